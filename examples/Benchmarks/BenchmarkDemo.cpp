@@ -27,9 +27,18 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
 
 #include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "BulletCollision/CollisionDispatch/btConvexConvexMprAlgorithm.h"
 
 #include "LinearMath/btAlignedObjectArray.h"
 #include "LinearMath/btTransform.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include "Bullet3Common/b3Logging.h"
+
+#include "../Importers/ImportObjDemo/LoadMeshFromObj.h"
+#include "../OpenGLWindow/GLInstanceGraphicsShape.h"
+#include "../Utils/b3ResourcePath.h"
+#include "../Utils/b3BulletDefaultFileIO.h"
 
 class btDynamicsWorld;
 
@@ -53,6 +62,9 @@ class BenchmarkDemo : public CommonRigidBodyMTBase
 
 	btAlignedObjectArray<class RagDoll*> m_ragdolls;
 
+	//the triangle meshes of createTest10, they outlive the mesh shapes
+	btAlignedObjectArray<class btStridingMeshInterface*> m_meshInterfaces;
+
 	int m_benchmark;
 
 	void myinit()
@@ -71,6 +83,8 @@ class BenchmarkDemo : public CommonRigidBodyMTBase
 	void createTest6();
 	void createTest7();
 	void createTest8();
+	void createTest9();
+	void createTest10();
 
 	void createWall(const btVector3& offsetPosition, int stackSize, const btVector3& boxSize);
 	void createPyramid(const btVector3& offsetPosition, int stackSize, const btVector3& boxSize);
@@ -451,6 +465,17 @@ void BenchmarkDemo::initPhysics()
 			createTest8();
 			break;
 		}
+		case 9:
+		case 10:
+		{
+			createTest9();
+			break;
+		}
+		case 11:
+		{
+			createTest10();
+			break;
+		}
 
 		default:
 		{
@@ -1315,6 +1340,184 @@ void BenchmarkDemo::createTest8()
 #endif
 }
 
+void BenchmarkDemo::createTest9()
+{
+	setCameraDistance(btScalar(50.));
+
+	if (m_benchmark == 10)
+	{
+		//use GJK and MPR for all pairs of these shapes, except sphere-sphere and box-box that have their own algorithms
+		const int shapeTypes[4] = {SPHERE_SHAPE_PROXYTYPE, CAPSULE_SHAPE_PROXYTYPE, BOX_SHAPE_PROXYTYPE, CONVEX_HULL_SHAPE_PROXYTYPE};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				if (i == j && shapeTypes[i] != CAPSULE_SHAPE_PROXYTYPE && shapeTypes[i] != CONVEX_HULL_SHAPE_PROXYTYPE)
+					continue;
+				m_dispatcher->registerCollisionCreateFunc(shapeTypes[i], shapeTypes[j], m_collisionConfiguration->getConvexConvexMprCreateFunc());
+			}
+		}
+	}
+
+	btBoxShape* groundShape = new btBoxShape(btVector3(btScalar(50.), btScalar(1.), btScalar(50.)));
+	m_collisionShapes.push_back(groundShape);
+	btTransform trans;
+	trans.setIdentity();
+	trans.setOrigin(btVector3(0, -1, 0));
+	createRigidBody(0, trans, groundShape);
+
+	btConvexHullShape* convexHullShape = new btConvexHullShape();
+	for (int i = 0; i < TaruVtxCount; i++)
+	{
+		btVector3 vtx(TaruVtx[i * 3], TaruVtx[i * 3 + 1], TaruVtx[i * 3 + 2]);
+		convexHullShape->addPoint(vtx * btScalar(0.5));
+	}
+	btCollisionShape* shapes[4] = {
+		new btSphereShape(btScalar(0.5)),
+		new btCapsuleShape(btScalar(0.4), btScalar(0.8)),
+		new btBoxShape(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5))),
+		convexHullShape};
+
+	for (int i = 0; i < 4; i++)
+	{
+		m_collisionShapes.push_back(shapes[i]);
+	}
+
+	const int size = 10;
+	const int height = 10;
+	const float spacing = 1.4f;
+	for (int k = 0; k < height; k++)
+	{
+		for (int j = 0; j < size; j++)
+		{
+			for (int i = 0; i < size; i++)
+			{
+				trans.setOrigin(btVector3((i - size / 2) * spacing, 1.f + k * spacing, (j - size / 2) * spacing));
+				createRigidBody(1.f, trans, shapes[(i + j + k) % 4]);
+			}
+		}
+	}
+}
+
+struct btBenchmarkCountCallback : public btNodeOverlapCallback
+{
+	int m_count;
+
+	btBenchmarkCountCallback() : m_count(0)
+	{
+	}
+
+	virtual void processNode(int subPart, int triangleIndex)
+	{
+		m_count++;
+	}
+};
+
+///load time of the btBvhTriangleMeshShape: builds the bvh of the data meshes, tiled 4x4 to get larger meshes,
+///with the median split and with the surface area heuristic builder, and measures the aabb queries on both trees
+void BenchmarkDemo::createTest10()
+{
+	setCameraDistance(btScalar(150.));
+
+	const char* fileNames[] = {"terrain.obj", "teddy.obj", "duck.obj", "bunny.obj", "leoTest1.obj"};
+	const int numFiles = sizeof(fileNames) / sizeof(fileNames[0]);
+	const int numTiles = 4;
+	const btScalar meshSize = btScalar(20.);
+	const int numQueries = 20000;
+
+	printf("mesh bvh build, %d threads\n", btGetTaskScheduler() ? btGetTaskScheduler()->getNumThreads() : 1);
+	for (int f = 0; f < numFiles; f++)
+	{
+		char relativeFileName[1024];
+		if (!b3ResourcePath::findResourcePath(fileNames[f], relativeFileName, 1024, 0))
+		{
+			b3Warning("Cannot find file %s\n", fileNames[f]);
+			continue;
+		}
+		b3BulletDefaultFileIO fileIO;
+		GLInstanceGraphicsShape* glmesh = LoadMeshFromObj(relativeFileName, "", &fileIO);
+		if (!glmesh || !glmesh->m_numIndices)
+		{
+			delete glmesh;
+			continue;
+		}
+
+		//scale the mesh to meshSize and tile it
+		btVector3 meshMin(btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT));
+		btVector3 meshMax = -meshMin;
+		for (int i = 0; i < glmesh->m_numvertices; i++)
+		{
+			const float* xyzw = glmesh->m_vertices->at(i).xyzw;
+			btVector3 v(xyzw[0], xyzw[1], xyzw[2]);
+			meshMin.setMin(v);
+			meshMax.setMax(v);
+		}
+		const btScalar scale = meshSize / btMax((meshMax - meshMin).length(), SIMD_EPSILON);
+		btTriangleMesh* meshInterface = new btTriangleMesh();
+		m_meshInterfaces.push_back(meshInterface);
+		for (int tx = 0; tx < numTiles; tx++)
+		{
+			for (int tz = 0; tz < numTiles; tz++)
+			{
+				const btVector3 offset(tx * meshSize, 0, tz * meshSize);
+				for (int i = 0; i + 2 < glmesh->m_numIndices; i += 3)
+				{
+					btVector3 vertices[3];
+					for (int k = 0; k < 3; k++)
+					{
+						const float* xyzw = glmesh->m_vertices->at(glmesh->m_indices->at(i + k)).xyzw;
+						vertices[k] = (btVector3(xyzw[0], xyzw[1], xyzw[2]) - meshMin) * scale + offset;
+					}
+					meshInterface->addTriangle(vertices[0], vertices[1], vertices[2]);
+				}
+			}
+		}
+		delete glmesh;
+
+		btBvhTriangleMeshShape* shapes[2];
+		unsigned long long buildTime[2];
+		unsigned long long queryTime[2];
+		int numReported[2];
+		btClock clock;
+		for (int k = 0; k < 2; k++)
+		{
+			clock.reset();
+			shapes[k] = new btBvhTriangleMeshShape(meshInterface, true, false);
+			shapes[k]->buildOptimizedBvh(k == 1 ? btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC : btQuantizedBvh::BUILD_MEDIAN_SPLIT);
+			buildTime[k] = clock.getTimeMicroseconds();
+
+			btVector3 aabbMin, aabbMax;
+			shapes[k]->getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
+			const btVector3 halfExtents = (aabbMax - aabbMin) * btScalar(0.01);
+			btBenchmarkCountCallback callback;
+			srand(1);
+			clock.reset();
+			for (int q = 0; q < numQueries; q++)
+			{
+				btVector3 center;
+				for (int axis = 0; axis < 3; axis++)
+				{
+					center[axis] = aabbMin[axis] + (aabbMax[axis] - aabbMin[axis]) * btScalar(rand()) / btScalar(RAND_MAX);
+				}
+				shapes[k]->getOptimizedBvh()->reportAabbOverlappingNodex(&callback, center - halfExtents, center + halfExtents);
+			}
+			queryTime[k] = clock.getTimeMicroseconds();
+			numReported[k] = callback.m_count;
+		}
+		printf("%s: %d triangles, build median %.1f ms sah %.1f ms, %d aabb queries median %.1f ms sah %.1f ms (%d triangles)\n",
+			   fileNames[f], meshInterface->getNumTriangles(), buildTime[0] * 0.001, buildTime[1] * 0.001,
+			   numQueries, queryTime[0] * 0.001, queryTime[1] * 0.001, numReported[1]);
+		btAssert(numReported[0] == numReported[1]);
+
+		delete shapes[0];
+		m_collisionShapes.push_back(shapes[1]);
+		btTransform trans;
+		trans.setIdentity();
+		trans.setOrigin(btVector3((f - numFiles / 2) * meshSize * numTiles * btScalar(1.1), 0, 0));
+		createRigidBody(0, trans, shapes[1]);
+	}
+}
+
 void BenchmarkDemo::exitPhysics()
 {
 	int i;
@@ -1327,6 +1530,12 @@ void BenchmarkDemo::exitPhysics()
 	m_ragdolls.clear();
 
 	CommonRigidBodyMTBase::exitPhysics();
+
+	for (i = 0; i < m_meshInterfaces.size(); i++)
+	{
+		delete m_meshInterfaces[i];
+	}
+	m_meshInterfaces.clear();
 }
 
 CommonExampleInterface* BenchmarkCreateFunc(struct CommonExampleOptions& options)
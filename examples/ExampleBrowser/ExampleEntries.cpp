@@ -262,6 +262,9 @@ static ExampleEntry gDefaultExamples[] =
 		ExampleEntry(1, "Convex vs Mesh", "Benchmark the performance and stability of rigid bodies using convex hull collision shapes (btConvexHullShape), resting on a triangle mesh, btBvhTriangleMeshShape.", BenchmarkCreateFunc, 6),
 		ExampleEntry(1, "Raycast", "Benchmark the performance of the btCollisionWorld::rayTest. Note that currently the rays are not rendered.", BenchmarkCreateFunc, 7),
 		ExampleEntry(1, "Convex Pack", "Benchmark the performance of the convex hull primitive.", BenchmarkCreateFunc, 8),
+		ExampleEntry(1, "Convex mix", "Benchmark a pile of spheres, capsules, boxes and convex hulls using the default convex-convex collision algorithm, GJK and EPA.", BenchmarkCreateFunc, 9),
+		ExampleEntry(1, "Convex mix MPR", "Benchmark the same pile using btConvexConvexMprAlgorithm, GJK and MPR specialized for each pair of shape types.", BenchmarkCreateFunc, 10),
+		ExampleEntry(1, "Mesh BVH build", "Benchmark the load time of btBvhTriangleMeshShape on the data meshes, building the btQuantizedBvh with the median split and with the parallel binned surface area heuristic, and the aabb queries on both trees.", BenchmarkCreateFunc, 11),
 		ExampleEntry(1, "Heightfield", "Raycast against a btHeightfieldTerrainShape", HeightfieldExampleCreateFunc),
 		//#endif
 
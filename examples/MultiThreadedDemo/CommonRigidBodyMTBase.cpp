@@ -27,6 +27,7 @@ class btCollisionShape;
 #include "LinearMath/btPoolAllocator.h"
 #include "btBulletCollisionCommon.h"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphaseMt.h"
 #include "BulletDynamics/Dynamics/btSimulationIslandManagerMt.h"  // for setSplitIslands()
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
@@ -295,6 +296,11 @@ public:
 			m_allocatedTaskSchedulers.push_back(ts);
 			addTaskScheduler(ts);
 		}
+		if (btITaskScheduler* ts = btCreateWorkStealingTaskScheduler())
+		{
+			m_allocatedTaskSchedulers.push_back(ts);
+			addTaskScheduler(ts);
+		}
 		addTaskScheduler(btGetOpenMPTaskScheduler());
 		addTaskScheduler(btGetTBBTaskScheduler());
 		addTaskScheduler(btGetPPLTaskScheduler());
@@ -535,7 +541,7 @@ void CommonRigidBodyMTBase::createEmptyDynamicsWorld()
 		m_collisionConfiguration = new btDefaultCollisionConfiguration(cci);
 
 		m_dispatcher = new MyCollisionDispatcher(m_collisionConfiguration, 40);
-		m_broadphase = new btDbvtBroadphase();
+		m_broadphase = new btDbvtBroadphaseMt();
 
 		btConstraintSolverPoolMt* solverPool;
 		{
@@ -6134,6 +6134,12 @@ struct FilteredClosestRayResultCallback : public btCollisionWorld::ClosestRayRes
 	{
 	}
 
+	FilteredClosestRayResultCallback()
+		: btCollisionWorld::ClosestRayResultCallback(btVector3(0, 0, 0), btVector3(0, 0, 0)),
+		  m_collisionFilterMask(0)
+	{
+	}
+
 	int m_collisionFilterMask;
 
 	virtual btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
@@ -6245,17 +6251,57 @@ struct BatchRayCaster
 				BT_PROFILE("CastSyncInfo_getNextTask");
 				taskNr = obj->m_syncInfo->getNextTask();
 			}
-			if (taskNr >= numRays)
+			//each task is a packet of consecutive rays
+			const int firstRay = taskNr * BT_RAY_PACKET_SIZE;
+			if (firstRay >= numRays)
 				return;
-			obj->processRay(taskNr);
+			obj->processRayPacket(firstRay);
 		}
 	}
 
 	void castSequentially()
 	{
-		for (int i = 0; i < m_numRays; i++)
+		for (int i = 0; i < m_numRays; i += BT_RAY_PACKET_SIZE)
 		{
-			processRay(i);
+			processRayPacket(i);
+		}
+	}
+
+	void processRayPacket(int firstRay)
+	{
+		const int numRays = btMin(m_numRays - firstRay, int(BT_RAY_PACKET_SIZE));
+		if (m_reportHitNumber >= 0)
+		{
+			for (int i = 0; i < numRays; i++)
+			{
+				processRay(firstRay + i);
+			}
+			return;
+		}
+
+		BT_PROFILE("BatchRayCaster_processRayPacket");
+		btVector3 rayFromWorld[BT_RAY_PACKET_SIZE];
+		btVector3 rayToWorld[BT_RAY_PACKET_SIZE];
+		FilteredClosestRayResultCallback rayResultCallbacks[BT_RAY_PACKET_SIZE];
+		btCollisionWorld::RayResultCallback* rayResultCallbackPtrs[BT_RAY_PACKET_SIZE];
+		for (int i = 0; i < numRays; i++)
+		{
+			const double* from = m_rayInputBuffer[firstRay + i].m_rayFromPosition;
+			const double* to = m_rayInputBuffer[firstRay + i].m_rayToPosition;
+			rayFromWorld[i].setValue(from[0], from[1], from[2]);
+			rayToWorld[i].setValue(to[0], to[1], to[2]);
+
+			FilteredClosestRayResultCallback& rayResultCallback = rayResultCallbacks[i];
+			rayResultCallback.m_rayFromWorld = rayFromWorld[i];
+			rayResultCallback.m_rayToWorld = rayToWorld[i];
+			rayResultCallback.m_collisionFilterMask = m_collisionFilterMask;
+			rayResultCallback.m_flags |= btTriangleRaycastCallback::kF_UseGjkConvexCastRaytest;
+			rayResultCallbackPtrs[i] = &rayResultCallback;
+		}
+		m_world->rayTestPacket(rayFromWorld, rayToWorld, rayResultCallbackPtrs, numRays);
+		for (int i = 0; i < numRays; i++)
+		{
+			writeRayHit(firstRay + i, rayResultCallbacks[i]);
 		}
 	}
 
@@ -6287,7 +6333,11 @@ struct BatchRayCaster
 		{
 			m_world->rayTest(rayFromWorld, rayToWorld, rayResultCallback);
 		}
+		writeRayHit(ray, rayResultCallback);
+	}
 
+	void writeRayHit(int ray, const FilteredClosestRayResultCallback& rayResultCallback)
+	{
 		b3RayHitInfo& hit = m_hitInfoOutputBuffer[ray];
 		if (rayResultCallback.hasHit())
 		{
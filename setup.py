@@ -242,6 +242,7 @@ sources = ["examples/pybullet/pybullet.c"]\
 +["Extras/InverseDynamics/SimpleTreeCreator.cpp"]\
 +["Extras/InverseDynamics/invdyn_bullet_comparison.cpp"]\
 +["src/BulletSoftBody/btDefaultSoftBodySolver.cpp"]\
++["src/BulletSoftBody/btDefaultSoftBodySolverMt.cpp"]\
 +["src/BulletSoftBody/btSoftBodyHelpers.cpp"]\
 +["src/BulletSoftBody/btSoftRigidCollisionAlgorithm.cpp"]\
 +["src/BulletSoftBody/btSoftBody.cpp"]\
@@ -369,6 +370,7 @@ egl_renderer_sources = \
 +["src/BulletCollision/CollisionShapes/btConvexShape.cpp"]\
 +["src/BulletCollision/CollisionShapes/btCollisionShape.cpp"]\
 +["src/BulletCollision/CollisionShapes/btConvexPolyhedron.cpp"]\
++["src/BulletCollision/CollisionShapes/btConvexSupportAccelerator.cpp"]\
 +["src/BulletCollision/CollisionShapes/btConvexInternalShape.cpp"]\
 +["src/Bullet3Common/b3Logging.cpp"]\
 +["src/LinearMath/btAlignedAllocator.cpp"]\
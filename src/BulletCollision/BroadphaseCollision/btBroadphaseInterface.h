@@ -42,6 +42,27 @@ protected:
 };
 
 #include "LinearMath/btVector3.h"
+#include "btRayPacket.h"
+
+///btBroadphaseRayPacketCallback is used by btBroadphaseInterface::rayTestPacket, with one btBroadphaseRayCallback per ray of the packet.
+///processPacket receives each proxy together with the mask of the rays that overlap its aabb,
+///the default implementation simply calls process on the ray callback of each of these rays.
+struct btBroadphaseRayPacketCallback
+{
+	btBroadphaseRayCallback* m_rayCallbacks[BT_RAY_PACKET_SIZE];
+
+	virtual ~btBroadphaseRayPacketCallback() {}
+	virtual void processPacket(const btBroadphaseProxy* proxy, unsigned int rayMask)
+	{
+		for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+		{
+			if (rayMask & (1u << i))
+			{
+				m_rayCallbacks[i]->process(proxy);
+			}
+		}
+	}
+};
 
 ///The btBroadphaseInterface class provides an interface to detect aabb-overlapping object pairs.
 ///Some implementations for this broadphase interface include btAxisSweep3, bt32BitAxisSweep3 and btDbvtBroadphase.
@@ -58,6 +79,17 @@ public:
 
 	virtual void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0)) = 0;
 
+	///rayTestPacket casts up to BT_RAY_PACKET_SIZE coherent rays at once. The default implementation performs a rayTest for each ray,
+	///broadphases that support packet traversal (btDbvtBroadphase) visit their tree only once for the whole packet.
+	virtual void rayTestPacket(const btVector3* rayFrom, const btVector3* rayTo, int numRays, btBroadphaseRayPacketCallback& packetCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0))
+	{
+		btAssert(numRays <= BT_RAY_PACKET_SIZE);
+		for (int i = 0; i < numRays; i++)
+		{
+			rayTest(rayFrom[i], rayTo[i], *packetCallback.m_rayCallbacks[i], aabbMin, aabbMax);
+		}
+	}
+
 	virtual void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) = 0;
 
 	///calculateOverlappingPairs is optional: incremental algorithms (sweep and prune) might do it during the set aabb
@@ -0,0 +1,287 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_BVH_SAH_BINNING_H
+#define BT_BVH_SAH_BINNING_H
+
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btMinMax.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+///Binned surface area heuristic on quantized boxes, shared by the builders of btQuantizedBvh and btWideBvh.
+///The primitive type of a builder derives from btBvhSahQuantizedAabb, the functions below work on ranges of an array of them.
+
+///the maximum number of bins per axis
+#define BT_BVH_SAH_NUM_BINS 16
+
+struct btBvhSahQuantizedAabb
+{
+	unsigned short m_quantizedAabbMin[3];
+	unsigned short m_quantizedAabbMax[3];
+
+	//twice the center, so that it stays an integer
+	SIMD_FORCE_INLINE int getCentroid(int axis) const
+	{
+		return int(m_quantizedAabbMin[axis]) + int(m_quantizedAabbMax[axis]);
+	}
+};
+
+struct btBvhSahBin
+{
+	int m_count;
+	int m_aabbMin[3];
+	int m_aabbMax[3];
+};
+
+///the bins of all 3 axes, parallel builders fill one per chunk and merge them afterwards
+struct btBvhSahBins
+{
+	btBvhSahBin m_bins[3][BT_BVH_SAH_NUM_BINS];
+	///small ranges use fewer bins
+	int m_numBins;
+
+	void init(int numBins)
+	{
+		m_numBins = numBins;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int b = 0; b < numBins; b++)
+			{
+				btBvhSahBin& bin = m_bins[axis][b];
+				bin.m_count = 0;
+				bin.m_aabbMin[0] = bin.m_aabbMin[1] = bin.m_aabbMin[2] = 0xffff;
+				bin.m_aabbMax[0] = bin.m_aabbMax[1] = bin.m_aabbMax[2] = 0;
+			}
+		}
+	}
+
+	void merge(const btBvhSahBins& other)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int b = 0; b < m_numBins; b++)
+			{
+				btBvhSahBin& bin = m_bins[axis][b];
+				const btBvhSahBin& otherBin = other.m_bins[axis][b];
+				bin.m_count += otherBin.m_count;
+				for (int k = 0; k < 3; k++)
+				{
+					bin.m_aabbMin[k] = btMin(bin.m_aabbMin[k], otherBin.m_aabbMin[k]);
+					bin.m_aabbMax[k] = btMax(bin.m_aabbMax[k], otherBin.m_aabbMax[k]);
+				}
+			}
+		}
+	}
+};
+
+SIMD_FORCE_INLINE btScalar btBvhSahGetBinScale(int centroidMin, int centroidMax, int numBins)
+{
+	return btScalar(numBins) / btScalar(centroidMax - centroidMin + 1);
+}
+
+SIMD_FORCE_INLINE int btBvhSahGetBin(int centroid, int centroidMin, btScalar binScale, int numBins)
+{
+	return btMin(int(btScalar(centroid - centroidMin) * binScale), numBins - 1);
+}
+
+///half the surface area of a box with the given quantized extent, axisScale is the length of a quantization step on each axis
+SIMD_FORCE_INLINE btScalar btBvhSahCalcHalfArea(const btScalar* axisScale, const int* extent)
+{
+	const btScalar x = btScalar(extent[0]) * axisScale[0];
+	const btScalar y = btScalar(extent[1]) * axisScale[1];
+	const btScalar z = btScalar(extent[2]) * axisScale[2];
+	return x * y + y * z + z * x;
+}
+
+SIMD_FORCE_INLINE int btBvhSahGetLargestAxis(const int* centroidMin, const int* centroidMax)
+{
+	int largestAxis = 0;
+	for (int axis = 1; axis < 3; axis++)
+	{
+		if (centroidMax[axis] - centroidMin[axis] > centroidMax[largestAxis] - centroidMin[largestAxis])
+		{
+			largestAxis = axis;
+		}
+	}
+	return largestAxis;
+}
+
+template <typename btPrimitive>
+void btBvhSahCalcCentroidBounds(const btAlignedObjectArray<btPrimitive>& primitives, int begin, int end, int* centroidMin, int* centroidMax)
+{
+	centroidMin[0] = centroidMin[1] = centroidMin[2] = 0x7fffffff;
+	centroidMax[0] = centroidMax[1] = centroidMax[2] = 0;
+	for (int i = begin; i < end; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const int c = primitives[i].getCentroid(axis);
+			centroidMin[axis] = btMin(centroidMin[axis], c);
+			centroidMax[axis] = btMax(centroidMax[axis], c);
+		}
+	}
+}
+
+template <typename btPrimitive>
+void btBvhSahBinPrimitives(const btAlignedObjectArray<btPrimitive>& primitives, int begin, int end, const int* centroidMin, const int* centroidMax, int numBins, btBvhSahBins& bins)
+{
+	bins.init(numBins);
+	btScalar binScale[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		binScale[axis] = btBvhSahGetBinScale(centroidMin[axis], centroidMax[axis], numBins);
+	}
+	for (int i = begin; i < end; i++)
+	{
+		const btPrimitive& primitive = primitives[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (centroidMax[axis] == centroidMin[axis])
+			{
+				continue;
+			}
+			btBvhSahBin& bin = bins.m_bins[axis][btBvhSahGetBin(primitive.getCentroid(axis), centroidMin[axis], binScale[axis], numBins)];
+			bin.m_count++;
+			for (int k = 0; k < 3; k++)
+			{
+				bin.m_aabbMin[k] = btMin(bin.m_aabbMin[k], int(primitive.m_quantizedAabbMin[k]));
+				bin.m_aabbMax[k] = btMax(bin.m_aabbMax[k], int(primitive.m_quantizedAabbMax[k]));
+			}
+		}
+	}
+}
+
+///finds the cheapest split between two bins, the cost of a split is the area times the count of both sides.
+///Returns false if no split leaves primitives on both sides, bestBin is the last bin of the left side.
+inline bool btBvhSahFindBestSplit(const btBvhSahBins& bins, const int* centroidMin, const int* centroidMax, const btScalar* axisScale, int& bestAxis, int& bestBin)
+{
+	const int numBins = bins.m_numBins;
+	btScalar bestCost = btScalar(BT_LARGE_FLOAT);
+	bestAxis = -1;
+	bestBin = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (centroidMax[axis] == centroidMin[axis])
+		{
+			continue;
+		}
+		//accumulate the right sides from the last bin, then sweep the left sides from the first bin
+		btScalar rightCost[BT_BVH_SAH_NUM_BINS];
+		int aabbMin[3] = {0xffff, 0xffff, 0xffff};
+		int aabbMax[3] = {0, 0, 0};
+		int count = 0;
+		for (int b = numBins - 1; b > 0; b--)
+		{
+			const btBvhSahBin& bin = bins.m_bins[axis][b];
+			count += bin.m_count;
+			int extent[3];
+			for (int k = 0; k < 3; k++)
+			{
+				aabbMin[k] = btMin(aabbMin[k], bin.m_aabbMin[k]);
+				aabbMax[k] = btMax(aabbMax[k], bin.m_aabbMax[k]);
+				extent[k] = btMax(aabbMax[k] - aabbMin[k], 0);
+			}
+			rightCost[b] = count ? btBvhSahCalcHalfArea(axisScale, extent) * btScalar(count) : btScalar(-1.);
+		}
+		aabbMin[0] = aabbMin[1] = aabbMin[2] = 0xffff;
+		aabbMax[0] = aabbMax[1] = aabbMax[2] = 0;
+		count = 0;
+		for (int b = 0; b < numBins - 1; b++)
+		{
+			const btBvhSahBin& bin = bins.m_bins[axis][b];
+			count += bin.m_count;
+			int extent[3];
+			for (int k = 0; k < 3; k++)
+			{
+				aabbMin[k] = btMin(aabbMin[k], bin.m_aabbMin[k]);
+				aabbMax[k] = btMax(aabbMax[k], bin.m_aabbMax[k]);
+				extent[k] = btMax(aabbMax[k] - aabbMin[k], 0);
+			}
+			//split between bin b and bin b+1
+			if (count && rightCost[b + 1] >= btScalar(0.))
+			{
+				const btScalar cost = btBvhSahCalcHalfArea(axisScale, extent) * btScalar(count) + rightCost[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+	}
+	return bestAxis >= 0;
+}
+
+///moves the primitive with the k-th smallest centroid on axis to position k, the smaller ones before it
+template <typename btPrimitive>
+void btBvhSahSelectMedian(btAlignedObjectArray<btPrimitive>& primitives, int begin, int end, int k, int axis)
+{
+	while (end - begin > 1)
+	{
+		const int pivot = primitives[(begin + end) / 2].getCentroid(axis);
+		int i = begin;
+		int j = end - 1;
+		while (i <= j)
+		{
+			while (primitives[i].getCentroid(axis) < pivot)
+				i++;
+			while (primitives[j].getCentroid(axis) > pivot)
+				j--;
+			if (i <= j)
+			{
+				primitives.swap(i, j);
+				i++;
+				j--;
+			}
+		}
+		if (k <= j)
+		{
+			end = j + 1;
+		}
+		else if (k >= i)
+		{
+			begin = i;
+		}
+		else
+		{
+			return;
+		}
+	}
+}
+
+///moves the primitives up to splitBin on axis before the others and returns the first index of the others
+template <typename btPrimitive>
+int btBvhSahPartition(btAlignedObjectArray<btPrimitive>& primitives, int begin, int end, int axis, int splitBin, const int* centroidMin, const int* centroidMax, int numBins)
+{
+	const btScalar binScale = btBvhSahGetBinScale(centroidMin[axis], centroidMax[axis], numBins);
+	int i = begin;
+	int j = end - 1;
+	while (i <= j)
+	{
+		if (btBvhSahGetBin(primitives[i].getCentroid(axis), centroidMin[axis], binScale, numBins) <= splitBin)
+		{
+			i++;
+		}
+		else
+		{
+			primitives.swap(i, j);
+			j--;
+		}
+	}
+	return i;
+}
+
+#endif  //BT_BVH_SAH_BINNING_H
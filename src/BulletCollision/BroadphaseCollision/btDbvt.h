@@ -21,6 +21,7 @@ subject to the following restrictions:
 #include "LinearMath/btVector3.h"
 #include "LinearMath/btTransform.h"
 #include "LinearMath/btAabbUtil2.h"
+#include "btRayPacket.h"
 //
 // Compile time configuration
 //
@@ -272,6 +273,7 @@ struct btDbvt
 		DBVT_VIRTUAL void Process(const btDbvtNode*, const btDbvtNode*) {}
 		DBVT_VIRTUAL void Process(const btDbvtNode*) {}
 		DBVT_VIRTUAL void Process(const btDbvtNode* n, btScalar) { Process(n); }
+		DBVT_VIRTUAL void ProcessRays(const btDbvtNode* n, unsigned int /*rayMask*/) { Process(n); }
         DBVT_VIRTUAL void Process(const btDbvntNode*, const btDbvntNode*) {}
 		DBVT_VIRTUAL bool Descent(const btDbvtNode*) { return (true); }
 		DBVT_VIRTUAL bool AllLeaves(const btDbvtNode*) { return (true); }
@@ -401,6 +403,16 @@ struct btDbvt
 						 const btVector3& aabbMax,
 						 btAlignedObjectArray<const btDbvtNode*>& stack,
 						 DBVT_IPOLICY) const;
+	///rayTestPacketInternal casts a packet of coherent rays (see btRayPacket) in a single traversal, each node is tested against all rays at once.
+	///Once a subtree is only hit by a single ray, it is finished with the single ray traversal of rayTestInternal.
+	///policy.ProcessRays(leaf, rayMask) is called for each leaf, with a bit set in rayMask for every ray that hits the leaf.
+	DBVT_PREFIX
+	void rayTestPacketInternal(const btDbvtNode* root,
+							   const btRayPacket& packet,
+							   const btVector3& aabbMin,
+							   const btVector3& aabbMax,
+							   btAlignedObjectArray<sStkNP>& stack,
+							   DBVT_IPOLICY) const;
 
 	DBVT_PREFIX
 	static void collideKDOP(const btDbvtNode* root,
@@ -1271,6 +1283,79 @@ inline void btDbvt::rayTestInternal(const btDbvtNode* root,
 	}
 }
 
+//
+DBVT_PREFIX
+inline void btDbvt::rayTestPacketInternal(const btDbvtNode* root,
+										  const btRayPacket& packet,
+										  const btVector3& aabbMin,
+										  const btVector3& aabbMax,
+										  btAlignedObjectArray<sStkNP>& stack,
+										  DBVT_IPOLICY) const
+{
+	DBVT_CHECKTYPE
+	if (root)
+	{
+		const unsigned int rootMask = packet.testAabb(root->volume.Mins() - aabbMax, root->volume.Maxs() - aabbMin, packet.getActiveMask());
+		if (rootMask == 0)
+		{
+			return;
+		}
+		stack.resizeNoInitialize(0);
+		stack.push_back(sStkNP(root, rootMask));
+		btVector3 bounds[2];
+		do
+		{
+			const sStkNP se = stack[stack.size() - 1];
+			stack.pop_back();
+			const unsigned int rayMask = (unsigned int)se.mask;
+			const btDbvtNode* node = se.node;
+			if (node->isleaf())
+			{
+				policy.ProcessRays(node, rayMask);
+			}
+			else if (btRayPacket::isSingleRay(rayMask))
+			{
+				/* Rays diverged, finish this subtree with the single ray traversal	*/
+				const int ray = btRayPacket::getFirstRay(rayMask);
+				const int base = stack.size();
+				stack.push_back(sStkNP(node, rayMask));
+				while (stack.size() > base)
+				{
+					const btDbvtNode* n = stack[stack.size() - 1].node;
+					stack.pop_back();
+					bounds[0] = n->volume.Mins() - aabbMax;
+					bounds[1] = n->volume.Maxs() - aabbMin;
+					btScalar tmin = 1.f, lambda_min = 0.f;
+					if (btRayAabb2(packet.m_rayFrom[ray], packet.m_rayDirectionInverse[ray], packet.m_signs[ray], bounds, tmin, lambda_min, packet.m_lambdaMax[ray]))
+					{
+						if (n->isinternal())
+						{
+							stack.push_back(sStkNP(n->childs[0], rayMask));
+							stack.push_back(sStkNP(n->childs[1], rayMask));
+						}
+						else
+						{
+							policy.ProcessRays(n, rayMask);
+						}
+					}
+				}
+			}
+			else
+			{
+				for (int i = 0; i < 2; ++i)
+				{
+					const btDbvtNode* child = node->childs[i];
+					const unsigned int childMask = packet.testAabb(child->volume.Mins() - aabbMax, child->volume.Maxs() - aabbMin, rayMask);
+					if (childMask)
+					{
+						stack.push_back(sStkNP(child, childMask));
+					}
+				}
+			}
+		} while (stack.size());
+	}
+}
+
 //
 DBVT_PREFIX
 inline void btDbvt::rayTest(const btDbvtNode* root,
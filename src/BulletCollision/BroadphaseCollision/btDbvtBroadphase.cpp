@@ -283,6 +283,43 @@ void btDbvtBroadphase::rayTest(const btVector3& rayFrom, const btVector3& rayTo,
 							  callback);
 }
 
+struct BroadphaseRayPacketTester : btDbvt::ICollide
+{
+	btBroadphaseRayPacketCallback& m_packetCallback;
+	BroadphaseRayPacketTester(btBroadphaseRayPacketCallback& orgCallback)
+		: m_packetCallback(orgCallback)
+	{
+	}
+	void ProcessRays(const btDbvtNode* leaf, unsigned int rayMask)
+	{
+		btDbvtProxy* proxy = (btDbvtProxy*)leaf->data;
+		m_packetCallback.processPacket(proxy, rayMask);
+	}
+};
+
+void btDbvtBroadphase::rayTestPacket(const btVector3* rayFrom, const btVector3* rayTo, int numRays, btBroadphaseRayPacketCallback& packetCallback, const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	BroadphaseRayPacketTester callback(packetCallback);
+	const btRayPacket packet(rayFrom, rayTo, numRays);
+	// the packet stack is always local, so this function is as re-entrant as rayTest
+	btAlignedObjectArray<btDbvt::sStkNP> stack;
+	stack.reserve(btDbvt::DOUBLE_STACKSIZE);
+
+	m_sets[0].rayTestPacketInternal(m_sets[0].m_root,
+									packet,
+									aabbMin,
+									aabbMax,
+									stack,
+									callback);
+
+	m_sets[1].rayTestPacketInternal(m_sets[1].m_root,
+									packet,
+									aabbMin,
+									aabbMax,
+									stack,
+									callback);
+}
+
 struct BroadphaseAabbTester : btDbvt::ICollide
 {
 	btBroadphaseAabbCallback& m_aabbCallback;
@@ -566,16 +603,15 @@ void btDbvtBroadphase::collide(btDispatcher* dispatcher)
 	}
 	/* collide dynamics		*/
 	{
-		btDbvtTreeCollider collider(this);
 		if (m_deferedcollide)
 		{
 			SPC(m_profiling.m_fdcollide);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root, m_sets[1].m_root, collider);
+			collideTrees(m_sets[0].m_root, m_sets[1].m_root);
 		}
 		if (m_deferedcollide)
 		{
 			SPC(m_profiling.m_ddcollide);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root, m_sets[0].m_root, collider);
+			collideTrees(m_sets[0].m_root, m_sets[0].m_root);
 		}
 	}
 	/* clean up				*/
@@ -623,6 +659,13 @@ void btDbvtBroadphase::collide(btDispatcher* dispatcher)
 	m_updates_call /= 2;
 }
 
+//
+void btDbvtBroadphase::collideTrees(const btDbvtNode* root0, const btDbvtNode* root1)
+{
+	btDbvtTreeCollider collider(this);
+	m_sets[0].collideTTpersistentStack(root0, root1, collider);
+}
+
 //
 void btDbvtBroadphase::optimize()
 {
@@ -106,11 +106,16 @@ struct btDbvtBroadphase : btBroadphaseInterface
 	void collide(btDispatcher* dispatcher);
 	void optimize();
 
+	///collideTrees adds a pair for every overlapping leaf pair between root0 and root1 (root0==root1 for self-collision)
+	///it is used by collide when m_deferedcollide is set, derived broadphases can override it (see btDbvtBroadphaseMt)
+	virtual void collideTrees(const btDbvtNode* root0, const btDbvtNode* root1);
+
 	/* btBroadphaseInterface Implementation	*/
 	btBroadphaseProxy* createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType, void* userPtr, int collisionFilterGroup, int collisionFilterMask, btDispatcher* dispatcher);
 	virtual void destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher);
 	virtual void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher);
 	virtual void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0));
+	virtual void rayTestPacket(const btVector3* rayFrom, const btVector3* rayTo, int numRays, btBroadphaseRayPacketCallback& packetCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0));
 	virtual void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
 
 	virtual void getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const;
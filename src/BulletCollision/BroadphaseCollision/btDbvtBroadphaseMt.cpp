@@ -0,0 +1,337 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btDbvtBroadphaseMt.h"
+#include "LinearMath/btQuickprof.h"
+
+//
+// Helpers (same as btDbvtBroadphase.cpp)
+//
+
+//
+template <typename T>
+static inline void listappendMt(T* item, T*& list)
+{
+	item->links[0] = 0;
+	item->links[1] = list;
+	if (list) list->links[0] = item;
+	list = item;
+}
+
+//
+template <typename T>
+static inline void listremoveMt(T* item, T*& list)
+{
+	if (item->links[0])
+		item->links[0]->links[1] = item->links[1];
+	else
+		list = item->links[1];
+	if (item->links[1]) item->links[1]->links[0] = item->links[0];
+}
+
+//
+static void refitSubtree(btDbvtNode* node)
+{
+	if (node->isinternal())
+	{
+		refitSubtree(node->childs[0]);
+		refitSubtree(node->childs[1]);
+		Merge(node->childs[0]->volume, node->childs[1]->volume, node->volume);
+	}
+}
+
+/* Job collider	*/
+struct btDbvtJobCollider : btDbvt::ICollide
+{
+	btAlignedObjectArray<btDbvtBroadphaseMt::LeafPair>* m_pairs;
+	btDbvtJobCollider(btAlignedObjectArray<btDbvtBroadphaseMt::LeafPair>* pairs) : m_pairs(pairs) {}
+	void Process(const btDbvtNode* na, const btDbvtNode* nb)
+	{
+		if (na != nb)
+		{
+			btDbvtProxy* pa = (btDbvtProxy*)na->data;
+			btDbvtProxy* pb = (btDbvtProxy*)nb->data;
+#if DBVT_BP_SORTPAIRS
+			if (pa->m_uniqueId > pb->m_uniqueId)
+				btSwap(pa, pb);
+#endif
+			btDbvtBroadphaseMt::LeafPair& pair = m_pairs->expandNonInitializing();
+			pair.m_proxy0 = pa;
+			pair.m_proxy1 = pb;
+		}
+	}
+};
+
+struct RefitSubtreesLoop : public btIParallelForBody
+{
+	btDbvtNode* const* m_subtrees;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			refitSubtree(m_subtrees[i]);
+		}
+	}
+};
+
+struct CollideJobsLoop : public btIParallelForBody
+{
+	btDbvt* m_tree;
+	const btDbvt::sStkNN* m_jobs;
+	btAlignedObjectArray<btDbvtBroadphaseMt::LeafPair>* m_jobPairs;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btDbvtJobCollider collider(&m_jobPairs[i]);
+			m_tree->collideTT(m_jobs[i].a, m_jobs[i].b, collider);
+		}
+	}
+};
+
+//
+// btDbvtBroadphaseMt
+//
+
+//
+btDbvtBroadphaseMt::btDbvtBroadphaseMt(btOverlappingPairCache* paircache)
+	: btDbvtBroadphase(paircache)
+{
+	m_deferedcollide = true;
+	m_needrefit = false;
+	m_jobsPerThread = 8;
+	m_deterministic = false;
+}
+
+//
+btDbvtBroadphaseMt::~btDbvtBroadphaseMt()
+{
+}
+
+//
+int btDbvtBroadphaseMt::getNumJobs() const
+{
+	const btITaskScheduler* scheduler = btGetTaskScheduler();
+	int numThreads = scheduler ? scheduler->getNumThreads() : 1;
+	if (m_deterministic)
+	{
+		numThreads = BT_MAX_THREAD_COUNT;
+	}
+	return numThreads * m_jobsPerThread;
+}
+
+//
+void btDbvtBroadphaseMt::setAabb(btBroadphaseProxy* absproxy,
+								 const btVector3& aabbMin,
+								 const btVector3& aabbMax,
+								 btDispatcher* dispatcher)
+{
+	btDbvtProxy* proxy = (btDbvtProxy*)absproxy;
+	ATTRIBUTE_ALIGNED16(btDbvtVolume)
+	aabb = btDbvtVolume::FromMM(aabbMin, aabbMax);
+	if (!m_deferedcollide || (proxy->stage == STAGECOUNT) || !Intersect(proxy->leaf->volume, aabb))
+	{
+		/* fixed -> dynamic set or teleporting, needs a re-insertion */
+		btDbvtBroadphase::setAabb(absproxy, aabbMin, aabbMax, dispatcher);
+		return;
+	}
+	/* Moving, grow the leaf now and refit its ancestors in calculateOverlappingPairs */
+	++m_updates_call;
+	if (!proxy->leaf->volume.Contain(aabb))
+	{
+		const btVector3 delta = aabbMin - proxy->m_aabbMin;
+		btVector3 velocity(((proxy->m_aabbMax - proxy->m_aabbMin) / 2) * m_prediction);
+		if (delta[0] < 0) velocity[0] = -velocity[0];
+		if (delta[1] < 0) velocity[1] = -velocity[1];
+		if (delta[2] < 0) velocity[2] = -velocity[2];
+		aabb.Expand(btVector3(gDbvtMargin, gDbvtMargin, gDbvtMargin));
+		aabb.SignedExpand(velocity);
+		proxy->leaf->volume = aabb;
+		++m_updates_done;
+		m_needrefit = true;
+		m_needcleanup = true;
+	}
+	listremoveMt(proxy, m_stageRoots[proxy->stage]);
+	proxy->m_aabbMin = aabbMin;
+	proxy->m_aabbMax = aabbMax;
+	proxy->stage = m_stageCurrent;
+	listappendMt(proxy, m_stageRoots[m_stageCurrent]);
+}
+
+//
+void btDbvtBroadphaseMt::refitDynamicSet()
+{
+	BT_PROFILE("btDbvtBroadphaseMt::refitDynamicSet");
+	m_needrefit = false;
+	btDbvtNode* root = m_sets[0].m_root;
+	if (root == 0)
+	{
+		return;
+	}
+	// split the tree breadth-first into enough independent subtrees
+	const int numJobs = getNumJobs();
+	btAlignedObjectArray<btDbvtNode*>* subtrees = &m_refitSubtrees;
+	btAlignedObjectArray<btDbvtNode*>* scratch = &m_refitScratch;
+	subtrees->resizeNoInitialize(0);
+	subtrees->push_back(root);
+	m_refitTopNodes.resizeNoInitialize(0);
+	bool expanded = true;
+	while (expanded && subtrees->size() < numJobs)
+	{
+		expanded = false;
+		scratch->resizeNoInitialize(0);
+		for (int i = 0; i < subtrees->size(); ++i)
+		{
+			btDbvtNode* node = (*subtrees)[i];
+			if (node->isinternal())
+			{
+				m_refitTopNodes.push_back(node);
+				scratch->push_back(node->childs[0]);
+				scratch->push_back(node->childs[1]);
+				expanded = true;
+			}
+			else
+			{
+				scratch->push_back(node);
+			}
+		}
+		btSwap(subtrees, scratch);
+	}
+
+	RefitSubtreesLoop loop;
+	loop.m_subtrees = &(*subtrees)[0];
+	btParallelFor(0, subtrees->size(), 1, loop);
+
+	// top nodes are stored breadth-first, so children are refitted before their parents
+	for (int i = m_refitTopNodes.size() - 1; i >= 0; --i)
+	{
+		btDbvtNode* node = m_refitTopNodes[i];
+		Merge(node->childs[0]->volume, node->childs[1]->volume, node->volume);
+	}
+}
+
+//
+void btDbvtBroadphaseMt::collideTrees(const btDbvtNode* root0, const btDbvtNode* root1)
+{
+	BT_PROFILE("btDbvtBroadphaseMt::collideTrees");
+	if ((root0 == 0) || (root1 == 0))
+	{
+		return;
+	}
+	// split the traversal breadth-first (using the same descent as btDbvt::collideTT)
+	// until there are enough independent node pairs
+	const int numJobs = getNumJobs();
+	btAlignedObjectArray<btDbvt::sStkNN>* jobs = &m_collideJobs;
+	btAlignedObjectArray<btDbvt::sStkNN>* scratch = &m_collideScratch;
+	jobs->resizeNoInitialize(0);
+	jobs->push_back(btDbvt::sStkNN(root0, root1));
+	bool expanded = true;
+	while (expanded && jobs->size() < numJobs)
+	{
+		expanded = false;
+		scratch->resizeNoInitialize(0);
+		for (int i = 0; i < jobs->size(); ++i)
+		{
+			const btDbvt::sStkNN p = (*jobs)[i];
+			if (p.a == p.b)
+			{
+				if (p.a->isinternal())
+				{
+					scratch->push_back(btDbvt::sStkNN(p.a->childs[0], p.a->childs[0]));
+					scratch->push_back(btDbvt::sStkNN(p.a->childs[1], p.a->childs[1]));
+					scratch->push_back(btDbvt::sStkNN(p.a->childs[0], p.a->childs[1]));
+					expanded = true;
+				}
+			}
+			else if (Intersect(p.a->volume, p.b->volume))
+			{
+				if (p.a->isinternal())
+				{
+					if (p.b->isinternal())
+					{
+						scratch->push_back(btDbvt::sStkNN(p.a->childs[0], p.b->childs[0]));
+						scratch->push_back(btDbvt::sStkNN(p.a->childs[1], p.b->childs[0]));
+						scratch->push_back(btDbvt::sStkNN(p.a->childs[0], p.b->childs[1]));
+						scratch->push_back(btDbvt::sStkNN(p.a->childs[1], p.b->childs[1]));
+					}
+					else
+					{
+						scratch->push_back(btDbvt::sStkNN(p.a->childs[0], p.b));
+						scratch->push_back(btDbvt::sStkNN(p.a->childs[1], p.b));
+					}
+					expanded = true;
+				}
+				else if (p.b->isinternal())
+				{
+					scratch->push_back(btDbvt::sStkNN(p.a, p.b->childs[0]));
+					scratch->push_back(btDbvt::sStkNN(p.a, p.b->childs[1]));
+					expanded = true;
+				}
+				else
+				{
+					scratch->push_back(p);
+				}
+			}
+		}
+		btSwap(jobs, scratch);
+	}
+	if (jobs->size() == 0)
+	{
+		return;
+	}
+
+	// only grow, so the per-job buffers keep their capacity from frame to frame
+	if (m_jobPairs.size() < jobs->size())
+	{
+		m_jobPairs.resize(jobs->size());
+	}
+	CollideJobsLoop loop;
+	loop.m_tree = &m_sets[0];
+	loop.m_jobs = &(*jobs)[0];
+	loop.m_jobPairs = &m_jobPairs[0];
+	btParallelFor(0, jobs->size(), 1, loop);
+
+	// merge in job order, so the result does not depend on the thread count
+	for (int i = 0; i < jobs->size(); ++i)
+	{
+		btAlignedObjectArray<LeafPair>& pairs = m_jobPairs[i];
+		for (int j = 0; j < pairs.size(); ++j)
+		{
+			m_paircache->addOverlappingPair(pairs[j].m_proxy0, pairs[j].m_proxy1);
+		}
+		m_newpairs += pairs.size();
+		pairs.resizeNoInitialize(0);
+	}
+}
+
+//
+void btDbvtBroadphaseMt::calculateOverlappingPairs(btDispatcher* dispatcher)
+{
+	if (m_needrefit)
+	{
+		refitDynamicSet();
+	}
+	btDbvtBroadphase::calculateOverlappingPairs(dispatcher);
+}
+
+//
+void btDbvtBroadphaseMt::resetPool(btDispatcher* dispatcher)
+{
+	btDbvtBroadphase::resetPool(dispatcher);
+	m_deferedcollide = true;
+	m_needrefit = false;
+}
@@ -0,0 +1,90 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_DBVT_BROADPHASE_MT_H
+#define BT_DBVT_BROADPHASE_MT_H
+
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "LinearMath/btThreads.h"
+
+///
+/// btDbvtBroadphaseMt -- a version of btDbvtBroadphase that uses btParallelFor for the per-frame work.
+///
+///  Collision is always deferred to calculateOverlappingPairs, where
+///     - the dynamic set (m_sets[0]) is refitted, with its subtrees refitted in parallel
+///     - the tree-vs-tree traversals are split into independent subtree jobs that run in parallel
+///  Moving proxies only grow their leaf volume in setAabb; they are not removed and re-inserted.
+///  Teleporting proxies and proxies leaving the fixed set still go through the serial insertion.
+///  Every traversal job writes its pairs into its own buffer, and the buffers are added to the pair
+///  cache in job order. The number of jobs is derived from the number of threads though, so the order of
+///  new pairs depends on the thread count unless setDeterministic(true) is used.
+///  Note: between setAabb and calculateOverlappingPairs the internal nodes of m_sets[0] may not
+///  contain the moved leaves, so rayTest/aabbTest should be called after the pairs are updated.
+///
+class btDbvtBroadphaseMt : public btDbvtBroadphase
+{
+public:
+	struct LeafPair
+	{
+		btDbvtProxy* m_proxy0;
+		btDbvtProxy* m_proxy1;
+	};
+
+	btDbvtBroadphaseMt(btOverlappingPairCache* paircache = 0);
+	virtual ~btDbvtBroadphaseMt();
+
+	virtual void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher) BT_OVERRIDE;
+	virtual void calculateOverlappingPairs(btDispatcher* dispatcher) BT_OVERRIDE;
+	virtual void resetPool(btDispatcher* dispatcher) BT_OVERRIDE;
+	virtual void collideTrees(const btDbvtNode* root0, const btDbvtNode* root1) BT_OVERRIDE;
+
+	///recompute the internal node volumes of the dynamic set, called by calculateOverlappingPairs
+	void refitDynamicSet();
+
+	///number of refit and traversal jobs created per worker thread (more jobs give better load balancing)
+	void setJobsPerThread(int jobsPerThread)
+	{
+		m_jobsPerThread = btMax(1, jobsPerThread);
+	}
+	int getJobsPerThread() const
+	{
+		return m_jobsPerThread;
+	}
+
+	///split the work as if BT_MAX_THREAD_COUNT threads were running, so the pair array is the same for any number of threads
+	void setDeterministic(bool deterministic)
+	{
+		m_deterministic = deterministic;
+	}
+	bool getDeterministic() const
+	{
+		return m_deterministic;
+	}
+
+protected:
+	btAlignedObjectArray<btDbvtNode*> m_refitSubtrees;                // subtree roots refitted in parallel
+	btAlignedObjectArray<btDbvtNode*> m_refitTopNodes;                // internal nodes above the subtrees, refitted afterwards
+	btAlignedObjectArray<btDbvtNode*> m_refitScratch;
+	btAlignedObjectArray<btDbvt::sStkNN> m_collideJobs;               // independent node pairs traversed in parallel
+	btAlignedObjectArray<btDbvt::sStkNN> m_collideScratch;
+	btAlignedObjectArray<btAlignedObjectArray<LeafPair> > m_jobPairs;  // pairs found by each job
+	int m_jobsPerThread;
+	bool m_deterministic;
+	bool m_needrefit;
+
+	int getNumJobs() const;
+};
+
+#endif  //BT_DBVT_BROADPHASE_MT_H
@@ -47,7 +47,9 @@ struct btDispatcherInfo
 		  m_allowedCcdPenetration(btScalar(0.04)),
 		  m_useConvexConservativeDistanceUtil(false),
 		  m_convexConservativeDistanceThreshold(0.0f),
-		  m_deterministicOverlappingPairs(false)
+		  m_deterministicOverlappingPairs(false),
+		  m_useSpeculativeContacts(false),
+		  m_useGjkWarmStart(true)
 	{
 	}
 	btScalar m_timeStep;
@@ -63,6 +65,8 @@ struct btDispatcherInfo
 	bool m_useConvexConservativeDistanceUtil;
 	btScalar m_convexConservativeDistanceThreshold;
 	bool m_deterministicOverlappingPairs;
+	bool m_useSpeculativeContacts;
+	bool m_useGjkWarmStart;
 };
 
 enum ebtDispatcherQueryType
@@ -14,10 +14,13 @@ subject to the following restrictions:
 */
 
 #include "btQuantizedBvh.h"
+#include "btBvhSahBinning.h"
 
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
 
 #define RAYAABB2
 
@@ -33,7 +36,7 @@ btQuantizedBvh::btQuantizedBvh() : m_bulletVersion(BT_BULLET_VERSION),
 	m_bvhAabbMax.setValue(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY);
 }
 
-void btQuantizedBvh::buildInternal()
+void btQuantizedBvh::buildInternal(btBuildMode buildMode)
 {
 	///assumes that caller filled in the m_quantizedLeafNodes
 	m_useQuantization = true;
@@ -49,7 +52,14 @@ void btQuantizedBvh::buildInternal()
 
 	m_curNodeIndex = 0;
 
-	buildTree(0, numLeafNodes);
+	if (buildMode == BUILD_SURFACE_AREA_HEURISTIC)
+	{
+		buildTreeSah(numLeafNodes);
+	}
+	else
+	{
+		buildTree(0, numLeafNodes);
+	}
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if (m_useQuantization && !m_SubtreeHeaders.size())
@@ -309,6 +319,576 @@ int btQuantizedBvh::calcSplittingAxis(int startIndex, int endIndex)
 	return variance.maxAxis();
 }
 
+///deeper ranges are split at the median, so that the recursion stays bounded for degenerate meshes
+#define BT_BVH_SAH_MAX_DEPTH 64
+///ranges with more leaves are split one level at a time with parallel binning, smaller ranges are built by a single task
+#define BT_BVH_SAH_TASK_SIZE 8192
+///the number of leaves that are binned or partitioned by one task of the parallel splits
+#define BT_BVH_SAH_CHUNK_SIZE 8192
+
+///the quantized box of a leaf node during the surface area heuristic build
+struct btBvhSahPrimitive : public btBvhSahQuantizedAabb
+{
+	int m_leafIndex;
+};
+
+static void btBvhSahParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler() && iEnd - iBegin > grainSize)
+	{
+		btParallelFor(iBegin, iEnd, grainSize, body);
+		return;
+	}
+#endif
+	body.forLoop(iBegin, iEnd);
+}
+
+///a range of leaves and the node it is built into, the left child of a node over n leaves follows it directly and
+///its right child starts 2*(number of leaves of the left child)-1 nodes later, so subtrees can be written independently
+struct btBvhSahRange
+{
+	int m_begin;
+	int m_end;
+	int m_nodeIndex;
+	int m_depth;
+	int m_splitIndex;
+};
+
+///btBvhSahBuilder sorts the leaves into subtrees with a binned surface area heuristic. The splits of large ranges
+///bin and partition the leaves in parallel chunks, the results do not depend on the number of threads.
+struct btBvhSahBuilder
+{
+	btAlignedObjectArray<btBvhSahPrimitive> m_primitives;
+	btAlignedObjectArray<btBvhSahPrimitive> m_scratch;
+	///the length of the quantization steps on each axis, to measure the surface areas in world units
+	btScalar m_axisScale[3];
+
+	struct ChunkCentroidBoundsBody : public btIParallelForBody
+	{
+		const btBvhSahBuilder* m_builder;
+		int m_begin;
+		int m_end;
+		int (*m_centroidMin)[3];
+		int (*m_centroidMax)[3];
+
+		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+		{
+			for (int chunk = iBegin; chunk < iEnd; chunk++)
+			{
+				const int begin = m_begin + chunk * BT_BVH_SAH_CHUNK_SIZE;
+				btBvhSahCalcCentroidBounds(m_builder->m_primitives, begin, btMin(begin + BT_BVH_SAH_CHUNK_SIZE, m_end), m_centroidMin[chunk], m_centroidMax[chunk]);
+			}
+		}
+	};
+
+	struct ChunkBinBody : public btIParallelForBody
+	{
+		const btBvhSahBuilder* m_builder;
+		int m_begin;
+		int m_end;
+		const int* m_centroidMin;
+		const int* m_centroidMax;
+		btBvhSahBins* m_bins;
+
+		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+		{
+			for (int chunk = iBegin; chunk < iEnd; chunk++)
+			{
+				const int begin = m_begin + chunk * BT_BVH_SAH_CHUNK_SIZE;
+				btBvhSahBinPrimitives(m_builder->m_primitives, begin, btMin(begin + BT_BVH_SAH_CHUNK_SIZE, m_end), m_centroidMin, m_centroidMax, BT_BVH_SAH_NUM_BINS, m_bins[chunk]);
+			}
+		}
+	};
+
+	struct ChunkPartitionBody : public btIParallelForBody
+	{
+		btBvhSahBuilder* m_builder;
+		int m_begin;
+		int m_end;
+		int m_axis;
+		int m_splitBin;
+		int m_centroidMin;
+		btScalar m_binScale;
+		///the first index of the chunk in the left and in the right half
+		const int* m_leftOffsets;
+		const int* m_rightOffsets;
+
+		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+		{
+			for (int chunk = iBegin; chunk < iEnd; chunk++)
+			{
+				const int begin = m_begin + chunk * BT_BVH_SAH_CHUNK_SIZE;
+				const int end = btMin(begin + BT_BVH_SAH_CHUNK_SIZE, m_end);
+				int left = m_leftOffsets[chunk];
+				int right = m_rightOffsets[chunk];
+				for (int i = begin; i < end; i++)
+				{
+					const btBvhSahPrimitive& primitive = m_builder->m_primitives[i];
+					if (btBvhSahGetBin(primitive.getCentroid(m_axis), m_centroidMin, m_binScale, BT_BVH_SAH_NUM_BINS) <= m_splitBin)
+					{
+						m_builder->m_scratch[left++] = primitive;
+					}
+					else
+					{
+						m_builder->m_scratch[right++] = primitive;
+					}
+				}
+			}
+		}
+	};
+
+	struct ChunkCopyBody : public btIParallelForBody
+	{
+		btBvhSahBuilder* m_builder;
+		int m_begin;
+		int m_end;
+
+		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+		{
+			for (int chunk = iBegin; chunk < iEnd; chunk++)
+			{
+				const int begin = m_begin + chunk * BT_BVH_SAH_CHUNK_SIZE;
+				const int end = btMin(begin + BT_BVH_SAH_CHUNK_SIZE, m_end);
+				for (int i = begin; i < end; i++)
+				{
+					m_builder->m_primitives[i] = m_builder->m_scratch[i];
+				}
+			}
+		}
+	};
+
+	///splits the range in two non-empty halves and returns the first index of the second half.
+	///Ranges larger than BT_BVH_SAH_TASK_SIZE are binned and partitioned in parallel chunks.
+	int splitRange(int begin, int end, int depth)
+	{
+		if (end - begin == 2)
+		{
+			return begin + 1;
+		}
+		const int numChunks = (end - begin + BT_BVH_SAH_CHUNK_SIZE - 1) / BT_BVH_SAH_CHUNK_SIZE;
+		const bool parallel = end - begin > BT_BVH_SAH_TASK_SIZE;
+
+		int centroidMin[3];
+		int centroidMax[3];
+		if (parallel)
+		{
+			btAlignedObjectArray<int> chunkBounds;
+			chunkBounds.resize(numChunks * 6);
+			ChunkCentroidBoundsBody body;
+			body.m_builder = this;
+			body.m_begin = begin;
+			body.m_end = end;
+			body.m_centroidMin = (int(*)[3]) & chunkBounds[0];
+			body.m_centroidMax = (int(*)[3]) & chunkBounds[numChunks * 3];
+			btBvhSahParallelFor(0, numChunks, 1, body);
+			centroidMin[0] = centroidMin[1] = centroidMin[2] = 0x7fffffff;
+			centroidMax[0] = centroidMax[1] = centroidMax[2] = 0;
+			for (int chunk = 0; chunk < numChunks; chunk++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					centroidMin[axis] = btMin(centroidMin[axis], body.m_centroidMin[chunk][axis]);
+					centroidMax[axis] = btMax(centroidMax[axis], body.m_centroidMax[chunk][axis]);
+				}
+			}
+		}
+		else
+		{
+			btBvhSahCalcCentroidBounds(m_primitives, begin, end, centroidMin, centroidMax);
+		}
+
+		const int largestAxis = btBvhSahGetLargestAxis(centroidMin, centroidMax);
+		const int mid = (begin + end) / 2;
+		if (centroidMax[largestAxis] == centroidMin[largestAxis])
+		{
+			//all centers coincide, any split is as good as the others
+			return mid;
+		}
+		if (depth >= BT_BVH_SAH_MAX_DEPTH)
+		{
+			btBvhSahSelectMedian(m_primitives, begin, end, mid, largestAxis);
+			return mid;
+		}
+
+		const int numBins = btMin(end - begin, BT_BVH_SAH_NUM_BINS);
+		btBvhSahBins bins;
+		btAlignedObjectArray<btBvhSahBins> chunkBins;
+		if (parallel)
+		{
+			chunkBins.resize(numChunks);
+			ChunkBinBody body;
+			body.m_builder = this;
+			body.m_begin = begin;
+			body.m_end = end;
+			body.m_centroidMin = centroidMin;
+			body.m_centroidMax = centroidMax;
+			body.m_bins = &chunkBins[0];
+			btBvhSahParallelFor(0, numChunks, 1, body);
+			bins = chunkBins[0];
+			for (int chunk = 1; chunk < numChunks; chunk++)
+			{
+				bins.merge(chunkBins[chunk]);
+			}
+		}
+		else
+		{
+			btBvhSahBinPrimitives(m_primitives, begin, end, centroidMin, centroidMax, numBins, bins);
+		}
+
+		int bestAxis;
+		int bestBin;
+		if (!btBvhSahFindBestSplit(bins, centroidMin, centroidMax, m_axisScale, bestAxis, bestBin))
+		{
+			btBvhSahSelectMedian(m_primitives, begin, end, mid, largestAxis);
+			return mid;
+		}
+
+		if (parallel)
+		{
+			//stable partition: the bins of each chunk tell how many of its leaves go left, so each chunk
+			//scatters its leaves to its own offsets
+			btAlignedObjectArray<int> offsets;
+			offsets.resize(numChunks * 2);
+			int numLeft = 0;
+			for (int chunk = 0; chunk < numChunks; chunk++)
+			{
+				for (int b = 0; b <= bestBin; b++)
+				{
+					numLeft += chunkBins[chunk].m_bins[bestAxis][b].m_count;
+				}
+			}
+			int left = begin;
+			int right = begin + numLeft;
+			for (int chunk = 0; chunk < numChunks; chunk++)
+			{
+				const int chunkSize = btMin(BT_BVH_SAH_CHUNK_SIZE, end - begin - chunk * BT_BVH_SAH_CHUNK_SIZE);
+				int chunkLeft = 0;
+				for (int b = 0; b <= bestBin; b++)
+				{
+					chunkLeft += chunkBins[chunk].m_bins[bestAxis][b].m_count;
+				}
+				offsets[chunk] = left;
+				offsets[numChunks + chunk] = right;
+				left += chunkLeft;
+				right += chunkSize - chunkLeft;
+			}
+			ChunkPartitionBody body;
+			body.m_builder = this;
+			body.m_begin = begin;
+			body.m_end = end;
+			body.m_axis = bestAxis;
+			body.m_splitBin = bestBin;
+			body.m_centroidMin = centroidMin[bestAxis];
+			body.m_binScale = btBvhSahGetBinScale(centroidMin[bestAxis], centroidMax[bestAxis], BT_BVH_SAH_NUM_BINS);
+			body.m_leftOffsets = &offsets[0];
+			body.m_rightOffsets = &offsets[numChunks];
+			btBvhSahParallelFor(0, numChunks, 1, body);
+
+			ChunkCopyBody copyBody;
+			copyBody.m_builder = this;
+			copyBody.m_begin = begin;
+			copyBody.m_end = end;
+			btBvhSahParallelFor(0, numChunks, 1, copyBody);
+			btAssert(numLeft > 0 && numLeft < end - begin);
+			return begin + numLeft;
+		}
+
+		const int splitIndex = btBvhSahPartition(m_primitives, begin, end, bestAxis, bestBin, centroidMin, centroidMax, numBins);
+		btAssert(splitIndex > begin && splitIndex < end);
+		return splitIndex;
+	}
+};
+
+static SIMD_FORCE_INLINE void btBvhSahQuantize(unsigned short* out, const btVector3& point, const btVector3& aabbMin, const btVector3& quantization, int isMax)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		btScalar v = (point[axis] - aabbMin[axis]) * quantization[axis];
+		v = btMax(btMin(v + (isMax ? btScalar(1.) : btScalar(0.)), btScalar(65535.)), btScalar(0.));
+		out[axis] = (unsigned short)v;
+	}
+}
+
+void btQuantizedBvh::mergeChildNodes(int nodeIndex, int leftChildNodeIndex, int rightChildNodeIndex, int escapeIndex)
+{
+	if (m_useQuantization)
+	{
+		btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+		const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+		const btQuantizedBvhNode& rightChildNode = m_quantizedContiguousNodes[rightChildNodeIndex];
+		for (int i = 0; i < 3; i++)
+		{
+			node.m_quantizedAabbMin[i] = btMin(leftChildNode.m_quantizedAabbMin[i], rightChildNode.m_quantizedAabbMin[i]);
+			node.m_quantizedAabbMax[i] = btMax(leftChildNode.m_quantizedAabbMax[i], rightChildNode.m_quantizedAabbMax[i]);
+		}
+	}
+	else
+	{
+		btOptimizedBvhNode& node = m_contiguousNodes[nodeIndex];
+		node.m_aabbMinOrg = m_contiguousNodes[leftChildNodeIndex].m_aabbMinOrg;
+		node.m_aabbMinOrg.setMin(m_contiguousNodes[rightChildNodeIndex].m_aabbMinOrg);
+		node.m_aabbMaxOrg = m_contiguousNodes[leftChildNodeIndex].m_aabbMaxOrg;
+		node.m_aabbMaxOrg.setMax(m_contiguousNodes[rightChildNodeIndex].m_aabbMaxOrg);
+	}
+	setInternalNodeEscapeIndex(nodeIndex, escapeIndex);
+}
+
+void btQuantizedBvh::buildSubtreeSah(btBvhSahBuilder& builder, int startIndex, int endIndex, int nodeIndex, int depth)
+{
+	if (endIndex - startIndex == 1)
+	{
+		assignInternalNodeFromLeafNode(nodeIndex, builder.m_primitives[startIndex].m_leafIndex);
+		return;
+	}
+	const int splitIndex = builder.splitRange(startIndex, endIndex, depth);
+	const int leftChildNodeIndex = nodeIndex + 1;
+	const int rightChildNodeIndex = nodeIndex + 2 * (splitIndex - startIndex);
+	buildSubtreeSah(builder, startIndex, splitIndex, leftChildNodeIndex, depth + 1);
+	buildSubtreeSah(builder, splitIndex, endIndex, rightChildNodeIndex, depth + 1);
+	mergeChildNodes(nodeIndex, leftChildNodeIndex, rightChildNodeIndex, 2 * (endIndex - startIndex) - 1);
+}
+
+void btQuantizedBvh::buildTreeSah(int numLeafNodes)
+{
+	BT_PROFILE("btQuantizedBvh::buildTreeSah");
+	m_curNodeIndex = 0;
+	if (numLeafNodes <= 0)
+	{
+		return;
+	}
+
+	buildNodesSah(0, numLeafNodes);
+	m_curNodeIndex = 2 * numLeafNodes - 1;
+
+	if (m_useQuantization)
+	{
+		buildSubtreeHeaders(0);
+	}
+}
+
+void btQuantizedBvh::buildNodesSah(int rootNodeIndex, int numLeafNodes)
+{
+	btBvhSahBuilder builder;
+	builder.m_primitives.resize(numLeafNodes);
+	if (numLeafNodes > BT_BVH_SAH_TASK_SIZE)
+	{
+		builder.m_scratch.resize(numLeafNodes);
+	}
+
+	//quantized trees are built on the quantized leaf boxes, the other trees quantize their leaf boxes for the build only
+	btVector3 aabbMin = m_bvhAabbMin;
+	btVector3 quantization = m_bvhQuantization;
+	if (!m_useQuantization)
+	{
+		btVector3 aabbMax = m_leafNodes[0].m_aabbMaxOrg;
+		aabbMin = m_leafNodes[0].m_aabbMinOrg;
+		for (int i = 1; i < numLeafNodes; i++)
+		{
+			aabbMin.setMin(m_leafNodes[i].m_aabbMinOrg);
+			aabbMax.setMax(m_leafNodes[i].m_aabbMaxOrg);
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const btScalar size = aabbMax[axis] - aabbMin[axis];
+			quantization[axis] = size > SIMD_EPSILON ? btScalar(65534.) / size : btScalar(1.);
+		}
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		builder.m_axisScale[axis] = btScalar(1.) / quantization[axis];
+	}
+
+	struct InitPrimitivesBody : public btIParallelForBody
+	{
+		btBvhSahPrimitive* m_primitives;
+		const btQuantizedBvhNode* m_quantizedLeafNodes;
+		const btOptimizedBvhNode* m_leafNodes;
+		btVector3 m_aabbMin;
+		btVector3 m_quantization;
+
+		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+		{
+			for (int i = iBegin; i < iEnd; i++)
+			{
+				btBvhSahPrimitive& primitive = m_primitives[i];
+				if (m_quantizedLeafNodes)
+				{
+					for (int axis = 0; axis < 3; axis++)
+					{
+						primitive.m_quantizedAabbMin[axis] = m_quantizedLeafNodes[i].m_quantizedAabbMin[axis];
+						primitive.m_quantizedAabbMax[axis] = m_quantizedLeafNodes[i].m_quantizedAabbMax[axis];
+					}
+				}
+				else
+				{
+					btBvhSahQuantize(primitive.m_quantizedAabbMin, m_leafNodes[i].m_aabbMinOrg, m_aabbMin, m_quantization, 0);
+					btBvhSahQuantize(primitive.m_quantizedAabbMax, m_leafNodes[i].m_aabbMaxOrg, m_aabbMin, m_quantization, 1);
+				}
+				primitive.m_leafIndex = i;
+			}
+		}
+	};
+	InitPrimitivesBody initBody;
+	initBody.m_primitives = &builder.m_primitives[0];
+	initBody.m_quantizedLeafNodes = m_useQuantization ? &m_quantizedLeafNodes[0] : 0;
+	initBody.m_leafNodes = m_useQuantization ? 0 : &m_leafNodes[0];
+	initBody.m_aabbMin = aabbMin;
+	initBody.m_quantization = quantization;
+	btBvhSahParallelFor(0, numLeafNodes, BT_BVH_SAH_CHUNK_SIZE, initBody);
+
+	//split the top of the tree one level at a time, each split bins and partitions in parallel,
+	//until the ranges are small enough to be built as independent tasks
+	btAlignedObjectArray<btBvhSahRange> stack;
+	btAlignedObjectArray<btBvhSahRange> tasks;
+	btAlignedObjectArray<btBvhSahRange> topNodes;
+	btBvhSahRange root;
+	root.m_begin = 0;
+	root.m_end = numLeafNodes;
+	root.m_nodeIndex = rootNodeIndex;
+	root.m_depth = 0;
+	root.m_splitIndex = 0;
+	stack.push_back(root);
+	while (stack.size())
+	{
+		btBvhSahRange range = stack[stack.size() - 1];
+		stack.pop_back();
+		if (range.m_end - range.m_begin <= BT_BVH_SAH_TASK_SIZE)
+		{
+			tasks.push_back(range);
+			continue;
+		}
+		range.m_splitIndex = builder.splitRange(range.m_begin, range.m_end, range.m_depth);
+		topNodes.push_back(range);
+
+		btBvhSahRange leftRange = range;
+		leftRange.m_end = range.m_splitIndex;
+		leftRange.m_nodeIndex = range.m_nodeIndex + 1;
+		leftRange.m_depth = range.m_depth + 1;
+		btBvhSahRange rightRange = range;
+		rightRange.m_begin = range.m_splitIndex;
+		rightRange.m_nodeIndex = range.m_nodeIndex + 2 * (range.m_splitIndex - range.m_begin);
+		rightRange.m_depth = range.m_depth + 1;
+		stack.push_back(rightRange);
+		stack.push_back(leftRange);
+	}
+
+	struct BuildSubtreesBody : public btIParallelForBody
+	{
+		btQuantizedBvh* m_bvh;
+		btBvhSahBuilder* m_builder;
+		const btBvhSahRange* m_tasks;
+
+		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+		{
+			for (int i = iBegin; i < iEnd; i++)
+			{
+				const btBvhSahRange& range = m_tasks[i];
+				m_bvh->buildSubtreeSah(*m_builder, range.m_begin, range.m_end, range.m_nodeIndex, range.m_depth);
+			}
+		}
+	};
+	BuildSubtreesBody subtreesBody;
+	subtreesBody.m_bvh = this;
+	subtreesBody.m_builder = &builder;
+	subtreesBody.m_tasks = &tasks[0];
+	btBvhSahParallelFor(0, tasks.size(), 1, subtreesBody);
+
+	//the children of the top nodes are complete now, merge them bottom up
+	for (int i = topNodes.size() - 1; i >= 0; i--)
+	{
+		const btBvhSahRange& range = topNodes[i];
+		mergeChildNodes(range.m_nodeIndex, range.m_nodeIndex + 1, range.m_nodeIndex + 2 * (range.m_splitIndex - range.m_begin), 2 * (range.m_end - range.m_begin) - 1);
+	}
+}
+
+///adds the same subtree headers as buildTree, in the same order
+void btQuantizedBvh::buildSubtreeHeaders(int nodeIndex)
+{
+	const btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+	if (node.isLeafNode() || node.getEscapeIndex() * static_cast<int>(sizeof(btQuantizedBvhNode)) <= MAX_SUBTREE_SIZE_IN_BYTES)
+	{
+		return;
+	}
+	const int leftChildNodeIndex = nodeIndex + 1;
+	const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+	const int rightChildNodeIndex = leftChildNodeIndex + (leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+	buildSubtreeHeaders(leftChildNodeIndex);
+	buildSubtreeHeaders(rightChildNodeIndex);
+	updateSubtreeHeaders(leftChildNodeIndex, rightChildNodeIndex);
+}
+
+void btQuantizedBvh::rebuildSubtree(int nodeIndex)
+{
+	BT_PROFILE("btQuantizedBvh::rebuildSubtree");
+	int numNodes;
+	if (m_useQuantization)
+	{
+		const btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+		numNodes = node.isLeafNode() ? 1 : node.getEscapeIndex();
+	}
+	else
+	{
+		const btOptimizedBvhNode& node = m_contiguousNodes[nodeIndex];
+		numNodes = node.m_escapeIndex == -1 ? 1 : node.m_escapeIndex;
+	}
+	if (numNodes < 5)
+	{
+		//a subtree of one or two leaves has a single layout
+		return;
+	}
+
+	//gather the leaves of the subtree, they are rebuilt in place from the temporary leaf arrays
+	const int numLeafNodes = (numNodes + 1) / 2;
+	if (m_useQuantization)
+	{
+		m_quantizedLeafNodes.resize(0);
+		m_quantizedLeafNodes.reserve(numLeafNodes);
+		for (int i = nodeIndex; i < nodeIndex + numNodes; i++)
+		{
+			if (m_quantizedContiguousNodes[i].isLeafNode())
+			{
+				m_quantizedLeafNodes.push_back(m_quantizedContiguousNodes[i]);
+			}
+		}
+	}
+	else
+	{
+		m_leafNodes.resize(0);
+		m_leafNodes.reserve(numLeafNodes);
+		for (int i = nodeIndex; i < nodeIndex + numNodes; i++)
+		{
+			if (m_contiguousNodes[i].m_escapeIndex == -1)
+			{
+				m_leafNodes.push_back(m_contiguousNodes[i]);
+			}
+		}
+	}
+	btAssert(m_quantizedLeafNodes.size() + m_leafNodes.size() == numLeafNodes);
+
+	buildNodesSah(nodeIndex, numLeafNodes);
+
+	//the subtree headers below a subtree larger than a header are rebuilt too, smaller subtrees are inside a header
+	if (m_useQuantization && numNodes * static_cast<int>(sizeof(btQuantizedBvhNode)) > MAX_SUBTREE_SIZE_IN_BYTES)
+	{
+		int numHeaders = 0;
+		for (int i = 0; i < m_SubtreeHeaders.size(); i++)
+		{
+			const int rootNodeIndex = m_SubtreeHeaders[i].m_rootNodeIndex;
+			if (rootNodeIndex < nodeIndex || rootNodeIndex >= nodeIndex + numNodes)
+			{
+				m_SubtreeHeaders[numHeaders++] = m_SubtreeHeaders[i];
+			}
+		}
+		m_SubtreeHeaders.resize(numHeaders);
+		buildSubtreeHeaders(nodeIndex);
+		m_subtreeHeaderCount = m_SubtreeHeaders.size();
+	}
+
+	m_quantizedLeafNodes.clear();
+	m_leafNodes.clear();
+}
+
 void btQuantizedBvh::reportAabbOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const
 {
 	//either choose recursive traversal (walkTree) or stackless (walkStacklessTree)
@@ -650,6 +1230,99 @@ void btQuantizedBvh::walkStacklessQuantizedTreeAgainstRay(btNodeOverlapCallback*
 	}
 }
 
+///forwards the nodes found by the single ray walk of a ray packet, once the rays have diverged
+struct btSingleRayOfPacketNodeCallback : public btNodeOverlapCallback
+{
+	btNodeRayPacketOverlapCallback* m_packetCallback;
+	unsigned int m_rayMask;
+
+	btSingleRayOfPacketNodeCallback(btNodeRayPacketOverlapCallback* packetCallback, unsigned int rayMask)
+		: m_packetCallback(packetCallback),
+		  m_rayMask(rayMask)
+	{
+	}
+
+	virtual void processNode(int subPart, int triangleIndex)
+	{
+		m_packetCallback->processNode(subPart, triangleIndex, m_rayMask);
+	}
+};
+
+void btQuantizedBvh::walkStacklessQuantizedTreeAgainstRayPacket(btNodeRayPacketOverlapCallback* nodeCallback, const btRayPacket& packet, int startNodeIndex, int endNodeIndex) const
+{
+	btAssert(m_useQuantization);
+
+	const unsigned int activeMask = packet.getActiveMask();
+	if (activeMask == 0)
+	{
+		return;
+	}
+
+	int curIndex = startNodeIndex;
+	const btQuantizedBvhNode* rootNode = &m_quantizedContiguousNodes[startNodeIndex];
+	int escapeIndex;
+	bool isLeafNode;
+	unsigned rayMask;
+
+	/* Quick pruning by the quantized box around all rays of the packet */
+	btVector3 packetAabbMin = packet.m_rayFrom[0];
+	btVector3 packetAabbMax = packet.m_rayFrom[0];
+	for (int i = 0; i < packet.m_numRays; i++)
+	{
+		packetAabbMin.setMin(packet.m_rayFrom[i]);
+		packetAabbMin.setMin(packet.m_rayTo[i]);
+		packetAabbMax.setMax(packet.m_rayFrom[i]);
+		packetAabbMax.setMax(packet.m_rayTo[i]);
+	}
+	unsigned short int quantizedQueryAabbMin[3];
+	unsigned short int quantizedQueryAabbMax[3];
+	quantizeWithClamp(quantizedQueryAabbMin, packetAabbMin, 0);
+	quantizeWithClamp(quantizedQueryAabbMax, packetAabbMax, 1);
+
+	while (curIndex < endNodeIndex)
+	{
+		rayMask = 0;
+		if (testQuantizedAabbAgainstQuantizedAabb(quantizedQueryAabbMin, quantizedQueryAabbMax, rootNode->m_quantizedAabbMin, rootNode->m_quantizedAabbMax))
+		{
+			//the stackless walk doesn't remember the mask of the parent, so each node is tested against all rays
+			//(this is still conservative, because the quantized node boxes contain the boxes of their children)
+			rayMask = packet.testAabb(unQuantize(rootNode->m_quantizedAabbMin), unQuantize(rootNode->m_quantizedAabbMax), activeMask);
+		}
+		isLeafNode = rootNode->isLeafNode();
+
+		if (isLeafNode)
+		{
+			if (rayMask)
+			{
+				nodeCallback->processNode(rootNode->getPartId(), rootNode->getTriangleIndex(), rayMask);
+			}
+			rootNode++;
+			curIndex++;
+		}
+		else if (btRayPacket::isSingleRay(rayMask))
+		{
+			//the rays diverged, finish this subtree with the single ray walk
+			const int ray = btRayPacket::getFirstRay(rayMask);
+			escapeIndex = rootNode->getEscapeIndex();
+			btSingleRayOfPacketNodeCallback singleRayCallback(nodeCallback, rayMask);
+			walkStacklessQuantizedTreeAgainstRay(&singleRayCallback, packet.m_rayFrom[ray], packet.m_rayTo[ray], btVector3(0, 0, 0), btVector3(0, 0, 0), curIndex, curIndex + escapeIndex);
+			rootNode += escapeIndex;
+			curIndex += escapeIndex;
+		}
+		else if (rayMask)
+		{
+			rootNode++;
+			curIndex++;
+		}
+		else
+		{
+			escapeIndex = rootNode->getEscapeIndex();
+			rootNode += escapeIndex;
+			curIndex += escapeIndex;
+		}
+	}
+}
+
 void btQuantizedBvh::walkStacklessQuantizedTree(btNodeOverlapCallback* nodeCallback, unsigned short int* quantizedQueryAabbMin, unsigned short int* quantizedQueryAabbMax, int startNodeIndex, int endNodeIndex) const
 {
 	btAssert(m_useQuantization);
@@ -765,6 +1438,23 @@ void btQuantizedBvh::reportBoxCastOverlappingNodex(btNodeOverlapCallback* nodeCa
 	*/
 }
 
+void btQuantizedBvh::reportRayPacketOverlappingNodex(btNodeRayPacketOverlapCallback* nodeCallback, const btRayPacket& packet) const
+{
+	if (m_useQuantization)
+	{
+		walkStacklessQuantizedTreeAgainstRayPacket(nodeCallback, packet, 0, m_curNodeIndex);
+	}
+	else
+	{
+		//no packet walk for the unquantized tree, walk it once per ray
+		for (int i = 0; i < packet.m_numRays; i++)
+		{
+			btSingleRayOfPacketNodeCallback singleRayCallback(nodeCallback, 1u << i);
+			walkStacklessTreeAgainstRay(&singleRayCallback, packet.m_rayFrom[i], packet.m_rayTo[i], btVector3(0, 0, 0), btVector3(0, 0, 0), 0, m_curNodeIndex);
+		}
+	}
+}
+
 void btQuantizedBvh::swapLeafNodes(int i, int splitIndex)
 {
 	if (m_useQuantization)
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_QUANTIZED_BVH_H
 
 class btSerializer;
+struct btBvhSahBuilder;
 
 //#define DEBUG_CHECK_DEQUANTIZATION 1
 #ifdef DEBUG_CHECK_DEQUANTIZATION
@@ -30,6 +31,7 @@ class btSerializer;
 
 #include "LinearMath/btVector3.h"
 #include "LinearMath/btAlignedAllocator.h"
+#include "btRayPacket.h"
 
 #ifdef BT_USE_DOUBLE_PRECISION
 #define btQuantizedBvhData btQuantizedBvhDoubleData
@@ -152,6 +154,15 @@ public:
 	virtual void processNode(int subPart, int triangleIndex) = 0;
 };
 
+///btNodeRayPacketOverlapCallback is used by reportRayPacketOverlappingNodex, rayMask has a bit set for every ray of the packet that overlaps the leaf node
+class btNodeRayPacketOverlapCallback
+{
+public:
+	virtual ~btNodeRayPacketOverlapCallback(){};
+
+	virtual void processNode(int subPart, int triangleIndex, unsigned int rayMask) = 0;
+};
+
 #include "LinearMath/btAlignedAllocator.h"
 #include "LinearMath/btAlignedObjectArray.h"
 
@@ -174,6 +185,15 @@ public:
 		TRAVERSAL_RECURSIVE
 	};
 
+	///BUILD_SURFACE_AREA_HEURISTIC, the default, builds the tree with a parallel binned surface area heuristic. It gives faster
+	///queries and builds than BUILD_MEDIAN_SPLIT, the original median split of the variance axis, with the same node format
+	///and query results, but a different tree.
+	enum btBuildMode
+	{
+		BUILD_MEDIAN_SPLIT = 0,
+		BUILD_SURFACE_AREA_HEURISTIC
+	};
+
 protected:
 	btVector3 m_bvhAabbMin;
 	btVector3 m_bvhAabbMax;
@@ -284,6 +304,18 @@ protected:
 protected:
 	void buildTree(int startIndex, int endIndex);
 
+	///builds the same node layout as buildTree, using btParallelFor when a task scheduler is set
+	void buildTreeSah(int numLeafNodes);
+
+	///builds the 2*numLeafNodes-1 nodes starting at rootNodeIndex from the leaf arrays, without subtree headers
+	void buildNodesSah(int rootNodeIndex, int numLeafNodes);
+
+	void buildSubtreeSah(btBvhSahBuilder & builder, int startIndex, int endIndex, int nodeIndex, int depth);
+
+	void mergeChildNodes(int nodeIndex, int leftChildNodeIndex, int rightChildNodeIndex, int escapeIndex);
+
+	void buildSubtreeHeaders(int nodeIndex);
+
 	int calcSplittingAxis(int startIndex, int endIndex);
 
 	int sortAndCalcSplittingIndex(int startIndex, int endIndex, int splitAxis);
@@ -291,6 +323,7 @@ protected:
 	void walkStacklessTree(btNodeOverlapCallback * nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const;
 
 	void walkStacklessQuantizedTreeAgainstRay(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax, int startNodeIndex, int endNodeIndex) const;
+	void walkStacklessQuantizedTreeAgainstRayPacket(btNodeRayPacketOverlapCallback * nodeCallback, const btRayPacket& packet, int startNodeIndex, int endNodeIndex) const;
 	void walkStacklessQuantizedTree(btNodeOverlapCallback * nodeCallback, unsigned short int* quantizedQueryAabbMin, unsigned short int* quantizedQueryAabbMax, int startNodeIndex, int endNodeIndex) const;
 	void walkStacklessTreeAgainstRay(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax, int startNodeIndex, int endNodeIndex) const;
 
@@ -316,12 +349,17 @@ public:
 	void setQuantizationValues(const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, btScalar quantizationMargin = btScalar(1.0));
 	QuantizedNodeArray& getLeafNodeArray() { return m_quantizedLeafNodes; }
 	///buildInternal is expert use only: assumes that setQuantizationValues and LeafNodeArray are initialized
-	void buildInternal();
+	void buildInternal(btBuildMode buildMode = BUILD_SURFACE_AREA_HEURISTIC);
+	///rebuildSubtree rebuilds the subtree at nodeIndex in place with the surface area heuristic builder, using the current leaf boxes.
+	///The subtree keeps its nodes, its leaves and its aabb, so the rest of the tree is not touched. Used to repair subtrees after refits.
+	void rebuildSubtree(int nodeIndex);
 	///***************************************** expert/internal use only *************************
 
 	void reportAabbOverlappingNodex(btNodeOverlapCallback * nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const;
 	void reportRayOverlappingNodex(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget) const;
 	void reportBoxCastOverlappingNodex(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const;
+	///reportRayPacketOverlappingNodex walks the quantized tree once for the whole packet, and continues with the single ray walk for subtrees hit by only one ray
+	void reportRayPacketOverlappingNodex(btNodeRayPacketOverlapCallback * nodeCallback, const btRayPacket& packet) const;
 
 	SIMD_FORCE_INLINE void quantize(unsigned short* out, const btVector3& point, int isMax) const
 	{
@@ -0,0 +1,166 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RAY_PACKET_H
+#define BT_RAY_PACKET_H
+
+#include "LinearMath/btVector3.h"
+
+#define BT_RAY_PACKET_SIZE 4
+
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+#define BT_RAY_PACKET_USE_SSE 1
+#endif
+
+///btRayPacket stores up to BT_RAY_PACKET_SIZE rays in structure-of-arrays layout, so that a bounding box can be tested
+///against all rays at once (4-wide SSE in single precision, scalar otherwise). It is used for the packet traversal
+///of btDbvt and btQuantizedBvh. Each ray is parametrized like btRayAabb2: origin + t * normalized direction, 0 <= t <= lambda_max.
+///The per-ray btRayAabb2 data is kept as well, so a traversal can continue with the single ray code once the rays diverge.
+ATTRIBUTE_ALIGNED16(struct)
+btRayPacket
+{
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btScalar m_origin[3][BT_RAY_PACKET_SIZE];
+	btScalar m_directionInverse[3][BT_RAY_PACKET_SIZE];
+	btScalar m_lambdaMax[BT_RAY_PACKET_SIZE];
+
+	btVector3 m_rayFrom[BT_RAY_PACKET_SIZE];
+	btVector3 m_rayTo[BT_RAY_PACKET_SIZE];
+	btVector3 m_rayDirectionInverse[BT_RAY_PACKET_SIZE];
+	unsigned int m_signs[BT_RAY_PACKET_SIZE][3];
+	int m_numRays;
+
+	btRayPacket()
+		: m_numRays(0)
+	{
+	}
+
+	btRayPacket(const btVector3* rayFrom, const btVector3* rayTo, int numRays)
+	{
+		init(rayFrom, rayTo, numRays);
+	}
+
+	void init(const btVector3* rayFrom, const btVector3* rayTo, int numRays)
+	{
+		btAssert(numRays >= 0 && numRays <= BT_RAY_PACKET_SIZE);
+		m_numRays = numRays;
+		for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+		{
+			if (i < numRays)
+			{
+				setRay(i, rayFrom[i], rayTo[i]);
+			}
+			else
+			{
+				//unused lanes never hit anything
+				setRay(i, btVector3(0, 0, 0), btVector3(0, 0, 0));
+				m_lambdaMax[i] = btScalar(-1.);
+			}
+		}
+	}
+
+	void setRay(int i, const btVector3& rayFrom, const btVector3& rayTo)
+	{
+		m_rayFrom[i] = rayFrom;
+		m_rayTo[i] = rayTo;
+		btVector3 rayDir = rayTo - rayFrom;
+		rayDir.safeNormalize();
+		///what about division by zero? --> just set rayDirection[i] to BT_LARGE_FLOAT, same as btDbvt::rayTest
+		btVector3& inv = m_rayDirectionInverse[i];
+		inv[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+		inv[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+		inv[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+		m_signs[i][0] = inv[0] < 0.0;
+		m_signs[i][1] = inv[1] < 0.0;
+		m_signs[i][2] = inv[2] < 0.0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_origin[axis][i] = rayFrom[axis];
+			m_directionInverse[axis][i] = inv[axis];
+		}
+		m_lambdaMax[i] = rayDir.dot(rayTo - rayFrom);
+	}
+
+	unsigned int getActiveMask() const
+	{
+		return (1u << m_numRays) - 1u;
+	}
+
+	///returns the subset of rayMask for which the ray overlaps the box [aabbMin,aabbMax]
+	unsigned int testAabb(const btVector3& aabbMin, const btVector3& aabbMax, unsigned int rayMask) const
+	{
+#ifdef BT_RAY_PACKET_USE_SSE
+		__m128 tmin = _mm_setzero_ps();
+		__m128 tmax = _mm_load_ps(m_lambdaMax);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const __m128 origin = _mm_load_ps(m_origin[axis]);
+			const __m128 inv = _mm_load_ps(m_directionInverse[axis]);
+			const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabbMin[axis]), origin), inv);
+			const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabbMax[axis]), origin), inv);
+			tmin = _mm_max_ps(tmin, _mm_min_ps(t0, t1));
+			tmax = _mm_min_ps(tmax, _mm_max_ps(t0, t1));
+		}
+		return rayMask & (unsigned int)_mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+#else
+		btScalar tmin[BT_RAY_PACKET_SIZE];
+		btScalar tmax[BT_RAY_PACKET_SIZE];
+		for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+		{
+			tmin[i] = btScalar(0.);
+			tmax[i] = m_lambdaMax[i];
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+			{
+				const btScalar t0 = (aabbMin[axis] - m_origin[axis][i]) * m_directionInverse[axis][i];
+				const btScalar t1 = (aabbMax[axis] - m_origin[axis][i]) * m_directionInverse[axis][i];
+				tmin[i] = btMax(tmin[i], btMin(t0, t1));
+				tmax[i] = btMin(tmax[i], btMax(t0, t1));
+			}
+		}
+		unsigned int hitMask = 0;
+		for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+		{
+			if (tmin[i] <= tmax[i])
+			{
+				hitMask |= 1u << i;
+			}
+		}
+		return rayMask & hitMask;
+#endif  //BT_RAY_PACKET_USE_SSE
+	}
+
+	///returns true if rayMask has exactly one ray left, the traversal then continues with the single ray code
+	static bool isSingleRay(unsigned int rayMask)
+	{
+		return rayMask && ((rayMask & (rayMask - 1u)) == 0);
+	}
+
+	static int getFirstRay(unsigned int rayMask)
+	{
+		btAssert(rayMask);
+		int i = 0;
+		while ((rayMask & (1u << i)) == 0)
+		{
+			i++;
+		}
+		return i;
+	}
+};
+
+#endif  //BT_RAY_PACKET_H
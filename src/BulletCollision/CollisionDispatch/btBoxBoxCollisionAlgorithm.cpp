@@ -19,6 +19,9 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "btBoxBoxDetector.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h"
+#include "BulletCollision/NarrowPhaseCollision/btPointCollector.h"
+#include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
 #define USE_PERSISTENT_CONTACTS 1
 
 btBoxBoxCollisionAlgorithm::btBoxBoxCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
@@ -61,8 +64,31 @@ void btBoxBoxCollisionAlgorithm::processCollision(const btCollisionObjectWrapper
 	input.m_transformA = body0Wrap->getWorldTransform();
 	input.m_transformB = body1Wrap->getWorldTransform();
 
-	btBoxBoxDetector detector(box0, box1);
-	detector.getClosestPoints(input, *resultOut, dispatchInfo.m_debugDraw);
+	bool isSeparated = false;
+	if (m_manifoldPtr->getSpeculativeContactDistance() > btScalar(0.))
+	{
+		//btBoxBoxDetector only reports touching boxes, so separated boxes get a speculative contact at their closest points
+		btVoronoiSimplexSolver simplexSolver;
+		btGjkPairDetector gjkPairDetector(box0, box1, &simplexSolver, 0);
+		btPointCollector closestPoints;
+		btScalar maximumDistance = box0->getMargin() + box1->getMargin() + m_manifoldPtr->getContactBreakingThreshold();
+		btDiscreteCollisionDetectorInterface::ClosestPointInput gjkInput;
+		gjkInput.m_maximumDistanceSquared = maximumDistance * maximumDistance;
+		gjkInput.m_transformA = input.m_transformA;
+		gjkInput.m_transformB = input.m_transformB;
+		gjkPairDetector.getClosestPoints(gjkInput, closestPoints, 0);
+		if (closestPoints.m_hasResult && closestPoints.m_distance > btScalar(0.))
+		{
+			resultOut->addContactPoint(closestPoints.m_normalOnBInWorld, closestPoints.m_pointInWorld, closestPoints.m_distance);
+			isSeparated = true;
+		}
+	}
+
+	if (!isSeparated)
+	{
+		btBoxBoxDetector detector(box0, box1);
+		detector.getClosestPoints(input, *resultOut, dispatchInfo.m_debugDraw);
+	}
 
 #ifdef USE_PERSISTENT_CONTACTS
 	//  refreshContactPoints is only necessary when using persistent contact points. otherwise all points are newly added
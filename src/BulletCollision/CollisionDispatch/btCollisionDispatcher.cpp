@@ -247,6 +247,10 @@ void btCollisionDispatcher::defaultNearCallback(btBroadphasePair& collisionPair,
 		if (collisionPair.m_algorithm)
 		{
 			btManifoldResult contactPointResult(&obj0Wrap, &obj1Wrap);
+			if (dispatchInfo.m_useSpeculativeContacts)
+			{
+				contactPointResult.m_speculativeContactDistance = btManifoldResult::calculateSpeculativeContactDistance(colObj0, colObj1);
+			}
 
 			if (dispatchInfo.m_dispatchFunc == btDispatcherInfo::DISPATCH_DISCRETE)
 			{
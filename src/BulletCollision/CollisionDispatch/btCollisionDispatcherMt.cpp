@@ -26,9 +26,11 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
 btCollisionDispatcherMt::btCollisionDispatcherMt(btCollisionConfiguration* config, int grainSize)
-	: btCollisionDispatcher(config)
+	: btCollisionDispatcher(config),
+	  m_persistentManifoldAllocator(m_persistentManifoldPoolAllocator),
+	  m_collisionAlgorithmAllocator(m_collisionAlgorithmPoolAllocator)
 {
-	m_batchManifoldsPtr.resize(btGetTaskScheduler()->getNumThreads());
+	m_batchThreadData.resize(btGetTaskScheduler()->getNumThreads());
 	m_batchUpdating = false;
 	m_grainSize = grainSize;  // iterations per task
 }
@@ -42,11 +44,12 @@ btPersistentManifold* btCollisionDispatcherMt::getNewManifold(const btCollisionO
 
 	btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(), body1->getContactProcessingThreshold());
 
-	void* mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
+	//when the pool is exhausted the allocator grows its arena, unless we require a contiguous contact pool
+	const bool allowGrowth = (m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0;
+	void* mem = m_persistentManifoldAllocator.allocate(sizeof(btPersistentManifold), allowGrowth);
 	if (NULL == mem)
 	{
-		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
-		if ((m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0)
+		if (allowGrowth)
 		{
 			mem = btAlignedAlloc(sizeof(btPersistentManifold), 16);
 		}
@@ -68,7 +71,11 @@ btPersistentManifold* btCollisionDispatcherMt::getNewManifold(const btCollisionO
 	}
 	else
 	{
-		m_batchManifoldsPtr[btGetCurrentThreadIndex()].push_back(manifold);
+		BatchThreadData& threadData = m_batchThreadData[btGetCurrentThreadIndex()];
+		BatchManifold& batchManifold = threadData.m_manifolds.expandNonInitializing();
+		batchManifold.m_manifold = manifold;
+		batchManifold.m_pairIndex = threadData.m_pairIndex;
+		batchManifold.m_sequence = 0;
 	}
 
 	return manifold;
@@ -90,9 +97,9 @@ void btCollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
 	}
 
 	manifold->~btPersistentManifold();
-	if (m_persistentManifoldPoolAllocator->validPtr(manifold))
+	if (m_persistentManifoldAllocator.validPtr(manifold))
 	{
-		m_persistentManifoldPoolAllocator->freeMemory(manifold);
+		m_persistentManifoldAllocator.freeMemory(manifold);
 	}
 	else
 	{
@@ -100,11 +107,34 @@ void btCollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
 	}
 }
 
+void* btCollisionDispatcherMt::allocateCollisionAlgorithm(int size)
+{
+	void* mem = m_collisionAlgorithmAllocator.allocate(size);
+	if (NULL == mem)
+	{
+		//larger than the pool elements
+		return btAlignedAlloc(static_cast<size_t>(size), 16);
+	}
+	return mem;
+}
+
+void btCollisionDispatcherMt::freeCollisionAlgorithm(void* ptr)
+{
+	if (m_collisionAlgorithmAllocator.validPtr(ptr))
+	{
+		m_collisionAlgorithmAllocator.freeMemory(ptr);
+	}
+	else
+	{
+		btAlignedFree(ptr);
+	}
+}
+
 struct CollisionDispatcherUpdater : public btIParallelForBody
 {
 	btBroadphasePair* mPairArray;
 	btNearCallback mCallback;
-	btCollisionDispatcher* mDispatcher;
+	btCollisionDispatcherMt* mDispatcher;
 	const btDispatcherInfo* mInfo;
 
 	CollisionDispatcherUpdater()
@@ -116,8 +146,10 @@ struct CollisionDispatcherUpdater : public btIParallelForBody
 	}
 	void forLoop(int iBegin, int iEnd) const
 	{
+		int& pairIndex = mDispatcher->m_batchThreadData[btGetCurrentThreadIndex()].m_pairIndex;
 		for (int i = iBegin; i < iEnd; ++i)
 		{
+			pairIndex = i;
 			btBroadphasePair* pair = &mPairArray[i];
 			mCallback(*pair, *mDispatcher, *mInfo);
 		}
@@ -126,11 +158,23 @@ struct CollisionDispatcherUpdater : public btIParallelForBody
 
 void btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher)
 {
+	// return what piled up in the thread caches since the last frame, e.g. the algorithms and manifolds
+	// of the pairs removed by the broadphase on the main thread
+	m_persistentManifoldAllocator.flushCaches();
+	m_collisionAlgorithmAllocator.flushCaches();
+
 	const int pairCount = pairCache->getNumOverlappingPairs();
 	if (pairCount == 0)
 	{
 		return;
 	}
+	// thread indices may go up to the maximum number of threads if the thread count was changed
+	const int maxNumThreads = btGetTaskScheduler()->getMaxNumThreads();
+	if (m_batchThreadData.size() < maxNumThreads)
+	{
+		m_batchThreadData.resize(maxNumThreads);
+	}
+
 	CollisionDispatcherUpdater updater;
 	updater.mCallback = getNearCallback();
 	updater.mPairArray = pairCache->getOverlappingPairArrayPtr();
@@ -141,18 +185,31 @@ void btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache*
 	btParallelFor(0, pairCount, m_grainSize, updater);
 	m_batchUpdating = false;
 
-	// merge new manifolds, if any
-	for (int i = 0; i < m_batchManifoldsPtr.size(); ++i)
+	// merge new manifolds, if any, in the order of their pairs and of their creation within a pair,
+	// so the result does not depend on which thread processed which pair
+	m_batchMergedManifolds.resizeNoInitialize(0);
+	for (int i = 0; i < m_batchThreadData.size(); ++i)
 	{
-		btAlignedObjectArray<btPersistentManifold*>& batchManifoldsPtr = m_batchManifoldsPtr[i];
+		btAlignedObjectArray<BatchManifold>& batchManifoldsPtr = m_batchThreadData[i].m_manifolds;
 
 		for (int j = 0; j < batchManifoldsPtr.size(); ++j)
 		{
-			m_manifoldsPtr.push_back(batchManifoldsPtr[j]);
+			// the near callback of a pair runs on a single thread, so the position in the thread's array gives the creation order
+			BatchManifold& batchManifold = m_batchMergedManifolds.expandNonInitializing();
+			batchManifold = batchManifoldsPtr[j];
+			batchManifold.m_sequence = j;
 		}
 
 		batchManifoldsPtr.resizeNoInitialize(0);
 	}
+	if (m_batchMergedManifolds.size() > 1)
+	{
+		m_batchMergedManifolds.quickSort(BatchManifoldSortPredicate());
+	}
+	for (int i = 0; i < m_batchMergedManifolds.size(); ++i)
+	{
+		m_manifoldsPtr.push_back(m_batchMergedManifolds[i].m_manifold);
+	}
 
 	// update the indices (used when releasing manifolds)
 	for (int i = 0; i < m_manifoldsPtr.size(); ++i)
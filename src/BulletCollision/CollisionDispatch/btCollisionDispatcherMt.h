@@ -18,19 +18,62 @@ subject to the following restrictions:
 
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
 #include "LinearMath/btThreads.h"
+#include "LinearMath/btThreadLocalPoolAllocator.h"
 
+///
+/// btCollisionDispatcherMt -- a version of btCollisionDispatcher that runs the near callbacks of the overlapping pairs
+///                            in parallel with btParallelFor.
+///
+///  Manifolds created while the pairs are dispatched are collected per thread, and added to the manifold array
+///  in the order of their overlapping pairs, so the manifold array does not depend on the number of threads.
+///
+///  Manifolds and collision algorithms are allocated through btThreadLocalPoolAllocator front ends of the pools of the
+///  collision configuration, so the worker threads do not contend for the pool locks. When a pool is exhausted, the
+///  allocators grow their own arena (unless CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION is set for manifolds).
+///  The thread caches are rebalanced at the start of dispatchAllCollisionPairs.
+///
 class btCollisionDispatcherMt : public btCollisionDispatcher
 {
+	friend struct CollisionDispatcherUpdater;
+
 public:
 	btCollisionDispatcherMt(btCollisionConfiguration* config, int grainSize = 40);
 
 	virtual btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) BT_OVERRIDE;
 	virtual void releaseManifold(btPersistentManifold* manifold) BT_OVERRIDE;
 
+	virtual void* allocateCollisionAlgorithm(int size) BT_OVERRIDE;
+	virtual void freeCollisionAlgorithm(void* ptr) BT_OVERRIDE;
+
 	virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher) BT_OVERRIDE;
 
 protected:
-	btAlignedObjectArray<btAlignedObjectArray<btPersistentManifold*> > m_batchManifoldsPtr;
+	struct BatchManifold
+	{
+		btPersistentManifold* m_manifold;
+		int m_pairIndex;  // index of the overlapping pair whose near callback created the manifold
+		int m_sequence;   // creation order within the near callback
+	};
+	struct BatchManifoldSortPredicate
+	{
+		bool operator()(const BatchManifold& a, const BatchManifold& b) const
+		{
+			return a.m_pairIndex < b.m_pairIndex || (a.m_pairIndex == b.m_pairIndex && a.m_sequence < b.m_sequence);
+		}
+	};
+
+	// the state of one thread, padded so that the threads do not write to the same cache line
+	struct BatchThreadData
+	{
+		btAlignedObjectArray<BatchManifold> m_manifolds;
+		int m_pairIndex;  // pair being dispatched
+		char m_padding[64];
+	};
+
+	btAlignedObjectArray<BatchThreadData> m_batchThreadData;  // per thread
+	btAlignedObjectArray<BatchManifold> m_batchMergedManifolds;
+	btThreadLocalPoolAllocator m_persistentManifoldAllocator;
+	btThreadLocalPoolAllocator m_collisionAlgorithmAllocator;
 	bool m_batchUpdating;
 	int m_grainSize;
 };
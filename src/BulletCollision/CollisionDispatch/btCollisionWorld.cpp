@@ -34,6 +34,7 @@ subject to the following restrictions:
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btQuickprof.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
@@ -159,7 +160,7 @@ void btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
 	minAabb -= contactThreshold;
 	maxAabb += contactThreshold;
 
-	if (getDispatchInfo().m_useContinuous && colObj->getInternalType() == btCollisionObject::CO_RIGID_BODY && !colObj->isStaticOrKinematicObject())
+	if ((getDispatchInfo().m_useContinuous || getDispatchInfo().m_useSpeculativeContacts) && colObj->getInternalType() == btCollisionObject::CO_RIGID_BODY && !colObj->isStaticOrKinematicObject())
 	{
 		btVector3 minAabb2, maxAabb2;
 		colObj->getCollisionShape()->getAabb(colObj->getInterpolationWorldTransform(), minAabb2, maxAabb2);
@@ -795,6 +796,14 @@ void btCollisionWorld::objectQuerySingleInternal(const btConvexShape* castShape,
 					btVector3 boxMinLocal, boxMaxLocal;
 					castShape->getAabb(rotationXform, boxMinLocal, boxMaxLocal);
 
+					if (collisionShape->getShapeType() == TERRAIN_SHAPE_PROXYTYPE)
+					{
+						///optimized version for btHeightfieldTerrainShape
+						btHeightfieldTerrainShape* heightField = (btHeightfieldTerrainShape*)collisionShape;
+						heightField->performConvexcast(&tccb, convexFromLocal, convexToLocal, boxMinLocal, boxMaxLocal);
+						return;
+					}
+
 					btVector3 rayAabbMinLocal = convexFromLocal;
 					rayAabbMinLocal.setMin(convexToLocal);
 					btVector3 rayAabbMaxLocal = convexFromLocal;
@@ -936,14 +945,25 @@ struct btSingleRayCallback : public btBroadphaseRayCallback
 	btVector3 m_hitNormal;
 
 	const btCollisionWorld* m_world;
-	btCollisionWorld::RayResultCallback& m_resultCallback;
+	btCollisionWorld::RayResultCallback* m_resultCallback;
+
+	btSingleRayCallback()
+		: m_world(0),
+		  m_resultCallback(0)
+	{
+	}
 
 	btSingleRayCallback(const btVector3& rayFromWorld, const btVector3& rayToWorld, const btCollisionWorld* world, btCollisionWorld::RayResultCallback& resultCallback)
-		: m_rayFromWorld(rayFromWorld),
-		  m_rayToWorld(rayToWorld),
-		  m_world(world),
-		  m_resultCallback(resultCallback)
 	{
+		init(rayFromWorld, rayToWorld, world, resultCallback);
+	}
+
+	void init(const btVector3& rayFromWorld, const btVector3& rayToWorld, const btCollisionWorld* world, btCollisionWorld::RayResultCallback& resultCallback)
+	{
+		m_rayFromWorld = rayFromWorld;
+		m_rayToWorld = rayToWorld;
+		m_world = world;
+		m_resultCallback = &resultCallback;
 		m_rayFromTrans.setIdentity();
 		m_rayFromTrans.setOrigin(m_rayFromWorld);
 		m_rayToTrans.setIdentity();
@@ -966,13 +986,13 @@ struct btSingleRayCallback : public btBroadphaseRayCallback
 	virtual bool process(const btBroadphaseProxy* proxy)
 	{
 		///terminate further ray tests, once the closestHitFraction reached zero
-		if (m_resultCallback.m_closestHitFraction == btScalar(0.f))
+		if (m_resultCallback->m_closestHitFraction == btScalar(0.f))
 			return false;
 
 		btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
 
 		//only perform raycast if filterMask matches
-		if (m_resultCallback.needsCollision(collisionObject->getBroadphaseHandle()))
+		if (m_resultCallback->needsCollision(collisionObject->getBroadphaseHandle()))
 		{
 			//RigidcollisionObject* collisionObject = ctrl->GetRigidcollisionObject();
 			//btVector3 collisionObjectAabbMin,collisionObjectAabbMax;
@@ -994,7 +1014,7 @@ struct btSingleRayCallback : public btBroadphaseRayCallback
 									   collisionObject,
 									   collisionObject->getCollisionShape(),
 									   collisionObject->getWorldTransform(),
-									   m_resultCallback);
+									   *m_resultCallback);
 			}
 		}
 		return true;
@@ -1018,6 +1038,127 @@ void btCollisionWorld::rayTest(const btVector3& rayFromWorld, const btVector3& r
 #endif  //USE_BRUTEFORCE_RAYBROADPHASE
 }
 
+///btPacketTriangleRaycastCallback reports the triangle hits of one ray of a packet cast through a btBvhTriangleMeshShape
+struct btPacketTriangleRaycastCallback : public btTriangleRaycastCallback
+{
+	btCollisionWorld::RayResultCallback* m_resultCallback;
+	const btCollisionObject* m_collisionObject;
+	const btTransform* m_colObjWorldTransform;
+
+	btPacketTriangleRaycastCallback()
+		: btTriangleRaycastCallback(btVector3(0, 0, 0), btVector3(0, 0, 0)),
+		  m_resultCallback(0),
+		  m_collisionObject(0),
+		  m_colObjWorldTransform(0)
+	{
+	}
+
+	virtual btScalar reportHit(const btVector3& hitNormalLocal, btScalar hitFraction, int partId, int triangleIndex)
+	{
+		btCollisionWorld::LocalShapeInfo shapeInfo;
+		shapeInfo.m_shapePart = partId;
+		shapeInfo.m_triangleIndex = triangleIndex;
+
+		btVector3 hitNormalWorld = m_colObjWorldTransform->getBasis() * hitNormalLocal;
+
+		btCollisionWorld::LocalRayResult rayResult(m_collisionObject,
+												   &shapeInfo,
+												   hitNormalWorld,
+												   hitFraction);
+
+		bool normalInWorldSpace = true;
+		return m_resultCallback->addSingleResult(rayResult, normalInWorldSpace);
+	}
+};
+
+struct btRayPacketCallback : public btBroadphaseRayPacketCallback
+{
+	btSingleRayCallback m_singleRayCallbacks[BT_RAY_PACKET_SIZE];
+
+	btRayPacketCallback(const btVector3* rayFromWorld, const btVector3* rayToWorld, btCollisionWorld::RayResultCallback** resultCallbacks, int numRays, const btCollisionWorld* world)
+	{
+		for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+		{
+			if (i < numRays)
+			{
+				m_singleRayCallbacks[i].init(rayFromWorld[i], rayToWorld[i], world, *resultCallbacks[i]);
+			}
+			m_rayCallbacks[i] = &m_singleRayCallbacks[i];
+		}
+	}
+
+	virtual void processPacket(const btBroadphaseProxy* proxy, unsigned int rayMask)
+	{
+		btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
+		if (btRayPacket::isSingleRay(rayMask) || (collisionObject->getCollisionShape()->getShapeType() != TRIANGLE_MESH_SHAPE_PROXYTYPE))
+		{
+			btBroadphaseRayPacketCallback::processPacket(proxy, rayMask);
+			return;
+		}
+
+		///several rays overlap a btBvhTriangleMeshShape, cast them through its bvh as a packet
+		btBvhTriangleMeshShape* triangleMesh = (btBvhTriangleMeshShape*)collisionObject->getCollisionShape();
+		const btTransform& colObjWorldTransform = collisionObject->getWorldTransform();
+		btTransform worldTocollisionObject = colObjWorldTransform.inverse();
+
+		btPacketTriangleRaycastCallback triangleCallbacks[BT_RAY_PACKET_SIZE];
+		btTriangleCallback* triangleCallbackPtrs[BT_RAY_PACKET_SIZE];
+		btVector3 rayFromLocal[BT_RAY_PACKET_SIZE];
+		btVector3 rayToLocal[BT_RAY_PACKET_SIZE];
+		int numRays = 0;
+		for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+		{
+			if ((rayMask & (1u << i)) == 0)
+			{
+				continue;
+			}
+			const btSingleRayCallback& rayCB = m_singleRayCallbacks[i];
+			btCollisionWorld::RayResultCallback* resultCallback = rayCB.m_resultCallback;
+			//same early outs as btSingleRayCallback::process
+			if ((resultCallback->m_closestHitFraction == btScalar(0.f)) || !resultCallback->needsCollision(collisionObject->getBroadphaseHandle()))
+			{
+				continue;
+			}
+			rayFromLocal[numRays] = worldTocollisionObject * rayCB.m_rayFromWorld;
+			rayToLocal[numRays] = worldTocollisionObject * rayCB.m_rayToWorld;
+
+			btPacketTriangleRaycastCallback& rcb = triangleCallbacks[numRays];
+			rcb.m_from = rayFromLocal[numRays];
+			rcb.m_to = rayToLocal[numRays];
+			rcb.m_flags = resultCallback->m_flags;
+			rcb.m_hitFraction = resultCallback->m_closestHitFraction;
+			rcb.m_resultCallback = resultCallback;
+			rcb.m_collisionObject = collisionObject;
+			rcb.m_colObjWorldTransform = &colObjWorldTransform;
+			triangleCallbackPtrs[numRays] = &rcb;
+			numRays++;
+		}
+		if (numRays)
+		{
+			triangleMesh->performRaycastPacket(triangleCallbackPtrs, rayFromLocal, rayToLocal, numRays);
+		}
+	}
+};
+
+void btCollisionWorld::rayTestPacket(const btVector3* rayFromWorld, const btVector3* rayToWorld, RayResultCallback** resultCallbacks, int numRays) const
+{
+	//BT_PROFILE("rayTestPacket");
+	for (int first = 0; first < numRays; first += BT_RAY_PACKET_SIZE)
+	{
+		const int packetSize = btMin(numRays - first, int(BT_RAY_PACKET_SIZE));
+		btRayPacketCallback packetCB(&rayFromWorld[first], &rayToWorld[first], &resultCallbacks[first], packetSize, this);
+
+#ifndef USE_BRUTEFORCE_RAYBROADPHASE
+		m_broadphasePairCache->rayTestPacket(&rayFromWorld[first], &rayToWorld[first], packetSize, packetCB);
+#else
+		for (int i = 0; i < this->getNumCollisionObjects(); i++)
+		{
+			packetCB.processPacket(m_collisionObjects[i]->getBroadphaseHandle(), (1u << packetSize) - 1u);
+		}
+#endif  //USE_BRUTEFORCE_RAYBROADPHASE
+	}
+}
+
 struct btSingleSweepCallback : public btBroadphaseRayCallback
 {
 	btTransform m_convexFromTrans;
@@ -1132,6 +1273,158 @@ void btCollisionWorld::convexSweepTest(const btConvexShape* castShape, const btT
 #endif  //USE_BRUTEFORCE_RAYBROADPHASE
 }
 
+static void btBatchQueryFor(int numQueries, int grainSize, const btIParallelForBody& body)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler() && numQueries > grainSize)
+	{
+		btParallelFor(0, numQueries, grainSize, body);
+		return;
+	}
+#endif  //BT_THREADSAFE
+	body.forLoop(0, numQueries);
+}
+
+///ClosestRayResultCallback that can be stored in an array, the rays are set by btRayTestBatchLoop
+struct btBatchClosestRayResultCallback : public btCollisionWorld::ClosestRayResultCallback
+{
+	btBatchClosestRayResultCallback()
+		: btCollisionWorld::ClosestRayResultCallback(btVector3(0, 0, 0), btVector3(0, 0, 0))
+	{
+	}
+};
+
+struct btRayTestBatchLoop : public btIParallelForBody
+{
+	const btCollisionWorld* m_world;
+	const btVector3* m_rayFromWorld;
+	const btVector3* m_rayToWorld;
+	btCollisionWorld::BatchQueryResults* m_results;
+	int m_collisionFilterGroup;
+	int m_collisionFilterMask;
+	unsigned int m_flags;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		//consecutive rays are cast as packets, see btCollisionWorld::rayTestPacket
+		for (int first = iBegin; first < iEnd; first += BT_RAY_PACKET_SIZE)
+		{
+			const int packetSize = btMin(iEnd - first, int(BT_RAY_PACKET_SIZE));
+			btBatchClosestRayResultCallback rayCallbacks[BT_RAY_PACKET_SIZE];
+			btCollisionWorld::RayResultCallback* rayCallbackPtrs[BT_RAY_PACKET_SIZE];
+			for (int j = 0; j < packetSize; j++)
+			{
+				btCollisionWorld::ClosestRayResultCallback& rayCallback = rayCallbacks[j];
+				rayCallback.m_rayFromWorld = m_rayFromWorld[first + j];
+				rayCallback.m_rayToWorld = m_rayToWorld[first + j];
+				rayCallback.m_collisionFilterGroup = m_collisionFilterGroup;
+				rayCallback.m_collisionFilterMask = m_collisionFilterMask;
+				rayCallback.m_flags = m_flags;
+				rayCallbackPtrs[j] = &rayCallback;
+			}
+			m_world->rayTestPacket(&m_rayFromWorld[first], &m_rayToWorld[first], rayCallbackPtrs, packetSize);
+
+			for (int j = 0; j < packetSize; j++)
+			{
+				const int i = first + j;
+				const btCollisionWorld::ClosestRayResultCallback& rayCallback = rayCallbacks[j];
+				if (rayCallback.hasHit())
+				{
+					m_results->m_hitFractions[i] = rayCallback.m_closestHitFraction;
+					m_results->m_hitNormalWorld[i] = rayCallback.m_hitNormalWorld;
+					m_results->m_hitPointWorld[i] = rayCallback.m_hitPointWorld;
+					m_results->m_hitObjectIndices[i] = rayCallback.m_collisionObject->getWorldArrayIndex();
+				}
+				else
+				{
+					m_results->m_hitFractions[i] = btScalar(1.);
+					m_results->m_hitNormalWorld[i].setValue(0, 0, 0);
+					m_results->m_hitPointWorld[i] = m_rayToWorld[i];
+					m_results->m_hitObjectIndices[i] = -1;
+				}
+			}
+		}
+	}
+};
+
+void btCollisionWorld::rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, int numRays, BatchQueryResults& results,
+									int collisionFilterGroup, int collisionFilterMask, unsigned int flags, int grainSize) const
+{
+	BT_PROFILE("rayTestBatch");
+	results.resize(numRays);
+	if (numRays <= 0)
+	{
+		return;
+	}
+	btRayTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_rayFromWorld = rayFromWorld;
+	loop.m_rayToWorld = rayToWorld;
+	loop.m_results = &results;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	loop.m_collisionFilterMask = collisionFilterMask;
+	loop.m_flags = flags;
+	btBatchQueryFor(numRays, btMax(1, grainSize), loop);
+}
+
+struct btConvexSweepTestBatchLoop : public btIParallelForBody
+{
+	const btCollisionWorld* m_world;
+	const btConvexShape* m_castShape;
+	const btTransform* m_convexFromWorld;
+	const btTransform* m_convexToWorld;
+	btCollisionWorld::BatchQueryResults* m_results;
+	int m_collisionFilterGroup;
+	int m_collisionFilterMask;
+	btScalar m_allowedCcdPenetration;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btCollisionWorld::ClosestConvexResultCallback sweepCallback(m_convexFromWorld[i].getOrigin(), m_convexToWorld[i].getOrigin());
+			sweepCallback.m_collisionFilterGroup = m_collisionFilterGroup;
+			sweepCallback.m_collisionFilterMask = m_collisionFilterMask;
+			m_world->convexSweepTest(m_castShape, m_convexFromWorld[i], m_convexToWorld[i], sweepCallback, m_allowedCcdPenetration);
+			if (sweepCallback.hasHit() && sweepCallback.m_hitCollisionObject)
+			{
+				m_results->m_hitFractions[i] = sweepCallback.m_closestHitFraction;
+				m_results->m_hitNormalWorld[i] = sweepCallback.m_hitNormalWorld;
+				m_results->m_hitPointWorld[i] = sweepCallback.m_hitPointWorld;
+				m_results->m_hitObjectIndices[i] = sweepCallback.m_hitCollisionObject->getWorldArrayIndex();
+			}
+			else
+			{
+				m_results->m_hitFractions[i] = btScalar(1.);
+				m_results->m_hitNormalWorld[i].setValue(0, 0, 0);
+				m_results->m_hitPointWorld[i] = m_convexToWorld[i].getOrigin();
+				m_results->m_hitObjectIndices[i] = -1;
+			}
+		}
+	}
+};
+
+void btCollisionWorld::convexSweepTestBatch(const btConvexShape* castShape, const btTransform* convexFromWorld, const btTransform* convexToWorld, int numSweeps, BatchQueryResults& results,
+											int collisionFilterGroup, int collisionFilterMask, btScalar allowedCcdPenetration, int grainSize) const
+{
+	BT_PROFILE("convexSweepTestBatch");
+	results.resize(numSweeps);
+	if (numSweeps <= 0)
+	{
+		return;
+	}
+	btConvexSweepTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_castShape = castShape;
+	loop.m_convexFromWorld = convexFromWorld;
+	loop.m_convexToWorld = convexToWorld;
+	loop.m_results = &results;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	loop.m_collisionFilterMask = collisionFilterMask;
+	loop.m_allowedCcdPenetration = allowedCcdPenetration;
+	btBatchQueryFor(numSweeps, btMax(1, grainSize), loop);
+}
+
 struct btBridgedManifoldResult : public btManifoldResult
 {
 	btCollisionWorld::ContactResultCallback& m_resultCallback;
@@ -1548,7 +1841,7 @@ void btCollisionWorld::debugDrawWorld()
 
 						btVector3 minAabb2, maxAabb2;
 
-						if (getDispatchInfo().m_useContinuous && colObj->getInternalType() == btCollisionObject::CO_RIGID_BODY && !colObj->isStaticOrKinematicObject())
+						if ((getDispatchInfo().m_useContinuous || getDispatchInfo().m_useSpeculativeContacts) && colObj->getInternalType() == btCollisionObject::CO_RIGID_BODY && !colObj->isStaticOrKinematicObject())
 						{
 							colObj->getCollisionShape()->getAabb(colObj->getInterpolationWorldTransform(), minAabb2, maxAabb2);
 							minAabb2 -= contactThreshold;
@@ -424,6 +424,32 @@ public:
 		virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0, const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1) = 0;
 	};
 
+	///BatchQueryResults stores the closest hit of every query of rayTestBatch or convexSweepTestBatch.
+	///The results are flat arrays with one entry per query, in the order of the queries.
+	struct BatchQueryResults
+	{
+		btAlignedObjectArray<btScalar> m_hitFractions;  //1 if there was no hit
+		btAlignedObjectArray<btVector3> m_hitNormalWorld;
+		btAlignedObjectArray<btVector3> m_hitPointWorld;
+		btAlignedObjectArray<int> m_hitObjectIndices;  //btCollisionObject::getWorldArrayIndex of the hit object, -1 if there was no hit
+
+		void resize(int numQueries)
+		{
+			m_hitFractions.resizeNoInitialize(numQueries);
+			m_hitNormalWorld.resizeNoInitialize(numQueries);
+			m_hitPointWorld.resizeNoInitialize(numQueries);
+			m_hitObjectIndices.resizeNoInitialize(numQueries);
+		}
+		int size() const
+		{
+			return m_hitFractions.size();
+		}
+		bool hasHit(int queryIndex) const
+		{
+			return m_hitObjectIndices[queryIndex] >= 0;
+		}
+	};
+
 	int getNumCollisionObjects() const
 	{
 		return int(m_collisionObjects.size());
@@ -433,10 +459,29 @@ public:
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value returned by the callback.
 	virtual void rayTest(const btVector3& rayFromWorld, const btVector3& rayToWorld, RayResultCallback& resultCallback) const;
 
+	/// rayTestPacket performs rayTest for numRays rays, resultCallbacks[i] receives the hits of ray i.
+	/// The rays are cast in packets of BT_RAY_PACKET_SIZE: the broadphase and the bvh of btBvhTriangleMeshShape are traversed
+	/// once per packet (see btRayPacket), so coherent rays (camera/lidar style) are cheaper than with separate rayTest calls.
+	/// Worlds that override rayTest should override rayTestPacket as well.
+	virtual void rayTestPacket(const btVector3* rayFromWorld, const btVector3* rayToWorld, RayResultCallback** resultCallbacks, int numRays) const;
+
 	/// convexTest performs a swept convex cast on all objects in the btCollisionWorld, and calls the resultCallback
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value return by the callback.
 	void convexSweepTest(const btConvexShape* castShape, const btTransform& from, const btTransform& to, ConvexResultCallback& resultCallback, btScalar allowedCcdPenetration = btScalar(0.)) const;
 
+	/// rayTestBatch performs a closest-hit raycast for each of the numRays rays and writes the hits into results (resized to numRays).
+	/// The rays are distributed over the task scheduler using btParallelFor (in a BT_THREADSAFE build), grainSize rays per task,
+	/// and consecutive rays are cast together using rayTestPacket, so the rays should be ordered coherently (for example by scanline).
+	/// flags are the btTriangleRaycastCallback::EFlags used for triangle meshes, see RayResultCallback::m_flags.
+	void rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, int numRays, BatchQueryResults& results,
+					  int collisionFilterGroup = btBroadphaseProxy::DefaultFilter, int collisionFilterMask = btBroadphaseProxy::AllFilter,
+					  unsigned int flags = 0, int grainSize = 64) const;
+
+	/// convexSweepTestBatch performs a closest-hit convex sweep of castShape for each of the numSweeps from/to transforms, see rayTestBatch.
+	void convexSweepTestBatch(const btConvexShape* castShape, const btTransform* convexFromWorld, const btTransform* convexToWorld, int numSweeps, BatchQueryResults& results,
+							  int collisionFilterGroup = btBroadphaseProxy::DefaultFilter, int collisionFilterMask = btBroadphaseProxy::AllFilter,
+							  btScalar allowedCcdPenetration = btScalar(0.), int grainSize = 16) const;
+
 	///contactTest performs a discrete collision test between colObj against all objects in the btCollisionWorld, and calls the resultCallback.
 	///it reports one or more contact points for every overlapping object (including the one with deepest penetration)
 	void contactTest(btCollisionObject* colObj, ContactResultCallback& resultCallback);
@@ -36,6 +36,7 @@ btCompoundCollisionAlgorithm::btCompoundCollisionAlgorithm(const btCollisionAlgo
 	btAssert(colObjWrap->getCollisionShape()->isCompound());
 
 	const btCompoundShape* compoundShape = static_cast<const btCompoundShape*>(colObjWrap->getCollisionShape());
+	m_compoundShape = compoundShape;
 	m_compoundShapeRevision = compoundShape->getUpdateRevision();
 
 	preallocateChildAlgorithms(body0Wrap, body1Wrap);
@@ -52,8 +53,9 @@ void btCompoundCollisionAlgorithm::preallocateChildAlgorithms(const btCollisionO
 	int numChildren = compoundShape->getNumChildShapes();
 	int i;
 
+	int firstChild = m_childCollisionAlgorithms.size();
 	m_childCollisionAlgorithms.resize(numChildren);
-	for (i = 0; i < numChildren; i++)
+	for (i = firstChild; i < numChildren; i++)
 	{
 		if (compoundShape->getDynamicAabbTree())
 		{
@@ -84,6 +86,17 @@ void btCompoundCollisionAlgorithm::removeChildAlgorithms()
 			m_dispatcher->freeCollisionAlgorithm(m_childCollisionAlgorithms[i]);
 		}
 	}
+	m_childCollisionAlgorithms.resize(0);
+}
+
+bool btCompoundCollisionAlgorithm::hasOnlyAddedChildren(const btCompoundShape* compoundShape, const btCompoundShape* previousCompoundShape, int revision, int numChildren)
+{
+	if (compoundShape != previousCompoundShape)
+	{
+		return false;
+	}
+	//each addChildShape adds one child and one revision, the removals add a revision without adding a child
+	return compoundShape->getUpdateRevision() - revision == compoundShape->getNumChildShapes() - numChildren;
 }
 
 btCompoundCollisionAlgorithm::~btCompoundCollisionAlgorithm()
@@ -101,10 +114,14 @@ public:
 	btManifoldResult* m_resultOut;
 	btCollisionAlgorithm** m_childCollisionAlgorithms;
 	btPersistentManifold* m_sharedManifold;
+	btVector3 m_otherAabbMin;
+	btVector3 m_otherAabbMax;
 
 	btCompoundLeafCallback(const btCollisionObjectWrapper* compoundObjWrap, const btCollisionObjectWrapper* otherObjWrap, btDispatcher* dispatcher, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut, btCollisionAlgorithm** childCollisionAlgorithms, btPersistentManifold* sharedManifold)
 		: m_compoundColObjWrap(compoundObjWrap), m_otherObjWrap(otherObjWrap), m_dispatcher(dispatcher), m_dispatchInfo(dispatchInfo), m_resultOut(resultOut), m_childCollisionAlgorithms(childCollisionAlgorithms), m_sharedManifold(sharedManifold)
 	{
+		//the aabb of the other object is the same for all the children
+		m_otherObjWrap->getCollisionShape()->getAabb(m_otherObjWrap->getWorldTransform(), m_otherAabbMin, m_otherAabbMax);
 	}
 
 	void ProcessChildShape(const btCollisionShape* childShape, int index)
@@ -129,15 +146,12 @@ public:
 		btVector3 aabbMin0, aabbMax0;
 		childShape->getAabb(newChildWorldTrans, aabbMin0, aabbMax0);
 
-		btVector3 extendAabb(m_resultOut->m_closestPointDistanceThreshold, m_resultOut->m_closestPointDistanceThreshold, m_resultOut->m_closestPointDistanceThreshold);
+		const btScalar extend = m_resultOut->m_closestPointDistanceThreshold + m_resultOut->m_speculativeContactDistance;
+		btVector3 extendAabb(extend, extend, extend);
 		aabbMin0 -= extendAabb;
 		aabbMax0 += extendAabb;
 
-		btVector3 aabbMin1, aabbMax1;
-		m_otherObjWrap->getCollisionShape()->getAabb(m_otherObjWrap->getWorldTransform(), aabbMin1, aabbMax1);
-
-
-		if (TestAabbAgainstAabb2(aabbMin0, aabbMax0, aabbMin1, aabbMax1))
+		if (TestAabbAgainstAabb2(aabbMin0, aabbMax0, m_otherAabbMin, m_otherAabbMax))
 		{
 			btTransform preTransform = childTrans;
 			if (this->m_compoundColObjWrap->m_preTransform)
@@ -237,12 +251,16 @@ void btCompoundCollisionAlgorithm::processCollision(const btCollisionObjectWrapp
 
 	///btCompoundShape might have changed:
 	////make sure the internal child collision algorithm caches are still valid
-	if (compoundShape->getUpdateRevision() != m_compoundShapeRevision)
+	if ((compoundShape != m_compoundShape) || (compoundShape->getUpdateRevision() != m_compoundShapeRevision))
 	{
-		///clear and update all
-		removeChildAlgorithms();
+		///clear and update all, unless children were only added
+		if (!hasOnlyAddedChildren(compoundShape, m_compoundShape, m_compoundShapeRevision, m_childCollisionAlgorithms.size()))
+		{
+			removeChildAlgorithms();
+		}
 
 		preallocateChildAlgorithms(body0Wrap, body1Wrap);
+		m_compoundShape = compoundShape;
 		m_compoundShapeRevision = compoundShape->getUpdateRevision();
 	}
 
@@ -284,7 +302,8 @@ void btCompoundCollisionAlgorithm::processCollision(const btCollisionObjectWrapp
 		btTransform otherInCompoundSpace;
 		otherInCompoundSpace = colObjWrap->getWorldTransform().inverse() * otherObjWrap->getWorldTransform();
 		otherObjWrap->getCollisionShape()->getAabb(otherInCompoundSpace, localAabbMin, localAabbMax);
-		btVector3 extraExtends(resultOut->m_closestPointDistanceThreshold, resultOut->m_closestPointDistanceThreshold, resultOut->m_closestPointDistanceThreshold);
+		const btScalar extend = resultOut->m_closestPointDistanceThreshold + resultOut->m_speculativeContactDistance;
+		btVector3 extraExtends(extend, extend, extend);
 		localAabbMin -= extraExtends;
 		localAabbMax += extraExtends;
 
@@ -313,6 +332,11 @@ void btCompoundCollisionAlgorithm::processCollision(const btCollisionObjectWrapp
 
 		btTransform newChildWorldTrans;
 		btVector3 aabbMin0, aabbMax0, aabbMin1, aabbMax1;
+		otherObjWrap->getCollisionShape()->getAabb(otherObjWrap->getWorldTransform(), aabbMin1, aabbMax1);
+		//keep the algorithms of the children within the speculative contact distance
+		btVector3 speculativeExtends(resultOut->m_speculativeContactDistance, resultOut->m_speculativeContactDistance, resultOut->m_speculativeContactDistance);
+		aabbMin1 -= speculativeExtends;
+		aabbMax1 += speculativeExtends;
 
 		for (i = 0; i < numChildren; i++)
 		{
@@ -327,7 +351,6 @@ void btCompoundCollisionAlgorithm::processCollision(const btCollisionObjectWrapp
 
 				//perform an AABB check first
 				childShape->getAabb(newChildWorldTrans, aabbMin0, aabbMax0);
-				otherObjWrap->getCollisionShape()->getAabb(otherObjWrap->getWorldTransform(), aabbMin1, aabbMax1);
 
 				if (!TestAabbAgainstAabb2(aabbMin0, aabbMax0, aabbMin1, aabbMax1))
 				{
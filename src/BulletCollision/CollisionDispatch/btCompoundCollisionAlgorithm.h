@@ -29,6 +29,7 @@ class btDispatcher;
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
 class btDispatcher;
 class btCollisionObject;
+class btCompoundShape;
 
 class btCollisionShape;
 typedef bool (*btShapePairCallback)(const btCollisionShape* pShape0, const btCollisionShape* pShape1);
@@ -47,12 +48,18 @@ protected:
 	class btPersistentManifold* m_sharedManifold;
 	bool m_ownsManifold;
 
-	int m_compoundShapeRevision;  //to keep track of changes, so that childAlgorithm array can be updated
+	const btCompoundShape* m_compoundShape;  //the collision shape of the object can be replaced by another compound shape
+	int m_compoundShapeRevision;             //to keep track of changes, so that childAlgorithm array can be updated
 
 	void removeChildAlgorithms();
 
+	///creates the child algorithms of the children after the existing ones, keeping the existing child algorithms
 	void preallocateChildAlgorithms(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap);
 
+	///true when children were only added to the compound shape since the revision, so the indices of the existing
+	///children and their child algorithms remain valid. A different compound shape is never a continuation of the previous one.
+	static bool hasOnlyAddedChildren(const btCompoundShape* compoundShape, const btCompoundShape* previousCompoundShape, int revision, int numChildren);
+
 public:
 	btCompoundCollisionAlgorithm(const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped);
 
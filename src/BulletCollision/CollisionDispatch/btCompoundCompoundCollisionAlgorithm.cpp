@@ -42,10 +42,14 @@ btCompoundCompoundCollisionAlgorithm::btCompoundCompoundCollisionAlgorithm(const
 	btAssert(col1ObjWrap->getCollisionShape()->isCompound());
 
 	const btCompoundShape* compoundShape0 = static_cast<const btCompoundShape*>(col0ObjWrap->getCollisionShape());
+	m_compoundShape0 = compoundShape0;
 	m_compoundShapeRevision0 = compoundShape0->getUpdateRevision();
+	m_compoundShapeNumChildren0 = compoundShape0->getNumChildShapes();
 
 	const btCompoundShape* compoundShape1 = static_cast<const btCompoundShape*>(col1ObjWrap->getCollisionShape());
+	m_compoundShape1 = compoundShape1;
 	m_compoundShapeRevision1 = compoundShape1->getUpdateRevision();
+	m_compoundShapeNumChildren1 = compoundShape1->getNumChildShapes();
 }
 
 btCompoundCompoundCollisionAlgorithm::~btCompoundCompoundCollisionAlgorithm()
@@ -145,7 +149,8 @@ struct btCompoundCompoundLeafCallback : btDbvt::ICollide
 		childShape0->getAabb(newChildWorldTrans0, aabbMin0, aabbMax0);
 		childShape1->getAabb(newChildWorldTrans1, aabbMin1, aabbMax1);
 
-		btVector3 thresholdVec(m_resultOut->m_closestPointDistanceThreshold, m_resultOut->m_closestPointDistanceThreshold, m_resultOut->m_closestPointDistanceThreshold);
+		const btScalar threshold = m_resultOut->m_closestPointDistanceThreshold + m_resultOut->m_speculativeContactDistance;
+		btVector3 thresholdVec(threshold, threshold, threshold);
 
 		aabbMin0 -= thresholdVec;
 		aabbMax0 += thresholdVec;
@@ -212,11 +217,16 @@ struct btCompoundCompoundLeafCallback : btDbvt::ICollide
 	}
 };
 
+///absBasis is the absolute of the basis of xform, computed once for the traversal instead of in btTransformAabb at each node pair
 static DBVT_INLINE bool MyIntersect(const btDbvtAabbMm& a,
-									const btDbvtAabbMm& b, const btTransform& xform, btScalar distanceThreshold)
+									const btDbvtAabbMm& b, const btTransform& xform, const btMatrix3x3& absBasis, btScalar distanceThreshold)
 {
-	btVector3 newmin, newmax;
-	btTransformAabb(b.Mins(), b.Maxs(), 0.f, xform, newmin, newmax);
+	btVector3 localHalfExtents = btScalar(0.5) * (b.Maxs() - b.Mins());
+	btVector3 localCenter = btScalar(0.5) * (b.Maxs() + b.Mins());
+	btVector3 center = xform(localCenter);
+	btVector3 extent = localHalfExtents.dot3(absBasis[0], absBasis[1], absBasis[2]);
+	btVector3 newmin = center - extent;
+	btVector3 newmax = center + extent;
 	newmin -= btVector3(distanceThreshold, distanceThreshold, distanceThreshold);
 	newmax += btVector3(distanceThreshold, distanceThreshold, distanceThreshold);
 	btDbvtAabbMm newb = btDbvtAabbMm::FromMM(newmin, newmax);
@@ -239,11 +249,12 @@ static inline void MycollideTT(const btDbvtNode* root0,
 #else
 		stkStack.resize(btDbvt::DOUBLE_STACKSIZE);
 #endif
+		const btMatrix3x3 absBasis = xform.getBasis().absolute();
 		stkStack[0] = btDbvt::sStkNN(root0, root1);
 		do
 		{
 			btDbvt::sStkNN p = stkStack[--depth];
-			if (MyIntersect(p.a->volume, p.b->volume, xform, distanceThreshold))
+			if (MyIntersect(p.a->volume, p.b->volume, xform, absBasis, distanceThreshold))
 			{
 				if (depth > treshold)
 				{
@@ -300,12 +311,21 @@ void btCompoundCompoundCollisionAlgorithm::processCollision(const btCollisionObj
 	}
 	///btCompoundShape might have changed:
 	////make sure the internal child collision algorithm caches are still valid
-	if ((compoundShape0->getUpdateRevision() != m_compoundShapeRevision0) || (compoundShape1->getUpdateRevision() != m_compoundShapeRevision1))
+	if ((compoundShape0 != m_compoundShape0) || (compoundShape1 != m_compoundShape1) ||
+		(compoundShape0->getUpdateRevision() != m_compoundShapeRevision0) || (compoundShape1->getUpdateRevision() != m_compoundShapeRevision1))
 	{
-		///clear all
-		removeChildAlgorithms();
+		///clear all, unless children were only added, so the child indices of the cached pairs are still valid
+		if (!hasOnlyAddedChildren(compoundShape0, m_compoundShape0, m_compoundShapeRevision0, m_compoundShapeNumChildren0) ||
+			!hasOnlyAddedChildren(compoundShape1, m_compoundShape1, m_compoundShapeRevision1, m_compoundShapeNumChildren1))
+		{
+			removeChildAlgorithms();
+		}
+		m_compoundShape0 = compoundShape0;
+		m_compoundShape1 = compoundShape1;
 		m_compoundShapeRevision0 = compoundShape0->getUpdateRevision();
 		m_compoundShapeRevision1 = compoundShape1->getUpdateRevision();
+		m_compoundShapeNumChildren0 = compoundShape0->getNumChildShapes();
+		m_compoundShapeNumChildren1 = compoundShape1->getNumChildShapes();
 	}
 
 	///we need to refresh all contact manifolds
@@ -315,8 +335,8 @@ void btCompoundCompoundCollisionAlgorithm::processCollision(const btCollisionObj
 		int i;
 		btManifoldArray manifoldArray;
 #ifdef USE_LOCAL_STACK
-		btPersistentManifold localManifolds[4];
-		manifoldArray.initializeFromBuffer(&localManifolds, 0, 4);
+		btPersistentManifold* localManifolds[4];
+		manifoldArray.initializeFromBuffer(localManifolds, 0, 4);
 #endif
 		btSimplePairArray& pairs = m_childCollisionAlgorithmCache->getOverlappingPairArray();
 		for (i = 0; i < pairs.size(); i++)
@@ -342,7 +362,8 @@ void btCompoundCompoundCollisionAlgorithm::processCollision(const btCollisionObj
 	btCompoundCompoundLeafCallback callback(col0ObjWrap, col1ObjWrap, this->m_dispatcher, dispatchInfo, resultOut, this->m_childCollisionAlgorithmCache, m_sharedManifold);
 
 	const btTransform xform = col0ObjWrap->getWorldTransform().inverse() * col1ObjWrap->getWorldTransform();
-	MycollideTT(tree0->m_root, tree1->m_root, xform, &callback, resultOut->m_closestPointDistanceThreshold);
+	const btScalar distanceThreshold = resultOut->m_closestPointDistanceThreshold + resultOut->m_speculativeContactDistance;
+	MycollideTT(tree0->m_root, tree1->m_root, xform, &callback, distanceThreshold);
 
 	//printf("#compound-compound child/leaf overlap =%d                      \r",callback.m_numOverlapPairs);
 
@@ -374,7 +395,7 @@ void btCompoundCompoundCollisionAlgorithm::processCollision(const btCollisionObj
 					newChildWorldTrans0 = col0ObjWrap->getWorldTransform() * childTrans0;
 					childShape0->getAabb(newChildWorldTrans0, aabbMin0, aabbMax0);
 				}
-				btVector3 thresholdVec(resultOut->m_closestPointDistanceThreshold, resultOut->m_closestPointDistanceThreshold, resultOut->m_closestPointDistanceThreshold);
+				btVector3 thresholdVec(distanceThreshold, distanceThreshold, distanceThreshold);
 				aabbMin0 -= thresholdVec;
 				aabbMax0 += thresholdVec;
 				{
@@ -37,13 +37,18 @@ class btCollisionShape;
 extern btShapePairCallback gCompoundCompoundChildShapePairCallback;
 
 /// btCompoundCompoundCollisionAlgorithm  supports collision between two btCompoundCollisionShape shapes
+/// The child collision algorithms are cached by child pair across frames, and are kept when children are added to the compounds.
 class btCompoundCompoundCollisionAlgorithm : public btCompoundCollisionAlgorithm
 {
 	class btHashedSimplePairCache* m_childCollisionAlgorithmCache;
 	btSimplePairArray m_removePairs;
 
+	const btCompoundShape* m_compoundShape0;
+	const btCompoundShape* m_compoundShape1;
 	int m_compoundShapeRevision0;  //to keep track of changes, so that childAlgorithm array can be updated
 	int m_compoundShapeRevision1;
+	int m_compoundShapeNumChildren0;
+	int m_compoundShapeNumChildren1;
 
 	void removeChildAlgorithms();
 
@@ -50,124 +50,10 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
 #include "BulletCollision/NarrowPhaseCollision/btPolyhedralContactClipping.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/NarrowPhaseCollision/btCapsuleCapsuleDistance.h"
 
 ///////////
 
-static SIMD_FORCE_INLINE void segmentsClosestPoints(
-	btVector3& ptsVector,
-	btVector3& offsetA,
-	btVector3& offsetB,
-	btScalar& tA, btScalar& tB,
-	const btVector3& translation,
-	const btVector3& dirA, btScalar hlenA,
-	const btVector3& dirB, btScalar hlenB)
-{
-	// compute the parameters of the closest points on each line segment
-
-	btScalar dirA_dot_dirB = btDot(dirA, dirB);
-	btScalar dirA_dot_trans = btDot(dirA, translation);
-	btScalar dirB_dot_trans = btDot(dirB, translation);
-
-	btScalar denom = 1.0f - dirA_dot_dirB * dirA_dot_dirB;
-
-	if (denom == 0.0f)
-	{
-		tA = 0.0f;
-	}
-	else
-	{
-		tA = (dirA_dot_trans - dirB_dot_trans * dirA_dot_dirB) / denom;
-		if (tA < -hlenA)
-			tA = -hlenA;
-		else if (tA > hlenA)
-			tA = hlenA;
-	}
-
-	tB = tA * dirA_dot_dirB - dirB_dot_trans;
-
-	if (tB < -hlenB)
-	{
-		tB = -hlenB;
-		tA = tB * dirA_dot_dirB + dirA_dot_trans;
-
-		if (tA < -hlenA)
-			tA = -hlenA;
-		else if (tA > hlenA)
-			tA = hlenA;
-	}
-	else if (tB > hlenB)
-	{
-		tB = hlenB;
-		tA = tB * dirA_dot_dirB + dirA_dot_trans;
-
-		if (tA < -hlenA)
-			tA = -hlenA;
-		else if (tA > hlenA)
-			tA = hlenA;
-	}
-
-	// compute the closest points relative to segment centers.
-
-	offsetA = dirA * tA;
-	offsetB = dirB * tB;
-
-	ptsVector = translation - offsetA + offsetB;
-}
-
-static SIMD_FORCE_INLINE btScalar capsuleCapsuleDistance(
-	btVector3& normalOnB,
-	btVector3& pointOnB,
-	btScalar capsuleLengthA,
-	btScalar capsuleRadiusA,
-	btScalar capsuleLengthB,
-	btScalar capsuleRadiusB,
-	int capsuleAxisA,
-	int capsuleAxisB,
-	const btTransform& transformA,
-	const btTransform& transformB,
-	btScalar distanceThreshold)
-{
-	btVector3 directionA = transformA.getBasis().getColumn(capsuleAxisA);
-	btVector3 translationA = transformA.getOrigin();
-	btVector3 directionB = transformB.getBasis().getColumn(capsuleAxisB);
-	btVector3 translationB = transformB.getOrigin();
-
-	// translation between centers
-
-	btVector3 translation = translationB - translationA;
-
-	// compute the closest points of the capsule line segments
-
-	btVector3 ptsVector;  // the vector between the closest points
-
-	btVector3 offsetA, offsetB;  // offsets from segment centers to their closest points
-	btScalar tA, tB;             // parameters on line segment
-
-	segmentsClosestPoints(ptsVector, offsetA, offsetB, tA, tB, translation,
-						  directionA, capsuleLengthA, directionB, capsuleLengthB);
-
-	btScalar distance = ptsVector.length() - capsuleRadiusA - capsuleRadiusB;
-
-	if (distance > distanceThreshold)
-		return distance;
-
-	btScalar lenSqr = ptsVector.length2();
-	if (lenSqr <= (SIMD_EPSILON * SIMD_EPSILON))
-	{
-		//degenerate case where 2 capsules are likely at the same location: take a vector tangential to 'directionA'
-		btVector3 q;
-		btPlaneSpace1(directionA, normalOnB, q);
-	}
-	else
-	{
-		// compute the contact normal
-		normalOnB = ptsVector * -btRecipSqrt(lenSqr);
-	}
-	pointOnB = transformB.getOrigin() + offsetB + normalOnB * capsuleRadiusB;
-
-	return distance;
-}
-
 //////////
 
 btConvexConvexAlgorithm::CreateFunc::CreateFunc(btConvexPenetrationDepthSolver* pdSolver)
@@ -372,6 +258,7 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 		//TODO: if (dispatchInfo.m_useContinuous)
 		gjkPairDetector.setMinkowskiA(min0);
 		gjkPairDetector.setMinkowskiB(min1);
+		gjkPairDetector.setWarmStartCache(dispatchInfo.m_useGjkWarmStart ? &m_gjkWarmStartCache : 0);
 
 #ifdef USE_SEPDISTANCE_UTIL2
 		if (dispatchInfo.m_useConvexConservativeDistanceUtil)
@@ -467,6 +354,49 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 				}
 			};
 
+			///gathers the complete contact set of the pair before it goes to the manifold
+			struct btContactSetResult : public btDiscreteCollisionDetectorInterface::Result
+			{
+				enum
+				{
+					MAX_CONTACTS = MANIFOLD_CACHE_SIZE + 1  // the clipped contacts plus the GJK or edge-edge point
+				};
+				btVector3 m_normalsOnBInWorld[MAX_CONTACTS];
+				btVector3 m_pointsInWorld[MAX_CONTACTS];
+				btVector3 m_pointsOnAInWorld[MAX_CONTACTS];
+				btScalar m_depths[MAX_CONTACTS];
+				int m_numContacts;
+
+				btContactSetResult()
+					: m_numContacts(0)
+				{
+				}
+
+				virtual void setShapeIdentifiersA(int partId0, int index0) {}
+				virtual void setShapeIdentifiersB(int partId1, int index1) {}
+				virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+				{
+					if (m_numContacts < MAX_CONTACTS)
+					{
+						m_normalsOnBInWorld[m_numContacts] = normalOnBInWorld;
+						m_pointsInWorld[m_numContacts] = pointInWorld;
+						m_pointsOnAInWorld[m_numContacts] = pointInWorld + normalOnBInWorld * depth;
+						m_depths[m_numContacts] = depth;
+						m_numContacts++;
+					}
+				}
+
+				void replaceManifoldContacts(btManifoldResult* resultOut)
+				{
+					btPersistentManifold* manifold = resultOut->getPersistentManifold();
+					manifold->removeStaleContactPoints(manifold->getBody0()->getWorldTransform(), m_pointsOnAInWorld, m_numContacts);
+					for (int i = 0; i < m_numContacts; i++)
+					{
+						resultOut->addContactPoint(m_normalsOnBInWorld[i], m_pointsInWorld[i], m_depths[i]);
+					}
+				}
+			};
+
 			btDummyResult dummy;
 
 			///btBoxShape is an exception: its vertices are created WITH margin so don't subtract it
@@ -474,12 +404,16 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 			btScalar min0Margin = min0->getShapeType() == BOX_SHAPE_PROXYTYPE ? 0.f : min0->getMargin();
 			btScalar min1Margin = min1->getShapeType() == BOX_SHAPE_PROXYTYPE ? 0.f : min1->getMargin();
 
-			btWithoutMarginResult withoutMargin(resultOut, min0Margin, min1Margin);
-
 			btPolyhedralConvexShape* polyhedronA = (btPolyhedralConvexShape*)min0;
 			btPolyhedralConvexShape* polyhedronB = (btPolyhedralConvexShape*)min1;
 			if (polyhedronA->getConvexPolyhedron() && polyhedronB->getConvexPolyhedron())
 			{
+				//the contacts of a manifold owned by this pair are replaced as a whole: the clipping computes the complete,
+				//reduced contact set every frame. Shared manifolds (compounds, meshes) receive the contacts directly.
+				btContactSetResult contactSet;
+				btDiscreteCollisionDetectorInterface::Result* contactsOut = m_ownManifold ? (btDiscreteCollisionDetectorInterface::Result*)&contactSet : resultOut;
+				btWithoutMarginResult withoutMargin(contactsOut, min0Margin, min1Margin);
+
 				btScalar threshold = m_manifoldPtr->getContactBreakingThreshold()+ resultOut->m_closestPointDistanceThreshold;
 
 				btScalar minDist = -1e30f;
@@ -492,13 +426,13 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 						*polyhedronA->getConvexPolyhedron(), *polyhedronB->getConvexPolyhedron(),
 						body0Wrap->getWorldTransform(),
 						body1Wrap->getWorldTransform(),
-						sepNormalWorldSpace, *resultOut);
+						sepNormalWorldSpace, *contactsOut, &m_satCache);
 				}
 				else
 				{
 #ifdef ZERO_MARGIN
 					gjkPairDetector.setIgnoreMargin(true);
-					gjkPairDetector.getClosestPoints(input, *resultOut, dispatchInfo.m_debugDraw);
+					gjkPairDetector.getClosestPoints(input, *contactsOut, dispatchInfo.m_debugDraw);
 #else
 
 					gjkPairDetector.getClosestPoints(input, withoutMargin, dispatchInfo.m_debugDraw);
@@ -526,10 +460,11 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 					btPolyhedralContactClipping::clipHullAgainstHull(sepNormalWorldSpace, *polyhedronA->getConvexPolyhedron(), *polyhedronB->getConvexPolyhedron(),
 																	 body0Wrap->getWorldTransform(),
 																	 body1Wrap->getWorldTransform(), minDist - threshold, threshold, worldVertsB1, worldVertsB2,
-																	 *resultOut);
+																	 *contactsOut, MANIFOLD_CACHE_SIZE);
 				}
 				if (m_ownManifold)
 				{
+					contactSet.replaceManifoldContacts(resultOut);
 					resultOut->refreshContactPoints();
 				}
 				return;
@@ -683,7 +618,7 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 					{
 						worldVertsB2.resize(0);
 						btPolyhedralContactClipping::clipFaceAgainstHull(sepNormalWorldSpace, *polyhedronA->getConvexPolyhedron(),
-																		 body0Wrap->getWorldTransform(), worldSpaceVertices, worldVertsB2, minDist - threshold, maxDist, *resultOut);
+																		 body0Wrap->getWorldTransform(), worldSpaceVertices, worldVertsB2, minDist - threshold, maxDist, *resultOut, MANIFOLD_CACHE_SIZE);
 					}
 
 					if (m_ownManifold)
@@ -732,6 +667,9 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 				if (perturbeAngle > angleLimit)
 					perturbeAngle = angleLimit;
 
+				//the perturbed queries should not overwrite the state of the unperturbed pair
+				gjkPairDetector.setWarmStartCache(0);
+
 				btTransform unPerturbedTransform;
 				if (perturbeA)
 				{
@@ -793,6 +731,11 @@ btScalar btConvexConvexAlgorithm::calculateTimeOfImpact(btCollisionObject* col0,
 {
 	(void)resultOut;
 	(void)dispatchInfo;
+	return calculateSweptSphereTimeOfImpact(col0, col1);
+}
+
+btScalar btConvexConvexAlgorithm::calculateSweptSphereTimeOfImpact(btCollisionObject* col0, btCollisionObject* col1)
+{
 	///Rather then checking ALL pairs, only calculate TOI when motion exceeds threshold
 
 	///Linear motion for one of objects needs to exceed m_ccdSquareMotionThreshold
@@ -55,7 +55,11 @@ class btConvexConvexAlgorithm : public btActivatingCollisionAlgorithm
 	int m_numPerturbationIterations;
 	int m_minimumPointsPerturbationThreshold;
 
-	///cache separating vector to speedup collision detection
+	///cache separating vector, simplex and penetration normal to speedup collision detection in the next frame
+	btGjkWarmStartCache m_gjkWarmStartCache;
+
+	///feature of the last separating axis test between the polyhedral hulls, tested first in the next frame
+	btSeparatingAxisCache m_satCache;
 
 public:
 	btConvexConvexAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btConvexPenetrationDepthSolver* pdSolver, int numPerturbationIterations, int minimumPointsPerturbationThreshold);
@@ -66,6 +70,9 @@ public:
 
 	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
 
+	///conservative time of impact, each object against the swept sphere of the other, only when the motion exceeds the ccd threshold
+	static btScalar calculateSweptSphereTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1);
+
 	virtual void getAllContactManifolds(btManifoldArray& manifoldArray)
 	{
 		///should we use m_ownManifold to avoid adding duplicates?
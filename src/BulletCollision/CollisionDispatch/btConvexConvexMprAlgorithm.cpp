@@ -0,0 +1,143 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btConvexConvexMprAlgorithm.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/NarrowPhaseCollision/btConvexTemplateShapes.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpa3.h"
+#include "BulletCollision/NarrowPhaseCollision/btMprPenetration.h"
+
+btConvexConvexMprAlgorithm::CreateFunc::CreateFunc()
+{
+}
+
+btConvexConvexMprAlgorithm::CreateFunc::~CreateFunc()
+{
+}
+
+btConvexConvexMprAlgorithm::btConvexConvexMprAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+	: btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap),
+	  m_ownManifold(false),
+	  m_manifoldPtr(mf),
+	  m_cachedSeparatingAxis(btScalar(0.), btScalar(1.), btScalar(0.))
+{
+}
+
+btConvexConvexMprAlgorithm::~btConvexConvexMprAlgorithm()
+{
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr)
+			m_dispatcher->releaseManifold(m_manifoldPtr);
+	}
+}
+
+//GJK between the cores of the shapes, MPR once the cores overlap
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+static void btMprCollide(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btScalar maxDistance, btVector3& cachedSeparatingAxis, btManifoldResult* resultOut)
+{
+	const btConvexTemplateA a(body0Wrap->getCollisionShape(), body0Wrap->getWorldTransform());
+	const btConvexTemplateB b(body1Wrap->getCollisionShape(), body1Wrap->getWorldTransform());
+
+	btMprDistanceInfo distInfo;
+	btGjkCollisionDescription gjkDesc;
+	gjkDesc.m_firstDir = cachedSeparatingAxis;
+	if (btComputeGjkDistance(btConvexTemplateCore<btConvexTemplateA>(a), btConvexTemplateCore<btConvexTemplateB>(b), gjkDesc, &distInfo) == 0)
+	{
+		//the GJK normal is in the local space of A, the witness points are in world space
+		cachedSeparatingAxis = distInfo.m_normalBtoA;
+		const btScalar distance = distInfo.m_distance - a.getMargin() - b.getMargin();
+		if (distance > maxDistance)
+		{
+			return;
+		}
+		btVector3 normalOnB = distInfo.m_pointOnA - distInfo.m_pointOnB;
+		const btScalar len2 = normalOnB.length2();
+		if (len2 > SIMD_EPSILON * SIMD_EPSILON)
+		{
+			normalOnB /= btSqrt(len2);
+		}
+		else
+		{
+			normalOnB = a.getWorldTransform().getBasis() * distInfo.m_normalBtoA;
+		}
+		resultOut->addContactPoint(normalOnB, distInfo.m_pointOnB + normalOnB * b.getMargin(), distance);
+		return;
+	}
+
+	btMprCollisionDescription mprDesc;
+	if (btComputeMprPenetration(a, b, mprDesc, &distInfo) == 0)
+	{
+		cachedSeparatingAxis = distInfo.m_normalBtoA * a.getWorldTransform().getBasis();
+		resultOut->addContactPoint(distInfo.m_normalBtoA, distInfo.m_pointOnB, distInfo.m_distance);
+	}
+}
+
+typedef void (*btMprCollideFunc)(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btScalar maxDistance, btVector3& cachedSeparatingAxis, btManifoldResult* resultOut);
+
+#define BT_MPR_COLLIDE_ROW(TypeA)                                                                     \
+	{                                                                                                 \
+		&btMprCollide<TypeA, btConvexTemplateSphere>, &btMprCollide<TypeA, btConvexTemplateCapsule>, \
+			&btMprCollide<TypeA, btConvexTemplateBox>, &btMprCollide<TypeA, btConvexTemplateHull>,   \
+			&btMprCollide<TypeA, btConvexTemplateShape>                                               \
+	}
+
+static const btMprCollideFunc gMprCollideFuncs[BT_CONVEX_TEMPLATE_NUM_TYPES][BT_CONVEX_TEMPLATE_NUM_TYPES] = {
+	BT_MPR_COLLIDE_ROW(btConvexTemplateSphere),
+	BT_MPR_COLLIDE_ROW(btConvexTemplateCapsule),
+	BT_MPR_COLLIDE_ROW(btConvexTemplateBox),
+	BT_MPR_COLLIDE_ROW(btConvexTemplateHull),
+	BT_MPR_COLLIDE_ROW(btConvexTemplateShape)};
+
+#undef BT_MPR_COLLIDE_ROW
+
+//
+// Convex-Convex collision algorithm
+//
+void btConvexConvexMprAlgorithm ::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)dispatchInfo;
+	if (!m_manifoldPtr)
+	{
+		//swapped?
+		m_manifoldPtr = m_dispatcher->getNewManifold(body0Wrap->getCollisionObject(), body1Wrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	const btScalar maxDistance = m_manifoldPtr->getContactBreakingThreshold() + resultOut->m_closestPointDistanceThreshold;
+	const int typeA = btGetConvexTemplateType(body0Wrap->getCollisionShape()->getShapeType());
+	const int typeB = btGetConvexTemplateType(body1Wrap->getCollisionShape()->getShapeType());
+	gMprCollideFuncs[typeA][typeB](body0Wrap, body1Wrap, maxDistance, m_cachedSeparatingAxis, resultOut);
+
+	if (m_ownManifold)
+	{
+		resultOut->refreshContactPoints();
+	}
+}
+
+btScalar btConvexConvexMprAlgorithm::calculateTimeOfImpact(btCollisionObject* col0, btCollisionObject* col1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)col0;
+	(void)col1;
+	(void)dispatchInfo;
+	(void)resultOut;
+
+	//not yet
+	return btScalar(1.);
+}
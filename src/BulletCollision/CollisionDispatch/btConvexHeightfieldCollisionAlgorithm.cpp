@@ -0,0 +1,463 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btConvexHeightfieldCollisionAlgorithm.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletCollision/NarrowPhaseCollision/btConvexTemplateShapes.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpa3.h"
+#include "BulletCollision/NarrowPhaseCollision/btMprPenetration.h"
+#include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
+#include "LinearMath/btAabbUtil2.h"
+#include "LinearMath/btQuickprof.h"
+
+///an edge between two triangles is active when it is convex and the angle between the triangle normals is above ~5 degrees
+#define BT_HEIGHTFIELD_ACTIVE_EDGE_COS_ANGLE btScalar(0.996)
+
+btConvexHeightfieldCollisionAlgorithm::btConvexHeightfieldCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped)
+	: btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap),
+	  m_ownManifold(false),
+	  m_manifoldPtr(mf),
+	  m_isSwapped(isSwapped)
+{
+	const btCollisionObjectWrapper* convexObjWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* heightfieldObjWrap = m_isSwapped ? body0Wrap : body1Wrap;
+
+	if (!m_manifoldPtr && m_dispatcher->needsCollision(convexObjWrap->getCollisionObject(), heightfieldObjWrap->getCollisionObject()))
+	{
+		m_manifoldPtr = m_dispatcher->getNewManifold(convexObjWrap->getCollisionObject(), heightfieldObjWrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+}
+
+btConvexHeightfieldCollisionAlgorithm::~btConvexHeightfieldCollisionAlgorithm()
+{
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr)
+			m_dispatcher->releaseManifold(m_manifoldPtr);
+	}
+}
+
+///a triangle in the local space of the heightfield, presented to the templated GJK and MPR like a btConvexTemplate
+struct btHeightfieldTriangleTemplate
+{
+	btVector3 m_vertices[3];
+	btVector3 m_center;
+	btTransform m_worldTrans;
+	btScalar m_margin;
+
+	SIMD_FORCE_INLINE btScalar getMargin() const
+	{
+		return m_margin;
+	}
+	SIMD_FORCE_INLINE btVector3 getObjectCenterInWorld() const
+	{
+		return m_center;
+	}
+	SIMD_FORCE_INLINE const btTransform& getWorldTransform() const
+	{
+		return m_worldTrans;
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		const btScalar dot0 = dir.dot(m_vertices[0]);
+		const btScalar dot1 = dir.dot(m_vertices[1]);
+		const btScalar dot2 = dir.dot(m_vertices[2]);
+		if (dot0 >= dot1)
+		{
+			return dot0 >= dot2 ? m_vertices[0] : m_vertices[2];
+		}
+		return dot1 >= dot2 ? m_vertices[1] : m_vertices[2];
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		const btScalar len2 = dir.length2();
+		if (len2 < SIMD_EPSILON * SIMD_EPSILON)
+		{
+			return getLocalSupportWithoutMargin(dir);
+		}
+		return getLocalSupportWithoutMargin(dir) + dir * (m_margin / btSqrt(len2));
+	}
+};
+
+///the outward normal of a heightfield triangle, 0 for a degenerate triangle
+static bool btHeightfieldTriangleNormal(const btVector3* vertices, int upAxis, btScalar upSign, btVector3& normal)
+{
+	normal = (vertices[1] - vertices[0]).cross(vertices[2] - vertices[0]);
+	const btScalar len2 = normal.length2();
+	if (len2 < SIMD_EPSILON * SIMD_EPSILON)
+	{
+		return false;
+	}
+	normal /= btSqrt(len2);
+	if (normal[upAxis] * upSign < btScalar(0.))
+	{
+		normal = -normal;
+	}
+	return true;
+}
+
+///computes the contacts between a convex shape and the triangles of the grid cells, in the local space of the heightfield
+template <typename btConvexTemplate>
+struct btHeightfieldCellCollider
+{
+	const btHeightfieldTerrainShape* m_heightfield;
+	const btConvexTemplate& m_convex;
+	btHeightfieldTriangleTemplate m_triangle;
+	btVector3 m_aabbMin;
+	btVector3 m_aabbMax;
+	btScalar m_maxDistance;
+	int m_upAxis;
+	btScalar m_upSign;
+	btTransform m_heightfieldTrans;
+	btManifoldResult* m_resultOut;
+	bool m_heightfieldIsBody0;
+
+	btHeightfieldCellCollider(const btHeightfieldTerrainShape* heightfield, const btConvexTemplate& convex)
+		: m_heightfield(heightfield),
+		  m_convex(convex)
+	{
+	}
+
+	void operator()(int x, int z)
+	{
+		btVector3 triangles[2][3];
+		m_heightfield->getCellTriangles(x, z, triangles);
+		collideTriangle(triangles[0], x, z, 2 * x);
+		collideTriangle(triangles[1], x, z, 2 * x + 1);
+	}
+
+	void collideTriangle(const btVector3* vertices, int x, int z, int triangleIndex)
+	{
+		if (!TestTriangleAgainstAabb2(vertices, m_aabbMin, m_aabbMax))
+		{
+			return;
+		}
+		btVector3 normal;
+		if (!btHeightfieldTriangleNormal(vertices, m_upAxis, m_upSign, normal))
+		{
+			return;
+		}
+
+		//skip the triangle when the convex shape is entirely above its plane
+		const btTransform& convexTrans = m_convex.getWorldTransform();
+		const btScalar planeConstant = normal.dot(vertices[0]) + m_triangle.getMargin();
+		const btVector3 deepest = convexTrans(m_convex.getLocalSupportWithMargin(-normal * convexTrans.getBasis()));
+		if (normal.dot(deepest) - planeConstant > m_maxDistance)
+		{
+			return;
+		}
+
+		m_triangle.m_vertices[0] = vertices[0];
+		m_triangle.m_vertices[1] = vertices[1];
+		m_triangle.m_vertices[2] = vertices[2];
+		m_triangle.m_center = (vertices[0] + vertices[1] + vertices[2]) * btScalar(1. / 3.);
+
+		//GJK between the core of the convex shape and the triangle, MPR once they overlap
+		btVector3 normalOnB;
+		btVector3 pointOnA;
+		btScalar distance;
+		//the point on the core of the convex shape, with the margin still to apply
+		btVector3 pointOnCore;
+		btScalar coreMargin = btScalar(0.);
+		btMprDistanceInfo distInfo;
+		btGjkCollisionDescription gjkDesc;
+		gjkDesc.m_firstDir = normal * convexTrans.getBasis();
+		if (btComputeGjkDistance(btConvexTemplateCore<btConvexTemplate>(m_convex), btConvexTemplateCore<btHeightfieldTriangleTemplate>(m_triangle), gjkDesc, &distInfo) == 0)
+		{
+			distance = distInfo.m_distance - m_convex.getMargin() - m_triangle.getMargin();
+			if (distance > m_maxDistance)
+			{
+				return;
+			}
+			normalOnB = distInfo.m_pointOnA - distInfo.m_pointOnB;
+			const btScalar len2 = normalOnB.length2();
+			if (len2 > SIMD_EPSILON * SIMD_EPSILON)
+			{
+				normalOnB /= btSqrt(len2);
+			}
+			else
+			{
+				normalOnB = normal;
+			}
+			pointOnA = distInfo.m_pointOnA - normalOnB * m_convex.getMargin();
+			pointOnCore = distInfo.m_pointOnA;
+			coreMargin = m_convex.getMargin();
+		}
+		else
+		{
+			btMprCollisionDescription mprDesc;
+			if (btComputeMprPenetration(m_convex, m_triangle, mprDesc, &distInfo) == 0)
+			{
+				normalOnB = distInfo.m_normalBtoA;
+				pointOnA = distInfo.m_pointOnA;
+				distance = distInfo.m_distance;
+				pointOnCore = pointOnA;
+			}
+			else
+			{
+				normalOnB = normal;
+				pointOnA = deepest;
+				distance = normal.dot(deepest) - planeConstant;
+				pointOnCore = pointOnA;
+			}
+		}
+
+		//at the flat and concave edges, and below the triangle, the normal of the triangle is the only valid normal.
+		//The depth along it is the one of the deepest point of the convex shape, or of the core point with the margin
+		//along the normal, as long as that point is above the triangle.
+		if (!isValidNormal(normalOnB, normal, vertices, x, z, triangleIndex))
+		{
+			normalOnB = normal;
+			const btVector3 pointBelowCore = pointOnCore - normal * coreMargin;
+			if (isAboveTriangle(deepest, normal, vertices))
+			{
+				pointOnA = deepest;
+			}
+			else if (isAboveTriangle(pointBelowCore, normal, vertices))
+			{
+				pointOnA = pointBelowCore;
+			}
+			distance = normal.dot(pointOnA) - planeConstant;
+			if (distance > m_maxDistance)
+			{
+				return;
+			}
+		}
+
+		const btVector3 pointOnB = pointOnA - normalOnB * distance;
+		if (m_heightfieldIsBody0)
+		{
+			m_resultOut->setShapeIdentifiersA(triangleIndex, z);
+		}
+		else
+		{
+			m_resultOut->setShapeIdentifiersB(triangleIndex, z);
+		}
+		m_resultOut->addContactPoint(m_heightfieldTrans.getBasis() * normalOnB, m_heightfieldTrans * pointOnB, distance);
+	}
+
+	///true if the projection of the point along the normal is inside the triangle
+	static bool isAboveTriangle(const btVector3& point, const btVector3& normal, const btVector3* vertices)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			const btVector3& a = vertices[i];
+			const btVector3& b = vertices[(i + 1) % 3];
+			const btVector3& c = vertices[(i + 2) % 3];
+			const btVector3 edgeNormal = (b - a).cross(normal);
+			if (edgeNormal.dot(point - a) * edgeNormal.dot(c - a) < btScalar(0.))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	///the normal is valid if it is the triangle normal, or if it points towards an active edge
+	bool isValidNormal(const btVector3& normalOnB, const btVector3& normal, const btVector3* vertices, int x, int z, int triangleIndex) const
+	{
+		const btScalar cosAngle = normalOnB.dot(normal);
+		if (cosAngle > btScalar(0.9999))
+		{
+			return true;
+		}
+		const btVector3 tangent = normalOnB - normal * cosAngle;
+		if (tangent.length2() < SIMD_EPSILON)
+		{
+			return false;
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			const btVector3& a = vertices[i];
+			const btVector3& b = vertices[(i + 1) % 3];
+			const btVector3& c = vertices[(i + 2) % 3];
+			btVector3 outward = (b - a).cross(normal);
+			if (outward.dot(c - a) > btScalar(0.))
+			{
+				outward = -outward;
+			}
+			if (outward.dot(tangent) > btScalar(0.) && isActiveEdge(a, b, normal, x, z, triangleIndex))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool isActiveEdge(const btVector3& a, const btVector3& b, const btVector3& normal, int x, int z, int triangleIndex) const
+	{
+		//the triangle on the other side of the edge is in the same cell or in one of the 4 neighbor cells
+		static const int neighborCells[5][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+		const int numCellsX = m_heightfield->getHeightStickWidth() - 1;
+		const int numCellsZ = m_heightfield->getHeightStickLength() - 1;
+		for (int n = 0; n < 5; n++)
+		{
+			const int nx = x + neighborCells[n][0];
+			const int nz = z + neighborCells[n][1];
+			if (nx < 0 || nz < 0 || nx >= numCellsX || nz >= numCellsZ)
+			{
+				continue;
+			}
+			btVector3 triangles[2][3];
+			m_heightfield->getCellTriangles(nx, nz, triangles);
+			for (int t = 0; t < 2; t++)
+			{
+				if (nx == x && nz == z && 2 * x + t == triangleIndex)
+				{
+					continue;
+				}
+				const btVector3* neighbor = triangles[t];
+				for (int i = 0; i < 3; i++)
+				{
+					const btVector3& c = neighbor[(i + 2) % 3];
+					const btVector3& v0 = neighbor[i];
+					const btVector3& v1 = neighbor[(i + 1) % 3];
+					if ((v0 == a && v1 == b) || (v0 == b && v1 == a))
+					{
+						btVector3 neighborNormal;
+						if (!btHeightfieldTriangleNormal(neighbor, m_upAxis, m_upSign, neighborNormal))
+						{
+							return true;
+						}
+						//convex, and not almost flat
+						return normal.dot(c - a) < btScalar(0.) && normal.dot(neighborNormal) < BT_HEIGHTFIELD_ACTIVE_EDGE_COS_ANGLE;
+					}
+				}
+			}
+		}
+		//border of the heightfield
+		return true;
+	}
+
+private:
+	btHeightfieldCellCollider& operator=(const btHeightfieldCellCollider&);
+};
+
+template <typename btConvexTemplate>
+static void btCollideConvexHeightfield(const btCollisionObjectWrapper* convexWrap, const btCollisionObjectWrapper* heightfieldWrap, btScalar maxDistance, btManifoldResult* resultOut)
+{
+	const btHeightfieldTerrainShape* heightfield = static_cast<const btHeightfieldTerrainShape*>(heightfieldWrap->getCollisionShape());
+	const btTransform& heightfieldTrans = heightfieldWrap->getWorldTransform();
+	const btTransform convexInHeightfield = heightfieldTrans.inverseTimes(convexWrap->getWorldTransform());
+	const btConvexTemplate convex(convexWrap->getCollisionShape(), convexInHeightfield);
+
+	btHeightfieldCellCollider<btConvexTemplate> collider(heightfield, convex);
+	collider.m_triangle.m_worldTrans.setIdentity();
+	collider.m_triangle.m_margin = heightfield->getMargin();
+	collider.m_maxDistance = maxDistance;
+	collider.m_upAxis = heightfield->getUpAxis();
+	collider.m_upSign = heightfield->getLocalScaling()[collider.m_upAxis] < btScalar(0.) ? btScalar(-1.) : btScalar(1.);
+	collider.m_heightfieldTrans = heightfieldTrans;
+	collider.m_resultOut = resultOut;
+	collider.m_heightfieldIsBody0 = resultOut->getBody0Internal() == heightfieldWrap->getCollisionObject();
+
+	convexWrap->getCollisionShape()->getAabb(convexInHeightfield, collider.m_aabbMin, collider.m_aabbMax);
+	const btScalar extraMargin = heightfield->getMargin() + maxDistance;
+	const btVector3 extra(extraMargin, extraMargin, extraMargin);
+	collider.m_aabbMin -= extra;
+	collider.m_aabbMax += extra;
+
+	heightfield->processAllCells(collider, collider.m_aabbMin, collider.m_aabbMax);
+}
+
+typedef void (*btHeightfieldCollideFunc)(const btCollisionObjectWrapper* convexWrap, const btCollisionObjectWrapper* heightfieldWrap, btScalar maxDistance, btManifoldResult* resultOut);
+
+static const btHeightfieldCollideFunc gHeightfieldCollideFuncs[BT_CONVEX_TEMPLATE_NUM_TYPES] = {
+	&btCollideConvexHeightfield<btConvexTemplateSphere>,
+	&btCollideConvexHeightfield<btConvexTemplateCapsule>,
+	&btCollideConvexHeightfield<btConvexTemplateBox>,
+	&btCollideConvexHeightfield<btConvexTemplateHull>,
+	&btCollideConvexHeightfield<btConvexTemplateShape>};
+
+void btConvexHeightfieldCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	BT_PROFILE("btConvexHeightfieldCollisionAlgorithm::processCollision");
+	(void)dispatchInfo;
+	if (!m_manifoldPtr)
+		return;
+
+	const btCollisionObjectWrapper* convexObjWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* heightfieldObjWrap = m_isSwapped ? body0Wrap : body1Wrap;
+
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	const btScalar maxDistance = m_manifoldPtr->getContactBreakingThreshold() + resultOut->m_closestPointDistanceThreshold;
+	const int convexType = btGetConvexTemplateType(convexObjWrap->getCollisionShape()->getShapeType());
+	gHeightfieldCollideFuncs[convexType](convexObjWrap, heightfieldObjWrap, maxDistance, resultOut);
+
+	if (m_ownManifold)
+	{
+		resultOut->refreshContactPoints();
+	}
+}
+
+///keeps the closest hit of the swept sphere of continuous collision detection
+struct btHeightfieldCcdCallback : public btTriangleConvexcastCallback
+{
+	btHeightfieldCcdCallback(const btConvexShape* ccdSphere, const btTransform& from, const btTransform& to, const btTransform& heightfieldTrans, btScalar margin)
+		: btTriangleConvexcastCallback(ccdSphere, from, to, heightfieldTrans, margin)
+	{
+	}
+
+	virtual btScalar reportHit(const btVector3& hitNormalLocal, const btVector3& hitPointLocal, btScalar hitFraction, int partId, int triangleIndex)
+	{
+		(void)hitNormalLocal;
+		(void)hitPointLocal;
+		(void)partId;
+		(void)triangleIndex;
+		m_hitFraction = hitFraction;
+		return hitFraction;
+	}
+};
+
+btScalar btConvexHeightfieldCollisionAlgorithm::calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)resultOut;
+	(void)dispatchInfo;
+	btCollisionObject* convexBody = m_isSwapped ? body1 : body0;
+	btCollisionObject* heightfieldBody = m_isSwapped ? body0 : body1;
+
+	//only perform CCD above a certain threshold, like btConvexConcaveCollisionAlgorithm
+	btScalar squareMot0 = (convexBody->getInterpolationWorldTransform().getOrigin() - convexBody->getWorldTransform().getOrigin()).length2();
+	if (squareMot0 < convexBody->getCcdSquareMotionThreshold())
+	{
+		return btScalar(1.);
+	}
+
+	const btHeightfieldTerrainShape* heightfield = static_cast<const btHeightfieldTerrainShape*>(heightfieldBody->getCollisionShape());
+	const btScalar ccdRadius = convexBody->getCcdSweptSphereRadius();
+	btSphereShape ccdSphere(ccdRadius);
+	btHeightfieldCcdCallback ccdCallback(&ccdSphere, convexBody->getWorldTransform(), convexBody->getInterpolationWorldTransform(), heightfieldBody->getWorldTransform(), heightfield->getMargin());
+	ccdCallback.m_hitFraction = convexBody->getHitFraction();
+
+	const btTransform heightfieldInv = heightfieldBody->getWorldTransform().inverse();
+	const btVector3 fromLocal = heightfieldInv * convexBody->getWorldTransform().getOrigin();
+	const btVector3 toLocal = heightfieldInv * convexBody->getInterpolationWorldTransform().getOrigin();
+	const btVector3 ccdExtent(ccdRadius, ccdRadius, ccdRadius);
+	heightfield->performConvexcast(&ccdCallback, fromLocal, toLocal, -ccdExtent, ccdExtent);
+
+	if (ccdCallback.m_hitFraction < convexBody->getHitFraction())
+	{
+		convexBody->setHitFraction(ccdCallback.m_hitFraction);
+		return ccdCallback.m_hitFraction;
+	}
+	return btScalar(1.);
+}
@@ -0,0 +1,66 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CONVEX_HEIGHTFIELD_COLLISION_ALGORITHM_H
+#define BT_CONVEX_HEIGHTFIELD_COLLISION_ALGORITHM_H
+
+#include "btActivatingCollisionAlgorithm.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "btCollisionDispatcher.h"
+
+///btConvexHeightfieldCollisionAlgorithm collides a convex shape with a btHeightfieldTerrainShape.
+///It visits the grid cells under the convex shape, skipping the cells above or below it with the min/max pyramid of
+///the heightfield (see btHeightfieldTerrainShape::buildAccelerator), and computes the contact with each triangle of the
+///cells with the templated GJK and MPR solvers, without btTriangleShape objects or a collision algorithm per triangle.
+///The terrain is solid below its surface, so the contacts push the convex shape up. At the edges between triangles
+///that are flat or concave, the contact normal is replaced by the triangle normal, so there is no need for
+///btAdjustInternalEdgeContacts, which does not apply to this algorithm.
+///The algorithm is not used by default, see btDefaultCollisionConstructionInfo::m_useConvexHeightfieldAlgorithm.
+class btConvexHeightfieldCollisionAlgorithm : public btActivatingCollisionAlgorithm
+{
+	bool m_ownManifold;
+	btPersistentManifold* m_manifoldPtr;
+	bool m_isSwapped;
+
+public:
+	btConvexHeightfieldCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped);
+
+	virtual ~btConvexHeightfieldCollisionAlgorithm();
+
+	virtual void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual void getAllContactManifolds(btManifoldArray& manifoldArray)
+	{
+		if (m_manifoldPtr && m_ownManifold)
+		{
+			manifoldArray.push_back(m_manifoldPtr);
+		}
+	}
+
+	struct CreateFunc : public btCollisionAlgorithmCreateFunc
+	{
+		virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+		{
+			void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(btConvexHeightfieldCollisionAlgorithm));
+			return new (mem) btConvexHeightfieldCollisionAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, m_swapped);
+		}
+	};
+};
+
+#endif  //BT_CONVEX_HEIGHTFIELD_COLLISION_ALGORITHM_H
@@ -16,12 +16,16 @@ subject to the following restrictions:
 #include "btDefaultCollisionConfiguration.h"
 
 #include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btConvexConvexMprAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btPrimitivePairCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btEmptyCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btConvexConcaveCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btCompoundCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btCompoundCompoundCollisionAlgorithm.h"
 
 #include "BulletCollision/CollisionDispatch/btConvexPlaneCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btConvexHeightfieldCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btSdfCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btBoxBoxCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btSphereSphereCollisionAlgorithm.h"
 #ifdef USE_BUGGY_SPHERE_BOX_ALGORITHM
@@ -93,16 +97,47 @@ btDefaultCollisionConfiguration::btDefaultCollisionConfiguration(const btDefault
 	m_planeConvexCF = new (mem) btConvexPlaneCollisionAlgorithm::CreateFunc;
 	m_planeConvexCF->m_swapped = true;
 
+	mem = btAlignedAlloc(sizeof(btPrimitivePairCollisionAlgorithm::CreateFunc), 16);
+	m_primitivePairCF = new (mem) btPrimitivePairCollisionAlgorithm::CreateFunc;
+	m_usePrimitivePairAlgorithm = constructionInfo.m_usePrimitivePairAlgorithm != 0;
+
+	//convex versus heightfield
+	mem = btAlignedAlloc(sizeof(btConvexHeightfieldCollisionAlgorithm::CreateFunc), 16);
+	m_convexHeightfieldCF = new (mem) btConvexHeightfieldCollisionAlgorithm::CreateFunc;
+	mem = btAlignedAlloc(sizeof(btConvexHeightfieldCollisionAlgorithm::CreateFunc), 16);
+	m_heightfieldConvexCF = new (mem) btConvexHeightfieldCollisionAlgorithm::CreateFunc;
+	m_heightfieldConvexCF->m_swapped = true;
+	m_useConvexHeightfieldAlgorithm = constructionInfo.m_useConvexHeightfieldAlgorithm != 0;
+
+	//signed distance fields versus convex and signed distance fields
+	mem = btAlignedAlloc(sizeof(btSdfCollisionAlgorithm::CreateFunc), 16);
+	m_convexSdfCF = new (mem) btSdfCollisionAlgorithm::CreateFunc;
+	mem = btAlignedAlloc(sizeof(btSdfCollisionAlgorithm::CreateFunc), 16);
+	m_sdfConvexCF = new (mem) btSdfCollisionAlgorithm::CreateFunc;
+	m_sdfConvexCF->m_swapped = true;
+	m_useSdfCollisionAlgorithm = constructionInfo.m_useSdfCollisionAlgorithm != 0;
+
+	mem = btAlignedAlloc(sizeof(btConvexConvexMprAlgorithm::CreateFunc), 16);
+	m_convexConvexMprCreateFunc = new (mem) btConvexConvexMprAlgorithm::CreateFunc;
+
 	///calculate maximum element size, big enough to fit any collision algorithm in the memory pool
 	int maxSize = sizeof(btConvexConvexAlgorithm);
 	int maxSize2 = sizeof(btConvexConcaveCollisionAlgorithm);
 	int maxSize3 = sizeof(btCompoundCollisionAlgorithm);
 	int maxSize4 = sizeof(btCompoundCompoundCollisionAlgorithm);
+	int maxSize5 = sizeof(btConvexConvexMprAlgorithm);
+	int maxSize6 = sizeof(btPrimitivePairCollisionAlgorithm);
+	int maxSize7 = sizeof(btConvexHeightfieldCollisionAlgorithm);
+	int maxSize8 = sizeof(btSdfCollisionAlgorithm);
 
 	int collisionAlgorithmMaxElementSize = btMax(maxSize, constructionInfo.m_customCollisionAlgorithmMaxElementSize);
 	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize2);
 	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize3);
 	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize4);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize5);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize6);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize7);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize, maxSize8);
 
 	if (constructionInfo.m_persistentManifoldPool)
 	{
@@ -185,6 +220,21 @@ btDefaultCollisionConfiguration::~btDefaultCollisionConfiguration()
 	m_planeConvexCF->~btCollisionAlgorithmCreateFunc();
 	btAlignedFree(m_planeConvexCF);
 
+	m_primitivePairCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_primitivePairCF);
+
+	m_convexHeightfieldCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_convexHeightfieldCF);
+	m_heightfieldConvexCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_heightfieldConvexCF);
+	m_sdfConvexCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_sdfConvexCF);
+	m_convexSdfCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_convexSdfCF);
+
+	m_convexConvexMprCreateFunc->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_convexConvexMprCreateFunc);
+
 	m_pdSolver->~btConvexPenetrationDepthSolver();
 
 	btAlignedFree(m_pdSolver);
@@ -297,6 +347,31 @@ btCollisionAlgorithmCreateFunc* btDefaultCollisionConfiguration::getCollisionAlg
 		return m_boxBoxCF;
 	}
 
+	if (m_usePrimitivePairAlgorithm && btPrimitivePairCollisionAlgorithm::hasKernel(proxyType0, proxyType1))
+	{
+		return m_primitivePairCF;
+	}
+
+	if (m_useConvexHeightfieldAlgorithm && btBroadphaseProxy::isConvex(proxyType0) && (proxyType1 == TERRAIN_SHAPE_PROXYTYPE))
+	{
+		return m_convexHeightfieldCF;
+	}
+
+	if (m_useConvexHeightfieldAlgorithm && btBroadphaseProxy::isConvex(proxyType1) && (proxyType0 == TERRAIN_SHAPE_PROXYTYPE))
+	{
+		return m_heightfieldConvexCF;
+	}
+
+	if (m_useSdfCollisionAlgorithm && (proxyType1 == SDF_SHAPE_PROXYTYPE) && (btBroadphaseProxy::isConvex(proxyType0) || proxyType0 == SDF_SHAPE_PROXYTYPE))
+	{
+		return m_convexSdfCF;
+	}
+
+	if (m_useSdfCollisionAlgorithm && (proxyType0 == SDF_SHAPE_PROXYTYPE) && btBroadphaseProxy::isConvex(proxyType1))
+	{
+		return m_sdfConvexCF;
+	}
+
 	if (btBroadphaseProxy::isConvex(proxyType0) && (proxyType1 == STATIC_PLANE_PROXYTYPE))
 	{
 		return m_convexPlaneCF;
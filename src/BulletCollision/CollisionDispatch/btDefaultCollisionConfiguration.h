@@ -28,6 +28,16 @@ struct btDefaultCollisionConstructionInfo
 	int m_defaultMaxCollisionAlgorithmPoolSize;
 	int m_customCollisionAlgorithmMaxElementSize;
 	int m_useEpaPenetrationAlgorithm;
+	///use btPrimitivePairCollisionAlgorithm for capsule-capsule, sphere-capsule, capsule-box, sphere-hull and cylinder-box pairs.
+	///Off by default: these pairs then ignore setConvexConvexMultipointIterations and m_useEpaPenetrationAlgorithm.
+	int m_usePrimitivePairAlgorithm;
+	///use btConvexHeightfieldCollisionAlgorithm for convex versus btHeightfieldTerrainShape pairs, instead of the
+	///generic convex versus concave algorithm. Its contacts ignore btAdjustInternalEdgeContacts.
+	int m_useConvexHeightfieldAlgorithm;
+	///use btSdfCollisionAlgorithm for btSdfCollisionShape versus convex and btSdfCollisionShape pairs, instead of the generic
+	///convex versus concave algorithm. Off by default: SDF_SHAPE_PROXYTYPE is CUSTOM_CONCAVE_SHAPE_TYPE, so only enable it
+	///when no other shape uses CUSTOM_CONCAVE_SHAPE_TYPE.
+	int m_useSdfCollisionAlgorithm;
 
 	btDefaultCollisionConstructionInfo()
 		: m_persistentManifoldPool(0),
@@ -35,7 +45,10 @@ struct btDefaultCollisionConstructionInfo
 		  m_defaultMaxPersistentManifoldPoolSize(4096),
 		  m_defaultMaxCollisionAlgorithmPoolSize(4096),
 		  m_customCollisionAlgorithmMaxElementSize(0),
-		  m_useEpaPenetrationAlgorithm(true)
+		  m_useEpaPenetrationAlgorithm(true),
+		  m_usePrimitivePairAlgorithm(false),
+		  m_useConvexHeightfieldAlgorithm(false),
+		  m_useSdfCollisionAlgorithm(false)
 	{
 	}
 };
@@ -75,6 +88,17 @@ protected:
 	btCollisionAlgorithmCreateFunc* m_triangleSphereCF;
 	btCollisionAlgorithmCreateFunc* m_planeConvexCF;
 	btCollisionAlgorithmCreateFunc* m_convexPlaneCF;
+	btCollisionAlgorithmCreateFunc* m_primitivePairCF;
+	bool m_usePrimitivePairAlgorithm;
+	btCollisionAlgorithmCreateFunc* m_convexHeightfieldCF;
+	btCollisionAlgorithmCreateFunc* m_heightfieldConvexCF;
+	bool m_useConvexHeightfieldAlgorithm;
+	btCollisionAlgorithmCreateFunc* m_convexSdfCF;
+	btCollisionAlgorithmCreateFunc* m_sdfConvexCF;
+	bool m_useSdfCollisionAlgorithm;
+
+	//not used by default, see getConvexConvexMprCreateFunc
+	btCollisionAlgorithmCreateFunc* m_convexConvexMprCreateFunc;
 
 public:
 	btDefaultCollisionConfiguration(const btDefaultCollisionConstructionInfo& constructionInfo = btDefaultCollisionConstructionInfo());
@@ -106,6 +130,14 @@ public:
 	void setConvexConvexMultipointIterations(int numPerturbationIterations = 3, int minimumPointsPerturbationThreshold = 3);
 
 	void setPlaneConvexMultipointIterations(int numPerturbationIterations = 3, int minimumPointsPerturbationThreshold = 3);
+
+	///Returns the create function of btConvexConvexMprAlgorithm, a GJK and MPR based alternative to the default convex-convex algorithm.
+	///Register it for the pairs of shape types that should use it, before the pairs are created, for instance:
+	///dispatcher->registerCollisionCreateFunc(CAPSULE_SHAPE_PROXYTYPE, BOX_SHAPE_PROXYTYPE, collisionConfiguration->getConvexConvexMprCreateFunc());
+	btCollisionAlgorithmCreateFunc* getConvexConvexMprCreateFunc()
+	{
+		return m_convexConvexMprCreateFunc;
+	}
 };
 
 #endif  //BT_DEFAULT_COLLISION_CONFIGURATION
@@ -17,6 +17,8 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionShapes/btPolyhedralConvexShape.h"
+#include "LinearMath/btTransformUtil.h"
 
 ///This is to allow MaterialCombiner/Custom Friction/Restitution values
 ContactAddedCallback gContactAddedCallback = 0;
@@ -86,6 +88,38 @@ btScalar btManifoldResult::calculateCombinedContactStiffness(const btCollisionOb
 	return combinedStiffness;
 }
 
+static bool btHasSpeculativeMotion(const btCollisionObject* body)
+{
+	return body->getInternalType() == btCollisionObject::CO_RIGID_BODY && !body->isStaticOrKinematicObject();
+}
+
+static btVector3 btSpeculativeLinearMotion(const btCollisionObject* body)
+{
+	if (btHasSpeculativeMotion(body))
+	{
+		return body->getInterpolationWorldTransform().getOrigin() - body->getWorldTransform().getOrigin();
+	}
+	return btVector3(0, 0, 0);
+}
+
+static btScalar btSpeculativeAngularMotion(const btCollisionObject* body)
+{
+	if (btHasSpeculativeMotion(body))
+	{
+		btVector3 axis;
+		btScalar angle;
+		btTransformUtil::calculateDiffAxisAngle(body->getWorldTransform(), body->getInterpolationWorldTransform(), axis, angle);
+		return angle * body->getCollisionShape()->getAngularMotionDisc();
+	}
+	return btScalar(0.);
+}
+
+btScalar btManifoldResult::calculateSpeculativeContactDistance(const btCollisionObject* body0, const btCollisionObject* body1)
+{
+	btScalar linearMotion = (btSpeculativeLinearMotion(body0) - btSpeculativeLinearMotion(body1)).length();
+	return linearMotion + btSpeculativeAngularMotion(body0) + btSpeculativeAngularMotion(body1);
+}
+
 btManifoldResult::btManifoldResult(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
 	: m_manifoldPtr(0),
 	  m_body0Wrap(body0Wrap),
@@ -98,7 +132,8 @@ btManifoldResult::btManifoldResult(const btCollisionObjectWrapper* body0Wrap, co
 	  m_index1(-1)
 #endif  //DEBUG_PART_INDEX
 	  ,
-	  m_closestPointDistanceThreshold(0)
+	  m_closestPointDistanceThreshold(0),
+	  m_speculativeContactDistance(0)
 {
 }
 
@@ -200,4 +235,195 @@ void btManifoldResult::addContactPoint(const btVector3& normalOnBInWorld, const
 	{
 		gContactStartedCallback(m_manifoldPtr);
 	}
+
+	if (m_speculativeContactDistance > btScalar(0.))
+	{
+		addSpeculativeVertexContacts(normalOnBInWorld, pointInWorld, depth);
+	}
+}
+
+//the motion of a point attached to the body over the time step
+static btVector3 btSpeculativePointMotion(const btCollisionObject* body, const btVector3& point)
+{
+	if (btHasSpeculativeMotion(body))
+	{
+		return body->getInterpolationWorldTransform()(body->getWorldTransform().invXform(point)) - point;
+	}
+	return btVector3(0, 0, 0);
+}
+
+struct btSpeculativeFaceVertex
+{
+	btScalar m_x;
+	btScalar m_y;
+	btScalar m_angle;
+};
+
+struct btSpeculativeFaceVertexSortPredicate
+{
+	bool operator()(const btSpeculativeFaceVertex& a, const btSpeculativeFaceVertex& b) const
+	{
+		return a.m_angle < b.m_angle;
+	}
+};
+
+///the face of the polyhedron with the outward normal faceNormal, as a convex polygon in the plane coordinates of planeX and planeY.
+///Returns false if the polyhedron only has a vertex or an edge in that direction.
+static bool btGetSpeculativeFace(const btPolyhedralConvexShape* polyhedron, const btTransform& trans, const btVector3& faceNormal, const btVector3& planeX, const btVector3& planeY, btAlignedObjectArray<btSpeculativeFaceVertex>& face)
+{
+	const int numVertices = polyhedron->getNumVertices();
+	btScalar minDist = BT_LARGE_FLOAT;
+	btScalar maxDist = -BT_LARGE_FLOAT;
+	for (int i = 0; i < numVertices; i++)
+	{
+		btVector3 vertex;
+		polyhedron->getVertex(i, vertex);
+		const btScalar dist = faceNormal.dot(trans(vertex));
+		minDist = btMin(minDist, dist);
+		maxDist = btMax(maxDist, dist);
+	}
+	//the normals of the narrowphase are not exact face normals, so the vertices close to the plane of the face count as well
+	btVector3 aabbMin, aabbMax;
+	polyhedron->getAabb(trans, aabbMin, aabbMax);
+	const btScalar faceTolerance = btMax(btScalar(0.02) * (aabbMax - aabbMin).length(), btScalar(0.1) * (maxDist - minDist));
+
+	face.resize(0);
+	btScalar centerX = btScalar(0.);
+	btScalar centerY = btScalar(0.);
+	for (int i = 0; i < numVertices; i++)
+	{
+		btVector3 vertex;
+		polyhedron->getVertex(i, vertex);
+		vertex = trans(vertex);
+		if (faceNormal.dot(vertex) >= maxDist - faceTolerance)
+		{
+			btSpeculativeFaceVertex& faceVertex = face.expandNonInitializing();
+			faceVertex.m_x = planeX.dot(vertex);
+			faceVertex.m_y = planeY.dot(vertex);
+			centerX += faceVertex.m_x;
+			centerY += faceVertex.m_y;
+		}
+	}
+	if (face.size() < 3)
+	{
+		return false;
+	}
+
+	//the vertices of a face of a convex polyhedron are convex, so sorting them around their center gives the polygon
+	centerX /= btScalar(face.size());
+	centerY /= btScalar(face.size());
+	for (int i = 0; i < face.size(); i++)
+	{
+		face[i].m_angle = btAtan2(face[i].m_y - centerY, face[i].m_x - centerX);
+	}
+	face.quickSort(btSpeculativeFaceVertexSortPredicate());
+
+	btScalar doubleArea = btScalar(0.);
+	for (int i = 0; i < face.size(); i++)
+	{
+		const btSpeculativeFaceVertex& a = face[i];
+		const btSpeculativeFaceVertex& b = face[(i + 1) % face.size()];
+		doubleArea += a.m_x * b.m_y - b.m_x * a.m_y;
+	}
+	return doubleArea > faceTolerance * faceTolerance;
+}
+
+static bool btIsInsideSpeculativeFace(const btAlignedObjectArray<btSpeculativeFaceVertex>& face, btScalar x, btScalar y, btScalar tolerance)
+{
+	for (int i = 0; i < face.size(); i++)
+	{
+		const btSpeculativeFaceVertex& a = face[i];
+		const btSpeculativeFaceVertex& b = face[(i + 1) % face.size()];
+		const btScalar edgeX = b.m_x - a.m_x;
+		const btScalar edgeY = b.m_y - a.m_y;
+		//the vertices of both sides of a thin shape can project to almost the same point, the direction of such an edge means nothing
+		const btScalar edgeLength2 = edgeX * edgeX + edgeY * edgeY;
+		if (edgeLength2 <= tolerance * tolerance)
+		{
+			continue;
+		}
+		//the polygon is counter clockwise, so the inside is on the left of each edge
+		const btScalar cross = edgeX * (y - a.m_y) - edgeY * (x - a.m_x);
+		if (cross < -tolerance * btSqrt(edgeLength2))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void btManifoldResult::addSpeculativeVertexContacts(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+{
+	//the solver can stop a single closest point or edge of a polyhedron by spinning the body, while its other vertices pass.
+	//So the vertices of the smaller shape that face the other shape are added against the contact face of the other shape.
+	//like in addContactPoint, A is the object of the first body of the manifold
+	const bool isSwapped = m_manifoldPtr->getBody0() != m_body0Wrap->getCollisionObject();
+	const btCollisionObjectWrapper* wrapA = isSwapped ? m_body1Wrap : m_body0Wrap;
+	const btCollisionObjectWrapper* wrapB = isSwapped ? m_body0Wrap : m_body1Wrap;
+
+	btTransform identity;
+	identity.setIdentity();
+	btVector3 aabbMinA, aabbMaxA, aabbMinB, aabbMaxB;
+	wrapA->getCollisionShape()->getAabb(identity, aabbMinA, aabbMaxA);
+	wrapB->getCollisionShape()->getAabb(identity, aabbMinB, aabbMaxB);
+	const bool isSmallerA = (aabbMaxA - aabbMinA).length2() <= (aabbMaxB - aabbMinB).length2();
+	const btCollisionObjectWrapper* vertexWrap = isSmallerA ? wrapA : wrapB;
+	const btCollisionObjectWrapper* faceWrap = isSmallerA ? wrapB : wrapA;
+	if (!vertexWrap->getCollisionShape()->isPolyhedral() || !faceWrap->getCollisionShape()->isPolyhedral())
+		return;
+
+	//the plane of the contact only supports the vertices within the face of the other shape, beyond its edges
+	//there is either nothing or another part of the other shape that reports its own contacts
+	const btVector3 faceNormal = isSmallerA ? normalOnBInWorld : -normalOnBInWorld;
+	btVector3 planeX, planeY;
+	btPlaneSpace1(faceNormal, planeX, planeY);
+	btAlignedObjectArray<btSpeculativeFaceVertex> face;
+	const btPolyhedralConvexShape* facePolyhedron = static_cast<const btPolyhedralConvexShape*>(faceWrap->getCollisionShape());
+	if (!btGetSpeculativeFace(facePolyhedron, faceWrap->getWorldTransform(), faceNormal, planeX, planeY, face))
+		return;
+	const btScalar faceTolerance = facePolyhedron->getMargin();
+
+	const btPolyhedralConvexShape* polyhedron = static_cast<const btPolyhedralConvexShape*>(vertexWrap->getCollisionShape());
+	const btTransform& vertexTrans = vertexWrap->getWorldTransform();
+	//the distance of a vertex to the contact plane is vertexDirection.dot(vertex) - planeOffset
+	const btVector3 vertexDirection = isSmallerA ? normalOnBInWorld : -normalOnBInWorld;
+	const btScalar planeOffset = isSmallerA ? normalOnBInWorld.dot(pointInWorld) : -normalOnBInWorld.dot(pointInWorld + normalOnBInWorld * depth);
+	const int numVertices = polyhedron->getNumVertices();
+
+	//only the half of the vertices closest to the plane, the others are covered by them
+	btScalar minDepth = BT_LARGE_FLOAT;
+	btScalar maxDepth = -BT_LARGE_FLOAT;
+	for (int i = 0; i < numVertices; i++)
+	{
+		btVector3 vertex;
+		polyhedron->getVertex(i, vertex);
+		btScalar vertexDepth = vertexDirection.dot(vertexTrans(vertex)) - planeOffset;
+		minDepth = btMin(minDepth, vertexDepth);
+		maxDepth = btMax(maxDepth, vertexDepth);
+	}
+	const btScalar maxVertexDepth = btScalar(0.5) * (minDepth + maxDepth);
+
+	//the added points must not add vertex contacts again
+	const btScalar speculativeContactDistance = m_speculativeContactDistance;
+	m_speculativeContactDistance = btScalar(0.);
+	for (int i = 0; i < numVertices; i++)
+	{
+		btVector3 vertex;
+		polyhedron->getVertex(i, vertex);
+		vertex = vertexTrans(vertex);
+		btScalar vertexDepth = vertexDirection.dot(vertex) - planeOffset;
+		//touching and penetrating vertices are left to the regular contacts, and so are the ones that do not close the gap within the step
+		if (vertexDepth <= btScalar(0.) || vertexDepth > maxVertexDepth)
+			continue;
+		const btVector3 pointOnFace = vertex - faceNormal * vertexDepth;
+		const btVector3 relativeMotion = btSpeculativePointMotion(vertexWrap->getCollisionObject(), vertex) - btSpeculativePointMotion(faceWrap->getCollisionObject(), pointOnFace);
+		if (relativeMotion.dot(faceNormal) >= btScalar(0.))
+			continue;
+		if (btIsInsideSpeculativeFace(face, planeX.dot(vertex), planeY.dot(vertex), faceTolerance))
+		{
+			btVector3 pointOnB = isSmallerA ? pointOnFace : vertex;
+			btManifoldResult::addContactPoint(normalOnBInWorld, pointOnB, vertexDepth);
+		}
+	}
+	m_speculativeContactDistance = speculativeContactDistance;
 }
@@ -56,6 +56,8 @@ protected:
 	int m_index0;
 	int m_index1;
 
+	void addSpeculativeVertexContacts(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth);
+
 public:
 	btManifoldResult()
 		:
@@ -66,7 +68,8 @@ public:
 		  m_index0(-1),
 		  m_index1(-1)
 #endif  //DEBUG_PART_INDEX
-			  m_closestPointDistanceThreshold(0)
+			  m_closestPointDistanceThreshold(0),
+			  m_speculativeContactDistance(0)
 	{
 	}
 
@@ -77,6 +80,10 @@ public:
 	void setPersistentManifold(btPersistentManifold* manifoldPtr)
 	{
 		m_manifoldPtr = manifoldPtr;
+		if (manifoldPtr)
+		{
+			manifoldPtr->setSpeculativeContactDistance(m_speculativeContactDistance);
+		}
 	}
 
 	const btPersistentManifold* getPersistentManifold() const
@@ -151,6 +158,13 @@ public:
 
 	btScalar m_closestPointDistanceThreshold;
 
+	///the speculative contact distance of the manifolds set with setPersistentManifold, see btDispatcherInfo::m_useSpeculativeContacts
+	btScalar m_speculativeContactDistance;
+
+	///the relative motion of the objects over the time step, from their world transform to their interpolation world transform,
+	///with the rotation times the angular motion disc of the shapes. Only dynamic rigid bodies move, like in the swept aabbs of btCollisionWorld::updateSingleAabb.
+	static btScalar calculateSpeculativeContactDistance(const btCollisionObject* body0, const btCollisionObject* body1);
+
 	/// in the future we can let the user override the methods to combine restitution and friction
 	static btScalar calculateCombinedRestitution(const btCollisionObject* body0, const btCollisionObject* body1);
 	static btScalar calculateCombinedFriction(const btCollisionObject* body0, const btCollisionObject* body1);
@@ -0,0 +1,207 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2026 Bullet Physics contributors  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btPrimitivePairCollisionAlgorithm.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/NarrowPhaseCollision/btCapsuleCapsuleDistance.h"
+#include "BulletCollision/NarrowPhaseCollision/btConvexTemplateShapes.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpa3.h"
+
+btPrimitivePairCollisionAlgorithm::btPrimitivePairCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+	: btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap),
+	  m_ownManifold(false),
+	  m_manifoldPtr(mf),
+	  m_cachedSeparatingAxis(btScalar(0.), btScalar(1.), btScalar(0.))
+{
+}
+
+btPrimitivePairCollisionAlgorithm::~btPrimitivePairCollisionAlgorithm()
+{
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr)
+			m_dispatcher->releaseManifold(m_manifoldPtr);
+	}
+}
+
+//closed form for capsules and spheres
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+static void btSegmentPairCollide(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btScalar maxDistance, btVector3& cachedSeparatingAxis, btManifoldResult* resultOut)
+{
+	(void)cachedSeparatingAxis;
+	const btConvexTemplateA a(body0Wrap->getCollisionShape(), body0Wrap->getWorldTransform());
+	const btConvexTemplateB b(body1Wrap->getCollisionShape(), body1Wrap->getWorldTransform());
+
+	btVector3 normalOnB;
+	btVector3 pointOnBWorld;
+	const btScalar dist = capsuleCapsuleDistance(normalOnB, pointOnBWorld, a.getHalfHeight(), a.getMargin(),
+												 b.getHalfHeight(), b.getMargin(), a.getUpAxis(), b.getUpAxis(),
+												 a.getWorldTransform(), b.getWorldTransform(), maxDistance);
+	if (dist < maxDistance)
+	{
+		resultOut->addContactPoint(normalOnB, pointOnBWorld, dist);
+	}
+}
+
+//the contact of the shapes from the closest points or the penetration of their cores, a shape is its core with the margin around it
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+static void btAddCoreContact(const btConvexTemplateA& a, const btConvexTemplateB& b, const btGjkEpaSolver3::sResults& results, btScalar maxDistance, btManifoldResult* resultOut)
+{
+	const btScalar distance = results.distance - a.getMargin() - b.getMargin();
+	if (distance > maxDistance)
+	{
+		return;
+	}
+	btVector3 normalOnB = a.getWorldTransform().getBasis() * results.normal;
+	if (results.status != btGjkEpaSolver3::sResults::Penetrating)
+	{
+		btVector3 witnessDelta = results.witnesses[0] - results.witnesses[1];
+		const btScalar len2 = witnessDelta.length2();
+		if (len2 > SIMD_EPSILON * SIMD_EPSILON)
+		{
+			normalOnB = witnessDelta / btSqrt(len2);
+		}
+	}
+	resultOut->addContactPoint(normalOnB, results.witnesses[1] + normalOnB * b.getMargin(), distance);
+}
+
+//GJK between the cores of the shapes, then EPA on the cores once they overlap: the cores of the rounded shapes are
+//polytopes, where EPA finds the exact penetration, while it can stop early on the curved full shapes.
+//EPA on the full shapes only when the cores are flat and EPA fails on them.
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+static void btCoreGjkEpaCollide(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btScalar maxDistance, btVector3& cachedSeparatingAxis, btManifoldResult* resultOut)
+{
+	const btConvexTemplateA a(body0Wrap->getCollisionShape(), body0Wrap->getWorldTransform());
+	const btConvexTemplateB b(body1Wrap->getCollisionShape(), body1Wrap->getWorldTransform());
+	const btConvexTemplateCore<btConvexTemplateA> coreA(a);
+	const btConvexTemplateCore<btConvexTemplateB> coreB(b);
+
+	//the normal of the results is in the local space of A, the witness points are in world space
+	btGjkEpaSolver3::sResults results;
+	if (btGjkEpaSolver3_Distance(coreA, coreB, cachedSeparatingAxis, results) ||
+		btGjkEpaSolver3_Penetration(coreA, coreB, cachedSeparatingAxis, results))
+	{
+		cachedSeparatingAxis = results.normal;
+		btAddCoreContact(a, b, results, maxDistance, resultOut);
+		return;
+	}
+
+	if (btGjkEpaSolver3_Penetration(a, b, cachedSeparatingAxis, results))
+	{
+		cachedSeparatingAxis = results.normal;
+		resultOut->addContactPoint(a.getWorldTransform().getBasis() * results.normal, results.witnesses[1], results.distance);
+	}
+}
+
+enum btPrimitivePairShapeType
+{
+	BT_PRIMITIVE_PAIR_SPHERE,
+	BT_PRIMITIVE_PAIR_CAPSULE,
+	BT_PRIMITIVE_PAIR_BOX,
+	BT_PRIMITIVE_PAIR_HULL,
+	BT_PRIMITIVE_PAIR_CYLINDER,
+	BT_PRIMITIVE_PAIR_NUM_TYPES
+};
+
+static int btGetPrimitivePairShapeType(int proxyType)
+{
+	switch (proxyType)
+	{
+		case SPHERE_SHAPE_PROXYTYPE:
+			return BT_PRIMITIVE_PAIR_SPHERE;
+		case CAPSULE_SHAPE_PROXYTYPE:
+			return BT_PRIMITIVE_PAIR_CAPSULE;
+		case BOX_SHAPE_PROXYTYPE:
+			return BT_PRIMITIVE_PAIR_BOX;
+		case CONVEX_HULL_SHAPE_PROXYTYPE:
+			return BT_PRIMITIVE_PAIR_HULL;
+		case CYLINDER_SHAPE_PROXYTYPE:
+			return BT_PRIMITIVE_PAIR_CYLINDER;
+		default:
+			return -1;
+	}
+}
+
+typedef void (*btPrimitivePairCollideFunc)(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btScalar maxDistance, btVector3& cachedSeparatingAxis, btManifoldResult* resultOut);
+
+//the pairs without a kernel are left to the other algorithms of btDefaultCollisionConfiguration
+static const btPrimitivePairCollideFunc gPrimitivePairCollideFuncs[BT_PRIMITIVE_PAIR_NUM_TYPES][BT_PRIMITIVE_PAIR_NUM_TYPES] = {
+	//sphere
+	{0, &btSegmentPairCollide<btConvexTemplateSphere, btConvexTemplateCapsule>, 0,
+	 &btCoreGjkEpaCollide<btConvexTemplateSphere, btConvexTemplateHull>, 0},
+	//capsule
+	{&btSegmentPairCollide<btConvexTemplateCapsule, btConvexTemplateSphere>, &btSegmentPairCollide<btConvexTemplateCapsule, btConvexTemplateCapsule>,
+	 &btCoreGjkEpaCollide<btConvexTemplateCapsule, btConvexTemplateBox>, 0, 0},
+	//box
+	{0, &btCoreGjkEpaCollide<btConvexTemplateBox, btConvexTemplateCapsule>, 0, 0,
+	 &btCoreGjkEpaCollide<btConvexTemplateBox, btConvexTemplateCylinder>},
+	//hull
+	{&btCoreGjkEpaCollide<btConvexTemplateHull, btConvexTemplateSphere>, 0, 0, 0, 0},
+	//cylinder
+	{0, 0, &btCoreGjkEpaCollide<btConvexTemplateCylinder, btConvexTemplateBox>, 0, 0}};
+
+static btPrimitivePairCollideFunc btGetPrimitivePairCollideFunc(int proxyType0, int proxyType1)
+{
+	const int type0 = btGetPrimitivePairShapeType(proxyType0);
+	const int type1 = btGetPrimitivePairShapeType(proxyType1);
+	if (type0 < 0 || type1 < 0)
+	{
+		return 0;
+	}
+	return gPrimitivePairCollideFuncs[type0][type1];
+}
+
+bool btPrimitivePairCollisionAlgorithm::hasKernel(int proxyType0, int proxyType1)
+{
+	return btGetPrimitivePairCollideFunc(proxyType0, proxyType1) != 0;
+}
+
+void btPrimitivePairCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)dispatchInfo;
+	const btPrimitivePairCollideFunc collideFunc = btGetPrimitivePairCollideFunc(body0Wrap->getCollisionShape()->getShapeType(), body1Wrap->getCollisionShape()->getShapeType());
+	btAssert(collideFunc);
+	if (!collideFunc)
+	{
+		return;
+	}
+
+	if (!m_manifoldPtr)
+	{
+		//swapped?
+		m_manifoldPtr = m_dispatcher->getNewManifold(body0Wrap->getCollisionObject(), body1Wrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	const btScalar maxDistance = m_manifoldPtr->getContactBreakingThreshold() + resultOut->m_closestPointDistanceThreshold;
+	collideFunc(body0Wrap, body1Wrap, maxDistance, m_cachedSeparatingAxis, resultOut);
+
+	if (m_ownManifold)
+	{
+		resultOut->refreshContactPoints();
+	}
+}
+
+btScalar btPrimitivePairCollisionAlgorithm::calculateTimeOfImpact(btCollisionObject* col0, btCollisionObject* col1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)dispatchInfo;
+	(void)resultOut;
+	return btConvexConvexAlgorithm::calculateSweptSphereTimeOfImpact(col0, col1);
+}
@@ -0,0 +1,68 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2026 Bullet Physics contributors  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_PRIMITIVE_PAIR_COLLISION_ALGORITHM_H
+#define BT_PRIMITIVE_PAIR_COLLISION_ALGORITHM_H
+
+#include "btActivatingCollisionAlgorithm.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "btCollisionDispatcher.h"
+
+class btManifoldResult;
+
+///btPrimitivePairCollisionAlgorithm computes the contact between common pairs of primitive shapes with a kernel that is
+///instantiated for the pair at compile time, so no virtual calls are made inside the kernel:
+///capsule-capsule and sphere-capsule use the closed form segment distance, capsule-box, sphere-hull and cylinder-box
+///run the templated GJK (btGjkEpa3.h) between the shape cores and EPA on the full shapes once the cores overlap.
+///It generates one contact point per frame, the points accumulate in the persistent manifold.
+///btDefaultCollisionConfiguration uses it for these pairs, see btDefaultCollisionConstructionInfo::m_usePrimitivePairAlgorithm.
+class btPrimitivePairCollisionAlgorithm : public btActivatingCollisionAlgorithm
+{
+	bool m_ownManifold;
+	btPersistentManifold* m_manifoldPtr;
+	///separating direction of the previous frame in the local space of body 0, the first search direction of GJK
+	btVector3 m_cachedSeparatingAxis;
+
+public:
+	btPrimitivePairCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap);
+
+	virtual ~btPrimitivePairCollisionAlgorithm();
+
+	virtual void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual void getAllContactManifolds(btManifoldArray& manifoldArray)
+	{
+		if (m_manifoldPtr && m_ownManifold)
+			manifoldArray.push_back(m_manifoldPtr);
+	}
+
+	///returns true if there is a kernel for the pair of proxy types
+	static bool hasKernel(int proxyType0, int proxyType1);
+
+	struct CreateFunc : public btCollisionAlgorithmCreateFunc
+	{
+		virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+		{
+			void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(btPrimitivePairCollisionAlgorithm));
+			return new (mem) btPrimitivePairCollisionAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap);
+		}
+	};
+};
+
+#endif  //BT_PRIMITIVE_PAIR_COLLISION_ALGORITHM_H
@@ -0,0 +1,364 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btSdfCollisionAlgorithm.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btCapsuleShape.h"
+#include "BulletCollision/CollisionShapes/btMiniSDF.h"
+#include "BulletCollision/CollisionShapes/btPolyhedralConvexShape.h"
+#include "BulletCollision/CollisionShapes/btSdfCollisionShape.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "LinearMath/btAabbUtil2.h"
+#include "LinearMath/btQuickprof.h"
+
+///the maximum number of samples along an edge of a convex shape or along the axis of a capsule
+#define BT_SDF_MAX_SAMPLES_PER_AXIS 8
+///the maximum number of steps of the sphere tracing of calculateTimeOfImpact
+#define BT_SDF_MAX_CCD_ITERATIONS 64
+
+btSdfCollisionAlgorithm::btSdfCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped)
+	: btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap),
+	  m_ownManifold(false),
+	  m_manifoldPtr(mf),
+	  m_isSwapped(isSwapped),
+	  m_convexSampleRadius(0),
+	  m_sampledConvex(0),
+	  m_sampledScaling(0, 0, 0)
+{
+	const btCollisionObjectWrapper* otherObjWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* sdfObjWrap = m_isSwapped ? body0Wrap : body1Wrap;
+
+	if (!m_manifoldPtr && m_dispatcher->needsCollision(otherObjWrap->getCollisionObject(), sdfObjWrap->getCollisionObject()))
+	{
+		m_manifoldPtr = m_dispatcher->getNewManifold(otherObjWrap->getCollisionObject(), sdfObjWrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+}
+
+btSdfCollisionAlgorithm::~btSdfCollisionAlgorithm()
+{
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr)
+			m_dispatcher->releaseManifold(m_manifoldPtr);
+	}
+}
+
+static int btSdfNumSegments(btScalar length, btScalar spacing)
+{
+	const int numSegments = static_cast<int>(length / spacing) + 1;
+	return btMin(numSegments, int(BT_SDF_MAX_SAMPLES_PER_AXIS));
+}
+
+void btSdfCollisionAlgorithm::updateConvexSamples(const btConvexShape* convex, btScalar spacing)
+{
+	if (convex == m_sampledConvex && convex->getLocalScaling() == m_sampledScaling)
+	{
+		return;
+	}
+	m_sampledConvex = convex;
+	m_sampledScaling = convex->getLocalScaling();
+	m_convexSamples.resize(0);
+	m_convexSampleRadius = btScalar(0.);
+
+	switch (convex->getShapeType())
+	{
+		case SPHERE_SHAPE_PROXYTYPE:
+		{
+			m_convexSamples.push_back(btVector3(0, 0, 0));
+			m_convexSampleRadius = static_cast<const btSphereShape*>(convex)->getRadius();
+			return;
+		}
+		case CAPSULE_SHAPE_PROXYTYPE:
+		{
+			const btCapsuleShape* capsule = static_cast<const btCapsuleShape*>(convex);
+			const int upAxis = capsule->getUpAxis();
+			const btScalar halfHeight = capsule->getHalfHeight();
+			const int numSegments = btSdfNumSegments(btScalar(2.) * halfHeight, spacing);
+			for (int i = 0; i <= numSegments; i++)
+			{
+				btVector3 sample(0, 0, 0);
+				sample[upAxis] = -halfHeight + btScalar(2.) * halfHeight * btScalar(i) / btScalar(numSegments);
+				m_convexSamples.push_back(sample);
+			}
+			m_convexSampleRadius = capsule->getRadius();
+			return;
+		}
+		case BOX_SHAPE_PROXYTYPE:
+		{
+			//a lattice of points on the faces of the box, including its vertices and edges
+			const btVector3 halfExtents = static_cast<const btBoxShape*>(convex)->getHalfExtentsWithMargin();
+			int numSegments[3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				numSegments[axis] = btSdfNumSegments(btScalar(2.) * halfExtents[axis], spacing);
+			}
+			for (int i = 0; i <= numSegments[0]; i++)
+			{
+				for (int j = 0; j <= numSegments[1]; j++)
+				{
+					for (int k = 0; k <= numSegments[2]; k++)
+					{
+						if (i != 0 && i != numSegments[0] && j != 0 && j != numSegments[1] && k != 0 && k != numSegments[2])
+						{
+							continue;
+						}
+						const btVector3 t(btScalar(i) / btScalar(numSegments[0]), btScalar(j) / btScalar(numSegments[1]), btScalar(k) / btScalar(numSegments[2]));
+						m_convexSamples.push_back(halfExtents * (btScalar(2.) * t - btVector3(1, 1, 1)));
+					}
+				}
+			}
+			return;
+		}
+		default:
+			break;
+	}
+
+	if (convex->isPolyhedral())
+	{
+		//the vertices and points along the edges, rounded by the margin
+		const btPolyhedralConvexShape* polyhedron = static_cast<const btPolyhedralConvexShape*>(convex);
+		for (int i = 0; i < polyhedron->getNumVertices(); i++)
+		{
+			btVector3 vertex;
+			polyhedron->getVertex(i, vertex);
+			m_convexSamples.push_back(vertex);
+		}
+		for (int i = 0; i < polyhedron->getNumEdges(); i++)
+		{
+			btVector3 pa, pb;
+			polyhedron->getEdge(i, pa, pb);
+			const int numSegments = btSdfNumSegments((pb - pa).length(), spacing);
+			for (int j = 1; j < numSegments; j++)
+			{
+				m_convexSamples.push_back(pa.lerp(pb, btScalar(j) / btScalar(numSegments)));
+			}
+		}
+		m_convexSampleRadius = polyhedron->getMargin();
+		return;
+	}
+
+	//the support points along the axes, the diagonals of the faces and the diagonals of the unit cube
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int z = -1; z <= 1; z++)
+			{
+				if (x || y || z)
+				{
+					m_convexSamples.push_back(convex->localGetSupportingVertex(btVector3(btScalar(x), btScalar(y), btScalar(z))));
+				}
+			}
+		}
+	}
+}
+
+///transforms the points to world space and to the local space of the distance field, keeping the points within its aabb
+static void btGatherSdfQueryPoints(const btAlignedObjectArray<btVector3>& localPoints, const btTransform& pointsTrans, const btTransform& sdfTrans,
+								   const btVector3& sdfAabbMin, const btVector3& sdfAabbMax,
+								   btAlignedObjectArray<btVector3>& queryPoints, btAlignedObjectArray<btVector3>& worldPoints)
+{
+	const btTransform pointsToSdf = sdfTrans.inverseTimes(pointsTrans);
+	queryPoints.resize(0);
+	worldPoints.resize(0);
+	for (int i = 0; i < localPoints.size(); i++)
+	{
+		const btVector3 pointInSdf = pointsToSdf * localPoints[i];
+		if (TestPointAgainstAabb2(sdfAabbMin, sdfAabbMax, pointInSdf))
+		{
+			queryPoints.push_back(pointInSdf);
+			worldPoints.push_back(pointsTrans * localPoints[i]);
+		}
+	}
+}
+
+void btSdfCollisionAlgorithm::addSdfContacts(const btSdfCollisionShape* sdfShape, const btTransform& sdfTrans, btScalar radius, btScalar maxDistance, bool sdfIsManifoldBody1, btManifoldResult* resultOut)
+{
+	const int numPoints = m_queryPoints.size();
+	if (!numPoints)
+	{
+		return;
+	}
+	m_queryDistances.resize(numPoints);
+	m_queryNormals.resize(numPoints);
+	if (!sdfShape->queryPoints(&m_queryPoints[0], numPoints, &m_queryDistances[0], &m_queryNormals[0]))
+	{
+		return;
+	}
+
+	for (int i = 0; i < numPoints; i++)
+	{
+		const btScalar dist = m_queryDistances[i];
+		const btScalar depth = dist - radius;
+		if (depth >= maxDistance)
+		{
+			continue;
+		}
+		const btScalar len2 = m_queryNormals[i].length2();
+		if (len2 < SIMD_EPSILON * SIMD_EPSILON)
+		{
+			continue;
+		}
+		//the gradient points out of the distance field, towards the other body
+		const btVector3 normal = sdfTrans.getBasis() * (m_queryNormals[i] / btSqrt(len2));
+		const btVector3& pointInWorld = m_queryWorldPoints[i];
+		if (sdfIsManifoldBody1)
+		{
+			resultOut->addContactPoint(normal, pointInWorld - normal * dist, depth);
+		}
+		else
+		{
+			//the point is on the surface of manifold body 1, queried in the distance field of manifold body 0
+			resultOut->addContactPoint(-normal, pointInWorld, depth);
+		}
+	}
+}
+
+void btSdfCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	BT_PROFILE("btSdfCollisionAlgorithm::processCollision");
+	(void)dispatchInfo;
+	if (!m_manifoldPtr)
+		return;
+
+	const btCollisionObjectWrapper* otherObjWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* sdfObjWrap = m_isSwapped ? body0Wrap : body1Wrap;
+
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	const btScalar maxDistance = m_manifoldPtr->getContactBreakingThreshold() + resultOut->m_closestPointDistanceThreshold;
+	const btVector3 maxExtent(maxDistance, maxDistance, maxDistance);
+	const btSdfCollisionShape* sdfShape = static_cast<const btSdfCollisionShape*>(sdfObjWrap->getCollisionShape());
+	const btTransform& sdfTrans = sdfObjWrap->getWorldTransform();
+	const btTransform& otherTrans = otherObjWrap->getWorldTransform();
+	btVector3 sdfAabbMin, sdfAabbMax;
+	sdfShape->getAabb(btTransform::getIdentity(), sdfAabbMin, sdfAabbMax);
+
+	const btCollisionShape* otherShape = otherObjWrap->getCollisionShape();
+	if (otherShape->getShapeType() == SDF_SHAPE_PROXYTYPE)
+	{
+		const btSdfCollisionShape* otherSdfShape = static_cast<const btSdfCollisionShape*>(otherShape);
+		btVector3 otherAabbMin, otherAabbMax;
+		otherSdfShape->getAabb(btTransform::getIdentity(), otherAabbMin, otherAabbMax);
+
+		btGatherSdfQueryPoints(otherSdfShape->getSurfacePoints(), otherTrans, sdfTrans, sdfAabbMin - maxExtent, sdfAabbMax + maxExtent, m_queryPoints, m_queryWorldPoints);
+		addSdfContacts(sdfShape, sdfTrans, btScalar(0.), maxDistance, true, resultOut);
+
+		btGatherSdfQueryPoints(sdfShape->getSurfacePoints(), sdfTrans, otherTrans, otherAabbMin - maxExtent, otherAabbMax + maxExtent, m_queryPoints, m_queryWorldPoints);
+		addSdfContacts(otherSdfShape, otherTrans, btScalar(0.), maxDistance, false, resultOut);
+	}
+	else if (otherShape->isConvex())
+	{
+		const btMiniSDF& sdf = sdfShape->getSDF();
+		const btScalar spacing = btScalar(2.) * sdf.m_cell_size[sdf.m_cell_size.minAxis()];
+		updateConvexSamples(static_cast<const btConvexShape*>(otherShape), spacing);
+
+		const btScalar extent = maxDistance + m_convexSampleRadius;
+		const btVector3 sampleExtent(extent, extent, extent);
+		btGatherSdfQueryPoints(m_convexSamples, otherTrans, sdfTrans, sdfAabbMin - sampleExtent, sdfAabbMax + sampleExtent, m_queryPoints, m_queryWorldPoints);
+		addSdfContacts(sdfShape, sdfTrans, m_convexSampleRadius, maxDistance, true, resultOut);
+	}
+
+	if (m_ownManifold)
+	{
+		resultOut->refreshContactPoints();
+	}
+}
+
+btScalar btSdfCollisionAlgorithm::calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)resultOut;
+	(void)dispatchInfo;
+	btCollisionObject* otherBody = m_isSwapped ? body1 : body0;
+	btCollisionObject* sdfBody = m_isSwapped ? body0 : body1;
+
+	//only perform CCD above a certain threshold, like btConvexConcaveCollisionAlgorithm
+	btScalar squareMot0 = (otherBody->getInterpolationWorldTransform().getOrigin() - otherBody->getWorldTransform().getOrigin()).length2();
+	if (squareMot0 < otherBody->getCcdSquareMotionThreshold())
+	{
+		return btScalar(1.);
+	}
+
+	const btSdfCollisionShape* sdfShape = static_cast<const btSdfCollisionShape*>(sdfBody->getCollisionShape());
+	const btMiniSDF& sdf = sdfShape->getSDF();
+	const btScalar ccdRadius = otherBody->getCcdSweptSphereRadius();
+	const btVector3 from = sdfBody->getWorldTransform().invXform(otherBody->getWorldTransform().getOrigin());
+	const btVector3 to = sdfBody->getWorldTransform().invXform(otherBody->getInterpolationWorldTransform().getOrigin());
+	const btVector3 motion = to - from;
+	const btScalar motionLength = motion.length();
+
+	//clip the motion against the domain of the distance field, expanded by the swept sphere
+	btScalar tMin = btScalar(0.);
+	btScalar tMax = otherBody->getHitFraction();
+	const btVector3 ccdExtent(ccdRadius, ccdRadius, ccdRadius);
+	const btVector3 domainMin = sdf.m_domain.min() - ccdExtent;
+	const btVector3 domainMax = sdf.m_domain.max() + ccdExtent;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (btFabs(motion[axis]) < SIMD_EPSILON)
+		{
+			if (from[axis] < domainMin[axis] || from[axis] > domainMax[axis])
+			{
+				return btScalar(1.);
+			}
+			continue;
+		}
+		btScalar t0 = (domainMin[axis] - from[axis]) / motion[axis];
+		btScalar t1 = (domainMax[axis] - from[axis]) / motion[axis];
+		if (t0 > t1)
+		{
+			btSwap(t0, t1);
+		}
+		tMin = btMax(tMin, t0);
+		tMax = btMin(tMax, t1);
+	}
+	if (tMin >= tMax)
+	{
+		return btScalar(1.);
+	}
+
+	//sphere tracing: the swept sphere can move by its clearance without touching the surface
+	const btScalar minStep = btScalar(0.5) * sdf.m_cell_size[sdf.m_cell_size.minAxis()];
+	const btScalar tolerance = btScalar(0.01) * minStep;
+	btScalar t = tMin;
+	for (int i = 0; i < BT_SDF_MAX_CCD_ITERATIONS && t < tMax; i++)
+	{
+		const btVector3 point = from + motion * t;
+		btScalar dist;
+		btVector3 gradient;
+		btScalar clearance = minStep;
+		if (sdfShape->queryPoints(&point, 1, &dist, &gradient))
+		{
+			clearance = dist - ccdRadius;
+			if (clearance < tolerance)
+			{
+				if (t <= btScalar(0.))
+				{
+					//already touching at the start, the discrete collision detection takes care of it
+					return btScalar(1.);
+				}
+				otherBody->setHitFraction(t);
+				return t;
+			}
+		}
+		t += clearance / motionLength;
+	}
+	return btScalar(1.);
+}
@@ -0,0 +1,85 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SDF_COLLISION_ALGORITHM_H
+#define BT_SDF_COLLISION_ALGORITHM_H
+
+#include "btActivatingCollisionAlgorithm.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "btCollisionDispatcher.h"
+
+class btConvexShape;
+class btSdfCollisionShape;
+
+///btSdfCollisionAlgorithm collides a btSdfCollisionShape with a convex shape or with another btSdfCollisionShape.
+///The convex shape is represented by sample points with a radius: the center of a sphere, points along the axis of a capsule,
+///points on the faces of a box, the vertices and points on the edges of other polyhedral shapes and support points of the
+///remaining shapes. The samples are queried in the distance field in one batch, see btSdfCollisionShape::queryPoints.
+///Two btSdfCollisionShape query the surface points of each one in the distance field of the other.
+///The contacts are reduced to the four points of the persistent manifold, so only the deepest features are kept.
+class btSdfCollisionAlgorithm : public btActivatingCollisionAlgorithm
+{
+	bool m_ownManifold;
+	btPersistentManifold* m_manifoldPtr;
+	bool m_isSwapped;
+
+	///the samples of the convex shape in its local space, computed again when the shape or its scaling change
+	btAlignedObjectArray<btVector3> m_convexSamples;
+	btScalar m_convexSampleRadius;
+	const btConvexShape* m_sampledConvex;
+	btVector3 m_sampledScaling;
+
+	btAlignedObjectArray<btVector3> m_queryPoints;
+	btAlignedObjectArray<btVector3> m_queryWorldPoints;
+	btAlignedObjectArray<btScalar> m_queryDistances;
+	btAlignedObjectArray<btVector3> m_queryNormals;
+
+	void updateConvexSamples(const btConvexShape* convex, btScalar spacing);
+
+	void addSdfContacts(const btSdfCollisionShape* sdfShape, const btTransform& sdfTrans, btScalar radius, btScalar maxDistance, bool sdfIsManifoldBody1, btManifoldResult* resultOut);
+
+public:
+	btSdfCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped);
+
+	virtual ~btSdfCollisionAlgorithm();
+
+	virtual void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	///sphere traces the swept sphere of the moving body through the distance field of the other body
+	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual void getAllContactManifolds(btManifoldArray& manifoldArray)
+	{
+		if (m_manifoldPtr && m_ownManifold)
+		{
+			manifoldArray.push_back(m_manifoldPtr);
+		}
+	}
+
+	///the btSdfCollisionShape is body1, or body0 when m_swapped is set. With two btSdfCollisionShape, use a CreateFunc that is not swapped.
+	struct CreateFunc : public btCollisionAlgorithmCreateFunc
+	{
+		virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+		{
+			void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(btSdfCollisionAlgorithm));
+			return new (mem) btSdfCollisionAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, m_swapped);
+		}
+	};
+};
+
+#endif  //BT_SDF_COLLISION_ALGORITHM_H
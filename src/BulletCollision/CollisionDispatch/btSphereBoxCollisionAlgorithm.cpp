@@ -63,10 +63,10 @@ void btSphereBoxCollisionAlgorithm::processCollision(const btCollisionObjectWrap
 	btVector3 sphereCenter = sphereObjWrap->getWorldTransform().getOrigin();
 	const btSphereShape* sphere0 = (const btSphereShape*)sphereObjWrap->getCollisionShape();
 	btScalar radius = sphere0->getRadius();
-	btScalar maxContactDistance = m_manifoldPtr->getContactBreakingThreshold();
-
 	resultOut->setPersistentManifold(m_manifoldPtr);
 
+	btScalar maxContactDistance = m_manifoldPtr->getContactBreakingThreshold();
+
 	if (getSphereDistance(boxObjWrap, pOnBox, normalOnSurfaceB, penetrationDepth, sphereCenter, radius, maxContactDistance))
 	{
 		/// report a contact. internally this will be kept persistent, and contact reduction is done
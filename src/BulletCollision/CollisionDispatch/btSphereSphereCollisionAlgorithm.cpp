@@ -62,8 +62,8 @@ void btSphereSphereCollisionAlgorithm::processCollision(const btCollisionObjectW
 	m_manifoldPtr->clearManifold();  //don't do this, it disables warmstarting
 #endif
 
-	///iff distance positive, don't generate a new contact
-	if (len > (radius0 + radius1 + resultOut->m_closestPointDistanceThreshold))
+	///iff distance positive, don't generate a new contact, unless it is a speculative contact
+	if (len > (radius0 + radius1 + resultOut->m_closestPointDistanceThreshold + m_manifoldPtr->getSpeculativeContactDistance()))
 	{
 #ifndef CLEAR_MANIFOLD
 		resultOut->refreshContactPoints();
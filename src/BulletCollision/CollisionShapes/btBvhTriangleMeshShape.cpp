@@ -25,8 +25,12 @@ btBvhTriangleMeshShape::btBvhTriangleMeshShape(btStridingMeshInterface* meshInte
 	: btTriangleMeshShape(meshInterface),
 	  m_bvh(0),
 	  m_triangleInfoMap(0),
+	  m_wideBvh(0),
+	  m_refitData(0),
+	  m_bvhBuildMode(btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC),
 	  m_useQuantizedAabbCompression(useQuantizedAabbCompression),
-	  m_ownsBvh(false)
+	  m_ownsBvh(false),
+	  m_ownsWideBvh(false)
 {
 	m_shapeType = TRIANGLE_MESH_SHAPE_PROXYTYPE;
 	//construct bvh from meshInterface
@@ -44,8 +48,12 @@ btBvhTriangleMeshShape::btBvhTriangleMeshShape(btStridingMeshInterface* meshInte
 	: btTriangleMeshShape(meshInterface),
 	  m_bvh(0),
 	  m_triangleInfoMap(0),
+	  m_wideBvh(0),
+	  m_refitData(0),
+	  m_bvhBuildMode(btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC),
 	  m_useQuantizedAabbCompression(useQuantizedAabbCompression),
-	  m_ownsBvh(false)
+	  m_ownsBvh(false),
+	  m_ownsWideBvh(false)
 {
 	m_shapeType = TRIANGLE_MESH_SHAPE_PROXYTYPE;
 	//construct bvh from meshInterface
@@ -56,7 +64,7 @@ btBvhTriangleMeshShape::btBvhTriangleMeshShape(btStridingMeshInterface* meshInte
 		void* mem = btAlignedAlloc(sizeof(btOptimizedBvh), 16);
 		m_bvh = new (mem) btOptimizedBvh();
 
-		m_bvh->build(meshInterface, m_useQuantizedAabbCompression, bvhAabbMin, bvhAabbMax);
+		m_bvh->build(meshInterface, m_useQuantizedAabbCompression, bvhAabbMin, bvhAabbMax, m_bvhBuildMode);
 		m_ownsBvh = true;
 	}
 
@@ -65,7 +73,14 @@ btBvhTriangleMeshShape::btBvhTriangleMeshShape(btStridingMeshInterface* meshInte
 
 void btBvhTriangleMeshShape::partialRefitTree(const btVector3& aabbMin, const btVector3& aabbMax)
 {
-	m_bvh->refitPartial(m_meshInterface, aabbMin, aabbMax);
+	if (m_bvh)
+	{
+		m_bvh->refitPartial(m_meshInterface, aabbMin, aabbMax);
+	}
+	if (m_wideBvh)
+	{
+		m_wideBvh->refitPartial(m_meshInterface, aabbMin, aabbMax);
+	}
 
 	m_localAabbMin.setMin(aabbMin);
 	m_localAabbMax.setMax(aabbMax);
@@ -73,11 +88,64 @@ void btBvhTriangleMeshShape::partialRefitTree(const btVector3& aabbMin, const bt
 
 void btBvhTriangleMeshShape::refitTree(const btVector3& aabbMin, const btVector3& aabbMax)
 {
-	m_bvh->refit(m_meshInterface, aabbMin, aabbMax);
+	if (m_bvh)
+	{
+		m_bvh->refit(m_meshInterface, aabbMin, aabbMax);
+	}
+	if (m_wideBvh)
+	{
+		m_wideBvh->refit(m_meshInterface, aabbMin, aabbMax);
+	}
 
 	recalcLocalAabb();
 }
 
+void btBvhTriangleMeshShape::refitDirtyTriangles(bool clearDirtyTriangles)
+{
+	if (m_meshInterface->getDirtyTriangles().size() == 0)
+	{
+		return;
+	}
+
+	if (m_bvh && m_bvh->isQuantized())
+	{
+		if (!m_refitData)
+		{
+			void* mem = btAlignedAlloc(sizeof(btOptimizedBvhRefitData), 16);
+			m_refitData = new (mem) btOptimizedBvhRefitData();
+		}
+		const bool inRange = m_bvh->refitDirtyTriangles(m_meshInterface, *m_refitData);
+		m_localAabbMin.setMin(m_refitData->m_dirtyAabbMin);
+		m_localAabbMax.setMax(m_refitData->m_dirtyAabbMax);
+		if (m_wideBvh)
+		{
+			const btVector3& wideAabbMin = m_wideBvh->getBvhAabbMin();
+			const btVector3& wideAabbMax = m_wideBvh->getBvhAabbMax();
+			if (inRange &&
+				m_refitData->m_dirtyAabbMin.getX() > wideAabbMin.getX() && m_refitData->m_dirtyAabbMin.getY() > wideAabbMin.getY() && m_refitData->m_dirtyAabbMin.getZ() > wideAabbMin.getZ() &&
+				m_refitData->m_dirtyAabbMax.getX() < wideAabbMax.getX() && m_refitData->m_dirtyAabbMax.getY() < wideAabbMax.getY() && m_refitData->m_dirtyAabbMax.getZ() < wideAabbMax.getZ())
+			{
+				m_wideBvh->refitPartial(m_meshInterface, m_refitData->m_dirtyAabbMin, m_refitData->m_dirtyAabbMax);
+			}
+			else
+			{
+				m_wideBvh->refit(m_meshInterface, m_localAabbMin, m_localAabbMax);
+			}
+		}
+	}
+	else
+	{
+		//without a quantized btOptimizedBvh there is no incremental path
+		recalcLocalAabb();
+		refitTree(m_localAabbMin, m_localAabbMax);
+	}
+
+	if (clearDirtyTriangles)
+	{
+		m_meshInterface->clearDirtyTriangles();
+	}
+}
+
 btBvhTriangleMeshShape::~btBvhTriangleMeshShape()
 {
 	if (m_ownsBvh)
@@ -85,6 +153,16 @@ btBvhTriangleMeshShape::~btBvhTriangleMeshShape()
 		m_bvh->~btOptimizedBvh();
 		btAlignedFree(m_bvh);
 	}
+	if (m_ownsWideBvh)
+	{
+		m_wideBvh->~btWideBvh();
+		btAlignedFree(m_wideBvh);
+	}
+	if (m_refitData)
+	{
+		m_refitData->~btOptimizedBvhRefitData();
+		btAlignedFree(m_refitData);
+	}
 }
 
 void btBvhTriangleMeshShape::performRaycast(btTriangleCallback* callback, const btVector3& raySource, const btVector3& rayTarget)
@@ -158,7 +236,106 @@ void btBvhTriangleMeshShape::performRaycast(btTriangleCallback* callback, const
 
 	MyNodeOverlapCallback myNodeCallback(callback, m_meshInterface);
 
-	m_bvh->reportRayOverlappingNodex(&myNodeCallback, raySource, rayTarget);
+	if (m_wideBvh)
+	{
+		m_wideBvh->reportRayOverlappingNodex(&myNodeCallback, raySource, rayTarget);
+	}
+	else
+	{
+		m_bvh->reportRayOverlappingNodex(&myNodeCallback, raySource, rayTarget);
+	}
+}
+
+void btBvhTriangleMeshShape::performRaycastPacket(btTriangleCallback** callbacks, const btVector3* raySources, const btVector3* rayTargets, int numRays)
+{
+	struct MyNodeOverlapCallback : public btNodeRayPacketOverlapCallback
+	{
+		btStridingMeshInterface* m_meshInterface;
+		btTriangleCallback** m_callbacks;
+
+		MyNodeOverlapCallback(btTriangleCallback** callbacks, btStridingMeshInterface* meshInterface)
+			: m_meshInterface(meshInterface),
+			  m_callbacks(callbacks)
+		{
+		}
+
+		virtual void processNode(int nodeSubPart, int nodeTriangleIndex, unsigned int rayMask)
+		{
+			btVector3 m_triangle[3];
+			const unsigned char* vertexbase;
+			int numverts;
+			PHY_ScalarType type;
+			int stride;
+			const unsigned char* indexbase;
+			int indexstride;
+			int numfaces;
+			PHY_ScalarType indicestype;
+
+			m_meshInterface->getLockedReadOnlyVertexIndexBase(
+				&vertexbase,
+				numverts,
+				type,
+				stride,
+				&indexbase,
+				indexstride,
+				numfaces,
+				indicestype,
+				nodeSubPart);
+
+			unsigned int* gfxbase = (unsigned int*)(indexbase + nodeTriangleIndex * indexstride);
+
+			const btVector3& meshScaling = m_meshInterface->getScaling();
+			for (int j = 2; j >= 0; j--)
+			{
+				int graphicsindex;
+				switch (indicestype)
+				{
+					case PHY_INTEGER: graphicsindex = gfxbase[j]; break;
+					case PHY_SHORT: graphicsindex = ((unsigned short*)gfxbase)[j]; break;
+					case PHY_UCHAR: graphicsindex = ((unsigned char*)gfxbase)[j]; break;
+					default: btAssert(0);
+				}
+
+				if (type == PHY_FLOAT)
+				{
+					float* graphicsbase = (float*)(vertexbase + graphicsindex * stride);
+
+					m_triangle[j] = btVector3(graphicsbase[0] * meshScaling.getX(), graphicsbase[1] * meshScaling.getY(), graphicsbase[2] * meshScaling.getZ());
+				}
+				else
+				{
+					double* graphicsbase = (double*)(vertexbase + graphicsindex * stride);
+
+					m_triangle[j] = btVector3(btScalar(graphicsbase[0]) * meshScaling.getX(), btScalar(graphicsbase[1]) * meshScaling.getY(), btScalar(graphicsbase[2]) * meshScaling.getZ());
+				}
+			}
+
+			/* Perform ray vs. triangle collision for each ray of the packet that overlaps this node */
+			for (int i = 0; i < BT_RAY_PACKET_SIZE; i++)
+			{
+				if (rayMask & (1u << i))
+				{
+					m_callbacks[i]->processTriangle(m_triangle, nodeSubPart, nodeTriangleIndex);
+				}
+			}
+			m_meshInterface->unLockReadOnlyVertexBase(nodeSubPart);
+		}
+	};
+
+	for (int first = 0; first < numRays; first += BT_RAY_PACKET_SIZE)
+	{
+		const int packetSize = btMin(numRays - first, int(BT_RAY_PACKET_SIZE));
+		MyNodeOverlapCallback myNodeCallback(&callbacks[first], m_meshInterface);
+		const btRayPacket packet(&raySources[first], &rayTargets[first], packetSize);
+		if (m_wideBvh)
+		{
+			m_wideBvh->reportRayPacketOverlappingNodex(&myNodeCallback, packet);
+		}
+		else
+		{
+			m_bvh->reportRayPacketOverlappingNodex(&myNodeCallback, packet);
+		}
+	}
 }
 
 void btBvhTriangleMeshShape::performConvexcast(btTriangleCallback* callback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax)
@@ -232,7 +409,14 @@ void btBvhTriangleMeshShape::performConvexcast(btTriangleCallback* callback, con
 
 	MyNodeOverlapCallback myNodeCallback(callback, m_meshInterface);
 
-	m_bvh->reportBoxCastOverlappingNodex(&myNodeCallback, raySource, rayTarget, aabbMin, aabbMax);
+	if (m_wideBvh)
+	{
+		m_wideBvh->reportBoxCastOverlappingNodex(&myNodeCallback, raySource, rayTarget, aabbMin, aabbMax);
+	}
+	else
+	{
+		m_bvh->reportBoxCastOverlappingNodex(&myNodeCallback, raySource, rayTarget, aabbMin, aabbMax);
+	}
 }
 
 //perform bvh tree traversal and report overlapping triangles to 'callback'
@@ -323,7 +507,14 @@ void btBvhTriangleMeshShape::processAllTriangles(btTriangleCallback* callback, c
 
 	MyNodeOverlapCallback myNodeCallback(callback, m_meshInterface);
 
-	m_bvh->reportAabbOverlappingNodex(&myNodeCallback, aabbMin, aabbMax);
+	if (m_wideBvh)
+	{
+		m_wideBvh->reportAabbOverlappingNodex(&myNodeCallback, aabbMin, aabbMax);
+	}
+	else
+	{
+		m_bvh->reportAabbOverlappingNodex(&myNodeCallback, aabbMin, aabbMax);
+	}
 
 #endif  //DISABLE_BVH
 }
@@ -333,11 +524,18 @@ void btBvhTriangleMeshShape::setLocalScaling(const btVector3& scaling)
 	if ((getLocalScaling() - scaling).length2() > SIMD_EPSILON)
 	{
 		btTriangleMeshShape::setLocalScaling(scaling);
-		buildOptimizedBvh();
+		if (m_wideBvh)
+		{
+			buildWideBvh(m_wideBvh->getMaxLeafSize());
+		}
+		if (m_bvh || !m_wideBvh)
+		{
+			buildOptimizedBvh(m_bvhBuildMode);
+		}
 	}
 }
 
-void btBvhTriangleMeshShape::buildOptimizedBvh()
+void btBvhTriangleMeshShape::buildOptimizedBvh(btQuantizedBvh::btBuildMode buildMode)
 {
 	if (m_ownsBvh)
 	{
@@ -348,8 +546,13 @@ void btBvhTriangleMeshShape::buildOptimizedBvh()
 	void* mem = btAlignedAlloc(sizeof(btOptimizedBvh), 16);
 	m_bvh = new (mem) btOptimizedBvh();
 	//rebuild the bvh...
-	m_bvh->build(m_meshInterface, m_useQuantizedAabbCompression, m_localAabbMin, m_localAabbMax);
+	m_bvh->build(m_meshInterface, m_useQuantizedAabbCompression, m_localAabbMin, m_localAabbMax, buildMode);
+	m_bvhBuildMode = buildMode;
 	m_ownsBvh = true;
+	if (m_refitData)
+	{
+		m_refitData->clear();
+	}
 }
 
 void btBvhTriangleMeshShape::setOptimizedBvh(btOptimizedBvh* bvh, const btVector3& scaling)
@@ -359,6 +562,37 @@ void btBvhTriangleMeshShape::setOptimizedBvh(btOptimizedBvh* bvh, const btVector
 
 	m_bvh = bvh;
 	m_ownsBvh = false;
+	if (m_refitData)
+	{
+		m_refitData->clear();
+	}
+	// update the scaling without rebuilding the bvh
+	if ((getLocalScaling() - scaling).length2() > SIMD_EPSILON)
+	{
+		btTriangleMeshShape::setLocalScaling(scaling);
+	}
+}
+
+void btBvhTriangleMeshShape::buildWideBvh(int maxLeafSize)
+{
+	if (m_ownsWideBvh)
+	{
+		m_wideBvh->~btWideBvh();
+		btAlignedFree(m_wideBvh);
+	}
+	void* mem = btAlignedAlloc(sizeof(btWideBvh), 16);
+	m_wideBvh = new (mem) btWideBvh();
+	m_wideBvh->build(m_meshInterface, m_localAabbMin, m_localAabbMax, maxLeafSize);
+	m_ownsWideBvh = true;
+}
+
+void btBvhTriangleMeshShape::setWideBvh(btWideBvh* wideBvh, const btVector3& scaling)
+{
+	btAssert(!m_wideBvh);
+	btAssert(!m_ownsWideBvh);
+
+	m_wideBvh = wideBvh;
+	m_ownsWideBvh = false;
 	// update the scaling without rebuilding the bvh
 	if ((getLocalScaling() - scaling).length2() > SIMD_EPSILON)
 	{
@@ -18,6 +18,7 @@ subject to the following restrictions:
 
 #include "btTriangleMeshShape.h"
 #include "btOptimizedBvh.h"
+#include "btWideBvh.h"
 #include "LinearMath/btAlignedAllocator.h"
 #include "btTriangleInfoMap.h"
 
@@ -31,18 +32,23 @@ subject to the following restrictions:
 ///It takes a triangle mesh as input, for example a btTriangleMesh or btTriangleIndexVertexArray. The btBvhTriangleMeshShape class allows for triangle mesh deformations by a refit or partialRefit method.
 ///Instead of building the bounding volume hierarchy acceleration structure, it is also possible to serialize (save) and deserialize (load) the structure from disk.
 ///See Demos\ConcaveDemo\ConcavePhysicsDemo.cpp for an example.
+///For large static meshes, buildWideBvh replaces the btOptimizedBvh by a 4-wide, cache line packed btWideBvh for all queries.
 ATTRIBUTE_ALIGNED16(class)
 btBvhTriangleMeshShape : public btTriangleMeshShape
 {
 	btOptimizedBvh* m_bvh;
 	btTriangleInfoMap* m_triangleInfoMap;
+	btWideBvh* m_wideBvh;
+	btOptimizedBvhRefitData* m_refitData;
+	btQuantizedBvh::btBuildMode m_bvhBuildMode;
 
 	bool m_useQuantizedAabbCompression;
 	bool m_ownsBvh;
+	bool m_ownsWideBvh;
 #ifdef __clang__
-	bool m_pad[11] __attribute__((unused));  ////need padding due to alignment
+	bool m_pad[10] __attribute__((unused));  ////need padding due to alignment
 #else
-	bool m_pad[11];  ////need padding due to alignment
+	bool m_pad[10];  ////need padding due to alignment
 #endif
 
 public:
@@ -62,6 +68,9 @@ public:
 
 	void performRaycast(btTriangleCallback * callback, const btVector3& raySource, const btVector3& rayTarget);
 	void performConvexcast(btTriangleCallback * callback, const btVector3& boxSource, const btVector3& boxTarget, const btVector3& boxMin, const btVector3& boxMax);
+	///performRaycastPacket casts a packet of coherent rays with a single bvh traversal (see btRayPacket), in groups of BT_RAY_PACKET_SIZE rays.
+	///callbacks[i] receives the triangles overlapped by ray i, so the result is the same as calling performRaycast for each ray.
+	void performRaycastPacket(btTriangleCallback * *callbacks, const btVector3* raySources, const btVector3* rayTargets, int numRays);
 
 	virtual void processAllTriangles(btTriangleCallback * callback, const btVector3& aabbMin, const btVector3& aabbMax) const;
 
@@ -70,6 +79,17 @@ public:
 	///for a fast incremental refit of parts of the tree. Note: the entire AABB of the tree will become more conservative, it never shrinks
 	void partialRefitTree(const btVector3& aabbMin, const btVector3& aabbMax);
 
+	///refitDirtyTriangles updates the tree for the triangles marked with btStridingMeshInterface::markTriangleDirty, and rebuilds
+	///the subtrees that degraded, see btOptimizedBvh::refitDirtyTriangles. Like partialRefitTree, the AABB of the shape never shrinks.
+	///Pass clearDirtyTriangles = false when the mesh interface is shared with other shapes, and clear it after all of them were refit.
+	void refitDirtyTriangles(bool clearDirtyTriangles = true);
+
+	///the thresholds and statistics of refitDirtyTriangles, 0 before the first call
+	btOptimizedBvhRefitData* getRefitData()
+	{
+		return m_refitData;
+	}
+
 	//debugging
 	virtual const char* getName() const { return "BVHTRIANGLEMESH"; }
 
@@ -82,7 +102,21 @@ public:
 
 	void setOptimizedBvh(btOptimizedBvh * bvh, const btVector3& localScaling = btVector3(1, 1, 1));
 
-	void buildOptimizedBvh();
+	///builds the btOptimizedBvh, setLocalScaling rebuilds it with the same build mode.
+	///To build with the original median split, pass buildBvh = false to the constructor and call buildOptimizedBvh(btQuantizedBvh::BUILD_MEDIAN_SPLIT).
+	void buildOptimizedBvh(btQuantizedBvh::btBuildMode buildMode = btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC);
+
+	///builds a btWideBvh, which is then used for all queries instead of the btOptimizedBvh.
+	///Pass buildBvh = false to the constructor when only the wide bvh is needed.
+	void buildWideBvh(int maxLeafSize = BT_WIDE_BVH_DEFAULT_LEAF_SIZE);
+
+	btWideBvh* getWideBvh()
+	{
+		return m_wideBvh;
+	}
+
+	///uses a btWideBvh that is not owned by the shape, for example one loaded with btWideBvh::deSerializeInPlace
+	void setWideBvh(btWideBvh * wideBvh, const btVector3& localScaling = btVector3(1, 1, 1));
 
 	bool usesQuantizedAabbCompression() const
 	{
@@ -85,22 +85,46 @@ void btCompoundShape::addChildShape(const btTransform& localTransform, btCollisi
 
 void btCompoundShape::updateChildTransform(int childIndex, const btTransform& newChildTransform, bool shouldRecalculateLocalAabb)
 {
-	m_children[childIndex].m_transform = newChildTransform;
+	btCompoundShapeChild& child = m_children[childIndex];
+	btVector3 localAabbMin, localAabbMax;
+
+	//without dynamic aabb tree, the local aabb only needs to be recalculated when the old aabb of the child touched it
+	bool childWasInside = false;
+	if (shouldRecalculateLocalAabb && !m_dynamicAabbTree)
+	{
+		child.m_childShape->getAabb(child.m_transform, localAabbMin, localAabbMax);
+		childWasInside = m_localAabbMin.x() < localAabbMin.x() && m_localAabbMin.y() < localAabbMin.y() && m_localAabbMin.z() < localAabbMin.z() &&
+						 localAabbMax.x() < m_localAabbMax.x() && localAabbMax.y() < m_localAabbMax.y() && localAabbMax.z() < m_localAabbMax.z();
+	}
+
+	child.m_transform = newChildTransform;
+	child.m_childShape->getAabb(newChildTransform, localAabbMin, localAabbMax);
 
 	if (m_dynamicAabbTree)
 	{
 		///update the dynamic aabb tree
-		btVector3 localAabbMin, localAabbMax;
-		m_children[childIndex].m_childShape->getAabb(newChildTransform, localAabbMin, localAabbMax);
 		ATTRIBUTE_ALIGNED16(btDbvtVolume)
 		bounds = btDbvtVolume::FromMM(localAabbMin, localAabbMax);
-		//int index = m_children.size()-1;
-		m_dynamicAabbTree->update(m_children[childIndex].m_node, bounds);
+		m_dynamicAabbTree->update(child.m_node, bounds);
 	}
 
 	if (shouldRecalculateLocalAabb)
 	{
-		recalculateLocalAabb();
+		if (m_dynamicAabbTree)
+		{
+			//the tree refits the volumes of the nodes above the child, so its root is the union of the aabbs of all children
+			m_localAabbMin = m_dynamicAabbTree->m_root->volume.Mins();
+			m_localAabbMax = m_dynamicAabbTree->m_root->volume.Maxs();
+		}
+		else if (childWasInside)
+		{
+			m_localAabbMin.setMin(localAabbMin);
+			m_localAabbMax.setMax(localAabbMax);
+		}
+		else
+		{
+			recalculateLocalAabb();
+		}
 	}
 }
 
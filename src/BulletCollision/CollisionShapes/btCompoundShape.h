@@ -106,7 +106,9 @@ public:
 		return m_children[index].m_transform;
 	}
 
-	///set a new transform for a child, and update internal data structures (local aabb and dynamic tree)
+	///set a new transform for a child, and update internal data structures (local aabb and dynamic tree).
+	///The local aabb is updated from the dynamic tree or from the aabb of the child, without the aabbs of the other children,
+	///so call recalculateLocalAabb after changing the child shapes themselves.
 	void updateChildTransform(int childIndex, const btTransform& newChildTransform, bool shouldRecalculateLocalAabb = true);
 
 	btCompoundShapeChild* getChildList()
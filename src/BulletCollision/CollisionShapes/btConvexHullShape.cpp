@@ -23,11 +23,13 @@ subject to the following restrictions:
 #include "LinearMath/btQuaternion.h"
 #include "LinearMath/btSerializer.h"
 #include "btConvexPolyhedron.h"
+#include "btConvexSupportAccelerator.h"
 #include "LinearMath/btConvexHullComputer.h"
 
 btConvexHullShape ::btConvexHullShape(const btScalar* points, int numPoints, int stride) : btPolyhedralConvexAabbCachingShape()
 {
 	m_shapeType = CONVEX_HULL_SHAPE_PROXYTYPE;
+	m_supportAccelerator = 0;
 	m_unscaledPoints.resize(numPoints);
 
 	unsigned char* pointsAddress = (unsigned char*)points;
@@ -42,6 +44,28 @@ btConvexHullShape ::btConvexHullShape(const btScalar* points, int numPoints, int
 	recalcLocalAabb();
 }
 
+btConvexHullShape::~btConvexHullShape()
+{
+	freeSupportAccelerator();
+}
+
+void btConvexHullShape::initializeSupportAccelerator(int minHillClimbingVertices)
+{
+	freeSupportAccelerator();
+	void* mem = btAlignedAlloc(sizeof(btConvexSupportAccelerator), 16);
+	m_supportAccelerator = new (mem) btConvexSupportAccelerator(getUnscaledPoints(), getNumPoints(), minHillClimbingVertices);
+}
+
+void btConvexHullShape::freeSupportAccelerator()
+{
+	if (m_supportAccelerator)
+	{
+		m_supportAccelerator->~btConvexSupportAccelerator();
+		btAlignedFree(m_supportAccelerator);
+		m_supportAccelerator = 0;
+	}
+}
+
 void btConvexHullShape::setLocalScaling(const btVector3& scaling)
 {
 	m_localScaling = scaling;
@@ -51,6 +75,7 @@ void btConvexHullShape::setLocalScaling(const btVector3& scaling)
 void btConvexHullShape::addPoint(const btVector3& point, bool recalculateLocalAabb)
 {
 	m_unscaledPoints.push_back(point);
+	freeSupportAccelerator();
 	if (recalculateLocalAabb)
 		recalcLocalAabb();
 }
@@ -61,6 +86,11 @@ btVector3 btConvexHullShape::localGetSupportingVertexWithoutMargin(const btVecto
 	btScalar maxDot = btScalar(-BT_LARGE_FLOAT);
 
 	// Here we take advantage of dot(a, b*c) = dot(a*b, c).  Note: This is true mathematically, but not numerically.
+	if (m_supportAccelerator)
+	{
+		return m_supportAccelerator->localGetSupportingVertexWithoutMargin(vec, m_localScaling);
+	}
+
 	if (0 < m_unscaledPoints.size())
 	{
 		btVector3 scaled = vec * m_localScaling;
@@ -73,6 +103,34 @@ btVector3 btConvexHullShape::localGetSupportingVertexWithoutMargin(const btVecto
 
 void btConvexHullShape::batchedUnitVectorGetSupportingVertexWithoutMargin(const btVector3* vectors, btVector3* supportVerticesOut, int numVectors) const
 {
+	if (m_supportAccelerator)
+	{
+		//all directions of a chunk are handled by a single call, so the points are only loaded once per chunk
+		const int chunkSize = 16;
+		btVector3 scaledVectors[chunkSize];
+		int indices[chunkSize];
+		btScalar dots[chunkSize];
+		for (int first = 0; first < numVectors; first += chunkSize)
+		{
+			const int count = btMin(chunkSize, numVectors - first);
+			for (int j = 0; j < count; j++)
+			{
+				scaledVectors[j] = vectors[first + j] * m_localScaling;  // dot(a, b*c) = dot(a*b, c)
+			}
+			m_supportAccelerator->batchedGetSupportingVertexIndices(scaledVectors, count, indices, dots);
+			for (int j = 0; j < count; j++)
+			{
+				supportVerticesOut[first + j][3] = btScalar(-BT_LARGE_FLOAT);
+				if (indices[j] >= 0)
+				{
+					supportVerticesOut[first + j] = m_supportAccelerator->getPoint(indices[j]) * m_localScaling;
+					supportVerticesOut[first + j][3] = dots[j];
+				}
+			}
+		}
+		return;
+	}
+
 	btScalar newDot;
 	//use 'w' component of supportVerticesOut?
 	{
@@ -118,6 +176,7 @@ void btConvexHullShape::optimizeConvexHull()
 	btConvexHullComputer conv;
 	conv.compute(&m_unscaledPoints[0].getX(), sizeof(btVector3), m_unscaledPoints.size(), 0.f, 0.f);
 	int numVerts = conv.vertices.size();
+	freeSupportAccelerator();
 	m_unscaledPoints.resize(0);
 	for (int i = 0; i < numVerts; i++)
 	{
@@ -20,12 +20,17 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"  // for the types
 #include "LinearMath/btAlignedObjectArray.h"
 
+class btConvexSupportAccelerator;
+
 ///The btConvexHullShape implements an implicit convex hull of an array of vertices.
 ///Bullet provides a general and fast collision detector for convex shapes based on GJK and EPA using localGetSupportingVertex.
 ATTRIBUTE_ALIGNED16(class)
 btConvexHullShape : public btPolyhedralConvexAabbCachingShape
 {
 	btAlignedObjectArray<btVector3> m_unscaledPoints;
+	btConvexSupportAccelerator* m_supportAccelerator;
+
+	void freeSupportAccelerator();
 
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
@@ -35,6 +40,18 @@ public:
 	///btConvexHullShape make an internal copy of the points.
 	btConvexHullShape(const btScalar* points = 0, int numPoints = 0, int stride = sizeof(btVector3));
 
+	virtual ~btConvexHullShape();
+
+	///speeds up the support queries of hulls with many vertices with SIMD kernels and, from minHillClimbingVertices vertices on,
+	///with hill climbing over the edges of the hull, see btConvexSupportAccelerator.
+	///Call it after the points are added: addPoint and optimizeConvexHull remove the accelerator.
+	void initializeSupportAccelerator(int minHillClimbingVertices = 128);
+
+	const btConvexSupportAccelerator* getSupportAccelerator() const
+	{
+		return m_supportAccelerator;
+	}
+
 	void addPoint(const btVector3& point, bool recalculateLocalAabb = true);
 
 	btVector3* getUnscaledPoints()
@@ -16,8 +16,32 @@ subject to the following restrictions:
 #include "btConvexPointCloudShape.h"
 #include "BulletCollision/CollisionShapes/btCollisionMargin.h"
 
+#include "btConvexSupportAccelerator.h"
+
 #include "LinearMath/btQuaternion.h"
 
+btConvexPointCloudShape::~btConvexPointCloudShape()
+{
+	freeSupportAccelerator();
+}
+
+void btConvexPointCloudShape::initializeSupportAccelerator(int minHillClimbingVertices)
+{
+	freeSupportAccelerator();
+	void* mem = btAlignedAlloc(sizeof(btConvexSupportAccelerator), 16);
+	m_supportAccelerator = new (mem) btConvexSupportAccelerator(m_unscaledPoints, m_numPoints, minHillClimbingVertices);
+}
+
+void btConvexPointCloudShape::freeSupportAccelerator()
+{
+	if (m_supportAccelerator)
+	{
+		m_supportAccelerator->~btConvexSupportAccelerator();
+		btAlignedFree(m_supportAccelerator);
+		m_supportAccelerator = 0;
+	}
+}
+
 void btConvexPointCloudShape::setLocalScaling(const btVector3& scaling)
 {
 	m_localScaling = scaling;
@@ -42,6 +66,12 @@ btVector3 btConvexPointCloudShape::localGetSupportingVertexWithoutMargin(const b
 		vec *= rlen;
 	}
 
+	if (m_supportAccelerator && m_numPoints > 0)
+	{
+		int index = m_supportAccelerator->getSupportingVertexIndex(vec, maxDot);
+		return getScaledPoint(index);
+	}
+
 	if (m_numPoints > 0)
 	{
 		// Here we take advantage of dot(a*b, c) = dot( a, b*c) to do less work. Note this transformation is true mathematically, not numerically.
@@ -55,6 +85,35 @@ btVector3 btConvexPointCloudShape::localGetSupportingVertexWithoutMargin(const b
 
 void btConvexPointCloudShape::batchedUnitVectorGetSupportingVertexWithoutMargin(const btVector3* vectors, btVector3* supportVerticesOut, int numVectors) const
 {
+	if (m_supportAccelerator)
+	{
+		//all directions of a chunk are handled by a single call, so the points are only loaded once per chunk
+		const int chunkSize = 16;
+		btVector3 scaledVectors[chunkSize];
+		int indices[chunkSize];
+		btScalar dots[chunkSize];
+		for (int first = 0; first < numVectors; first += chunkSize)
+		{
+			const int count = btMin(chunkSize, numVectors - first);
+			for (int j = 0; j < count; j++)
+			{
+				scaledVectors[j] = vectors[first + j] * m_localScaling;  // dot( a*c, b) = dot(a, b*c)
+			}
+			m_supportAccelerator->batchedGetSupportingVertexIndices(scaledVectors, count, indices, dots);
+			for (int j = 0; j < count; j++)
+			{
+				supportVerticesOut[first + j][3] = btScalar(-BT_LARGE_FLOAT);
+				if (0 <= indices[j])
+				{
+					//WARNING: don't swap next lines, the w component would get overwritten!
+					supportVerticesOut[first + j] = getScaledPoint(indices[j]);
+					supportVerticesOut[first + j][3] = dots[j];
+				}
+			}
+		}
+		return;
+	}
+
 	for (int j = 0; j < numVectors; j++)
 	{
 		const btVector3& vec = vectors[j] * m_localScaling;  // dot( a*c, b) = dot(a, b*c)
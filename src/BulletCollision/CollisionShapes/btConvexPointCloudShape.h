@@ -20,12 +20,17 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"  // for the types
 #include "LinearMath/btAlignedObjectArray.h"
 
+class btConvexSupportAccelerator;
+
 ///The btConvexPointCloudShape implements an implicit convex hull of an array of vertices.
 ATTRIBUTE_ALIGNED16(class)
 btConvexPointCloudShape : public btPolyhedralConvexAabbCachingShape
 {
 	btVector3* m_unscaledPoints;
 	int m_numPoints;
+	btConvexSupportAccelerator* m_supportAccelerator;
+
+	void freeSupportAccelerator();
 
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
@@ -36,6 +41,7 @@ public:
 		m_shapeType = CONVEX_POINT_CLOUD_SHAPE_PROXYTYPE;
 		m_unscaledPoints = 0;
 		m_numPoints = 0;
+		m_supportAccelerator = 0;
 	}
 
 	btConvexPointCloudShape(btVector3 * points, int numPoints, const btVector3& localScaling, bool computeAabb = true)
@@ -44,21 +50,34 @@ public:
 		m_shapeType = CONVEX_POINT_CLOUD_SHAPE_PROXYTYPE;
 		m_unscaledPoints = points;
 		m_numPoints = numPoints;
+		m_supportAccelerator = 0;
 
 		if (computeAabb)
 			recalcLocalAabb();
 	}
 
+	virtual ~btConvexPointCloudShape();
+
 	void setPoints(btVector3 * points, int numPoints, bool computeAabb = true, const btVector3& localScaling = btVector3(1.f, 1.f, 1.f))
 	{
 		m_unscaledPoints = points;
 		m_numPoints = numPoints;
 		m_localScaling = localScaling;
+		freeSupportAccelerator();
 
 		if (computeAabb)
 			recalcLocalAabb();
 	}
 
+	///speeds up the support queries of large point clouds, see btConvexHullShape::initializeSupportAccelerator.
+	///The accelerator keeps a copy of the points: call it again after modifying them. setPoints removes the accelerator.
+	void initializeSupportAccelerator(int minHillClimbingVertices = 128);
+
+	const btConvexSupportAccelerator* getSupportAccelerator() const
+	{
+		return m_supportAccelerator;
+	}
+
 	SIMD_FORCE_INLINE btVector3* getUnscaledPoints()
 	{
 		return m_unscaledPoints;
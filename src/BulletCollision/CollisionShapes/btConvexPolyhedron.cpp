@@ -150,6 +150,25 @@ void btConvexPolyhedron::initialize()
 		}
 	}
 
+	m_edges.resize(0);
+	for (int i = 0; i < edges.size(); i++)
+	{
+		const btInternalEdge* edptr = edges.getAtIndex(i);
+		if (edptr->m_face1 < 0)
+		{
+			//open polyhedron, the edge adjacency would miss axes
+			m_edges.resize(0);
+			break;
+		}
+		const btInternalVertexPair vp = edges.getKeyAtIndex(i);
+		btPolyhedronEdge edge;
+		edge.m_vertex0 = vp.m_v0;
+		edge.m_vertex1 = vp.m_v1;
+		edge.m_face0 = edptr->m_face0;
+		edge.m_face1 = edptr->m_face1;
+		m_edges.push_back(edge);
+	}
+
 #ifdef USE_CONNECTED_FACES
 	for (int i = 0; i < m_faces.size(); i++)
 	{
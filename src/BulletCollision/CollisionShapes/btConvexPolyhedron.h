@@ -30,6 +30,15 @@ struct btFace
 	btScalar m_plane[4];
 };
 
+///an edge of a closed btConvexPolyhedron and the two faces that share it
+struct btPolyhedronEdge
+{
+	int m_vertex0;
+	int m_vertex1;
+	int m_face0;
+	int m_face1;
+};
+
 ATTRIBUTE_ALIGNED16(class)
 btConvexPolyhedron
 {
@@ -42,6 +51,8 @@ public:
 	btAlignedObjectArray<btVector3> m_vertices;
 	btAlignedObjectArray<btFace> m_faces;
 	btAlignedObjectArray<btVector3> m_uniqueEdges;
+	///filled by initialize, empty if the polyhedron is not closed; used to prune the edge-edge axes of the separating axis test
+	btAlignedObjectArray<btPolyhedronEdge> m_edges;
 
 	btVector3 m_localCenter;
 	btVector3 m_extents;
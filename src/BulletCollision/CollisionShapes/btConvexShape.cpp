@@ -25,6 +25,7 @@ subject to the following restrictions:
 #include "btCapsuleShape.h"
 #include "btConvexHullShape.h"
 #include "btConvexPointCloudShape.h"
+#include "btConvexSupportAccelerator.h"
 
 ///not supported on IBM SDK, until we fix the alignment of btVector3
 #if defined(__CELLOS_LV2__) && defined(__SPU__)
@@ -280,6 +281,10 @@ btVector3 btConvexShape::localGetSupportVertexWithoutMarginNonVirtual(const btVe
 		case CONVEX_POINT_CLOUD_SHAPE_PROXYTYPE:
 		{
 			btConvexPointCloudShape* convexPointCloudShape = (btConvexPointCloudShape*)this;
+			if (convexPointCloudShape->getSupportAccelerator())
+			{
+				return convexPointCloudShape->getSupportAccelerator()->localGetSupportingVertexWithoutMargin(localDir, convexPointCloudShape->getLocalScalingNV());
+			}
 			btVector3* points = convexPointCloudShape->getUnscaledPoints();
 			int numPoints = convexPointCloudShape->getNumPoints();
 			return convexHullSupport(localDir, points, numPoints, convexPointCloudShape->getLocalScalingNV());
@@ -287,6 +292,10 @@ btVector3 btConvexShape::localGetSupportVertexWithoutMarginNonVirtual(const btVe
 		case CONVEX_HULL_SHAPE_PROXYTYPE:
 		{
 			btConvexHullShape* convexHullShape = (btConvexHullShape*)this;
+			if (convexHullShape->getSupportAccelerator())
+			{
+				return convexHullShape->getSupportAccelerator()->localGetSupportingVertexWithoutMargin(localDir, convexHullShape->getLocalScalingNV());
+			}
 			btVector3* points = convexHullShape->getUnscaledPoints();
 			int numPoints = convexHullShape->getNumPoints();
 			return convexHullSupport(localDir, points, numPoints, convexHullShape->getLocalScalingNV());
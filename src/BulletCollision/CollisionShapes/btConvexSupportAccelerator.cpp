@@ -0,0 +1,399 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btConvexSupportAccelerator.h"
+#include "LinearMath/btConvexHullComputer.h"
+
+typedef int (*btMaxDotSoAFunc)(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3& dir, btScalar& maxDot);
+typedef void (*btBatchedMaxDotSoAFunc)(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3* dirs, int numDirs, int* indicesOut, btScalar* maxDotsOut);
+
+static int btMaxDotSoAScalar(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3& dir, btScalar& maxDot)
+{
+	const btScalar* xs = coords;
+	const btScalar* ys = coords + paddedNumPoints;
+	const btScalar* zs = coords + 2 * paddedNumPoints;
+	maxDot = -SIMD_INFINITY;
+	int result = -1;
+	for (int i = 0; i < numPoints; i++)
+	{
+		btScalar dot = xs[i] * dir.getX() + ys[i] * dir.getY() + zs[i] * dir.getZ();
+		if (dot > maxDot)
+		{
+			maxDot = dot;
+			result = i;
+		}
+	}
+	return result;
+}
+
+static void btBatchedMaxDotSoAScalar(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3* dirs, int numDirs, int* indicesOut, btScalar* maxDotsOut)
+{
+	for (int j = 0; j < numDirs; j++)
+	{
+		indicesOut[j] = btMaxDotSoAScalar(coords, numPoints, paddedNumPoints, dirs[j], maxDotsOut[j]);
+	}
+}
+
+#ifdef BT_ALLOW_AVX2
+
+// Like the maxDot kernels in btVector3.cpp, the AVX2/FMA3 versions are compiled with function target attributes
+// and selected on the first call, so they only need AVX2/FMA3 at runtime.
+
+#include "LinearMath/btCpuFeatureUtility.h"
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BT_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define BT_AVX2_TARGET
+#endif
+
+#ifdef BT_USE_DOUBLE_PRECISION
+
+//4 points per iteration
+BT_AVX2_TARGET static int btMaxDotSoAAvx2(const double* coords, int numPoints, int paddedNumPoints, const btVector3& dir, double& maxDot)
+{
+	(void)numPoints;
+	const double* xs = coords;
+	const double* ys = coords + paddedNumPoints;
+	const double* zs = coords + 2 * paddedNumPoints;
+	const __m256d dx = _mm256_set1_pd(dir.getX());
+	const __m256d dy = _mm256_set1_pd(dir.getY());
+	const __m256d dz = _mm256_set1_pd(dir.getZ());
+	__m256d best = _mm256_set1_pd(-SIMD_INFINITY);
+	__m256d bestIndex = _mm256_set1_pd(-1.0);
+	__m256d index = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+	const __m256d four = _mm256_set1_pd(4.0);
+	for (int i = 0; i < paddedNumPoints; i += 4)
+	{
+		__m256d dot = _mm256_fmadd_pd(_mm256_loadu_pd(zs + i), dz, _mm256_fmadd_pd(_mm256_loadu_pd(ys + i), dy, _mm256_mul_pd(_mm256_loadu_pd(xs + i), dx)));
+		__m256d mask = _mm256_cmp_pd(dot, best, _CMP_GT_OQ);
+		best = _mm256_blendv_pd(best, dot, mask);
+		bestIndex = _mm256_blendv_pd(bestIndex, index, mask);
+		index = _mm256_add_pd(index, four);
+	}
+	double laneDot[4];
+	double laneIndex[4];
+	_mm256_storeu_pd(laneDot, best);
+	_mm256_storeu_pd(laneIndex, bestIndex);
+	maxDot = -SIMD_INFINITY;
+	int result = -1;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		int laneVertex = int(laneIndex[lane]);
+		//the scalar loop returns the first point on ties
+		if (laneVertex >= 0 && (laneDot[lane] > maxDot || (laneDot[lane] == maxDot && laneVertex < result)))
+		{
+			maxDot = laneDot[lane];
+			result = laneVertex;
+		}
+	}
+	return result;
+}
+
+//4 directions per iteration
+BT_AVX2_TARGET static void btBatchedMaxDotSoAAvx2(const double* coords, int numPoints, int paddedNumPoints, const btVector3* dirs, int numDirs, int* indicesOut, double* maxDotsOut)
+{
+	const double* xs = coords;
+	const double* ys = coords + paddedNumPoints;
+	const double* zs = coords + 2 * paddedNumPoints;
+	for (int j = 0; j < numDirs; j += 4)
+	{
+		const int numLanes = btMin(4, numDirs - j);
+		double dirX[4] = {0, 0, 0, 0};
+		double dirY[4] = {0, 0, 0, 0};
+		double dirZ[4] = {0, 0, 0, 0};
+		for (int lane = 0; lane < numLanes; lane++)
+		{
+			dirX[lane] = dirs[j + lane].getX();
+			dirY[lane] = dirs[j + lane].getY();
+			dirZ[lane] = dirs[j + lane].getZ();
+		}
+		const __m256d dx = _mm256_loadu_pd(dirX);
+		const __m256d dy = _mm256_loadu_pd(dirY);
+		const __m256d dz = _mm256_loadu_pd(dirZ);
+		__m256d best = _mm256_set1_pd(-SIMD_INFINITY);
+		__m256d bestIndex = _mm256_set1_pd(-1.0);
+		for (int i = 0; i < numPoints; i++)
+		{
+			__m256d dot = _mm256_fmadd_pd(_mm256_broadcast_sd(zs + i), dz, _mm256_fmadd_pd(_mm256_broadcast_sd(ys + i), dy, _mm256_mul_pd(_mm256_broadcast_sd(xs + i), dx)));
+			__m256d mask = _mm256_cmp_pd(dot, best, _CMP_GT_OQ);
+			best = _mm256_blendv_pd(best, dot, mask);
+			bestIndex = _mm256_blendv_pd(bestIndex, _mm256_set1_pd(double(i)), mask);
+		}
+		double laneDot[4];
+		double laneIndex[4];
+		_mm256_storeu_pd(laneDot, best);
+		_mm256_storeu_pd(laneIndex, bestIndex);
+		for (int lane = 0; lane < numLanes; lane++)
+		{
+			indicesOut[j + lane] = int(laneIndex[lane]);
+			maxDotsOut[j + lane] = laneDot[lane];
+		}
+	}
+}
+
+#else  //BT_USE_DOUBLE_PRECISION
+
+//8 points per iteration
+BT_AVX2_TARGET static int btMaxDotSoAAvx2(const float* coords, int numPoints, int paddedNumPoints, const btVector3& dir, float& maxDot)
+{
+	(void)numPoints;
+	const float* xs = coords;
+	const float* ys = coords + paddedNumPoints;
+	const float* zs = coords + 2 * paddedNumPoints;
+	const __m256 dx = _mm256_set1_ps(dir.getX());
+	const __m256 dy = _mm256_set1_ps(dir.getY());
+	const __m256 dz = _mm256_set1_ps(dir.getZ());
+	__m256 best = _mm256_set1_ps(-SIMD_INFINITY);
+	__m256i bestIndex = _mm256_set1_epi32(-1);
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i eight = _mm256_set1_epi32(8);
+	for (int i = 0; i < paddedNumPoints; i += 8)
+	{
+		__m256 dot = _mm256_fmadd_ps(_mm256_loadu_ps(zs + i), dz, _mm256_fmadd_ps(_mm256_loadu_ps(ys + i), dy, _mm256_mul_ps(_mm256_loadu_ps(xs + i), dx)));
+		__m256 mask = _mm256_cmp_ps(dot, best, _CMP_GT_OQ);
+		best = _mm256_blendv_ps(best, dot, mask);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), mask));
+		index = _mm256_add_epi32(index, eight);
+	}
+	float laneDot[8];
+	int laneIndex[8];
+	_mm256_storeu_ps(laneDot, best);
+	_mm256_storeu_si256((__m256i*)laneIndex, bestIndex);
+	maxDot = -SIMD_INFINITY;
+	int result = -1;
+	for (int lane = 0; lane < 8; lane++)
+	{
+		int laneVertex = laneIndex[lane];
+		//the scalar loop returns the first point on ties
+		if (laneVertex >= 0 && (laneDot[lane] > maxDot || (laneDot[lane] == maxDot && laneVertex < result)))
+		{
+			maxDot = laneDot[lane];
+			result = laneVertex;
+		}
+	}
+	return result;
+}
+
+//8 directions per iteration
+BT_AVX2_TARGET static void btBatchedMaxDotSoAAvx2(const float* coords, int numPoints, int paddedNumPoints, const btVector3* dirs, int numDirs, int* indicesOut, float* maxDotsOut)
+{
+	const float* xs = coords;
+	const float* ys = coords + paddedNumPoints;
+	const float* zs = coords + 2 * paddedNumPoints;
+	for (int j = 0; j < numDirs; j += 8)
+	{
+		const int numLanes = btMin(8, numDirs - j);
+		float dirX[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		float dirY[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		float dirZ[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		for (int lane = 0; lane < numLanes; lane++)
+		{
+			dirX[lane] = dirs[j + lane].getX();
+			dirY[lane] = dirs[j + lane].getY();
+			dirZ[lane] = dirs[j + lane].getZ();
+		}
+		const __m256 dx = _mm256_loadu_ps(dirX);
+		const __m256 dy = _mm256_loadu_ps(dirY);
+		const __m256 dz = _mm256_loadu_ps(dirZ);
+		__m256 best = _mm256_set1_ps(-SIMD_INFINITY);
+		__m256i bestIndex = _mm256_set1_epi32(-1);
+		for (int i = 0; i < numPoints; i++)
+		{
+			__m256 dot = _mm256_fmadd_ps(_mm256_broadcast_ss(zs + i), dz, _mm256_fmadd_ps(_mm256_broadcast_ss(ys + i), dy, _mm256_mul_ps(_mm256_broadcast_ss(xs + i), dx)));
+			__m256 mask = _mm256_cmp_ps(dot, best, _CMP_GT_OQ);
+			best = _mm256_blendv_ps(best, dot, mask);
+			bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(_mm256_set1_epi32(i)), mask));
+		}
+		float laneDot[8];
+		int laneIndex[8];
+		_mm256_storeu_ps(laneDot, best);
+		_mm256_storeu_si256((__m256i*)laneIndex, bestIndex);
+		for (int lane = 0; lane < numLanes; lane++)
+		{
+			indicesOut[j + lane] = laneIndex[lane];
+			maxDotsOut[j + lane] = laneDot[lane];
+		}
+	}
+}
+
+#endif  //BT_USE_DOUBLE_PRECISION
+
+static bool btSupportHasAvx2Fma3()
+{
+	const int required = btCpuFeatureUtility::CPU_FEATURE_AVX2 | btCpuFeatureUtility::CPU_FEATURE_FMA3;
+	return (btCpuFeatureUtility::getCpuFeatures() & required) == required;
+}
+
+static int btMaxDotSoASelect(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3& dir, btScalar& maxDot);
+static void btBatchedMaxDotSoASelect(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3* dirs, int numDirs, int* indicesOut, btScalar* maxDotsOut);
+
+static btMaxDotSoAFunc btMaxDotSoA = btMaxDotSoASelect;
+static btBatchedMaxDotSoAFunc btBatchedMaxDotSoA = btBatchedMaxDotSoASelect;
+
+static int btMaxDotSoASelect(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3& dir, btScalar& maxDot)
+{
+	btMaxDotSoA = btSupportHasAvx2Fma3() ? btMaxDotSoAAvx2 : btMaxDotSoAScalar;
+	return btMaxDotSoA(coords, numPoints, paddedNumPoints, dir, maxDot);
+}
+
+static void btBatchedMaxDotSoASelect(const btScalar* coords, int numPoints, int paddedNumPoints, const btVector3* dirs, int numDirs, int* indicesOut, btScalar* maxDotsOut)
+{
+	btBatchedMaxDotSoA = btSupportHasAvx2Fma3() ? btBatchedMaxDotSoAAvx2 : btBatchedMaxDotSoAScalar;
+	btBatchedMaxDotSoA(coords, numPoints, paddedNumPoints, dirs, numDirs, indicesOut, maxDotsOut);
+}
+
+#else  //BT_ALLOW_AVX2
+
+static btMaxDotSoAFunc btMaxDotSoA = btMaxDotSoAScalar;
+static btBatchedMaxDotSoAFunc btBatchedMaxDotSoA = btBatchedMaxDotSoAScalar;
+
+#endif  //BT_ALLOW_AVX2
+
+btConvexSupportAccelerator::btConvexSupportAccelerator(const btVector3* points, int numPoints, int minHillClimbingVertices)
+	: m_numPoints(numPoints)
+{
+	m_paddedNumPoints = ((numPoints + POINT_PADDING - 1) / POINT_PADDING) * POINT_PADDING;
+	m_coords.resize(3 * m_paddedNumPoints);
+	for (int i = 0; i < m_paddedNumPoints; i++)
+	{
+		//the padding repeats the first point, which wins all ties, so it is never reported
+		const btVector3& point = points[i < numPoints ? i : 0];
+		m_coords[i] = point.getX();
+		m_coords[m_paddedNumPoints + i] = point.getY();
+		m_coords[2 * m_paddedNumPoints + i] = point.getZ();
+	}
+	if (numPoints >= btMax(minHillClimbingVertices, 4))
+	{
+		buildHillClimbingGraph(points);
+	}
+}
+
+void btConvexSupportAccelerator::buildHillClimbingGraph(const btVector3* points)
+{
+	btConvexHullComputer conv;
+	conv.compute(&points[0].getX(), sizeof(btVector3), m_numPoints, 0.f, 0.f);
+	//a flat hull does not enclose a volume, use the brute force search
+	if (conv.faces.size() < 4)
+	{
+		return;
+	}
+
+	//each hull edge is stored in both directions, so the source vertices cover all neighbors
+	m_neighborOffsets.resize(m_numPoints + 1, 0);
+	for (int i = 0; i < conv.edges.size(); i++)
+	{
+		const btConvexHullComputer::Edge& edge = conv.edges[i];
+		int source = conv.original_vertex_index[edge.getSourceVertex()];
+		int target = conv.original_vertex_index[edge.getTargetVertex()];
+		if (source < 0 || target < 0)
+		{
+			m_neighborOffsets.clear();
+			return;
+		}
+		m_neighborOffsets[source + 1]++;
+	}
+	for (int i = 0; i < m_numPoints; i++)
+	{
+		m_neighborOffsets[i + 1] += m_neighborOffsets[i];
+	}
+	m_neighbors.resize(m_neighborOffsets[m_numPoints]);
+	btAlignedObjectArray<int> fill;
+	fill.resize(m_numPoints);
+	for (int i = 0; i < m_numPoints; i++)
+	{
+		fill[i] = m_neighborOffsets[i];
+	}
+	for (int i = 0; i < conv.edges.size(); i++)
+	{
+		const btConvexHullComputer::Edge& edge = conv.edges[i];
+		int source = conv.original_vertex_index[edge.getSourceVertex()];
+		m_neighbors[fill[source]++] = conv.original_vertex_index[edge.getTargetVertex()];
+	}
+
+	//start from the extreme vertices along the axes and the diagonals, the best of them is usually a few steps
+	//away from the support vertex
+	static const btScalar startDirections[14][3] = {
+		{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1}, {-1, 1, 1}, {-1, 1, -1}, {-1, -1, 1}, {-1, -1, -1}};
+	for (int d = 0; d < 14; d++)
+	{
+		btVector3 dir(startDirections[d][0], startDirections[d][1], startDirections[d][2]);
+		btScalar maxDot;
+		int vertex = btMaxDotSoAScalar(&m_coords[0], m_numPoints, m_paddedNumPoints, dir, maxDot);
+		if (m_neighborOffsets[vertex + 1] > m_neighborOffsets[vertex] && m_startVertices.findLinearSearch(vertex) == m_startVertices.size())
+		{
+			m_startVertices.push_back(vertex);
+		}
+	}
+}
+
+int btConvexSupportAccelerator::getSupportingVertexIndex(const btVector3& dir, btScalar& maxDot) const
+{
+	if (m_numPoints == 0)
+	{
+		maxDot = -SIMD_INFINITY;
+		return -1;
+	}
+	if (!usesHillClimbing())
+	{
+		return btMaxDotSoA(&m_coords[0], m_numPoints, m_paddedNumPoints, dir, maxDot);
+	}
+
+	int best = m_startVertices[0];
+	btScalar bestDot = dot(best, dir);
+	for (int i = 1; i < m_startVertices.size(); i++)
+	{
+		btScalar d = dot(m_startVertices[i], dir);
+		if (d > bestDot)
+		{
+			bestDot = d;
+			best = m_startVertices[i];
+		}
+	}
+	//move to the best neighbor until no neighbor improves, the dot product grows strictly so this terminates
+	int current = -1;
+	while (current != best)
+	{
+		current = best;
+		const int end = m_neighborOffsets[current + 1];
+		for (int j = m_neighborOffsets[current]; j < end; j++)
+		{
+			const int neighbor = m_neighbors[j];
+			btScalar d = dot(neighbor, dir);
+			if (d > bestDot)
+			{
+				bestDot = d;
+				best = neighbor;
+			}
+		}
+	}
+	maxDot = bestDot;
+	return best;
+}
+
+void btConvexSupportAccelerator::batchedGetSupportingVertexIndices(const btVector3* dirs, int numDirs, int* indicesOut, btScalar* maxDotsOut) const
+{
+	//a register of directions only pays off when it is mostly filled
+	if (usesHillClimbing() || m_numPoints == 0 || numDirs < 4)
+	{
+		for (int j = 0; j < numDirs; j++)
+		{
+			indicesOut[j] = getSupportingVertexIndex(dirs[j], maxDotsOut[j]);
+		}
+		return;
+	}
+	btBatchedMaxDotSoA(&m_coords[0], m_numPoints, m_paddedNumPoints, dirs, numDirs, indicesOut, maxDotsOut);
+}
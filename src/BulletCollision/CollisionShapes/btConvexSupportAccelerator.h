@@ -0,0 +1,99 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CONVEX_SUPPORT_ACCELERATOR_H
+#define BT_CONVEX_SUPPORT_ACCELERATOR_H
+
+#include "LinearMath/btVector3.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+///btConvexSupportAccelerator speeds up the support mapping of a point set, see btConvexHullShape::initializeSupportAccelerator.
+///
+///The points are stored in structure-of-arrays layout (all x, then all y, then all z), so the max-dot kernels
+///(AVX2/FMA3 when available at runtime, scalar otherwise) load full registers of a single coordinate without shuffles.
+///Batched queries process several directions per register, so every point is loaded once per group of directions.
+///
+///For larger point sets the edges of the convex hull are stored as an adjacency graph, and a support query starts at
+///the best of a few precomputed extreme vertices and climbs to neighbors with a larger dot product until none is left.
+///A linear function has no local maximum on the vertex graph of a convex polytope other than the global one,
+///so the result is exact, up to ties, after visiting only a small part of the vertices.
+///
+///The accelerator keeps its own copy of the points: it has to be rebuilt when the points change.
+///Queries are read-only, so a shared shape can be queried from several threads.
+ATTRIBUTE_ALIGNED16(class)
+btConvexSupportAccelerator
+{
+	enum
+	{
+		POINT_PADDING = 8
+	};
+
+	int m_numPoints;
+	int m_paddedNumPoints;                   // multiple of POINT_PADDING, the padding repeats the first point
+	btAlignedObjectArray<btScalar> m_coords;  // x block, y block, z block of m_paddedNumPoints each
+
+	//hill climbing, empty when the point set is too small or flat
+	btAlignedObjectArray<int> m_neighborOffsets;  // m_numPoints+1 offsets into m_neighbors
+	btAlignedObjectArray<int> m_neighbors;
+	btAlignedObjectArray<int> m_startVertices;
+
+	void buildHillClimbingGraph(const btVector3* points);
+
+	btScalar dot(int vertex, const btVector3& dir) const
+	{
+		return m_coords[vertex] * dir.getX() + m_coords[m_paddedNumPoints + vertex] * dir.getY() + m_coords[2 * m_paddedNumPoints + vertex] * dir.getZ();
+	}
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	///hill climbing is used for point sets with at least minHillClimbingVertices points
+	btConvexSupportAccelerator(const btVector3* points, int numPoints, int minHillClimbingVertices = 128);
+
+	///returns the index of the point with the largest dot product with dir, or -1 if there are no points
+	int getSupportingVertexIndex(const btVector3& dir, btScalar& maxDot) const;
+
+	///same as getSupportingVertexIndex for each direction
+	void batchedGetSupportingVertexIndices(const btVector3* dirs, int numDirs, int* indicesOut, btScalar* maxDotsOut) const;
+
+	///support vertex of the scaled points in the direction localDir
+	btVector3 localGetSupportingVertexWithoutMargin(const btVector3& localDir, const btVector3& localScaling) const
+	{
+		btScalar maxDot;
+		int index = getSupportingVertexIndex(localDir * localScaling, maxDot);
+		if (index < 0)
+		{
+			return btVector3(btScalar(0.), btScalar(0.), btScalar(0.));
+		}
+		return getPoint(index) * localScaling;
+	}
+
+	btVector3 getPoint(int index) const
+	{
+		return btVector3(m_coords[index], m_coords[m_paddedNumPoints + index], m_coords[2 * m_paddedNumPoints + index]);
+	}
+
+	int getNumPoints() const
+	{
+		return m_numPoints;
+	}
+
+	bool usesHillClimbing() const
+	{
+		return m_startVertices.size() > 0;
+	}
+};
+
+#endif  //BT_CONVEX_SUPPORT_ACCELERATOR_H
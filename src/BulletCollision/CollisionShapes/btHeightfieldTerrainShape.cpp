@@ -16,6 +16,7 @@ subject to the following restrictions:
 #include "btHeightfieldTerrainShape.h"
 
 #include "LinearMath/btTransformUtil.h"
+#include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 
 btHeightfieldTerrainShape::btHeightfieldTerrainShape(
 	int heightStickWidth, int heightStickLength, const void* heightfieldData,
@@ -76,6 +77,7 @@ void btHeightfieldTerrainShape::initialize(
 	m_useDiamondSubdivision = false;
 	m_useZigzagSubdivision = false;
 	m_flipTriangleWinding = false;
+	m_useTriangleIdsInRaycast = false;
 	m_upAxis = upAxis;
 	m_localScaling.setValue(btScalar(1.), btScalar(1.), btScalar(1.));
 	
@@ -252,14 +254,13 @@ void btHeightfieldTerrainShape::quantizeWithClamp(int* out, const btVector3& poi
 	out[2] = getQuantized(clampedPoint.getZ());
 }
 
-/// process all triangles within the provided axis-aligned bounding box
+/// computes the range of grid cells and the range of raw heights overlapped by a local aabb
 /**
   basic algorithm:
     - convert input aabb to local coordinates (scale down and shift for local origin)
     - convert input aabb to a range of heightfield grid points (quantize)
-    - iterate over all triangles in that subset of the grid
  */
-void btHeightfieldTerrainShape::processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const
+bool btHeightfieldTerrainShape::getCellRange(const btVector3& aabbMin, const btVector3& aabbMax, CellRange& range) const
 {
 	// scale down the input aabb's so they are in local (non-scaled) coordinates
 	btVector3 localAabbMin = aabbMin * btVector3(1.f / m_localScaling[0], 1.f / m_localScaling[1], 1.f / m_localScaling[2]);
@@ -333,48 +334,111 @@ void btHeightfieldTerrainShape::processAllTriangles(btTriangleCallback* callback
 		}
 	}
 
-	// TODO If m_vboundsGrid is available, use it to determine if we really need to process this area
+	range.m_startX = startX;
+	range.m_endX = endX;
+	range.m_startZ = startJ;
+	range.m_endZ = endJ;
 
-	for (int j = startJ; j < endJ; j++)
+	// the raw height range, the scaling along the up axis may be negative
+	btScalar minHeight = localAabbMin[m_upAxis];
+	btScalar maxHeight = localAabbMax[m_upAxis];
+	if (minHeight > maxHeight)
 	{
-		for (int x = startX; x < endX; x++)
-		{
-			btVector3 vertices[3];
-			int indices[3] = { 0, 1, 2 };
-			if (m_flipTriangleWinding)
-			{
-				indices[0] = 2;
-				indices[2] = 0;
-			}
+		btSwap(minHeight, maxHeight);
+	}
+	// keep the triangles that only touch the aabb, in spite of the rounding of the scaling
+	const btScalar heightEpsilon = btScalar(1e-4) * (btFabs(m_minHeight) + btFabs(m_maxHeight) + btScalar(1.));
+	range.m_minHeight = minHeight - heightEpsilon;
+	range.m_maxHeight = maxHeight + heightEpsilon;
 
-			if (m_flipQuadEdges || (m_useDiamondSubdivision && !((j + x) & 1)) || (m_useZigzagSubdivision && !(j & 1)))
-			{
-				//first triangle
-				getVertex(x, j, vertices[indices[0]]);
-				getVertex(x, j + 1, vertices[indices[1]]);
-				getVertex(x + 1, j + 1, vertices[indices[2]]);
-				callback->processTriangle(vertices, 2 * x, j);
-				//second triangle
-				//  getVertex(x,j,vertices[0]);//already got this vertex before, thanks to Danny Chapman
-				getVertex(x + 1, j + 1, vertices[indices[1]]);
-				getVertex(x + 1, j, vertices[indices[2]]);
-				callback->processTriangle(vertices, 2 * x+1, j);
-			}
-			else
-			{
-				//first triangle
-				getVertex(x, j, vertices[indices[0]]);
-				getVertex(x, j + 1, vertices[indices[1]]);
-				getVertex(x + 1, j, vertices[indices[2]]);
-				callback->processTriangle(vertices, 2 * x, j);
-				//second triangle
-				getVertex(x + 1, j, vertices[indices[0]]);
-				//getVertex(x,j+1,vertices[1]);
-				getVertex(x + 1, j + 1, vertices[indices[2]]);
-				callback->processTriangle(vertices, 2 * x+1, j);
-			}
+	return startX < endX && startJ < endJ;
+}
+
+void btHeightfieldTerrainShape::getCellTriangles(int x, int z, btVector3 triangles[2][3]) const
+{
+	int indices[3] = {0, 1, 2};
+	if (m_flipTriangleWinding)
+	{
+		indices[0] = 2;
+		indices[2] = 0;
+	}
+
+	if (m_flipQuadEdges || (m_useDiamondSubdivision && !((z + x) & 1)) || (m_useZigzagSubdivision && !(z & 1)))
+	{
+		//first triangle
+		getVertex(x, z, triangles[0][indices[0]]);
+		getVertex(x, z + 1, triangles[0][indices[1]]);
+		getVertex(x + 1, z + 1, triangles[0][indices[2]]);
+		//second triangle
+		triangles[1][indices[0]] = triangles[0][indices[0]];
+		triangles[1][indices[1]] = triangles[0][indices[2]];
+		getVertex(x + 1, z, triangles[1][indices[2]]);
+	}
+	else
+	{
+		//first triangle
+		getVertex(x, z, triangles[0][indices[0]]);
+		getVertex(x, z + 1, triangles[0][indices[1]]);
+		getVertex(x + 1, z, triangles[0][indices[2]]);
+		//second triangle
+		triangles[1][indices[0]] = triangles[0][indices[2]];
+		triangles[1][indices[1]] = triangles[0][indices[1]];
+		getVertex(x + 1, z + 1, triangles[1][indices[2]]);
+	}
+}
+
+void btHeightfieldTerrainShape::getCellHeightRange(int x, int z, Range& range) const
+{
+	const btScalar h00 = getRawHeightFieldValue(x, z);
+	const btScalar h10 = getRawHeightFieldValue(x + 1, z);
+	const btScalar h01 = getRawHeightFieldValue(x, z + 1);
+	const btScalar h11 = getRawHeightFieldValue(x + 1, z + 1);
+	range.min = btMin(btMin(h00, h10), btMin(h01, h11));
+	range.max = btMax(btMax(h00, h10), btMax(h01, h11));
+}
+
+struct ProcessTrianglesAction
+{
+	const btHeightfieldTerrainShape* shape;
+	int width;
+	int length;
+	btTriangleCallback* callback;
+	// the legacy raycast ids: both triangles of the cell with partId x
+	bool useCellIds;
+
+	void exec(int x, int z) const
+	{
+		if (x < 0 || z < 0 || x >= width || z >= length)
+		{
+			return;
 		}
+
+		btVector3 triangles[2][3];
+		shape->getCellTriangles(x, z, triangles);
+		callback->processTriangle(triangles[0], useCellIds ? x : 2 * x, z);
+		callback->processTriangle(triangles[1], useCellIds ? x : 2 * x + 1, z);
+	}
+
+	void operator()(int x, int z) const
+	{
+		exec(x, z);
 	}
+};
+
+/// process all triangles within the provided axis-aligned bounding box
+/**
+  iterates over all triangles of the grid cells in getCellRange, skipping
+  the cells above or below the aabb when the accelerator is built
+ */
+void btHeightfieldTerrainShape::processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	ProcessTrianglesAction processTriangles;
+	processTriangles.shape = this;
+	processTriangles.callback = callback;
+	processTriangles.useCellIds = false;
+	processTriangles.width = m_heightStickWidth - 1;
+	processTriangles.length = m_heightStickLength - 1;
+	processAllCells(processTriangles, aabbMin, aabbMax);
 }
 
 void btHeightfieldTerrainShape::calculateLocalInertia(btScalar, btVector3& inertia) const
@@ -548,134 +612,311 @@ void gridRaycast(Action_T& quadAction, const btVector3& beginPos, const btVector
 	}
 }
 
-struct ProcessTrianglesAction
+struct ProcessGridCellAction
 {
-	const btHeightfieldTerrainShape* shape;
-	bool flipQuadEdges;
-	bool useDiamondSubdivision;
-	int width;
-	int length;
-	btTriangleCallback* callback;
+	ProcessTrianglesAction processTriangles;
 
-	void exec(int x, int z) const
+	void operator()(const GridRaycastState& rs) const
 	{
-		if (x < 0 || z < 0 || x >= width || z >= length)
+		processTriangles.exec(rs.prev_x, rs.prev_z);
+	}
+};
+
+namespace
+{
+	/// A ray or a swept box in the raw (unscaled, not centered) space of the heightfield,
+	/// see btHeightfieldTerrainShape::performCast
+	struct HeightfieldCast
+	{
+		const btHeightfieldTerrainShape* shape;
+		int indices[3];  // grid x, up and grid z axes of the raw space
+		btVector3 begin;
+		btVector3 end;
+		// the swept box relative to its center, zero for a ray
+		btVector3 extentMin;
+		btVector3 extentMax;
+		bool isRay;
+		// slack of the cast parameter, so that no cell is lost between two chunks
+		btScalar paramSlack;
+		// the closest hit fraction of the callback, if it has one
+		const btScalar* hitFraction;
+		ProcessTrianglesAction processTriangles;
+
+		btScalar getMaxFraction() const
 		{
-			return;
+			return (hitFraction && *hitFraction < btScalar(1.)) ? *hitFraction : btScalar(1.);
 		}
+	};
 
-		btVector3 vertices[3];
-
-		// TODO Since this is for raycasts, we could greatly benefit from an early exit on the first hit
+	struct ProcessChunkCellAction
+	{
+		const ProcessTrianglesAction* processTriangles;
+		int startX;
+		int endX;
+		int startZ;
+		int endZ;
 
-		// Check quad
-		if (flipQuadEdges || (useDiamondSubdivision && (((z + x) & 1) > 0)))
+		void operator()(const GridRaycastState& rs) const
 		{
-			// First triangle
-			shape->getVertex(x, z, vertices[0]);
-			shape->getVertex(x + 1, z, vertices[1]);
-			shape->getVertex(x + 1, z + 1, vertices[2]);
-			callback->processTriangle(vertices, x, z);
+			if (rs.prev_x >= startX && rs.prev_x < endX && rs.prev_z >= startZ && rs.prev_z < endZ)
+			{
+				processTriangles->exec(rs.prev_x, rs.prev_z);
+			}
+		}
+	};
+}
 
-			// Second triangle
-			shape->getVertex(x, z, vertices[0]);
-			shape->getVertex(x + 1, z + 1, vertices[1]);
-			shape->getVertex(x, z + 1, vertices[2]);
-			callback->processTriangle(vertices, x, z);
+/// Clips the cast against a box, expanded by the extents of the swept box.
+/// On input, [tEnter, tExit] is the parameter range to clip.
+static bool clipHeightfieldCast(const HeightfieldCast& cast, const btVector3& boxMin, const btVector3& boxMax, btScalar& tEnter, btScalar& tExit)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		const btScalar lo = boxMin[i] - cast.extentMax[i];
+		const btScalar hi = boxMax[i] - cast.extentMin[i];
+		const btScalar delta = cast.end[i] - cast.begin[i];
+		if (delta == btScalar(0.))
+		{
+			if (cast.begin[i] < lo || cast.begin[i] > hi)
+			{
+				return false;
+			}
+			continue;
 		}
-		else
+		const btScalar invDelta = btScalar(1.) / delta;
+		btScalar t0 = (lo - cast.begin[i]) * invDelta;
+		btScalar t1 = (hi - cast.begin[i]) * invDelta;
+		if (t0 > t1)
+		{
+			btSwap(t0, t1);
+		}
+		tEnter = btMax(tEnter, t0);
+		tExit = btMin(tExit, t1);
+		if (tEnter > tExit)
 		{
-			// First triangle
-			shape->getVertex(x, z, vertices[0]);
-			shape->getVertex(x, z + 1, vertices[1]);
-			shape->getVertex(x + 1, z, vertices[2]);
-			callback->processTriangle(vertices, x, z);
+			return false;
+		}
+	}
+	return true;
+}
 
-			// Second triangle
-			shape->getVertex(x + 1, z, vertices[0]);
-			shape->getVertex(x, z + 1, vertices[1]);
-			shape->getVertex(x + 1, z + 1, vertices[2]);
-			callback->processTriangle(vertices, x, z);
+/// Processes the cells of the chunk [startX, endX) x [startZ, endZ) hit by the cast between tEnter and tExit.
+/// Rays walk the cells with gridRaycast, swept boxes test the height range of each cell of their footprint.
+static void castHeightfieldChunk(const HeightfieldCast& cast, int startX, int endX, int startZ, int endZ, btScalar tEnter, btScalar tExit)
+{
+	tEnter = btMax(tEnter - cast.paramSlack, btScalar(0.));
+	tExit = btMin(tExit + cast.paramSlack, btScalar(1.));
+	const btVector3 enterPos = cast.begin.lerp(cast.end, tEnter);
+	const btVector3 exitPos = cast.begin.lerp(cast.end, tExit);
+	const int ix = cast.indices[0];
+	const int iy = cast.indices[1];
+	const int iz = cast.indices[2];
+
+	if (cast.isRay)
+	{
+		ProcessChunkCellAction processCells;
+		processCells.processTriangles = &cast.processTriangles;
+		processCells.startX = startX;
+		processCells.endX = endX;
+		processCells.startZ = startZ;
+		processCells.endZ = endZ;
+
+		if (enterPos.distance2(exitPos) < btScalar(0.0001 * 0.0001))
+		{
+			// gridRaycast ignores such a short segment
+			GridRaycastState rs;
+			rs.prev_x = static_cast<int>(floor(enterPos[ix]));
+			rs.prev_z = static_cast<int>(floor(enterPos[iz]));
+			processCells(rs);
+			return;
 		}
+		int indices[3] = {ix, iy, iz};
+		gridRaycast(processCells, enterPos, exitPos, indices);
+		return;
 	}
 
-	void operator()(const GridRaycastState& bs) const
+	btVector3 footprintMin = enterPos;
+	btVector3 footprintMax = enterPos;
+	footprintMin.setMin(exitPos);
+	footprintMax.setMax(exitPos);
+	footprintMin += cast.extentMin;
+	footprintMax += cast.extentMax;
+	const int cellStartX = btMax(startX, static_cast<int>(floor(footprintMin[ix])));
+	const int cellEndX = btMin(endX, static_cast<int>(floor(footprintMax[ix])) + 1);
+	const int cellStartZ = btMax(startZ, static_cast<int>(floor(footprintMin[iz])));
+	const int cellEndZ = btMin(endZ, static_cast<int>(floor(footprintMax[iz])) + 1);
+
+	for (int z = cellStartZ; z < cellEndZ; z++)
 	{
-		exec(bs.prev_x, bs.prev_z);
+		for (int x = cellStartX; x < cellEndX; x++)
+		{
+			btHeightfieldTerrainShape::Range cellRange;
+			cast.shape->getCellHeightRange(x, z, cellRange);
+			btVector3 cellMin;
+			btVector3 cellMax;
+			cellMin[ix] = btScalar(x);
+			cellMax[ix] = btScalar(x + 1);
+			cellMin[iy] = cellRange.min;
+			cellMax[iy] = cellRange.max;
+			cellMin[iz] = btScalar(z);
+			cellMax[iz] = btScalar(z + 1);
+			btScalar tCellEnter = btScalar(0.);
+			btScalar tCellExit = cast.getMaxFraction();
+			if (clipHeightfieldCast(cast, cellMin, cellMax, tCellEnter, tCellExit))
+			{
+				cast.processTriangles.exec(x, z);
+			}
+		}
 	}
-};
+}
 
-struct ProcessVBoundsAction
+/// Descends the min/max pyramid, visiting the children of a node in the order of the cast direction,
+/// so that the nodes beyond the closest hit found so far are skipped.
+static void castHeightfieldVBoundsNode(const HeightfieldCast& cast, int level, int cx, int cz)
 {
-	const btAlignedObjectArray<btHeightfieldTerrainShape::Range>& vbounds;
-	int width;
-	int length;
-	int chunkSize;
-
-	btVector3 rayBegin;
-	btVector3 rayEnd;
-	btVector3 rayDir;
-
-	int* m_indices;
-	ProcessTrianglesAction processTriangles;
-
-	ProcessVBoundsAction(const btAlignedObjectArray<btHeightfieldTerrainShape::Range>& bnd, int* indices)
-		: vbounds(bnd),
-		m_indices(indices)
+	const btHeightfieldTerrainShape* shape = cast.shape;
+	const int numCellsX = shape->getHeightStickWidth() - 1;
+	const int numCellsZ = shape->getHeightStickLength() - 1;
+	const int nodeSize = shape->getVBoundsChunkSize() << level;
+	const int x0 = cx * nodeSize;
+	const int z0 = cz * nodeSize;
+	if (x0 >= numCellsX || z0 >= numCellsZ)
 	{
+		return;
 	}
-	void operator()(const GridRaycastState& rs) const
+	const int x1 = btMin(x0 + nodeSize, numCellsX);
+	const int z1 = btMin(z0 + nodeSize, numCellsZ);
+
+	const btHeightfieldTerrainShape::Range& bounds = shape->getVBounds(level, cx, cz);
+	btVector3 nodeMin;
+	btVector3 nodeMax;
+	nodeMin[cast.indices[0]] = btScalar(x0);
+	nodeMax[cast.indices[0]] = btScalar(x1);
+	nodeMin[cast.indices[1]] = bounds.min;
+	nodeMax[cast.indices[1]] = bounds.max;
+	nodeMin[cast.indices[2]] = btScalar(z0);
+	nodeMax[cast.indices[2]] = btScalar(z1);
+	btScalar tEnter = btScalar(0.);
+	btScalar tExit = cast.getMaxFraction();
+	if (!clipHeightfieldCast(cast, nodeMin, nodeMax, tEnter, tExit))
 	{
-		int x = rs.prev_x;
-		int z = rs.prev_z;
+		return;
+	}
 
-		if (x < 0 || z < 0 || x >= width || z >= length)
+	if (level == 0)
+	{
+		castHeightfieldChunk(cast, x0, x1, z0, z1, tEnter, tExit);
+		return;
+	}
+
+	const btHeightfieldTerrainShape::VBoundsLevel& childLevel = shape->getVBoundsLevel(level - 1);
+	const int flipX = cast.end[cast.indices[0]] < cast.begin[cast.indices[0]] ? 1 : 0;
+	const int flipZ = cast.end[cast.indices[2]] < cast.begin[cast.indices[2]] ? 1 : 0;
+	for (int j = 0; j < 2; j++)
+	{
+		const int czChild = 2 * cz + (j ^ flipZ);
+		if (czChild >= childLevel.m_length)
 		{
-			return;
+			continue;
 		}
-
-		const btHeightfieldTerrainShape::Range chunk = vbounds[x + z * width];
-
-		btVector3 enterPos;
-		btVector3 exitPos;
-
-		if (rs.maxDistanceFlat > 0.0001)
+		for (int i = 0; i < 2; i++)
 		{
-			btScalar flatTo3d = chunkSize * rs.maxDistance3d / rs.maxDistanceFlat;
-			btScalar enterParam3d = rs.prevParam * flatTo3d;
-			btScalar exitParam3d = rs.param * flatTo3d;
-			enterPos = rayBegin + rayDir * enterParam3d;
-			exitPos = rayBegin + rayDir * exitParam3d;
-
-			// We did enter the flat projection of the AABB,
-			// but we have to check if we intersect it on the vertical axis
-			if (enterPos[1] > chunk.max && exitPos[m_indices[1]] > chunk.max)
+			const int cxChild = 2 * cx + (i ^ flipX);
+			if (cxChild < childLevel.m_width)
 			{
-				return;
+				castHeightfieldVBoundsNode(cast, level - 1, cxChild, czChild);
 			}
-			if (enterPos[1] < chunk.min && exitPos[m_indices[1]] < chunk.min)
-			{
-				return;
-			}
-		}
-		else
-		{
-			// Consider the ray vertical
-			// (though we shouldn't reach this often because there is an early check up-front)
-			enterPos = rayBegin;
-			exitPos = rayEnd;
 		}
-
-		gridRaycast(processTriangles, enterPos, exitPos, m_indices);
-		// Note: it could be possible to have more than one grid at different levels,
-		// to do this there would be a branch using a pointer to another ProcessVBoundsAction
 	}
-};
+}
 
-// TODO How do I interrupt the ray when there is a hit? `callback` does not return any result
-/// Performs a raycast using a hierarchical Bresenham algorithm.
+/// Performs a raycast, descending the min/max pyramid when the accelerator is built
+/// and using a Bresenham algorithm within the chunks.
 /// Does not allocate any memory by itself.
 void btHeightfieldTerrainShape::performRaycast(btTriangleCallback* callback, const btVector3& raySource, const btVector3& rayTarget) const
+{
+	performCast(callback, 0, raySource, rayTarget, 0, 0);
+}
+
+void btHeightfieldTerrainShape::performRaycast(btTriangleRaycastCallback* callback, const btVector3& raySource, const btVector3& rayTarget) const
+{
+	performCast(callback, &callback->m_hitFraction, raySource, rayTarget, 0, 0);
+}
+
+void btHeightfieldTerrainShape::performConvexcast(btTriangleCallback* callback, const btVector3& boxSource, const btVector3& boxTarget, const btVector3& boxMin, const btVector3& boxMax) const
+{
+	performCast(callback, 0, boxSource, boxTarget, &boxMin, &boxMax);
+}
+
+void btHeightfieldTerrainShape::performConvexcast(btTriangleConvexcastCallback* callback, const btVector3& boxSource, const btVector3& boxTarget, const btVector3& boxMin, const btVector3& boxMax) const
+{
+	performCast(callback, &callback->m_hitFraction, boxSource, boxTarget, &boxMin, &boxMax);
+}
+
+void btHeightfieldTerrainShape::performCast(btTriangleCallback* callback, const btScalar* hitFraction, const btVector3& source, const btVector3& target, const btVector3* boxMin, const btVector3* boxMax) const
+{
+	if (!boxMin && m_vboundsLevels.size() == 0)
+	{
+		performGridRaycast(callback, source, target);
+		return;
+	}
+	if (m_vboundsLevels.size() == 0)
+	{
+		// Process the triangles overlapping the swept box
+		const btVector3 margin(getMargin(), getMargin(), getMargin());
+		btVector3 sweptMin = source;
+		btVector3 sweptMax = source;
+		sweptMin.setMin(target);
+		sweptMax.setMax(target);
+		processAllTriangles(callback, sweptMin + *boxMin - margin, sweptMax + *boxMax + margin);
+		return;
+	}
+
+	HeightfieldCast cast;
+	cast.shape = this;
+	cast.indices[0] = m_upAxis == 0 ? 1 : 0;
+	cast.indices[1] = m_upAxis;
+	cast.indices[2] = m_upAxis == 2 ? 1 : 2;
+	// Transform to cell-local
+	cast.begin = source / m_localScaling + m_localOrigin;
+	cast.end = target / m_localScaling + m_localOrigin;
+	cast.isRay = boxMin == 0;
+	if (cast.isRay)
+	{
+		cast.extentMin.setZero();
+		cast.extentMax.setZero();
+	}
+	else
+	{
+		// the triangles have the margin of the heightfield, and the scaling may be negative
+		const btVector3 margin(getMargin(), getMargin(), getMargin());
+		cast.extentMin = (*boxMin - margin) / m_localScaling;
+		cast.extentMax = (*boxMax + margin) / m_localScaling;
+		const btVector3 extent0 = cast.extentMin;
+		cast.extentMin.setMin(cast.extentMax);
+		cast.extentMax.setMax(extent0);
+	}
+	const btScalar length = cast.begin.distance(cast.end);
+	cast.paramSlack = length > btScalar(0.01) ? btScalar(0.01) / length : btScalar(1.);
+	cast.hitFraction = hitFraction;
+	cast.processTriangles.shape = this;
+	cast.processTriangles.callback = callback;
+	cast.processTriangles.useCellIds = cast.isRay && !m_useTriangleIdsInRaycast;
+	cast.processTriangles.width = m_heightStickWidth - 1;
+	cast.processTriangles.length = m_heightStickLength - 1;
+
+	const int top = m_vboundsLevels.size() - 1;
+	for (int cz = 0; cz < m_vboundsLevels[top].m_length; cz++)
+	{
+		for (int cx = 0; cx < m_vboundsLevels[top].m_width; cx++)
+		{
+			castHeightfieldVBoundsNode(cast, top, cx, cz);
+		}
+	}
+}
+
+/// Walks the cells under the ray, without accelerator
+void btHeightfieldTerrainShape::performGridRaycast(btTriangleCallback* callback, const btVector3& raySource, const btVector3& rayTarget) const
 {
 	// Transform to cell-local
 	btVector3 beginPos = raySource / m_localScaling;
@@ -683,17 +924,20 @@ void btHeightfieldTerrainShape::performRaycast(btTriangleCallback* callback, con
 	beginPos += m_localOrigin;
 	endPos += m_localOrigin;
 
-	ProcessTrianglesAction processTriangles;
-	processTriangles.shape = this;
-	processTriangles.flipQuadEdges = m_flipQuadEdges;
-	processTriangles.useDiamondSubdivision = m_useDiamondSubdivision;
-	processTriangles.callback = callback;
-	processTriangles.width = m_heightStickWidth - 1;
-	processTriangles.length = m_heightStickLength - 1;
+	ProcessGridCellAction processCells;
+	processCells.processTriangles.shape = this;
+	processCells.processTriangles.callback = callback;
+	processCells.processTriangles.useCellIds = !m_useTriangleIdsInRaycast;
+	processCells.processTriangles.width = m_heightStickWidth - 1;
+	processCells.processTriangles.length = m_heightStickLength - 1;
 
-	// TODO Transform vectors to account for m_upAxis
-	int indices[3] = { 0, 1, 2 };
-	if (m_upAxis == 2)
+	int indices[3] = {0, 1, 2};
+	if (m_upAxis == 0)
+	{
+		indices[0] = 1;
+		indices[1] = 0;
+	}
+	else if (m_upAxis == 2)
 	{
 		indices[1] = 2;
 		indices[2] = 1;
@@ -708,41 +952,16 @@ void btHeightfieldTerrainShape::performRaycast(btTriangleCallback* callback, con
 		// The ray will never cross quads within the plane,
 		// so directly process triangles within one quad
 		// (typically, vertical rays should end up here)
-		processTriangles.exec(iBeginX, iEndZ);
+		processCells.processTriangles.exec(iBeginX, iEndZ);
 		return;
 	}
 
-	
-
-	if (m_vboundsGrid.size()==0)
-	{
-		// Process all quads intersecting the flat projection of the ray
-		gridRaycast(processTriangles, beginPos, endPos, &indices[0]);
-	}
-	else
-	{
-		btVector3 rayDiff = endPos - beginPos;
-		btScalar flatDistance2 = rayDiff[indices[0]] * rayDiff[indices[0]] + rayDiff[indices[2]] * rayDiff[indices[2]];
-		if (flatDistance2 < m_vboundsChunkSize * m_vboundsChunkSize)
-		{
-			// Don't use chunks, the ray is too short in the plane
-			gridRaycast(processTriangles, beginPos, endPos, &indices[0]);
-		}
-
-		ProcessVBoundsAction processVBounds(m_vboundsGrid, &indices[0]);
-		processVBounds.width = m_vboundsGridWidth;
-		processVBounds.length = m_vboundsGridLength;
-		processVBounds.rayBegin = beginPos;
-		processVBounds.rayEnd = endPos;
-		processVBounds.rayDir = rayDiff.normalized();
-		processVBounds.processTriangles = processTriangles;
-		processVBounds.chunkSize = m_vboundsChunkSize;
-		// The ray is long, run raycast on a higher-level grid
-		gridRaycast(processVBounds, beginPos / m_vboundsChunkSize, endPos / m_vboundsChunkSize, indices);
-	}
+	// Process all quads intersecting the flat projection of the ray
+	gridRaycast(processCells, beginPos, endPos, &indices[0]);
 }
 
-/// Builds a grid data structure storing the min and max heights of the terrain in chunks.
+/// Builds a grid data structure storing the min and max heights of the terrain in chunks,
+/// and the min/max pyramid above it.
 /// if chunkSize is zero, that accelerator is removed.
 /// If you modify the heights, you need to rebuild this accelerator.
 void btHeightfieldTerrainShape::buildAccelerator(int chunkSize)
@@ -841,9 +1060,54 @@ void btHeightfieldTerrainShape::buildAccelerator(int chunkSize)
 			m_vboundsGrid[cx + cz * nChunksX] = r;
 		}
 	}
+
+	buildVBoundsPyramid();
+}
+
+void btHeightfieldTerrainShape::buildVBoundsPyramid()
+{
+	m_vboundsPyramid.resize(0);
+	m_vboundsLevels.resize(0);
+
+	VBoundsLevel level;
+	level.m_offset = 0;
+	level.m_width = m_vboundsGridWidth;
+	level.m_length = m_vboundsGridLength;
+	m_vboundsLevels.push_back(level);
+
+	while (level.m_width > 1 || level.m_length > 1)
+	{
+		const int childIndex = m_vboundsLevels.size() - 1;
+		const VBoundsLevel childLevel = level;
+		level.m_offset = m_vboundsPyramid.size();
+		level.m_width = (childLevel.m_width + 1) / 2;
+		level.m_length = (childLevel.m_length + 1) / 2;
+		m_vboundsPyramid.resize(level.m_offset + level.m_width * level.m_length);
+
+		for (int cz = 0; cz < level.m_length; ++cz)
+		{
+			for (int cx = 0; cx < level.m_width; ++cx)
+			{
+				Range r = getVBounds(childIndex, 2 * cx, 2 * cz);
+				for (int czChild = 2 * cz; czChild < 2 * cz + 2 && czChild < childLevel.m_length; ++czChild)
+				{
+					for (int cxChild = 2 * cx; cxChild < 2 * cx + 2 && cxChild < childLevel.m_width; ++cxChild)
+					{
+						const Range& child = getVBounds(childIndex, cxChild, czChild);
+						r.min = btMin(r.min, child.min);
+						r.max = btMax(r.max, child.max);
+					}
+				}
+				m_vboundsPyramid[level.m_offset + cx + cz * level.m_width] = r;
+			}
+		}
+		m_vboundsLevels.push_back(level);
+	}
 }
 
 void btHeightfieldTerrainShape::clearAccelerator()
 {
 	m_vboundsGrid.clear();
+	m_vboundsPyramid.clear();
+	m_vboundsLevels.clear();
 }
\ No newline at end of file
@@ -19,6 +19,9 @@ subject to the following restrictions:
 #include "btConcaveShape.h"
 #include "LinearMath/btAlignedObjectArray.h"
 
+class btTriangleRaycastCallback;
+class btTriangleConvexcastCallback;
+
 ///btHeightfieldTerrainShape simulates a 2D heightfield terrain
 /**
   The caller is responsible for maintaining the heightfield array; this
@@ -67,6 +70,13 @@ subject to the following restrictions:
   or maximum heights.  These values are used to determine the heightfield's
   axis-aligned bounding box, multiplied by localScaling.
 
+  buildAccelerator computes a min/max height pyramid over chunks of the grid.
+  processAllTriangles, performRaycast and performConvexcast use it to skip
+  the parts of the terrain that are above or below the query, which is what
+  makes large terrains affordable. btConvexHeightfieldCollisionAlgorithm
+  collides convex shapes directly with the grid cells, see
+  btDefaultCollisionConstructionInfo::m_useConvexHeightfieldAlgorithm.
+
   For usage and testing see the TerrainDemo.
  */
 ATTRIBUTE_ALIGNED16(class)
@@ -79,6 +89,15 @@ public:
 		btScalar max;
 	};
 
+	///one level of the min/max height pyramid, see buildAccelerator
+	struct VBoundsLevel
+	{
+		///index of the first range of the level in m_vboundsPyramid, unused for level 0 which is m_vboundsGrid
+		int m_offset;
+		int m_width;
+		int m_length;
+	};
+
 protected:
 	btVector3 m_localAabbMin;
 	btVector3 m_localAabbMax;
@@ -104,6 +123,7 @@ protected:
 	bool m_useDiamondSubdivision;
 	bool m_useZigzagSubdivision;
 	bool m_flipTriangleWinding;
+	bool m_useTriangleIdsInRaycast;
 	int m_upAxis;
 
 	btVector3 m_localScaling;
@@ -113,6 +133,9 @@ protected:
 	int m_vboundsGridWidth;
 	int m_vboundsGridLength;
 	int m_vboundsChunkSize;
+	///levels 1 and above of the pyramid, each range merges 2x2 ranges of the level below
+	btAlignedObjectArray<Range> m_vboundsPyramid;
+	btAlignedObjectArray<VBoundsLevel> m_vboundsLevels;
 
 	
 	btScalar m_userValue3;
@@ -122,6 +145,29 @@ protected:
 	virtual btScalar getRawHeightFieldValue(int x, int y) const;
 	void quantizeWithClamp(int* out, const btVector3& point, int isMax) const;
 
+	///range of grid cells and raw heights covered by a local aabb
+	struct CellRange
+	{
+		int m_startX;
+		int m_endX;
+		int m_startZ;
+		int m_endZ;
+		btScalar m_minHeight;
+		btScalar m_maxHeight;
+	};
+
+	///returns false if the aabb does not overlap any cell
+	bool getCellRange(const btVector3& aabbMin, const btVector3& aabbMax, CellRange& range) const;
+
+	template <typename CellAction>
+	void processVBoundsNode(CellAction& cellAction, const CellRange& range, int level, int cx, int cz) const;
+
+	void buildVBoundsPyramid();
+
+	///boxMin and boxMax are 0 for a ray, hitFraction is 0 when the callback does not report the closest hit
+	void performCast(btTriangleCallback * callback, const btScalar* hitFraction, const btVector3& source, const btVector3& target, const btVector3* boxMin, const btVector3* boxMax) const;
+	void performGridRaycast(btTriangleCallback * callback, const btVector3& raySource, const btVector3& rayTarget) const;
+
 	/// protected initialization
 	/**
 	  Handles the work of constructors so that public constructors can be
@@ -167,6 +213,10 @@ public:
 	{
 		m_flipTriangleWinding = flipTriangleWinding;
 	}
+
+	///by default, performRaycast reports both triangles of the grid cell (x, z) with partId x and triangleIndex z.
+	///With useTriangleIds, it uses the ids of processAllTriangles and performConvexcast instead, which tell the two triangles apart.
+	void setUseTriangleIdsInRaycast(bool useTriangleIds = true) { m_useTriangleIdsInRaycast = useTriangleIds; }
 	virtual void getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const;
 
 	virtual void processAllTriangles(btTriangleCallback * callback, const btVector3& aabbMin, const btVector3& aabbMax) const;
@@ -181,9 +231,68 @@ public:
 
 	void performRaycast(btTriangleCallback * callback, const btVector3& raySource, const btVector3& rayTarget) const;
 
+	///with the accelerator, the traversal visits the chunks front to back and skips the chunks beyond the closest hit
+	///found so far. The m_from and m_to of the callback have to be raySource and rayTarget.
+	void performRaycast(btTriangleRaycastCallback * callback, const btVector3& raySource, const btVector3& rayTarget) const;
+
+	///reports the triangles that may be hit by a box, given by boxMin and boxMax relative to its center,
+	///moving from boxSource to boxTarget. The box is expanded by the margin of the heightfield.
+	///Without the accelerator, it reports the triangles overlapping the aabb of the swept box.
+	void performConvexcast(btTriangleCallback * callback, const btVector3& boxSource, const btVector3& boxTarget, const btVector3& boxMin, const btVector3& boxMax) const;
+
+	///with the accelerator, the chunks beyond the closest hit found so far are skipped
+	void performConvexcast(btTriangleConvexcastCallback * callback, const btVector3& boxSource, const btVector3& boxTarget, const btVector3& boxMin, const btVector3& boxMax) const;
+
+	///calls cellAction(x, z) for the grid cells overlapping the local aabb. With the accelerator, the cells
+	///and chunks that are entirely above or below the aabb are skipped.
+	template <typename CellAction>
+	void processAllCells(CellAction & cellAction, const btVector3& aabbMin, const btVector3& aabbMax) const;
+
+	///the two triangles of the grid cell (x, z) in local coordinates, as reported by processAllTriangles:
+	///with partId 2 * x and 2 * x + 1, and triangleIndex z
+	void getCellTriangles(int x, int z, btVector3 triangles[2][3]) const;
+
+	///the raw (unscaled, not centered) height range of the grid cell (x, z)
+	void getCellHeightRange(int x, int z, Range & range) const;
+
+	int getHeightStickWidth() const
+	{
+		return m_heightStickWidth;
+	}
+	int getHeightStickLength() const
+	{
+		return m_heightStickLength;
+	}
+
+	/// Builds a min/max height pyramid: level 0 stores the height range of chunks of chunkSize x chunkSize cells,
+	/// each level above merges 2x2 ranges of the level below, up to a single range for the whole terrain.
 	void buildAccelerator(int chunkSize = 16);
 	void clearAccelerator();
 
+	///the number of levels of the min/max height pyramid, 0 without accelerator
+	int getNumVBoundsLevels() const
+	{
+		return m_vboundsLevels.size();
+	}
+	const VBoundsLevel& getVBoundsLevel(int level) const
+	{
+		return m_vboundsLevels[level];
+	}
+	///the raw height range of the node (cx, cz) of a pyramid level, which covers (getVBoundsChunkSize() << level)^2 cells
+	const Range& getVBounds(int level, int cx, int cz) const
+	{
+		if (level == 0)
+		{
+			return m_vboundsGrid[cx + cz * m_vboundsGridWidth];
+		}
+		const VBoundsLevel& vboundsLevel = m_vboundsLevels[level];
+		return m_vboundsPyramid[vboundsLevel.m_offset + cx + cz * vboundsLevel.m_width];
+	}
+	int getVBoundsChunkSize() const
+	{
+		return m_vboundsChunkSize;
+	}
+
 	int getUpAxis() const
 	{
 		return m_upAxis;
@@ -218,4 +327,82 @@ public:
 	}
 };
 
+template <typename CellAction>
+void btHeightfieldTerrainShape::processAllCells(CellAction& cellAction, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	CellRange range;
+	if (!getCellRange(aabbMin, aabbMax, range))
+	{
+		return;
+	}
+
+	if (m_vboundsLevels.size() == 0)
+	{
+		for (int z = range.m_startZ; z < range.m_endZ; z++)
+		{
+			for (int x = range.m_startX; x < range.m_endX; x++)
+			{
+				cellAction(x, z);
+			}
+		}
+		return;
+	}
+
+	const int top = m_vboundsLevels.size() - 1;
+	for (int cz = 0; cz < m_vboundsLevels[top].m_length; cz++)
+	{
+		for (int cx = 0; cx < m_vboundsLevels[top].m_width; cx++)
+		{
+			processVBoundsNode(cellAction, range, top, cx, cz);
+		}
+	}
+}
+
+template <typename CellAction>
+void btHeightfieldTerrainShape::processVBoundsNode(CellAction& cellAction, const CellRange& range, int level, int cx, int cz) const
+{
+	const int nodeSize = m_vboundsChunkSize << level;
+	const int x0 = cx * nodeSize;
+	const int z0 = cz * nodeSize;
+	if (x0 >= range.m_endX || z0 >= range.m_endZ || x0 + nodeSize <= range.m_startX || z0 + nodeSize <= range.m_startZ)
+	{
+		return;
+	}
+	const Range& bounds = getVBounds(level, cx, cz);
+	if (bounds.max < range.m_minHeight || bounds.min > range.m_maxHeight)
+	{
+		return;
+	}
+
+	if (level > 0)
+	{
+		const VBoundsLevel& childLevel = m_vboundsLevels[level - 1];
+		for (int czChild = 2 * cz; czChild < 2 * cz + 2 && czChild < childLevel.m_length; czChild++)
+		{
+			for (int cxChild = 2 * cx; cxChild < 2 * cx + 2 && cxChild < childLevel.m_width; cxChild++)
+			{
+				processVBoundsNode(cellAction, range, level - 1, cxChild, czChild);
+			}
+		}
+		return;
+	}
+
+	const int startX = btMax(x0, range.m_startX);
+	const int endX = btMin(x0 + nodeSize, range.m_endX);
+	const int startZ = btMax(z0, range.m_startZ);
+	const int endZ = btMin(z0 + nodeSize, range.m_endZ);
+	for (int z = startZ; z < endZ; z++)
+	{
+		for (int x = startX; x < endX; x++)
+		{
+			Range cellRange;
+			getCellHeightRange(x, z, cellRange);
+			if (cellRange.max >= range.m_minHeight && cellRange.min <= range.m_maxHeight)
+			{
+				cellAction(x, z);
+			}
+		}
+	}
+}
+
 #endif  //BT_HEIGHTFIELD_TERRAIN_SHAPE_H
\ No newline at end of file
@@ -10,8 +10,14 @@
 //
 
 #include <limits.h>
+#include <float.h>
 #include <string.h>  //memcpy
 
+#if defined(BT_USE_SSE) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BT_MINISDF_USE_SSE2 1
+#endif
+
 struct btSdfDataStream
 {
 	const char* m_data;
@@ -446,6 +452,9 @@ bool btMiniSDF::interpolate(unsigned int field_id, double& dist, btVector3 const
 	if (!m_isValid)
 		return false;
 
+	if (hasNarrowBand())
+		return interpolateNarrowBand(field_id, dist, x, gradient);
+
 	if (!m_domain.contains(x))
 		return false;
 
@@ -520,3 +529,532 @@ bool btMiniSDF::interpolate(unsigned int field_id, double& dist, btVector3 const
 	dist = phi;
 	return true;
 }
+
+void btMiniSDF::getCellNodeLattice(int node, unsigned int lattice[3])
+{
+	btAssert(node >= 0 && node < 32);
+	if (node < 8)
+	{
+		lattice[0] = (node & 1) * 3;
+		lattice[1] = ((node >> 1) & 1) * 3;
+		lattice[2] = ((node >> 2) & 1) * 3;
+		return;
+	}
+	//the edge nodes are at 1/3 and 2/3 of the edges along x, y and z
+	static const int otherAxes[3][2] = {{2, 1}, {0, 2}, {1, 0}};
+	int axis = (node - 8) / 8;
+	int m = (node - 8) & 7;
+	lattice[axis] = 1 + (m & 1);
+	lattice[otherAxes[axis][0]] = ((m >> 1) & 1) * 3;
+	lattice[otherAxes[axis][1]] = ((m >> 2) & 1) * 3;
+}
+
+///the index of a node within a brick, given its position on the lattice of thirds of a cell
+static int btMiniSDFBrickNodeIndex(unsigned int x, unsigned int y, unsigned int z)
+{
+	const int numCorners = BT_MINISDF_BRICK_SIZE + 1;
+	const int numEdgeNodes = 2 * BT_MINISDF_BRICK_SIZE;
+	const int numCornerNodes = numCorners * numCorners * numCorners;
+	const int numNodesPerAxis = numEdgeNodes * numCorners * numCorners;
+	if (x % 3)
+	{
+		return numCornerNodes + (x / 3 * 2 + x % 3 - 1) + numEdgeNodes * (y / 3 + numCorners * (z / 3));
+	}
+	if (y % 3)
+	{
+		return numCornerNodes + numNodesPerAxis + (y / 3 * 2 + y % 3 - 1) + numEdgeNodes * (x / 3 + numCorners * (z / 3));
+	}
+	if (z % 3)
+	{
+		return numCornerNodes + 2 * numNodesPerAxis + (z / 3 * 2 + z % 3 - 1) + numEdgeNodes * (x / 3 + numCorners * (y / 3));
+	}
+	return x / 3 + numCorners * (y / 3 + numCorners * (z / 3));
+}
+
+void btMiniSDF::buildNarrowBand(double bandWidth)
+{
+	btAssert(m_isValid);
+	if (!m_isValid || hasNarrowBand())
+		return;
+
+	const int brickSize = BT_MINISDF_BRICK_SIZE;
+	const int numBrickCells = brickSize * brickSize * brickSize;
+	m_brickCellNodes.resize(numBrickCells * 32);
+	for (int c = 0; c < numBrickCells; c++)
+	{
+		unsigned int cell[3] = {(unsigned int)(c % brickSize), (unsigned int)((c / brickSize) % brickSize), (unsigned int)(c / (brickSize * brickSize))};
+		for (int j = 0; j < 32; j++)
+		{
+			unsigned int lattice[3];
+			getCellNodeLattice(j, lattice);
+			m_brickCellNodes[c * 32 + j] = (unsigned short)btMiniSDFBrickNodeIndex(3 * cell[0] + lattice[0], 3 * cell[1] + lattice[1], 3 * cell[2] + lattice[2]);
+		}
+	}
+
+	for (int d = 0; d < 3; d++)
+	{
+		m_brickResolution[d] = (m_resolution[d] + brickSize - 1) / brickSize;
+	}
+	const int numBricks = m_brickResolution[0] * m_brickResolution[1] * m_brickResolution[2];
+
+	//the gradients of the far field come from the dense storage, so they are computed before the brick map exists
+	m_brickGradients.resize(int(m_n_fields));
+	for (int field_id = 0; field_id < int(m_n_fields); field_id++)
+	{
+		btAlignedObjectArray<float>& brickGradients = m_brickGradients[field_id];
+		brickGradients.resize(numBricks * 3);
+		for (int brick = 0; brick < numBricks; brick++)
+		{
+			unsigned int brickIjk[3] = {brick % m_brickResolution[0], (brick / m_brickResolution[0]) % m_brickResolution[1], brick / (m_brickResolution[0] * m_brickResolution[1])};
+			btVector3 center;
+			for (int d = 0; d < 3; d++)
+			{
+				const unsigned int cellMin = brickIjk[d] * brickSize;
+				const unsigned int cellMax = btMin(cellMin + brickSize, m_resolution[d]);
+				center[d] = m_domain.min()[d] + m_cell_size[d] * btScalar(0.5) * btScalar(cellMin + cellMax);
+			}
+			double dist;
+			btVector3 gradient(0, 0, 0);
+			if (!interpolate(field_id, dist, center, &gradient))
+			{
+				gradient.setZero();
+			}
+			for (int d = 0; d < 3; d++)
+			{
+				brickGradients[brick * 3 + d] = float(gradient[d]);
+			}
+		}
+	}
+
+	m_brickMap.resize(int(m_n_fields));
+	m_brickNodes.resize(int(m_n_fields));
+
+	float values[BT_MINISDF_BRICK_NODES];
+	for (int field_id = 0; field_id < int(m_n_fields); field_id++)
+	{
+		btAlignedObjectArray<int>& brickMap = m_brickMap[field_id];
+		btAlignedObjectArray<float>& brickNodes = m_brickNodes[field_id];
+		brickMap.resize(numBricks);
+		for (int brick = 0; brick < numBricks; brick++)
+		{
+			unsigned int brickIjk[3] = {brick % m_brickResolution[0], (brick / m_brickResolution[0]) % m_brickResolution[1], brick / (m_brickResolution[0] * m_brickResolution[1])};
+			for (int n = 0; n < BT_MINISDF_BRICK_NODES; n++)
+			{
+				values[n] = FLT_MAX;
+			}
+			bool hasCells = false;
+			bool inBand = false;
+			bool inside = false;
+			for (int c = 0; c < numBrickCells; c++)
+			{
+				btMultiIndex mi;
+				mi.ijk[0] = brickIjk[0] * brickSize + c % brickSize;
+				mi.ijk[1] = brickIjk[1] * brickSize + (c / brickSize) % brickSize;
+				mi.ijk[2] = brickIjk[2] * brickSize + c / (brickSize * brickSize);
+				if (mi.ijk[0] >= m_resolution[0] || mi.ijk[1] >= m_resolution[1] || mi.ijk[2] >= m_resolution[2])
+					continue;
+				unsigned int i_ = m_cell_map[field_id][multiToSingleIndex(mi)];
+				if (i_ == UINT_MAX)
+					continue;
+				const btCell32& cell = m_cells[field_id][i_];
+				bool valid = true;
+				double minDist = DBL_MAX;
+				bool positive = false;
+				bool negative = false;
+				for (int j = 0; j < 32; j++)
+				{
+					double v = m_nodes[field_id][cell.m_cells[j]];
+					valid = valid && (v != DBL_MAX);
+					minDist = btMin(minDist, v < 0 ? -v : v);
+					positive = positive || (v > 0);
+					negative = negative || (v <= 0);
+				}
+				if (!valid)
+					continue;
+				for (int j = 0; j < 32; j++)
+				{
+					values[m_brickCellNodes[c * 32 + j]] = float(m_nodes[field_id][cell.m_cells[j]]);
+				}
+				hasCells = true;
+				inBand = inBand || (minDist <= bandWidth) || (positive && negative);
+				inside = inside || negative;
+			}
+			if (!hasCells)
+			{
+				brickMap[brick] = BT_MINISDF_BRICK_INVALID;
+			}
+			else if (!inBand)
+			{
+				brickMap[brick] = inside ? BT_MINISDF_BRICK_INSIDE : BT_MINISDF_BRICK_OUTSIDE;
+			}
+			else
+			{
+				brickMap[brick] = brickNodes.size();
+				for (int n = 0; n < BT_MINISDF_BRICK_NODES; n++)
+				{
+					brickNodes.push_back(values[n]);
+				}
+			}
+		}
+	}
+	m_narrowBandWidth = bandWidth;
+
+	m_nodes.clear();
+	m_cells.clear();
+	m_cell_map.clear();
+}
+
+int btMiniSDF::calculateMemorySize() const
+{
+	int size = 0;
+	for (int i = 0; i < m_nodes.size(); i++)
+		size += m_nodes[i].size() * sizeof(double);
+	for (int i = 0; i < m_cells.size(); i++)
+		size += m_cells[i].size() * sizeof(btCell32);
+	for (int i = 0; i < m_cell_map.size(); i++)
+		size += m_cell_map[i].size() * sizeof(unsigned int);
+	for (int i = 0; i < m_brickMap.size(); i++)
+		size += m_brickMap[i].size() * sizeof(int);
+	for (int i = 0; i < m_brickNodes.size(); i++)
+		size += m_brickNodes[i].size() * sizeof(float);
+	for (int i = 0; i < m_brickGradients.size(); i++)
+		size += m_brickGradients[i].size() * sizeof(float);
+	size += m_brickCellNodes.size() * sizeof(unsigned short);
+	return size;
+}
+
+///the same cubic shape functions as btMiniSDF::shape_function_, written for a scalar or for four points in SSE registers.
+///The corner nodes are fac * (1 +- x) * (1 +- y) * (1 +- z) and the edge nodes along axis a are
+///9/64 * (1 - a * a) * (1 +- 3 * a) times (1 +- b) * (1 +- c) for the two other axes.
+template <typename T>
+static void btMiniSDFShapeFunction(const T xi[3], T N[32], T (*dN)[3])
+{
+	const T one(1.f);
+	T plus[3], minus[3];
+	for (int d = 0; d < 3; d++)
+	{
+		plus[d] = one + xi[d];
+		minus[d] = one - xi[d];
+	}
+	const T cornerFactor = (T(9.f) * (xi[0] * xi[0] + xi[1] * xi[1] + xi[2] * xi[2]) - T(19.f)) * T(1.f / 64.f);
+	for (int j = 0; j < 8; j++)
+	{
+		T f[3];
+		for (int d = 0; d < 3; d++)
+		{
+			f[d] = ((j >> d) & 1) ? plus[d] : minus[d];
+		}
+		const T product = f[0] * f[1] * f[2];
+		N[j] = cornerFactor * product;
+		if (dN)
+		{
+			const T cornerDerivative = T(18.f / 64.f) * product;
+			for (int d = 0; d < 3; d++)
+			{
+				const T others = f[(d + 1) % 3] * f[(d + 2) % 3];
+				dN[j][d] = cornerDerivative * xi[d] + (((j >> d) & 1) ? cornerFactor * others : T(0.f) - cornerFactor * others);
+			}
+		}
+	}
+	for (int j = 8; j < 32; j++)
+	{
+		unsigned int lattice[3];
+		btMiniSDF::getCellNodeLattice(j, lattice);
+		const int axis = (j - 8) / 8;
+		const int b = (axis + 1) % 3;
+		const int c = (axis + 2) % 3;
+		const T& a = xi[axis];
+		const T oneMinusA2 = one - a * a;
+		const T threeA = T(3.f) * a;
+		const T edge = (lattice[axis] == 1) ? one - threeA : one + threeA;
+		const T fb = lattice[b] ? plus[b] : minus[b];
+		const T fc = lattice[c] ? plus[c] : minus[c];
+		const T scaledEdge = T(9.f / 64.f) * oneMinusA2 * edge;
+		N[j] = scaledEdge * fb * fc;
+		if (dN)
+		{
+			//d/da (1 - a * a) * (1 +- 3 * a) = -2 * a * (1 +- 3 * a) +- 3 * (1 - a * a)
+			const T threeOneMinusA2 = T(3.f) * oneMinusA2;
+			const T edgeDerivative = (lattice[axis] == 1) ? T(0.f) - threeOneMinusA2 : threeOneMinusA2;
+			dN[j][axis] = T(9.f / 64.f) * (edgeDerivative - T(2.f) * a * edge) * fb * fc;
+			dN[j][b] = lattice[b] ? scaledEdge * fc : T(0.f) - scaledEdge * fc;
+			dN[j][c] = lattice[c] ? scaledEdge * fb : T(0.f) - scaledEdge * fb;
+		}
+	}
+}
+
+///finds the brick cell of a point of the narrow band storage, returns the node values of the brick or 0.
+///brick is the index of the brick of the point, or -1 outside of the domain.
+static const float* btMiniSDFFindBrickCell(const btMiniSDF& sdf, unsigned int field_id, const btVector3& x, btVector3& xi, const unsigned short*& cellNodes, int& brick)
+{
+	brick = -1;
+	if (!sdf.m_domain.contains(x))
+		return 0;
+	btVector3 tmpmi = ((x - sdf.m_domain.min()) * (sdf.m_inv_cell_size));
+	unsigned int mi[3];
+	for (int d = 0; d < 3; d++)
+	{
+		mi[d] = btMin((unsigned int)tmpmi[d], sdf.m_resolution[d] - 1);
+	}
+	const unsigned int brickSize = BT_MINISDF_BRICK_SIZE;
+	brick = (mi[0] / brickSize) + sdf.m_brickResolution[0] * ((mi[1] / brickSize) + sdf.m_brickResolution[1] * (mi[2] / brickSize));
+	int firstNode = sdf.m_brickMap[field_id][brick];
+	if (firstNode < 0)
+		return 0;
+	int cell = (mi[0] % brickSize) + brickSize * ((mi[1] % brickSize) + brickSize * (mi[2] % brickSize));
+	cellNodes = &sdf.m_brickCellNodes[cell * 32];
+	//the cell spans -1..1
+	for (int d = 0; d < 3; d++)
+	{
+		btScalar cellMin = sdf.m_domain.min()[d] + sdf.m_cell_size[d] * btScalar(mi[d]);
+		xi[d] = btScalar(2.) * (x[d] - cellMin) * sdf.m_inv_cell_size[d] - btScalar(1.);
+	}
+	return &sdf.m_brickNodes[field_id][firstNode];
+}
+
+///the far field of a brick beyond the narrow band: the distance clamped to the band width and the gradient at the brick center
+static bool btMiniSDFFarField(const btMiniSDF& sdf, unsigned int field_id, int brick, double& dist, btVector3& gradient)
+{
+	if (brick < 0)
+		return false;
+	const int brickType = sdf.m_brickMap[field_id][brick];
+	if (brickType != BT_MINISDF_BRICK_INSIDE && brickType != BT_MINISDF_BRICK_OUTSIDE)
+		return false;
+	dist = (brickType == BT_MINISDF_BRICK_INSIDE) ? -sdf.m_narrowBandWidth : sdf.m_narrowBandWidth;
+	const float* g = &sdf.m_brickGradients[field_id][brick * 3];
+	gradient.setValue(g[0], g[1], g[2]);
+	return true;
+}
+
+bool btMiniSDF::interpolateNarrowBand(unsigned int field_id, double& dist, btVector3 const& x, btVector3* gradient) const
+{
+	btVector3 xi;
+	const unsigned short* cellNodes = 0;
+	int brick;
+	const float* nodes = btMiniSDFFindBrickCell(*this, field_id, x, xi, cellNodes, brick);
+	if (!nodes)
+	{
+		btVector3 farGradient;
+		if (!btMiniSDFFarField(*this, field_id, brick, dist, farGradient))
+			return false;
+		if (gradient)
+		{
+			*gradient = farGradient;
+		}
+		return true;
+	}
+
+	btScalar xiArray[3] = {xi[0], xi[1], xi[2]};
+	btScalar N[32];
+	btScalar dN[32][3];
+	btMiniSDFShapeFunction<btScalar>(xiArray, N, gradient ? dN : 0);
+
+	double phi = 0.0;
+	btVector3 grad(0, 0, 0);
+	for (int j = 0; j < 32; j++)
+	{
+		float c = nodes[cellNodes[j]];
+		if (c == FLT_MAX)
+			return false;
+		phi += c * N[j];
+		if (gradient)
+		{
+			grad += btVector3(dN[j][0], dN[j][1], dN[j][2]) * btScalar(c);
+		}
+	}
+	if (gradient)
+	{
+		*gradient = grad * (btScalar(2.) * m_inv_cell_size);
+	}
+	dist = phi;
+	return true;
+}
+
+#ifdef BT_MINISDF_USE_SSE2
+///four floats in a SSE register, for btMiniSDFShapeFunction
+struct btMiniSDFFloat4
+{
+	__m128 m_value;
+
+	btMiniSDFFloat4()
+	{
+	}
+	btMiniSDFFloat4(__m128 value)
+		: m_value(value)
+	{
+	}
+	btMiniSDFFloat4(float value)
+		: m_value(_mm_set1_ps(value))
+	{
+	}
+};
+
+SIMD_FORCE_INLINE btMiniSDFFloat4 operator+(const btMiniSDFFloat4& a, const btMiniSDFFloat4& b)
+{
+	return _mm_add_ps(a.m_value, b.m_value);
+}
+
+SIMD_FORCE_INLINE btMiniSDFFloat4 operator-(const btMiniSDFFloat4& a, const btMiniSDFFloat4& b)
+{
+	return _mm_sub_ps(a.m_value, b.m_value);
+}
+
+SIMD_FORCE_INLINE btMiniSDFFloat4 operator*(const btMiniSDFFloat4& a, const btMiniSDFFloat4& b)
+{
+	return _mm_mul_ps(a.m_value, b.m_value);
+}
+#endif  //BT_MINISDF_USE_SSE2
+
+int btMiniSDF::interpolatePoints(unsigned int field_id, const btVector3* points, int numPoints, btScalar* distances, btVector3* gradients) const
+{
+	btAssert(m_isValid);
+	int numValid = 0;
+	int i = 0;
+#ifdef BT_MINISDF_USE_SSE2
+	if (hasNarrowBand())
+	{
+		for (; i + 4 <= numPoints; i += 4)
+		{
+			const float* nodes[4];
+			const unsigned short* cellNodes[4];
+			int bricks[4];
+			float xiLanes[3][4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				btVector3 xi(0, 0, 0);
+				nodes[lane] = btMiniSDFFindBrickCell(*this, field_id, points[i + lane], xi, cellNodes[lane], bricks[lane]);
+				for (int d = 0; d < 3; d++)
+				{
+					xiLanes[d][lane] = float(xi[d]);
+				}
+			}
+			btMiniSDFFloat4 xi[3] = {_mm_loadu_ps(xiLanes[0]), _mm_loadu_ps(xiLanes[1]), _mm_loadu_ps(xiLanes[2])};
+			btMiniSDFFloat4 N[32];
+			btMiniSDFFloat4 dN[32][3];
+			btMiniSDFShapeFunction<btMiniSDFFloat4>(xi, N, dN);
+
+			__m128 phi = _mm_setzero_ps();
+			__m128 grad[3] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+			bool valid[4];
+			float c[4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				valid[lane] = nodes[lane] != 0;
+			}
+			for (int j = 0; j < 32; j++)
+			{
+				for (int lane = 0; lane < 4; lane++)
+				{
+					c[lane] = valid[lane] ? nodes[lane][cellNodes[lane][j]] : 0.f;
+					if (c[lane] == FLT_MAX)
+					{
+						valid[lane] = false;
+						c[lane] = 0.f;
+					}
+				}
+				__m128 cj = _mm_loadu_ps(c);
+				phi = _mm_add_ps(phi, _mm_mul_ps(cj, N[j].m_value));
+				grad[0] = _mm_add_ps(grad[0], _mm_mul_ps(cj, dN[j][0].m_value));
+				grad[1] = _mm_add_ps(grad[1], _mm_mul_ps(cj, dN[j][1].m_value));
+				grad[2] = _mm_add_ps(grad[2], _mm_mul_ps(cj, dN[j][2].m_value));
+			}
+			float phiLanes[4];
+			float gradLanes[3][4];
+			_mm_storeu_ps(phiLanes, phi);
+			_mm_storeu_ps(gradLanes[0], grad[0]);
+			_mm_storeu_ps(gradLanes[1], grad[1]);
+			_mm_storeu_ps(gradLanes[2], grad[2]);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (valid[lane])
+				{
+					distances[i + lane] = phiLanes[lane];
+					if (gradients)
+					{
+						gradients[i + lane] = btVector3(gradLanes[0][lane], gradLanes[1][lane], gradLanes[2][lane]) * (btScalar(2.) * m_inv_cell_size);
+					}
+					numValid++;
+				}
+				else
+				{
+					double dist;
+					btVector3 gradient;
+					if (!nodes[lane] && btMiniSDFFarField(*this, field_id, bricks[lane], dist, gradient))
+					{
+						distances[i + lane] = btScalar(dist);
+						numValid++;
+					}
+					else
+					{
+						distances[i + lane] = BT_LARGE_FLOAT;
+						gradient.setZero();
+					}
+					if (gradients)
+					{
+						gradients[i + lane] = gradient;
+					}
+				}
+			}
+		}
+	}
+#endif  //BT_MINISDF_USE_SSE2
+	for (; i < numPoints; i++)
+	{
+		double dist;
+		btVector3 gradient;
+		if (interpolate(field_id, dist, points[i], gradients ? &gradient : 0))
+		{
+			distances[i] = btScalar(dist);
+			if (gradients)
+			{
+				gradients[i] = gradient;
+			}
+			numValid++;
+		}
+		else
+		{
+			distances[i] = BT_LARGE_FLOAT;
+			if (gradients)
+			{
+				gradients[i].setZero();
+			}
+		}
+	}
+	return numValid;
+}
+
+void btMiniSDF::computeSurfacePoints(unsigned int field_id, btAlignedObjectArray<btVector3>& points) const
+{
+	btAssert(m_isValid);
+	const btScalar halfDiagonal = btScalar(0.5) * m_cell_size.length();
+	const btScalar tolerance = btScalar(0.1) * m_cell_size[m_cell_size.minAxis()];
+	for (unsigned int k = 0; k < m_resolution[2]; k++)
+	{
+		for (unsigned int j = 0; j < m_resolution[1]; j++)
+		{
+			for (unsigned int i = 0; i < m_resolution[0]; i++)
+			{
+				if (hasNarrowBand())
+				{
+					const unsigned int brickSize = BT_MINISDF_BRICK_SIZE;
+					int brick = (i / brickSize) + m_brickResolution[0] * ((j / brickSize) + m_brickResolution[1] * (k / brickSize));
+					if (m_brickMap[field_id][brick] < 0)
+						continue;
+				}
+				btVector3 center = m_domain.min() + btVector3(btScalar(i) + btScalar(0.5), btScalar(j) + btScalar(0.5), btScalar(k) + btScalar(0.5)) * m_cell_size;
+				double dist;
+				btVector3 gradient;
+				if (!interpolate(field_id, dist, center, &gradient) || btFabs(btScalar(dist)) > halfDiagonal)
+					continue;
+				btScalar length2 = gradient.length2();
+				if (length2 < SIMD_EPSILON)
+					continue;
+				btVector3 point = center - gradient * (btScalar(dist) / length2);
+				double surfaceDist;
+				if (!interpolate(field_id, surfaceDist, point, 0) || btFabs(btScalar(surfaceDist)) > tolerance)
+					continue;
+				points.push_back(point);
+			}
+		}
+	}
+}
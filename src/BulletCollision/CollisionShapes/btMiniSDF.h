@@ -87,6 +87,23 @@ struct btCell32
 	unsigned int m_cells[32];
 };
 
+///number of cells along each side of a brick of the narrow band storage, see btMiniSDF::buildNarrowBand
+#define BT_MINISDF_BRICK_SIZE 4
+///number of node values of a brick: the corner nodes and the two nodes on each cell edge
+#define BT_MINISDF_BRICK_NODES 725
+
+///markers of the bricks of the narrow band storage that have no node values
+enum btMiniSDFBrickType
+{
+	BT_MINISDF_BRICK_OUTSIDE = -1,
+	BT_MINISDF_BRICK_INSIDE = -2,
+	BT_MINISDF_BRICK_INVALID = -3
+};
+
+///btMiniSDF is a signed distance field sampled on a grid of cells with cubic Lagrange polynomials, loaded from the
+///dense grid format of Discregrid or btMiniSDFBuilder. buildNarrowBand converts it to a sparse storage of bricks of
+///BT_MINISDF_BRICK_SIZE^3 cells with float node values, that only keeps the bricks near the surface.
+///interpolatePoints evaluates batches of points, four at a time with SSE2 when available.
 struct btMiniSDF
 {
 	btAlignedBox3d m_domain;
@@ -101,15 +118,51 @@ struct btMiniSDF
 	btAlignedObjectArray<btAlignedObjectArray<btCell32> > m_cells;
 	btAlignedObjectArray<btAlignedObjectArray<unsigned int> > m_cell_map;
 
+	///narrow band storage: for each field and brick, the first node value of the brick in m_brickNodes or a btMiniSDFBrickType
+	unsigned int m_brickResolution[3];
+	double m_narrowBandWidth;
+	btAlignedObjectArray<btAlignedObjectArray<int> > m_brickMap;
+	btAlignedObjectArray<btAlignedObjectArray<float> > m_brickNodes;
+	///for each field, the gradient at the center of each brick (3 floats per brick), used beyond the narrow band
+	btAlignedObjectArray<btAlignedObjectArray<float> > m_brickGradients;
+	///the 32 node indices within a brick of each of its cells
+	btAlignedObjectArray<unsigned short> m_brickCellNodes;
+
 	btMiniSDF()
-		: m_isValid(false)
+		: m_isValid(false),
+		  m_narrowBandWidth(0)
 	{
+		m_brickResolution[0] = m_brickResolution[1] = m_brickResolution[2] = 0;
 	}
 	bool load(const char* data, int size);
 	bool isValid() const
 	{
 		return m_isValid;
 	}
+
+	///replaces the dense storage by bricks, keeping the bricks with node values within bandWidth of the surface.
+	///Beyond the narrow band, interpolate returns the distance clamped to -bandWidth inside and bandWidth outside,
+	///with the gradient at the center of the brick, so deep points still get a distance and a direction.
+	void buildNarrowBand(double bandWidth);
+
+	bool hasNarrowBand() const
+	{
+		return m_brickMap.size() != 0;
+	}
+
+	///the memory used by the node values and cells, in bytes
+	int calculateMemorySize() const;
+
+	///interpolates the distance and gradient at numPoints points. The points without value get a distance of
+	///BT_LARGE_FLOAT and a zero gradient. Returns the number of points with a value.
+	int interpolatePoints(unsigned int field_id, const btVector3* points, int numPoints, btScalar* distances, btVector3* gradients) const;
+
+	///finds a point on the surface near the center of each cell crossed by the surface, with a Newton step from the center
+	void computeSurfacePoints(unsigned int field_id, btAlignedObjectArray<btVector3>& points) const;
+
+	///the position of node (0..31) of a cell on the lattice of thirds of a cell, with coordinates 0..3 along each axis,
+	///in the order of the shape functions
+	static void getCellNodeLattice(int node, unsigned int lattice[3]);
 	unsigned int multiToSingleIndex(btMultiIndex const& ijk) const;
 
 	btAlignedBox3d subdomain(btMultiIndex const& ijk) const;
@@ -122,6 +175,8 @@ struct btMiniSDF
 	shape_function_(btVector3 const& xi, btShapeGradients* gradient = 0) const;
 
 	bool interpolate(unsigned int field_id, double& dist, btVector3 const& x, btVector3* gradient) const;
+
+	bool interpolateNarrowBand(unsigned int field_id, double& dist, btVector3 const& x, btVector3* gradient) const;
 };
 
 #endif  //MINISDF_H
@@ -0,0 +1,645 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMiniSDFBuilder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "btMiniSDF.h"
+#include "btStridingMeshInterface.h"
+#include "btTriangleCallback.h"
+#include "BulletCollision/BroadphaseCollision/btDbvt.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+
+///the features of a triangle closest to a point
+enum btMiniSDFTriangleFeature
+{
+	BT_MINISDF_FEATURE_FACE = 0,
+	BT_MINISDF_FEATURE_VERTEX0,
+	BT_MINISDF_FEATURE_VERTEX1,
+	BT_MINISDF_FEATURE_VERTEX2,
+	BT_MINISDF_FEATURE_EDGE01,
+	BT_MINISDF_FEATURE_EDGE12,
+	BT_MINISDF_FEATURE_EDGE20
+};
+
+///welds the vertices of the mesh with the same position
+struct btMiniSDFVertexKey
+{
+	btScalar m_position[3];
+
+	btMiniSDFVertexKey(const btVector3& position)
+	{
+		//adding zero turns -0 into +0, so they have the same hash
+		m_position[0] = position.getX() + btScalar(0.);
+		m_position[1] = position.getY() + btScalar(0.);
+		m_position[2] = position.getZ() + btScalar(0.);
+	}
+
+	bool equals(const btMiniSDFVertexKey& other) const
+	{
+		return m_position[0] == other.m_position[0] && m_position[1] == other.m_position[1] && m_position[2] == other.m_position[2];
+	}
+
+	SIMD_FORCE_INLINE unsigned int getHash() const
+	{
+		unsigned int words[sizeof(m_position) / sizeof(unsigned int)];
+		memcpy(words, m_position, sizeof(m_position));
+		unsigned int key = 0;
+		for (unsigned int i = 0; i < sizeof(words) / sizeof(unsigned int); i++)
+		{
+			key = key * 31 + words[i];
+		}
+		// Thomas Wang's hash
+		key += ~(key << 15);
+		key ^= (key >> 10);
+		key += (key << 3);
+		key ^= (key >> 6);
+		key += ~(key << 11);
+		key ^= (key >> 16);
+		return key;
+	}
+};
+
+///an edge between two welded vertices, shared by the triangles on both sides
+struct btMiniSDFEdgeKey
+{
+	int m_vertex0;
+	int m_vertex1;
+
+	btMiniSDFEdgeKey(int vertexA, int vertexB)
+		: m_vertex0(btMin(vertexA, vertexB)),
+		  m_vertex1(btMax(vertexA, vertexB))
+	{
+	}
+
+	bool equals(const btMiniSDFEdgeKey& other) const
+	{
+		return m_vertex0 == other.m_vertex0 && m_vertex1 == other.m_vertex1;
+	}
+
+	SIMD_FORCE_INLINE unsigned int getHash() const
+	{
+		unsigned int key = static_cast<unsigned int>(m_vertex0) * 73856093u ^ static_cast<unsigned int>(m_vertex1) * 19349663u;
+		key += ~(key << 15);
+		key ^= (key >> 10);
+		key += (key << 3);
+		key ^= (key >> 6);
+		key += ~(key << 11);
+		key ^= (key >> 16);
+		return key;
+	}
+};
+
+///the welded triangles of the mesh with the pseudo normals of their faces, edges and vertices
+struct btMiniSDFMesh : public btInternalTriangleIndexCallback
+{
+	btAlignedObjectArray<btVector3> m_vertices;
+	btAlignedObjectArray<btVector3> m_vertexNormals;
+	btAlignedObjectArray<int> m_triangles;
+	btAlignedObjectArray<btVector3> m_faceNormals;
+	///the index in m_edgeNormals of the edges 01, 12 and 20 of each triangle
+	btAlignedObjectArray<int> m_triangleEdges;
+	btAlignedObjectArray<btVector3> m_edgeNormals;
+	btHashMap<btMiniSDFVertexKey, int> m_vertexMap;
+	btHashMap<btMiniSDFEdgeKey, int> m_edgeMap;
+
+	int addVertex(const btVector3& position)
+	{
+		const btMiniSDFVertexKey key(position);
+		const int* index = m_vertexMap.find(key);
+		if (index)
+		{
+			return *index;
+		}
+		const int newIndex = m_vertices.size();
+		m_vertices.push_back(position);
+		m_vertexNormals.push_back(btVector3(0, 0, 0));
+		m_vertexMap.insert(key, newIndex);
+		return newIndex;
+	}
+
+	int addEdge(int vertexA, int vertexB, const btVector3& faceNormal)
+	{
+		const btMiniSDFEdgeKey key(vertexA, vertexB);
+		const int* index = m_edgeMap.find(key);
+		if (index)
+		{
+			m_edgeNormals[*index] += faceNormal;
+			return *index;
+		}
+		const int newIndex = m_edgeNormals.size();
+		m_edgeNormals.push_back(faceNormal);
+		m_edgeMap.insert(key, newIndex);
+		return newIndex;
+	}
+
+	virtual void internalProcessTriangleIndex(btVector3* triangle, int partId, int triangleIndex)
+	{
+		(void)partId;
+		(void)triangleIndex;
+		btVector3 normal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]);
+		const btScalar len2 = normal.length2();
+		if (len2 < SIMD_EPSILON * SIMD_EPSILON)
+		{
+			//degenerate triangles have no area and no normal, they do not change the distance field of a closed mesh
+			return;
+		}
+		normal /= btSqrt(len2);
+
+		int vertices[3];
+		for (int i = 0; i < 3; i++)
+		{
+			vertices[i] = addVertex(triangle[i]);
+		}
+		if (vertices[0] == vertices[1] || vertices[1] == vertices[2] || vertices[2] == vertices[0])
+		{
+			return;
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			const btVector3& vertex = triangle[i];
+			const btScalar angle = (triangle[(i + 1) % 3] - vertex).angle(triangle[(i + 2) % 3] - vertex);
+			m_vertexNormals[vertices[i]] += normal * angle;
+			m_triangles.push_back(vertices[i]);
+			m_triangleEdges.push_back(addEdge(vertices[i], vertices[(i + 1) % 3], normal));
+		}
+		m_faceNormals.push_back(normal);
+	}
+
+	int getNumTriangles() const
+	{
+		return m_faceNormals.size();
+	}
+};
+
+///the closest point to p on the triangle abc, see Real-Time Collision Detection by Christer Ericson, section 5.1.5
+static btVector3 btMiniSDFClosestPointOnTriangle(const btVector3& p, const btVector3& a, const btVector3& b, const btVector3& c, int& feature)
+{
+	const btVector3 ab = b - a;
+	const btVector3 ac = c - a;
+	const btVector3 ap = p - a;
+	const btScalar d1 = ab.dot(ap);
+	const btScalar d2 = ac.dot(ap);
+	if (d1 <= btScalar(0.) && d2 <= btScalar(0.))
+	{
+		feature = BT_MINISDF_FEATURE_VERTEX0;
+		return a;
+	}
+
+	const btVector3 bp = p - b;
+	const btScalar d3 = ab.dot(bp);
+	const btScalar d4 = ac.dot(bp);
+	if (d3 >= btScalar(0.) && d4 <= d3)
+	{
+		feature = BT_MINISDF_FEATURE_VERTEX1;
+		return b;
+	}
+
+	const btScalar vc = d1 * d4 - d3 * d2;
+	if (vc <= btScalar(0.) && d1 >= btScalar(0.) && d3 <= btScalar(0.))
+	{
+		feature = BT_MINISDF_FEATURE_EDGE01;
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const btVector3 cp = p - c;
+	const btScalar d5 = ab.dot(cp);
+	const btScalar d6 = ac.dot(cp);
+	if (d6 >= btScalar(0.) && d5 <= d6)
+	{
+		feature = BT_MINISDF_FEATURE_VERTEX2;
+		return c;
+	}
+
+	const btScalar vb = d5 * d2 - d1 * d6;
+	if (vb <= btScalar(0.) && d2 >= btScalar(0.) && d6 <= btScalar(0.))
+	{
+		feature = BT_MINISDF_FEATURE_EDGE20;
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const btScalar va = d3 * d6 - d5 * d4;
+	if (va <= btScalar(0.) && (d4 - d3) >= btScalar(0.) && (d5 - d6) >= btScalar(0.))
+	{
+		feature = BT_MINISDF_FEATURE_EDGE12;
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	const btScalar denom = btScalar(1.) / (va + vb + vc);
+	feature = BT_MINISDF_FEATURE_FACE;
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+static btScalar btMiniSDFAabbDistance2(const btVector3& p, const btDbvtVolume& volume)
+{
+	btVector3 below = volume.Mins() - p;
+	below.setMax(btVector3(0, 0, 0));
+	btVector3 above = p - volume.Maxs();
+	above.setMax(btVector3(0, 0, 0));
+	return (below + above).length2();
+}
+
+///the node index of each position on the lattice of thirds of the cells: first the corners of the cells, then the nodes
+///on the edges along x, y and z, two per edge
+struct btMiniSDFNodeLattice
+{
+	unsigned int m_resolution[3];
+	unsigned int m_xEdgeOffset;
+	unsigned int m_yEdgeOffset;
+	unsigned int m_zEdgeOffset;
+	unsigned int m_numNodes;
+
+	btMiniSDFNodeLattice(const int resolution[3])
+	{
+		const unsigned int r0 = resolution[0];
+		const unsigned int r1 = resolution[1];
+		const unsigned int r2 = resolution[2];
+		m_resolution[0] = r0;
+		m_resolution[1] = r1;
+		m_resolution[2] = r2;
+		m_xEdgeOffset = (r0 + 1) * (r1 + 1) * (r2 + 1);
+		m_yEdgeOffset = m_xEdgeOffset + 2 * r0 * (r1 + 1) * (r2 + 1);
+		m_zEdgeOffset = m_yEdgeOffset + (r0 + 1) * 2 * r1 * (r2 + 1);
+		m_numNodes = m_zEdgeOffset + (r0 + 1) * (r1 + 1) * 2 * r2;
+	}
+
+	unsigned int getNodeIndex(const unsigned int lattice[3]) const
+	{
+		const unsigned int r0 = m_resolution[0];
+		const unsigned int r1 = m_resolution[1];
+		const unsigned int r2 = m_resolution[2];
+		if (lattice[0] % 3)
+		{
+			return m_xEdgeOffset + 2 * (lattice[0] / 3) + lattice[0] % 3 - 1 + 2 * r0 * (lattice[1] / 3 + (r1 + 1) * (lattice[2] / 3));
+		}
+		if (lattice[1] % 3)
+		{
+			return m_yEdgeOffset + 2 * (lattice[1] / 3) + lattice[1] % 3 - 1 + 2 * r1 * (lattice[0] / 3 + (r0 + 1) * (lattice[2] / 3));
+		}
+		if (lattice[2] % 3)
+		{
+			return m_zEdgeOffset + 2 * (lattice[2] / 3) + lattice[2] % 3 - 1 + 2 * r2 * (lattice[0] / 3 + (r0 + 1) * (lattice[1] / 3));
+		}
+		return lattice[0] / 3 + (r0 + 1) * (lattice[1] / 3 + (r1 + 1) * (lattice[2] / 3));
+	}
+
+	void getNodeLattice(unsigned int node, unsigned int lattice[3]) const
+	{
+		const unsigned int r0 = m_resolution[0];
+		const unsigned int r1 = m_resolution[1];
+		const unsigned int r2 = m_resolution[2];
+		if (node < m_xEdgeOffset)
+		{
+			lattice[0] = 3 * (node % (r0 + 1));
+			lattice[1] = 3 * ((node / (r0 + 1)) % (r1 + 1));
+			lattice[2] = 3 * (node / ((r0 + 1) * (r1 + 1)));
+		}
+		else if (node < m_yEdgeOffset)
+		{
+			const unsigned int m = node - m_xEdgeOffset;
+			const unsigned int e = m % (2 * r0);
+			lattice[0] = 3 * (e / 2) + 1 + e % 2;
+			lattice[1] = 3 * ((m / (2 * r0)) % (r1 + 1));
+			lattice[2] = 3 * (m / (2 * r0 * (r1 + 1)));
+		}
+		else if (node < m_zEdgeOffset)
+		{
+			const unsigned int m = node - m_yEdgeOffset;
+			const unsigned int e = m % (2 * r1);
+			lattice[1] = 3 * (e / 2) + 1 + e % 2;
+			lattice[0] = 3 * ((m / (2 * r1)) % (r0 + 1));
+			lattice[2] = 3 * (m / (2 * r1 * (r0 + 1)));
+		}
+		else
+		{
+			const unsigned int m = node - m_zEdgeOffset;
+			const unsigned int e = m % (2 * r2);
+			lattice[2] = 3 * (e / 2) + 1 + e % 2;
+			lattice[0] = 3 * ((m / (2 * r2)) % (r0 + 1));
+			lattice[1] = 3 * (m / (2 * r2 * (r0 + 1)));
+		}
+	}
+};
+
+///computes the signed distances of a range of nodes
+struct btMiniSDFDistanceLoop : public btIParallelForBody
+{
+	const btMiniSDFMesh& m_mesh;
+	const btDbvt& m_tree;
+	const btMiniSDFNodeLattice& m_lattice;
+	btVector3 m_domainMin;
+	btVector3 m_latticeSpacing;
+	double* m_distances;
+
+	btMiniSDFDistanceLoop(const btMiniSDFMesh& mesh, const btDbvt& tree, const btMiniSDFNodeLattice& lattice)
+		: m_mesh(mesh),
+		  m_tree(tree),
+		  m_lattice(lattice)
+	{
+	}
+
+	void testTriangle(const btVector3& p, int triangle, btScalar& bestDistance2, int& bestTriangle, int& bestFeature, btVector3& bestPoint) const
+	{
+		const int* vertices = &m_mesh.m_triangles[3 * triangle];
+		int feature;
+		const btVector3 closest = btMiniSDFClosestPointOnTriangle(p, m_mesh.m_vertices[vertices[0]], m_mesh.m_vertices[vertices[1]], m_mesh.m_vertices[vertices[2]], feature);
+		const btScalar distance2 = (p - closest).length2();
+		if (distance2 < bestDistance2)
+		{
+			bestDistance2 = distance2;
+			bestTriangle = triangle;
+			bestFeature = feature;
+			bestPoint = closest;
+		}
+	}
+
+	///the closest triangle of the previous node, which is usually near, bounds the search from the start
+	double computeSignedDistance(const btVector3& p, int& closestTriangle, btAlignedObjectArray<const btDbvtNode*>& stack) const
+	{
+		btScalar bestDistance2 = BT_LARGE_FLOAT;
+		int bestTriangle = -1;
+		int bestFeature = BT_MINISDF_FEATURE_FACE;
+		btVector3 bestPoint(0, 0, 0);
+		if (closestTriangle >= 0)
+		{
+			testTriangle(p, closestTriangle, bestDistance2, bestTriangle, bestFeature, bestPoint);
+		}
+
+		//branch and bound, visiting the closer child first
+		stack.resize(0);
+		stack.push_back(m_tree.m_root);
+		while (stack.size())
+		{
+			const btDbvtNode* node = stack[stack.size() - 1];
+			stack.pop_back();
+			if (btMiniSDFAabbDistance2(p, node->volume) >= bestDistance2)
+			{
+				continue;
+			}
+			if (node->isleaf())
+			{
+				testTriangle(p, node->dataAsInt, bestDistance2, bestTriangle, bestFeature, bestPoint);
+				continue;
+			}
+			const btScalar distance0 = btMiniSDFAabbDistance2(p, node->childs[0]->volume);
+			const btScalar distance1 = btMiniSDFAabbDistance2(p, node->childs[1]->volume);
+			if (distance0 < distance1)
+			{
+				stack.push_back(node->childs[1]);
+				stack.push_back(node->childs[0]);
+			}
+			else
+			{
+				stack.push_back(node->childs[0]);
+				stack.push_back(node->childs[1]);
+			}
+		}
+
+		btVector3 pseudoNormal;
+		switch (bestFeature)
+		{
+			case BT_MINISDF_FEATURE_VERTEX0:
+			case BT_MINISDF_FEATURE_VERTEX1:
+			case BT_MINISDF_FEATURE_VERTEX2:
+				pseudoNormal = m_mesh.m_vertexNormals[m_mesh.m_triangles[3 * bestTriangle + bestFeature - BT_MINISDF_FEATURE_VERTEX0]];
+				break;
+			case BT_MINISDF_FEATURE_EDGE01:
+			case BT_MINISDF_FEATURE_EDGE12:
+			case BT_MINISDF_FEATURE_EDGE20:
+				pseudoNormal = m_mesh.m_edgeNormals[m_mesh.m_triangleEdges[3 * bestTriangle + bestFeature - BT_MINISDF_FEATURE_EDGE01]];
+				break;
+			default:
+				pseudoNormal = m_mesh.m_faceNormals[bestTriangle];
+		}
+		closestTriangle = bestTriangle;
+		const double distance = btSqrt(bestDistance2);
+		return (p - bestPoint).dot(pseudoNormal) < btScalar(0.) ? -distance : distance;
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btAlignedObjectArray<const btDbvtNode*> stack;
+		int closestTriangle = -1;
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			unsigned int lattice[3];
+			m_lattice.getNodeLattice(i, lattice);
+			const btVector3 p = m_domainMin + m_latticeSpacing * btVector3(btScalar(lattice[0]), btScalar(lattice[1]), btScalar(lattice[2]));
+			m_distances[i] = computeSignedDistance(p, closestTriangle, stack);
+		}
+	}
+};
+
+///writes the values of the distance field to memory allocated in advance, like btSdfDataStream reads them
+struct btMiniSDFDataWriter
+{
+	char* m_data;
+	int m_offset;
+
+	btMiniSDFDataWriter(char* data)
+		: m_data(data),
+		  m_offset(0)
+	{
+	}
+
+	template <class T>
+	void write(const T& value)
+	{
+		memcpy(m_data + m_offset, &value, sizeof(T));
+		m_offset += sizeof(T);
+	}
+
+	void write(const void* values, int size)
+	{
+		memcpy(m_data + m_offset, values, size);
+		m_offset += size;
+	}
+};
+
+btMiniSDFBuilder::btMiniSDFBuilder()
+	: m_domainMin(0, 0, 0),
+	  m_domainMax(0, 0, 0),
+	  m_hasDomain(false),
+	  m_domainPadding(btScalar(0.1)),
+	  m_grainSize(256)
+{
+	m_resolution[0] = m_resolution[1] = m_resolution[2] = 32;
+}
+
+void btMiniSDFBuilder::setResolution(int resolutionX, int resolutionY, int resolutionZ)
+{
+	btAssert(resolutionX > 0 && resolutionY > 0 && resolutionZ > 0);
+	m_resolution[0] = resolutionX;
+	m_resolution[1] = resolutionY;
+	m_resolution[2] = resolutionZ;
+}
+
+void btMiniSDFBuilder::setDomain(const btVector3& domainMin, const btVector3& domainMax)
+{
+	m_domainMin = domainMin;
+	m_domainMax = domainMax;
+	m_hasDomain = true;
+}
+
+bool btMiniSDFBuilder::build(const btStridingMeshInterface* meshInterface, btAlignedObjectArray<char>& sdfData) const
+{
+	BT_PROFILE("btMiniSDFBuilder::build");
+	sdfData.resize(0);
+
+	btMiniSDFMesh mesh;
+	const btVector3 aabbMax(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+	meshInterface->InternalProcessAllTriangles(&mesh, -aabbMax, aabbMax);
+	if (!mesh.getNumTriangles())
+	{
+		return false;
+	}
+
+	btDbvt tree;
+	btVector3 meshMin = mesh.m_vertices[0];
+	btVector3 meshMax = mesh.m_vertices[0];
+	for (int i = 0; i < mesh.getNumTriangles(); i++)
+	{
+		const int* vertices = &mesh.m_triangles[3 * i];
+		btVector3 points[3] = {mesh.m_vertices[vertices[0]], mesh.m_vertices[vertices[1]], mesh.m_vertices[vertices[2]]};
+		const btDbvtVolume volume = btDbvtVolume::FromPoints(points, 3);
+		meshMin.setMin(volume.Mins());
+		meshMax.setMax(volume.Maxs());
+		btDbvtNode* leaf = tree.insert(volume, 0);
+		leaf->dataAsInt = i;
+	}
+	tree.optimizeTopDown();
+
+	btVector3 domainMin = m_domainMin;
+	btVector3 domainMax = m_domainMax;
+	if (!m_hasDomain)
+	{
+		const btVector3 extent = meshMax - meshMin;
+		const btScalar padding = m_domainPadding * extent[extent.maxAxis()];
+		domainMin = meshMin - btVector3(padding, padding, padding);
+		domainMax = meshMax + btVector3(padding, padding, padding);
+	}
+
+	const btMiniSDFNodeLattice lattice(m_resolution);
+	btVector3 cellSize;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		cellSize[axis] = (domainMax[axis] - domainMin[axis]) / btScalar(m_resolution[axis]);
+	}
+	btAlignedObjectArray<double> distances;
+	distances.resize(lattice.m_numNodes);
+	{
+		BT_PROFILE("computeDistances");
+		btMiniSDFDistanceLoop loop(mesh, tree, lattice);
+		loop.m_domainMin = domainMin;
+		loop.m_latticeSpacing = cellSize / btScalar(3.);
+		loop.m_distances = &distances[0];
+#if BT_THREADSAFE
+		if (btGetTaskScheduler())
+		{
+			btParallelFor(0, lattice.m_numNodes, m_grainSize, loop);
+		}
+		else
+#endif  //BT_THREADSAFE
+		{
+			loop.forLoop(0, lattice.m_numNodes);
+		}
+	}
+
+	const unsigned int numCells = m_resolution[0] * m_resolution[1] * m_resolution[2];
+	const unsigned long long int numFields = 1;
+	const int headerSize = 6 * sizeof(double) + 3 * sizeof(unsigned int) + 6 * sizeof(double) + 2 * sizeof(unsigned long long int);
+	const int nodesSize = 2 * sizeof(unsigned long long int) + lattice.m_numNodes * sizeof(double);
+	const int cellsSize = 2 * sizeof(unsigned long long int) + numCells * sizeof(btCell32);
+	const int cellMapSize = 2 * sizeof(unsigned long long int) + numCells * sizeof(unsigned int);
+	sdfData.resize(headerSize + nodesSize + cellsSize + cellMapSize);
+	btMiniSDFDataWriter writer(&sdfData[0]);
+
+	writer.write(double(domainMin[0]));
+	writer.write(double(domainMin[1]));
+	writer.write(double(domainMin[2]));
+	writer.write(double(domainMax[0]));
+	writer.write(double(domainMax[1]));
+	writer.write(double(domainMax[2]));
+	for (int axis = 0; axis < 3; axis++)
+	{
+		writer.write(static_cast<unsigned int>(m_resolution[axis]));
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		writer.write(double(cellSize[axis]));
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		writer.write(1.0 / double(cellSize[axis]));
+	}
+	writer.write(static_cast<unsigned long long int>(numCells));
+	writer.write(numFields);
+
+	//the node values
+	writer.write(numFields);
+	writer.write(static_cast<unsigned long long int>(lattice.m_numNodes));
+	writer.write(&distances[0], lattice.m_numNodes * sizeof(double));
+
+	//the nodes of the cells, in the order of the shape functions of btMiniSDF
+	writer.write(numFields);
+	writer.write(static_cast<unsigned long long int>(numCells));
+	unsigned int cellLattice[32][3];
+	for (int n = 0; n < 32; n++)
+	{
+		btMiniSDF::getCellNodeLattice(n, cellLattice[n]);
+	}
+	for (int k = 0; k < m_resolution[2]; k++)
+	{
+		for (int j = 0; j < m_resolution[1]; j++)
+		{
+			for (int i = 0; i < m_resolution[0]; i++)
+			{
+				btCell32 cell;
+				for (int n = 0; n < 32; n++)
+				{
+					const unsigned int nodeLattice[3] = {3 * i + cellLattice[n][0], 3 * j + cellLattice[n][1], 3 * k + cellLattice[n][2]};
+					cell.m_cells[n] = lattice.getNodeIndex(nodeLattice);
+				}
+				writer.write(cell);
+			}
+		}
+	}
+
+	//all cells have values
+	writer.write(numFields);
+	writer.write(static_cast<unsigned long long int>(numCells));
+	for (unsigned int l = 0; l < numCells; l++)
+	{
+		writer.write(l);
+	}
+	btAssert(writer.m_offset == sdfData.size());
+	return true;
+}
+
+bool btMiniSDFBuilder::writeFile(const char* fileName, const btAlignedObjectArray<char>& sdfData)
+{
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+	{
+		return false;
+	}
+	const size_t size = sdfData.size();
+	const bool written = !size || fwrite(&sdfData[0], 1, size, file) == size;
+	return fclose(file) == 0 && written;
+}
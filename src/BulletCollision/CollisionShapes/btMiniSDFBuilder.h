@@ -0,0 +1,66 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MINI_SDF_BUILDER_H
+#define BT_MINI_SDF_BUILDER_H
+
+#include "LinearMath/btVector3.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+class btStridingMeshInterface;
+
+///btMiniSDFBuilder computes the signed distance field of a triangle mesh on a grid of cubic cells, and stores it in the
+///Discregrid format loaded by btMiniSDF and btSdfCollisionShape::initializeSDF, so the fields no longer have to come from external tools.
+///The distance of each node is the distance to the closest triangle, found with a btDbvt of the triangles, and its sign
+///is given by the angle weighted pseudo normal of the closest feature of that triangle. The mesh has to be closed, with the
+///triangles wound counter clockwise seen from the outside. The nodes are computed with btParallelFor when a task scheduler
+///is set with btSetTaskScheduler in a BT_THREADSAFE build, and one after the other otherwise.
+class btMiniSDFBuilder
+{
+	int m_resolution[3];
+	btVector3 m_domainMin;
+	btVector3 m_domainMax;
+	bool m_hasDomain;
+	btScalar m_domainPadding;
+	int m_grainSize;
+
+public:
+	btMiniSDFBuilder();
+
+	///the number of cells along each axis
+	void setResolution(int resolutionX, int resolutionY, int resolutionZ);
+
+	///the box covered by the distance field, the aabb of the mesh expanded by the domain padding when not set
+	void setDomain(const btVector3& domainMin, const btVector3& domainMax);
+
+	///the padding added on each side of the aabb of the mesh, relative to its largest extent
+	void setDomainPadding(btScalar padding)
+	{
+		m_domainPadding = padding;
+	}
+
+	///the number of nodes computed by each task of btParallelFor
+	void setGrainSize(int grainSize)
+	{
+		m_grainSize = grainSize;
+	}
+
+	///computes the distance field of the triangles of the mesh, including its scaling, and returns false when the mesh has no triangles
+	bool build(const btStridingMeshInterface* meshInterface, btAlignedObjectArray<char>& sdfData) const;
+
+	static bool writeFile(const char* fileName, const btAlignedObjectArray<char>& sdfData);
+};
+
+#endif  //BT_MINI_SDF_BUILDER_H
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #include "btStridingMeshInterface.h"
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btIDebugDraw.h"
+#include "LinearMath/btQuickprof.h"
 
 btOptimizedBvh::btOptimizedBvh()
 {
@@ -26,7 +27,7 @@ btOptimizedBvh::~btOptimizedBvh()
 {
 }
 
-void btOptimizedBvh::build(btStridingMeshInterface* triangles, bool useQuantizedAabbCompression, const btVector3& bvhAabbMin, const btVector3& bvhAabbMax)
+void btOptimizedBvh::build(btStridingMeshInterface* triangles, bool useQuantizedAabbCompression, const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, btBuildMode buildMode)
 {
 	m_useQuantization = useQuantizedAabbCompression;
 
@@ -169,7 +170,14 @@ void btOptimizedBvh::build(btStridingMeshInterface* triangles, bool useQuantized
 
 	m_curNodeIndex = 0;
 
-	buildTree(0, numLeafNodes);
+	if (buildMode == BUILD_SURFACE_AREA_HEURISTIC)
+	{
+		buildTreeSah(numLeafNodes);
+	}
+	else
+	{
+		buildTree(0, numLeafNodes);
+	}
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if (m_useQuantization && !m_SubtreeHeaders.size())
@@ -354,6 +362,315 @@ void btOptimizedBvh::updateBvhNodes(btStridingMeshInterface* meshInterface, int
 		meshInterface->unLockReadOnlyVertexBase(curNodeSubPart);
 }
 
+static SIMD_FORCE_INLINE btScalar btOptimizedBvhHalfArea(const btQuantizedBvhNode& node, const btVector3& quantization)
+{
+	const btScalar x = btScalar(node.m_quantizedAabbMax[0] - node.m_quantizedAabbMin[0]) / quantization.getX();
+	const btScalar y = btScalar(node.m_quantizedAabbMax[1] - node.m_quantizedAabbMin[1]) / quantization.getY();
+	const btScalar z = btScalar(node.m_quantizedAabbMax[2] - node.m_quantizedAabbMin[2]) / quantization.getZ();
+	return x * y + y * z + z * x;
+}
+
+static void btOptimizedBvhCalcTriangleAabb(const unsigned char* vertexbase, PHY_ScalarType type, int stride, const unsigned char* indexbase, int indexstride, PHY_ScalarType indicestype, int triangleIndex, const btVector3& meshScaling, btVector3& aabbMin, btVector3& aabbMax)
+{
+	const unsigned char* gfxbase = indexbase + triangleIndex * indexstride;
+	aabbMin.setValue(btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT));
+	aabbMax.setValue(btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT));
+	for (int j = 0; j < 3; j++)
+	{
+		int graphicsindex = 0;
+		switch (indicestype)
+		{
+			case PHY_INTEGER:
+				graphicsindex = ((const unsigned int*)gfxbase)[j];
+				break;
+			case PHY_SHORT:
+				graphicsindex = ((const unsigned short*)gfxbase)[j];
+				break;
+			case PHY_UCHAR:
+				graphicsindex = gfxbase[j];
+				break;
+			default:
+				btAssert(0);
+		}
+		btVector3 vertex;
+		if (type == PHY_FLOAT)
+		{
+			const float* graphicsbase = (const float*)(vertexbase + graphicsindex * stride);
+			vertex.setValue(graphicsbase[0] * meshScaling.getX(), graphicsbase[1] * meshScaling.getY(), graphicsbase[2] * meshScaling.getZ());
+		}
+		else
+		{
+			const double* graphicsbase = (const double*)(vertexbase + graphicsindex * stride);
+			vertex.setValue(btScalar(graphicsbase[0] * meshScaling.getX()), btScalar(graphicsbase[1] * meshScaling.getY()), btScalar(graphicsbase[2] * meshScaling.getZ()));
+		}
+		aabbMin.setMin(vertex);
+		aabbMax.setMax(vertex);
+	}
+}
+
+struct btOptimizedBvhNodeIndexLess
+{
+	bool operator()(int a, int b) const
+	{
+		return a < b;
+	}
+};
+
+void btOptimizedBvh::initRefitData(btOptimizedBvhRefitData& data) const
+{
+	data.clear();
+
+	//the triangle counts of the parts are taken from the leaves, so the mesh is not locked
+	btAlignedObjectArray<int>& offsets = data.m_partTriangleOffsets;
+	for (int i = 0; i < m_curNodeIndex; i++)
+	{
+		const btQuantizedBvhNode& node = m_quantizedContiguousNodes[i];
+		if (node.isLeafNode())
+		{
+			const int partId = node.getPartId();
+			while (offsets.size() <= partId + 1)
+			{
+				offsets.push_back(0);
+			}
+			offsets[partId + 1] = btMax(offsets[partId + 1], node.getTriangleIndex() + 1);
+		}
+	}
+	for (int i = 1; i < offsets.size(); i++)
+	{
+		offsets[i] += offsets[i - 1];
+	}
+
+	data.m_triangleLeafNodes.resize(offsets.size() ? offsets[offsets.size() - 1] : 0, -1);
+	data.m_costs.resize(m_curNodeIndex);
+	data.m_builtCosts.resize(m_curNodeIndex);
+	resetRefitData(data, 0, m_curNodeIndex);
+}
+
+void btOptimizedBvh::resetRefitData(btOptimizedBvhRefitData& data, int firstNode, int endNode) const
+{
+	//children follow their parent, so walking backwards visits them first
+	for (int i = endNode - 1; i >= firstNode; i--)
+	{
+		const btQuantizedBvhNode& node = m_quantizedContiguousNodes[i];
+		if (node.isLeafNode())
+		{
+			data.m_triangleLeafNodes[data.m_partTriangleOffsets[node.getPartId()] + node.getTriangleIndex()] = i;
+			data.m_costs[i] = btScalar(0.);
+		}
+		else
+		{
+			const int leftChildNodeIndex = i + 1;
+			const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+			const int rightChildNodeIndex = leftChildNodeIndex + (leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+			data.m_costs[i] = btOptimizedBvhHalfArea(node, m_bvhQuantization) + data.m_costs[leftChildNodeIndex] + data.m_costs[rightChildNodeIndex];
+		}
+		data.m_builtCosts[i] = data.m_costs[i];
+	}
+}
+
+///the dirty nodes are sorted, so the ones below the right child follow the ones below the left child
+static SIMD_FORCE_INLINE int btOptimizedBvhCountNodesBelow(const int* dirtyNodes, int numDirtyNodes, int nodeIndex)
+{
+	int lo = 0;
+	int hi = numDirtyNodes;
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) >> 1;
+		if (dirtyNodes[mid] < nodeIndex)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+void btOptimizedBvh::refitDirtyNodes(btOptimizedBvhRefitData& data, int nodeIndex, const int* dirtyNodes, int numDirtyNodes)
+{
+	const btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+	if (node.isLeafNode())
+	{
+		return;
+	}
+	const int leftChildNodeIndex = nodeIndex + 1;
+	const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+	const int rightChildNodeIndex = leftChildNodeIndex + (leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+	const int numLeftDirtyNodes = btOptimizedBvhCountNodesBelow(dirtyNodes, numDirtyNodes, rightChildNodeIndex);
+	if (numLeftDirtyNodes > 0)
+	{
+		refitDirtyNodes(data, leftChildNodeIndex, dirtyNodes, numLeftDirtyNodes);
+	}
+	if (numLeftDirtyNodes < numDirtyNodes)
+	{
+		refitDirtyNodes(data, rightChildNodeIndex, dirtyNodes + numLeftDirtyNodes, numDirtyNodes - numLeftDirtyNodes);
+	}
+	mergeChildNodes(nodeIndex, leftChildNodeIndex, rightChildNodeIndex, node.getEscapeIndex());
+	data.m_costs[nodeIndex] = btOptimizedBvhHalfArea(node, m_bvhQuantization) + data.m_costs[leftChildNodeIndex] + data.m_costs[rightChildNodeIndex];
+}
+
+void btOptimizedBvh::rebuildDegradedSubtrees(btOptimizedBvhRefitData& data, int nodeIndex, const int* dirtyNodes, int numDirtyNodes)
+{
+	const btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+	if (node.isLeafNode())
+	{
+		return;
+	}
+
+	//the topmost degraded subtree is rebuilt, this also repairs the degraded subtrees below it
+	const int numNodes = node.getEscapeIndex();
+	const int numLeafNodes = (numNodes + 1) / 2;
+	if (numLeafNodes > 2 && numLeafNodes <= data.m_maxRebuildLeafCount && data.m_costs[nodeIndex] > data.m_maxCostGrowth * data.m_builtCosts[nodeIndex])
+	{
+		rebuildSubtree(nodeIndex);
+		resetRefitData(data, nodeIndex, nodeIndex + numNodes);
+		data.m_numRebuiltSubtrees++;
+		data.m_numRebuiltLeafNodes += numLeafNodes;
+		return;
+	}
+
+	const int leftChildNodeIndex = nodeIndex + 1;
+	const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+	const int rightChildNodeIndex = leftChildNodeIndex + (leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+	const int numLeftDirtyNodes = btOptimizedBvhCountNodesBelow(dirtyNodes, numDirtyNodes, rightChildNodeIndex);
+	if (numLeftDirtyNodes > 0)
+	{
+		rebuildDegradedSubtrees(data, leftChildNodeIndex, dirtyNodes, numLeftDirtyNodes);
+	}
+	if (numLeftDirtyNodes < numDirtyNodes)
+	{
+		rebuildDegradedSubtrees(data, rightChildNodeIndex, dirtyNodes + numLeftDirtyNodes, numDirtyNodes - numLeftDirtyNodes);
+	}
+	data.m_costs[nodeIndex] = btOptimizedBvhHalfArea(node, m_bvhQuantization) + data.m_costs[leftChildNodeIndex] + data.m_costs[rightChildNodeIndex];
+}
+
+bool btOptimizedBvh::refitDirtyTriangles(btStridingMeshInterface* meshInterface, btOptimizedBvhRefitData& data)
+{
+	BT_PROFILE("btOptimizedBvh::refitDirtyTriangles");
+	btAssert(m_useQuantization);
+
+	data.m_numDirtyLeafNodes = 0;
+	data.m_numRebuiltSubtrees = 0;
+	data.m_numRebuiltLeafNodes = 0;
+	data.m_dirtyAabbMin.setValue(btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT));
+	data.m_dirtyAabbMax.setValue(btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT));
+	if (!m_useQuantization || m_curNodeIndex == 0)
+	{
+		return true;
+	}
+	if (data.m_costs.size() != m_curNodeIndex)
+	{
+		initRefitData(data);
+	}
+
+	//leaf nodes of the dirty triangles, sorted and without duplicates
+	const btAlignedObjectArray<btDirtyTriangle>& dirtyTriangles = meshInterface->getDirtyTriangles();
+	btAlignedObjectArray<int> dirtyNodes;
+	dirtyNodes.reserve(dirtyTriangles.size());
+	for (int i = 0; i < dirtyTriangles.size(); i++)
+	{
+		const btDirtyTriangle& triangle = dirtyTriangles[i];
+		if (triangle.m_subPart < 0 || triangle.m_subPart + 1 >= data.m_partTriangleOffsets.size() || triangle.m_triangleIndex < 0)
+		{
+			continue;
+		}
+		const int triangleOffset = data.m_partTriangleOffsets[triangle.m_subPart] + triangle.m_triangleIndex;
+		if (triangleOffset < data.m_partTriangleOffsets[triangle.m_subPart + 1] && data.m_triangleLeafNodes[triangleOffset] >= 0)
+		{
+			dirtyNodes.push_back(data.m_triangleLeafNodes[triangleOffset]);
+		}
+	}
+	if (dirtyNodes.size() == 0)
+	{
+		return true;
+	}
+	dirtyNodes.quickSort(btOptimizedBvhNodeIndexLess());
+	int numDirtyNodes = 1;
+	for (int i = 1; i < dirtyNodes.size(); i++)
+	{
+		if (dirtyNodes[i] != dirtyNodes[numDirtyNodes - 1])
+		{
+			dirtyNodes[numDirtyNodes++] = dirtyNodes[i];
+		}
+	}
+	dirtyNodes.resize(numDirtyNodes);
+
+	//read all dirty triangles first, the tree is left untouched if one of them left the quantization range
+	btAlignedObjectArray<btVector3> dirtyAabbs;
+	dirtyAabbs.resize(2 * numDirtyNodes);
+	{
+		int curNodeSubPart = -1;
+		const unsigned char* vertexbase = 0;
+		int numverts = 0;
+		PHY_ScalarType type = PHY_INTEGER;
+		int stride = 0;
+		const unsigned char* indexbase = 0;
+		int indexstride = 0;
+		int numfaces = 0;
+		PHY_ScalarType indicestype = PHY_INTEGER;
+		const btVector3& meshScaling = meshInterface->getScaling();
+
+		for (int i = 0; i < numDirtyNodes; i++)
+		{
+			const btQuantizedBvhNode& node = m_quantizedContiguousNodes[dirtyNodes[i]];
+			const int nodeSubPart = node.getPartId();
+			if (nodeSubPart != curNodeSubPart)
+			{
+				if (curNodeSubPart >= 0)
+					meshInterface->unLockReadOnlyVertexBase(curNodeSubPart);
+				meshInterface->getLockedReadOnlyVertexIndexBase(&vertexbase, numverts, type, stride, &indexbase, indexstride, numfaces, indicestype, nodeSubPart);
+				curNodeSubPart = nodeSubPart;
+			}
+			btOptimizedBvhCalcTriangleAabb(vertexbase, type, stride, indexbase, indexstride, indicestype, node.getTriangleIndex(), meshScaling, dirtyAabbs[2 * i], dirtyAabbs[2 * i + 1]);
+			data.m_dirtyAabbMin.setMin(dirtyAabbs[2 * i]);
+			data.m_dirtyAabbMax.setMax(dirtyAabbs[2 * i + 1]);
+		}
+		if (curNodeSubPart >= 0)
+			meshInterface->unLockReadOnlyVertexBase(curNodeSubPart);
+	}
+
+	if (data.m_dirtyAabbMin.getX() < m_bvhAabbMin.getX() || data.m_dirtyAabbMin.getY() < m_bvhAabbMin.getY() || data.m_dirtyAabbMin.getZ() < m_bvhAabbMin.getZ() ||
+		data.m_dirtyAabbMax.getX() > m_bvhAabbMax.getX() || data.m_dirtyAabbMax.getY() > m_bvhAabbMax.getY() || data.m_dirtyAabbMax.getZ() > m_bvhAabbMax.getZ())
+	{
+		btVector3 aabbMin = m_bvhAabbMin;
+		btVector3 aabbMax = m_bvhAabbMax;
+		aabbMin.setMin(data.m_dirtyAabbMin);
+		aabbMax.setMax(data.m_dirtyAabbMax);
+		refit(meshInterface, aabbMin, aabbMax);
+
+		//the topology did not change, so the costs of the build stay the reference
+		btAlignedObjectArray<btScalar> builtCosts;
+		builtCosts.copyFromArray(data.m_builtCosts);
+		resetRefitData(data, 0, m_curNodeIndex);
+		data.m_builtCosts.copyFromArray(builtCosts);
+		data.m_numDirtyLeafNodes = numDirtyNodes;
+		rebuildDegradedSubtrees(data, 0, &dirtyNodes[0], numDirtyNodes);
+		return false;
+	}
+
+	for (int i = 0; i < numDirtyNodes; i++)
+	{
+		btQuantizedBvhNode& node = m_quantizedContiguousNodes[dirtyNodes[i]];
+		data.m_dirtyAabbMin.setMin(unQuantize(&node.m_quantizedAabbMin[0]));
+		data.m_dirtyAabbMax.setMax(unQuantize(&node.m_quantizedAabbMax[0]));
+		quantize(&node.m_quantizedAabbMin[0], dirtyAabbs[2 * i], 0);
+		quantize(&node.m_quantizedAabbMax[0], dirtyAabbs[2 * i + 1], 1);
+	}
+	data.m_numDirtyLeafNodes = numDirtyNodes;
+
+	refitDirtyNodes(data, 0, &dirtyNodes[0], numDirtyNodes);
+	rebuildDegradedSubtrees(data, 0, &dirtyNodes[0], numDirtyNodes);
+
+	for (int i = 0; i < m_SubtreeHeaders.size(); i++)
+	{
+		btBvhSubtreeInfo& subtree = m_SubtreeHeaders[i];
+		subtree.setAabbFromQuantizeNode(m_quantizedContiguousNodes[subtree.m_rootNodeIndex]);
+	}
+	return true;
+}
+
 ///deSerializeInPlace loads and initializes a BVH from a buffer in memory 'in place'
 btOptimizedBvh* btOptimizedBvh::deSerializeInPlace(void* i_alignedDataBuffer, unsigned int i_dataBufferSize, bool i_swapEndian)
 {
@@ -22,6 +22,51 @@ subject to the following restrictions:
 
 class btStridingMeshInterface;
 
+///btOptimizedBvhRefitData is the state of btOptimizedBvh::refitDirtyTriangles that is not part of the tree: the leaf node
+///of each triangle and the surface area cost of each subtree, now and when it was built. It is filled by the first refit.
+///It is kept outside the btOptimizedBvh, so that a tree serialized in place keeps its layout.
+ATTRIBUTE_ALIGNED16(struct)
+btOptimizedBvhRefitData
+{
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	///a subtree is rebuilt when its cost grew by more than this factor since it was built
+	btScalar m_maxCostGrowth;
+	///subtrees with more leaves are refit only, a lower count bounds the time of a single refit but lets the top of the tree degrade
+	int m_maxRebuildLeafCount;
+
+	///statistics of the last refit
+	int m_numDirtyLeafNodes;
+	int m_numRebuiltSubtrees;
+	int m_numRebuiltLeafNodes;
+	///bounds of the dirty triangles of the last refit, before and after they moved
+	btVector3 m_dirtyAabbMin;
+	btVector3 m_dirtyAabbMax;
+
+	btAlignedObjectArray<int> m_partTriangleOffsets;
+	btAlignedObjectArray<int> m_triangleLeafNodes;
+	btAlignedObjectArray<btScalar> m_costs;
+	btAlignedObjectArray<btScalar> m_builtCosts;
+
+	btOptimizedBvhRefitData()
+		: m_maxCostGrowth(btScalar(1.5)),
+		  m_maxRebuildLeafCount(0x7fffffff),
+		  m_numDirtyLeafNodes(0),
+		  m_numRebuiltSubtrees(0),
+		  m_numRebuiltLeafNodes(0)
+	{
+	}
+
+	///call clear when the tree was built again
+	void clear()
+	{
+		m_partTriangleOffsets.clear();
+		m_triangleLeafNodes.clear();
+		m_costs.clear();
+		m_builtCosts.clear();
+	}
+};
+
 ///The btOptimizedBvh extends the btQuantizedBvh to create AABB tree for triangle meshes, through the btStridingMeshInterface.
 ATTRIBUTE_ALIGNED16(class)
 btOptimizedBvh : public btQuantizedBvh
@@ -30,12 +75,20 @@ public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
 protected:
+	void initRefitData(btOptimizedBvhRefitData & data) const;
+
+	void resetRefitData(btOptimizedBvhRefitData & data, int firstNode, int endNode) const;
+
+	void refitDirtyNodes(btOptimizedBvhRefitData & data, int nodeIndex, const int* dirtyNodes, int numDirtyNodes);
+
+	void rebuildDegradedSubtrees(btOptimizedBvhRefitData & data, int nodeIndex, const int* dirtyNodes, int numDirtyNodes);
+
 public:
 	btOptimizedBvh();
 
 	virtual ~btOptimizedBvh();
 
-	void build(btStridingMeshInterface * triangles, bool useQuantizedAabbCompression, const btVector3& bvhAabbMin, const btVector3& bvhAabbMax);
+	void build(btStridingMeshInterface * triangles, bool useQuantizedAabbCompression, const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, btBuildMode buildMode = BUILD_SURFACE_AREA_HEURISTIC);
 
 	void refit(btStridingMeshInterface * triangles, const btVector3& aabbMin, const btVector3& aabbMax);
 
@@ -43,6 +96,12 @@ public:
 
 	void updateBvhNodes(btStridingMeshInterface * meshInterface, int firstNode, int endNode, int index);
 
+	///refitDirtyTriangles updates the leaves of the triangles marked with btStridingMeshInterface::markTriangleDirty and their
+	///ancestors only. Then it rebuilds the subtrees whose surface area cost grew by more than data.m_maxCostGrowth since they
+	///were built, so that a deforming mesh keeps the query performance of a fresh tree without paying for a full rebuild.
+	///Returns false when a dirty triangle left the quantization range: the whole tree is refit with a larger range then.
+	bool refitDirtyTriangles(btStridingMeshInterface * meshInterface, btOptimizedBvhRefitData & data);
+
 	/// Data buffer MUST be 16 byte aligned
 	virtual bool serializeInPlace(void* o_alignedDataBuffer, unsigned i_dataBufferSize, bool i_swapEndian) const
 	{
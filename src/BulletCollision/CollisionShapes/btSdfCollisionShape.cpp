@@ -7,6 +7,7 @@ struct btSdfCollisionShapeInternalData
 	btVector3 m_localScaling;
 	btScalar m_margin;
 	btMiniSDF m_sdf;
+	btAlignedObjectArray<btVector3> m_surfacePoints;
 
 	btSdfCollisionShapeInternalData()
 		: m_localScaling(1, 1, 1),
@@ -18,6 +19,11 @@ struct btSdfCollisionShapeInternalData
 bool btSdfCollisionShape::initializeSDF(const char* sdfData, int sizeInBytes)
 {
 	bool valid = m_data->m_sdf.load(sdfData, sizeInBytes);
+	m_data->m_surfacePoints.clear();
+	if (valid)
+	{
+		m_data->m_sdf.computeSurfacePoints(0, m_data->m_surfacePoints);
+	}
 	return valid;
 }
 btSdfCollisionShape::btSdfCollisionShape()
@@ -90,3 +96,24 @@ bool btSdfCollisionShape::queryPoint(const btVector3& ptInSDF, btScalar& distOut
 	}
 	return hasResult;
 }
+
+int btSdfCollisionShape::queryPoints(const btVector3* ptsInSDF, int numPoints, btScalar* distOut, btVector3* normalsOut) const
+{
+	int field = 0;
+	return m_data->m_sdf.interpolatePoints(field, ptsInSDF, numPoints, distOut, normalsOut);
+}
+
+void btSdfCollisionShape::buildNarrowBand(btScalar bandWidth)
+{
+	m_data->m_sdf.buildNarrowBand(bandWidth);
+}
+
+const btAlignedObjectArray<btVector3>& btSdfCollisionShape::getSurfacePoints() const
+{
+	return m_data->m_surfacePoints;
+}
+
+const btMiniSDF& btSdfCollisionShape::getSDF() const
+{
+	return m_data->m_sdf;
+}
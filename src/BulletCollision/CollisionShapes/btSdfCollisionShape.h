@@ -2,7 +2,12 @@
 #define BT_SDF_COLLISION_SHAPE_H
 
 #include "btConcaveShape.h"
+#include "LinearMath/btAlignedObjectArray.h"
 
+struct btMiniSDF;
+
+///btSdfCollisionShape is a static concave shape given by a signed distance field, see btMiniSDF and btMiniSDFBuilder.
+///btSdfCollisionAlgorithm computes its contacts with convex shapes and with other btSdfCollisionShape.
 class btSdfCollisionShape : public btConcaveShape
 {
 	struct btSdfCollisionShapeInternalData* m_data;
@@ -24,6 +29,19 @@ public:
 	virtual void processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const;
 
 	bool queryPoint(const btVector3& ptInSDF, btScalar& distOut, btVector3& normal);
+
+	///queries a batch of points, see btMiniSDF::interpolatePoints. The normals are the gradients of the distance,
+	///the points without distance get a distance of BT_LARGE_FLOAT. Returns the number of points with a distance.
+	int queryPoints(const btVector3* ptsInSDF, int numPoints, btScalar* distOut, btVector3* normalsOut) const;
+
+	///keeps only the bricks of the distance field within bandWidth of the surface, see btMiniSDF::buildNarrowBand.
+	///Deeper points get a distance clamped to bandWidth and the gradient at the center of their brick.
+	void buildNarrowBand(btScalar bandWidth);
+
+	///points on the surface of the shape, computed by initializeSDF and used for the contacts between two btSdfCollisionShape
+	const btAlignedObjectArray<btVector3>& getSurfacePoints() const;
+
+	const btMiniSDF& getSDF() const;
 };
 
 #endif  //BT_SDF_COLLISION_SHAPE_H
@@ -19,6 +19,14 @@ subject to the following restrictions:
 #include "LinearMath/btVector3.h"
 #include "btTriangleCallback.h"
 #include "btConcaveShape.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+///btDirtyTriangle identifies a triangle whose vertices moved, see btStridingMeshInterface::markTriangleDirty
+struct btDirtyTriangle
+{
+	int m_subPart;
+	int m_triangleIndex;
+};
 
 ///	The btStridingMeshInterface is the interface class for high performance generic access to triangle meshes, used in combination with btBvhTriangleMeshShape and some other collision shapes.
 /// Using index striding of 3*sizeof(integer) it can use triangle arrays, using index striding of 1*sizeof(integer) it can handle triangle strips.
@@ -28,6 +36,7 @@ btStridingMeshInterface
 {
 protected:
 	btVector3 m_scaling;
+	btAlignedObjectArray<btDirtyTriangle> m_dirtyTriangles;
 
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
@@ -86,6 +95,25 @@ public:
 		m_scaling = scaling;
 	}
 
+	///markTriangleDirty records a triangle whose vertices were moved, without changing the number of triangles.
+	///btBvhTriangleMeshShape::refitDirtyTriangles and btGImpactMeshShape::refitDirtyTriangles then only update the tree around the dirty triangles.
+	void markTriangleDirty(int subpart, int triangleIndex)
+	{
+		btDirtyTriangle& triangle = m_dirtyTriangles.expandNonInitializing();
+		triangle.m_subPart = subpart;
+		triangle.m_triangleIndex = triangleIndex;
+	}
+
+	const btAlignedObjectArray<btDirtyTriangle>& getDirtyTriangles() const
+	{
+		return m_dirtyTriangles;
+	}
+
+	void clearDirtyTriangles()
+	{
+		m_dirtyTriangles.resize(0);
+	}
+
 	virtual int calculateSerializeBufferSize() const;
 
 	///fills the dataBuffer and returns the struct name (and 0 on failure)
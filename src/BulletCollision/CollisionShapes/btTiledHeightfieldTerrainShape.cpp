@@ -0,0 +1,548 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btTiledHeightfieldTerrainShape.h"
+#include "LinearMath/btAabbUtil2.h"
+#include "LinearMath/btQuickprof.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BT_HEIGHTFIELD_TILE_FILE_VERSION 2
+///version 1 files do not store the height element size, only their PHY_UCHAR and PHY_SHORT tiles can be read
+#define BT_HEIGHTFIELD_TILE_FILE_VERSION_WITHOUT_ELEMENT_SIZE 1
+
+static const char btHeightfieldTileFileMagic[8] = {'B', 'T', 'H', 'F', 'T', 'I', 'L', 'E'};
+
+static int btGetHeightfieldElementSize(int heightDataType)
+{
+	int elementSize = 0;
+	switch (heightDataType)
+	{
+		case PHY_FLOAT:
+			elementSize = sizeof(btScalar);
+			break;
+		case PHY_UCHAR:
+			elementSize = sizeof(unsigned char);
+			break;
+		case PHY_SHORT:
+			elementSize = sizeof(short);
+			break;
+		default:
+			btAssert(0);
+	}
+	return elementSize;
+}
+
+static int btGetHeightfieldTileDataSize(const btHeightfieldTileInfo& tileInfo)
+{
+	return (tileInfo.m_tileSize + 1) * (tileInfo.m_tileSize + 1) * btGetHeightfieldElementSize(tileInfo.m_heightDataType);
+}
+
+///the tile heights start at 16 byte aligned offsets in the file
+static unsigned long long int btAlignHeightfieldTileOffset(unsigned long long int offset)
+{
+	return (offset + 15) & ~(unsigned long long int)15;
+}
+
+btMappedHeightfieldTileFile::btMappedHeightfieldTileFile()
+	: m_fileSize(0),
+	  m_viewAlignment(0),
+	  m_fileHandle(0),
+	  m_mappingHandle(0),
+	  m_fileDescriptor(-1)
+{
+	memset(&m_tileInfo, 0, sizeof(m_tileInfo));
+}
+
+btMappedHeightfieldTileFile::~btMappedHeightfieldTileFile()
+{
+	close();
+}
+
+int btMappedHeightfieldTileFile::getTileDataSize() const
+{
+	return btGetHeightfieldTileDataSize(m_tileInfo);
+}
+
+bool btMappedHeightfieldTileFile::open(const char* fileName)
+{
+	close();
+
+	//read the header and the tile offsets
+	FILE* file = fopen(fileName, "rb");
+	if (!file)
+	{
+		return false;
+	}
+	btHeightfieldTileFileHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1;
+	valid = valid && memcmp(header.m_magic, btHeightfieldTileFileMagic, sizeof(header.m_magic)) == 0;
+	valid = valid && header.m_numTilesX > 0 && header.m_numTilesZ > 0 && header.m_tileSize > 0;
+	valid = valid && (header.m_heightDataType == PHY_FLOAT || header.m_heightDataType == PHY_UCHAR || header.m_heightDataType == PHY_SHORT);
+	if (valid && header.m_version == BT_HEIGHTFIELD_TILE_FILE_VERSION)
+	{
+		//a file written with a different btScalar precision has PHY_FLOAT heights of a different size
+		valid = header.m_heightElementSize == btGetHeightfieldElementSize(header.m_heightDataType);
+	}
+	else
+	{
+		valid = valid && header.m_version == BT_HEIGHTFIELD_TILE_FILE_VERSION_WITHOUT_ELEMENT_SIZE && header.m_heightDataType != PHY_FLOAT;
+	}
+	if (valid)
+	{
+		m_tileInfo.m_numTilesX = header.m_numTilesX;
+		m_tileInfo.m_numTilesZ = header.m_numTilesZ;
+		m_tileInfo.m_tileSize = header.m_tileSize;
+		m_tileInfo.m_heightDataType = (PHY_ScalarType)header.m_heightDataType;
+		m_tileInfo.m_heightScale = header.m_heightScale;
+		m_tileInfo.m_minHeight = header.m_minHeight;
+		m_tileInfo.m_maxHeight = header.m_maxHeight;
+		m_tileOffsets.resize(header.m_numTilesX * header.m_numTilesZ);
+		valid = fread(&m_tileOffsets[0], sizeof(unsigned long long int), m_tileOffsets.size(), file) == (size_t)m_tileOffsets.size();
+	}
+	fclose(file);
+
+#if defined(WIN32) || defined(_WIN32)
+	if (valid)
+	{
+		HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		LARGE_INTEGER fileSize;
+		if (fileHandle != INVALID_HANDLE_VALUE && GetFileSizeEx(fileHandle, &fileSize))
+		{
+			m_fileHandle = fileHandle;
+			m_fileSize = fileSize.QuadPart;
+			m_mappingHandle = CreateFileMappingA(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+		}
+		else if (fileHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(fileHandle);
+		}
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		m_viewAlignment = systemInfo.dwAllocationGranularity;
+		valid = m_mappingHandle != 0;
+	}
+#else
+	if (valid)
+	{
+		m_fileDescriptor = ::open(fileName, O_RDONLY);
+		struct stat fileStat;
+		if (m_fileDescriptor >= 0 && fstat(m_fileDescriptor, &fileStat) == 0)
+		{
+			m_fileSize = fileStat.st_size;
+		}
+		m_viewAlignment = sysconf(_SC_PAGESIZE);
+		valid = m_fileSize > 0;
+	}
+#endif
+
+	//all tiles have to be inside of the file
+	const unsigned long long int tileDataSize = getTileDataSize();
+	for (int i = 0; valid && i < m_tileOffsets.size(); i++)
+	{
+		valid = m_tileOffsets[i] == 0 || m_tileOffsets[i] + tileDataSize <= m_fileSize;
+	}
+
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+	m_tileViews.resize(m_tileOffsets.size(), 0);
+	return true;
+}
+
+void btMappedHeightfieldTileFile::close()
+{
+	for (int i = 0; i < m_tileViews.size(); i++)
+	{
+		if (m_tileViews[i])
+		{
+			int numTilesX = m_tileInfo.m_numTilesX;
+			unmapTile(i % numTilesX, i / numTilesX, 0);
+		}
+	}
+	m_tileViews.clear();
+	m_tileOffsets.clear();
+#if defined(WIN32) || defined(_WIN32)
+	if (m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+#else
+	if (m_fileDescriptor >= 0)
+	{
+		::close(m_fileDescriptor);
+	}
+#endif
+	m_mappingHandle = 0;
+	m_fileHandle = 0;
+	m_fileDescriptor = -1;
+	m_fileSize = 0;
+}
+
+bool btMappedHeightfieldTileFile::hasTile(int tileX, int tileZ) const
+{
+	btAssert(tileX >= 0 && tileX < m_tileInfo.m_numTilesX && tileZ >= 0 && tileZ < m_tileInfo.m_numTilesZ);
+	return m_tileOffsets[tileZ * m_tileInfo.m_numTilesX + tileX] != 0;
+}
+
+const void* btMappedHeightfieldTileFile::mapTile(int tileX, int tileZ)
+{
+	int tileIndex = tileZ * m_tileInfo.m_numTilesX + tileX;
+	unsigned long long int offset = m_tileOffsets[tileIndex];
+	if (!offset)
+	{
+		return 0;
+	}
+	btAssert(!m_tileViews[tileIndex]);
+
+	//views start at a multiple of the page size or allocation granularity
+	unsigned long long int viewOffset = offset - offset % m_viewAlignment;
+	size_t viewSize = (size_t)(offset - viewOffset) + getTileDataSize();
+	void* view = 0;
+#if defined(WIN32) || defined(_WIN32)
+	view = MapViewOfFile((HANDLE)m_mappingHandle, FILE_MAP_READ, (DWORD)(viewOffset >> 32), (DWORD)(viewOffset & 0xffffffff), viewSize);
+#else
+	view = mmap(0, viewSize, PROT_READ, MAP_SHARED, m_fileDescriptor, (off_t)viewOffset);
+	if (view == MAP_FAILED)
+	{
+		view = 0;
+	}
+#endif
+	if (!view)
+	{
+		return 0;
+	}
+	m_tileViews[tileIndex] = view;
+	return (const char*)view + (offset - viewOffset);
+}
+
+void btMappedHeightfieldTileFile::unmapTile(int tileX, int tileZ, const void* /*heightData*/)
+{
+	int tileIndex = tileZ * m_tileInfo.m_numTilesX + tileX;
+	void* view = m_tileViews[tileIndex];
+	if (!view)
+	{
+		return;
+	}
+#if defined(WIN32) || defined(_WIN32)
+	UnmapViewOfFile(view);
+#else
+	unsigned long long int offset = m_tileOffsets[tileIndex];
+	size_t viewSize = (size_t)(offset % m_viewAlignment) + getTileDataSize();
+	munmap(view, viewSize);
+#endif
+	m_tileViews[tileIndex] = 0;
+}
+
+bool btMappedHeightfieldTileFile::writeFile(const char* fileName, const btHeightfieldTileInfo& tileInfo, const void* const* tileData)
+{
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	btHeightfieldTileFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, btHeightfieldTileFileMagic, sizeof(header.m_magic));
+	header.m_version = BT_HEIGHTFIELD_TILE_FILE_VERSION;
+	header.m_numTilesX = tileInfo.m_numTilesX;
+	header.m_numTilesZ = tileInfo.m_numTilesZ;
+	header.m_tileSize = tileInfo.m_tileSize;
+	header.m_heightDataType = tileInfo.m_heightDataType;
+	header.m_heightScale = float(tileInfo.m_heightScale);
+	header.m_minHeight = float(tileInfo.m_minHeight);
+	header.m_maxHeight = float(tileInfo.m_maxHeight);
+	header.m_heightElementSize = btGetHeightfieldElementSize(tileInfo.m_heightDataType);
+
+	const int numTiles = tileInfo.m_numTilesX * tileInfo.m_numTilesZ;
+	const unsigned long long int tileDataSize = btGetHeightfieldTileDataSize(tileInfo);
+	btAlignedObjectArray<unsigned long long int> tileOffsets;
+	tileOffsets.resize(numTiles, 0);
+	unsigned long long int offset = btAlignHeightfieldTileOffset(sizeof(header) + numTiles * sizeof(unsigned long long int));
+	for (int i = 0; i < numTiles; i++)
+	{
+		if (tileData[i])
+		{
+			tileOffsets[i] = offset;
+			offset = btAlignHeightfieldTileOffset(offset + tileDataSize);
+		}
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(&tileOffsets[0], sizeof(unsigned long long int), numTiles, file) == (size_t)numTiles;
+	unsigned long long int position = sizeof(header) + numTiles * sizeof(unsigned long long int);
+	const char padding[16] = {0};
+	for (int i = 0; ok && i < numTiles; i++)
+	{
+		if (tileData[i])
+		{
+			ok = fwrite(padding, 1, (size_t)(tileOffsets[i] - position), file) == (size_t)(tileOffsets[i] - position);
+			ok = ok && fwrite(tileData[i], 1, (size_t)tileDataSize, file) == (size_t)tileDataSize;
+			position = tileOffsets[i] + tileDataSize;
+		}
+	}
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
+
+btTiledHeightfieldTerrainShape::btTiledHeightfieldTerrainShape(btHeightfieldTileSource* tileSource, int upAxis, bool flipQuadEdges)
+	: btCompoundShape(true),
+	  m_tileSource(tileSource),
+	  m_tileInfo(tileSource->getTileInfo()),
+	  m_upAxis(upAxis),
+	  m_flipQuadEdges(flipQuadEdges),
+	  m_useDiamondSubdivision(false),
+	  m_useZigzagSubdivision(false),
+	  m_flipTriangleWinding(false),
+	  m_tileAcceleratorChunkSize(16),
+	  m_frame(0),
+	  m_tileKeepAliveFrames(30),
+	  m_maxResidentTiles(0)
+{
+	btAssert(upAxis >= 0 && upAxis < 3);
+	btAssert(m_tileInfo.m_minHeight <= m_tileInfo.m_maxHeight);
+	Tile tile;
+	tile.m_shape = 0;
+	tile.m_heightData = 0;
+	tile.m_lastRequestFrame = 0;
+	m_tiles.resize(m_tileInfo.m_numTilesX * m_tileInfo.m_numTilesZ, tile);
+	recalculateLocalAabb();
+}
+
+btTiledHeightfieldTerrainShape::~btTiledHeightfieldTerrainShape()
+{
+	pageOutAllTiles();
+}
+
+void btTiledHeightfieldTerrainShape::recalculateLocalAabb()
+{
+	//the aabb of all tiles, centered like btHeightfieldTerrainShape
+	btVector3 halfExtents;
+	halfExtents[m_upAxis] = btScalar(0.5) * (m_tileInfo.m_maxHeight - m_tileInfo.m_minHeight);
+	halfExtents[m_upAxis == 0 ? 1 : 0] = btScalar(0.5) * btScalar(m_tileInfo.m_numTilesX * m_tileInfo.m_tileSize);
+	halfExtents[m_upAxis == 2 ? 1 : 2] = btScalar(0.5) * btScalar(m_tileInfo.m_numTilesZ * m_tileInfo.m_tileSize);
+	halfExtents = (halfExtents * m_localScaling).absolute();
+	m_localAabbMin = -halfExtents;
+	m_localAabbMax = halfExtents;
+}
+
+void btTiledHeightfieldTerrainShape::getAabb(const btTransform& trans, btVector3& aabbMin, btVector3& aabbMax) const
+{
+	btVector3 localHalfExtents = btScalar(0.5) * (m_localAabbMax - m_localAabbMin);
+	btVector3 localCenter = btScalar(0.5) * (m_localAabbMax + m_localAabbMin);
+	localHalfExtents += btVector3(getMargin(), getMargin(), getMargin());
+
+	btMatrix3x3 abs_b = trans.getBasis().absolute();
+	btVector3 center = trans(localCenter);
+	btVector3 extent = localHalfExtents.dot3(abs_b[0], abs_b[1], abs_b[2]);
+	aabbMin = center - extent;
+	aabbMax = center + extent;
+}
+
+void btTiledHeightfieldTerrainShape::calculateLocalInertia(btScalar /*mass*/, btVector3& inertia) const
+{
+	//moving terrain is not supported
+	inertia.setValue(btScalar(0.), btScalar(0.), btScalar(0.));
+}
+
+btVector3 btTiledHeightfieldTerrainShape::getTileOrigin(int tileX, int tileZ) const
+{
+	const btScalar tileSize = btScalar(m_tileInfo.m_tileSize);
+	btVector3 origin(0, 0, 0);
+	origin[m_upAxis == 0 ? 1 : 0] = (btScalar(tileX) + btScalar(0.5)) * tileSize - btScalar(0.5) * tileSize * btScalar(m_tileInfo.m_numTilesX);
+	origin[m_upAxis == 2 ? 1 : 2] = (btScalar(tileZ) + btScalar(0.5)) * tileSize - btScalar(0.5) * tileSize * btScalar(m_tileInfo.m_numTilesZ);
+	return origin * m_localScaling;
+}
+
+void btTiledHeightfieldTerrainShape::getTileRange(const btVector3& aabbMin, const btVector3& aabbMax, int& startX, int& endX, int& startZ, int& endZ) const
+{
+	startX = 0;
+	endX = -1;
+	startZ = 0;
+	endZ = -1;
+	if (!TestAabbAgainstAabb2(aabbMin, aabbMax, m_localAabbMin, m_localAabbMax))
+	{
+		return;
+	}
+
+	//the grid coordinates of the aabb, the scaling may be negative
+	const btVector3 halfGridExtents = m_localAabbMax / m_localScaling.absolute();
+	const btVector3 gridCorner0 = aabbMin / m_localScaling + halfGridExtents;
+	const btVector3 gridCorner1 = aabbMax / m_localScaling + halfGridExtents;
+	btVector3 gridMin = gridCorner0;
+	btVector3 gridMax = gridCorner0;
+	gridMin.setMin(gridCorner1);
+	gridMax.setMax(gridCorner1);
+
+	const btScalar tileSize = btScalar(m_tileInfo.m_tileSize);
+	const int indexX = m_upAxis == 0 ? 1 : 0;
+	const int indexZ = m_upAxis == 2 ? 1 : 2;
+	startX = btMax(static_cast<int>(floor(gridMin[indexX] / tileSize)), 0);
+	endX = btMin(static_cast<int>(floor(gridMax[indexX] / tileSize)), m_tileInfo.m_numTilesX - 1);
+	startZ = btMax(static_cast<int>(floor(gridMin[indexZ] / tileSize)), 0);
+	endZ = btMin(static_cast<int>(floor(gridMax[indexZ] / tileSize)), m_tileInfo.m_numTilesZ - 1);
+}
+
+void btTiledHeightfieldTerrainShape::pageInTile(int tileIndex)
+{
+	BT_PROFILE("btTiledHeightfieldTerrainShape::pageInTile");
+	const int tileX = tileIndex % m_tileInfo.m_numTilesX;
+	const int tileZ = tileIndex / m_tileInfo.m_numTilesX;
+	const void* heightData = m_tileSource->mapTile(tileX, tileZ);
+	if (!heightData)
+	{
+		return;
+	}
+
+	const int tileSticks = m_tileInfo.m_tileSize + 1;
+	btHeightfieldTerrainShape* shape = new btHeightfieldTerrainShape(tileSticks, tileSticks, heightData, m_tileInfo.m_heightScale,
+																	   m_tileInfo.m_minHeight, m_tileInfo.m_maxHeight, m_upAxis,
+																	   m_tileInfo.m_heightDataType, m_flipQuadEdges);
+	shape->setUseDiamondSubdivision(m_useDiamondSubdivision);
+	shape->setUseZigzagSubdivision(m_useZigzagSubdivision);
+	shape->setFlipTriangleWinding(m_flipTriangleWinding);
+	shape->setLocalScaling(m_localScaling);
+	shape->setUserIndex(tileIndex);
+	if (m_tileAcceleratorChunkSize > 0)
+	{
+		shape->buildAccelerator(m_tileAcceleratorChunkSize);
+	}
+
+	btTransform tileTransform;
+	tileTransform.setIdentity();
+	tileTransform.setOrigin(getTileOrigin(tileX, tileZ));
+	addChildShape(tileTransform, shape);
+
+	Tile& tile = m_tiles[tileIndex];
+	tile.m_shape = shape;
+	tile.m_heightData = heightData;
+	m_residentTiles.push_back(tileIndex);
+}
+
+void btTiledHeightfieldTerrainShape::pageOutTile(int tileIndex)
+{
+	Tile& tile = m_tiles[tileIndex];
+	btAssert(tile.m_shape);
+	removeChildShape(tile.m_shape);
+	delete tile.m_shape;
+	m_tileSource->unmapTile(tileIndex % m_tileInfo.m_numTilesX, tileIndex / m_tileInfo.m_numTilesX, tile.m_heightData);
+	tile.m_shape = 0;
+	tile.m_heightData = 0;
+}
+
+void btTiledHeightfieldTerrainShape::requestTiles(const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	int startX, endX, startZ, endZ;
+	getTileRange(aabbMin, aabbMax, startX, endX, startZ, endZ);
+	for (int tileZ = startZ; tileZ <= endZ; tileZ++)
+	{
+		for (int tileX = startX; tileX <= endX; tileX++)
+		{
+			if (!m_tileSource->hasTile(tileX, tileZ))
+			{
+				continue;
+			}
+			int tileIndex = getTileIndex(tileX, tileZ);
+			m_tiles[tileIndex].m_lastRequestFrame = m_frame;
+			if (!m_tiles[tileIndex].m_shape)
+			{
+				pageInTile(tileIndex);
+			}
+		}
+	}
+}
+
+struct btTileRequestSortPredicate
+{
+	const btAlignedObjectArray<int>* m_lastRequestFrames;
+
+	bool operator()(int a, int b) const
+	{
+		return (*m_lastRequestFrames)[a] < (*m_lastRequestFrames)[b];
+	}
+};
+
+void btTiledHeightfieldTerrainShape::updatePaging()
+{
+	BT_PROFILE("btTiledHeightfieldTerrainShape::updatePaging");
+	for (int i = m_residentTiles.size() - 1; i >= 0; i--)
+	{
+		int tileIndex = m_residentTiles[i];
+		if (m_frame - m_tiles[tileIndex].m_lastRequestFrame > m_tileKeepAliveFrames)
+		{
+			pageOutTile(tileIndex);
+			m_residentTiles.swap(i, m_residentTiles.size() - 1);
+			m_residentTiles.pop_back();
+		}
+	}
+
+	if (m_maxResidentTiles > 0 && m_residentTiles.size() > m_maxResidentTiles)
+	{
+		//page out the least recently requested tiles first
+		btAlignedObjectArray<int> lastRequestFrames;
+		lastRequestFrames.resize(m_tiles.size());
+		for (int i = 0; i < m_residentTiles.size(); i++)
+		{
+			lastRequestFrames[m_residentTiles[i]] = m_tiles[m_residentTiles[i]].m_lastRequestFrame;
+		}
+		btTileRequestSortPredicate predicate;
+		predicate.m_lastRequestFrames = &lastRequestFrames;
+		m_residentTiles.quickSort(predicate);
+
+		int numPagedOut = 0;
+		while (m_residentTiles.size() - numPagedOut > m_maxResidentTiles &&
+			   m_tiles[m_residentTiles[numPagedOut]].m_lastRequestFrame < m_frame)
+		{
+			pageOutTile(m_residentTiles[numPagedOut]);
+			numPagedOut++;
+		}
+		for (int i = numPagedOut; i < m_residentTiles.size(); i++)
+		{
+			m_residentTiles[i - numPagedOut] = m_residentTiles[i];
+		}
+		m_residentTiles.resize(m_residentTiles.size() - numPagedOut);
+	}
+	m_frame++;
+}
+
+void btTiledHeightfieldTerrainShape::pageOutAllTiles()
+{
+	for (int i = 0; i < m_residentTiles.size(); i++)
+	{
+		pageOutTile(m_residentTiles[i]);
+	}
+	m_residentTiles.clear();
+}
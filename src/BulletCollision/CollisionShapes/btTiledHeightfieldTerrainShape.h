@@ -0,0 +1,233 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_TILED_HEIGHTFIELD_TERRAIN_SHAPE_H
+#define BT_TILED_HEIGHTFIELD_TERRAIN_SHAPE_H
+
+#include "btCompoundShape.h"
+#include "btHeightfieldTerrainShape.h"
+
+///the layout of the tiles of a btHeightfieldTileSource
+struct btHeightfieldTileInfo
+{
+	int m_numTilesX;
+	int m_numTilesZ;
+	///number of grid cells along each side of a tile, a tile stores (m_tileSize + 1) x (m_tileSize + 1) heights
+	///and shares its border heights with its neighbours
+	int m_tileSize;
+	PHY_ScalarType m_heightDataType;
+	btScalar m_heightScale;
+	btScalar m_minHeight;
+	btScalar m_maxHeight;
+};
+
+///btHeightfieldTileSource provides the height data of the tiles of a btTiledHeightfieldTerrainShape.
+///The heights of a tile are stored row by row like the heightfieldData of btHeightfieldTerrainShape,
+///in the m_heightDataType format, where PHY_FLOAT heights are btScalar values.
+///Tiles without data (holes, ocean) are not paged in and have no collision.
+class btHeightfieldTileSource
+{
+public:
+	virtual ~btHeightfieldTileSource() {}
+
+	virtual const btHeightfieldTileInfo& getTileInfo() const = 0;
+
+	virtual bool hasTile(int tileX, int tileZ) const = 0;
+
+	///returns the heights of the tile, which have to stay valid until unmapTile, or 0 on failure
+	virtual const void* mapTile(int tileX, int tileZ) = 0;
+
+	virtual void unmapTile(int tileX, int tileZ, const void* heightData) = 0;
+};
+
+///btMappedHeightfieldTileFile pages the tiles in and out of a tile file with one memory mapped view per tile,
+///so only the resident tiles take address space and memory, and the file can exceed 4 GB on 64 bit platforms.
+///The file starts with a btHeightfieldTileFileHeader, followed by a table of 64 bit byte offsets of the
+///tiles (0 for a tile without data) and the tile heights, see writeFile.
+class btMappedHeightfieldTileFile : public btHeightfieldTileSource
+{
+	btHeightfieldTileInfo m_tileInfo;
+	btAlignedObjectArray<unsigned long long int> m_tileOffsets;
+	btAlignedObjectArray<void*> m_tileViews;
+	unsigned long long int m_fileSize;
+	unsigned long long int m_viewAlignment;
+	void* m_fileHandle;
+	void* m_mappingHandle;
+	int m_fileDescriptor;
+
+	int getTileDataSize() const;
+
+public:
+	btMappedHeightfieldTileFile();
+
+	virtual ~btMappedHeightfieldTileFile();
+
+	///opens a tile file, returns false when the file can not be opened or is not a valid tile file
+	bool open(const char* fileName);
+
+	void close();
+
+	bool isOpen() const
+	{
+		return m_tileOffsets.size() != 0;
+	}
+
+	virtual const btHeightfieldTileInfo& getTileInfo() const
+	{
+		return m_tileInfo;
+	}
+
+	virtual bool hasTile(int tileX, int tileZ) const;
+
+	virtual const void* mapTile(int tileX, int tileZ);
+
+	virtual void unmapTile(int tileX, int tileZ, const void* heightData);
+
+	///writes a tile file. tileData[tileZ * numTilesX + tileX] points to the heights of each tile, or is 0 for a tile without data.
+	static bool writeFile(const char* fileName, const btHeightfieldTileInfo& tileInfo, const void* const* tileData);
+};
+
+// clang-format off
+
+///do not change the tile file header, the tile files written before would become unreadable. New fields take the padding
+///and a new version. PHY_FLOAT heights are btScalar, m_heightElementSize (version 2) tells float and double files apart.
+struct btHeightfieldTileFileHeader
+{
+	char	m_magic[8];
+	int		m_version;
+	int		m_numTilesX;
+	int		m_numTilesZ;
+	int		m_tileSize;
+	int		m_heightDataType;
+	float	m_heightScale;
+	float	m_minHeight;
+	float	m_maxHeight;
+	int		m_heightElementSize;
+	char	m_padding[4];
+};
+
+// clang-format on
+
+///btTiledHeightfieldTerrainShape is a terrain made of tiles of heights, that are paged in from a btHeightfieldTileSource
+///when they are needed and paged out when they are not, so only the heights around the moving bodies are resident.
+///The resident tiles are btHeightfieldTerrainShape children of the compound shape, so the terrain uses a single
+///collision object and broadphase proxy, the dynamic aabb tree of the compound to find the tiles, and the heightfield
+///paths for contacts, ray tests and convex sweeps. The aabb of the shape covers all tiles, whether they are resident or not.
+///The terrain is centered like a btHeightfieldTerrainShape with the same total number of heights. Tile (tileX, tileZ)
+///covers the grid cells tileX * tileSize to (tileX + 1) * tileSize along the width, and the user index of its shape is
+///tileZ * numTilesX + tileX, see getTileIndex. Contacts report the child index of the tile and the triangle ids within the tile.
+///
+///Paging is driven by the application: call requestTiles with the aabbs of the bodies in the local space of the
+///terrain, expanded by the distance they may travel before the next request, and then updatePaging once per frame.
+///Both change the children of the compound, so they may not run during the collision detection.
+///Paging in only adds children, so the compound collision algorithms keep their child algorithms and contact manifolds.
+///Paging out removes children, which changes the child indices: in the next frame, every pair with the terrain drops its
+///child algorithms and manifolds, and their contacts start again without warm starting. Keep the tiles resident long
+///enough with setTileKeepAliveFrames and setMaxResidentTiles so that paging out is rare.
+///When using diamond or zigzag subdivision, use an even tile size so the triangulation matches a single heightfield.
+ATTRIBUTE_ALIGNED16(class)
+btTiledHeightfieldTerrainShape : public btCompoundShape
+{
+	struct Tile
+	{
+		btHeightfieldTerrainShape* m_shape;
+		const void* m_heightData;
+		int m_lastRequestFrame;
+	};
+
+	btHeightfieldTileSource* m_tileSource;
+	btHeightfieldTileInfo m_tileInfo;
+	btAlignedObjectArray<Tile> m_tiles;
+	btAlignedObjectArray<int> m_residentTiles;
+	int m_upAxis;
+	bool m_flipQuadEdges;
+	bool m_useDiamondSubdivision;
+	bool m_useZigzagSubdivision;
+	bool m_flipTriangleWinding;
+	int m_tileAcceleratorChunkSize;
+	int m_frame;
+	int m_tileKeepAliveFrames;
+	int m_maxResidentTiles;
+
+	void pageInTile(int tileIndex);
+	void pageOutTile(int tileIndex);
+	btVector3 getTileOrigin(int tileX, int tileZ) const;
+	void getTileRange(const btVector3& aabbMin, const btVector3& aabbMax, int& startX, int& endX, int& startZ, int& endZ) const;
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	///the tile source is not owned by the shape and has to outlive it
+	btTiledHeightfieldTerrainShape(btHeightfieldTileSource * tileSource, int upAxis, bool flipQuadEdges);
+
+	virtual ~btTiledHeightfieldTerrainShape();
+
+	///the aabb of all tiles, whether they are resident or not
+	virtual void getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const;
+
+	virtual void recalculateLocalAabb();
+
+	virtual void calculateLocalInertia(btScalar mass, btVector3 & inertia) const;
+
+	///the options of the tiles, they apply to the tiles paged in afterwards
+	void setUseDiamondSubdivision(bool useDiamondSubdivision = true) { m_useDiamondSubdivision = useDiamondSubdivision; }
+	void setUseZigzagSubdivision(bool useZigzagSubdivision = true) { m_useZigzagSubdivision = useZigzagSubdivision; }
+	void setFlipTriangleWinding(bool flipTriangleWinding) { m_flipTriangleWinding = flipTriangleWinding; }
+
+	///the chunk size of btHeightfieldTerrainShape::buildAccelerator for the tiles, 0 to page in the tiles without accelerator
+	void setTileAcceleratorChunkSize(int chunkSize) { m_tileAcceleratorChunkSize = chunkSize; }
+
+	///the tiles that were not requested during the last keepAliveFrames calls to updatePaging are paged out
+	void setTileKeepAliveFrames(int keepAliveFrames) { m_tileKeepAliveFrames = keepAliveFrames; }
+
+	///when more tiles are resident, updatePaging pages out the least recently requested tiles that were not requested in the current frame
+	void setMaxResidentTiles(int maxResidentTiles) { m_maxResidentTiles = maxResidentTiles; }
+
+	///pages in the tiles overlapping the aabb, given in the local space of the terrain, and keeps them resident
+	void requestTiles(const btVector3& aabbMin, const btVector3& aabbMax);
+
+	///pages out the tiles that are no longer requested, call it once per frame after requestTiles
+	void updatePaging();
+
+	void pageOutAllTiles();
+
+	const btHeightfieldTileInfo& getTileInfo() const
+	{
+		return m_tileInfo;
+	}
+
+	int getTileIndex(int tileX, int tileZ) const
+	{
+		return tileZ * m_tileInfo.m_numTilesX + tileX;
+	}
+
+	///the shape of a resident tile, or 0
+	btHeightfieldTerrainShape* getTileShape(int tileX, int tileZ)
+	{
+		return m_tiles[getTileIndex(tileX, tileZ)].m_shape;
+	}
+
+	int getNumResidentTiles() const
+	{
+		return m_residentTiles.size();
+	}
+
+	virtual const char* getName() const
+	{
+		return "TiledHeightfield";
+	}
+};
+
+#endif  //BT_TILED_HEIGHTFIELD_TERRAIN_SHAPE_H
@@ -0,0 +1,1099 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btWideBvh.h"
+#include "btStridingMeshInterface.h"
+#include "btTriangleCallback.h"
+#include "BulletCollision/BroadphaseCollision/btQuantizedBvh.h"
+#include "BulletCollision/BroadphaseCollision/btBvhSahBinning.h"
+#include "BulletCollision/BroadphaseCollision/btRayPacket.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btQuickprof.h"
+
+#include <string.h>  //memcpy
+
+#if defined(BT_USE_SSE) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BT_WIDE_BVH_USE_SSE2 1
+#endif
+
+///the traversal stack holds at most 3 entries per level, the build keeps the tree below BT_WIDE_BVH_MAX_DEPTH levels
+#define BT_WIDE_BVH_STACK_SIZE 256
+///below this depth the builder uses the surface area heuristic, deeper nodes are split at the median
+///so that degenerate meshes cannot overflow the traversal stack
+#define BT_WIDE_BVH_MAX_SAH_DEPTH 48
+#define BT_WIDE_BVH_MAX_DEPTH (BT_WIDE_BVH_MAX_SAH_DEPTH + 16)
+#define BT_WIDE_BVH_NODE_ALIGNMENT 64
+
+//header of a leaf block: bits 0-3 triangle count - 1, bits 4-5 format, bits 6-31 part id
+enum btWideBvhLeafFormat
+{
+	///one part, first triangle index followed by 16 bit deltas to the other (sorted) triangle indices, two per int
+	BT_WIDE_BVH_LEAF_DELTA16 = 0,
+	///one part, one triangle index per int
+	BT_WIDE_BVH_LEAF_INDEX = 1,
+	///part id and triangle index pairs
+	BT_WIDE_BVH_LEAF_MIXED = 2
+};
+
+template <typename btLeafVisitor>
+static SIMD_FORCE_INLINE void btWideBvhVisitLeaf(const int* leaf, btLeafVisitor& visitor)
+{
+	const unsigned int header = (unsigned int)leaf[0];
+	const int count = int(header & 15) + 1;
+	const int partId = int(header >> 6);
+	switch ((header >> 4) & 3)
+	{
+		case BT_WIDE_BVH_LEAF_DELTA16:
+		{
+			const int base = leaf[1];
+			visitor(partId, base);
+			for (int i = 1; i < count; i++)
+			{
+				const unsigned int word = (unsigned int)leaf[2 + ((i - 1) >> 1)];
+				const int delta = int((i & 1) ? (word & 0xffff) : (word >> 16));
+				visitor(partId, base + delta);
+			}
+			break;
+		}
+		case BT_WIDE_BVH_LEAF_INDEX:
+		{
+			for (int i = 0; i < count; i++)
+			{
+				visitor(partId, leaf[1 + i]);
+			}
+			break;
+		}
+		default:
+		{
+			for (int i = 0; i < count; i++)
+			{
+				visitor(leaf[1 + 2 * i], leaf[2 + 2 * i]);
+			}
+		}
+	}
+}
+
+#ifdef BT_DEBUG
+///only used to check the leaf encoder
+static int btWideBvhLeafSize(const int* leaf)
+{
+	const unsigned int header = (unsigned int)leaf[0];
+	const int count = int(header & 15) + 1;
+	switch ((header >> 4) & 3)
+	{
+		case BT_WIDE_BVH_LEAF_DELTA16:
+			return 2 + count / 2;
+		case BT_WIDE_BVH_LEAF_INDEX:
+			return 1 + count;
+		default:
+			return 1 + 2 * count;
+	}
+}
+#endif  //BT_DEBUG
+
+struct btWideBvhNodeCallbackVisitor
+{
+	btNodeOverlapCallback* m_nodeCallback;
+
+	btWideBvhNodeCallbackVisitor(btNodeOverlapCallback* nodeCallback)
+		: m_nodeCallback(nodeCallback)
+	{
+	}
+	SIMD_FORCE_INLINE void operator()(int partId, int triangleIndex)
+	{
+		m_nodeCallback->processNode(partId, triangleIndex);
+	}
+};
+
+struct btWideBvhRayPacketCallbackVisitor
+{
+	btNodeRayPacketOverlapCallback* m_nodeCallback;
+	unsigned int m_rayMask;
+
+	btWideBvhRayPacketCallbackVisitor(btNodeRayPacketOverlapCallback* nodeCallback, unsigned int rayMask)
+		: m_nodeCallback(nodeCallback),
+		  m_rayMask(rayMask)
+	{
+	}
+	SIMD_FORCE_INLINE void operator()(int partId, int triangleIndex)
+	{
+		m_nodeCallback->processNode(partId, triangleIndex, m_rayMask);
+	}
+};
+
+///same minimum size as the leaf nodes of btOptimizedBvh, so that flat triangles have a non-empty box
+static void btWideBvhExpandTriangleAabb(btVector3& aabbMin, btVector3& aabbMax)
+{
+	const btScalar MIN_AABB_DIMENSION = btScalar(0.002);
+	const btScalar MIN_AABB_HALF_DIMENSION = btScalar(0.001);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (aabbMax[axis] - aabbMin[axis] < MIN_AABB_DIMENSION)
+		{
+			aabbMax[axis] += MIN_AABB_HALF_DIMENSION;
+			aabbMin[axis] -= MIN_AABB_HALF_DIMENSION;
+		}
+	}
+}
+
+///reads single triangles of the mesh, keeping the last used part locked
+struct btWideBvhTriangleReader
+{
+	btStridingMeshInterface* m_meshInterface;
+	int m_lockedPart;
+	const unsigned char* m_vertexbase;
+	int m_numverts;
+	PHY_ScalarType m_type;
+	int m_stride;
+	const unsigned char* m_indexbase;
+	int m_indexstride;
+	int m_numfaces;
+	PHY_ScalarType m_indicestype;
+
+	btWideBvhTriangleReader(btStridingMeshInterface* meshInterface)
+		: m_meshInterface(meshInterface),
+		  m_lockedPart(-1)
+	{
+	}
+
+	~btWideBvhTriangleReader()
+	{
+		if (m_lockedPart >= 0)
+		{
+			m_meshInterface->unLockReadOnlyVertexBase(m_lockedPart);
+		}
+	}
+
+	void getTriangleAabb(int partId, int triangleIndex, btVector3& aabbMin, btVector3& aabbMax)
+	{
+		if (partId != m_lockedPart)
+		{
+			if (m_lockedPart >= 0)
+			{
+				m_meshInterface->unLockReadOnlyVertexBase(m_lockedPart);
+			}
+			m_meshInterface->getLockedReadOnlyVertexIndexBase(&m_vertexbase, m_numverts, m_type, m_stride, &m_indexbase, m_indexstride, m_numfaces, m_indicestype, partId);
+			m_lockedPart = partId;
+		}
+
+		const unsigned int* gfxbase = (const unsigned int*)(m_indexbase + triangleIndex * m_indexstride);
+		const btVector3& meshScaling = m_meshInterface->getScaling();
+		aabbMin.setValue(btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT));
+		aabbMax.setValue(btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT));
+		for (int j = 0; j < 3; j++)
+		{
+			const int graphicsindex = m_indicestype == PHY_SHORT ? ((const unsigned short*)gfxbase)[j] : m_indicestype == PHY_INTEGER ? gfxbase[j] : ((const unsigned char*)gfxbase)[j];
+			btVector3 vertex;
+			if (m_type == PHY_FLOAT)
+			{
+				const float* graphicsbase = (const float*)(m_vertexbase + graphicsindex * m_stride);
+				vertex.setValue(graphicsbase[0] * meshScaling.getX(), graphicsbase[1] * meshScaling.getY(), graphicsbase[2] * meshScaling.getZ());
+			}
+			else
+			{
+				const double* graphicsbase = (const double*)(m_vertexbase + graphicsindex * m_stride);
+				vertex.setValue(btScalar(graphicsbase[0]) * meshScaling.getX(), btScalar(graphicsbase[1]) * meshScaling.getY(), btScalar(graphicsbase[2]) * meshScaling.getZ());
+			}
+			aabbMin.setMin(vertex);
+			aabbMax.setMax(vertex);
+		}
+		btWideBvhExpandTriangleAabb(aabbMin, aabbMax);
+	}
+};
+
+struct btWideBvhTriangleAabbVisitor
+{
+	btWideBvhTriangleReader& m_reader;
+	btVector3 m_aabbMin;
+	btVector3 m_aabbMax;
+
+	btWideBvhTriangleAabbVisitor(btWideBvhTriangleReader& reader)
+		: m_reader(reader),
+		  m_aabbMin(btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT)),
+		  m_aabbMax(btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT))
+	{
+	}
+	void operator()(int partId, int triangleIndex)
+	{
+		btVector3 aabbMin, aabbMax;
+		m_reader.getTriangleAabb(partId, triangleIndex, aabbMin, aabbMax);
+		m_aabbMin.setMin(aabbMin);
+		m_aabbMax.setMax(aabbMax);
+	}
+
+private:
+	btWideBvhTriangleAabbVisitor& operator=(const btWideBvhTriangleAabbVisitor&);
+};
+
+///the quantized query box, replicated for the 4 lanes of a node
+struct btWideBvhQuantizedQuery
+{
+#ifdef BT_WIDE_BVH_USE_SSE2
+	//x and y lanes in one register, z in the low half of another, biased for the signed 16 bit compares
+	__m128i m_minXY;
+	__m128i m_maxXY;
+	__m128i m_minZ;
+	__m128i m_maxZ;
+#endif
+	unsigned short m_quantizedAabbMin[3];
+	unsigned short m_quantizedAabbMax[3];
+
+	void init()
+	{
+#ifdef BT_WIDE_BVH_USE_SSE2
+		const __m128i bias = _mm_set1_epi16(short(0x8000));
+		m_minXY = _mm_xor_si128(_mm_unpacklo_epi64(_mm_set1_epi16(short(m_quantizedAabbMin[0])), _mm_set1_epi16(short(m_quantizedAabbMin[1]))), bias);
+		m_maxXY = _mm_xor_si128(_mm_unpacklo_epi64(_mm_set1_epi16(short(m_quantizedAabbMax[0])), _mm_set1_epi16(short(m_quantizedAabbMax[1]))), bias);
+		m_minZ = _mm_xor_si128(_mm_set1_epi16(short(m_quantizedAabbMin[2])), bias);
+		m_maxZ = _mm_xor_si128(_mm_set1_epi16(short(m_quantizedAabbMax[2])), bias);
+#endif
+	}
+};
+
+///returns the lanes of the node with a child that overlaps the query box
+static SIMD_FORCE_INLINE unsigned int btWideBvhOverlapMask(const btWideBvhNode& node, const btWideBvhQuantizedQuery& query)
+{
+#ifdef BT_WIDE_BVH_USE_SSE2
+	//SSE2 only has signed 16 bit compares, flipping the sign bit keeps the unsigned order
+	const __m128i bias = _mm_set1_epi16(short(0x8000));
+	const __m128i nodeMinXY = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&node.m_quantizedAabbMin[0][0]), bias);
+	const __m128i nodeMaxXY = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&node.m_quantizedAabbMax[0][0]), bias);
+	const __m128i nodeMinZ = _mm_xor_si128(_mm_loadl_epi64((const __m128i*)&node.m_quantizedAabbMin[2][0]), bias);
+	const __m128i nodeMaxZ = _mm_xor_si128(_mm_loadl_epi64((const __m128i*)&node.m_quantizedAabbMax[2][0]), bias);
+	const __m128i separatedXY = _mm_or_si128(_mm_cmpgt_epi16(nodeMinXY, query.m_maxXY), _mm_cmpgt_epi16(query.m_minXY, nodeMaxXY));
+	const __m128i separatedZ = _mm_or_si128(_mm_cmpgt_epi16(nodeMinZ, query.m_maxZ), _mm_cmpgt_epi16(query.m_minZ, nodeMaxZ));
+	const __m128i separated = _mm_or_si128(_mm_or_si128(separatedXY, _mm_srli_si128(separatedXY, 8)), separatedZ);
+	const __m128i empty = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)node.m_children), _mm_setzero_si128());
+	const unsigned int separatedMask = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(separated, separated)) & 15;
+	const unsigned int emptyMask = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(empty));
+	return ~(separatedMask | emptyMask) & 15;
+#else
+	unsigned int mask = 0;
+	for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+	{
+		bool overlap = node.m_children[i] != 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			overlap = overlap && node.m_quantizedAabbMin[axis][i] <= query.m_quantizedAabbMax[axis] && node.m_quantizedAabbMax[axis][i] >= query.m_quantizedAabbMin[axis];
+		}
+		mask |= overlap ? (1u << i) : 0u;
+	}
+	return mask;
+#endif
+}
+
+///a ray (or box cast) against the 4 dequantized child boxes of a node, the boxes are enlarged by the cast box like btQuantizedBvh does
+struct btWideBvhRay
+{
+	///bvhAabbMin - castAabbMax - raySource and bvhAabbMin - castAabbMin - raySource, added to the dequantized min and max
+	btScalar m_offsetMin[3];
+	btScalar m_offsetMax[3];
+	btScalar m_quantizationInverse[3];
+	btScalar m_directionInverse[3];
+	btScalar m_lambdaMax;
+
+	void init(const btVector3& bvhAabbMin, const btVector3& bvhQuantization, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax)
+	{
+		btVector3 rayDirection = (rayTarget - raySource);
+		rayDirection.safeNormalize();
+		m_lambdaMax = rayDirection.dot(rayTarget - raySource);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			///same as btQuantizedBvh::walkStacklessQuantizedTreeAgainstRay: a zero direction gets BT_LARGE_FLOAT
+			m_directionInverse[axis] = rayDirection[axis] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDirection[axis];
+			m_offsetMin[axis] = bvhAabbMin[axis] - aabbMax[axis] - raySource[axis];
+			m_offsetMax[axis] = bvhAabbMin[axis] - aabbMin[axis] - raySource[axis];
+			m_quantizationInverse[axis] = btScalar(1.0) / bvhQuantization[axis];
+		}
+	}
+};
+
+///returns the subset of mask for which the ray overlaps the child box
+static SIMD_FORCE_INLINE unsigned int btWideBvhRayMask(const btWideBvhNode& node, const btWideBvhRay& ray, unsigned int mask)
+{
+#if defined(BT_WIDE_BVH_USE_SSE2) && !defined(BT_USE_DOUBLE_PRECISION)
+	const __m128i zero = _mm_setzero_si128();
+	__m128 tmin = _mm_setzero_ps();
+	__m128 tmax = _mm_set1_ps(ray.m_lambdaMax);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const __m128 quantizedMin = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)node.m_quantizedAabbMin[axis]), zero));
+		const __m128 quantizedMax = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)node.m_quantizedAabbMax[axis]), zero));
+		const __m128 scale = _mm_set1_ps(ray.m_quantizationInverse[axis]);
+		const __m128 inv = _mm_set1_ps(ray.m_directionInverse[axis]);
+		const __m128 t0 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(quantizedMin, scale), _mm_set1_ps(ray.m_offsetMin[axis])), inv);
+		const __m128 t1 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(quantizedMax, scale), _mm_set1_ps(ray.m_offsetMax[axis])), inv);
+		tmin = _mm_max_ps(tmin, _mm_min_ps(t0, t1));
+		tmax = _mm_min_ps(tmax, _mm_max_ps(t0, t1));
+	}
+	return mask & (unsigned int)_mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+#else
+	btScalar tmin[BT_WIDE_BVH_WIDTH];
+	btScalar tmax[BT_WIDE_BVH_WIDTH];
+	for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+	{
+		tmin[i] = btScalar(0.);
+		tmax[i] = ray.m_lambdaMax;
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+		{
+			const btScalar t0 = (btScalar(node.m_quantizedAabbMin[axis][i]) * ray.m_quantizationInverse[axis] + ray.m_offsetMin[axis]) * ray.m_directionInverse[axis];
+			const btScalar t1 = (btScalar(node.m_quantizedAabbMax[axis][i]) * ray.m_quantizationInverse[axis] + ray.m_offsetMax[axis]) * ray.m_directionInverse[axis];
+			tmin[i] = btMax(tmin[i], btMin(t0, t1));
+			tmax[i] = btMin(tmax[i], btMax(t0, t1));
+		}
+	}
+	unsigned int hitMask = 0;
+	for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+	{
+		if (tmin[i] <= tmax[i])
+		{
+			hitMask |= 1u << i;
+		}
+	}
+	return mask & hitMask;
+#endif
+}
+
+struct btWideBvhBuildPrimitive : public btBvhSahQuantizedAabb
+{
+	int m_partId;
+	int m_triangleIndex;
+};
+
+///a range of primitives with its quantized box, one child of a node during the build
+struct btWideBvhBuildRange
+{
+	int m_begin;
+	int m_end;
+	unsigned short m_quantizedAabbMin[3];
+	unsigned short m_quantizedAabbMax[3];
+
+	int size() const
+	{
+		return m_end - m_begin;
+	}
+};
+
+struct btWideBvhBuilder
+{
+	btAlignedObjectArray<btWideBvhBuildPrimitive> m_primitives;
+	btAlignedObjectArray<btWideBvhNode> m_nodes;
+	btAlignedObjectArray<int> m_leafData;
+	///the length of the quantization steps on each axis, to measure the surface areas in world units
+	btScalar m_axisScale[3];
+	int m_maxLeafSize;
+
+	void calcRangeAabb(btWideBvhBuildRange& range) const
+	{
+		unsigned short aabbMin[3] = {0xffff, 0xffff, 0xffff};
+		unsigned short aabbMax[3] = {0, 0, 0};
+		for (int i = range.m_begin; i < range.m_end; i++)
+		{
+			const btWideBvhBuildPrimitive& primitive = m_primitives[i];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				aabbMin[axis] = btMin(aabbMin[axis], primitive.m_quantizedAabbMin[axis]);
+				aabbMax[axis] = btMax(aabbMax[axis], primitive.m_quantizedAabbMax[axis]);
+			}
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			range.m_quantizedAabbMin[axis] = aabbMin[axis];
+			range.m_quantizedAabbMax[axis] = aabbMax[axis];
+		}
+	}
+
+	btScalar calcHalfArea(const btWideBvhBuildRange& range) const
+	{
+		int extent[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			extent[axis] = int(range.m_quantizedAabbMax[axis]) - int(range.m_quantizedAabbMin[axis]);
+		}
+		return btBvhSahCalcHalfArea(m_axisScale, extent);
+	}
+
+	///splits the range in two non-empty halves and returns the first index of the second half
+	int splitRange(int begin, int end, int depth)
+	{
+		int centroidMin[3];
+		int centroidMax[3];
+		btBvhSahCalcCentroidBounds(m_primitives, begin, end, centroidMin, centroidMax);
+		const int largestAxis = btBvhSahGetLargestAxis(centroidMin, centroidMax);
+		const int mid = (begin + end) / 2;
+		if (centroidMax[largestAxis] == centroidMin[largestAxis])
+		{
+			//all centers coincide, any split is as good as the others
+			return mid;
+		}
+		if (depth >= BT_WIDE_BVH_MAX_SAH_DEPTH)
+		{
+			btBvhSahSelectMedian(m_primitives, begin, end, mid, largestAxis);
+			return mid;
+		}
+
+		btBvhSahBins bins;
+		btBvhSahBinPrimitives(m_primitives, begin, end, centroidMin, centroidMax, BT_BVH_SAH_NUM_BINS, bins);
+		int bestAxis;
+		int bestBin;
+		if (!btBvhSahFindBestSplit(bins, centroidMin, centroidMax, m_axisScale, bestAxis, bestBin))
+		{
+			btBvhSahSelectMedian(m_primitives, begin, end, mid, largestAxis);
+			return mid;
+		}
+		const int splitIndex = btBvhSahPartition(m_primitives, begin, end, bestAxis, bestBin, centroidMin, centroidMax, BT_BVH_SAH_NUM_BINS);
+		btAssert(splitIndex > begin && splitIndex < end);
+		return splitIndex;
+	}
+
+	int addLeaf(int begin, int end)
+	{
+		//sort by part and triangle index, small ranges only
+		for (int i = begin + 1; i < end; i++)
+		{
+			for (int j = i; j > begin; j--)
+			{
+				const btWideBvhBuildPrimitive& a = m_primitives[j - 1];
+				const btWideBvhBuildPrimitive& b = m_primitives[j];
+				if (a.m_partId < b.m_partId || (a.m_partId == b.m_partId && a.m_triangleIndex <= b.m_triangleIndex))
+				{
+					break;
+				}
+				m_primitives.swap(j - 1, j);
+			}
+		}
+		const int count = end - begin;
+		const int partId = m_primitives[begin].m_partId;
+		const bool singlePart = m_primitives[end - 1].m_partId == partId;
+		const bool delta16 = singlePart && (m_primitives[end - 1].m_triangleIndex - m_primitives[begin].m_triangleIndex) <= 0xffff;
+		const btWideBvhLeafFormat format = delta16 ? BT_WIDE_BVH_LEAF_DELTA16 : singlePart ? BT_WIDE_BVH_LEAF_INDEX : BT_WIDE_BVH_LEAF_MIXED;
+
+		const int offset = m_leafData.size();
+		m_leafData.push_back(int((unsigned int)(count - 1) | ((unsigned int)format << 4) | ((unsigned int)(singlePart ? partId : 0) << 6)));
+		switch (format)
+		{
+			case BT_WIDE_BVH_LEAF_DELTA16:
+			{
+				const int base = m_primitives[begin].m_triangleIndex;
+				m_leafData.push_back(base);
+				for (int i = 1; i < count; i += 2)
+				{
+					unsigned int word = (unsigned int)(m_primitives[begin + i].m_triangleIndex - base);
+					if (i + 1 < count)
+					{
+						word |= (unsigned int)(m_primitives[begin + i + 1].m_triangleIndex - base) << 16;
+					}
+					m_leafData.push_back(int(word));
+				}
+				break;
+			}
+			case BT_WIDE_BVH_LEAF_INDEX:
+			{
+				for (int i = begin; i < end; i++)
+				{
+					m_leafData.push_back(m_primitives[i].m_triangleIndex);
+				}
+				break;
+			}
+			default:
+			{
+				for (int i = begin; i < end; i++)
+				{
+					m_leafData.push_back(m_primitives[i].m_partId);
+					m_leafData.push_back(m_primitives[i].m_triangleIndex);
+				}
+			}
+		}
+		btAssert(btWideBvhLeafSize(&m_leafData[offset]) == m_leafData.size() - offset);
+		return offset;
+	}
+
+	///builds the node for the range and its subtrees depth first, returns the index of the node
+	int buildNode(const btWideBvhBuildRange& nodeRange, int depth)
+	{
+		btAssert(depth < BT_WIDE_BVH_MAX_DEPTH);
+		const int nodeIndex = m_nodes.size();
+		m_nodes.expandNonInitializing();
+
+		//split the child with the largest surface area until the node is full
+		btWideBvhBuildRange ranges[BT_WIDE_BVH_WIDTH];
+		ranges[0] = nodeRange;
+		int numRanges = 1;
+		while (numRanges < BT_WIDE_BVH_WIDTH)
+		{
+			int largest = -1;
+			btScalar largestArea = btScalar(-1.);
+			for (int i = 0; i < numRanges; i++)
+			{
+				if (ranges[i].size() > m_maxLeafSize)
+				{
+					const btScalar area = calcHalfArea(ranges[i]);
+					if (area > largestArea)
+					{
+						largestArea = area;
+						largest = i;
+					}
+				}
+			}
+			if (largest < 0)
+			{
+				break;
+			}
+			btWideBvhBuildRange& range = ranges[largest];
+			const int split = splitRange(range.m_begin, range.m_end, depth);
+			btWideBvhBuildRange& secondHalf = ranges[numRanges++];
+			secondHalf.m_begin = split;
+			secondHalf.m_end = range.m_end;
+			range.m_end = split;
+			calcRangeAabb(range);
+			calcRangeAabb(secondHalf);
+		}
+
+		for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+		{
+			btWideBvhNode& node = m_nodes[nodeIndex];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				node.m_quantizedAabbMin[axis][i] = i < numRanges ? ranges[i].m_quantizedAabbMin[axis] : 0;
+				node.m_quantizedAabbMax[axis][i] = i < numRanges ? ranges[i].m_quantizedAabbMax[axis] : 0;
+			}
+			node.m_children[i] = 0;
+		}
+		for (int i = 0; i < numRanges; i++)
+		{
+			//the node array can grow in the recursion, only access it by index
+			const int child = ranges[i].size() > m_maxLeafSize ? buildNode(ranges[i], depth + 1) : ~addLeaf(ranges[i].m_begin, ranges[i].m_end);
+			m_nodes[nodeIndex].m_children[i] = child;
+		}
+		return nodeIndex;
+	}
+};
+
+btWideBvh::btWideBvh()
+	: m_bvhAabbMin(btScalar(-SIMD_INFINITY), btScalar(-SIMD_INFINITY), btScalar(-SIMD_INFINITY)),
+	  m_bvhAabbMax(btScalar(SIMD_INFINITY), btScalar(SIMD_INFINITY), btScalar(SIMD_INFINITY)),
+	  m_bvhQuantization(btScalar(0.), btScalar(0.), btScalar(0.)),
+	  m_nodes(0),
+	  m_leafData(0),
+	  m_numNodes(0),
+	  m_leafDataSize(0),
+	  m_numTriangles(0),
+	  m_maxLeafSize(BT_WIDE_BVH_DEFAULT_LEAF_SIZE),
+	  m_ownsMemory(1)
+{
+}
+
+btWideBvh::~btWideBvh()
+{
+	freeMemory();
+}
+
+void btWideBvh::freeMemory()
+{
+	if (m_ownsMemory)
+	{
+		btAlignedFree(m_nodes);
+		btAlignedFree(m_leafData);
+	}
+	m_nodes = 0;
+	m_leafData = 0;
+	m_numNodes = 0;
+	m_leafDataSize = 0;
+	m_ownsMemory = 1;
+}
+
+void btWideBvh::setQuantizationValues(const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, btScalar quantizationMargin)
+{
+	//same as btQuantizedBvh::setQuantizationValues
+	btVector3 clampValue(quantizationMargin, quantizationMargin, quantizationMargin);
+	m_bvhAabbMin = bvhAabbMin - clampValue;
+	m_bvhAabbMax = bvhAabbMax + clampValue;
+	btVector3 aabbSize = m_bvhAabbMax - m_bvhAabbMin;
+	m_bvhQuantization = btVector3(btScalar(65533.0), btScalar(65533.0), btScalar(65533.0)) / aabbSize;
+
+	unsigned short vecIn[3];
+	btVector3 v;
+	quantize(vecIn, m_bvhAabbMin, false);
+	v = unQuantize(vecIn);
+	m_bvhAabbMin.setMin(v - clampValue);
+	aabbSize = m_bvhAabbMax - m_bvhAabbMin;
+	m_bvhQuantization = btVector3(btScalar(65533.0), btScalar(65533.0), btScalar(65533.0)) / aabbSize;
+	quantize(vecIn, m_bvhAabbMax, true);
+	v = unQuantize(vecIn);
+	m_bvhAabbMax.setMax(v + clampValue);
+	aabbSize = m_bvhAabbMax - m_bvhAabbMin;
+	m_bvhQuantization = btVector3(btScalar(65533.0), btScalar(65533.0), btScalar(65533.0)) / aabbSize;
+}
+
+void btWideBvh::build(btStridingMeshInterface* triangles, const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, int maxLeafSize)
+{
+	BT_PROFILE("btWideBvh::build");
+	btAssert(maxLeafSize >= 1 && maxLeafSize <= BT_WIDE_BVH_MAX_LEAF_SIZE);
+	freeMemory();
+	setQuantizationValues(bvhAabbMin, bvhAabbMax);
+	m_maxLeafSize = btMax(1, btMin(maxLeafSize, int(BT_WIDE_BVH_MAX_LEAF_SIZE)));
+
+	struct PrimitiveTriangleCallback : public btInternalTriangleIndexCallback
+	{
+		btAlignedObjectArray<btWideBvhBuildPrimitive>& m_primitives;
+		const btWideBvh* m_bvh;
+
+		PrimitiveTriangleCallback(btAlignedObjectArray<btWideBvhBuildPrimitive>& primitives, const btWideBvh* bvh)
+			: m_primitives(primitives),
+			  m_bvh(bvh)
+		{
+		}
+
+		virtual void internalProcessTriangleIndex(btVector3* triangle, int partId, int triangleIndex)
+		{
+			btAssert(partId >= 0 && partId < (1 << 26));
+			btAssert(triangleIndex >= 0);
+
+			btVector3 aabbMin = triangle[0];
+			btVector3 aabbMax = triangle[0];
+			aabbMin.setMin(triangle[1]);
+			aabbMax.setMax(triangle[1]);
+			aabbMin.setMin(triangle[2]);
+			aabbMax.setMax(triangle[2]);
+			btWideBvhExpandTriangleAabb(aabbMin, aabbMax);
+
+			btWideBvhBuildPrimitive& primitive = m_primitives.expandNonInitializing();
+			m_bvh->quantize(primitive.m_quantizedAabbMin, aabbMin, 0);
+			m_bvh->quantize(primitive.m_quantizedAabbMax, aabbMax, 1);
+			primitive.m_partId = partId;
+			primitive.m_triangleIndex = triangleIndex;
+		}
+
+	private:
+		PrimitiveTriangleCallback& operator=(const PrimitiveTriangleCallback&);
+	};
+
+	btWideBvhBuilder builder;
+	builder.m_maxLeafSize = m_maxLeafSize;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		builder.m_axisScale[axis] = btScalar(1.) / m_bvhQuantization[axis];
+	}
+	PrimitiveTriangleCallback callback(builder.m_primitives, this);
+	triangles->InternalProcessAllTriangles(&callback, m_bvhAabbMin, m_bvhAabbMax);
+
+	m_numTriangles = builder.m_primitives.size();
+	if (!m_numTriangles)
+	{
+		return;
+	}
+
+	btWideBvhBuildRange root;
+	root.m_begin = 0;
+	root.m_end = m_numTriangles;
+	builder.calcRangeAabb(root);
+	builder.buildNode(root, 0);
+
+	m_numNodes = builder.m_nodes.size();
+	m_nodes = (btWideBvhNode*)btAlignedAlloc(sizeof(btWideBvhNode) * m_numNodes, BT_WIDE_BVH_NODE_ALIGNMENT);
+	memcpy(m_nodes, &builder.m_nodes[0], sizeof(btWideBvhNode) * m_numNodes);
+	m_leafDataSize = builder.m_leafData.size();
+	m_leafData = (int*)btAlignedAlloc(sizeof(int) * m_leafDataSize, 16);
+	memcpy(m_leafData, &builder.m_leafData[0], sizeof(int) * m_leafDataSize);
+}
+
+void btWideBvh::refitNode(btWideBvhTriangleReader& reader, int nodeIndex, const unsigned short* quantizedQueryAabbMin, const unsigned short* quantizedQueryAabbMax, unsigned short* quantizedAabbMin, unsigned short* quantizedAabbMax)
+{
+	btWideBvhNode& node = m_nodes[nodeIndex];
+	quantizedAabbMin[0] = quantizedAabbMin[1] = quantizedAabbMin[2] = 0xffff;
+	quantizedAabbMax[0] = quantizedAabbMax[1] = quantizedAabbMax[2] = 0;
+	for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+	{
+		const int child = node.m_children[i];
+		if (!child)
+		{
+			continue;
+		}
+		bool update = true;
+		if (quantizedQueryAabbMin)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				update = update && node.m_quantizedAabbMin[axis][i] <= quantizedQueryAabbMax[axis] && node.m_quantizedAabbMax[axis][i] >= quantizedQueryAabbMin[axis];
+			}
+		}
+		if (update)
+		{
+			unsigned short childAabbMin[3];
+			unsigned short childAabbMax[3];
+			if (child > 0)
+			{
+				refitNode(reader, child, quantizedQueryAabbMin, quantizedQueryAabbMax, childAabbMin, childAabbMax);
+			}
+			else
+			{
+				btWideBvhTriangleAabbVisitor visitor(reader);
+				btWideBvhVisitLeaf(&m_leafData[~child], visitor);
+				quantizeWithClamp(childAabbMin, visitor.m_aabbMin, 0);
+				quantizeWithClamp(childAabbMax, visitor.m_aabbMax, 1);
+			}
+			for (int axis = 0; axis < 3; axis++)
+			{
+				node.m_quantizedAabbMin[axis][i] = childAabbMin[axis];
+				node.m_quantizedAabbMax[axis][i] = childAabbMax[axis];
+			}
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			quantizedAabbMin[axis] = btMin(quantizedAabbMin[axis], node.m_quantizedAabbMin[axis][i]);
+			quantizedAabbMax[axis] = btMax(quantizedAabbMax[axis], node.m_quantizedAabbMax[axis][i]);
+		}
+	}
+}
+
+void btWideBvh::refit(btStridingMeshInterface* meshInterface, const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	setQuantizationValues(aabbMin, aabbMax);
+	if (m_numNodes)
+	{
+		btWideBvhTriangleReader reader(meshInterface);
+		unsigned short rootAabbMin[3];
+		unsigned short rootAabbMax[3];
+		refitNode(reader, 0, 0, 0, rootAabbMin, rootAabbMax);
+	}
+}
+
+void btWideBvh::refitPartial(btStridingMeshInterface* meshInterface, const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	//incrementally initialize quantization values
+	btAssert(aabbMin.getX() > m_bvhAabbMin.getX());
+	btAssert(aabbMin.getY() > m_bvhAabbMin.getY());
+	btAssert(aabbMin.getZ() > m_bvhAabbMin.getZ());
+
+	btAssert(aabbMax.getX() < m_bvhAabbMax.getX());
+	btAssert(aabbMax.getY() < m_bvhAabbMax.getY());
+	btAssert(aabbMax.getZ() < m_bvhAabbMax.getZ());
+
+	if (m_numNodes)
+	{
+		unsigned short quantizedQueryAabbMin[3];
+		unsigned short quantizedQueryAabbMax[3];
+		quantizeWithClamp(quantizedQueryAabbMin, aabbMin, 0);
+		quantizeWithClamp(quantizedQueryAabbMax, aabbMax, 1);
+
+		btWideBvhTriangleReader reader(meshInterface);
+		unsigned short rootAabbMin[3];
+		unsigned short rootAabbMax[3];
+		refitNode(reader, 0, quantizedQueryAabbMin, quantizedQueryAabbMax, rootAabbMin, rootAabbMax);
+	}
+}
+
+void btWideBvh::reportAabbOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	if (!m_numNodes)
+	{
+		return;
+	}
+	btWideBvhQuantizedQuery query;
+	quantizeWithClamp(query.m_quantizedAabbMin, aabbMin, 0);
+	quantizeWithClamp(query.m_quantizedAabbMax, aabbMax, 1);
+	query.init();
+
+	btWideBvhNodeCallbackVisitor visitor(nodeCallback);
+	int stack[BT_WIDE_BVH_STACK_SIZE];
+	int stackSize = 1;
+	stack[0] = 0;
+	while (stackSize)
+	{
+		const btWideBvhNode& node = m_nodes[stack[--stackSize]];
+		unsigned int mask = btWideBvhOverlapMask(node, query);
+		for (int i = 0; mask; i++, mask >>= 1)
+		{
+			if (mask & 1)
+			{
+				const int child = node.m_children[i];
+				if (child > 0)
+				{
+					btAssert(stackSize < BT_WIDE_BVH_STACK_SIZE);
+					stack[stackSize++] = child;
+				}
+				else
+				{
+					btWideBvhVisitLeaf(&m_leafData[~child], visitor);
+				}
+			}
+		}
+	}
+}
+
+void btWideBvh::walkTreeAgainstRay(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	if (!m_numNodes)
+	{
+		return;
+	}
+	/* Quick pruning by quantized box */
+	btVector3 rayAabbMin = raySource;
+	btVector3 rayAabbMax = raySource;
+	rayAabbMin.setMin(rayTarget);
+	rayAabbMax.setMax(rayTarget);
+	rayAabbMin += aabbMin;
+	rayAabbMax += aabbMax;
+
+	btWideBvhQuantizedQuery query;
+	quantizeWithClamp(query.m_quantizedAabbMin, rayAabbMin, 0);
+	quantizeWithClamp(query.m_quantizedAabbMax, rayAabbMax, 1);
+	query.init();
+
+	btWideBvhRay ray;
+	ray.init(m_bvhAabbMin, m_bvhQuantization, raySource, rayTarget, aabbMin, aabbMax);
+
+	btWideBvhNodeCallbackVisitor visitor(nodeCallback);
+	int stack[BT_WIDE_BVH_STACK_SIZE];
+	int stackSize = 1;
+	stack[0] = 0;
+	while (stackSize)
+	{
+		const btWideBvhNode& node = m_nodes[stack[--stackSize]];
+		unsigned int mask = btWideBvhOverlapMask(node, query);
+		if (!mask)
+		{
+			continue;
+		}
+		mask = btWideBvhRayMask(node, ray, mask);
+		for (int i = 0; mask; i++, mask >>= 1)
+		{
+			if (mask & 1)
+			{
+				const int child = node.m_children[i];
+				if (child > 0)
+				{
+					btAssert(stackSize < BT_WIDE_BVH_STACK_SIZE);
+					stack[stackSize++] = child;
+				}
+				else
+				{
+					btWideBvhVisitLeaf(&m_leafData[~child], visitor);
+				}
+			}
+		}
+	}
+}
+
+void btWideBvh::reportRayOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget) const
+{
+	walkTreeAgainstRay(nodeCallback, raySource, rayTarget, btVector3(0, 0, 0), btVector3(0, 0, 0));
+}
+
+void btWideBvh::reportBoxCastOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	walkTreeAgainstRay(nodeCallback, raySource, rayTarget, aabbMin, aabbMax);
+}
+
+void btWideBvh::reportRayPacketOverlappingNodex(btNodeRayPacketOverlapCallback* nodeCallback, const btRayPacket& packet) const
+{
+	if (!m_numNodes || !packet.m_numRays)
+	{
+		return;
+	}
+	btVector3 packetAabbMin = packet.m_rayFrom[0];
+	btVector3 packetAabbMax = packet.m_rayFrom[0];
+	for (int r = 0; r < packet.m_numRays; r++)
+	{
+		packetAabbMin.setMin(packet.m_rayFrom[r]);
+		packetAabbMax.setMax(packet.m_rayFrom[r]);
+		packetAabbMin.setMin(packet.m_rayTo[r]);
+		packetAabbMax.setMax(packet.m_rayTo[r]);
+	}
+	btWideBvhQuantizedQuery query;
+	quantizeWithClamp(query.m_quantizedAabbMin, packetAabbMin, 0);
+	quantizeWithClamp(query.m_quantizedAabbMax, packetAabbMax, 1);
+	query.init();
+
+	int stack[BT_WIDE_BVH_STACK_SIZE];
+	unsigned int stackRayMask[BT_WIDE_BVH_STACK_SIZE];
+	int stackSize = 1;
+	stack[0] = 0;
+	stackRayMask[0] = packet.getActiveMask();
+	while (stackSize)
+	{
+		stackSize--;
+		const btWideBvhNode& node = m_nodes[stack[stackSize]];
+		const unsigned int nodeRayMask = stackRayMask[stackSize];
+		unsigned int mask = btWideBvhOverlapMask(node, query);
+		for (int i = 0; mask; i++, mask >>= 1)
+		{
+			if (mask & 1)
+			{
+				const unsigned short childAabbMin[3] = {node.m_quantizedAabbMin[0][i], node.m_quantizedAabbMin[1][i], node.m_quantizedAabbMin[2][i]};
+				const unsigned short childAabbMax[3] = {node.m_quantizedAabbMax[0][i], node.m_quantizedAabbMax[1][i], node.m_quantizedAabbMax[2][i]};
+				const unsigned int rayMask = packet.testAabb(unQuantize(childAabbMin), unQuantize(childAabbMax), nodeRayMask);
+				if (!rayMask)
+				{
+					continue;
+				}
+				const int child = node.m_children[i];
+				if (child > 0)
+				{
+					btAssert(stackSize < BT_WIDE_BVH_STACK_SIZE);
+					stack[stackSize] = child;
+					stackRayMask[stackSize] = rayMask;
+					stackSize++;
+				}
+				else
+				{
+					btWideBvhRayPacketCallbackVisitor visitor(nodeCallback, rayMask);
+					btWideBvhVisitLeaf(&m_leafData[~child], visitor);
+				}
+			}
+		}
+	}
+}
+
+//the header is padded to the node alignment, the nodes and the leaf data follow it
+static unsigned btWideBvhSerializeHeaderSize()
+{
+	return (unsigned(sizeof(btWideBvh)) + BT_WIDE_BVH_NODE_ALIGNMENT - 1) & ~unsigned(BT_WIDE_BVH_NODE_ALIGNMENT - 1);
+}
+
+unsigned btWideBvh::calculateSerializeBufferSize() const
+{
+	return btWideBvhSerializeHeaderSize() + m_numNodes * sizeof(btWideBvhNode) + m_leafDataSize * sizeof(int);
+}
+
+bool btWideBvh::serialize(void* o_alignedDataBuffer, unsigned i_dataBufferSize, bool i_swapEndian) const
+{
+	if (o_alignedDataBuffer == NULL || i_dataBufferSize < calculateSerializeBufferSize())
+	{
+		btAssert(0);
+		return false;
+	}
+	unsigned char* data = (unsigned char*)o_alignedDataBuffer;
+	memset(data, 0, btWideBvhSerializeHeaderSize());
+	btWideBvh* targetBvh = (btWideBvh*)data;
+	btWideBvhNode* targetNodes = (btWideBvhNode*)(data + btWideBvhSerializeHeaderSize());
+	int* targetLeafData = (int*)(data + btWideBvhSerializeHeaderSize() + m_numNodes * sizeof(btWideBvhNode));
+
+	if (i_swapEndian)
+	{
+		btSwapVector3Endian(m_bvhAabbMin, targetBvh->m_bvhAabbMin);
+		btSwapVector3Endian(m_bvhAabbMax, targetBvh->m_bvhAabbMax);
+		btSwapVector3Endian(m_bvhQuantization, targetBvh->m_bvhQuantization);
+		targetBvh->m_numNodes = static_cast<int>(btSwapEndian(m_numNodes));
+		targetBvh->m_leafDataSize = static_cast<int>(btSwapEndian(m_leafDataSize));
+		targetBvh->m_numTriangles = static_cast<int>(btSwapEndian(m_numTriangles));
+		targetBvh->m_maxLeafSize = static_cast<int>(btSwapEndian(m_maxLeafSize));
+
+		for (int nodeIndex = 0; nodeIndex < m_numNodes; nodeIndex++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+				{
+					targetNodes[nodeIndex].m_quantizedAabbMin[axis][i] = btSwapEndian(m_nodes[nodeIndex].m_quantizedAabbMin[axis][i]);
+					targetNodes[nodeIndex].m_quantizedAabbMax[axis][i] = btSwapEndian(m_nodes[nodeIndex].m_quantizedAabbMax[axis][i]);
+				}
+			}
+			for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+			{
+				targetNodes[nodeIndex].m_children[i] = static_cast<int>(btSwapEndian(m_nodes[nodeIndex].m_children[i]));
+			}
+		}
+		for (int i = 0; i < m_leafDataSize; i++)
+		{
+			targetLeafData[i] = static_cast<int>(btSwapEndian(m_leafData[i]));
+		}
+	}
+	else
+	{
+		targetBvh->m_bvhAabbMin = m_bvhAabbMin;
+		targetBvh->m_bvhAabbMax = m_bvhAabbMax;
+		targetBvh->m_bvhQuantization = m_bvhQuantization;
+		targetBvh->m_numNodes = m_numNodes;
+		targetBvh->m_leafDataSize = m_leafDataSize;
+		targetBvh->m_numTriangles = m_numTriangles;
+		targetBvh->m_maxLeafSize = m_maxLeafSize;
+		if (m_numNodes)
+		{
+			memcpy(targetNodes, m_nodes, m_numNodes * sizeof(btWideBvhNode));
+		}
+		if (m_leafDataSize)
+		{
+			memcpy(targetLeafData, m_leafData, m_leafDataSize * sizeof(int));
+		}
+	}
+	//the pointers are restored by deSerializeInPlace
+	targetBvh->m_nodes = 0;
+	targetBvh->m_leafData = 0;
+	targetBvh->m_ownsMemory = 0;
+	return true;
+}
+
+btWideBvh* btWideBvh::deSerializeInPlace(void* i_alignedDataBuffer, unsigned int i_dataBufferSize, bool i_swapEndian)
+{
+	if (i_alignedDataBuffer == NULL || i_dataBufferSize < btWideBvhSerializeHeaderSize())
+	{
+		return NULL;
+	}
+	unsigned char* data = (unsigned char*)i_alignedDataBuffer;
+	btWideBvh* bvh = (btWideBvh*)data;
+
+	if (i_swapEndian)
+	{
+		btUnSwapVector3Endian(bvh->m_bvhAabbMin);
+		btUnSwapVector3Endian(bvh->m_bvhAabbMax);
+		btUnSwapVector3Endian(bvh->m_bvhQuantization);
+		bvh->m_numNodes = static_cast<int>(btSwapEndian(bvh->m_numNodes));
+		bvh->m_leafDataSize = static_cast<int>(btSwapEndian(bvh->m_leafDataSize));
+		bvh->m_numTriangles = static_cast<int>(btSwapEndian(bvh->m_numTriangles));
+		bvh->m_maxLeafSize = static_cast<int>(btSwapEndian(bvh->m_maxLeafSize));
+	}
+
+	unsigned int calculatedBufSize = bvh->calculateSerializeBufferSize();
+	btAssert(calculatedBufSize <= i_dataBufferSize);
+
+	if (calculatedBufSize > i_dataBufferSize)
+	{
+		return NULL;
+	}
+
+	bvh->m_nodes = bvh->m_numNodes ? (btWideBvhNode*)(data + btWideBvhSerializeHeaderSize()) : 0;
+	bvh->m_leafData = bvh->m_leafDataSize ? (int*)(data + btWideBvhSerializeHeaderSize() + bvh->m_numNodes * sizeof(btWideBvhNode)) : 0;
+	bvh->m_ownsMemory = 0;
+
+	if (i_swapEndian)
+	{
+		for (int nodeIndex = 0; nodeIndex < bvh->m_numNodes; nodeIndex++)
+		{
+			btWideBvhNode& node = bvh->m_nodes[nodeIndex];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+				{
+					node.m_quantizedAabbMin[axis][i] = btSwapEndian(node.m_quantizedAabbMin[axis][i]);
+					node.m_quantizedAabbMax[axis][i] = btSwapEndian(node.m_quantizedAabbMax[axis][i]);
+				}
+			}
+			for (int i = 0; i < BT_WIDE_BVH_WIDTH; i++)
+			{
+				node.m_children[i] = static_cast<int>(btSwapEndian(node.m_children[i]));
+			}
+		}
+		for (int i = 0; i < bvh->m_leafDataSize; i++)
+		{
+			bvh->m_leafData[i] = static_cast<int>(btSwapEndian(bvh->m_leafData[i]));
+		}
+	}
+	return bvh;
+}
@@ -0,0 +1,198 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_WIDE_BVH_H
+#define BT_WIDE_BVH_H
+
+#include "LinearMath/btVector3.h"
+#include "LinearMath/btAlignedAllocator.h"
+
+class btStridingMeshInterface;
+class btNodeOverlapCallback;
+class btNodeRayPacketOverlapCallback;
+struct btRayPacket;
+struct btWideBvhTriangleReader;
+
+#define BT_WIDE_BVH_WIDTH 4
+///a leaf block stores its triangle count in 4 bits
+#define BT_WIDE_BVH_MAX_LEAF_SIZE 16
+#define BT_WIDE_BVH_DEFAULT_LEAF_SIZE 2
+
+///btWideBvhNode stores the quantized boxes of its 4 children in structure-of-arrays layout, so that a node is
+///exactly one 64 byte cache line and the 4 boxes are tested at once.
+struct btWideBvhNode
+{
+	unsigned short m_quantizedAabbMin[3][BT_WIDE_BVH_WIDTH];
+	unsigned short m_quantizedAabbMax[3][BT_WIDE_BVH_WIDTH];
+	///positive: index of the child node, negative: ~offset of the leaf block in the leaf data,
+	///0: empty slot (node 0 is the root, so it is never a child)
+	int m_children[BT_WIDE_BVH_WIDTH];
+};
+
+///The btWideBvh is a 4-wide bounding volume hierarchy over the triangles of a btStridingMeshInterface, an alternative to
+///btOptimizedBvh for large static meshes, see btBvhTriangleMeshShape::buildWideBvh.
+///It is built with a binned surface area heuristic and uses the 16 bit quantization of btQuantizedBvh for the child boxes.
+///The nodes are laid out depth first and aligned to cache lines, a query touches one cache line per visited node
+///instead of one per binary node. Leaves are blocks of up to BT_WIDE_BVH_MAX_LEAF_SIZE triangles, the triangle
+///indices of a block are delta compressed when they share a part. Triangle indices use the full 31 bits, so there is no
+///limit of 2 million triangles per part as in btQuantizedBvh.
+///The queries use the callbacks of btQuantizedBvh. They report every triangle that btQuantizedBvh reports and
+///possibly other triangles of the same leaf blocks, larger leaves save memory but report more triangles.
+ATTRIBUTE_ALIGNED16(class)
+btWideBvh
+{
+	btVector3 m_bvhAabbMin;
+	btVector3 m_bvhAabbMax;
+	btVector3 m_bvhQuantization;
+
+	btWideBvhNode* m_nodes;
+	int* m_leafData;
+	int m_numNodes;
+	int m_leafDataSize;
+	int m_numTriangles;
+	int m_maxLeafSize;
+	int m_ownsMemory;
+
+	void setQuantizationValues(const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, btScalar quantizationMargin = btScalar(1.0));
+
+	void freeMemory();
+
+	void refitNode(btWideBvhTriangleReader & reader, int nodeIndex, const unsigned short* quantizedQueryAabbMin, const unsigned short* quantizedQueryAabbMax, unsigned short* quantizedAabbMin, unsigned short* quantizedAabbMax);
+
+	void walkTreeAgainstRay(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const;
+
+	btWideBvh(const btWideBvh&);
+	btWideBvh& operator=(const btWideBvh&);
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btWideBvh();
+
+	~btWideBvh();
+
+	///builds the tree over all triangles of the mesh, the quantization covers [bvhAabbMin,bvhAabbMax]
+	void build(btStridingMeshInterface * triangles, const btVector3& bvhAabbMin, const btVector3& bvhAabbMax, int maxLeafSize = BT_WIDE_BVH_DEFAULT_LEAF_SIZE);
+
+	///updates all boxes after the vertices moved, keeping the topology of the tree
+	void refit(btStridingMeshInterface * meshInterface, const btVector3& aabbMin, const btVector3& aabbMax);
+
+	///updates the boxes of the subtrees overlapping [aabbMin,aabbMax] only, the quantization is kept, so the moved
+	///triangles must stay within the aabb of the tree
+	void refitPartial(btStridingMeshInterface * meshInterface, const btVector3& aabbMin, const btVector3& aabbMax);
+
+	void reportAabbOverlappingNodex(btNodeOverlapCallback * nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const;
+	void reportRayOverlappingNodex(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget) const;
+	void reportBoxCastOverlappingNodex(btNodeOverlapCallback * nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const;
+	///walks the tree once for the whole packet, rayMask of the callback tells which rays overlap the triangle
+	void reportRayPacketOverlappingNodex(btNodeRayPacketOverlapCallback * nodeCallback, const btRayPacket& packet) const;
+
+	SIMD_FORCE_INLINE void quantize(unsigned short* out, const btVector3& point, int isMax) const
+	{
+		btAssert(point.getX() <= m_bvhAabbMax.getX());
+		btAssert(point.getY() <= m_bvhAabbMax.getY());
+		btAssert(point.getZ() <= m_bvhAabbMax.getZ());
+
+		btAssert(point.getX() >= m_bvhAabbMin.getX());
+		btAssert(point.getY() >= m_bvhAabbMin.getY());
+		btAssert(point.getZ() >= m_bvhAabbMin.getZ());
+
+		btVector3 v = (point - m_bvhAabbMin) * m_bvhQuantization;
+		///same conservative rounding as btQuantizedBvh::quantize
+		if (isMax)
+		{
+			out[0] = (unsigned short)(((unsigned short)(v.getX() + btScalar(1.)) | 1));
+			out[1] = (unsigned short)(((unsigned short)(v.getY() + btScalar(1.)) | 1));
+			out[2] = (unsigned short)(((unsigned short)(v.getZ() + btScalar(1.)) | 1));
+		}
+		else
+		{
+			out[0] = (unsigned short)(((unsigned short)(v.getX()) & 0xfffe));
+			out[1] = (unsigned short)(((unsigned short)(v.getY()) & 0xfffe));
+			out[2] = (unsigned short)(((unsigned short)(v.getZ()) & 0xfffe));
+		}
+	}
+
+	SIMD_FORCE_INLINE void quantizeWithClamp(unsigned short* out, const btVector3& point2, int isMax) const
+	{
+		btVector3 clampedPoint(point2);
+		clampedPoint.setMax(m_bvhAabbMin);
+		clampedPoint.setMin(m_bvhAabbMax);
+
+		quantize(out, clampedPoint, isMax);
+	}
+
+	SIMD_FORCE_INLINE btVector3 unQuantize(const unsigned short* vecIn) const
+	{
+		btVector3 vecOut;
+		vecOut.setValue(
+			(btScalar)(vecIn[0]) / (m_bvhQuantization.getX()),
+			(btScalar)(vecIn[1]) / (m_bvhQuantization.getY()),
+			(btScalar)(vecIn[2]) / (m_bvhQuantization.getZ()));
+		vecOut += m_bvhAabbMin;
+		return vecOut;
+	}
+
+	const btVector3& getBvhAabbMin() const
+	{
+		return m_bvhAabbMin;
+	}
+
+	const btVector3& getBvhAabbMax() const
+	{
+		return m_bvhAabbMax;
+	}
+
+	int getNumNodes() const
+	{
+		return m_numNodes;
+	}
+
+	const btWideBvhNode* getNodes() const
+	{
+		return m_nodes;
+	}
+
+	///size of the compressed leaf blocks, in ints
+	int getLeafDataSize() const
+	{
+		return m_leafDataSize;
+	}
+
+	int getNumTriangles() const
+	{
+		return m_numTriangles;
+	}
+
+	int getMaxLeafSize() const
+	{
+		return m_maxLeafSize;
+	}
+
+	////////////////////////////////////////////////////////////////////
+
+	///Calculate space needed to store the tree for serialization
+	unsigned calculateSerializeBufferSize() const;
+
+	///Data buffer MUST be 16 byte aligned, 64 byte alignment keeps each node in one cache line
+	bool serialize(void* o_alignedDataBuffer, unsigned i_dataBufferSize, bool i_swapEndian) const;
+
+	///deSerializeInPlace loads and initializes a tree from a buffer in memory 'in place', the buffer must stay alive while the tree is used
+	static btWideBvh* deSerializeInPlace(void* i_alignedDataBuffer, unsigned int i_dataBufferSize, bool i_swapEndian);
+
+	////////////////////////////////////////////////////////////////////
+};
+
+#endif  //BT_WIDE_BVH_H
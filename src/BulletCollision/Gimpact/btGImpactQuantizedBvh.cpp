@@ -225,6 +225,19 @@ void btQuantizedBvhTree::build_tree(
 	_build_sub_tree(primitive_boxes, 0, primitive_boxes.size());
 }
 
+void btQuantizedBvhTree::rebuild_sub_tree(
+	GIM_BVH_DATA_ARRAY& primitive_boxes, int nodeindex)
+{
+	// the subtree has the same number of nodes, so it is built over its old nodes
+	int num_nodes = m_num_nodes;
+	m_num_nodes = nodeindex;
+
+	_build_sub_tree(primitive_boxes, 0, primitive_boxes.size());
+
+	btAssert(m_num_nodes == nodeindex + primitive_boxes.size() * 2 - 1);
+	m_num_nodes = num_nodes;
+}
+
 ////////////////////////////////////class btGImpactQuantizedBvh
 
 void btGImpactQuantizedBvh::refit()
@@ -264,6 +277,196 @@ void btGImpactQuantizedBvh::refit()
 			setNodeBound(nodecount, bound);
 		}
 	}
+
+	if (m_node_costs.size() == getNodeCount())
+	{
+		// the costs of the build stay the reference of updatePrimitives
+		nodecount = getNodeCount();
+		while (nodecount--)
+		{
+			m_node_costs[nodecount] = calc_node_cost(nodecount);
+		}
+	}
+}
+
+btScalar btGImpactQuantizedBvh::calc_node_cost(int nodeindex) const
+{
+	if (isLeafNode(nodeindex)) return btScalar(0.);
+
+	btAABB bound;
+	getNodeBound(nodeindex, bound);
+	btVector3 extent = bound.m_max - bound.m_min;
+	btScalar half_area = extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0];
+
+	return half_area + m_node_costs[getLeftNode(nodeindex)] + m_node_costs[getRightNode(nodeindex)];
+}
+
+void btGImpactQuantizedBvh::reset_node_costs(int first_node, int end_node)
+{
+	// children follow their parent, so walking backwards visits them first
+	int nodeindex = end_node;
+	while (nodeindex-- > first_node)
+	{
+		if (isLeafNode(nodeindex))
+		{
+			m_primitive_leaf_nodes[getNodeData(nodeindex)] = nodeindex;
+		}
+		m_node_costs[nodeindex] = calc_node_cost(nodeindex);
+		m_node_built_costs[nodeindex] = m_node_costs[nodeindex];
+	}
+}
+
+//! number of dirty nodes before nodeindex, the dirty nodes are sorted
+static SIMD_FORCE_INLINE int bt_count_dirty_nodes_before(const int* dirty_nodes, int dirty_count, int nodeindex)
+{
+	int lo = 0;
+	int hi = dirty_count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) >> 1;
+		if (dirty_nodes[mid] < nodeindex)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+void btGImpactQuantizedBvh::refit_dirty_nodes(int nodeindex, const int* dirty_nodes, int dirty_count)
+{
+	if (isLeafNode(nodeindex)) return;
+
+	int left_node = getLeftNode(nodeindex);
+	int right_node = getRightNode(nodeindex);
+	int left_count = bt_count_dirty_nodes_before(dirty_nodes, dirty_count, right_node);
+
+	if (left_count > 0)
+	{
+		refit_dirty_nodes(left_node, dirty_nodes, left_count);
+	}
+	if (left_count < dirty_count)
+	{
+		refit_dirty_nodes(right_node, dirty_nodes + left_count, dirty_count - left_count);
+	}
+
+	btAABB bound;
+	btAABB temp_box;
+	getNodeBound(left_node, bound);
+	getNodeBound(right_node, temp_box);
+	bound.merge(temp_box);
+	setNodeBound(nodeindex, bound);
+
+	m_node_costs[nodeindex] = calc_node_cost(nodeindex);
+}
+
+void btGImpactQuantizedBvh::rebuild_degraded_nodes(int nodeindex, const int* dirty_nodes, int dirty_count)
+{
+	if (isLeafNode(nodeindex)) return;
+
+	// the topmost degraded subtree is rebuilt, this also repairs the degraded subtrees below it
+	int subtree_nodes = getEscapeNodeIndex(nodeindex);
+	int subtree_primitives = (subtree_nodes + 1) / 2;
+	if (subtree_primitives > 2 && m_node_costs[nodeindex] > m_max_cost_growth * m_node_built_costs[nodeindex])
+	{
+		GIM_BVH_DATA_ARRAY primitive_boxes;
+		primitive_boxes.reserve(subtree_primitives);
+		for (int i = nodeindex; i < nodeindex + subtree_nodes; i++)
+		{
+			if (isLeafNode(i))
+			{
+				GIM_BVH_DATA& data = primitive_boxes.expand();
+				getNodeBound(i, data.m_bound);
+				data.m_data = getNodeData(i);
+			}
+		}
+
+		m_box_tree.rebuild_sub_tree(primitive_boxes, nodeindex);
+		reset_node_costs(nodeindex, nodeindex + subtree_nodes);
+		return;
+	}
+
+	int left_node = getLeftNode(nodeindex);
+	int right_node = getRightNode(nodeindex);
+	int left_count = bt_count_dirty_nodes_before(dirty_nodes, dirty_count, right_node);
+
+	if (left_count > 0)
+	{
+		rebuild_degraded_nodes(left_node, dirty_nodes, left_count);
+	}
+	if (left_count < dirty_count)
+	{
+		rebuild_degraded_nodes(right_node, dirty_nodes + left_count, dirty_count - left_count);
+	}
+
+	m_node_costs[nodeindex] = calc_node_cost(nodeindex);
+}
+
+class btDirtyNodeLess
+{
+public:
+	bool operator()(int a, int b) const
+	{
+		return a < b;
+	}
+};
+
+void btGImpactQuantizedBvh::updatePrimitives(const btAlignedObjectArray<int>& primitive_indices)
+{
+	BT_PROFILE("btGImpactQuantizedBvh::updatePrimitives");
+	int nodecount = getNodeCount();
+	if (nodecount == 0 || primitive_indices.size() == 0) return;
+
+	if (m_node_costs.size() != nodecount)
+	{
+		m_primitive_leaf_nodes.resize(m_primitive_manager->get_primitive_count());
+		m_node_costs.resize(nodecount);
+		m_node_built_costs.resize(nodecount);
+		reset_node_costs(0, nodecount);
+	}
+
+	// leaf nodes of the primitives, sorted and without duplicates
+	btAlignedObjectArray<int> dirty_nodes;
+	dirty_nodes.reserve(primitive_indices.size());
+	for (int i = 0; i < primitive_indices.size(); i++)
+	{
+		int primitive_index = primitive_indices[i];
+		if (primitive_index >= 0 && primitive_index < m_primitive_leaf_nodes.size())
+		{
+			dirty_nodes.push_back(m_primitive_leaf_nodes[primitive_index]);
+		}
+	}
+	if (dirty_nodes.size() == 0) return;
+
+	dirty_nodes.quickSort(btDirtyNodeLess());
+	int dirty_count = 1;
+	for (int i = 1; i < dirty_nodes.size(); i++)
+	{
+		if (dirty_nodes[i] != dirty_nodes[dirty_count - 1])
+		{
+			dirty_nodes[dirty_count++] = dirty_nodes[i];
+		}
+	}
+
+	btAlignedObjectArray<btAABB> leafboxes;
+	leafboxes.resize(dirty_count);
+	for (int i = 0; i < dirty_count; i++)
+	{
+		m_primitive_manager->get_primitive_box(getNodeData(dirty_nodes[i]), leafboxes[i]);
+		if (!m_box_tree.isInQuantizationRange(leafboxes[i]))
+		{
+			// setNodeBound would clamp the box, the new quantization needs a new tree
+			buildSet();
+			return;
+		}
+	}
+
+	for (int i = 0; i < dirty_count; i++)
+	{
+		setNodeBound(dirty_nodes[i], leafboxes[i]);
+	}
+
+	refit_dirty_nodes(0, &dirty_nodes[0], dirty_count);
+	rebuild_degraded_nodes(0, &dirty_nodes[0], dirty_count);
 }
 
 //! this rebuild the entire set
@@ -280,6 +483,10 @@ void btGImpactQuantizedBvh::buildSet()
 	}
 
 	m_box_tree.build_tree(primitive_boxes);
+
+	m_primitive_leaf_nodes.clear();
+	m_node_costs.clear();
+	m_node_built_costs.clear();
 }
 
 //! returns the indices of the primitives in the m_primitive_manager
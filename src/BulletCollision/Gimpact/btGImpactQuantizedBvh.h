@@ -62,6 +62,25 @@ public:
 	//!@{
 	void build_tree(GIM_BVH_DATA_ARRAY& primitive_boxes);
 
+	//! rebuilds the subtree at nodeindex in place from the boxes of its primitives
+	/*!
+	\pre primitive_boxes holds the primitives of the subtree, the quantization is kept
+	*/
+	void rebuild_sub_tree(GIM_BVH_DATA_ARRAY& primitive_boxes, int nodeindex);
+
+	//! true if setNodeBound can store the bound without clamping it to the quantization range
+	SIMD_FORCE_INLINE bool isInQuantizationRange(const btAABB& bound) const
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if (bound.m_min[i] < m_global_bound.m_min[i] || bound.m_max[i] > m_global_bound.m_max[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
 	SIMD_FORCE_INLINE void quantizePoint(
 		unsigned short* quantizedpoint, const btVector3& point) const
 	{
@@ -159,21 +178,37 @@ protected:
 	btQuantizedBvhTree m_box_tree;
 	btPrimitiveManagerBase* m_primitive_manager;
 
+	//! state of updatePrimitives, filled on its first call
+	btAlignedObjectArray<int> m_primitive_leaf_nodes;
+	btAlignedObjectArray<btScalar> m_node_costs;
+	btAlignedObjectArray<btScalar> m_node_built_costs;
+	btScalar m_max_cost_growth;
+
 protected:
 	//stackless refit
 	void refit();
 
+	btScalar calc_node_cost(int nodeindex) const;
+
+	void reset_node_costs(int first_node, int end_node);
+
+	void refit_dirty_nodes(int nodeindex, const int* dirty_nodes, int dirty_count);
+
+	void rebuild_degraded_nodes(int nodeindex, const int* dirty_nodes, int dirty_count);
+
 public:
 	//! this constructor doesn't build the tree. you must call	buildSet
 	btGImpactQuantizedBvh()
 	{
 		m_primitive_manager = NULL;
+		m_max_cost_growth = btScalar(1.5);
 	}
 
 	//! this constructor doesn't build the tree. you must call	buildSet
 	btGImpactQuantizedBvh(btPrimitiveManagerBase* primitive_manager)
 	{
 		m_primitive_manager = primitive_manager;
+		m_max_cost_growth = btScalar(1.5);
 	}
 
 	SIMD_FORCE_INLINE btAABB getGlobalBox() const
@@ -205,6 +240,25 @@ public:
 	//! this rebuild the entire set
 	void buildSet();
 
+	//! refits the boxes of the given primitives and of their ancestors only
+	/*!
+	Then the subtrees whose surface area cost grew by more than getMaxCostGrowth() since they were built are rebuilt,
+	so a deforming mesh keeps the query performance of a fresh tree without paying for buildSet.
+	When a primitive leaves the quantization range of the tree, the whole set is rebuilt with buildSet instead.
+	\pre the number of primitives did not change since buildSet
+	*/
+	void updatePrimitives(const btAlignedObjectArray<int>& primitive_indices);
+
+	SIMD_FORCE_INLINE void setMaxCostGrowth(btScalar max_cost_growth)
+	{
+		m_max_cost_growth = max_cost_growth;
+	}
+
+	SIMD_FORCE_INLINE btScalar getMaxCostGrowth() const
+	{
+		return m_max_cost_growth;
+	}
+
 	//! returns the indices of the primitives in the m_primitive_manager
 	bool boxQuery(const btAABB& box, btAlignedObjectArray<int>& collided_results) const;
 
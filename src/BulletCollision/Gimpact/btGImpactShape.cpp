@@ -242,6 +242,53 @@ void btGImpactMeshShapePart::processAllTriangles(btTriangleCallback* callback, c
 	unlockChildShapes();
 }
 
+void btGImpactMeshShapePart::refitDirtyTriangles(const btAlignedObjectArray<btDirtyTriangle>& dirtyTriangles)
+{
+	if (m_needs_update || m_box_set.getNodeCount() == 0)
+	{
+		// the whole set is refit or built anyway
+		updateBound();
+		return;
+	}
+
+	btAlignedObjectArray<int> primitive_indices;
+	int part = getPart();
+	for (int i = 0; i < dirtyTriangles.size(); i++)
+	{
+		if (dirtyTriangles[i].m_subPart == part)
+		{
+			primitive_indices.push_back(dirtyTriangles[i].m_triangleIndex);
+		}
+	}
+	if (primitive_indices.size() == 0) return;
+
+	lockChildShapes();
+	m_box_set.updatePrimitives(primitive_indices);
+	unlockChildShapes();
+
+	m_localAABB = m_box_set.getGlobalBox();
+}
+
+void btGImpactMeshShape::refitDirtyTriangles(bool clearDirtyTriangles)
+{
+	const btAlignedObjectArray<btDirtyTriangle>& dirtyTriangles = m_meshInterface->getDirtyTriangles();
+	if (dirtyTriangles.size() == 0) return;
+
+	m_localAABB.invalidate();
+	int i = m_mesh_parts.size();
+	while (i--)
+	{
+		m_mesh_parts[i]->refitDirtyTriangles(dirtyTriangles);
+		m_localAABB.merge(m_mesh_parts[i]->getLocalBox());
+	}
+	m_needs_update = false;
+
+	if (clearDirtyTriangles)
+	{
+		m_meshInterface->clearDirtyTriangles();
+	}
+}
+
 void btGImpactMeshShape::processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const
 {
 	int i = m_mesh_parts.size();
@@ -835,6 +835,12 @@ public:
 		return (int)m_primitive_manager.m_part;
 	}
 
+	//! Refits the box set for the dirty triangles of this part only, see btGImpactQuantizedBvh::updatePrimitives
+	/*!
+	Instead of postUpdate(), for meshes whose vertices were moved and marked with btStridingMeshInterface::markTriangleDirty.
+	*/
+	void refitDirtyTriangles(const btAlignedObjectArray<btDirtyTriangle>& dirtyTriangles);
+
 	virtual void processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const;
 	virtual void processAllTrianglesRay(btTriangleCallback* callback, const btVector3& rayFrom, const btVector3& rayTo) const;
 };
@@ -958,6 +964,12 @@ public:
 		m_needs_update = true;
 	}
 
+	//! Refits the parts for the triangles marked with btStridingMeshInterface::markTriangleDirty, instead of postUpdate()
+	/*!
+	Pass clearDirtyTriangles = false when the mesh interface is shared with other shapes, and clear it after all of them were refit.
+	*/
+	void refitDirtyTriangles(bool clearDirtyTriangles = true);
+
 	virtual void calculateLocalInertia(btScalar mass, btVector3& inertia) const;
 
 	//! Obtains the primitive manager
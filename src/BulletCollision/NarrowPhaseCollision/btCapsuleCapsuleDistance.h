@@ -0,0 +1,139 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CAPSULE_CAPSULE_DISTANCE_H
+#define BT_CAPSULE_CAPSULE_DISTANCE_H
+
+#include "LinearMath/btTransform.h"
+
+///closed form distance between the segments of two capsules, shared by btConvexConvexAlgorithm and btPrimitivePairCollisionAlgorithm.
+///A sphere is a capsule with a segment of length zero.
+
+static SIMD_FORCE_INLINE void segmentsClosestPoints(
+	btVector3& ptsVector,
+	btVector3& offsetA,
+	btVector3& offsetB,
+	btScalar& tA, btScalar& tB,
+	const btVector3& translation,
+	const btVector3& dirA, btScalar hlenA,
+	const btVector3& dirB, btScalar hlenB)
+{
+	// compute the parameters of the closest points on each line segment
+
+	btScalar dirA_dot_dirB = btDot(dirA, dirB);
+	btScalar dirA_dot_trans = btDot(dirA, translation);
+	btScalar dirB_dot_trans = btDot(dirB, translation);
+
+	btScalar denom = 1.0f - dirA_dot_dirB * dirA_dot_dirB;
+
+	if (denom == 0.0f)
+	{
+		tA = 0.0f;
+	}
+	else
+	{
+		tA = (dirA_dot_trans - dirB_dot_trans * dirA_dot_dirB) / denom;
+		if (tA < -hlenA)
+			tA = -hlenA;
+		else if (tA > hlenA)
+			tA = hlenA;
+	}
+
+	tB = tA * dirA_dot_dirB - dirB_dot_trans;
+
+	if (tB < -hlenB)
+	{
+		tB = -hlenB;
+		tA = tB * dirA_dot_dirB + dirA_dot_trans;
+
+		if (tA < -hlenA)
+			tA = -hlenA;
+		else if (tA > hlenA)
+			tA = hlenA;
+	}
+	else if (tB > hlenB)
+	{
+		tB = hlenB;
+		tA = tB * dirA_dot_dirB + dirA_dot_trans;
+
+		if (tA < -hlenA)
+			tA = -hlenA;
+		else if (tA > hlenA)
+			tA = hlenA;
+	}
+
+	// compute the closest points relative to segment centers.
+
+	offsetA = dirA * tA;
+	offsetB = dirB * tB;
+
+	ptsVector = translation - offsetA + offsetB;
+}
+
+static SIMD_FORCE_INLINE btScalar capsuleCapsuleDistance(
+	btVector3& normalOnB,
+	btVector3& pointOnB,
+	btScalar capsuleLengthA,
+	btScalar capsuleRadiusA,
+	btScalar capsuleLengthB,
+	btScalar capsuleRadiusB,
+	int capsuleAxisA,
+	int capsuleAxisB,
+	const btTransform& transformA,
+	const btTransform& transformB,
+	btScalar distanceThreshold)
+{
+	btVector3 directionA = transformA.getBasis().getColumn(capsuleAxisA);
+	btVector3 translationA = transformA.getOrigin();
+	btVector3 directionB = transformB.getBasis().getColumn(capsuleAxisB);
+	btVector3 translationB = transformB.getOrigin();
+
+	// translation between centers
+
+	btVector3 translation = translationB - translationA;
+
+	// compute the closest points of the capsule line segments
+
+	btVector3 ptsVector;  // the vector between the closest points
+
+	btVector3 offsetA, offsetB;  // offsets from segment centers to their closest points
+	btScalar tA, tB;             // parameters on line segment
+
+	segmentsClosestPoints(ptsVector, offsetA, offsetB, tA, tB, translation,
+						  directionA, capsuleLengthA, directionB, capsuleLengthB);
+
+	btScalar distance = ptsVector.length() - capsuleRadiusA - capsuleRadiusB;
+
+	if (distance > distanceThreshold)
+		return distance;
+
+	btScalar lenSqr = ptsVector.length2();
+	if (lenSqr <= (SIMD_EPSILON * SIMD_EPSILON))
+	{
+		//degenerate case where 2 capsules are likely at the same location: take a vector tangential to 'directionA'
+		btVector3 q;
+		btPlaneSpace1(directionA, normalOnB, q);
+	}
+	else
+	{
+		// compute the contact normal
+		normalOnB = ptsVector * -btRecipSqrt(lenSqr);
+	}
+	pointOnB = transformB.getOrigin() + offsetB + normalOnB * capsuleRadiusB;
+
+	return distance;
+}
+
+#endif  //BT_CAPSULE_CAPSULE_DISTANCE_H
@@ -22,6 +22,7 @@ class btConvexShape;
 class btTransform;
 
 ///ConvexPenetrationDepthSolver provides an interface for penetration depth calculation.
+///On input, a non-zero v is an optional guess of the penetration direction. On output v is the normal, or zero if no result was found.
 class btConvexPenetrationDepthSolver
 {
 public:
@@ -0,0 +1,305 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CONVEX_TEMPLATE_SHAPES_H
+#define BT_CONVEX_TEMPLATE_SHAPES_H
+
+#include "LinearMath/btTransform.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletCollision/CollisionShapes/btCapsuleShape.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btCylinderShape.h"
+#include "BulletCollision/CollisionShapes/btConvexHullShape.h"
+#include "BulletCollision/CollisionShapes/btConvexSupportAccelerator.h"
+
+///The btConvexTemplate types adapt the collision shapes to the templated GJK (btGjkEpa3.h) and MPR (btMprPenetration.h).
+///Each type is specialized for one shape type, so the support functions are inlined into the solver instead of
+///going through the virtual btConvexShape interface. btConvexTemplateShape handles all other convex shapes,
+///using the non-virtual switch of btConvexShape.
+struct btConvexTemplateBase
+{
+	btTransform m_worldTrans;
+	btScalar m_margin;
+
+	btConvexTemplateBase(const btConvexShape* shape, const btTransform& worldTrans)
+		: m_worldTrans(worldTrans),
+		  m_margin(shape->getMarginNonVirtual())
+	{
+	}
+
+	SIMD_FORCE_INLINE btScalar getMargin() const
+	{
+		return m_margin;
+	}
+	SIMD_FORCE_INLINE btVector3 getObjectCenterInWorld() const
+	{
+		return m_worldTrans.getOrigin();
+	}
+	SIMD_FORCE_INLINE const btTransform& getWorldTransform() const
+	{
+		return m_worldTrans;
+	}
+
+	SIMD_FORCE_INLINE btVector3 addMargin(const btVector3& supportWithoutMargin, const btVector3& dir) const
+	{
+		const btScalar len2 = dir.length2();
+		if (len2 < SIMD_EPSILON * SIMD_EPSILON)
+		{
+			return supportWithoutMargin;
+		}
+		return supportWithoutMargin + dir * (m_margin / btSqrt(len2));
+	}
+};
+
+///a sphere is a point with a margin
+struct btConvexTemplateSphere : public btConvexTemplateBase
+{
+	btConvexTemplateSphere(const btCollisionShape* shape, const btTransform& worldTrans)
+		: btConvexTemplateBase(static_cast<const btSphereShape*>(shape), worldTrans)
+	{
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3&) const
+	{
+		return btVector3(btScalar(0.), btScalar(0.), btScalar(0.));
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return addMargin(btVector3(btScalar(0.), btScalar(0.), btScalar(0.)), dir);
+	}
+	SIMD_FORCE_INLINE int getUpAxis() const
+	{
+		return 1;
+	}
+	SIMD_FORCE_INLINE btScalar getHalfHeight() const
+	{
+		return btScalar(0.);
+	}
+};
+
+///a capsule is a segment along the up axis with a margin
+struct btConvexTemplateCapsule : public btConvexTemplateBase
+{
+	int m_upAxis;
+	btScalar m_halfHeight;
+
+	btConvexTemplateCapsule(const btCollisionShape* shape, const btTransform& worldTrans)
+		: btConvexTemplateBase(static_cast<const btCapsuleShape*>(shape), worldTrans),
+		  m_upAxis(static_cast<const btCapsuleShape*>(shape)->getUpAxis()),
+		  m_halfHeight(static_cast<const btCapsuleShape*>(shape)->getHalfHeight())
+	{
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		btVector3 supVec(btScalar(0.), btScalar(0.), btScalar(0.));
+		supVec[m_upAxis] = dir[m_upAxis] < btScalar(0.) ? -m_halfHeight : m_halfHeight;
+		return supVec;
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return addMargin(getLocalSupportWithoutMargin(dir), dir);
+	}
+	SIMD_FORCE_INLINE int getUpAxis() const
+	{
+		return m_upAxis;
+	}
+	SIMD_FORCE_INLINE btScalar getHalfHeight() const
+	{
+		return m_halfHeight;
+	}
+};
+
+struct btConvexTemplateBox : public btConvexTemplateBase
+{
+	btVector3 m_halfExtents;
+
+	btConvexTemplateBox(const btCollisionShape* shape, const btTransform& worldTrans)
+		: btConvexTemplateBase(static_cast<const btBoxShape*>(shape), worldTrans),
+		  m_halfExtents(static_cast<const btBoxShape*>(shape)->getHalfExtentsWithoutMargin())
+	{
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		return btVector3(btFsels(dir.x(), m_halfExtents.x(), -m_halfExtents.x()),
+						 btFsels(dir.y(), m_halfExtents.y(), -m_halfExtents.y()),
+						 btFsels(dir.z(), m_halfExtents.z(), -m_halfExtents.z()));
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return addMargin(getLocalSupportWithoutMargin(dir), dir);
+	}
+};
+
+///a cylinder along the up axis, the same support function as btCylinderShape, btCylinderShapeX and btCylinderShapeZ
+struct btConvexTemplateCylinder : public btConvexTemplateBase
+{
+	int m_upAxis;
+	btScalar m_radius;
+	btScalar m_halfHeight;
+
+	btConvexTemplateCylinder(const btCollisionShape* shape, const btTransform& worldTrans)
+		: btConvexTemplateBase(static_cast<const btCylinderShape*>(shape), worldTrans),
+		  m_upAxis(static_cast<const btCylinderShape*>(shape)->getUpAxis())
+	{
+		const btVector3& halfExtents = static_cast<const btCylinderShape*>(shape)->getHalfExtentsWithoutMargin();
+		m_radius = halfExtents[m_upAxis == 0 ? 1 : 0];
+		m_halfHeight = halfExtents[m_upAxis];
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		const int axis1 = (m_upAxis + 1) % 3;
+		const int axis2 = (m_upAxis + 2) % 3;
+		btVector3 supVec;
+		const btScalar s = btSqrt(dir[axis1] * dir[axis1] + dir[axis2] * dir[axis2]);
+		if (s != btScalar(0.))
+		{
+			const btScalar d = m_radius / s;
+			supVec[axis1] = dir[axis1] * d;
+			supVec[axis2] = dir[axis2] * d;
+		}
+		else
+		{
+			supVec[axis1] = m_radius;
+			supVec[axis2] = btScalar(0.);
+		}
+		supVec[m_upAxis] = dir[m_upAxis] < btScalar(0.) ? -m_halfHeight : m_halfHeight;
+		return supVec;
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return addMargin(getLocalSupportWithoutMargin(dir), dir);
+	}
+};
+
+///uses the support accelerator of the hull when it has one
+struct btConvexTemplateHull : public btConvexTemplateBase
+{
+	const btVector3* m_points;
+	int m_numPoints;
+	btVector3 m_localScaling;
+	const btConvexSupportAccelerator* m_accelerator;
+
+	btConvexTemplateHull(const btCollisionShape* shape, const btTransform& worldTrans)
+		: btConvexTemplateBase(static_cast<const btConvexHullShape*>(shape), worldTrans),
+		  m_points(static_cast<const btConvexHullShape*>(shape)->getUnscaledPoints()),
+		  m_numPoints(static_cast<const btConvexHullShape*>(shape)->getNumPoints()),
+		  m_localScaling(shape->getLocalScaling()),
+		  m_accelerator(static_cast<const btConvexHullShape*>(shape)->getSupportAccelerator())
+	{
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		if (m_accelerator)
+		{
+			return m_accelerator->localGetSupportingVertexWithoutMargin(dir, m_localScaling);
+		}
+		if (m_numPoints <= 0)
+		{
+			return btVector3(btScalar(0.), btScalar(0.), btScalar(0.));
+		}
+		btScalar maxDot;
+		const long index = (dir * m_localScaling).maxDot(m_points, m_numPoints, maxDot);
+		return m_points[index] * m_localScaling;
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return addMargin(getLocalSupportWithoutMargin(dir), dir);
+	}
+};
+
+///any other convex shape, through the non-virtual support function of btConvexShape
+struct btConvexTemplateShape : public btConvexTemplateBase
+{
+	const btConvexShape* m_convex;
+
+	btConvexTemplateShape(const btCollisionShape* shape, const btTransform& worldTrans)
+		: btConvexTemplateBase(static_cast<const btConvexShape*>(shape), worldTrans),
+		  m_convex(static_cast<const btConvexShape*>(shape))
+	{
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		return m_convex->localGetSupportVertexWithoutMarginNonVirtual(dir);
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return addMargin(getLocalSupportWithoutMargin(dir), dir);
+	}
+};
+
+///presents the core of a shape, without its margin, to GJK: the core of a sphere is a point and the core of a capsule
+///is a segment, so GJK converges in a few iterations, where the rounded shapes would need many
+template <typename btConvexTemplate>
+struct btConvexTemplateCore
+{
+	const btConvexTemplate& m_convex;
+
+	btConvexTemplateCore(const btConvexTemplate& convex)
+		: m_convex(convex)
+	{
+	}
+	SIMD_FORCE_INLINE btScalar getMargin() const
+	{
+		return btScalar(0.);
+	}
+	SIMD_FORCE_INLINE btVector3 getObjectCenterInWorld() const
+	{
+		return m_convex.getObjectCenterInWorld();
+	}
+	SIMD_FORCE_INLINE const btTransform& getWorldTransform() const
+	{
+		return m_convex.getWorldTransform();
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithoutMargin(const btVector3& dir) const
+	{
+		return m_convex.getLocalSupportWithoutMargin(dir);
+	}
+	SIMD_FORCE_INLINE btVector3 getLocalSupportWithMargin(const btVector3& dir) const
+	{
+		return m_convex.getLocalSupportWithoutMargin(dir);
+	}
+
+private:
+	btConvexTemplateCore& operator=(const btConvexTemplateCore&);
+};
+
+///the btConvexTemplate type that adapts a shape type, to select the instantiation of a templated solver
+enum btConvexTemplateType
+{
+	BT_CONVEX_TEMPLATE_SPHERE,
+	BT_CONVEX_TEMPLATE_CAPSULE,
+	BT_CONVEX_TEMPLATE_BOX,
+	BT_CONVEX_TEMPLATE_HULL,
+	BT_CONVEX_TEMPLATE_CONVEX,
+	BT_CONVEX_TEMPLATE_NUM_TYPES
+};
+
+SIMD_FORCE_INLINE int btGetConvexTemplateType(int shapeType)
+{
+	switch (shapeType)
+	{
+		case SPHERE_SHAPE_PROXYTYPE:
+			return BT_CONVEX_TEMPLATE_SPHERE;
+		case CAPSULE_SHAPE_PROXYTYPE:
+			return BT_CONVEX_TEMPLATE_CAPSULE;
+		case BOX_SHAPE_PROXYTYPE:
+			return BT_CONVEX_TEMPLATE_BOX;
+		case CONVEX_HULL_SHAPE_PROXYTYPE:
+			return BT_CONVEX_TEMPLATE_HULL;
+		default:
+			return BT_CONVEX_TEMPLATE_CONVEX;
+	}
+}
+
+#endif  //BT_CONVEX_TEMPLATE_SHAPES_H
@@ -74,23 +74,25 @@ struct btGjkEpaSolver3
 #define EPA_PLANE_EPS ((btScalar)0.00001)
 #define EPA_INSIDE_EPS ((btScalar)0.01)
 
+namespace gjkepa3_impl
+{
 // Shorthands
 typedef unsigned int U;
 typedef unsigned char U1;
 
 // MinkowskiDiff
-template <typename btConvexTemplate>
+template <typename btConvexTemplateA, typename btConvexTemplateB>
 struct MinkowskiDiff
 {
-	const btConvexTemplate* m_convexAPtr;
-	const btConvexTemplate* m_convexBPtr;
+	const btConvexTemplateA* m_convexAPtr;
+	const btConvexTemplateB* m_convexBPtr;
 
 	btMatrix3x3 m_toshape1;
 	btTransform m_toshape0;
 
 	bool m_enableMargin;
 
-	MinkowskiDiff(const btConvexTemplate& a, const btConvexTemplate& b)
+	MinkowskiDiff(const btConvexTemplateA& a, const btConvexTemplateB& b)
 		: m_convexAPtr(&a),
 		  m_convexBPtr(&b)
 	{
@@ -130,7 +132,7 @@ enum eGjkStatus
 };
 
 // GJK
-template <typename btConvexTemplate>
+template <typename btConvexTemplateA, typename btConvexTemplateB>
 struct GJK
 {
 	/* Types		*/
@@ -147,7 +149,7 @@ struct GJK
 
 	/* Fields		*/
 
-	MinkowskiDiff<btConvexTemplate> m_shape;
+	MinkowskiDiff<btConvexTemplateA, btConvexTemplateB> m_shape;
 	btVector3 m_ray;
 	btScalar m_distance;
 	sSimplex m_simplices[2];
@@ -159,7 +161,7 @@ struct GJK
 	eGjkStatus m_status;
 	/* Methods		*/
 
-	GJK(const btConvexTemplate& a, const btConvexTemplate& b)
+	GJK(const btConvexTemplateA& a, const btConvexTemplateB& b)
 		: m_shape(a, b)
 	{
 		Initialize();
@@ -172,13 +174,11 @@ struct GJK
 		m_current = 0;
 		m_distance = 0;
 	}
-	eGjkStatus Evaluate(const MinkowskiDiff<btConvexTemplate>& shapearg, const btVector3& guess)
+	eGjkStatus Evaluate(const MinkowskiDiff<btConvexTemplateA, btConvexTemplateB>& shapearg, const btVector3& guess)
 	{
 		U iterations = 0;
 		btScalar sqdist = 0;
 		btScalar alpha = 0;
-		btVector3 lastw[4];
-		U clastw = 0;
 		/* Initialize solver		*/
 		m_free[0] = &m_store[0];
 		m_free[1] = &m_store[1];
@@ -197,10 +197,6 @@ struct GJK
 		m_simplices[0].p[0] = 1;
 		m_ray = m_simplices[0].c[0]->w;
 		sqdist = sqrl;
-		lastw[0] =
-			lastw[1] =
-				lastw[2] =
-					lastw[3] = m_ray;
 		/* Loop						*/
 		do
 		{
@@ -217,10 +213,12 @@ struct GJK
 			/* Append new vertice in -'v' direction	*/
 			appendvertice(cs, -m_ray);
 			const btVector3& w = cs.c[cs.rank - 1]->w;
+			//only a vertex of the current simplex means convergence: the vertices dropped by the reduction
+			//can come back, and stopping on them returned a distance with the origin inside the shapes
 			bool found = false;
-			for (U i = 0; i < 4; ++i)
+			for (U i = 0; i + 1 < cs.rank; ++i)
 			{
-				if ((w - lastw[i]).length2() < GJK_DUPLICATED_EPS)
+				if ((w - cs.c[i]->w).length2() < GJK_DUPLICATED_EPS)
 				{
 					found = true;
 					break;
@@ -231,10 +229,6 @@ struct GJK
 				removevertice(m_simplices[m_current]);
 				break;
 			}
-			else
-			{ /* Update lastw					*/
-				lastw[clastw = (clastw + 1) & 3] = w;
-			}
 			/* Check for termination				*/
 			const btScalar omega = btDot(m_ray, w) / rl;
 			alpha = btMax(omega, alpha);
@@ -540,7 +534,7 @@ enum eEpaStatus
 };
 
 // EPA
-template <typename btConvexTemplate>
+template <typename btConvexTemplateA, typename btConvexTemplateB>
 struct EPA
 {
 	/* Types		*/
@@ -549,7 +543,7 @@ struct EPA
 	{
 		btVector3 n;
 		btScalar d;
-		typename GJK<btConvexTemplate>::sSV* c[3];
+		typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* c[3];
 		sFace* f[3];
 		sFace* l[2];
 		U1 e[3];
@@ -571,10 +565,10 @@ struct EPA
 
 	/* Fields		*/
 	eEpaStatus m_status;
-	typename GJK<btConvexTemplate>::sSimplex m_result;
+	typename GJK<btConvexTemplateA, btConvexTemplateB>::sSimplex m_result;
 	btVector3 m_normal;
 	btScalar m_depth;
-	typename GJK<btConvexTemplate>::sSV m_sv_store[EPA_MAX_VERTICES];
+	typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV m_sv_store[EPA_MAX_VERTICES];
 	sFace m_fc_store[EPA_MAX_FACES];
 	U m_nextsv;
 	sList m_hull;
@@ -619,9 +613,9 @@ struct EPA
 			append(m_stock, &m_fc_store[EPA_MAX_FACES - i - 1]);
 		}
 	}
-	eEpaStatus Evaluate(GJK<btConvexTemplate>& gjk, const btVector3& guess)
+	eEpaStatus Evaluate(GJK<btConvexTemplateA, btConvexTemplateB>& gjk, const btVector3& guess)
 	{
-		typename GJK<btConvexTemplate>::sSimplex& simplex = *gjk.m_simplex;
+		typename GJK<btConvexTemplateA, btConvexTemplateB>::sSimplex& simplex = *gjk.m_simplex;
 		if ((simplex.rank > 1) && gjk.EncloseOrigin())
 		{
 			/* Clean up				*/
@@ -664,7 +658,7 @@ struct EPA
 					if (m_nextsv < EPA_MAX_VERTICES)
 					{
 						sHorizon horizon;
-						typename GJK<btConvexTemplate>::sSV* w = &m_sv_store[m_nextsv++];
+						typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* w = &m_sv_store[m_nextsv++];
 						bool valid = true;
 						best->pass = (U1)(++pass);
 						gjk.getsupport(best->n, *w);
@@ -740,7 +734,7 @@ struct EPA
 		m_result.p[0] = 1;
 		return (m_status);
 	}
-	bool getedgedist(sFace* face, typename GJK<btConvexTemplate>::sSV* a, typename GJK<btConvexTemplate>::sSV* b, btScalar& dist)
+	bool getedgedist(sFace* face, typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* a, typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* b, btScalar& dist)
 	{
 		const btVector3 ba = b->w - a->w;
 		const btVector3 n_ab = btCross(ba, face->n);   // Outward facing edge normal direction, on triangle plane
@@ -776,7 +770,7 @@ struct EPA
 
 		return false;
 	}
-	sFace* newface(typename GJK<btConvexTemplate>::sSV* a, typename GJK<btConvexTemplate>::sSV* b, typename GJK<btConvexTemplate>::sSV* c, bool forced)
+	sFace* newface(typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* a, typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* b, typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* c, bool forced)
 	{
 		if (m_stock.root)
 		{
@@ -835,7 +829,7 @@ struct EPA
 		}
 		return (minf);
 	}
-	bool expand(U pass, typename GJK<btConvexTemplate>::sSV* w, sFace* f, U e, sHorizon& horizon)
+	bool expand(U pass, typename GJK<btConvexTemplateA, btConvexTemplateB>::sSV* w, sFace* f, U e, sHorizon& horizon)
 	{
 		static const U i1m3[] = {1, 2, 0};
 		static const U i2m3[] = {2, 0, 1};
@@ -874,10 +868,10 @@ struct EPA
 	}
 };
 
-template <typename btConvexTemplate>
-static void Initialize(const btConvexTemplate& a, const btConvexTemplate& b,
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+static void Initialize(const btConvexTemplateA& a, const btConvexTemplateB& b,
 					   btGjkEpaSolver3::sResults& results,
-					   MinkowskiDiff<btConvexTemplate>& shape)
+					   MinkowskiDiff<btConvexTemplateA, btConvexTemplateB>& shape)
 {
 	/* Results		*/
 	results.witnesses[0] =
@@ -889,25 +883,27 @@ static void Initialize(const btConvexTemplate& a, const btConvexTemplate& b,
 	shape.m_toshape0 = a.getWorldTransform().inverseTimes(b.getWorldTransform());
 }
 
+}  // namespace gjkepa3_impl
+
 //
 // Api
 //
 
 //
-template <typename btConvexTemplate>
-bool btGjkEpaSolver3_Distance(const btConvexTemplate& a, const btConvexTemplate& b,
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+bool btGjkEpaSolver3_Distance(const btConvexTemplateA& a, const btConvexTemplateB& b,
 							  const btVector3& guess,
 							  btGjkEpaSolver3::sResults& results)
 {
-	MinkowskiDiff<btConvexTemplate> shape(a, b);
-	Initialize(a, b, results, shape);
-	GJK<btConvexTemplate> gjk(a, b);
-	eGjkStatus gjk_status = gjk.Evaluate(shape, guess);
-	if (gjk_status == eGjkValid)
+	gjkepa3_impl::MinkowskiDiff<btConvexTemplateA, btConvexTemplateB> shape(a, b);
+	gjkepa3_impl::Initialize(a, b, results, shape);
+	gjkepa3_impl::GJK<btConvexTemplateA, btConvexTemplateB> gjk(a, b);
+	gjkepa3_impl::eGjkStatus gjk_status = gjk.Evaluate(shape, guess);
+	if (gjk_status == gjkepa3_impl::eGjkValid)
 	{
 		btVector3 w0 = btVector3(0, 0, 0);
 		btVector3 w1 = btVector3(0, 0, 0);
-		for (U i = 0; i < gjk.m_simplex->rank; ++i)
+		for (gjkepa3_impl::U i = 0; i < gjk.m_simplex->rank; ++i)
 		{
 			const btScalar p = gjk.m_simplex->p[i];
 			w0 += shape.Support(gjk.m_simplex->c[i]->d, 0) * p;
@@ -922,31 +918,31 @@ bool btGjkEpaSolver3_Distance(const btConvexTemplate& a, const btConvexTemplate&
 	}
 	else
 	{
-		results.status = gjk_status == eGjkInside ? btGjkEpaSolver3::sResults::Penetrating : btGjkEpaSolver3::sResults::GJK_Failed;
+		results.status = gjk_status == gjkepa3_impl::eGjkInside ? btGjkEpaSolver3::sResults::Penetrating : btGjkEpaSolver3::sResults::GJK_Failed;
 		return (false);
 	}
 }
 
-template <typename btConvexTemplate>
-bool btGjkEpaSolver3_Penetration(const btConvexTemplate& a,
-								 const btConvexTemplate& b,
+template <typename btConvexTemplateA, typename btConvexTemplateB>
+bool btGjkEpaSolver3_Penetration(const btConvexTemplateA& a,
+								 const btConvexTemplateB& b,
 								 const btVector3& guess,
 								 btGjkEpaSolver3::sResults& results)
 {
-	MinkowskiDiff<btConvexTemplate> shape(a, b);
-	Initialize(a, b, results, shape);
-	GJK<btConvexTemplate> gjk(a, b);
-	eGjkStatus gjk_status = gjk.Evaluate(shape, -guess);
+	gjkepa3_impl::MinkowskiDiff<btConvexTemplateA, btConvexTemplateB> shape(a, b);
+	gjkepa3_impl::Initialize(a, b, results, shape);
+	gjkepa3_impl::GJK<btConvexTemplateA, btConvexTemplateB> gjk(a, b);
+	gjkepa3_impl::eGjkStatus gjk_status = gjk.Evaluate(shape, -guess);
 	switch (gjk_status)
 	{
-		case eGjkInside:
+		case gjkepa3_impl::eGjkInside:
 		{
-			EPA<btConvexTemplate> epa;
-			eEpaStatus epa_status = epa.Evaluate(gjk, -guess);
-			if (epa_status != eEpaFailed)
+			gjkepa3_impl::EPA<btConvexTemplateA, btConvexTemplateB> epa;
+			gjkepa3_impl::eEpaStatus epa_status = epa.Evaluate(gjk, -guess);
+			if (epa_status != gjkepa3_impl::eEpaFailed)
 			{
 				btVector3 w0 = btVector3(0, 0, 0);
-				for (U i = 0; i < epa.m_result.rank; ++i)
+				for (gjkepa3_impl::U i = 0; i < epa.m_result.rank; ++i)
 				{
 					w0 += shape.Support(epa.m_result.c[i]->d, 0) * epa.m_result.p[i];
 				}
@@ -961,7 +957,7 @@ bool btGjkEpaSolver3_Penetration(const btConvexTemplate& a,
 				results.status = btGjkEpaSolver3::sResults::EPA_Failed;
 		}
 		break;
-		case eGjkFailed:
+		case gjkepa3_impl::eGjkFailed:
 			results.status = btGjkEpaSolver3::sResults::GJK_Failed;
 			break;
 		default:
@@ -1020,8 +1016,8 @@ int	btComputeGjkEpaPenetration2(const btCollisionDescription& colDesc, btDistanc
 }
 #endif
 
-template <typename btConvexTemplate, typename btDistanceInfoTemplate>
-int btComputeGjkDistance(const btConvexTemplate& a, const btConvexTemplate& b,
+template <typename btConvexTemplateA, typename btConvexTemplateB, typename btDistanceInfoTemplate>
+int btComputeGjkDistance(const btConvexTemplateA& a, const btConvexTemplateB& b,
 						 const btGjkCollisionDescription& colDesc, btDistanceInfoTemplate* distInfo)
 {
 	btGjkEpaSolver3::sResults results;
@@ -27,10 +27,13 @@ bool btGjkEpaPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& simp
 												  class btIDebugDraw* debugDraw)
 {
 	(void)debugDraw;
-	(void)v;
 	(void)simplexSolver;
 
+	//a non-zero v is a guess of the penetration direction, for instance the normal of the previous frame
+	const bool useInitialGuess = v.length2() > SIMD_EPSILON;
+
 	btVector3 guessVectors[] = {
+		v,
 		btVector3(transformB.getOrigin() - transformA.getOrigin()).safeNormalize(),
 		btVector3(transformA.getOrigin() - transformB.getOrigin()).safeNormalize(),
 		btVector3(0, 0, 1),
@@ -44,7 +47,7 @@ bool btGjkEpaPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& simp
 
 	int numVectors = sizeof(guessVectors) / sizeof(btVector3);
 
-	for (int i = 0; i < numVectors; i++)
+	for (int i = useInitialGuess ? 0 : 1; i < numVectors; i++)
 	{
 		simplexSolver.reset();
 		btVector3 guessVector = guessVectors[i];
@@ -15,6 +15,7 @@ subject to the following restrictions:
 
 #include "btGjkPairDetector.h"
 #include "BulletCollision/CollisionShapes/btConvexShape.h"
+#include "BulletCollision/CollisionShapes/btTriangleShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btSimplexSolverInterface.h"
 #include "BulletCollision/NarrowPhaseCollision/btConvexPenetrationDepthSolver.h"
 
@@ -36,6 +37,49 @@ btScalar gGjkEpaPenetrationTolerance = 1.0e-12;
 btScalar gGjkEpaPenetrationTolerance = 0.001;
 #endif
 
+static void getTriangleVertices(const btConvexShape *shape, btVector3 *vertices)
+{
+	if (shape->getShapeType() == TRIANGLE_SHAPE_PROXYTYPE)
+	{
+		const btTriangleShape *triangle = static_cast<const btTriangleShape *>(shape);
+		for (int i = 0; i < 3; i++)
+		{
+			vertices[i] = triangle->m_vertices1[i];
+		}
+	}
+}
+
+static bool matchesTriangleVertices(const btConvexShape *shape, const btVector3 *vertices)
+{
+	if (shape->getShapeType() != TRIANGLE_SHAPE_PROXYTYPE)
+	{
+		return true;
+	}
+	const btTriangleShape *triangle = static_cast<const btTriangleShape *>(shape);
+	return (triangle->m_vertices1[0] == vertices[0]) && (triangle->m_vertices1[1] == vertices[1]) && (triangle->m_vertices1[2] == vertices[2]);
+}
+
+void btGjkWarmStartCache::setShapes(const btConvexShape *shapeA, const btConvexShape *shapeB)
+{
+	m_shapeA = shapeA;
+	m_shapeB = shapeB;
+	m_localScalingA = shapeA->getLocalScaling();
+	m_localScalingB = shapeB->getLocalScaling();
+	m_marginA = shapeA->getMargin();
+	m_marginB = shapeB->getMargin();
+	getTriangleVertices(shapeA, m_triangleA);
+	getTriangleVertices(shapeB, m_triangleB);
+}
+
+bool btGjkWarmStartCache::matchesShapes(const btConvexShape *shapeA, const btConvexShape *shapeB) const
+{
+	//the cached support points are in the local spaces of the shapes, so they are stale after a scaling or margin change,
+	//or when another triangle is passed in the same btTriangleShape
+	return (m_shapeA == shapeA) && (m_shapeB == shapeB) &&
+		   (m_localScalingA == shapeA->getLocalScaling()) && (m_localScalingB == shapeB->getLocalScaling()) &&
+		   (m_marginA == shapeA->getMargin()) && (m_marginB == shapeB->getMargin()) &&
+		   matchesTriangleVertices(shapeA, m_triangleA) && matchesTriangleVertices(shapeB, m_triangleB);
+}
 
 btGjkPairDetector::btGjkPairDetector(const btConvexShape *objectA, const btConvexShape *objectB, btSimplexSolverInterface *simplexSolver, btConvexPenetrationDepthSolver *penetrationDepthSolver)
 	: m_cachedSeparatingAxis(btScalar(0.), btScalar(1.), btScalar(0.)),
@@ -48,6 +92,7 @@ btGjkPairDetector::btGjkPairDetector(const btConvexShape *objectA, const btConve
 	  m_marginA(objectA->getMargin()),
 	  m_marginB(objectB->getMargin()),
 	  m_ignoreMargin(false),
+	  m_warmStartCache(0),
 	  m_lastUsedMethod(-1),
 	  m_catchDegeneracies(1),
 	  m_fixContactNormalDirection(1)
@@ -64,6 +109,7 @@ btGjkPairDetector::btGjkPairDetector(const btConvexShape *objectA, const btConve
 	  m_marginA(marginA),
 	  m_marginB(marginB),
 	  m_ignoreMargin(false),
+	  m_warmStartCache(0),
 	  m_lastUsedMethod(-1),
 	  m_catchDegeneracies(1),
 	  m_fixContactNormalDirection(1)
@@ -717,6 +763,13 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 	int gGjkMaxIter = 1000;  //this is to catch invalid input, perhaps check for #NaN?
 	m_cachedSeparatingAxis.setValue(0, 1, 0);
 
+	//the cached simplex is stored in the local spaces of the shapes, which is not possible for the flattened 2d supports
+	const bool useWarmStart = m_warmStartCache && !check2d && m_warmStartCache->matchesShapes(m_minkowskiA, m_minkowskiB);
+	if (useWarmStart && m_warmStartCache->m_separatingAxis.length2() > SIMD_EPSILON)
+	{
+		m_cachedSeparatingAxis = m_warmStartCache->m_separatingAxis;
+	}
+
 	bool isValid = false;
 	bool checkSimplex = false;
 	bool checkPenetration = true;
@@ -742,6 +795,11 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 		btSimplexInit(simplex);
 
 		btVector3 dir(1, 0, 0);
+		if (useWarmStart && m_warmStartCache->m_separatingAxis.length2() > SIMD_EPSILON)
+		{
+			//start from the side of the Minkowski difference that was closest to the origin in the previous query
+			dir = -m_warmStartCache->m_separatingAxis;
+		}
 
 		{
 			btVector3 lastSupV;
@@ -823,6 +881,33 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 		}
 
 		m_simplexSolver->reset();
+		if (useWarmStart && m_warmStartCache->m_numVertices)
+		{
+			//rebuild the simplex of the previous query from the same support points, moved with the shapes.
+			//they are still points of the Minkowski difference, so the closest point of the simplex is an upper bound
+			//of the distance and GJK converges from there, in a single iteration for resting contacts.
+			for (int i = 0; i < m_warmStartCache->m_numVertices; i++)
+			{
+				btVector3 pWorld = localTransA(m_warmStartCache->m_localSupportA[i]);
+				btVector3 qWorld = localTransB(m_warmStartCache->m_localSupportB[i]);
+				btVector3 w = pWorld - qWorld;
+				if (!m_simplexSolver->inSimplex(w))
+				{
+					m_simplexSolver->addVertex(w, pWorld, qWorld);
+				}
+			}
+			btVector3 v;
+			if (m_simplexSolver->closest(v) && v.length2() >= REL_ERROR2)
+			{
+				m_cachedSeparatingAxis = v;
+				squaredDistance = v.length2();
+			}
+			else
+			{
+				//the origin is inside the simplex or the simplex is degenerate, only keep the axis
+				m_simplexSolver->reset();
+			}
+		}
 		if (status == 0)
 		{
 			//status = 0;
@@ -1003,6 +1088,25 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 			}
 		}
 
+		if (m_warmStartCache && !check2d)
+		{
+			btVector3 pBuf[btGjkWarmStartCache::MAX_VERTICES];
+			btVector3 qBuf[btGjkWarmStartCache::MAX_VERTICES];
+			btVector3 yBuf[btGjkWarmStartCache::MAX_VERTICES];
+			const int numVertices = m_simplexSolver->getSimplex(pBuf, qBuf, yBuf);
+			for (int i = 0; i < numVertices; i++)
+			{
+				m_warmStartCache->m_localSupportA[i] = localTransA.invXform(pBuf[i]);
+				m_warmStartCache->m_localSupportB[i] = localTransB.invXform(qBuf[i]);
+			}
+			m_warmStartCache->m_numVertices = numVertices;
+			if (!useWarmStart)
+			{
+				m_warmStartCache->setShapes(m_minkowskiA, m_minkowskiB);
+				m_warmStartCache->m_penetrationAxis.setZero();
+			}
+		}
+
 		bool catchDegeneratePenetrationCase =
 			(m_catchDegeneracies && m_penetrationDepthSolver && m_degenerateSimplex && ((distance + margin) < gGjkEpaPenetrationTolerance));
 
@@ -1017,7 +1121,12 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 				// Penetration depth case.
 				btVector3 tmpPointOnA, tmpPointOnB;
 
+				//a non-zero axis is used as a guess of the penetration direction
 				m_cachedSeparatingAxis.setZero();
+				if (m_warmStartCache && !check2d)
+				{
+					m_cachedSeparatingAxis = m_warmStartCache->m_penetrationAxis;
+				}
 
 				bool isValid2 = m_penetrationDepthSolver->calcPenDepth(
 					*m_simplexSolver,
@@ -1026,6 +1135,11 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 					m_cachedSeparatingAxis, tmpPointOnA, tmpPointOnB,
 					debugDraw);
 
+				if (m_warmStartCache && !check2d)
+				{
+					m_warmStartCache->m_penetrationAxis = m_cachedSeparatingAxis;
+				}
+
 				if (m_cachedSeparatingAxis.length2())
 				{
 					if (isValid2)
@@ -1180,4 +1294,9 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput &inpu
 	{
 		//printf("invalid gjk query\n");
 	}
+
+	if (m_warmStartCache && !check2d && m_cachedSeparatingAxis.length2() > SIMD_EPSILON)
+	{
+		m_warmStartCache->m_separatingAxis = m_cachedSeparatingAxis;
+	}
 }
@@ -23,6 +23,61 @@ class btConvexShape;
 #include "btSimplexSolverInterface.h"
 class btConvexPenetrationDepthSolver;
 
+///btGjkWarmStartCache keeps the state of the last btGjkPairDetector query of a pair of shapes, so the query of the next frame
+///can start from it instead of from scratch: the final GJK simplex, stored as the support points in the local space of each shape,
+///the separating axis and the last normal found by the penetration depth solver.
+///It is only used for the shapes it was filled in for, with the same local scaling and margin, see btGjkPairDetector::setWarmStartCache.
+///Triangle shapes are also matched by their vertices, because the concave algorithms pass many triangles through the same
+///btTriangleShape object to one collision algorithm.
+///Editing the vertices of a shape is not detected: remove the pairs of its objects from the overlapping pair cache
+///(cleanProxyFromPairs), so that the collision algorithms and their caches are created again.
+struct btGjkWarmStartCache
+{
+	enum
+	{
+		MAX_VERTICES = 4
+	};
+	const btConvexShape* m_shapeA;
+	const btConvexShape* m_shapeB;
+	btVector3 m_localScalingA;
+	btVector3 m_localScalingB;
+	btScalar m_marginA;
+	btScalar m_marginB;
+	btVector3 m_triangleA[3];  // vertices of shape A if it is a triangle
+	btVector3 m_triangleB[3];  // vertices of shape B if it is a triangle
+	btVector3 m_separatingAxis;   // world space, zero if none
+	btVector3 m_penetrationAxis;  // world space, zero if none
+	btVector3 m_localSupportA[MAX_VERTICES];
+	btVector3 m_localSupportB[MAX_VERTICES];
+	int m_numVertices;
+
+	btGjkWarmStartCache()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		m_shapeA = 0;
+		m_shapeB = 0;
+		m_localScalingA.setZero();
+		m_localScalingB.setZero();
+		m_marginA = btScalar(0.);
+		m_marginB = btScalar(0.);
+		for (int i = 0; i < 3; i++)
+		{
+			m_triangleA[i].setZero();
+			m_triangleB[i].setZero();
+		}
+		m_separatingAxis.setZero();
+		m_penetrationAxis.setZero();
+		m_numVertices = 0;
+	}
+
+	void setShapes(const btConvexShape* shapeA, const btConvexShape* shapeB);
+	bool matchesShapes(const btConvexShape* shapeA, const btConvexShape* shapeB) const;
+};
+
 /// btGjkPairDetector uses GJK to implement the btDiscreteCollisionDetectorInterface
 class btGjkPairDetector : public btDiscreteCollisionDetectorInterface
 {
@@ -38,6 +93,7 @@ class btGjkPairDetector : public btDiscreteCollisionDetectorInterface
 
 	bool m_ignoreMargin;
 	btScalar m_cachedSeparatingDistance;
+	btGjkWarmStartCache* m_warmStartCache;
 
 public:
 	//some debugging to fix degeneracy problems
@@ -83,6 +139,13 @@ public:
 		m_penetrationDepthSolver = penetrationDepthSolver;
 	}
 
+	///when set, the queries start from the simplex and the axes stored in the cache by the previous query of the same shapes,
+	///and store their own state in it. The cache should belong to a single pair, e.g. to its collision algorithm.
+	void setWarmStartCache(btGjkWarmStartCache* warmStartCache)
+	{
+		m_warmStartCache = warmStartCache;
+	}
+
 	///don't use setIgnoreMargin, it's for Bullet's internal use
 	void setIgnoreMargin(bool ignoreMargin)
 	{
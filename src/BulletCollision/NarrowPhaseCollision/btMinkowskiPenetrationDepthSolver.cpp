@@ -27,8 +27,6 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 													 btVector3& v, btVector3& pa, btVector3& pb,
 													 class btIDebugDraw* debugDraw)
 {
-	(void)v;
-
 	bool check2d = convexA->isConvex2d() && convexB->isConvex2d();
 
 	struct btIntermediateResult : public btDiscreteCollisionDetectorInterface::Result
@@ -224,7 +222,10 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 	minB -= minNorm * convexB->getMarginNonVirtual();
 	//no penetration
 	if (minProj < btScalar(0.))
+	{
+		v.setZero();
 		return false;
+	}
 
 	btScalar extraSeparation = 0.5f;  ///scale dependent
 	minProj += extraSeparation + (convexA->getMarginNonVirtual() + convexB->getMarginNonVirtual());
@@ -282,6 +283,10 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 		}
 #endif  //DEBUG_DRAW
 	}
+	else
+	{
+		v.setZero();
+	}
 	return res.m_hasResult;
 }
 
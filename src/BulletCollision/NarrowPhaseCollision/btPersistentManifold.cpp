@@ -32,11 +32,15 @@ ContactEndedCallback gContactEndedCallback = 0;
 ///when setting it to false, it will use 4 points to compute the area: it is more accurate but slower
 bool gContactCalcArea3Points = true;
 
+//the serialized manifold data holds 4 points
+static const int btSerializedManifoldCacheSize = 4;
+
 btPersistentManifold::btPersistentManifold()
 	: btTypedObject(BT_PERSISTENT_MANIFOLD_TYPE),
 	  m_body0(0),
 	  m_body1(0),
 	  m_cachedPoints(0),
+	  m_speculativeContactDistance(0),
 	  m_companionIdA(0),
 	  m_companionIdB(0),
 	  m_index1a(0)
@@ -117,7 +121,7 @@ int btPersistentManifold::sortCachedPoints(const btManifoldPoint& pt)
 #define KEEP_DEEPEST_POINT 1
 #ifdef KEEP_DEEPEST_POINT
 	btScalar maxPenetration = pt.getDistance();
-	for (int i = 0; i < 4; i++)
+	for (int i = 0; i < MANIFOLD_CACHE_SIZE; i++)
 	{
 		if (m_pointCache[i].getDistance() < maxPenetration)
 		{
@@ -127,6 +131,57 @@ int btPersistentManifold::sortCachedPoints(const btManifoldPoint& pt)
 	}
 #endif  //KEEP_DEEPEST_POINT
 
+#if MANIFOLD_CACHE_SIZE != 4
+	//order the cached points and the new point by angle around their center in the contact plane,
+	//and replace the point that spans the smallest triangle with its two neighbors, so the remaining polygon keeps the largest area
+	const int numPoints = MANIFOLD_CACHE_SIZE + 1;
+	btVector3 points[numPoints];
+	btScalar angles[numPoints];
+	int order[numPoints];
+	btVector3 center(btScalar(0.), btScalar(0.), btScalar(0.));
+	for (int i = 0; i < numPoints; i++)
+	{
+		points[i] = i < MANIFOLD_CACHE_SIZE ? m_pointCache[i].m_positionWorldOnA : pt.m_positionWorldOnA;
+		center += points[i];
+	}
+	center /= btScalar(numPoints);
+
+	const btVector3& normal = pt.m_normalWorldOnB;
+	btVector3 planeU, planeV;
+	btPlaneSpace1(normal, planeU, planeV);
+	for (int i = 0; i < numPoints; i++)
+	{
+		btVector3 diff = points[i] - center;
+		angles[i] = btAtan2(diff.dot(planeV), diff.dot(planeU));
+		//insertion sort
+		int j = i;
+		for (; j > 0 && angles[order[j - 1]] > angles[i]; j--)
+		{
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	int replaceIndex = 0;
+	btScalar minArea = BT_LARGE_FLOAT;
+	for (int k = 0; k < numPoints; k++)
+	{
+		const int i = order[k];
+		if (i == MANIFOLD_CACHE_SIZE || i == maxPenetrationIndex)
+		{
+			continue;
+		}
+		const btVector3& prev = points[order[(k + numPoints - 1) % numPoints]];
+		const btVector3& next = points[order[(k + 1) % numPoints]];
+		btScalar area = (points[i] - prev).cross(next - points[i]).dot(normal);
+		if (area < minArea)
+		{
+			minArea = area;
+			replaceIndex = i;
+		}
+	}
+	return replaceIndex;
+#else
 	btScalar res0(btScalar(0.)), res1(btScalar(0.)), res2(btScalar(0.)), res3(btScalar(0.));
 
 	if (gContactCalcArea3Points)
@@ -187,11 +242,12 @@ int btPersistentManifold::sortCachedPoints(const btManifoldPoint& pt)
 	btVector4 maxvec(res0, res1, res2, res3);
 	int biggestarea = maxvec.closestAxis4();
 	return biggestarea;
+#endif  //MANIFOLD_CACHE_SIZE != 4
 }
 
 int btPersistentManifold::getCacheEntry(const btManifoldPoint& newPoint) const
 {
-	btScalar shortestDist = getContactBreakingThreshold() * getContactBreakingThreshold();
+	btScalar shortestDist = m_contactBreakingThreshold * m_contactBreakingThreshold;
 	int size = getNumContacts();
 	int nearestPoint = -1;
 	for (int i = 0; i < size; i++)
@@ -241,7 +297,7 @@ int btPersistentManifold::addManifoldPoint(const btManifoldPoint& newPoint, bool
 
 btScalar btPersistentManifold::getContactBreakingThreshold() const
 {
-	return m_contactBreakingThreshold;
+	return m_contactBreakingThreshold + m_speculativeContactDistance;
 }
 
 void btPersistentManifold::refreshContactPoints(const btTransform& trA, const btTransform& trB)
@@ -284,7 +340,7 @@ void btPersistentManifold::refreshContactPoints(const btTransform& trA, const bt
 			projectedPoint = manifoldPoint.m_positionWorldOnA - manifoldPoint.m_normalWorldOnB * manifoldPoint.m_distance1;
 			projectedDifference = manifoldPoint.m_positionWorldOnB - projectedPoint;
 			distance2d = projectedDifference.dot(projectedDifference);
-			if (distance2d > getContactBreakingThreshold() * getContactBreakingThreshold())
+			if (distance2d > m_contactBreakingThreshold * m_contactBreakingThreshold)
 			{
 				removeContactPoint(i);
 			}
@@ -301,6 +357,24 @@ void btPersistentManifold::refreshContactPoints(const btTransform& trA, const bt
 #endif  //
 }
 
+void btPersistentManifold::removeStaleContactPoints(const btTransform& trA, const btVector3* pointsOnA, int numPoints)
+{
+	const btScalar threshold2 = m_contactBreakingThreshold * m_contactBreakingThreshold;
+	for (int i = getNumContacts() - 1; i >= 0; i--)
+	{
+		const btVector3 positionOnA = trA(m_pointCache[i].m_localPointA);
+		bool found = false;
+		for (int j = 0; j < numPoints && !found; j++)
+		{
+			found = (pointsOnA[j] - positionOnA).length2() < threshold2;
+		}
+		if (!found)
+		{
+			removeContactPoint(i);
+		}
+	}
+}
+
 int btPersistentManifold::calculateSerializeBufferSize() const
 {
 	return sizeof(btPersistentManifoldData);
@@ -313,15 +387,16 @@ const char* btPersistentManifold::serialize(const class btPersistentManifold* ma
 
 	dataOut->m_body0 = (btCollisionObjectData*)serializer->getUniquePointer((void*)manifold->getBody0());
 	dataOut->m_body1 = (btCollisionObjectData*)serializer->getUniquePointer((void*)manifold->getBody1());
-	dataOut->m_contactBreakingThreshold = manifold->getContactBreakingThreshold();
+	dataOut->m_contactBreakingThreshold = manifold->m_contactBreakingThreshold;
 	dataOut->m_contactProcessingThreshold = manifold->getContactProcessingThreshold();
-	dataOut->m_numCachedPoints = manifold->getNumContacts();
+	const int numSerializedPoints = btMin(manifold->getNumContacts(), btSerializedManifoldCacheSize);
+	dataOut->m_numCachedPoints = numSerializedPoints;
 	dataOut->m_companionIdA = manifold->m_companionIdA;
 	dataOut->m_companionIdB = manifold->m_companionIdB;
 	dataOut->m_index1a = manifold->m_index1a;
 	dataOut->m_objectType = manifold->m_objectType;
 
-	for (int i = 0; i < this->getNumContacts(); i++)
+	for (int i = 0; i < numSerializedPoints; i++)
 	{
 		const btManifoldPoint& pt = manifold->getContactPoint(i);
 		dataOut->m_pointCacheAppliedImpulse[i] = pt.m_appliedImpulse;
@@ -361,7 +436,7 @@ void btPersistentManifold::deSerialize(const struct btPersistentManifoldDoubleDa
 {
 	m_contactBreakingThreshold = manifoldDataPtr->m_contactBreakingThreshold;
 	m_contactProcessingThreshold = manifoldDataPtr->m_contactProcessingThreshold;
-	m_cachedPoints = manifoldDataPtr->m_numCachedPoints;
+	m_cachedPoints = btMin(manifoldDataPtr->m_numCachedPoints, btMin(int(MANIFOLD_CACHE_SIZE), btSerializedManifoldCacheSize));
 	m_companionIdA = manifoldDataPtr->m_companionIdA;
 	m_companionIdB = manifoldDataPtr->m_companionIdB;
 	//m_index1a = manifoldDataPtr->m_index1a;
@@ -407,7 +482,7 @@ void btPersistentManifold::deSerialize(const struct btPersistentManifoldFloatDat
 {
 	m_contactBreakingThreshold = manifoldDataPtr->m_contactBreakingThreshold;
 	m_contactProcessingThreshold = manifoldDataPtr->m_contactProcessingThreshold;
-	m_cachedPoints = manifoldDataPtr->m_numCachedPoints;
+	m_cachedPoints = btMin(manifoldDataPtr->m_numCachedPoints, btMin(int(MANIFOLD_CACHE_SIZE), btSerializedManifoldCacheSize));
 	m_companionIdA = manifoldDataPtr->m_companionIdA;
 	m_companionIdB = manifoldDataPtr->m_companionIdB;
 	//m_index1a = manifoldDataPtr->m_index1a;
@@ -49,15 +49,20 @@ enum btContactManifoldTypes
 	BT_PERSISTENT_MANIFOLD_TYPE
 };
 
+///the maximum number of contact points per manifold. It can be raised at compile time, for example with -DMANIFOLD_CACHE_SIZE=8,
+///which lets resting polyhedra keep all corners of their contact polygon. All code using Bullet has to be compiled with the same value.
+#ifndef MANIFOLD_CACHE_SIZE
 #define MANIFOLD_CACHE_SIZE 4
+#endif
 
 ///btPersistentManifold is a contact point cache, it stays persistent as long as objects are overlapping in the broadphase.
 ///Those contact points are created by the collision narrow phase.
-///The cache can be empty, or hold 1,2,3 or 4 points. Some collision algorithms (GJK) might only add one point at a time.
+///The cache can be empty, or hold up to MANIFOLD_CACHE_SIZE points. Some collision algorithms (GJK) might only add one point at a time.
 ///updates/refreshes old contact points, and throw them away if necessary (distance becomes too large)
-///reduces the cache to 4 points, when more then 4 points are added, using following rules:
+///reduces the cache to MANIFOLD_CACHE_SIZE points, when more points are added, using following rules:
 ///the contact point with deepest penetration is always kept, and it tries to maximuze the area covered by the points
 ///note that some pairs of objects might have more then one contact manifold.
+///Only the first 4 points are serialized.
 
 //ATTRIBUTE_ALIGNED128( class) btPersistentManifold : public btTypedObject
 ATTRIBUTE_ALIGNED16(class)
@@ -73,6 +78,7 @@ btPersistentManifold : public btTypedObject
 
 	btScalar m_contactBreakingThreshold;
 	btScalar m_contactProcessingThreshold;
+	btScalar m_speculativeContactDistance;
 
 	/// sort cached points so most isolated points come first
 	int sortCachedPoints(const btManifoldPoint& pt);
@@ -96,6 +102,7 @@ public:
 		  m_cachedPoints(0),
 		  m_contactBreakingThreshold(contactBreakingThreshold),
 		  m_contactProcessingThreshold(contactProcessingThreshold),
+		  m_speculativeContactDistance(0),
 		  m_companionIdA(0),
 		  m_companionIdB(0),
 		  m_index1a(0)
@@ -157,6 +164,18 @@ public:
 		m_contactProcessingThreshold = contactProcessingThreshold;
 	}
 
+	///speculative contacts are kept up to this distance on top of the contact breaking threshold, see btDispatcherInfo::m_useSpeculativeContacts.
+	///Points are still matched and broken by their tangential drift with the contact breaking threshold alone.
+	btScalar getSpeculativeContactDistance() const
+	{
+		return m_speculativeContactDistance;
+	}
+
+	void setSpeculativeContactDistance(btScalar speculativeContactDistance)
+	{
+		m_speculativeContactDistance = speculativeContactDistance;
+	}
+
 	int getCacheEntry(const btManifoldPoint& newPoint) const;
 
 	int addManifoldPoint(const btManifoldPoint& newPoint, bool isPredictive = false);
@@ -245,6 +264,11 @@ public:
 	/// calculated new worldspace coordinates and depth, and reject points that exceed the collision margin
 	void refreshContactPoints(const btTransform& trA, const btTransform& trB);
 
+	///removes the contact points that are farther than the contact breaking threshold from all given world space points on body0.
+	///Collision algorithms that compute the complete contact set of a pair call it before adding the set, so the manifold
+	///does not keep outdated points, while the points that are found again keep their accumulated impulses.
+	void removeStaleContactPoints(const btTransform& trA, const btVector3* pointsOnA, int numPoints);
+
 	SIMD_FORCE_INLINE void clearManifold()
 	{
 		int i;
@@ -22,10 +22,45 @@ subject to the following restrictions:
 
 #include <float.h>  //for FLT_MAX
 
+#if !defined(BT_USE_DOUBLE_PRECISION) && (defined(BT_USE_SSE) || defined(__SSE__))
+#define BT_CLIP_USE_SSE
+#include <xmmintrin.h>
+#endif
+
 int gExpectedNbTests = 0;
 int gActualNbTests = 0;
 bool gUseInternalObject = true;
 
+//faces with more vertices use a temporary heap buffer for the plane distances
+#define BT_CLIP_MAX_LOCAL_VERTICES 64
+
+//signed distances of the vertices to a plane
+static void btComputePlaneDistances(const btVector3* vertices, int numVertices, const btVector3& planeNormal, btScalar planeEq, btScalar* distancesOut)
+{
+	int i = 0;
+#ifdef BT_CLIP_USE_SSE
+	//4 vertices per iteration: transpose them to x, y and z registers
+	const __m128 nx = _mm_set1_ps(planeNormal.getX());
+	const __m128 ny = _mm_set1_ps(planeNormal.getY());
+	const __m128 nz = _mm_set1_ps(planeNormal.getZ());
+	const __m128 eq = _mm_set1_ps(planeEq);
+	for (; i + 4 <= numVertices; i += 4)
+	{
+		__m128 x = _mm_load_ps(vertices[i].m_floats);
+		__m128 y = _mm_load_ps(vertices[i + 1].m_floats);
+		__m128 z = _mm_load_ps(vertices[i + 2].m_floats);
+		__m128 w = _mm_load_ps(vertices[i + 3].m_floats);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx), _mm_mul_ps(y, ny)), _mm_mul_ps(z, nz));
+		_mm_storeu_ps(distancesOut + i, _mm_add_ps(d, eq));
+	}
+#endif  //BT_CLIP_USE_SSE
+	for (; i < numVertices; i++)
+	{
+		distancesOut[i] = planeNormal.dot(vertices[i]) + planeEq;
+	}
+}
+
 // Clips a face to the back of a plane
 void btPolyhedralContactClipping::clipFace(const btVertexArray& pVtxIn, btVertexArray& ppVtxOut, const btVector3& planeNormalWS, btScalar planeEqWS)
 {
@@ -35,16 +70,45 @@ void btPolyhedralContactClipping::clipFace(const btVertexArray& pVtxIn, btVertex
 	if (numVerts < 2)
 		return;
 
+	//compute all distances up front, most planes leave the polygon unchanged or remove it completely
+	btScalar localDistances[BT_CLIP_MAX_LOCAL_VERTICES];
+	btAlignedObjectArray<btScalar> heapDistances;
+	btScalar* distances = localDistances;
+	if (numVerts > BT_CLIP_MAX_LOCAL_VERTICES)
+	{
+		heapDistances.resize(numVerts);
+		distances = &heapDistances[0];
+	}
+	btComputePlaneDistances(&pVtxIn[0], numVerts, planeNormalWS, planeEqWS, distances);
+
+	int numInside = 0;
+	for (ve = 0; ve < numVerts; ve++)
+	{
+		numInside += distances[ve] < 0 ? 1 : 0;
+	}
+	if (numInside == 0)
+	{
+		return;
+	}
+	if (numInside == numVerts)
+	{
+		for (ve = 0; ve < numVerts; ve++)
+		{
+			ppVtxOut.push_back(pVtxIn[ve]);
+		}
+		return;
+	}
+
 	btVector3 firstVertex = pVtxIn[pVtxIn.size() - 1];
 	btVector3 endVertex = pVtxIn[0];
 
-	ds = planeNormalWS.dot(firstVertex) + planeEqWS;
+	ds = distances[numVerts - 1];
 
 	for (ve = 0; ve < numVerts; ve++)
 	{
 		endVertex = pVtxIn[ve];
 
-		de = planeNormalWS.dot(endVertex) + planeEqWS;
+		de = distances[ve];
 
 		if (ds < 0)
 		{
@@ -73,6 +137,174 @@ void btPolyhedralContactClipping::clipFace(const btVertexArray& pVtxIn, btVertex
 	}
 }
 
+int btPolyhedralContactClipping::reduceContacts(btVertexArray& points, const btVector3& normal, int maxNumContacts)
+{
+	const int numPoints = points.size();
+	if (numPoints <= maxNumContacts)
+	{
+		return numPoints;
+	}
+	if (maxNumContacts <= 0)
+	{
+		return 0;
+	}
+
+	//the selected points are kept in front of the array, as a polygon ordered counter-clockwise around the normal
+	//first the deepest point
+	int deepest = 0;
+	for (int i = 1; i < numPoints; i++)
+	{
+		if (points[i].w() < points[deepest].w())
+		{
+			deepest = i;
+		}
+	}
+	points.swap(0, deepest);
+	if (maxNumContacts == 1)
+	{
+		return 1;
+	}
+
+	//then the point farthest away from it in the contact plane
+	int farthest = -1;
+	btScalar maxDist2 = SIMD_EPSILON;
+	for (int i = 1; i < numPoints; i++)
+	{
+		btVector3 diff = points[i] - points[0];
+		diff -= normal * normal.dot(diff);
+		btScalar dist2 = diff.length2();
+		if (dist2 > maxDist2)
+		{
+			maxDist2 = dist2;
+			farthest = i;
+		}
+	}
+	if (farthest < 0)
+	{
+		return 1;
+	}
+	points.swap(1, farthest);
+	if (maxNumContacts == 2)
+	{
+		return 2;
+	}
+
+	//then the point that spans the largest triangle with both, its side defines the winding
+	int third = -1;
+	btScalar maxArea = SIMD_EPSILON;
+	btScalar thirdSign = btScalar(1.);
+	const btVector3 edge01 = points[1] - points[0];
+	for (int i = 2; i < numPoints; i++)
+	{
+		btScalar area = edge01.cross(points[i] - points[0]).dot(normal);
+		if (btFabs(area) > maxArea)
+		{
+			maxArea = btFabs(area);
+			thirdSign = area;
+			third = i;
+		}
+	}
+	if (third < 0)
+	{
+		return 2;
+	}
+	points.swap(2, third);
+	if (thirdSign < btScalar(0.))
+	{
+		points.swap(1, 2);
+	}
+
+	//then repeatedly the point that adds the largest triangle outside of one of the polygon edges,
+	//it is inserted between the vertices of that edge
+	int numSelected = 3;
+	while (numSelected < maxNumContacts)
+	{
+		int bestPoint = -1;
+		int bestEdge = -1;
+		btScalar maxGain = SIMD_EPSILON;
+		for (int i = numSelected; i < numPoints; i++)
+		{
+			for (int e = 0; e < numSelected; e++)
+			{
+				const btVector3& a = points[e];
+				const btVector3& b = points[e + 1 < numSelected ? e + 1 : 0];
+				btScalar gain = (points[i] - a).cross(b - a).dot(normal);
+				if (gain > maxGain)
+				{
+					maxGain = gain;
+					bestPoint = i;
+					bestEdge = e;
+				}
+			}
+		}
+		if (bestPoint < 0)
+		{
+			break;
+		}
+		btVector3 point = points[bestPoint];
+		points[bestPoint] = points[numSelected];
+		for (int j = numSelected; j > bestEdge + 1; j--)
+		{
+			points[j] = points[j - 1];
+		}
+		points[bestEdge + 1] = point;
+		numSelected++;
+	}
+
+	//the greedy choice can miss a larger polygon, so finally move single vertices, except the deepest point, to the unselected
+	//point and polygon edge that grow the area the most, until no move grows it. Removing a vertex cuts off the triangle
+	//with its neighbors, inserting a point on an edge adds the triangle with the edge, like above
+	const int numReducedEdges = numSelected - 1;
+	for (int iteration = 0; iteration < numPoints * numSelected; iteration++)
+	{
+		int bestPoint = -1;
+		int bestVertex = -1;
+		int bestEdge = -1;
+		btScalar maxGain = SIMD_EPSILON;
+		for (int v = 1; v < numSelected; v++)
+		{
+			const btVector3& prev = points[v - 1];
+			const btVector3& next = points[v + 1 < numSelected ? v + 1 : 0];
+			const btScalar loss = (points[v] - prev).cross(next - prev).dot(normal);
+			for (int i = numSelected; i < numPoints; i++)
+			{
+				//the edges of the polygon without v, edge e starts at its e-th vertex
+				for (int e = 0; e < numReducedEdges; e++)
+				{
+					const int e1 = e + 1 < numReducedEdges ? e + 1 : 0;
+					const btVector3& a = points[e < v ? e : e + 1];
+					const btVector3& b = points[e1 < v ? e1 : e1 + 1];
+					btScalar gain = (points[i] - a).cross(b - a).dot(normal) - loss;
+					if (gain > maxGain)
+					{
+						maxGain = gain;
+						bestPoint = i;
+						bestVertex = v;
+						bestEdge = e;
+					}
+				}
+			}
+		}
+		if (bestPoint < 0)
+		{
+			break;
+		}
+		const btVector3 removed = points[bestVertex];
+		const btVector3 inserted = points[bestPoint];
+		for (int j = bestVertex; j < numReducedEdges; j++)
+		{
+			points[j] = points[j + 1];
+		}
+		for (int j = numReducedEdges; j > bestEdge + 1; j--)
+		{
+			points[j] = points[j - 1];
+		}
+		points[bestEdge + 1] = inserted;
+		points[bestPoint] = removed;
+	}
+	return numSelected;
+}
+
 static bool TestSepAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, const btVector3& sep_axis, btScalar& depth, btVector3& witnessPointA, btVector3& witnessPointB)
 {
 	btScalar Min0, Max0;
@@ -233,7 +465,51 @@ SIMD_FORCE_INLINE void btSegmentsClosestPoints(
 	ptsVector = translation - offsetA + offsetB;
 }
 
-bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut)
+static SIMD_FORCE_INLINE btVector3 btGetFaceNormal(const btConvexPolyhedron& hull, int face)
+{
+	const btFace& f = hull.m_faces[face];
+	return btVector3(f.m_plane[0], f.m_plane[1], f.m_plane[2]);
+}
+
+///true if the arcs a-b and c-d on the unit sphere intersect, with bCrossA = b x a and dCrossC = d x c
+static SIMD_FORCE_INLINE bool btIsMinkowskiFace(const btVector3& a, const btVector3& b, const btVector3& bCrossA, const btVector3& c, const btVector3& d, const btVector3& dCrossC)
+{
+	const btScalar cba = c.dot(bCrossA);
+	const btScalar dba = d.dot(bCrossA);
+	const btScalar adc = a.dot(dCrossC);
+	const btScalar bdc = b.dot(dCrossC);
+	return cba * dba < btScalar(0.) && adc * bdc < btScalar(0.) && cba * bdc > btScalar(0.);
+}
+
+///axis (pointing away from A) and signed distance of the hulls along the cross product of an edge of A and an edge of B
+///that form a face of the Minkowski difference, positive if the hulls are separated. Returns false for parallel edges.
+static bool btEdgePairDistance(const btVector3& pointA, const btVector3& edgeA, const btVector3& centerA, const btVector3& pointB, const btVector3& edgeB, btVector3& axis, btScalar& distance)
+{
+	axis = edgeA.cross(edgeB);
+	const btScalar length2 = axis.length2();
+	//the axis of near parallel edges is covered by the face normals
+	if (length2 < btScalar(1e-6) * edgeA.length2() * edgeB.length2())
+		return false;
+	axis /= btSqrt(length2);
+	if (axis.dot(pointA - centerA) < btScalar(0.))
+		axis = -axis;
+	distance = axis.dot(pointB - pointA);
+	return true;
+}
+
+static SIMD_FORCE_INLINE void btStoreSeparatingFeature(btSeparatingAxisCache* cache, const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, int featureType, int index0, int index1)
+{
+	if (cache)
+	{
+		cache->m_hullA = &hullA;
+		cache->m_hullB = &hullB;
+		cache->m_featureType = featureType;
+		cache->m_index0 = index0;
+		cache->m_index1 = index1;
+	}
+}
+
+bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut, btSeparatingAxisCache* cache)
 {
 	gActualSATPairTests++;
 
@@ -246,7 +522,94 @@ bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& h
 	btScalar dmin = FLT_MAX;
 	int curPlaneTests = 0;
 
+	btVector3 edgeAstart, edgeAend, edgeBstart, edgeBend;
+	int edgeA = -1;
+	int edgeB = -1;
+	btVector3 worldEdgeA;
+	btVector3 worldEdgeB;
+	btVector3 witnessPointA(0, 0, 0), witnessPointB(0, 0, 0);
+
+	//feature of the minimum penetration, it goes to the cache
+	int featureType = btSeparatingAxisCache::SAT_NO_FEATURE;
+	int featureIndex0 = -1;
+	int featureIndex1 = -1;
+
 	int numFacesA = hullA.m_faces.size();
+	int numFacesB = hullB.m_faces.size();
+	int numEdgesA = hullA.m_edges.size();
+	int numEdgesB = hullB.m_edges.size();
+	// a pair of edges costs a few dot products on the Gauss maps, a pair of unique edge directions costs projections of both hulls,
+	// so hulls with few edge directions (boxes, prisms) keep using the unique edges
+	const int numUniqueEdgePairs = hullA.m_uniqueEdges.size() * hullB.m_uniqueEdges.size();
+	const bool useGaussMaps = numEdgesA > 0 && numEdgesB > 0 &&
+							  numEdgesA * numEdgesB < numUniqueEdgePairs * (hullA.m_vertices.size() + hullB.m_vertices.size()) / 2;
+	const btTransform transBtoA = transA.inverseTimes(transB);
+
+	// Test the feature of the previous call first: it exits right away if the pair is still separated,
+	// and a small dmin lets the internal object test skip more of the remaining axes
+	if (cache && cache->m_hullA == &hullA && cache->m_hullB == &hullB)
+	{
+		const int index0 = cache->m_index0;
+		const int index1 = cache->m_index1;
+		btVector3 axis(0, 0, 0);
+		bool validAxis = false;
+		if (cache->m_featureType == btSeparatingAxisCache::SAT_FACE_A && index0 < numFacesA)
+		{
+			axis = transA.getBasis() * btGetFaceNormal(hullA, index0);
+			validAxis = true;
+		}
+		else if (cache->m_featureType == btSeparatingAxisCache::SAT_FACE_B && index0 < numFacesB)
+		{
+			axis = transB.getBasis() * btGetFaceNormal(hullB, index0);
+			validAxis = true;
+		}
+		if (validAxis)
+		{
+			if (DeltaC2.dot(axis) < 0)
+				axis *= -1.f;
+			btScalar d;
+			btVector3 wA, wB;
+			if (!TestSepAxis(hullA, hullB, transA, transB, axis, d, wA, wB))
+				return false;
+			dmin = d;
+			sep = axis;
+			featureType = cache->m_featureType;
+			featureIndex0 = index0;
+		}
+		else if (cache->m_featureType == btSeparatingAxisCache::SAT_EDGE_PAIR && useGaussMaps && index0 < numEdgesA && index1 < numEdgesB)
+		{
+			const btPolyhedronEdge& edgeDataA = hullA.m_edges[index0];
+			const btPolyhedronEdge& edgeDataB = hullB.m_edges[index1];
+			const btVector3& pointA = hullA.m_vertices[edgeDataA.m_vertex0];
+			const btVector3 edgeVecA = hullA.m_vertices[edgeDataA.m_vertex1] - pointA;
+			const btVector3 pointB = transBtoA * hullB.m_vertices[edgeDataB.m_vertex0];
+			const btVector3 edgeVecB = transBtoA.getBasis() * (hullB.m_vertices[edgeDataB.m_vertex1] - hullB.m_vertices[edgeDataB.m_vertex0]);
+			const btVector3 a = btGetFaceNormal(hullA, edgeDataA.m_face0);
+			const btVector3 b = btGetFaceNormal(hullA, edgeDataA.m_face1);
+			const btVector3 c = -(transBtoA.getBasis() * btGetFaceNormal(hullB, edgeDataB.m_face0));
+			const btVector3 d = -(transBtoA.getBasis() * btGetFaceNormal(hullB, edgeDataB.m_face1));
+			btScalar dist;
+			//the edge distance is only exact while the pair still forms a face of the Minkowski difference
+			if (btIsMinkowskiFace(a, b, b.cross(a), c, d, d.cross(c)) &&
+				btEdgePairDistance(pointA, edgeVecA, hullA.m_localCenter, pointB, edgeVecB, axis, dist))
+			{
+				if (dist > btScalar(0.))
+					return false;
+				dmin = -dist;
+				sep = transA.getBasis() * axis;
+				edgeA = index0;
+				edgeB = index1;
+				worldEdgeA = transA.getBasis() * edgeVecA.normalized();
+				worldEdgeB = transA.getBasis() * edgeVecB.normalized();
+				witnessPointA = transA * pointA;
+				witnessPointB = transA * pointB;
+				featureType = btSeparatingAxisCache::SAT_EDGE_PAIR;
+				featureIndex0 = index0;
+				featureIndex1 = index1;
+			}
+		}
+	}
+
 	// Test normals from hullA
 	for (int i = 0; i < numFacesA; i++)
 	{
@@ -266,16 +629,22 @@ bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& h
 		btScalar d;
 		btVector3 wA, wB;
 		if (!TestSepAxis(hullA, hullB, transA, transB, faceANormalWS, d, wA, wB))
+		{
+			btStoreSeparatingFeature(cache, hullA, hullB, btSeparatingAxisCache::SAT_FACE_A, i, -1);
 			return false;
+		}
 
 		if (d < dmin)
 		{
 			dmin = d;
 			sep = faceANormalWS;
+			edgeA = -1;
+			edgeB = -1;
+			featureType = btSeparatingAxisCache::SAT_FACE_A;
+			featureIndex0 = i;
 		}
 	}
 
-	int numFacesB = hullB.m_faces.size();
 	// Test normals from hullB
 	for (int i = 0; i < numFacesB; i++)
 	{
@@ -295,68 +664,132 @@ bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& h
 		btScalar d;
 		btVector3 wA, wB;
 		if (!TestSepAxis(hullA, hullB, transA, transB, WorldNormal, d, wA, wB))
+		{
+			btStoreSeparatingFeature(cache, hullA, hullB, btSeparatingAxisCache::SAT_FACE_B, i, -1);
 			return false;
+		}
 
 		if (d < dmin)
 		{
 			dmin = d;
 			sep = WorldNormal;
+			edgeA = -1;
+			edgeB = -1;
+			featureType = btSeparatingAxisCache::SAT_FACE_B;
+			featureIndex0 = i;
 		}
 	}
 
-	btVector3 edgeAstart, edgeAend, edgeBstart, edgeBend;
-	int edgeA = -1;
-	int edgeB = -1;
-	btVector3 worldEdgeA;
-	btVector3 worldEdgeB;
-	btVector3 witnessPointA(0, 0, 0), witnessPointB(0, 0, 0);
-
 	int curEdgeEdge = 0;
 	// Test edges
-	for (int e0 = 0; e0 < hullA.m_uniqueEdges.size(); e0++)
+	if (useGaussMaps)
 	{
-		const btVector3 edge0 = hullA.m_uniqueEdges[e0];
-		const btVector3 WorldEdge0 = transA.getBasis() * edge0;
-		for (int e1 = 0; e1 < hullB.m_uniqueEdges.size(); e1++)
+		// Only the edge pairs whose arcs intersect on the Gauss maps of A and -B form a face of the Minkowski difference,
+		// all other pairs are skipped. The remaining pairs are measured in the space of A from the edge vertices,
+		// without projecting the hulls.
+		const btMatrix3x3& rotBtoA = transBtoA.getBasis();
+		for (int e1 = 0; e1 < numEdgesB; e1++)
 		{
-			const btVector3 edge1 = hullB.m_uniqueEdges[e1];
-			const btVector3 WorldEdge1 = transB.getBasis() * edge1;
-
-			btVector3 Cross = WorldEdge0.cross(WorldEdge1);
-			curEdgeEdge++;
-			if (!IsAlmostZero(Cross))
+			const btPolyhedronEdge& edgeDataB = hullB.m_edges[e1];
+			const btVector3 c = -(rotBtoA * btGetFaceNormal(hullB, edgeDataB.m_face0));
+			const btVector3 d = -(rotBtoA * btGetFaceNormal(hullB, edgeDataB.m_face1));
+			const btVector3 dCrossC = d.cross(c);
+			const btVector3 pointB = transBtoA * hullB.m_vertices[edgeDataB.m_vertex0];
+			const btVector3 edgeVecB = rotBtoA * (hullB.m_vertices[edgeDataB.m_vertex1] - hullB.m_vertices[edgeDataB.m_vertex0]);
+
+			for (int e0 = 0; e0 < numEdgesA; e0++)
 			{
-				Cross = Cross.normalize();
-				if (DeltaC2.dot(Cross) < 0)
-					Cross *= -1.f;
-
-#ifdef TEST_INTERNAL_OBJECTS
-				gExpectedNbTests++;
-				if (gUseInternalObject && !TestInternalObjects(transA, transB, DeltaC2, Cross, hullA, hullB, dmin))
+				const btPolyhedronEdge& edgeDataA = hullA.m_edges[e0];
+				const btVector3 a = btGetFaceNormal(hullA, edgeDataA.m_face0);
+				const btVector3 b = btGetFaceNormal(hullA, edgeDataA.m_face1);
+				if (!btIsMinkowskiFace(a, b, b.cross(a), c, d, dCrossC))
 					continue;
-				gActualNbTests++;
-#endif
 
+				const btVector3& pointA = hullA.m_vertices[edgeDataA.m_vertex0];
+				const btVector3 edgeVecA = hullA.m_vertices[edgeDataA.m_vertex1] - pointA;
+				btVector3 axis;
 				btScalar dist;
-				btVector3 wA, wB;
-				if (!TestSepAxis(hullA, hullB, transA, transB, Cross, dist, wA, wB))
+				curEdgeEdge++;
+				if (!btEdgePairDistance(pointA, edgeVecA, hullA.m_localCenter, pointB, edgeVecB, axis, dist))
+					continue;
+
+				if (dist > btScalar(0.))
+				{
+					btStoreSeparatingFeature(cache, hullA, hullB, btSeparatingAxisCache::SAT_EDGE_PAIR, e0, e1);
 					return false;
+				}
 
-				if (dist < dmin)
+				if (-dist < dmin)
 				{
-					dmin = dist;
-					sep = Cross;
+					dmin = -dist;
+					sep = transA.getBasis() * axis;
 					edgeA = e0;
 					edgeB = e1;
-					worldEdgeA = WorldEdge0;
-					worldEdgeB = WorldEdge1;
-					witnessPointA = wA;
-					witnessPointB = wB;
+					worldEdgeA = transA.getBasis() * edgeVecA.normalized();
+					worldEdgeB = transA.getBasis() * edgeVecB.normalized();
+					witnessPointA = transA * pointA;
+					witnessPointB = transA * pointB;
+					featureType = btSeparatingAxisCache::SAT_EDGE_PAIR;
+					featureIndex0 = e0;
+					featureIndex1 = e1;
+				}
+			}
+		}
+	}
+	else
+	{
+		for (int e0 = 0; e0 < hullA.m_uniqueEdges.size(); e0++)
+		{
+			const btVector3 edge0 = hullA.m_uniqueEdges[e0];
+			const btVector3 WorldEdge0 = transA.getBasis() * edge0;
+			for (int e1 = 0; e1 < hullB.m_uniqueEdges.size(); e1++)
+			{
+				const btVector3 edge1 = hullB.m_uniqueEdges[e1];
+				const btVector3 WorldEdge1 = transB.getBasis() * edge1;
+
+				btVector3 Cross = WorldEdge0.cross(WorldEdge1);
+				curEdgeEdge++;
+				if (!IsAlmostZero(Cross))
+				{
+					Cross = Cross.normalize();
+					if (DeltaC2.dot(Cross) < 0)
+						Cross *= -1.f;
+
+#ifdef TEST_INTERNAL_OBJECTS
+					gExpectedNbTests++;
+					if (gUseInternalObject && !TestInternalObjects(transA, transB, DeltaC2, Cross, hullA, hullB, dmin))
+						continue;
+					gActualNbTests++;
+#endif
+
+					btScalar dist;
+					btVector3 wA, wB;
+					if (!TestSepAxis(hullA, hullB, transA, transB, Cross, dist, wA, wB))
+					{
+						btStoreSeparatingFeature(cache, hullA, hullB, btSeparatingAxisCache::SAT_NO_FEATURE, -1, -1);
+						return false;
+					}
+
+					if (dist < dmin)
+					{
+						dmin = dist;
+						sep = Cross;
+						edgeA = e0;
+						edgeB = e1;
+						worldEdgeA = WorldEdge0;
+						worldEdgeB = WorldEdge1;
+						witnessPointA = wA;
+						witnessPointB = wB;
+						//unique edges carry no vertices, the axis is not cached
+						featureType = btSeparatingAxisCache::SAT_NO_FEATURE;
+					}
 				}
 			}
 		}
 	}
 
+	btStoreSeparatingFeature(cache, hullA, hullB, featureType, featureIndex0, featureIndex1);
+
 	if (edgeA >= 0 && edgeB >= 0)
 	{
 		//		printf("edge-edge\n");
@@ -402,7 +835,7 @@ bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& h
 	return true;
 }
 
-void btPolyhedralContactClipping::clipFaceAgainstHull(const btVector3& separatingNormal, const btConvexPolyhedron& hullA, const btTransform& transA, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, const btScalar minDist, btScalar maxDist, btDiscreteCollisionDetectorInterface::Result& resultOut)
+void btPolyhedralContactClipping::clipFaceAgainstHull(const btVector3& separatingNormal, const btConvexPolyhedron& hullA, const btTransform& transA, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, const btScalar minDist, btScalar maxDist, btDiscreteCollisionDetectorInterface::Result& resultOut, int maxNumContacts)
 {
 	worldVertsB2.resize(0);
 	btVertexArray* pVtxIn = &worldVertsB1;
@@ -432,13 +865,13 @@ void btPolyhedralContactClipping::clipFaceAgainstHull(const btVector3& separatin
 
 	// clip polygon to back of planes of all faces of hull A that are adjacent to witness face
 	int numVerticesA = polyA.m_indices.size();
+	const btVector3 worldPlaneAnormal1 = transA.getBasis() * btVector3(polyA.m_plane[0], polyA.m_plane[1], polyA.m_plane[2]);
 	for (int e0 = 0; e0 < numVerticesA; e0++)
 	{
 		const btVector3& a = hullA.m_vertices[polyA.m_indices[e0]];
 		const btVector3& b = hullA.m_vertices[polyA.m_indices[(e0 + 1) % numVerticesA]];
 		const btVector3 edge0 = a - b;
 		const btVector3 WorldEdge0 = transA.getBasis() * edge0;
-		btVector3 worldPlaneAnormal1 = transA.getBasis() * btVector3(polyA.m_plane[0], polyA.m_plane[1], polyA.m_plane[2]);
 
 		btVector3 planeNormalWS1 = -WorldEdge0.cross(worldPlaneAnormal1);  //.cross(WorldEdge0);
 		btVector3 worldA1 = transA * a;
@@ -462,6 +895,8 @@ void btPolyhedralContactClipping::clipFaceAgainstHull(const btVector3& separatin
 		clipFace(*pVtxIn, *pVtxOut, planeNormalWS, planeEqWS);
 		btSwap(pVtxIn, pVtxOut);
 		pVtxOut->resize(0);
+		if (pVtxIn->size() == 0)
+			return;
 	}
 
 	//#define ONLY_REPORT_DEEPEST_POINT
@@ -497,11 +932,29 @@ void btPolyhedralContactClipping::clipFaceAgainstHull(const btVector3& separatin
 					printf("likely wrong separatingNormal passed in\n");
 				}
 #endif
-				resultOut.addContactPoint(separatingNormal, point, depth);
+				if (maxNumContacts > 0)
+				{
+					//collect the points and report the reduced set below, instead of letting the manifold replace points one by one
+					point.setW(depth);
+					pVtxOut->push_back(point);
+				}
+				else
+				{
+					resultOut.addContactPoint(separatingNormal, point, depth);
+				}
 #endif
 			}
 		}
 	}
+	if (maxNumContacts > 0)
+	{
+		int numContacts = reduceContacts(*pVtxOut, separatingNormal, maxNumContacts);
+		for (int i = 0; i < numContacts; i++)
+		{
+			const btVector3& contact = pVtxOut->at(i);
+			resultOut.addContactPoint(separatingNormal, btVector3(contact.getX(), contact.getY(), contact.getZ()), contact.w());
+		}
+	}
 #ifdef ONLY_REPORT_DEEPEST_POINT
 	if (curMaxDist < maxDist)
 	{
@@ -510,7 +963,7 @@ void btPolyhedralContactClipping::clipFaceAgainstHull(const btVector3& separatin
 #endif  //ONLY_REPORT_DEEPEST_POINT
 }
 
-void btPolyhedralContactClipping::clipHullAgainstHull(const btVector3& separatingNormal1, const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, const btScalar minDist, btScalar maxDist, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, btDiscreteCollisionDetectorInterface::Result& resultOut)
+void btPolyhedralContactClipping::clipHullAgainstHull(const btVector3& separatingNormal1, const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, const btScalar minDist, btScalar maxDist, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, btDiscreteCollisionDetectorInterface::Result& resultOut, int maxNumContacts)
 {
 	btVector3 separatingNormal = separatingNormal1.normalized();
 	//	const btVector3 c0 = transA * hullA.m_localCenter;
@@ -544,5 +997,5 @@ void btPolyhedralContactClipping::clipHullAgainstHull(const btVector3& separatin
 	}
 
 	if (closestFaceB >= 0)
-		clipFaceAgainstHull(separatingNormal, hullA, transA, worldVertsB1, worldVertsB2, minDist, maxDist, resultOut);
+		clipFaceAgainstHull(separatingNormal, hullA, transA, worldVertsB1, worldVertsB2, minDist, maxDist, resultOut, maxNumContacts);
 }
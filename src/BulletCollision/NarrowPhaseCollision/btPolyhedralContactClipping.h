@@ -26,17 +26,53 @@ class btConvexPolyhedron;
 
 typedef btAlignedObjectArray<btVector3> btVertexArray;
 
+///btSeparatingAxisCache remembers the feature that defined the previous result of findSeparatingAxis for a pair of hulls:
+///the separating face or edge pair, or the face or edge pair of minimum penetration.
+///The next call tests that axis first, so a pair that stays separated costs a single axis test.
+struct btSeparatingAxisCache
+{
+	enum btSeparatingFeatureType
+	{
+		SAT_NO_FEATURE,
+		SAT_FACE_A,
+		SAT_FACE_B,
+		SAT_EDGE_PAIR
+	};
+
+	const btConvexPolyhedron* m_hullA;
+	const btConvexPolyhedron* m_hullB;
+	int m_featureType;
+	int m_index0;  // face of A, face of B, or edge of A
+	int m_index1;  // edge of B
+
+	btSeparatingAxisCache()
+		: m_hullA(0),
+		  m_hullB(0),
+		  m_featureType(SAT_NO_FEATURE),
+		  m_index0(-1),
+		  m_index1(-1)
+	{
+	}
+};
+
 // Clips a face to the back of a plane
 struct btPolyhedralContactClipping
 {
-	static void clipHullAgainstHull(const btVector3& separatingNormal1, const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, const btScalar minDist, btScalar maxDist, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, btDiscreteCollisionDetectorInterface::Result& resultOut);
+	///when maxNumContacts is positive, at most maxNumContacts of the clipped points are reported, see reduceContacts
+	static void clipHullAgainstHull(const btVector3& separatingNormal1, const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, const btScalar minDist, btScalar maxDist, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, btDiscreteCollisionDetectorInterface::Result& resultOut, int maxNumContacts = 0);
 
-	static void clipFaceAgainstHull(const btVector3& separatingNormal, const btConvexPolyhedron& hullA, const btTransform& transA, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, const btScalar minDist, btScalar maxDist, btDiscreteCollisionDetectorInterface::Result& resultOut);
+	static void clipFaceAgainstHull(const btVector3& separatingNormal, const btConvexPolyhedron& hullA, const btTransform& transA, btVertexArray& worldVertsB1, btVertexArray& worldVertsB2, const btScalar minDist, btScalar maxDist, btDiscreteCollisionDetectorInterface::Result& resultOut, int maxNumContacts = 0);
 
-	static bool findSeparatingAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut);
+	///returns false if the hulls are separated. The optional cache has to be kept per pair of hulls, it is validated against the hull pointers.
+	///Edge pairs are pruned with the Gauss maps of the hulls when both have edge adjacency (btConvexPolyhedron::m_edges).
+	static bool findSeparatingAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut, btSeparatingAxisCache* cache = 0);
 
 	///the clipFace method is used internally
 	static void clipFace(const btVertexArray& pVtxIn, btVertexArray& ppVtxOut, const btVector3& planeNormalWS, btScalar planeEqWS);
+
+	///selects at most maxNumContacts contact points that span the largest area in the plane of the normal, and moves them to the front of points.
+	///The w component of each point holds its depth, the deepest point is always selected. Returns the number of selected points.
+	static int reduceContacts(btVertexArray& points, const btVector3& normal, int maxNumContacts);
 };
 
 #endif  // BT_POLYHEDRAL_CONTACT_CLIPPING_H
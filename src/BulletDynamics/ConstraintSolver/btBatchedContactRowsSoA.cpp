@@ -0,0 +1,562 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btBatchedContactRowsSoA.h"
+#include "btSequentialImpulseConstraintSolver.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+
+#include "LinearMath/btSoAReal.h"
+#include "LinearMath/btQuickprof.h"
+
+#include <string.h>  //for memset
+
+int btBatchedContactRowsSoA::s_minimumNumContacts = 64;
+
+///the components of a row, each stored as BT_SOA_WIDTH lanes in a block
+enum btContactRowComponent
+{
+	ROW_NORMAL1,  // x, y, z
+	ROW_RELPOS1_CROSS_NORMAL = ROW_NORMAL1 + 3,
+	ROW_NORMAL2 = ROW_RELPOS1_CROSS_NORMAL + 3,
+	ROW_RELPOS2_CROSS_NORMAL = ROW_NORMAL2 + 3,
+	ROW_LINEAR_COMPONENT_A = ROW_RELPOS2_CROSS_NORMAL + 3,  // m_contactNormal1 * inverse mass of body A
+	ROW_ANGULAR_COMPONENT_A = ROW_LINEAR_COMPONENT_A + 3,
+	ROW_LINEAR_COMPONENT_B = ROW_ANGULAR_COMPONENT_A + 3,
+	ROW_ANGULAR_COMPONENT_B = ROW_LINEAR_COMPONENT_B + 3,
+	ROW_JAC_DIAG_AB_INV = ROW_ANGULAR_COMPONENT_B + 3,
+	ROW_JAC_DIAG_AB,  // 1 / m_jacDiagABInv, 0 for idle lanes, to return the residuals
+	ROW_RHS,
+	ROW_CFM,
+	ROW_LOWER_LIMIT,
+	ROW_FRICTION,
+	ROW_RHS_PENETRATION,
+	ROW_APPLIED_IMPULSE,
+	ROW_APPLIED_PUSH_IMPULSE,
+	NUM_ROW_COMPONENTS
+};
+
+static const int kBlockSize = NUM_ROW_COMPONENTS * BT_SOA_WIDTH;
+
+static SIMD_FORCE_INLINE bool btIsDynamicSolverBody(const btSolverBody& body)
+{
+	return body.m_originalBody && !body.m_originalBody->isStaticOrKinematicObject();
+}
+
+static SIMD_FORCE_INLINE btSoAReal btLoadLanes(const btScalar* block, int component)
+{
+	return btSoAReal::load(block + component * BT_SOA_WIDTH);
+}
+
+static SIMD_FORCE_INLINE void btStoreLanes(btScalar* block, int component, const btSoAReal& v)
+{
+	v.store(block + component * BT_SOA_WIDTH);
+}
+
+static SIMD_FORCE_INLINE btSoAReal btDotLanes(const btScalar* block, int component, const btSoAReal* v)
+{
+	return btLoadLanes(block, component) * v[0] + btLoadLanes(block, component + 1) * v[1] + btLoadLanes(block, component + 2) * v[2];
+}
+
+static SIMD_FORCE_INLINE void btAddScaledLanes(btSoAReal* v, const btScalar* block, int component, const btSoAReal& s)
+{
+	v[0] = v[0] + btLoadLanes(block, component) * s;
+	v[1] = v[1] + btLoadLanes(block, component + 1) * s;
+	v[2] = v[2] + btLoadLanes(block, component + 2) * s;
+}
+
+///loads a btVector3 member of the bodies of the lanes into x, y and z lanes, zero for lanes without a dynamic body
+static SIMD_FORCE_INLINE void btGatherLanes(btSoAReal* xyz, const btSolverBody* bodies, const int* bodyIds, btVector3 btSolverBody::*member)
+{
+#if BT_SOA_WIDTH == 8
+	__m128 r[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		r[i] = bodyIds[i] >= 0 ? _mm_loadu_ps((bodies[bodyIds[i]].*member).m_floats) : _mm_setzero_ps();
+	}
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	_MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+	for (int k = 0; k < 3; ++k)
+	{
+		xyz[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(r[k]), r[4 + k], 1);
+	}
+#elif BT_SOA_WIDTH == 4
+	__m128 r[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		r[i] = bodyIds[i] >= 0 ? _mm_loadu_ps((bodies[bodyIds[i]].*member).m_floats) : _mm_setzero_ps();
+	}
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	for (int k = 0; k < 3; ++k)
+	{
+		xyz[k] = r[k];
+	}
+#else
+	for (int k = 0; k < 3; ++k)
+	{
+		xyz[k] = btSoAReal(bodyIds[0] >= 0 ? (bodies[bodyIds[0]].*member)[k] : btScalar(0));
+	}
+#endif
+}
+
+///stores x, y and z lanes to a btVector3 member of the dynamic bodies of the lanes
+static SIMD_FORCE_INLINE void btScatterLanes(btSolverBody* bodies, const int* bodyIds, btVector3 btSolverBody::*member, const btSoAReal* xyz)
+{
+#if BT_SOA_WIDTH == 8
+	__m128 r[8];
+	for (int k = 0; k < 3; ++k)
+	{
+		r[k] = _mm256_castps256_ps128(xyz[k].m_v);
+		r[4 + k] = _mm256_extractf128_ps(xyz[k].m_v, 1);
+	}
+	r[3] = r[7] = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	_MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+	for (int i = 0; i < 8; ++i)
+	{
+		if (bodyIds[i] >= 0)
+		{
+			_mm_storeu_ps((bodies[bodyIds[i]].*member).m_floats, r[i]);
+		}
+	}
+#elif BT_SOA_WIDTH == 4
+	__m128 r[4] = {xyz[0].m_v, xyz[1].m_v, xyz[2].m_v, _mm_setzero_ps()};
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	for (int i = 0; i < 4; ++i)
+	{
+		if (bodyIds[i] >= 0)
+		{
+			_mm_storeu_ps((bodies[bodyIds[i]].*member).m_floats, r[i]);
+		}
+	}
+#else
+	if (bodyIds[0] >= 0)
+	{
+		(bodies[bodyIds[0]].*member).setValue(xyz[0].m_v, xyz[1].m_v, xyz[2].m_v);
+	}
+#endif
+}
+
+///solves the row of each lane like gResolveSingleConstraintRowGeneric_sse2 and returns the residuals.
+///With hasUpperLimit the impulses are clamped to upperLimit too, with hasMask lanes with mask <= 0 keep their applied impulse.
+template <bool hasUpperLimit, bool hasMask>
+static SIMD_FORCE_INLINE btSoAReal btResolveRowLanes(const btScalar* block, btSoAReal* linearA, btSoAReal* angularA, btSoAReal* linearB, btSoAReal* angularB,
+													 const btSoAReal& rhs, btSoAReal& appliedImpulse, const btSoAReal& lowerLimit, const btSoAReal& upperLimit, const btSoAReal& mask)
+{
+	const btSoAReal jacDiagABInv = btLoadLanes(block, ROW_JAC_DIAG_AB_INV);
+	btSoAReal deltaImpulse = rhs - appliedImpulse * btLoadLanes(block, ROW_CFM);
+	const btSoAReal deltaVel1Dotn = btDotLanes(block, ROW_NORMAL1, linearA) + btDotLanes(block, ROW_RELPOS1_CROSS_NORMAL, angularA);
+	const btSoAReal deltaVel2Dotn = btDotLanes(block, ROW_NORMAL2, linearB) + btDotLanes(block, ROW_RELPOS2_CROSS_NORMAL, angularB);
+	deltaImpulse = deltaImpulse - deltaVel1Dotn * jacDiagABInv;
+	deltaImpulse = deltaImpulse - deltaVel2Dotn * jacDiagABInv;
+	btSoAReal sum = btSoAMax(appliedImpulse + deltaImpulse, lowerLimit);
+	if (hasUpperLimit)
+	{
+		sum = btSoAMin(sum, upperLimit);
+	}
+	if (hasMask)
+	{
+		sum = btSoASelectGreater(mask, btSoAReal(btScalar(0)), sum, appliedImpulse);
+	}
+	deltaImpulse = sum - appliedImpulse;
+	appliedImpulse = sum;
+	btAddScaledLanes(linearA, block, ROW_LINEAR_COMPONENT_A, deltaImpulse);
+	btAddScaledLanes(angularA, block, ROW_ANGULAR_COMPONENT_A, deltaImpulse);
+	btAddScaledLanes(linearB, block, ROW_LINEAR_COMPONENT_B, deltaImpulse);
+	btAddScaledLanes(angularB, block, ROW_ANGULAR_COMPONENT_B, deltaImpulse);
+	return deltaImpulse * btLoadLanes(block, ROW_JAC_DIAG_AB);
+}
+
+static void btFillRowLane(btScalar* block, int lane, const btSolverConstraint& c, const btSolverBody& bodyA, const btSolverBody& bodyB)
+{
+	const btVector3 linearComponentA = c.m_contactNormal1 * bodyA.internalGetInvMass();
+	const btVector3 linearComponentB = c.m_contactNormal2 * bodyB.internalGetInvMass();
+	for (int k = 0; k < 3; ++k)
+	{
+		block[(ROW_NORMAL1 + k) * BT_SOA_WIDTH + lane] = c.m_contactNormal1[k];
+		block[(ROW_RELPOS1_CROSS_NORMAL + k) * BT_SOA_WIDTH + lane] = c.m_relpos1CrossNormal[k];
+		block[(ROW_NORMAL2 + k) * BT_SOA_WIDTH + lane] = c.m_contactNormal2[k];
+		block[(ROW_RELPOS2_CROSS_NORMAL + k) * BT_SOA_WIDTH + lane] = c.m_relpos2CrossNormal[k];
+		block[(ROW_LINEAR_COMPONENT_A + k) * BT_SOA_WIDTH + lane] = linearComponentA[k];
+		block[(ROW_ANGULAR_COMPONENT_A + k) * BT_SOA_WIDTH + lane] = c.m_angularComponentA[k];
+		block[(ROW_LINEAR_COMPONENT_B + k) * BT_SOA_WIDTH + lane] = linearComponentB[k];
+		block[(ROW_ANGULAR_COMPONENT_B + k) * BT_SOA_WIDTH + lane] = c.m_angularComponentB[k];
+	}
+	block[ROW_JAC_DIAG_AB_INV * BT_SOA_WIDTH + lane] = c.m_jacDiagABInv;
+	block[ROW_JAC_DIAG_AB * BT_SOA_WIDTH + lane] = c.m_jacDiagABInv != btScalar(0) ? btScalar(1) / c.m_jacDiagABInv : btScalar(0);
+	block[ROW_RHS * BT_SOA_WIDTH + lane] = c.m_rhs;
+	block[ROW_CFM * BT_SOA_WIDTH + lane] = c.m_cfm;
+	block[ROW_LOWER_LIMIT * BT_SOA_WIDTH + lane] = c.m_lowerLimit;
+	block[ROW_FRICTION * BT_SOA_WIDTH + lane] = c.m_friction;
+	block[ROW_RHS_PENETRATION * BT_SOA_WIDTH + lane] = c.m_rhsPenetration;
+	block[ROW_APPLIED_IMPULSE * BT_SOA_WIDTH + lane] = c.m_appliedImpulse;
+	block[ROW_APPLIED_PUSH_IMPULSE * BT_SOA_WIDTH + lane] = c.m_appliedPushImpulse;
+}
+
+///sorts the batches of a phase by decreasing length, so that the batches of a group have similar lengths
+struct btBatchLengthSortPredicate
+{
+	const btBatchedConstraints* m_batchedContacts;
+
+	btBatchLengthSortPredicate(const btBatchedConstraints* batchedContacts) : m_batchedContacts(batchedContacts) {}
+
+	bool operator()(int a, int b) const
+	{
+		const btBatchedConstraints::Range& batchA = m_batchedContacts->m_batches[a];
+		const btBatchedConstraints::Range& batchB = m_batchedContacts->m_batches[b];
+		int lengthA = batchA.end - batchA.begin;
+		int lengthB = batchB.end - batchB.begin;
+		return (lengthA != lengthB) ? (lengthA > lengthB) : (a < b);
+	}
+};
+
+btBatchedContactRowsSoA::btBatchedContactRowsSoA()
+{
+	m_batchedContacts = NULL;
+	m_numFrictionDirections = 1;
+	m_writeContactImpulses = false;
+}
+
+int btBatchedContactRowsSoA::getNumLanes()
+{
+	return BT_SOA_WIDTH;
+}
+
+const btBatchedConstraints& btBatchedContactRowsSoA::setupColoredBatches(const btConstraintArray& contacts, const btAlignedObjectArray<btSolverBody>& bodies)
+{
+	BT_PROFILE("setupColoredBatches");
+	const int numContacts = contacts.size();
+	const int numBodies = bodies.size();
+	m_bodyColors.resizeNoInitialize(numBodies);
+	if (numBodies)
+	{
+		memset(&m_bodyColors[0], 0, sizeof(unsigned int) * numBodies);
+	}
+	m_rowColors.resizeNoInitialize(numContacts);
+	m_colorOffsets.resizeNoInitialize(MAX_COLORS + 2);
+	for (int i = 0; i < m_colorOffsets.size(); ++i)
+	{
+		m_colorOffsets[i] = 0;
+	}
+	// each row takes the lowest color that is free for both of its dynamic bodies
+	for (int i = 0; i < numContacts; ++i)
+	{
+		const btSolverConstraint& c = contacts[i];
+		const bool dynamicA = btIsDynamicSolverBody(bodies[c.m_solverBodyIdA]);
+		const bool dynamicB = btIsDynamicSolverBody(bodies[c.m_solverBodyIdB]);
+		const unsigned int usedColors = (dynamicA ? m_bodyColors[c.m_solverBodyIdA] : 0) | (dynamicB ? m_bodyColors[c.m_solverBodyIdB] : 0);
+		int color = MAX_COLORS;
+		if (usedColors != 0xffffffff)
+		{
+			color = 0;
+			while (usedColors & (1u << color))
+			{
+				++color;
+			}
+			if (dynamicA)
+			{
+				m_bodyColors[c.m_solverBodyIdA] |= 1u << color;
+			}
+			if (dynamicB)
+			{
+				m_bodyColors[c.m_solverBodyIdB] |= 1u << color;
+			}
+		}
+		m_rowColors[i] = color;
+		m_colorOffsets[color + 1]++;
+	}
+	for (int color = 0; color <= MAX_COLORS; ++color)
+	{
+		m_colorOffsets[color + 1] += m_colorOffsets[color];
+	}
+
+	btBatchedConstraints& bc = m_coloredBatches;
+	bc.m_constraintIndices.resizeNoInitialize(numContacts);
+	bc.m_batches.resizeNoInitialize(0);
+	bc.m_phases.resizeNoInitialize(0);
+	bc.m_phaseGrainSize.resizeNoInitialize(0);
+	bc.m_phaseOrder.resizeNoInitialize(0);
+	for (int i = 0; i < numContacts; ++i)
+	{
+		bc.m_constraintIndices[m_colorOffsets[m_rowColors[i]]++] = i;
+	}
+	// each color becomes a phase of up to BT_SOA_WIDTH batches of consecutive rows, the uncolored rows a phase of a single batch
+	int begin = 0;
+	for (int color = 0; color <= MAX_COLORS; ++color)
+	{
+		const int end = m_colorOffsets[color];
+		const int numRows = end - begin;
+		if (numRows)
+		{
+			const int numBatches = (color == MAX_COLORS) ? 1 : btMin(numRows, int(BT_SOA_WIDTH));
+			const int firstBatch = bc.m_batches.size();
+			for (int iBatch = 0; iBatch < numBatches; ++iBatch)
+			{
+				bc.m_batches.push_back(btBatchedConstraints::Range(begin + numRows * iBatch / numBatches, begin + numRows * (iBatch + 1) / numBatches));
+			}
+			bc.m_phaseOrder.push_back(bc.m_phases.size());
+			bc.m_phases.push_back(btBatchedConstraints::Range(firstBatch, firstBatch + numBatches));
+			bc.m_phaseGrainSize.push_back(1);
+		}
+		begin = end;
+	}
+	return bc;
+}
+
+void btBatchedContactRowsSoA::setupGroups(const btBatchedConstraints& batchedContacts, int numFrictionDirections, bool writeContactImpulses)
+{
+	BT_PROFILE("btBatchedContactRowsSoA::setupGroups");
+	clear();
+	m_batchedContacts = &batchedContacts;
+	m_numFrictionDirections = numFrictionDirections;
+	m_writeContactImpulses = writeContactImpulses;
+	const int numPhases = batchedContacts.m_phases.size();
+	m_phaseGroups.resize(numPhases);
+	m_sortedBatches.resizeNoInitialize(0);
+	int numBlocks = 0;
+	for (int iPhase = 0; iPhase < numPhases; ++iPhase)
+	{
+		const btBatchedConstraints::Range& phase = batchedContacts.m_phases[iPhase];
+		const int firstBatch = m_sortedBatches.size();
+		for (int iBatch = phase.begin; iBatch < phase.end; ++iBatch)
+		{
+			m_sortedBatches.push_back(iBatch);
+		}
+		if (m_sortedBatches.size() - firstBatch > 1)
+		{
+			m_sortedBatches.quickSortInternal(btBatchLengthSortPredicate(&batchedContacts), firstBatch, m_sortedBatches.size() - 1);
+		}
+		m_phaseGroups[iPhase].begin = m_groups.size();
+		for (int i = firstBatch; i < m_sortedBatches.size(); i += BT_SOA_WIDTH)
+		{
+			const btBatchedConstraints::Range& longestBatch = batchedContacts.m_batches[m_sortedBatches[i]];
+			Group group;
+			group.m_firstBlock = numBlocks;
+			group.m_numBlocks = longestBatch.end - longestBatch.begin;
+			group.m_firstBatch = i;
+			group.m_numLanes = btMin(m_sortedBatches.size() - i, int(BT_SOA_WIDTH));
+			if (group.m_numBlocks)
+			{
+				m_groups.push_back(group);
+				numBlocks += group.m_numBlocks;
+			}
+		}
+		m_phaseGroups[iPhase].end = m_groups.size();
+	}
+	m_contactBlocks.resizeNoInitialize(numBlocks * kBlockSize);
+	m_frictionBlocks.resizeNoInitialize(numBlocks * numFrictionDirections * kBlockSize);
+	m_contactRows.resizeNoInitialize(numBlocks * BT_SOA_WIDTH);
+	m_blockBodies.resizeNoInitialize(numBlocks * 2 * BT_SOA_WIDTH);
+	m_blockOrder.resizeNoInitialize(numBlocks);
+}
+
+void btBatchedContactRowsSoA::fillGroups(int iBeginGroup, int iEndGroup, const btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& contacts, const btConstraintArray& frictions)
+{
+	BT_PROFILE("btBatchedContactRowsSoA::fillGroups");
+	const btBatchedConstraints& bc = *m_batchedContacts;
+	for (int iGroup = iBeginGroup; iGroup < iEndGroup; ++iGroup)
+	{
+		const Group& group = m_groups[iGroup];
+		for (int i = 0; i < group.m_numBlocks; ++i)
+		{
+			const int iBlock = group.m_firstBlock + i;
+			m_blockOrder[iBlock] = iBlock;
+			btScalar* block = &m_contactBlocks[iBlock * kBlockSize];
+			btScalar* frictionBlocks = &m_frictionBlocks[iBlock * m_numFrictionDirections * kBlockSize];
+			memset(block, 0, sizeof(btScalar) * kBlockSize);
+			memset(frictionBlocks, 0, sizeof(btScalar) * kBlockSize * m_numFrictionDirections);
+			int* rows = &m_contactRows[iBlock * BT_SOA_WIDTH];
+			int* bodyIds = &m_blockBodies[iBlock * 2 * BT_SOA_WIDTH];
+			for (int lane = 0; lane < BT_SOA_WIDTH; ++lane)
+			{
+				rows[lane] = -1;
+				bodyIds[lane] = -1;
+				bodyIds[BT_SOA_WIDTH + lane] = -1;
+				if (lane >= group.m_numLanes)
+				{
+					continue;
+				}
+				const btBatchedConstraints::Range& batch = bc.m_batches[m_sortedBatches[group.m_firstBatch + lane]];
+				if (batch.begin + i >= batch.end)
+				{
+					continue;
+				}
+				const int iRow = bc.m_constraintIndices[batch.begin + i];
+				const btSolverConstraint& c = contacts[iRow];
+				const btSolverBody& bodyA = bodies[c.m_solverBodyIdA];
+				const btSolverBody& bodyB = bodies[c.m_solverBodyIdB];
+				rows[lane] = iRow;
+				bodyIds[lane] = btIsDynamicSolverBody(bodyA) ? c.m_solverBodyIdA : -1;
+				bodyIds[BT_SOA_WIDTH + lane] = btIsDynamicSolverBody(bodyB) ? c.m_solverBodyIdB : -1;
+				btFillRowLane(block, lane, c, bodyA, bodyB);
+				for (int iDir = 0; iDir < m_numFrictionDirections; ++iDir)
+				{
+					btFillRowLane(frictionBlocks + iDir * kBlockSize, lane, frictions[c.m_frictionIndex + iDir], bodyA, bodyB);
+				}
+			}
+		}
+	}
+}
+
+void btBatchedContactRowsSoA::setup(const btBatchedConstraints& batchedContacts, const btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& contacts, const btConstraintArray& frictions, int numFrictionDirections, bool writeContactImpulses)
+{
+	setupGroups(batchedContacts, numFrictionDirections, writeContactImpulses);
+	fillGroups(0, m_groups.size(), bodies, contacts, frictions);
+}
+
+void btBatchedContactRowsSoA::clear()
+{
+	m_contactBlocks.resizeNoInitialize(0);
+	m_frictionBlocks.resizeNoInitialize(0);
+	m_contactRows.resizeNoInitialize(0);
+	m_blockBodies.resizeNoInitialize(0);
+	m_blockOrder.resizeNoInitialize(0);
+	m_groups.resizeNoInitialize(0);
+	m_phaseGroups.resizeNoInitialize(0);
+	m_batchedContacts = NULL;
+}
+
+void btBatchedContactRowsSoA::randomizeRowOrder(btSequentialImpulseConstraintSolver* solver)
+{
+	for (int iGroup = 0; iGroup < m_groups.size(); ++iGroup)
+	{
+		const Group& group = m_groups[iGroup];
+		int* blockOrder = &m_blockOrder[group.m_firstBlock];
+		for (int i = group.m_numBlocks - 1; i > 0; --i)
+		{
+			int j = solver->btRandInt2(i + 1);
+			btSwap(blockOrder[i], blockOrder[j]);
+		}
+	}
+}
+
+template <btBatchedContactRowsSoA::RowPass pass, bool useMaxResidual>
+btScalar btBatchedContactRowsSoA::solveGroupInternal(int iGroup, btSolverBody* bodies, btSolverConstraint* contacts)
+{
+	const Group& group = m_groups[iGroup];
+	const btSoAReal zero(btScalar(0));
+	btSoAReal residual = zero;
+	btVector3 btSolverBody::*linearMember = (pass == PASS_SPLIT_PENETRATION) ? &btSolverBody::m_pushVelocity : &btSolverBody::m_deltaLinearVelocity;
+	btVector3 btSolverBody::*angularMember = (pass == PASS_SPLIT_PENETRATION) ? &btSolverBody::m_turnVelocity : &btSolverBody::m_deltaAngularVelocity;
+	for (int i = 0; i < group.m_numBlocks; ++i)
+	{
+		const int iBlock = m_blockOrder[group.m_firstBlock + i];
+		btScalar* block = &m_contactBlocks[iBlock * kBlockSize];
+		const int* bodyIdsA = &m_blockBodies[iBlock * 2 * BT_SOA_WIDTH];
+		const int* bodyIdsB = bodyIdsA + BT_SOA_WIDTH;
+		btSoAReal linearA[3], angularA[3], linearB[3], angularB[3];
+		btGatherLanes(linearA, bodies, bodyIdsA, linearMember);
+		btGatherLanes(angularA, bodies, bodyIdsA, angularMember);
+		btGatherLanes(linearB, bodies, bodyIdsB, linearMember);
+		btGatherLanes(angularB, bodies, bodyIdsB, angularMember);
+		btSoAReal rowResidual;
+		if (pass == PASS_CONTACTS || pass == PASS_CONTACTS_AND_FRICTION)
+		{
+			btSoAReal appliedImpulse = btLoadLanes(block, ROW_APPLIED_IMPULSE);
+			rowResidual = btResolveRowLanes<false, false>(block, linearA, angularA, linearB, angularB, btLoadLanes(block, ROW_RHS), appliedImpulse, btLoadLanes(block, ROW_LOWER_LIMIT), zero, zero);
+			btStoreLanes(block, ROW_APPLIED_IMPULSE, appliedImpulse);
+			residual = useMaxResidual ? btSoAMax(residual, rowResidual * rowResidual) : residual + rowResidual * rowResidual;
+			if (m_writeContactImpulses)
+			{
+				const int* rows = &m_contactRows[iBlock * BT_SOA_WIDTH];
+				for (int lane = 0; lane < BT_SOA_WIDTH; ++lane)
+				{
+					if (rows[lane] >= 0)
+					{
+						contacts[rows[lane]].m_appliedImpulse = block[ROW_APPLIED_IMPULSE * BT_SOA_WIDTH + lane];
+					}
+				}
+			}
+		}
+		if (pass == PASS_FRICTION || pass == PASS_CONTACTS_AND_FRICTION)
+		{
+			const btSoAReal totalImpulse = btLoadLanes(block, ROW_APPLIED_IMPULSE);
+			for (int iDir = 0; iDir < m_numFrictionDirections; ++iDir)
+			{
+				btScalar* frictionBlock = &m_frictionBlocks[(iBlock * m_numFrictionDirections + iDir) * kBlockSize];
+				const btSoAReal upperLimit = btLoadLanes(frictionBlock, ROW_FRICTION) * totalImpulse;
+				btSoAReal appliedImpulse = btLoadLanes(frictionBlock, ROW_APPLIED_IMPULSE);
+				rowResidual = btResolveRowLanes<true, true>(frictionBlock, linearA, angularA, linearB, angularB, btLoadLanes(frictionBlock, ROW_RHS), appliedImpulse, zero - upperLimit, upperLimit, totalImpulse);
+				btStoreLanes(frictionBlock, ROW_APPLIED_IMPULSE, appliedImpulse);
+				residual = useMaxResidual ? btSoAMax(residual, rowResidual * rowResidual) : residual + rowResidual * rowResidual;
+			}
+		}
+		if (pass == PASS_SPLIT_PENETRATION)
+		{
+			const btSoAReal rhsPenetration = btLoadLanes(block, ROW_RHS_PENETRATION);
+			btSoAReal appliedPushImpulse = btLoadLanes(block, ROW_APPLIED_PUSH_IMPULSE);
+			rowResidual = btResolveRowLanes<false, true>(block, linearA, angularA, linearB, angularB, rhsPenetration, appliedPushImpulse, btLoadLanes(block, ROW_LOWER_LIMIT), zero, btSoAMax(rhsPenetration, zero - rhsPenetration));
+			btStoreLanes(block, ROW_APPLIED_PUSH_IMPULSE, appliedPushImpulse);
+			residual = useMaxResidual ? btSoAMax(residual, rowResidual * rowResidual) : residual + rowResidual * rowResidual;
+		}
+		btScatterLanes(bodies, bodyIdsA, linearMember, linearA);
+		btScatterLanes(bodies, bodyIdsA, angularMember, angularA);
+		btScatterLanes(bodies, bodyIdsB, linearMember, linearB);
+		btScatterLanes(bodies, bodyIdsB, angularMember, angularB);
+	}
+	btScalar lanes[BT_SOA_WIDTH];
+	residual.store(lanes);
+	btScalar leastSquaresResidual = 0;
+	for (int lane = 0; lane < BT_SOA_WIDTH; ++lane)
+	{
+		leastSquaresResidual = useMaxResidual ? btMax(leastSquaresResidual, lanes[lane]) : leastSquaresResidual + lanes[lane];
+	}
+	return leastSquaresResidual;
+}
+
+btScalar btBatchedContactRowsSoA::solveGroup(int iGroup, RowPass pass, bool useMaxResidual, btAlignedObjectArray<btSolverBody>& bodies, btConstraintArray& contacts)
+{
+	btSolverBody* solverBodies = &bodies[0];
+	btSolverConstraint* contactRows = &contacts[0];
+	switch (pass)
+	{
+		case PASS_CONTACTS:
+			return useMaxResidual ? solveGroupInternal<PASS_CONTACTS, true>(iGroup, solverBodies, contactRows) : solveGroupInternal<PASS_CONTACTS, false>(iGroup, solverBodies, contactRows);
+		case PASS_FRICTION:
+			return useMaxResidual ? solveGroupInternal<PASS_FRICTION, true>(iGroup, solverBodies, contactRows) : solveGroupInternal<PASS_FRICTION, false>(iGroup, solverBodies, contactRows);
+		case PASS_CONTACTS_AND_FRICTION:
+			return useMaxResidual ? solveGroupInternal<PASS_CONTACTS_AND_FRICTION, true>(iGroup, solverBodies, contactRows) : solveGroupInternal<PASS_CONTACTS_AND_FRICTION, false>(iGroup, solverBodies, contactRows);
+		case PASS_SPLIT_PENETRATION:
+			return useMaxResidual ? solveGroupInternal<PASS_SPLIT_PENETRATION, true>(iGroup, solverBodies, contactRows) : solveGroupInternal<PASS_SPLIT_PENETRATION, false>(iGroup, solverBodies, contactRows);
+	}
+	return btScalar(0);
+}
+
+void btBatchedContactRowsSoA::writeAppliedImpulses(int iBeginGroup, int iEndGroup, btConstraintArray& contacts, btConstraintArray& frictions) const
+{
+	for (int iGroup = iBeginGroup; iGroup < iEndGroup; ++iGroup)
+	{
+		const Group& group = m_groups[iGroup];
+		for (int iBlock = group.m_firstBlock; iBlock < group.m_firstBlock + group.m_numBlocks; ++iBlock)
+		{
+			const btScalar* block = &m_contactBlocks[iBlock * kBlockSize];
+			const int* rows = &m_contactRows[iBlock * BT_SOA_WIDTH];
+			for (int lane = 0; lane < BT_SOA_WIDTH; ++lane)
+			{
+				if (rows[lane] < 0)
+				{
+					continue;
+				}
+				btSolverConstraint& c = contacts[rows[lane]];
+				c.m_appliedImpulse = block[ROW_APPLIED_IMPULSE * BT_SOA_WIDTH + lane];
+				c.m_appliedPushImpulse = block[ROW_APPLIED_PUSH_IMPULSE * BT_SOA_WIDTH + lane];
+				for (int iDir = 0; iDir < m_numFrictionDirections; ++iDir)
+				{
+					const btScalar* frictionBlock = &m_frictionBlocks[(iBlock * m_numFrictionDirections + iDir) * kBlockSize];
+					frictions[c.m_frictionIndex + iDir].m_appliedImpulse = frictionBlock[ROW_APPLIED_IMPULSE * BT_SOA_WIDTH + lane];
+				}
+			}
+		}
+	}
+}
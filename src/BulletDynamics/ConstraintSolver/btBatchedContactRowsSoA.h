@@ -0,0 +1,135 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_BATCHED_CONTACT_ROWS_SOA_H
+#define BT_BATCHED_CONTACT_ROWS_SOA_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "BulletDynamics/ConstraintSolver/btBatchedConstraints.h"
+
+class btSequentialImpulseConstraintSolver;
+
+///
+/// btBatchedContactRowsSoA -- solves the contact and contact friction rows of btSequentialImpulseConstraintSolver and
+///                            btSequentialImpulseConstraintSolverMt one row per SIMD lane, see SOLVER_SIMD_BATCHED_CONTACTS.
+///
+///  The batches of a phase of btBatchedConstraints share no dynamic bodies, so rows of different batches of a phase can be
+///  solved at the same time (the rows of one batch usually share bodies). Each group of up to getNumLanes() batches of a phase
+///  becomes a sequence of row blocks, where block i holds the i-th row of each batch of the group. The batches of a phase are
+///  grouped by length, so few lanes idle.
+///  The constant data of the rows is transposed into the blocks once per solve. The iterations only gather the velocities
+///  of the bodies of a block, solve all lanes at once and scatter the velocity deltas back. The applied impulses stay in the
+///  blocks until writeAppliedImpulses, unless the contact impulses are needed by rows solved one at a time (rolling friction).
+///
+///  The kernels use 8 lanes when compiled with AVX, 4 lanes with SSE and plain scalar code otherwise (or with double precision),
+///  see btSoAReal. The solvers ignore SOLVER_SIMD_BATCHED_CONTACTS when there is a single lane.
+///  Each row is solved like the SOLVER_SIMD row functions of btSequentialImpulseConstraintSolver, but the rows are visited in
+///  the order of the blocks instead of the order of the contact pool. That is a different Gauss-Seidel sweep, so the impulses
+///  of an iteration differ from the per-row solver; they converge to the same solution, not to the same rounding.
+///
+class btBatchedContactRowsSoA
+{
+public:
+	enum RowPass
+	{
+		PASS_CONTACTS,
+		PASS_FRICTION,
+		PASS_CONTACTS_AND_FRICTION,  // each contact row followed by its friction rows, for SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS
+		PASS_SPLIT_PENETRATION,
+	};
+
+	static int s_minimumNumContacts;  // btSequentialImpulseConstraintSolver solves smaller islands one row at a time
+
+private:
+	enum
+	{
+		MAX_COLORS = 32
+	};
+
+	struct Group
+	{
+		int m_firstBlock;
+		int m_numBlocks;
+		int m_firstBatch;  // index into m_sortedBatches
+		int m_numLanes;
+	};
+
+	btAlignedObjectArray<btScalar> m_contactBlocks;   // NUM_ROW_COMPONENTS arrays of lanes per block
+	btAlignedObjectArray<btScalar> m_frictionBlocks;  // numFrictionDirections blocks per contact block
+	btAlignedObjectArray<int> m_contactRows;          // the contact row of each lane of each block, -1 for idle lanes
+	btAlignedObjectArray<int> m_blockBodies;          // the solver bodies A and B of each lane of each block, -1 when not dynamic
+	btAlignedObjectArray<int> m_blockOrder;           // the order of the blocks within their group
+	btAlignedObjectArray<Group> m_groups;
+	btAlignedObjectArray<btBatchedConstraints::Range> m_phaseGroups;  // the groups of each phase
+	btAlignedObjectArray<int> m_sortedBatches;                        // the batches of each phase, longest first
+	const btBatchedConstraints* m_batchedContacts;
+	int m_numFrictionDirections;
+	bool m_writeContactImpulses;
+
+	btBatchedConstraints m_coloredBatches;
+	btAlignedObjectArray<unsigned int> m_bodyColors;
+	btAlignedObjectArray<int> m_rowColors;
+	btAlignedObjectArray<int> m_colorOffsets;
+
+	template <RowPass pass, bool useMaxResidual>
+	btScalar solveGroupInternal(int iGroup, btSolverBody* bodies, btSolverConstraint* contacts);
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btBatchedContactRowsSoA();
+
+	static int getNumLanes();
+
+	///batches the contact rows for a single thread: the rows are colored greedily, so that the rows of a color share no dynamic
+	///bodies, and each color becomes a phase of getNumLanes() batches. Rows that get no color go to a last phase with a single batch.
+	const btBatchedConstraints& setupColoredBatches(const btConstraintArray& contacts, const btAlignedObjectArray<btSolverBody>& bodies);
+
+	///builds the groups for the batches and phases of batchedContacts, which must stay alive until the next setup. The blocks of
+	///the contact rows and their friction rows (the numFrictionDirections rows starting at m_frictionIndex) are filled by fillGroups.
+	///With writeContactImpulses the applied impulses of the contact rows are written to the contact pool after every pass.
+	void setupGroups(const btBatchedConstraints& batchedContacts, int numFrictionDirections, bool writeContactImpulses);
+
+	///fills the blocks of a range of groups, after the rows and their warm starting impulses are set up. Ranges can be filled in parallel.
+	void fillGroups(int iBeginGroup, int iEndGroup, const btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& contacts, const btConstraintArray& frictions);
+
+	///setupGroups and fillGroups for all groups
+	void setup(const btBatchedConstraints& batchedContacts, const btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& contacts, const btConstraintArray& frictions, int numFrictionDirections, bool writeContactImpulses);
+
+	void clear();
+
+	int getNumGroups() const
+	{
+		return m_groups.size();
+	}
+
+	///the groups of a phase of the batches passed to setupGroups
+	const btBatchedConstraints::Range& getPhaseGroups(int iPhase) const
+	{
+		return m_phaseGroups[iPhase];
+	}
+
+	///shuffles the order of the row blocks within each group, for SOLVER_RANDMIZE_ORDER
+	void randomizeRowOrder(btSequentialImpulseConstraintSolver* solver);
+
+	///solves the rows of a group and returns the sum of the squared residuals, or their maximum with useMaxResidual.
+	///Groups of a phase can be solved in parallel.
+	btScalar solveGroup(int iGroup, RowPass pass, bool useMaxResidual, btAlignedObjectArray<btSolverBody>& bodies, btConstraintArray& contacts);
+
+	///writes the applied impulses of a range of groups to the contact and friction rows, before the impulses are written back
+	void writeAppliedImpulses(int iBeginGroup, int iEndGroup, btConstraintArray& contacts, btConstraintArray& frictions) const;
+};
+
+#endif  //BT_BATCHED_CONTACT_ROWS_SOA_H
@@ -32,6 +32,7 @@ enum btSolverMode
 	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024,
 	SOLVER_DISABLE_IMPLICIT_CONE_FRICTION = 2048,
 	SOLVER_USE_ARTICULATED_WARMSTARTING = 4096,
+	SOLVER_SIMD_BATCHED_CONTACTS = 8192,  // solve the contact and contact friction rows one row per SIMD lane, see btBatchedContactRowsSoA
 };
 
 struct btContactSolverInfoData
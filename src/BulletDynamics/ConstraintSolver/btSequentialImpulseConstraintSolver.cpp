@@ -354,6 +354,8 @@ btSequentialImpulseConstraintSolver::btSequentialImpulseConstraintSolver()
 {
 	m_btSeed2 = 0;
 	m_cachedSolverMode = 0;
+	m_useContactRowsSoA = false;
+	m_contactRowsSoASolved = false;
 	setupSolverFunctions(false);
 }
 
@@ -1520,9 +1522,44 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 		}
 	}
 
+	setupContactRowsSoA(infoGlobal);
+
 	return 0.f;
 }
 
+void btSequentialImpulseConstraintSolver::setupContactRowsSoA(const btContactSolverInfo& infoGlobal)
+{
+	m_contactRowsSoASolved = false;
+	// without SIMD lanes (double precision or no SSE) the blocks only add gather and scatter work
+	m_useContactRowsSoA = (infoGlobal.m_solverMode & SOLVER_SIMD_BATCHED_CONTACTS) && btBatchedContactRowsSoA::getNumLanes() > 1 &&
+						  m_tmpSolverContactConstraintPool.size() >= btBatchedContactRowsSoA::s_minimumNumContacts;
+	if (m_useContactRowsSoA)
+	{
+		BT_PROFILE("setupContactRowsSoA");
+		int numFrictionDirections = (infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS) ? 2 : 1;
+		// the rolling friction rows read the applied impulses of the contact rows while they are solved
+		bool writeContactImpulses = m_tmpSolverContactRollingFrictionConstraintPool.size() > 0;
+		const btBatchedConstraints& batchedContacts = m_contactRowsSoA.setupColoredBatches(m_tmpSolverContactConstraintPool, m_tmpSolverBodyPool);
+		m_contactRowsSoA.setup(batchedContacts, m_tmpSolverBodyPool, m_tmpSolverContactConstraintPool, m_tmpSolverContactFrictionConstraintPool, numFrictionDirections, writeContactImpulses);
+	}
+}
+
+btScalar btSequentialImpulseConstraintSolver::resolveAllContactRowsSoA(btBatchedContactRowsSoA::RowPass pass)
+{
+	btScalar leastSquaresResidual = 0.f;
+	if (pass != btBatchedContactRowsSoA::PASS_SPLIT_PENETRATION)
+	{
+		m_contactRowsSoASolved = true;
+	}
+	// a single thread solves the groups of all phases in order
+	for (int iGroup = 0; iGroup < m_contactRowsSoA.getNumGroups(); ++iGroup)
+	{
+		btScalar residual = m_contactRowsSoA.solveGroup(iGroup, pass, true, m_tmpSolverBodyPool, m_tmpSolverContactConstraintPool);
+		leastSquaresResidual = btMax(leastSquaresResidual, residual);
+	}
+	return leastSquaresResidual;
+}
+
 btScalar btSequentialImpulseConstraintSolver::solveSingleIteration(int iteration, btCollisionObject** /*bodies */, int /*numBodies*/, btPersistentManifold** /*manifoldPtr*/, int /*numManifolds*/, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* /*debugDrawer*/)
 {
 	BT_PROFILE("solveSingleIteration");
@@ -1547,6 +1584,11 @@ btScalar btSequentialImpulseConstraintSolver::solveSingleIteration(int iteration
 			//contact/friction constraints are not solved more than
 			if (iteration < infoGlobal.m_numIterations)
 			{
+				if (m_useContactRowsSoA)
+				{
+					m_contactRowsSoA.randomizeRowOrder(this);
+				}
+
 				for (int j = 0; j < numConstraintPool; ++j)
 				{
 					int tmp = m_orderTmpConstraintPool[j];
@@ -1592,7 +1634,19 @@ btScalar btSequentialImpulseConstraintSolver::solveSingleIteration(int iteration
 		}
 
 		///solve all contact constraints
-		if (infoGlobal.m_solverMode & SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS)
+		if (m_useContactRowsSoA)
+		{
+			if (infoGlobal.m_solverMode & SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS)
+			{
+				leastSquaresResidual = btMax(leastSquaresResidual, resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_CONTACTS_AND_FRICTION));
+			}
+			else
+			{
+				leastSquaresResidual = btMax(leastSquaresResidual, resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_CONTACTS));
+				leastSquaresResidual = btMax(leastSquaresResidual, resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_FRICTION));
+			}
+		}
+		else if (infoGlobal.m_solverMode & SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS)
 		{
 			int numPoolConstraints = m_tmpSolverContactConstraintPool.size();
 			int multiplier = (infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS) ? 2 : 1;
@@ -1704,6 +1758,11 @@ void btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySplitImpulseIte
 			for (iteration = 0; iteration < infoGlobal.m_numIterations; iteration++)
 			{
 				btScalar leastSquaresResidual = 0.f;
+				if (m_useContactRowsSoA)
+				{
+					leastSquaresResidual = resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_SPLIT_PENETRATION);
+				}
+				else
 				{
 					int numPoolConstraints = m_tmpSolverContactConstraintPool.size();
 					int j;
@@ -1837,6 +1896,12 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyFinish(btCo
 {
 	BT_PROFILE("solveGroupCacheFriendlyFinish");
 
+	if (m_contactRowsSoASolved)
+	{
+		m_contactRowsSoA.writeAppliedImpulses(0, m_contactRowsSoA.getNumGroups(), m_tmpSolverContactConstraintPool, m_tmpSolverContactFrictionConstraintPool);
+		m_contactRowsSoASolved = false;
+	}
+
 	if (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING)
 	{
 		writeBackContacts(0, m_tmpSolverContactConstraintPool.size(), infoGlobal);
@@ -26,6 +26,7 @@ class btCollisionObject;
 #include "BulletDynamics/ConstraintSolver/btSolverConstraint.h"
 #include "BulletCollision/NarrowPhaseCollision/btManifoldPoint.h"
 #include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
+#include "BulletDynamics/ConstraintSolver/btBatchedContactRowsSoA.h"
 
 typedef btScalar (*btSingleConstraintRowSolver)(btSolverBody&, btSolverBody&, const btSolverConstraint&);
 
@@ -82,6 +83,11 @@ protected:
 
 	btScalar m_leastSquaresResidual;
 
+	///the contact and contact friction rows for SOLVER_SIMD_BATCHED_CONTACTS, see setupContactRowsSoA
+	btBatchedContactRowsSoA m_contactRowsSoA;
+	bool m_useContactRowsSoA;
+	bool m_contactRowsSoASolved;  // the applied impulses of m_contactRowsSoA are newer than those of the contact pools
+
 	void setupFrictionConstraint(btSolverConstraint & solverConstraint, const btVector3& normalAxis, int solverBodyIdA, int solverBodyIdB,
 		btManifoldPoint& cp, const btVector3& rel_pos1, const btVector3& rel_pos2,
 		btCollisionObject* colObj0, btCollisionObject* colObj1, btScalar relaxation,
@@ -152,6 +158,12 @@ protected:
 	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
 	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
 
+	///sets up m_contactRowsSoA at the end of solveGroupCacheFriendlySetup, when SOLVER_SIMD_BATCHED_CONTACTS is set, the build
+	///has more than one SIMD lane and there are at least btBatchedContactRowsSoA::s_minimumNumContacts contact rows
+	virtual void setupContactRowsSoA(const btContactSolverInfo& infoGlobal);
+	///solves a pass over all groups of m_contactRowsSoA, returns the maximum squared residual
+	virtual btScalar resolveAllContactRowsSoA(btBatchedContactRowsSoA::RowPass pass);
+
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
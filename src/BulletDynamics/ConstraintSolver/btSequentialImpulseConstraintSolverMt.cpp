@@ -870,6 +870,47 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveMultipleContactSplitPenet
 	return leastSquaresResidual;
 }
 
+struct BatchResidualLoop : public btIParallelForBody
+{
+	const btIParallelSumBody* m_body;
+	btScalar* m_residuals;
+	int m_begin;
+
+	BatchResidualLoop(const btIParallelSumBody* body, btScalar* residuals, int begin)
+	{
+		m_body = body;
+		m_residuals = residuals;
+		m_begin = begin;
+	}
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int iBatch = iBegin; iBatch < iEnd; ++iBatch)
+		{
+			m_residuals[iBatch - m_begin] = m_body->sumLoop(iBatch, iBatch + 1);
+		}
+	}
+};
+
+btScalar btSequentialImpulseConstraintSolverMt::sumBatchResiduals(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+	// the batches are solved in parallel, but their residuals are added up in batch order,
+	// so the sum does not depend on the number of threads or on how the work was split among them
+	const int numBatches = iEnd - iBegin;
+	if (numBatches <= 0)
+	{
+		return btScalar(0);
+	}
+	m_batchResiduals.resizeNoInitialize(numBatches);
+	BatchResidualLoop loop(&body, &m_batchResiduals[0], iBegin);
+	btParallelFor(iBegin, iEnd, grainSize, loop);
+	btScalar sum = 0;
+	for (int i = 0; i < numBatches; ++i)
+	{
+		sum += m_batchResiduals[i];
+	}
+	return sum;
+}
+
 struct ContactSplitPenetrationImpulseSolverLoop : public btIParallelSumBody
 {
 	btSequentialImpulseConstraintSolverMt* m_solver;
@@ -901,17 +942,20 @@ void btSequentialImpulseConstraintSolverMt::solveGroupCacheFriendlySplitImpulseI
 		for (int iteration = 0; iteration < infoGlobal.m_numIterations; iteration++)
 		{
 			btScalar leastSquaresResidual = 0.f;
-			if (m_useBatching)
+			if (m_useContactRowsSoA)
+			{
+				leastSquaresResidual = resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_SPLIT_PENETRATION);
+			}
+			else if (m_useBatching)
 			{
 				const btBatchedConstraints& batchedCons = m_batchedContactConstraints;
 				ContactSplitPenetrationImpulseSolverLoop loop(this, &batchedCons);
-				btScalar leastSquaresResidual = 0.f;
 				for (int iiPhase = 0; iiPhase < batchedCons.m_phases.size(); ++iiPhase)
 				{
 					int iPhase = batchedCons.m_phaseOrder[iiPhase];
 					const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 					int grainSize = batchedCons.m_phaseGrainSize[iPhase];
-					leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+					leastSquaresResidual += sumBatchResiduals(phase.begin, phase.end, grainSize, loop);
 				}
 			}
 			else
@@ -1040,7 +1084,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveMultipleContactFrictionCo
 			int iEnd = iBegin + m_numFrictionDirections;
 			for (int iFriction = iBegin; iFriction < iEnd; ++iFriction)
 			{
-				btSolverConstraint& solveManifold = m_tmpSolverContactFrictionConstraintPool[iFriction++];
+				btSolverConstraint& solveManifold = m_tmpSolverContactFrictionConstraintPool[iFriction];
 				btAssert(solveManifold.m_frictionIndex == iContact);
 
 				solveManifold.m_lowerLimit = -(solveManifold.m_friction * totalImpulse);
@@ -1198,6 +1242,10 @@ void btSequentialImpulseConstraintSolverMt::randomizeConstraintOrdering(int iter
 	if (iteration < numIterations)
 	{
 		randomizeBatchedConstraintOrdering(&m_batchedContactConstraints);
+		if (m_useContactRowsSoA)
+		{
+			m_contactRowsSoA.randomizeRowOrder(this);
+		}
 	}
 }
 
@@ -1237,7 +1285,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllJointConstraints(int i
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = 1;
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumBatchResiduals(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1267,6 +1315,10 @@ struct ContactSolverLoop : public btIParallelSumBody
 
 btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactConstraints()
 {
+	if (m_useContactRowsSoA)
+	{
+		return resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_CONTACTS);
+	}
 	BT_PROFILE("resolveAllContactConstraints");
 	const btBatchedConstraints& batchedCons = m_batchedContactConstraints;
 	ContactSolverLoop loop(this, &batchedCons);
@@ -1276,7 +1328,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactConstraints()
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = batchedCons.m_phaseGrainSize[iPhase];
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumBatchResiduals(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1306,6 +1358,10 @@ struct ContactFrictionSolverLoop : public btIParallelSumBody
 
 btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactFrictionConstraints()
 {
+	if (m_useContactRowsSoA)
+	{
+		return resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_FRICTION);
+	}
 	BT_PROFILE("resolveAllContactFrictionConstraints");
 	const btBatchedConstraints& batchedCons = m_batchedContactConstraints;
 	ContactFrictionSolverLoop loop(this, &batchedCons);
@@ -1315,7 +1371,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactFrictionConstra
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = batchedCons.m_phaseGrainSize[iPhase];
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumBatchResiduals(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1345,6 +1401,13 @@ struct InterleavedContactSolverLoop : public btIParallelSumBody
 
 btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactConstraintsInterleaved()
 {
+	if (m_useContactRowsSoA)
+	{
+		// the rolling friction rows are solved after the groups, rather than interleaved
+		btScalar leastSquaresResidual = resolveAllContactRowsSoA(btBatchedContactRowsSoA::PASS_CONTACTS_AND_FRICTION);
+		leastSquaresResidual += resolveAllRollingFrictionConstraints();
+		return leastSquaresResidual;
+	}
 	BT_PROFILE("resolveAllContactConstraintsInterleaved");
 	const btBatchedConstraints& batchedCons = m_batchedContactConstraints;
 	InterleavedContactSolverLoop loop(this, &batchedCons);
@@ -1354,7 +1417,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactConstraintsInte
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = 1;
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumBatchResiduals(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1414,7 +1477,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllRollingFrictionConstra
 			int iPhase = batchedCons.m_phaseOrder[iiPhase];
 			const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 			int grainSize = 1;
-			leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+			leastSquaresResidual += sumBatchResiduals(phase.begin, phase.end, grainSize, loop);
 		}
 	}
 	else
@@ -1444,6 +1507,100 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllRollingFrictionConstra
 	return leastSquaresResidual;
 }
 
+struct FillContactRowGroupsSoALoop : public btIParallelForBody
+{
+	btSequentialImpulseConstraintSolverMt* m_solver;
+
+	FillContactRowGroupsSoALoop(btSequentialImpulseConstraintSolverMt* solver)
+	{
+		m_solver = solver;
+	}
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		m_solver->internalFillContactRowGroupsSoA(iBegin, iEnd);
+	}
+};
+
+void btSequentialImpulseConstraintSolverMt::internalFillContactRowGroupsSoA(int iBegin, int iEnd)
+{
+	BT_PROFILE("internalFillContactRowGroupsSoA");
+	m_contactRowsSoA.fillGroups(iBegin, iEnd, m_tmpSolverBodyPool, m_tmpSolverContactConstraintPool, m_tmpSolverContactFrictionConstraintPool);
+}
+
+void btSequentialImpulseConstraintSolverMt::setupContactRowsSoA(const btContactSolverInfo& infoGlobal)
+{
+	if (!m_useBatching)
+	{
+		// a single thread solves the contacts, the rows are batched by coloring
+		btSequentialImpulseConstraintSolver::setupContactRowsSoA(infoGlobal);
+		return;
+	}
+	m_contactRowsSoASolved = false;
+	m_useContactRowsSoA = (infoGlobal.m_solverMode & SOLVER_SIMD_BATCHED_CONTACTS) && btBatchedContactRowsSoA::getNumLanes() > 1;
+	if (m_useContactRowsSoA)
+	{
+		BT_PROFILE("setupContactRowsSoA");
+		// the rolling friction rows read the applied impulses of the contact rows while they are solved
+		bool writeContactImpulses = m_tmpSolverContactRollingFrictionConstraintPool.size() > 0;
+		m_contactRowsSoA.setupGroups(m_batchedContactConstraints, m_numFrictionDirections, writeContactImpulses);
+		FillContactRowGroupsSoALoop loop(this);
+		int grainSize = 1;
+		btParallelFor(0, m_contactRowsSoA.getNumGroups(), grainSize, loop);
+	}
+}
+
+btScalar btSequentialImpulseConstraintSolverMt::resolveMultipleContactRowGroupsSoA(int groupBegin, int groupEnd, btBatchedContactRowsSoA::RowPass pass)
+{
+	btScalar leastSquaresResidual = 0.f;
+	for (int iGroup = groupBegin; iGroup < groupEnd; ++iGroup)
+	{
+		leastSquaresResidual += m_contactRowsSoA.solveGroup(iGroup, pass, false, m_tmpSolverBodyPool, m_tmpSolverContactConstraintPool);
+	}
+	return leastSquaresResidual;
+}
+
+struct ContactRowsSoASolverLoop : public btIParallelSumBody
+{
+	btSequentialImpulseConstraintSolverMt* m_solver;
+	btBatchedContactRowsSoA::RowPass m_pass;
+
+	ContactRowsSoASolverLoop(btSequentialImpulseConstraintSolverMt* solver, btBatchedContactRowsSoA::RowPass pass)
+	{
+		m_solver = solver;
+		m_pass = pass;
+	}
+	btScalar sumLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		BT_PROFILE("ContactRowsSoASolverLoop");
+		return m_solver->resolveMultipleContactRowGroupsSoA(iBegin, iEnd, m_pass);
+	}
+};
+
+btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactRowsSoA(btBatchedContactRowsSoA::RowPass pass)
+{
+	if (!m_useBatching)
+	{
+		return btSequentialImpulseConstraintSolver::resolveAllContactRowsSoA(pass);
+	}
+	BT_PROFILE("resolveAllContactRowsSoA");
+	if (pass != btBatchedContactRowsSoA::PASS_SPLIT_PENETRATION)
+	{
+		m_contactRowsSoASolved = true;
+	}
+	const btBatchedConstraints& batchedCons = m_batchedContactConstraints;
+	ContactRowsSoASolverLoop loop(this, pass);
+	btScalar leastSquaresResidual = 0.f;
+	for (int iiPhase = 0; iiPhase < batchedCons.m_phases.size(); ++iiPhase)
+	{
+		// the groups of a phase are solved in parallel, like the batches they are made of
+		int iPhase = batchedCons.m_phaseOrder[iiPhase];
+		const btBatchedConstraints::Range& groups = m_contactRowsSoA.getPhaseGroups(iPhase);
+		int grainSize = 1;
+		leastSquaresResidual += sumBatchResiduals(groups.begin, groups.end, grainSize, loop);
+	}
+	return leastSquaresResidual;
+}
+
 void btSequentialImpulseConstraintSolverMt::internalWriteBackContacts(int iBegin, int iEnd, const btContactSolverInfo& infoGlobal)
 {
 	BT_PROFILE("internalWriteBackContacts");
@@ -1474,6 +1631,12 @@ void btSequentialImpulseConstraintSolverMt::internalWriteBackBodies(int iBegin,
 	writeBackBodies(iBegin, iEnd, infoGlobal);
 }
 
+void btSequentialImpulseConstraintSolverMt::internalWriteContactRowImpulsesSoA(int iBegin, int iEnd)
+{
+	BT_PROFILE("internalWriteContactRowImpulsesSoA");
+	m_contactRowsSoA.writeAppliedImpulses(iBegin, iEnd, m_tmpSolverContactConstraintPool, m_tmpSolverContactFrictionConstraintPool);
+}
+
 struct WriteContactPointsLoop : public btIParallelForBody
 {
 	btSequentialImpulseConstraintSolverMt* m_solver;
@@ -1522,10 +1685,32 @@ struct WriteBodiesLoop : public btIParallelForBody
 	}
 };
 
+struct WriteContactRowImpulsesSoALoop : public btIParallelForBody
+{
+	btSequentialImpulseConstraintSolverMt* m_solver;
+
+	WriteContactRowImpulsesSoALoop(btSequentialImpulseConstraintSolverMt* solver)
+	{
+		m_solver = solver;
+	}
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		m_solver->internalWriteContactRowImpulsesSoA(iBegin, iEnd);
+	}
+};
+
 btScalar btSequentialImpulseConstraintSolverMt::solveGroupCacheFriendlyFinish(btCollisionObject** bodies, int numBodies, const btContactSolverInfo& infoGlobal)
 {
 	BT_PROFILE("solveGroupCacheFriendlyFinish");
 
+	if (m_contactRowsSoASolved)
+	{
+		WriteContactRowImpulsesSoALoop loop(this);
+		int grainSize = 10;
+		btParallelFor(0, m_contactRowsSoA.getNumGroups(), grainSize, loop);
+		m_contactRowsSoASolved = false;
+	}
+
 	if (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING)
 	{
 		WriteContactPointsLoop loop(this, infoGlobal);
@@ -48,10 +48,13 @@ subject to the following restrictions:
 ///  is randomized, however it does not swap constraints between batches.
 ///  This is to avoid regenerating the batches for each solver iteration which would be quite costly in performance.
 ///
-///  Note that a non-zero leastSquaresResidualThreshold could possibly affect the determinism of the simulation
-///  if the task scheduler's parallelSum operation is non-deterministic. The parallelSum operation can be non-deterministic
+///  When the SOLVER_SIMD_BATCHED_CONTACTS flag is enabled, the contact and contact friction rows of the batches of each phase
+///  are solved one row per SIMD lane, see btBatchedContactRowsSoA. The groups of lanes of a phase are solved in parallel.
+///
+///  A non-zero leastSquaresResidualThreshold can end the iterations early, so the residual must not depend on the threads.
+///  The residuals of the batches of a phase are computed in parallel but summed in batch order (see sumBatchResiduals),
+///  rather than with the task scheduler's parallelSum whose result depends on how the work was split among the threads,
 ///  because floating point addition is not associative due to rounding errors.
-///  The task scheduler can and should ensure that the result of any parallelSum operation is deterministic.
 ///
 ATTRIBUTE_ALIGNED16(class)
 btSequentialImpulseConstraintSolverMt : public btSequentialImpulseConstraintSolver
@@ -106,6 +109,7 @@ protected:
 	char m_antiFalseSharingPadding[CACHE_LINE_SIZE];  // padding to keep mutexes in separate cachelines
 	btSpinMutex m_kinematicBodyUniqueIdToSolverBodyTableMutex;
 	btAlignedObjectArray<char> m_scratchMemory;
+	btAlignedObjectArray<btScalar> m_batchResiduals;  // one per batch of the phase being solved
 
 	virtual void randomizeConstraintOrdering(int iteration, int numIterations);
 	virtual btScalar resolveAllJointConstraints(int iteration);
@@ -113,6 +117,8 @@ protected:
 	virtual btScalar resolveAllContactFrictionConstraints();
 	virtual btScalar resolveAllContactConstraintsInterleaved();
 	virtual btScalar resolveAllRollingFrictionConstraints();
+	virtual void setupContactRowsSoA(const btContactSolverInfo& infoGlobal) BT_OVERRIDE;
+	virtual btScalar resolveAllContactRowsSoA(btBatchedContactRowsSoA::RowPass pass) BT_OVERRIDE;
 
 	virtual void setupBatchedContactConstraints();
 	virtual void setupBatchedJointConstraints();
@@ -124,6 +130,7 @@ protected:
 	void allocAllContactConstraints(btPersistentManifold * *manifoldPtr, int numManifolds, const btContactSolverInfo& infoGlobal);
 	void setupAllContactConstraints(const btContactSolverInfo& infoGlobal);
 	void randomizeBatchedConstraintOrdering(btBatchedConstraints * batchedConstraints);
+	btScalar sumBatchResiduals(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body);
 
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
@@ -137,6 +144,7 @@ public:
 	btScalar resolveMultipleContactFrictionConstraints(const btAlignedObjectArray<int>& consIndices, int batchBegin, int batchEnd);
 	btScalar resolveMultipleContactRollingFrictionConstraints(const btAlignedObjectArray<int>& consIndices, int batchBegin, int batchEnd);
 	btScalar resolveMultipleContactConstraintsInterleaved(const btAlignedObjectArray<int>& contactIndices, int batchBegin, int batchEnd);
+	btScalar resolveMultipleContactRowGroupsSoA(int groupBegin, int groupEnd, btBatchedContactRowsSoA::RowPass pass);
 
 	void internalCollectContactManifoldCachedInfo(btContactManifoldCachedInfo * cachedInfoArray, btPersistentManifold * *manifoldPtr, int numManifolds, const btContactSolverInfo& infoGlobal);
 	void internalAllocContactConstraints(const btContactManifoldCachedInfo* cachedInfoArray, int numManifolds);
@@ -145,6 +153,8 @@ public:
 	void internalWriteBackContacts(int iBegin, int iEnd, const btContactSolverInfo& infoGlobal);
 	void internalWriteBackJoints(int iBegin, int iEnd, const btContactSolverInfo& infoGlobal);
 	void internalWriteBackBodies(int iBegin, int iEnd, const btContactSolverInfo& infoGlobal);
+	void internalFillContactRowGroupsSoA(int iBegin, int iEnd);
+	void internalWriteContactRowImpulsesSoA(int iBegin, int iEnd);
 };
 
 #endif  //BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_MT_H
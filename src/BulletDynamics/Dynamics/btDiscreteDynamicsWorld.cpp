@@ -23,6 +23,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
 #include "LinearMath/btTransformUtil.h"
 #include "LinearMath/btQuickprof.h"
+#include "BulletDynamics/Dynamics/btRigidBodyStateSoA.h"
 
 //rigidbody & constraints
 #include "BulletDynamics/Dynamics/btRigidBody.h"
@@ -199,7 +200,8 @@ btDiscreteDynamicsWorld::btDiscreteDynamicsWorld(btDispatcher* dispatcher, btBro
 	  m_synchronizeAllMotionStates(false),
 	  m_applySpeculativeContactRestitution(false),
 	  m_profileTimings(0),
-	  m_latencyMotionStateInterpolation(true)
+	  m_latencyMotionStateInterpolation(true),
+	  m_rigidBodyStateSoA(NULL)
 
 {
 	if (!m_constraintSolver)
@@ -244,6 +246,8 @@ btDiscreteDynamicsWorld::~btDiscreteDynamicsWorld()
 		m_constraintSolver->~btConstraintSolver();
 		btAlignedFree(m_constraintSolver);
 	}
+	//the bodies may already be deleted, so they are not removed from the state arrays
+	delete m_rigidBodyStateSoA;
 }
 
 void btDiscreteDynamicsWorld::saveKinematicState(btScalar timeStep)
@@ -531,6 +535,10 @@ void btDiscreteDynamicsWorld::removeCollisionObject(btCollisionObject* collision
 void btDiscreteDynamicsWorld::removeRigidBody(btRigidBody* body)
 {
 	m_nonStaticRigidBodies.remove(body);
+	if (m_rigidBodyStateSoA)
+	{
+		m_rigidBodyStateSoA->removeRigidBody(body);
+	}
 	btCollisionWorld::removeCollisionObject(body);
 }
 
@@ -546,6 +554,10 @@ void btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body)
 		if (!body->isStaticObject())
 		{
 			m_nonStaticRigidBodies.push_back(body);
+			if (m_rigidBodyStateSoA)
+			{
+				m_rigidBodyStateSoA->addRigidBody(body);
+			}
 		}
 		else
 		{
@@ -572,6 +584,10 @@ void btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body, int group, int mas
 		if (!body->isStaticObject())
 		{
 			m_nonStaticRigidBodies.push_back(body);
+			if (m_rigidBodyStateSoA)
+			{
+				m_rigidBodyStateSoA->addRigidBody(body);
+			}
 		}
 		else
 		{
@@ -846,81 +862,99 @@ public:
 ///internal debugging variable. this value shouldn't be too high
 int gNumClampedCcdMotions = 0;
 
-void btDiscreteDynamicsWorld::createPredictiveContactsInternal(btRigidBody** bodies, int numBodies, btScalar timeStep)
+bool btDiscreteDynamicsWorld::sweepPredictiveContact(btRigidBody* body, btScalar timeStep, PredictiveContactHit& hit)
 {
 	btTransform predictedTrans;
-	for (int i = 0; i < numBodies; i++)
-	{
-		btRigidBody* body = bodies[i];
-		body->setHitFraction(1.f);
-
-		if (body->isActive() && (!body->isStaticOrKinematicObject()))
-		{
-			body->predictIntegratedTransform(timeStep, predictedTrans);
+	body->predictIntegratedTransform(timeStep, predictedTrans);
 
-			btScalar squareMotion = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length2();
+	btScalar squareMotion = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length2();
 
-			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+	if (useCcdSweeps() && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+	{
+		BT_PROFILE("predictive convexSweepTest");
+		if (body->getCollisionShape()->isConvex())
+		{
+			gNumClampedCcdMotions++;
+#ifdef PREDICTIVE_CONTACT_USE_STATIC_ONLY
+			class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
 			{
-				BT_PROFILE("predictive convexSweepTest");
-				if (body->getCollisionShape()->isConvex())
+			public:
+				StaticOnlyCallback(btCollisionObject* me, const btVector3& fromA, const btVector3& toA, btOverlappingPairCache* pairCache, btDispatcher* dispatcher) : btClosestNotMeConvexResultCallback(me, fromA, toA, pairCache, dispatcher)
 				{
-					gNumClampedCcdMotions++;
-#ifdef PREDICTIVE_CONTACT_USE_STATIC_ONLY
-					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
-					{
-					public:
-						StaticOnlyCallback(btCollisionObject* me, const btVector3& fromA, const btVector3& toA, btOverlappingPairCache* pairCache, btDispatcher* dispatcher) : btClosestNotMeConvexResultCallback(me, fromA, toA, pairCache, dispatcher)
-						{
-						}
+				}
 
-						virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-						{
-							btCollisionObject* otherObj = (btCollisionObject*)proxy0->m_clientObject;
-							if (!otherObj->isStaticOrKinematicObject())
-								return false;
-							return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
-						}
-					};
+				virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+				{
+					btCollisionObject* otherObj = (btCollisionObject*)proxy0->m_clientObject;
+					if (!otherObj->isStaticOrKinematicObject())
+						return false;
+					return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
+				}
+			};
 
-					StaticOnlyCallback sweepResults(body, body->getWorldTransform().getOrigin(), predictedTrans.getOrigin(), getBroadphase()->getOverlappingPairCache(), getDispatcher());
+			StaticOnlyCallback sweepResults(body, body->getWorldTransform().getOrigin(), predictedTrans.getOrigin(), getBroadphase()->getOverlappingPairCache(), getDispatcher());
 #else
-					btClosestNotMeConvexResultCallback sweepResults(body, body->getWorldTransform().getOrigin(), predictedTrans.getOrigin(), getBroadphase()->getOverlappingPairCache(), getDispatcher());
+			btClosestNotMeConvexResultCallback sweepResults(body, body->getWorldTransform().getOrigin(), predictedTrans.getOrigin(), getBroadphase()->getOverlappingPairCache(), getDispatcher());
 #endif
-					//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					btSphereShape tmpSphere(body->getCcdSweptSphereRadius());  //btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					sweepResults.m_allowedPenetration = getDispatchInfo().m_allowedCcdPenetration;
+			//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+			btSphereShape tmpSphere(body->getCcdSweptSphereRadius());  //btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+			sweepResults.m_allowedPenetration = getDispatchInfo().m_allowedCcdPenetration;
 
-					sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
-					sweepResults.m_collisionFilterMask = body->getBroadphaseProxy()->m_collisionFilterMask;
-					btTransform modifiedPredictedTrans = predictedTrans;
-					modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
+			sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
+			sweepResults.m_collisionFilterMask = body->getBroadphaseProxy()->m_collisionFilterMask;
+			btTransform modifiedPredictedTrans = predictedTrans;
+			modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
 
-					convexSweepTest(&tmpSphere, body->getWorldTransform(), modifiedPredictedTrans, sweepResults);
-					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
-					{
-						btVector3 distVec = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()) * sweepResults.m_closestHitFraction;
-						btScalar distance = distVec.dot(-sweepResults.m_hitNormalWorld);
-
-						btPersistentManifold* manifold = m_dispatcher1->getNewManifold(body, sweepResults.m_hitCollisionObject);
-						btMutexLock(&m_predictiveManifoldsMutex);
-						m_predictiveManifolds.push_back(manifold);
-						btMutexUnlock(&m_predictiveManifoldsMutex);
-
-						btVector3 worldPointB = body->getWorldTransform().getOrigin() + distVec;
-						btVector3 localPointB = sweepResults.m_hitCollisionObject->getWorldTransform().inverse() * worldPointB;
-
-						btManifoldPoint newPoint(btVector3(0, 0, 0), localPointB, sweepResults.m_hitNormalWorld, distance);
-
-						bool isPredictive = true;
-						int index = manifold->addManifoldPoint(newPoint, isPredictive);
-						btManifoldPoint& pt = manifold->getContactPoint(index);
-						pt.m_combinedRestitution = 0;
-						pt.m_combinedFriction = gCalculateCombinedFrictionCallback(body, sweepResults.m_hitCollisionObject);
-						pt.m_positionWorldOnA = body->getWorldTransform().getOrigin();
-						pt.m_positionWorldOnB = worldPointB;
-					}
-				}
+			convexSweepTest(&tmpSphere, body->getWorldTransform(), modifiedPredictedTrans, sweepResults);
+			if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
+			{
+				hit.m_hitObject = sweepResults.m_hitCollisionObject;
+				hit.m_hitNormalWorld = sweepResults.m_hitNormalWorld;
+				hit.m_motionToHit = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()) * sweepResults.m_closestHitFraction;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void btDiscreteDynamicsWorld::addPredictiveContact(btRigidBody* body, const PredictiveContactHit& hit)
+{
+	const btVector3& distVec = hit.m_motionToHit;
+	btScalar distance = distVec.dot(-hit.m_hitNormalWorld);
+
+	btPersistentManifold* manifold = m_dispatcher1->getNewManifold(body, hit.m_hitObject);
+	btMutexLock(&m_predictiveManifoldsMutex);
+	m_predictiveManifolds.push_back(manifold);
+	btMutexUnlock(&m_predictiveManifoldsMutex);
+
+	btVector3 worldPointB = body->getWorldTransform().getOrigin() + distVec;
+	btVector3 localPointB = hit.m_hitObject->getWorldTransform().inverse() * worldPointB;
+
+	btManifoldPoint newPoint(btVector3(0, 0, 0), localPointB, hit.m_hitNormalWorld, distance);
+
+	bool isPredictive = true;
+	int index = manifold->addManifoldPoint(newPoint, isPredictive);
+	btManifoldPoint& pt = manifold->getContactPoint(index);
+	pt.m_combinedRestitution = 0;
+	pt.m_combinedFriction = gCalculateCombinedFrictionCallback(body, hit.m_hitObject);
+	pt.m_positionWorldOnA = body->getWorldTransform().getOrigin();
+	pt.m_positionWorldOnB = worldPointB;
+}
+
+void btDiscreteDynamicsWorld::createPredictiveContactsInternal(btRigidBody** bodies, int numBodies, btScalar timeStep)
+{
+	PredictiveContactHit hit;
+	for (int i = 0; i < numBodies; i++)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
+			if (sweepPredictiveContact(body, timeStep, hit))
+			{
+				addPredictiveContact(body, hit);
 			}
 		}
 	}
@@ -942,7 +976,7 @@ void btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 {
 	BT_PROFILE("createPredictiveContacts");
 	releasePredictiveContacts();
-	if (m_nonStaticRigidBodies.size() > 0)
+	if (m_nonStaticRigidBodies.size() > 0 && useCcdSweeps())
 	{
 		createPredictiveContactsInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
 	}
@@ -962,7 +996,7 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 
 			btScalar squareMotion = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length2();
 
-			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+			if (useCcdSweeps() && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
 			{
 				BT_PROFILE("CCD motion clamping");
 				if (body->getCollisionShape()->isConvex())
@@ -1047,7 +1081,17 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
-	if (m_nonStaticRigidBodies.size() > 0)
+	if (m_rigidBodyStateSoA)
+	{
+		//the bodies that need motion clamping are integrated again, one by one
+		m_ccdBodiesSoA.resize(0);
+		m_rigidBodyStateSoA->integrateTransforms(timeStep, useCcdSweeps(), m_ccdBodiesSoA);
+		if (m_ccdBodiesSoA.size() > 0)
+		{
+			integrateTransformsInternal(&m_ccdBodiesSoA[0], m_ccdBodiesSoA.size(), timeStep);
+		}
+	}
+	else if (m_nonStaticRigidBodies.size() > 0)
 	{
 		integrateTransformsInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
 	}
@@ -1091,6 +1135,11 @@ void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 void btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
+	if (m_rigidBodyStateSoA)
+	{
+		m_rigidBodyStateSoA->predictUnconstraintMotion(timeStep);
+		return;
+	}
 	for (int i = 0; i < m_nonStaticRigidBodies.size(); i++)
 	{
 		btRigidBody* body = m_nonStaticRigidBodies[i];
@@ -1105,6 +1154,31 @@ void btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 	}
 }
 
+void btDiscreteDynamicsWorld::setUseSoAIntegration(bool useSoA)
+{
+	if (useSoA == (m_rigidBodyStateSoA != NULL))
+	{
+		return;
+	}
+	if (useSoA)
+	{
+		m_rigidBodyStateSoA = new btRigidBodyStateSoA();
+		for (int i = 0; i < m_nonStaticRigidBodies.size(); i++)
+		{
+			m_rigidBodyStateSoA->addRigidBody(m_nonStaticRigidBodies[i]);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < m_nonStaticRigidBodies.size(); i++)
+		{
+			m_rigidBodyStateSoA->removeRigidBody(m_nonStaticRigidBodies[i]);
+		}
+		delete m_rigidBodyStateSoA;
+		m_rigidBodyStateSoA = NULL;
+	}
+}
+
 void btDiscreteDynamicsWorld::startProfiling(btScalar timeStep)
 {
 	(void)timeStep;
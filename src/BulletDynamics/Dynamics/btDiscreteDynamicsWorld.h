@@ -25,6 +25,7 @@ class btTypedConstraint;
 class btActionInterface;
 class btPersistentManifold;
 class btIDebugDraw;
+class btRigidBodyStateSoA;
 
 struct InplaceSolverIslandCallback;
 
@@ -69,6 +70,9 @@ protected:
 	btAlignedObjectArray<btPersistentManifold*> m_predictiveManifolds;
 	btSpinMutex m_predictiveManifoldsMutex;  // used to synchronize threads creating predictive contacts
 
+	btRigidBodyStateSoA* m_rigidBodyStateSoA;  // NULL unless setUseSoAIntegration(true)
+	btAlignedObjectArray<btRigidBody*> m_ccdBodiesSoA;
+
 	virtual void predictUnconstraintMotion(btScalar timeStep);
 
 	void integrateTransformsInternal(btRigidBody * *bodies, int numBodies, btScalar timeStep);  // can be called in parallel
@@ -86,10 +90,26 @@ protected:
 
 	virtual void internalSingleStepSimulation(btScalar timeStep);
 
+	///closest hit of the swept sphere of a fast moving body, found by sweepPredictiveContact
+	struct PredictiveContactHit
+	{
+		const btCollisionObject* m_hitObject;
+		btVector3 m_hitNormalWorld;
+		btVector3 m_motionToHit;  // motion of the body origin up to the hit
+	};
+
 	void releasePredictiveContacts();
+	bool sweepPredictiveContact(btRigidBody * body, btScalar timeStep, PredictiveContactHit & hit);  // can be called in parallel
+	void addPredictiveContact(btRigidBody * body, const PredictiveContactHit& hit);
 	void createPredictiveContactsInternal(btRigidBody * *bodies, int numBodies, btScalar timeStep);  // can be called in parallel
 	virtual void createPredictiveContacts(btScalar timeStep);
 
+	///fast bodies are swept against the world for predictive contacts and motion clamping, unless speculative contacts are used
+	bool useCcdSweeps() const
+	{
+		return getDispatchInfo().m_useContinuous && !getDispatchInfo().m_useSpeculativeContacts;
+	}
+
 	virtual void saveKinematicState(btScalar timeStep);
 
 	void serializeRigidBodies(btSerializer * serializer);
@@ -216,6 +236,22 @@ public:
 		return m_applySpeculativeContactRestitution;
 	}
 
+	///Use speculative contacts for continuous collision detection, instead of the swept spheres of btCollisionObject::setCcdMotionThreshold.
+	///The broadphase aabbs of the dynamic rigid bodies cover their motion over the time step, and the narrowphase keeps the contacts
+	///within the relative motion of the two objects, with a positive distance. The solver only removes the part of the approach velocity
+	///that would close that distance, so fast bodies stop at the surface, without sweeps or motion clamping after the solver.
+	///The distance includes the rotation of the bodies through their angular motion disc, and polyhedra get contacts at their separated vertices
+	///that approach the contact face of another polyhedron, but not at the vertices beyond the edges of that face.
+	///Thin triangle meshes can still be passed by fast boxes that reach the back of the triangles within one step.
+	void setUseSpeculativeContacts(bool useSpeculativeContacts)
+	{
+		getDispatchInfo().m_useSpeculativeContacts = useSpeculativeContacts;
+	}
+	bool getUseSpeculativeContacts() const
+	{
+		return getDispatchInfo().m_useSpeculativeContacts;
+	}
+
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (see Bullet/Demos/SerializeDemo)
 	virtual void serialize(btSerializer * serializer);
 
@@ -229,6 +265,15 @@ public:
 	{
 		return m_latencyMotionStateInterpolation;
 	}
+
+	///Integrate the non-static rigid bodies with the SIMD kernels of btRigidBodyStateSoA in predictUnconstraintMotion and integrateTransforms.
+	///Bodies that need continuous collision detection are still integrated one by one.
+	///btDiscreteDynamicsWorldMt has its own parallel integration and ignores this setting.
+	void setUseSoAIntegration(bool useSoA);
+	bool getUseSoAIntegration() const
+	{
+		return m_rigidBodyStateSoA != 0;
+	}
     
     btAlignedObjectArray<btRigidBody*>& getNonStaticRigidBodies()
     {
@@ -72,6 +72,7 @@ btConstraintSolverPoolMt::ThreadSolver* btConstraintSolverPoolMt::getAndLockThre
 void btConstraintSolverPoolMt::init(btConstraintSolver** solvers, int numSolvers)
 {
 	m_solverType = BT_SEQUENTIAL_IMPULSE_SOLVER;
+	m_deterministic = false;
 	m_solvers.resize(numSolvers);
 	for (int i = 0; i < numSolvers; ++i)
 	{
@@ -125,6 +126,10 @@ btScalar btConstraintSolverPoolMt::solveGroup(btCollisionObject** bodies,
 											  btDispatcher* dispatcher)
 {
 	ThreadSolver* ts = getAndLockThreadSolver();
+	if (m_deterministic)
+	{
+		ts->solver->reset();
+	}
 	ts->solver->solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, info, debugDrawer, dispatcher);
 	ts->mutex.unlock();
 	return 0.0f;
@@ -164,6 +169,8 @@ btDiscreteDynamicsWorldMt::btDiscreteDynamicsWorldMt(btDispatcher* dispatcher,
 		m_islandManager = im;
 	}
 	m_constraintSolverMt = constraintSolverMt;
+	m_solverPool = solverPool;
+	m_deterministic = false;
 }
 
 btDiscreteDynamicsWorldMt::~btDiscreteDynamicsWorldMt()
@@ -222,32 +229,104 @@ void btDiscreteDynamicsWorldMt::predictUnconstraintMotion(btScalar timeStep)
 	}
 }
 
+void btDiscreteDynamicsWorldMt::sweepPredictiveContactsInternal(btRigidBody** bodies, int iBegin, int iEnd, btScalar timeStep)
+{
+	for (int i = iBegin; i < iEnd; ++i)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+
+		bool hasHit = false;
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
+			hasHit = sweepPredictiveContact(body, timeStep, m_predictiveContactHits[i]);
+		}
+		m_bodyFlags[i] = hasHit;
+	}
+}
+
 void btDiscreteDynamicsWorldMt::createPredictiveContacts(btScalar timeStep)
 {
 	BT_PROFILE("createPredictiveContacts");
 	releasePredictiveContacts();
-	if (m_nonStaticRigidBodies.size() > 0)
+	const int numBodies = m_nonStaticRigidBodies.size();
+	if (numBodies > 0 && useCcdSweeps())
 	{
+		m_predictiveContactHits.resizeNoInitialize(numBodies);
+		m_bodyFlags.resizeNoInitialize(numBodies);
 		UpdaterCreatePredictiveContacts update;
 		update.world = this;
 		update.timeStep = timeStep;
 		update.rigidBodies = &m_nonStaticRigidBodies[0];
 		int grainSize = 50;  // num of iterations per task for task scheduler
-		btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
+		btParallelFor(0, numBodies, grainSize, update);
+
+		// the manifolds are created in body order, so the manifold array does not depend on the threads
+		for (int i = 0; i < numBodies; ++i)
+		{
+			if (m_bodyFlags[i])
+			{
+				addPredictiveContact(m_nonStaticRigidBodies[i], m_predictiveContactHits[i]);
+			}
+		}
+	}
+}
+
+void btDiscreteDynamicsWorldMt::integrateTransformsExceptCcdInternal(btRigidBody** bodies, int iBegin, int iEnd, btScalar timeStep)
+{
+	btTransform predictedTrans;
+	for (int i = iBegin; i < iEnd; ++i)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+
+		bool needsCcd = false;
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
+			body->predictIntegratedTransform(timeStep, predictedTrans);
+
+			// same condition as in integrateTransformsInternal
+			if (useCcdSweeps() && body->getCcdSquareMotionThreshold() && body->getCollisionShape()->isConvex())
+			{
+				btScalar squareMotion = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length2();
+				needsCcd = body->getCcdSquareMotionThreshold() < squareMotion;
+			}
+			if (!needsCcd)
+			{
+				body->proceedToTransform(predictedTrans);
+			}
+		}
+		m_bodyFlags[i] = needsCcd;
 	}
 }
 
 void btDiscreteDynamicsWorldMt::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
-	if (m_nonStaticRigidBodies.size() > 0)
+	const int numBodies = m_nonStaticRigidBodies.size();
+	if (numBodies > 0)
 	{
+		m_bodyFlags.resizeNoInitialize(numBodies);
 		UpdaterIntegrateTransforms update;
 		update.world = this;
 		update.timeStep = timeStep;
 		update.rigidBodies = &m_nonStaticRigidBodies[0];
 		int grainSize = 50;  // num of iterations per task for task scheduler
-		btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
+		btParallelFor(0, numBodies, grainSize, update);
+
+		// the bodies that need motion clamping sweep against the moved bodies, one by one
+		m_ccdBodies.resize(0);
+		for (int i = 0; i < numBodies; ++i)
+		{
+			if (m_bodyFlags[i])
+			{
+				m_ccdBodies.push_back(m_nonStaticRigidBodies[i]);
+			}
+		}
+		if (m_ccdBodies.size() > 0)
+		{
+			integrateTransformsInternal(&m_ccdBodies[0], m_ccdBodies.size(), timeStep);
+		}
 	}
 }
 
@@ -261,3 +340,13 @@ int btDiscreteDynamicsWorldMt::stepSimulation(btScalar timeStep, int maxSubSteps
 	}
 	return numSubSteps;
 }
+
+void btDiscreteDynamicsWorldMt::setDeterministic(bool deterministic)
+{
+	m_deterministic = deterministic;
+	getDispatchInfo().m_deterministicOverlappingPairs = deterministic;
+	if (m_solverPool && m_constraintSolver == m_solverPool)
+	{
+		m_solverPool->setDeterministic(deterministic);
+	}
+}
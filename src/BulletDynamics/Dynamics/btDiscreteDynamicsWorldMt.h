@@ -54,6 +54,11 @@ public:
 	virtual void reset() BT_OVERRIDE;
 	virtual btConstraintSolverType getSolverType() const BT_OVERRIDE { return m_solverType; }
 
+	///reset the solver before each group, so the result does not depend on which solver of the pool solved the previous groups
+	///(only matters with SOLVER_RANDMIZE_ORDER, where each solver keeps its own random seed)
+	void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+	bool getDeterministic() const { return m_deterministic; }
+
 private:
 	const static size_t kCacheLineSize = 128;
 	struct ThreadSolver
@@ -64,6 +69,7 @@ private:
 	};
 	btAlignedObjectArray<ThreadSolver> m_solvers;
 	btConstraintSolverType m_solverType;
+	bool m_deterministic;
 
 	ThreadSolver* getAndLockThreadSolver();
 	void init(btConstraintSolver** solvers, int numSolvers);
@@ -78,6 +84,15 @@ private:
 ///     - predictUnconstraintMotion
 ///     - integrateTransforms
 ///     - createPredictiveContacts
+///  The predictive contact sweeps run in parallel, but the manifolds are created afterwards in body order.
+///  Bodies that need CCD motion clamping are integrated after all other bodies were moved, one by one in body order,
+///  because their sweeps look at the transforms of the other bodies.
+///  With setUseSpeculativeContacts(true) there are no sweeps, the speculative contacts come from the parallel narrowphase.
+///
+///  With setDeterministic(true) the results are bit-identical for any number of threads (not necessarily identical to
+///  btDiscreteDynamicsWorld though). This also needs a deterministic broadphase, see btDbvtBroadphaseMt::setDeterministic,
+///  the btCollisionDispatcherMt, btSimulationIslandManagerMt and btSequentialImpulseConstraintSolverMt already
+///  produce their manifolds, islands and batches in an order that does not depend on the threads.
 ///
 ATTRIBUTE_ALIGNED16(class)
 btDiscreteDynamicsWorldMt : public btDiscreteDynamicsWorld
@@ -97,9 +112,10 @@ protected:
 
 		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
 		{
-			world->createPredictiveContactsInternal(&rigidBodies[iBegin], iEnd - iBegin, timeStep);
+			world->sweepPredictiveContactsInternal(rigidBodies, iBegin, iEnd, timeStep);
 		}
 	};
+	void sweepPredictiveContactsInternal(btRigidBody * *bodies, int iBegin, int iEnd, btScalar timeStep);  // can be called in parallel
 	virtual void createPredictiveContacts(btScalar timeStep) BT_OVERRIDE;
 
 	struct UpdaterIntegrateTransforms : public btIParallelForBody
@@ -110,11 +126,18 @@ protected:
 
 		void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
 		{
-			world->integrateTransformsInternal(&rigidBodies[iBegin], iEnd - iBegin, timeStep);
+			world->integrateTransformsExceptCcdInternal(rigidBodies, iBegin, iEnd, timeStep);
 		}
 	};
+	void integrateTransformsExceptCcdInternal(btRigidBody * *bodies, int iBegin, int iEnd, btScalar timeStep);  // can be called in parallel
 	virtual void integrateTransforms(btScalar timeStep) BT_OVERRIDE;
 
+	btConstraintSolverPoolMt* m_solverPool;
+	bool m_deterministic;
+	btAlignedObjectArray<PredictiveContactHit> m_predictiveContactHits;  // indexed like m_nonStaticRigidBodies
+	btAlignedObjectArray<char> m_bodyFlags;                              // indexed like m_nonStaticRigidBodies
+	btAlignedObjectArray<btRigidBody*> m_ccdBodies;
+
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
@@ -126,6 +149,13 @@ public:
 	virtual ~btDiscreteDynamicsWorldMt();
 
 	virtual int stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep) BT_OVERRIDE;
+
+	///make the simulation independent of the number of threads, see the class description
+	void setDeterministic(bool deterministic);
+	bool getDeterministic() const
+	{
+		return m_deterministic;
+	}
 };
 
 #endif  //BT_DISCRETE_DYNAMICS_WORLD_H
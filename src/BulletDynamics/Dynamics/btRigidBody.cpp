@@ -84,6 +84,7 @@ void btRigidBody::setupRigidBody(const btRigidBody::btRigidBodyConstructionInfo&
 
 	setCollisionShape(constructionInfo.m_collisionShape);
 	m_debugBodyId = uniqueId++;
+	m_stateIndex = -1;
 
 	setMassProps(constructionInfo.m_mass, constructionInfo.m_localInertia);
 	updateInertiaTensor();
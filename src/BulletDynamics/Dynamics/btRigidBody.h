@@ -92,6 +92,11 @@ class btRigidBody : public btCollisionObject
 
 	int m_debugBodyId;
 
+	//handle of the body in the btRigidBodyStateSoA of its world, -1 if the world doesn't use one
+	int m_stateIndex;
+
+	friend class btRigidBodyStateSoA;
+
 protected:
 	ATTRIBUTE_ALIGNED16(btVector3 m_deltaLinearVelocity);
 	btVector3 m_deltaAngularVelocity;
@@ -610,6 +615,12 @@ public:
 		return m_rigidbodyFlags;
 	}
 
+	///index of the body in the btRigidBodyStateSoA of its world, or -1. A deleted world leaves the index of its bodies unchanged.
+	int getStateIndex() const
+	{
+		return m_stateIndex;
+	}
+
 	///perform implicit force computation in world space
 	btVector3 computeGyroscopicImpulseImplicit_World(btScalar dt) const;
 
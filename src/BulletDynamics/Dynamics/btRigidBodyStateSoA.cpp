@@ -0,0 +1,428 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btRigidBodyStateSoA.h"
+#include "btRigidBody.h"
+#include "LinearMath/btTransformUtil.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btSoAReal.h"
+
+///the bodies are separate allocations, the hardware prefetcher doesn't see this access pattern
+void btRigidBodyStateSoA::prefetchBody(const btRigidBody* body)
+{
+#if BT_SOA_WIDTH > 1
+	const char* p = (const char*)body;
+	for (int offset = 0; offset < int(sizeof(btRigidBody)); offset += 64)
+	{
+		_mm_prefetch(p + offset, _MM_HINT_T0);
+	}
+#else
+	(void)body;
+#endif
+}
+
+btRigidBodyStateSoA::btRigidBodyStateSoA()
+	: m_dampingTimeStep(0)
+{
+	m_laneBodies.resize(LANES_PER_CHUNK);
+	m_laneData.resize(NUM_COMPONENTS * LANES_PER_CHUNK);
+}
+
+void btRigidBodyStateSoA::addRigidBody(btRigidBody* body)
+{
+	//a body that was in a deleted world keeps its old index, only a body that is already in this store is an error
+	const int stateIndex = body->m_stateIndex;
+	btAssert(stateIndex < 0 || stateIndex >= m_bodies.size() || m_bodies[stateIndex] != body);
+	(void)stateIndex;
+	body->m_stateIndex = m_bodies.size();
+	m_bodies.push_back(body);
+	DampingCache cache;
+	cache.m_linearDamping = btScalar(-1);
+	cache.m_angularDamping = btScalar(-1);
+	cache.m_linearFactor = btScalar(1);
+	cache.m_angularFactor = btScalar(1);
+	m_dampingCache.push_back(cache);
+}
+
+void btRigidBodyStateSoA::removeRigidBody(btRigidBody* body)
+{
+	int stateIndex = body->m_stateIndex;
+	if (stateIndex < 0 || stateIndex >= m_bodies.size() || m_bodies[stateIndex] != body)
+	{
+		return;
+	}
+	int last = m_bodies.size() - 1;
+	m_bodies[stateIndex] = m_bodies[last];
+	m_bodies[stateIndex]->m_stateIndex = stateIndex;
+	m_dampingCache[stateIndex] = m_dampingCache[last];
+	m_bodies.pop_back();
+	m_dampingCache.pop_back();
+	body->m_stateIndex = -1;
+}
+
+void btRigidBodyStateSoA::updateDampingFactors(int stateIndex, btScalar timeStep)
+{
+	const btRigidBody* body = m_bodies[stateIndex];
+	DampingCache& cache = m_dampingCache[stateIndex];
+	if (cache.m_linearDamping != body->m_linearDamping)
+	{
+		cache.m_linearDamping = body->m_linearDamping;
+#ifdef BT_USE_OLD_DAMPING_METHOD
+		cache.m_linearFactor = btMax((btScalar(1.0) - timeStep * cache.m_linearDamping), btScalar(0.0));
+#else
+		cache.m_linearFactor = btPow(btScalar(1) - cache.m_linearDamping, timeStep);
+#endif
+	}
+	if (cache.m_angularDamping != body->m_angularDamping)
+	{
+		cache.m_angularDamping = body->m_angularDamping;
+#ifdef BT_USE_OLD_DAMPING_METHOD
+		cache.m_angularFactor = btMax((btScalar(1.0) - timeStep * cache.m_angularDamping), btScalar(0.0));
+#else
+		cache.m_angularFactor = btPow(btScalar(1) - cache.m_angularDamping, timeStep);
+#endif
+	}
+}
+
+void btRigidBodyStateSoA::gatherLane(int lane, const btRigidBody* body, btScalar timeStep, bool damping)
+{
+	btScalar* c = &m_laneData[lane];
+	const btTransform& tr = body->getWorldTransform();
+	const btMatrix3x3& basis = tr.getBasis();
+	c[ORIGIN_X * LANES_PER_CHUNK] = tr.getOrigin().x();
+	c[ORIGIN_Y * LANES_PER_CHUNK] = tr.getOrigin().y();
+	c[ORIGIN_Z * LANES_PER_CHUNK] = tr.getOrigin().z();
+	for (int r = 0; r < 3; r++)
+	{
+		c[(BASIS_00 + 3 * r) * LANES_PER_CHUNK] = basis[r].x();
+		c[(BASIS_01 + 3 * r) * LANES_PER_CHUNK] = basis[r].y();
+		c[(BASIS_02 + 3 * r) * LANES_PER_CHUNK] = basis[r].z();
+	}
+	c[LINVEL_X * LANES_PER_CHUNK] = body->m_linearVelocity.x();
+	c[LINVEL_Y * LANES_PER_CHUNK] = body->m_linearVelocity.y();
+	c[LINVEL_Z * LANES_PER_CHUNK] = body->m_linearVelocity.z();
+	c[ANGVEL_X * LANES_PER_CHUNK] = body->m_angularVelocity.x();
+	c[ANGVEL_Y * LANES_PER_CHUNK] = body->m_angularVelocity.y();
+	c[ANGVEL_Z * LANES_PER_CHUNK] = body->m_angularVelocity.z();
+	c[INV_INERTIA_LOCAL_X * LANES_PER_CHUNK] = body->m_invInertiaLocal.x();
+	c[INV_INERTIA_LOCAL_Y * LANES_PER_CHUNK] = body->m_invInertiaLocal.y();
+	c[INV_INERTIA_LOCAL_Z * LANES_PER_CHUNK] = body->m_invInertiaLocal.z();
+	if (damping)
+	{
+		updateDampingFactors(body->m_stateIndex, timeStep);
+		const DampingCache& cache = m_dampingCache[body->m_stateIndex];
+		c[LINEAR_DAMPING_FACTOR * LANES_PER_CHUNK] = cache.m_linearFactor;
+		c[ANGULAR_DAMPING_FACTOR * LANES_PER_CHUNK] = cache.m_angularFactor;
+	}
+	m_laneBodies[lane] = const_cast<btRigidBody*>(body);
+}
+
+///integrates BT_SOA_WIDTH bodies per iteration, the same math as btTransformUtil::integrateTransform (exponential map)
+void btRigidBodyStateSoA::integrateLanes(int numLanes, btScalar timeStep, bool damping, bool inertia)
+{
+	btScalar* c[NUM_COMPONENTS];
+	for (int k = 0; k < NUM_COMPONENTS; k++)
+	{
+		c[k] = getComponent(k);
+	}
+
+	//padding lanes: a resting body with identity orientation
+	int numPaddedLanes = (numLanes + BT_SOA_WIDTH - 1) / BT_SOA_WIDTH * BT_SOA_WIDTH;
+	for (int i = numLanes; i < numPaddedLanes; i++)
+	{
+		for (int k = 0; k < NUM_COMPONENTS; k++)
+		{
+			c[k][i] = btScalar(0);
+		}
+		c[BASIS_00][i] = btScalar(1);
+		c[BASIS_11][i] = btScalar(1);
+		c[BASIS_22][i] = btScalar(1);
+		c[LINEAR_DAMPING_FACTOR][i] = btScalar(1);
+		c[ANGULAR_DAMPING_FACTOR][i] = btScalar(1);
+	}
+
+	const btSoAReal dt(timeStep);
+	const btSoAReal halfDt(btScalar(0.5) * timeStep);
+	const btSoAReal maxAngle(ANGULAR_MOTION_THRESHOLD / timeStep);
+	const btSoAReal epsilon(SIMD_EPSILON);
+	const btSoAReal zero(btScalar(0));
+	const btSoAReal one(btScalar(1));
+	const btSoAReal two(btScalar(2));
+
+	for (int i = 0; i < numPaddedLanes; i += BT_SOA_WIDTH)
+	{
+		btSoAReal vx = btSoAReal::load(c[LINVEL_X] + i);
+		btSoAReal vy = btSoAReal::load(c[LINVEL_Y] + i);
+		btSoAReal vz = btSoAReal::load(c[LINVEL_Z] + i);
+		btSoAReal wx = btSoAReal::load(c[ANGVEL_X] + i);
+		btSoAReal wy = btSoAReal::load(c[ANGVEL_Y] + i);
+		btSoAReal wz = btSoAReal::load(c[ANGVEL_Z] + i);
+		if (damping)
+		{
+			btSoAReal linearFactor = btSoAReal::load(c[LINEAR_DAMPING_FACTOR] + i);
+			btSoAReal angularFactor = btSoAReal::load(c[ANGULAR_DAMPING_FACTOR] + i);
+			vx = vx * linearFactor;
+			vy = vy * linearFactor;
+			vz = vz * linearFactor;
+			wx = wx * angularFactor;
+			wy = wy * angularFactor;
+			wz = wz * angularFactor;
+			vx.store(c[LINVEL_X] + i);
+			vy.store(c[LINVEL_Y] + i);
+			vz.store(c[LINVEL_Z] + i);
+			wx.store(c[ANGVEL_X] + i);
+			wy.store(c[ANGVEL_Y] + i);
+			wz.store(c[ANGVEL_Z] + i);
+		}
+
+		(btSoAReal::load(c[ORIGIN_X] + i) + vx * dt).store(c[ORIGIN_X] + i);
+		(btSoAReal::load(c[ORIGIN_Y] + i) + vy * dt).store(c[ORIGIN_Y] + i);
+		(btSoAReal::load(c[ORIGIN_Z] + i) + vz * dt).store(c[ORIGIN_Z] + i);
+
+		btSoAReal m00 = btSoAReal::load(c[BASIS_00] + i);
+		btSoAReal m01 = btSoAReal::load(c[BASIS_01] + i);
+		btSoAReal m02 = btSoAReal::load(c[BASIS_02] + i);
+		btSoAReal m10 = btSoAReal::load(c[BASIS_10] + i);
+		btSoAReal m11 = btSoAReal::load(c[BASIS_11] + i);
+		btSoAReal m12 = btSoAReal::load(c[BASIS_12] + i);
+		btSoAReal m20 = btSoAReal::load(c[BASIS_20] + i);
+		btSoAReal m21 = btSoAReal::load(c[BASIS_21] + i);
+		btSoAReal m22 = btSoAReal::load(c[BASIS_22] + i);
+
+		//orientation of the basis, see btMatrix3x3::getRotation. The largest of 4w^2, 4x^2, 4y^2, 4z^2 is the pivot.
+		//the quaternion is scaled by 4 * pivot instead of normalized, the conversion back to a matrix divides by its length
+		btSoAReal t0 = one + m00 + m11 + m22;
+		btSoAReal t1 = one + m00 - m11 - m22;
+		btSoAReal t2 = one - m00 + m11 - m22;
+		btSoAReal t3 = one - m00 - m11 + m22;
+		btSoAReal a = m21 - m12;
+		btSoAReal b = m02 - m20;
+		btSoAReal d = m10 - m01;
+		btSoAReal e = m01 + m10;
+		btSoAReal f = m02 + m20;
+		btSoAReal g = m12 + m21;
+
+		btSoAReal qx = a, qy = b, qz = d, qw = t0;
+		btSoAReal pivot = t0;
+		qx = btSoASelectGreater(t1, pivot, t1, qx);
+		qy = btSoASelectGreater(t1, pivot, e, qy);
+		qz = btSoASelectGreater(t1, pivot, f, qz);
+		qw = btSoASelectGreater(t1, pivot, a, qw);
+		pivot = btSoAMax(pivot, t1);
+		qx = btSoASelectGreater(t2, pivot, e, qx);
+		qy = btSoASelectGreater(t2, pivot, t2, qy);
+		qz = btSoASelectGreater(t2, pivot, g, qz);
+		qw = btSoASelectGreater(t2, pivot, b, qw);
+		pivot = btSoAMax(pivot, t2);
+		qx = btSoASelectGreater(t3, pivot, f, qx);
+		qy = btSoASelectGreater(t3, pivot, g, qy);
+		qz = btSoASelectGreater(t3, pivot, t3, qz);
+		qw = btSoASelectGreater(t3, pivot, d, qw);
+
+		//exponential map, see btTransformUtil::integrateTransform. The clamped half angle is at most
+		//ANGULAR_MOTION_THRESHOLD/2, where the Taylor series of sin(h)/h and cos(h) up to h^8 are exact in single precision
+		btSoAReal angle2 = wx * wx + wy * wy + wz * wz;
+		btSoAReal angle = btSoASelectGreater(angle2, epsilon, btSoASqrt(angle2), zero);
+		angle = btSoAMin(angle, maxAngle);
+		btSoAReal h = angle * halfDt;
+		btSoAReal h2 = h * h;
+		btSoAReal sinc = one - h2 * btSoAReal(btScalar(1. / 6.)) * (one - h2 * btSoAReal(btScalar(1. / 20.)) * (one - h2 * btSoAReal(btScalar(1. / 42.)) * (one - h2 * btSoAReal(btScalar(1. / 72.)))));
+		btSoAReal cosine = one - h2 * btSoAReal(btScalar(1. / 2.)) * (one - h2 * btSoAReal(btScalar(1. / 12.)) * (one - h2 * btSoAReal(btScalar(1. / 30.)) * (one - h2 * btSoAReal(btScalar(1. / 56.)))));
+		btSoAReal scale = halfDt * sinc;
+		btSoAReal dx = wx * scale;
+		btSoAReal dy = wy * scale;
+		btSoAReal dz = wz * scale;
+		btSoAReal dw = cosine;
+
+		//dorn * orn0
+		btSoAReal px = dw * qx + dx * qw + dy * qz - dz * qy;
+		btSoAReal py = dw * qy + dy * qw + dz * qx - dx * qz;
+		btSoAReal pz = dw * qz + dz * qw + dx * qy - dy * qx;
+		btSoAReal pw = dw * qw - dx * qx - dy * qy - dz * qz;
+
+		//btMatrix3x3::setRotation
+		btSoAReal s = two / (px * px + py * py + pz * pz + pw * pw);
+		btSoAReal xs = px * s, ys = py * s, zs = pz * s;
+		btSoAReal wxs = pw * xs, wys = pw * ys, wzs = pw * zs;
+		btSoAReal xxs = px * xs, xys = px * ys, xzs = px * zs;
+		btSoAReal yys = py * ys, yzs = py * zs, zzs = pz * zs;
+		m00 = one - (yys + zzs);
+		m01 = xys - wzs;
+		m02 = xzs + wys;
+		m10 = xys + wzs;
+		m11 = one - (xxs + zzs);
+		m12 = yzs - wxs;
+		m20 = xzs - wys;
+		m21 = yzs + wxs;
+		m22 = one - (xxs + yys);
+		m00.store(c[BASIS_00] + i);
+		m01.store(c[BASIS_01] + i);
+		m02.store(c[BASIS_02] + i);
+		m10.store(c[BASIS_10] + i);
+		m11.store(c[BASIS_11] + i);
+		m12.store(c[BASIS_12] + i);
+		m20.store(c[BASIS_20] + i);
+		m21.store(c[BASIS_21] + i);
+		m22.store(c[BASIS_22] + i);
+
+		if (inertia)
+		{
+			//basis.scaled(invInertiaLocal) * basis.transpose(), see btRigidBody::updateInertiaTensor
+			btSoAReal i0 = btSoAReal::load(c[INV_INERTIA_LOCAL_X] + i);
+			btSoAReal i1 = btSoAReal::load(c[INV_INERTIA_LOCAL_Y] + i);
+			btSoAReal i2 = btSoAReal::load(c[INV_INERTIA_LOCAL_Z] + i);
+			btSoAReal s00 = m00 * i0, s01 = m01 * i1, s02 = m02 * i2;
+			btSoAReal s10 = m10 * i0, s11 = m11 * i1, s12 = m12 * i2;
+			(s00 * m00 + s01 * m01 + s02 * m02).store(c[INV_INERTIA_WORLD_00] + i);
+			(s00 * m10 + s01 * m11 + s02 * m12).store(c[INV_INERTIA_WORLD_01] + i);
+			(s00 * m20 + s01 * m21 + s02 * m22).store(c[INV_INERTIA_WORLD_02] + i);
+			(s10 * m10 + s11 * m11 + s12 * m12).store(c[INV_INERTIA_WORLD_11] + i);
+			(s10 * m20 + s11 * m21 + s12 * m22).store(c[INV_INERTIA_WORLD_12] + i);
+			(m20 * i0 * m20 + m21 * i1 * m21 + m22 * i2 * m22).store(c[INV_INERTIA_WORLD_22] + i);
+		}
+	}
+}
+
+void btRigidBodyStateSoA::writeInterpolationTransforms(int numLanes)
+{
+	const btScalar* c[NUM_COMPONENTS];
+	for (int k = 0; k < NUM_COMPONENTS; k++)
+	{
+		c[k] = getComponent(k);
+	}
+	for (int i = 0; i < numLanes; i++)
+	{
+		btRigidBody* body = m_laneBodies[i];
+		body->m_linearVelocity.setValue(c[LINVEL_X][i], c[LINVEL_Y][i], c[LINVEL_Z][i]);
+		body->m_angularVelocity.setValue(c[ANGVEL_X][i], c[ANGVEL_Y][i], c[ANGVEL_Z][i]);
+		btTransform& tr = body->getInterpolationWorldTransform();
+		tr.getOrigin().setValue(c[ORIGIN_X][i], c[ORIGIN_Y][i], c[ORIGIN_Z][i]);
+		tr.getBasis().setValue(c[BASIS_00][i], c[BASIS_01][i], c[BASIS_02][i],
+							   c[BASIS_10][i], c[BASIS_11][i], c[BASIS_12][i],
+							   c[BASIS_20][i], c[BASIS_21][i], c[BASIS_22][i]);
+	}
+}
+
+void btRigidBodyStateSoA::writeTransforms(int numLanes, bool useContinuous, btAlignedObjectArray<btRigidBody*>& ccdBodies)
+{
+	const btScalar* c[NUM_COMPONENTS];
+	for (int k = 0; k < NUM_COMPONENTS; k++)
+	{
+		c[k] = getComponent(k);
+	}
+	for (int i = 0; i < numLanes; i++)
+	{
+		btRigidBody* body = m_laneBodies[i];
+		btTransform& tr = body->getWorldTransform();
+		btVector3 origin(c[ORIGIN_X][i], c[ORIGIN_Y][i], c[ORIGIN_Z][i]);
+		if (useContinuous)
+		{
+			btScalar squareMotion = (origin - tr.getOrigin()).length2();
+			if (body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+			{
+				ccdBodies.push_back(body);
+				continue;
+			}
+		}
+		//btRigidBody::proceedToTransform
+		tr.setOrigin(origin);
+		tr.getBasis().setValue(c[BASIS_00][i], c[BASIS_01][i], c[BASIS_02][i],
+							   c[BASIS_10][i], c[BASIS_11][i], c[BASIS_12][i],
+							   c[BASIS_20][i], c[BASIS_21][i], c[BASIS_22][i]);
+		body->getInterpolationWorldTransform() = tr;
+		body->m_interpolationLinearVelocity = body->m_linearVelocity;
+		body->m_interpolationAngularVelocity = body->m_angularVelocity;
+		body->m_invInertiaTensorWorld.setValue(c[INV_INERTIA_WORLD_00][i], c[INV_INERTIA_WORLD_01][i], c[INV_INERTIA_WORLD_02][i],
+											   c[INV_INERTIA_WORLD_01][i], c[INV_INERTIA_WORLD_11][i], c[INV_INERTIA_WORLD_12][i],
+											   c[INV_INERTIA_WORLD_02][i], c[INV_INERTIA_WORLD_12][i], c[INV_INERTIA_WORLD_22][i]);
+	}
+}
+
+void btRigidBodyStateSoA::predictUnconstraintMotion(btScalar timeStep)
+{
+	BT_PROFILE("btRigidBodyStateSoA::predictUnconstraintMotion");
+	if (timeStep != m_dampingTimeStep)
+	{
+		m_dampingTimeStep = timeStep;
+		for (int i = 0; i < m_dampingCache.size(); i++)
+		{
+			m_dampingCache[i].m_linearDamping = btScalar(-1);
+			m_dampingCache[i].m_angularDamping = btScalar(-1);
+		}
+	}
+
+	int numLanes = 0;
+	for (int i = 0; i < m_bodies.size(); i++)
+	{
+		if (i + BODY_PREFETCH_DISTANCE < m_bodies.size())
+		{
+			prefetchBody(m_bodies[i + BODY_PREFETCH_DISTANCE]);
+		}
+		btRigidBody* body = m_bodies[i];
+		if (body->isStaticOrKinematicObject())
+		{
+			continue;
+		}
+		if (body->m_additionalDamping)
+		{
+			body->applyDamping(timeStep);
+			body->predictIntegratedTransform(timeStep, body->getInterpolationWorldTransform());
+			continue;
+		}
+		gatherLane(numLanes++, body, timeStep, true);
+		if (numLanes == LANES_PER_CHUNK)
+		{
+			integrateLanes(numLanes, timeStep, true, false);
+			writeInterpolationTransforms(numLanes);
+			numLanes = 0;
+		}
+	}
+	if (numLanes)
+	{
+		integrateLanes(numLanes, timeStep, true, false);
+		writeInterpolationTransforms(numLanes);
+	}
+}
+
+void btRigidBodyStateSoA::integrateTransforms(btScalar timeStep, bool useContinuous, btAlignedObjectArray<btRigidBody*>& ccdBodies)
+{
+	BT_PROFILE("btRigidBodyStateSoA::integrateTransforms");
+	int numLanes = 0;
+	for (int i = 0; i < m_bodies.size(); i++)
+	{
+		if (i + BODY_PREFETCH_DISTANCE < m_bodies.size())
+		{
+			prefetchBody(m_bodies[i + BODY_PREFETCH_DISTANCE]);
+		}
+		btRigidBody* body = m_bodies[i];
+		body->setHitFraction(1.f);
+		if (!body->isActive() || body->isStaticOrKinematicObject())
+		{
+			continue;
+		}
+		gatherLane(numLanes++, body, timeStep, false);
+		if (numLanes == LANES_PER_CHUNK)
+		{
+			integrateLanes(numLanes, timeStep, false, true);
+			writeTransforms(numLanes, useContinuous, ccdBodies);
+			numLanes = 0;
+		}
+	}
+	if (numLanes)
+	{
+		integrateLanes(numLanes, timeStep, false, true);
+		writeTransforms(numLanes, useContinuous, ccdBodies);
+	}
+}
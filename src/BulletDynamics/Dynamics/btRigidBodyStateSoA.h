@@ -0,0 +1,134 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RIGID_BODY_STATE_SOA_H
+#define BT_RIGID_BODY_STATE_SOA_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btScalar.h"
+
+class btRigidBody;
+
+///
+/// btRigidBodyStateSoA -- structure-of-arrays state store used by btDiscreteDynamicsWorld to integrate its
+///                        non-static rigid bodies with SIMD kernels, see btDiscreteDynamicsWorld::setUseSoAIntegration.
+///
+///  Each body added to the store gets a handle (btRigidBody::getStateIndex). In predictUnconstraintMotion and
+///  integrateTransforms the transforms, velocities and inverse local inertia of the bodies that need integration
+///  are gathered in chunks of LANES_PER_CHUNK bodies into one array per component, integrated a full SIMD register
+///  of bodies at a time, and written back while the bodies are still in the cache.
+///  The btRigidBody remains the owner of its state, so the rest of the pipeline and the user API are unchanged.
+///
+///  The kernels use 8 lanes when compiled with AVX, 4 lanes with SSE and plain scalar code otherwise (or with double precision).
+///  The results match btRigidBody::applyDamping and btRigidBody::predictIntegratedTransform up to floating point rounding.
+///  Bodies with additional damping are integrated with the regular btRigidBody code.
+///
+class btRigidBodyStateSoA
+{
+	enum Component
+	{
+		ORIGIN_X,
+		ORIGIN_Y,
+		ORIGIN_Z,
+		BASIS_00,
+		BASIS_01,
+		BASIS_02,
+		BASIS_10,
+		BASIS_11,
+		BASIS_12,
+		BASIS_20,
+		BASIS_21,
+		BASIS_22,
+		LINVEL_X,
+		LINVEL_Y,
+		LINVEL_Z,
+		ANGVEL_X,
+		ANGVEL_Y,
+		ANGVEL_Z,
+		INV_INERTIA_LOCAL_X,
+		INV_INERTIA_LOCAL_Y,
+		INV_INERTIA_LOCAL_Z,
+		LINEAR_DAMPING_FACTOR,
+		ANGULAR_DAMPING_FACTOR,
+		INV_INERTIA_WORLD_00,
+		INV_INERTIA_WORLD_01,
+		INV_INERTIA_WORLD_02,
+		INV_INERTIA_WORLD_11,
+		INV_INERTIA_WORLD_12,
+		INV_INERTIA_WORLD_22,
+		NUM_COMPONENTS
+	};
+
+	enum
+	{
+		LANES_PER_CHUNK = 256,
+		BODY_PREFETCH_DISTANCE = 8
+	};
+
+	struct DampingCache
+	{
+		btScalar m_linearDamping;
+		btScalar m_angularDamping;
+		btScalar m_linearFactor;
+		btScalar m_angularFactor;
+	};
+
+	btAlignedObjectArray<btRigidBody*> m_bodies;        // indexed by btRigidBody::getStateIndex
+	btAlignedObjectArray<DampingCache> m_dampingCache;  // indexed by btRigidBody::getStateIndex
+	btScalar m_dampingTimeStep;
+
+	btAlignedObjectArray<btRigidBody*> m_laneBodies;  // LANES_PER_CHUNK
+	btAlignedObjectArray<btScalar> m_laneData;       // NUM_COMPONENTS arrays of LANES_PER_CHUNK scalars
+
+	btScalar* getComponent(int component)
+	{
+		return &m_laneData[component * LANES_PER_CHUNK];
+	}
+
+	static void prefetchBody(const btRigidBody* body);
+	void updateDampingFactors(int stateIndex, btScalar timeStep);
+	void gatherLane(int lane, const btRigidBody* body, btScalar timeStep, bool damping);
+	void integrateLanes(int numLanes, btScalar timeStep, bool damping, bool inertia);
+	void writeInterpolationTransforms(int numLanes);
+	void writeTransforms(int numLanes, bool useContinuous, btAlignedObjectArray<btRigidBody*>& ccdBodies);
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btRigidBodyStateSoA();
+
+	void addRigidBody(btRigidBody* body);
+	///swaps the last body into the slot of the removed body, its handle changes
+	void removeRigidBody(btRigidBody* body);
+
+	int getNumBodies() const
+	{
+		return m_bodies.size();
+	}
+	btRigidBody* getRigidBody(int stateIndex)
+	{
+		return m_bodies[stateIndex];
+	}
+
+	///applyDamping and predictIntegratedTransform into the interpolation world transform, for all dynamic bodies
+	void predictUnconstraintMotion(btScalar timeStep);
+
+	///integrates the active dynamic bodies and moves them to their predicted transform, with the same hit fraction
+	///handling as btDiscreteDynamicsWorld::integrateTransformsInternal.
+	///when useContinuous is set, bodies whose motion exceeds their ccd threshold are not moved but added to ccdBodies.
+	void integrateTransforms(btScalar timeStep, bool useContinuous, btAlignedObjectArray<btRigidBody*>& ccdBodies);
+};
+
+#endif  //BT_RIGID_BODY_STATE_SOA_H
@@ -48,6 +48,19 @@ protected:
 
 	virtual void calculateSimulationIslands();
 	virtual void updateActivationState(btScalar timeStep);
+	virtual void stepMultiBodyVelocities(btContactSolverInfo& solverInfo);
+
+	static bool isMultiBodySleeping(const btMultiBody* bod);
+
+	///the per-multibody work of a simulation step, on a range of multibodies and with the given scratch memory (see btMultiBodyDynamicsWorldMt)
+	void stepMultiBodyVelocitiesInternal(btMultiBody** bodies, int numBodies, const btContactSolverInfo& solverInfo,
+										 btAlignedObjectArray<btScalar>& scratch_r, btAlignedObjectArray<btVector3>& scratch_v, btAlignedObjectArray<btMatrix3x3>& scratch_m);
+	void computeMultiBodyJointFeedbackInternal(btMultiBody** bodies, int numBodies, const btContactSolverInfo& solverInfo,
+											   btAlignedObjectArray<btScalar>& scratch_r, btAlignedObjectArray<btVector3>& scratch_v, btAlignedObjectArray<btMatrix3x3>& scratch_m);
+	void integrateMultiBodyTransformsInternal(btMultiBody** bodies, int numBodies, btScalar timeStep,
+											  btAlignedObjectArray<btQuaternion>& world_to_local, btAlignedObjectArray<btVector3>& local_origin);
+	void predictMultiBodyTransformsInternal(btMultiBody** bodies, int numBodies, btScalar timeStep,
+											btAlignedObjectArray<btQuaternion>& world_to_local, btAlignedObjectArray<btVector3>& local_origin);
 	
 
 	virtual void serializeMultiBodies(btSerializer* serializer);
@@ -98,15 +111,15 @@ public:
 	virtual void removeMultiBodyConstraint(btMultiBodyConstraint* constraint);
 
 	virtual void integrateTransforms(btScalar timeStep);
-    void integrateMultiBodyTransforms(btScalar timeStep);
-    void predictMultiBodyTransforms(btScalar timeStep);
+    virtual void integrateMultiBodyTransforms(btScalar timeStep);
+    virtual void predictMultiBodyTransforms(btScalar timeStep);
     
     virtual void predictUnconstraintMotion(btScalar timeStep);
 	virtual void debugDrawWorld();
 
 	virtual void debugDrawMultiBodyConstraint(btMultiBodyConstraint* constraint);
 
-	void forwardKinematics();
+	virtual void forwardKinematics();
 	virtual void clearForces();
 	virtual void clearMultiBodyConstraintForces();
 	virtual void clearMultiBodyForces();
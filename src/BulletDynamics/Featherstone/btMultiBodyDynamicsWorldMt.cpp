@@ -0,0 +1,419 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMultiBodyDynamicsWorldMt.h"
+#include "btMultiBodyConstraintSolver.h"
+#include "btMultiBody.h"
+#include "btMultiBodyLinkCollider.h"
+#include "btMultiBodyConstraint.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "LinearMath/btQuickprof.h"
+
+///num of multibodies per task for the task scheduler, a multibody is a lot more work than a rigid body
+static const int s_multiBodyGrainSize = 4;
+
+///
+/// IslandBatch -- the bodies, manifolds and constraints of one or more islands, solved by a single solver
+///
+struct btMultiBodyDynamicsWorldMt::IslandBatch
+{
+	btAlignedObjectArray<btCollisionObject*> m_bodies;
+	btAlignedObjectArray<btPersistentManifold*> m_manifolds;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<btMultiBodyConstraint*> m_multiBodyConstraints;
+	btSolverAnalyticsData m_analyticsData;
+	int m_islandId;
+
+	void solve(btMultiBodyConstraintSolver* solver, const btContactSolverInfo& solverInfo, btIDebugDraw* debugDrawer, btDispatcher* dispatcher)
+	{
+		btCollisionObject** bodies = m_bodies.size() ? &m_bodies[0] : 0;
+		btPersistentManifold** manifolds = m_manifolds.size() ? &m_manifolds[0] : 0;
+		btTypedConstraint** constraints = m_constraints.size() ? &m_constraints[0] : 0;
+		btMultiBodyConstraint** multiBodyConstraints = m_multiBodyConstraints.size() ? &m_multiBodyConstraints[0] : 0;
+		solver->solveMultiBodyGroup(bodies, m_bodies.size(), manifolds, m_manifolds.size(), constraints, m_constraints.size(), multiBodyConstraints, m_multiBodyConstraints.size(), solverInfo, debugDrawer, dispatcher);
+		if (solverInfo.m_reportSolverAnalytics & 1)
+		{
+			solver->m_analyticsData.m_islandId = m_islandId;
+			m_analyticsData = solver->m_analyticsData;
+		}
+	}
+};
+
+///
+/// IslandBatchCallback -- batches the islands like MultiBodyInplaceSolverIslandCallback, but collects the batches instead of solving them
+///
+struct btMultiBodyDynamicsWorldMt::IslandBatchCallback : public MultiBodyInplaceSolverIslandCallback
+{
+	btAlignedObjectArray<IslandBatch*> m_batches;  // reused from step to step
+	int m_numBatches;
+
+	IslandBatchCallback(btMultiBodyConstraintSolver* solver, btDispatcher* dispatcher)
+		: MultiBodyInplaceSolverIslandCallback(solver, dispatcher),
+		  m_numBatches(0)
+	{
+	}
+
+	virtual ~IslandBatchCallback()
+	{
+		for (int i = 0; i < m_batches.size(); i++)
+		{
+			delete m_batches[i];
+		}
+	}
+
+	virtual void setup(btContactSolverInfo* solverInfo, btTypedConstraint** sortedConstraints, int numConstraints, btMultiBodyConstraint** sortedMultiBodyConstraints, int numMultiBodyConstraints, btIDebugDraw* debugDrawer) BT_OVERRIDE
+	{
+		MultiBodyInplaceSolverIslandCallback::setup(solverInfo, sortedConstraints, numConstraints, sortedMultiBodyConstraints, numMultiBodyConstraints, debugDrawer);
+		m_numBatches = 0;
+	}
+
+	virtual void processConstraints(int islandId = -1) BT_OVERRIDE
+	{
+		if (m_bodies.size() || m_manifolds.size() || m_constraints.size() || m_multiBodyConstraints.size())
+		{
+			if (m_numBatches == m_batches.size())
+			{
+				m_batches.push_back(new IslandBatch());
+			}
+			IslandBatch* batch = m_batches[m_numBatches++];
+			batch->m_bodies.copyFromArray(m_bodies);
+			batch->m_manifolds.copyFromArray(m_manifolds);
+			batch->m_constraints.copyFromArray(m_constraints);
+			batch->m_multiBodyConstraints.copyFromArray(m_multiBodyConstraints);
+			batch->m_islandId = islandId;
+		}
+		m_bodies.resize(0);
+		m_softBodies.resize(0);
+		m_manifolds.resize(0);
+		m_constraints.resize(0);
+		m_multiBodyConstraints.resize(0);
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterForwardKinematics : public btIParallelForBody
+{
+	btMultiBody** m_multiBodies;
+	btMultiBodyDynamicsWorldMt* m_world;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		ThreadScratch& scratch = m_world->getThreadScratch();
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			m_multiBodies[i]->forwardKinematics(scratch.m_worldToLocal, scratch.m_localOrigin);
+		}
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterStepVelocities : public btIParallelForBody
+{
+	btMultiBody** m_multiBodies;
+	const btContactSolverInfo* m_solverInfo;
+	btMultiBodyDynamicsWorldMt* m_world;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		ThreadScratch& scratch = m_world->getThreadScratch();
+		m_world->stepMultiBodyVelocitiesInternal(&m_multiBodies[iBegin], iEnd - iBegin, *m_solverInfo, scratch.m_r, scratch.m_v, scratch.m_m);
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterJointFeedback : public btIParallelForBody
+{
+	btMultiBody** m_multiBodies;
+	const btContactSolverInfo* m_solverInfo;
+	btMultiBodyDynamicsWorldMt* m_world;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		ThreadScratch& scratch = m_world->getThreadScratch();
+		m_world->computeMultiBodyJointFeedbackInternal(&m_multiBodies[iBegin], iEnd - iBegin, *m_solverInfo, scratch.m_r, scratch.m_v, scratch.m_m);
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterProcessDeltaVee : public btIParallelForBody
+{
+	btMultiBody** m_multiBodies;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			m_multiBodies[i]->processDeltaVeeMultiDof2();
+		}
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterIntegrateTransforms : public btIParallelForBody
+{
+	btMultiBody** m_multiBodies;
+	btScalar m_timeStep;
+	btMultiBodyDynamicsWorldMt* m_world;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		ThreadScratch& scratch = m_world->getThreadScratch();
+		m_world->integrateMultiBodyTransformsInternal(&m_multiBodies[iBegin], iEnd - iBegin, m_timeStep, scratch.m_worldToLocal, scratch.m_localOrigin);
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterPredictTransforms : public btIParallelForBody
+{
+	btMultiBody** m_multiBodies;
+	btScalar m_timeStep;
+	btMultiBodyDynamicsWorldMt* m_world;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		ThreadScratch& scratch = m_world->getThreadScratch();
+		m_world->predictMultiBodyTransformsInternal(&m_multiBodies[iBegin], iEnd - iBegin, m_timeStep, scratch.m_worldToLocal, scratch.m_localOrigin);
+	}
+};
+
+struct btMultiBodyDynamicsWorldMt::UpdaterSolveIslandBatches : public btIParallelForBody
+{
+	IslandBatch** m_batches;
+	const btContactSolverInfo* m_solverInfo;
+	btMultiBodyDynamicsWorldMt* m_world;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			ThreadSolver* ts = m_world->getAndLockThreadSolver();
+			m_batches[i]->solve(ts->m_solver, *m_solverInfo, m_world->getDebugDrawer(), m_world->getDispatcher());
+			ts->m_mutex.unlock();
+		}
+	}
+};
+
+btMultiBodyDynamicsWorldMt::btMultiBodyDynamicsWorldMt(btDispatcher* dispatcher,
+													   btBroadphaseInterface* pairCache,
+													   btMultiBodyConstraintSolver* constraintSolver,
+													   btMultiBodyConstraintSolver** solverPool,
+													   int numSolversInPool,
+													   btCollisionConfiguration* collisionConfiguration)
+	: btMultiBodyDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+{
+	delete m_solverMultiBodyIslandCallback;
+	m_islandBatchCallback = new IslandBatchCallback(constraintSolver, dispatcher);
+	m_solverMultiBodyIslandCallback = m_islandBatchCallback;
+	m_threadScratch.resize(BT_MAX_THREAD_COUNT);
+	setMultiBodyConstraintSolverPool(solverPool, numSolversInPool);
+}
+
+btMultiBodyDynamicsWorldMt::~btMultiBodyDynamicsWorldMt()
+{
+}
+
+void btMultiBodyDynamicsWorldMt::setMultiBodyConstraintSolverPool(btMultiBodyConstraintSolver** solverPool, int numSolversInPool)
+{
+	m_solverPool.resize(numSolversInPool);
+	for (int i = 0; i < numSolversInPool; ++i)
+	{
+		m_solverPool[i].m_solver = solverPool[i];
+	}
+}
+
+btMultiBodyDynamicsWorldMt::ThreadSolver* btMultiBodyDynamicsWorldMt::getAndLockThreadSolver()
+{
+	int i = 0;
+#if BT_THREADSAFE
+	i = btGetCurrentThreadIndex() % m_solverPool.size();
+#endif  // #if BT_THREADSAFE
+	while (true)
+	{
+		ThreadSolver& solver = m_solverPool[i];
+		if (solver.m_mutex.tryLock())
+		{
+			return &solver;
+		}
+		// failed, try the next one
+		i = (i + 1) % m_solverPool.size();
+	}
+	return NULL;
+}
+
+void btMultiBodyDynamicsWorldMt::forwardKinematics()
+{
+	BT_PROFILE("btMultiBody forwardKinematics");
+	if (m_multiBodies.size())
+	{
+		UpdaterForwardKinematics update;
+		update.m_multiBodies = &m_multiBodies[0];
+		update.m_world = this;
+		btParallelFor(0, m_multiBodies.size(), s_multiBodyGrainSize, update);
+	}
+}
+
+void btMultiBodyDynamicsWorldMt::stepMultiBodyVelocities(btContactSolverInfo& solverInfo)
+{
+	BT_PROFILE("btMultiBody stepVelocities");
+	if (m_multiBodies.size())
+	{
+		UpdaterStepVelocities update;
+		update.m_multiBodies = &m_multiBodies[0];
+		update.m_solverInfo = &solverInfo;
+		update.m_world = this;
+		btParallelFor(0, m_multiBodies.size(), s_multiBodyGrainSize, update);
+	}
+}
+
+void btMultiBodyDynamicsWorldMt::integrateMultiBodyTransforms(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepPositions");
+	if (m_multiBodies.size())
+	{
+		UpdaterIntegrateTransforms update;
+		update.m_multiBodies = &m_multiBodies[0];
+		update.m_timeStep = timeStep;
+		update.m_world = this;
+		btParallelFor(0, m_multiBodies.size(), s_multiBodyGrainSize, update);
+	}
+}
+
+void btMultiBodyDynamicsWorldMt::predictMultiBodyTransforms(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepPositions");
+	if (m_multiBodies.size())
+	{
+		UpdaterPredictTransforms update;
+		update.m_multiBodies = &m_multiBodies[0];
+		update.m_timeStep = timeStep;
+		update.m_world = this;
+		btParallelFor(0, m_multiBodies.size(), s_multiBodyGrainSize, update);
+	}
+}
+
+bool btMultiBodyDynamicsWorldMt::assignMultiBodyToBatch(const btMultiBody* multiBody, int batchIndex)
+{
+	const int* otherBatch = m_multiBodyToBatch.find(multiBody);
+	if (otherBatch == 0)
+	{
+		m_multiBodyToBatch.insert(multiBody, batchIndex);
+		return true;
+	}
+	return (*otherBatch == batchIndex);
+}
+
+bool btMultiBodyDynamicsWorldMt::canSolveIslandBatchesInParallel()
+{
+	// the solver writes to every multibody of a batch, so no multibody may be in two batches
+	m_multiBodyToBatch.clear();
+	for (int b = 0; b < m_islandBatchCallback->m_numBatches; ++b)
+	{
+		const IslandBatch* batch = m_islandBatchCallback->m_batches[b];
+		for (int i = 0; i < batch->m_manifolds.size(); ++i)
+		{
+			const btPersistentManifold* manifold = batch->m_manifolds[i];
+			const btMultiBodyLinkCollider* col0 = btMultiBodyLinkCollider::upcast(manifold->getBody0());
+			const btMultiBodyLinkCollider* col1 = btMultiBodyLinkCollider::upcast(manifold->getBody1());
+			if (col0 && col0->m_multiBody && !assignMultiBodyToBatch(col0->m_multiBody, b))
+			{
+				return false;
+			}
+			if (col1 && col1->m_multiBody && !assignMultiBodyToBatch(col1->m_multiBody, b))
+			{
+				return false;
+			}
+		}
+		for (int i = 0; i < batch->m_multiBodyConstraints.size(); ++i)
+		{
+			btMultiBodyConstraint* constraint = batch->m_multiBodyConstraints[i];
+			if (constraint->getMultiBodyA() && !assignMultiBodyToBatch(constraint->getMultiBodyA(), b))
+			{
+				return false;
+			}
+			if (constraint->getMultiBodyB() && !assignMultiBodyToBatch(constraint->getMultiBodyB(), b))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void btMultiBodyDynamicsWorldMt::solveIslandBatches(btContactSolverInfo& solverInfo)
+{
+	BT_PROFILE("btMultiBodyDynamicsWorldMt::solveIslandBatches");
+	const int numBatches = m_islandBatchCallback->m_numBatches;
+	if (numBatches == 0)
+	{
+		return;
+	}
+	IslandBatch** batches = &m_islandBatchCallback->m_batches[0];
+	if ((numBatches > 1) && m_solverPool.size() && canSolveIslandBatchesInParallel())
+	{
+		UpdaterSolveIslandBatches update;
+		update.m_batches = batches;
+		update.m_solverInfo = &solverInfo;
+		update.m_world = this;
+		btParallelFor(0, numBatches, 1, update);
+	}
+	else
+	{
+		for (int i = 0; i < numBatches; ++i)
+		{
+			batches[i]->solve(m_multiBodyConstraintSolver, solverInfo, m_debugDrawer, getDispatcher());
+		}
+	}
+	// report in batch order, so the analytics do not depend on the thread count
+	if (solverInfo.m_reportSolverAnalytics & 1)
+	{
+		for (int i = 0; i < numBatches; ++i)
+		{
+			if (batches[i]->m_bodies.size())
+			{
+				m_islandBatchCallback->m_islandAnalyticsData.push_back(batches[i]->m_analyticsData);
+			}
+		}
+	}
+}
+
+void btMultiBodyDynamicsWorldMt::solveInternalConstraints(btContactSolverInfo& solverInfo)
+{
+	/// collect the remaining islands and solve all batches
+	m_islandBatchCallback->processConstraints();
+	solveIslandBatches(solverInfo);
+	m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
+	if (m_multiBodies.size() == 0)
+	{
+		return;
+	}
+	{
+		BT_PROFILE("btMultiBody stepVelocities");
+		UpdaterJointFeedback update;
+		update.m_multiBodies = &m_multiBodies[0];
+		update.m_solverInfo = &solverInfo;
+		update.m_world = this;
+		btParallelFor(0, m_multiBodies.size(), s_multiBodyGrainSize, update);
+	}
+	{
+		UpdaterProcessDeltaVee update;
+		update.m_multiBodies = &m_multiBodies[0];
+		btParallelFor(0, m_multiBodies.size(), s_multiBodyGrainSize, update);
+	}
+}
+
+int btMultiBodyDynamicsWorldMt::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep)
+{
+	int numSubSteps = btMultiBodyDynamicsWorld::stepSimulation(timeStep, maxSubSteps, fixedTimeStep);
+	if (btITaskScheduler* scheduler = btGetTaskScheduler())
+	{
+		// tell Bullet's threads to sleep, so other threads can run
+		scheduler->sleepWorkerThreadsHint();
+	}
+	return numSubSteps;
+}
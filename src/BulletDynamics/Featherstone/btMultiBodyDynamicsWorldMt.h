@@ -0,0 +1,106 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MULTIBODY_DYNAMICS_WORLD_MT_H
+#define BT_MULTIBODY_DYNAMICS_WORLD_MT_H
+
+#include "btMultiBodyDynamicsWorld.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btThreads.h"
+
+///
+/// btMultiBodyDynamicsWorldMt -- a version of btMultiBodyDynamicsWorld that processes the multibodies and their
+///                               simulation islands with btParallelFor.
+///
+///  These per-multibody steps run in parallel, each thread with its own scratch memory:
+///     - forwardKinematics
+///     - the articulated body algorithm (computeAccelerationsArticulatedBodyAlgorithmMultiDof, also for RK4 and joint feedback)
+///     - predictMultiBodyTransforms and integrateMultiBodyTransforms (stepPositionsMultiDof)
+///     - processDeltaVeeMultiDof2
+///  The islands are batched like in btMultiBodyDynamicsWorld (see btContactSolverInfo::m_minimumSolverBatchSize),
+///  and the batches are solved in parallel by a pool of btMultiBodyConstraintSolvers, one per thread.
+///  If a multibody is used by more than one batch (for example through contacts with the static base of a fixed-base
+///  multibody), the batches of that step are solved one after the other, by the main constraint solver.
+///  The rigid body parts of the step are the same as in btMultiBodyDynamicsWorld.
+///
+class btMultiBodyDynamicsWorldMt : public btMultiBodyDynamicsWorld
+{
+protected:
+	struct ThreadScratch
+	{
+		btAlignedObjectArray<btQuaternion> m_worldToLocal;
+		btAlignedObjectArray<btVector3> m_localOrigin;
+		btAlignedObjectArray<btScalar> m_r;
+		btAlignedObjectArray<btVector3> m_v;
+		btAlignedObjectArray<btMatrix3x3> m_m;
+	};
+	struct ThreadSolver
+	{
+		btMultiBodyConstraintSolver* m_solver;
+		btSpinMutex m_mutex;
+	};
+	struct IslandBatch;
+	struct IslandBatchCallback;
+	struct UpdaterForwardKinematics;
+	struct UpdaterStepVelocities;
+	struct UpdaterJointFeedback;
+	struct UpdaterProcessDeltaVee;
+	struct UpdaterIntegrateTransforms;
+	struct UpdaterPredictTransforms;
+	struct UpdaterSolveIslandBatches;
+
+	btAlignedObjectArray<ThreadScratch> m_threadScratch;  // indexed by btGetCurrentThreadIndex
+	btAlignedObjectArray<ThreadSolver> m_solverPool;
+	IslandBatchCallback* m_islandBatchCallback;           // replaces the in-place island callback, collects the island batches
+	btHashMap<btHashPtr, int> m_multiBodyToBatch;
+
+	virtual void stepMultiBodyVelocities(btContactSolverInfo& solverInfo) BT_OVERRIDE;
+
+	ThreadScratch& getThreadScratch()
+	{
+		return m_threadScratch[btGetCurrentThreadIndex()];
+	}
+	ThreadSolver* getAndLockThreadSolver();
+	bool assignMultiBodyToBatch(const btMultiBody* multiBody, int batchIndex);
+	bool canSolveIslandBatchesInParallel();
+	void solveIslandBatches(btContactSolverInfo& solverInfo);
+
+public:
+	///the solvers of the pool solve the island batches in parallel, there should be one for each thread.
+	///the world does not delete the solvers.
+	btMultiBodyDynamicsWorldMt(btDispatcher* dispatcher,
+							   btBroadphaseInterface* pairCache,
+							   btMultiBodyConstraintSolver* constraintSolver,
+							   btMultiBodyConstraintSolver** solverPool,
+							   int numSolversInPool,
+							   btCollisionConfiguration* collisionConfiguration);
+
+	virtual ~btMultiBodyDynamicsWorldMt();
+
+	virtual int stepSimulation(btScalar timeStep, int maxSubSteps = 1, btScalar fixedTimeStep = btScalar(1.) / btScalar(60.)) BT_OVERRIDE;
+
+	virtual void forwardKinematics() BT_OVERRIDE;
+	virtual void integrateMultiBodyTransforms(btScalar timeStep) BT_OVERRIDE;
+	virtual void predictMultiBodyTransforms(btScalar timeStep) BT_OVERRIDE;
+	virtual void solveInternalConstraints(btContactSolverInfo& solverInfo) BT_OVERRIDE;
+
+	void setMultiBodyConstraintSolverPool(btMultiBodyConstraintSolver** solverPool, int numSolversInPool);
+	int getNumSolversInPool() const
+	{
+		return m_solverPool.size();
+	}
+};
+
+#endif  //BT_MULTIBODY_DYNAMICS_WORLD_MT_H
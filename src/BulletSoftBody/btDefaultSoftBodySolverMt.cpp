@@ -0,0 +1,268 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btDefaultSoftBodySolverMt.h"
+#include "BulletSoftBody/btSoftBody.h"
+#include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
+#include "LinearMath/btQuickprof.h"
+
+struct SoftBodyPredictMotionLoop : public btIParallelForBody
+{
+	btSoftBody* const* m_bodies;
+	btScalar m_timeStep;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			m_bodies[i]->predictMotion(m_timeStep);
+		}
+	}
+};
+
+struct SoftBodyIntegrateMotionLoop : public btIParallelForBody
+{
+	btSoftBody* const* m_bodies;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			m_bodies[i]->integrateMotion();
+		}
+	}
+};
+
+struct SoftBodySolveGroupsLoop : public btIParallelForBody
+{
+	btSoftBody* const* m_groupBodies;
+	const int* m_groupOffsets;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int g = iBegin; g < iEnd; ++g)
+		{
+			for (int i = m_groupOffsets[g]; i < m_groupOffsets[g + 1]; ++i)
+			{
+				m_groupBodies[i]->solveConstraints();
+			}
+		}
+	}
+};
+
+btDefaultSoftBodySolverMt::btDefaultSoftBodySolverMt()
+{
+	m_minLinksForBatches = 1024;
+}
+
+btDefaultSoftBodySolverMt::~btDefaultSoftBodySolverMt()
+{
+}
+
+void btDefaultSoftBodySolverMt::gatherActiveBodies()
+{
+	m_activeBodies.resize(0);
+	for (int i = 0; i < m_softBodySet.size(); ++i)
+	{
+		btSoftBody* psb = m_softBodySet[i];
+		if (psb->isActive())
+		{
+			m_activeBodies.push_back(psb);
+		}
+	}
+}
+
+void btDefaultSoftBodySolverMt::predictMotion(btScalar timeStep)
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::predictMotion");
+	gatherActiveBodies();
+	if (m_activeBodies.size() == 0)
+	{
+		return;
+	}
+	SoftBodyPredictMotionLoop loop;
+	loop.m_bodies = &m_activeBodies[0];
+	loop.m_timeStep = timeStep;
+	btParallelFor(0, m_activeBodies.size(), 1, loop);
+}
+
+void btDefaultSoftBodySolverMt::updateSoftBodies()
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::updateSoftBodies");
+	gatherActiveBodies();
+	if (m_activeBodies.size() == 0)
+	{
+		return;
+	}
+	SoftBodyIntegrateMotionLoop loop;
+	loop.m_bodies = &m_activeBodies[0];
+	btParallelFor(0, m_activeBodies.size(), 1, loop);
+}
+
+void btDefaultSoftBodySolverMt::uniteSharedObject(const void* sharedObject, int bodyIndex)
+{
+	const int* firstBody = m_sharedObjectToBody.find(sharedObject);
+	if (firstBody)
+	{
+		m_unionFind.unite(*firstBody, bodyIndex);
+	}
+	else
+	{
+		m_sharedObjectToBody.insert(sharedObject, bodyIndex);
+	}
+}
+
+int btDefaultSoftBodySolverMt::findOwnerBody(const void* feature) const
+{
+	for (int i = 0; i < m_softBodySet.size(); ++i)
+	{
+		const btSoftBody* psb = m_softBodySet[i];
+		if (psb->m_nodes.size() && (feature >= (const void*)&psb->m_nodes[0]) && (feature < (const void*)(&psb->m_nodes[0] + psb->m_nodes.size())))
+		{
+			return i;
+		}
+		if (psb->m_faces.size() && (feature >= (const void*)&psb->m_faces[0]) && (feature < (const void*)(&psb->m_faces[0] + psb->m_faces.size())))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void btDefaultSoftBodySolverMt::buildSolverGroups()
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::buildSolverGroups");
+	const int numBodies = m_activeBodies.size();
+	m_unionFind.reset(numBodies);
+	m_sharedObjectToBody.clear();
+	for (int i = 0; i < numBodies; ++i)
+	{
+		m_sharedObjectToBody.insert(m_activeBodies[i], i);
+	}
+	for (int i = 0; i < numBodies; ++i)
+	{
+		btSoftBody* psb = m_activeBodies[i];
+		/* Anchors apply impulses to their rigid body	*/
+		for (int j = 0; j < psb->m_anchors.size(); ++j)
+		{
+			const btRigidBody* body = psb->m_anchors[j].m_body;
+			if (!body->isStaticOrKinematicObject())
+			{
+				uniteSharedObject(body, i);
+			}
+		}
+		/* Rigid contacts apply impulses to their rigid body or multibody	*/
+		for (int j = 0; j < psb->m_rcontacts.size(); ++j)
+		{
+			const btCollisionObject* colObj = psb->m_rcontacts[j].m_cti.m_colObj;
+			if (!colObj->hasContactResponse() || colObj->isStaticOrKinematicObject())
+			{
+				continue;
+			}
+			const btMultiBodyLinkCollider* multibodyLinkCol = btMultiBodyLinkCollider::upcast(colObj);
+			if (multibodyLinkCol)
+			{
+				uniteSharedObject(multibodyLinkCol->m_multiBody, i);
+			}
+			else
+			{
+				uniteSharedObject(colObj, i);
+			}
+		}
+		/* Soft contacts move the nodes of both soft bodies	*/
+		for (int j = 0; j < psb->m_scontacts.size(); ++j)
+		{
+			const btSoftBody::SContact& c = psb->m_scontacts[j];
+			const int nodeOwner = findOwnerBody(c.m_node);
+			const int faceOwner = findOwnerBody(c.m_face);
+			if (nodeOwner >= 0)
+			{
+				uniteSharedObject(m_softBodySet[nodeOwner], i);
+			}
+			if (faceOwner >= 0)
+			{
+				uniteSharedObject(m_softBodySet[faceOwner], i);
+			}
+		}
+	}
+
+	/* Gather the groups, ordered by their first body, so the result does not depend on the thread count	*/
+	m_groupOfRoot.resize(numBodies);
+	m_bodyGroup.resize(numBodies);
+	m_groupCounts.resize(0);
+	for (int i = 0; i < numBodies; ++i)
+	{
+		m_groupOfRoot[i] = -1;
+	}
+	for (int i = 0; i < numBodies; ++i)
+	{
+		const int root = m_unionFind.find(i);
+		if (m_groupOfRoot[root] < 0)
+		{
+			m_groupOfRoot[root] = m_groupCounts.size();
+			m_groupCounts.push_back(0);
+		}
+		m_bodyGroup[i] = m_groupOfRoot[root];
+		m_groupCounts[m_bodyGroup[i]]++;
+	}
+	const int numGroups = m_groupCounts.size();
+	m_groupOffsets.resize(numGroups + 1);
+	m_groupOffsets[0] = 0;
+	for (int g = 0; g < numGroups; ++g)
+	{
+		m_groupOffsets[g + 1] = m_groupOffsets[g] + m_groupCounts[g];
+		m_groupCounts[g] = m_groupOffsets[g];  // insertion index
+	}
+	m_groupBodies.resize(numBodies);
+	for (int i = 0; i < numBodies; ++i)
+	{
+		m_groupBodies[m_groupCounts[m_bodyGroup[i]]++] = m_activeBodies[i];
+	}
+}
+
+void btDefaultSoftBodySolverMt::solveConstraints(btScalar solverdt)
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::solveConstraints");
+	gatherActiveBodies();
+	if (m_activeBodies.size() == 0)
+	{
+		return;
+	}
+	for (int i = 0; i < m_activeBodies.size(); ++i)
+	{
+		btSoftBody* psb = m_activeBodies[i];
+		if ((psb->m_links.size() >= m_minLinksForBatches) && !psb->hasLinkBatches())
+		{
+			psb->generateLinkBatches();
+		}
+	}
+	buildSolverGroups();
+
+	SoftBodySolveGroupsLoop loop;
+	loop.m_groupBodies = &m_groupBodies[0];
+	loop.m_groupOffsets = &m_groupOffsets[0];
+	const int numGroups = m_groupOffsets.size() - 1;
+	const btITaskScheduler* scheduler = btGetTaskScheduler();
+	const int numThreads = scheduler ? scheduler->getNumThreads() : 1;
+	if ((numGroups > 1) && (numGroups >= numThreads))
+	{
+		btParallelFor(0, numGroups, 1, loop);
+	}
+	else
+	{
+		// few groups: solve them in sequence, the link batches of large bodies still run in parallel
+		loop.forLoop(0, numGroups);
+	}
+}
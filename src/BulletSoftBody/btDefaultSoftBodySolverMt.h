@@ -0,0 +1,76 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SOFT_BODY_DEFAULT_SOLVER_MT_H
+#define BT_SOFT_BODY_DEFAULT_SOLVER_MT_H
+
+#include "btDefaultSoftBodySolver.h"
+#include "BulletCollision/CollisionDispatch/btUnionFind.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btThreads.h"
+
+class btSoftBody;
+
+///
+/// btDefaultSoftBodySolverMt -- a version of btDefaultSoftBodySolver that uses btParallelFor.
+///
+///  predictMotion and updateSoftBodies run in parallel over the active soft bodies.
+///  solveConstraints groups the soft bodies that touch the same dynamic rigid body or multibody (anchors, rigid contacts)
+///  or each other (soft contacts), because their solvers write to the shared body. The groups are solved in parallel.
+///  When there are fewer groups than threads, the groups are solved one after the other instead, and the links
+///  of large bodies are relaxed in parallel, one graph-colored link batch at a time (see btSoftBody::generateLinkBatches).
+///  Note: generating the link batches reorders the links of the body, so the result differs slightly from btDefaultSoftBodySolver.
+///
+class btDefaultSoftBodySolverMt : public btDefaultSoftBodySolver
+{
+protected:
+	btAlignedObjectArray<btSoftBody*> m_activeBodies;
+	btAlignedObjectArray<btSoftBody*> m_groupBodies;  // active bodies sorted by group
+	btAlignedObjectArray<int> m_groupOffsets;         // start of each group in m_groupBodies
+	btAlignedObjectArray<int> m_groupOfRoot;
+	btAlignedObjectArray<int> m_groupCounts;
+	btAlignedObjectArray<int> m_bodyGroup;
+	btHashMap<btHashPtr, int> m_sharedObjectToBody;   // first active body that writes to a shared object
+	btUnionFind m_unionFind;
+	int m_minLinksForBatches;
+
+	void gatherActiveBodies();
+	void buildSolverGroups();
+	void uniteSharedObject(const void* sharedObject, int bodyIndex);
+	int findOwnerBody(const void* feature) const;
+
+public:
+	btDefaultSoftBodySolverMt();
+
+	virtual ~btDefaultSoftBodySolverMt();
+
+	virtual void updateSoftBodies();
+
+	virtual void solveConstraints(btScalar solverdt);
+
+	virtual void predictMotion(btScalar solverdt);
+
+	///bodies with at least this many links get graph-colored link batches, so that their links can be solved in parallel
+	void setMinLinksForBatches(int minLinks)
+	{
+		m_minLinksForBatches = minLinks;
+	}
+	int getMinLinksForBatches() const
+	{
+		return m_minLinksForBatches;
+	}
+};
+
+#endif  //BT_SOFT_BODY_DEFAULT_SOLVER_MT_H
@@ -264,6 +264,15 @@ public:
 #endif  //USE_BRUTEFORCE_RAYBROADPHASE
 	}
 
+	///soft bodies are not supported by the packet traversal, so each ray of the packet uses rayTest
+	virtual void rayTestPacket(const btVector3* rayFromWorld, const btVector3* rayToWorld, RayResultCallback** resultCallbacks, int numRays) const
+	{
+		for (int i = 0; i < numRays; i++)
+		{
+			rayTest(rayFromWorld[i], rayToWorld[i], *resultCallbacks[i]);
+		}
+	}
+
 	void rayTestSingle(const btTransform& rayFromTrans, const btTransform& rayToTrans,
 					   btCollisionObject* collisionObject,
 					   const btCollisionShape* collisionShape,
@@ -20,6 +20,7 @@ subject to the following restrictions:
 #include "LinearMath/btSerializer.h"
 #include "LinearMath/btImplicitQRSVD.h"
 #include "LinearMath/btAlignedAllocator.h"
+#include "LinearMath/btThreads.h"
 #include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraint.h"
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpa2.h"
@@ -397,6 +398,7 @@ void btSoftBody::appendLink(int model, Material* mat)
 		l.m_material = mat ? mat : m_materials[0];
 	}
 	m_links.push_back(l);
+	m_linkBatches.resize(0);
 }
 
 //
@@ -1481,8 +1483,66 @@ void btSoftBody::randomizeConstraints()
 		btSwap(m_faces[i], m_faces[NEXTRAND % ni]);
 	}
 #undef NEXTRAND
+	m_linkBatches.resize(0);
 }
 
+//
+int btSoftBody::generateLinkBatches()
+{
+	const int numLinks = m_links.size();
+	m_linkBatches.resize(0);
+	m_linkBatches.push_back(0);
+	if (numLinks == 0)
+	{
+		return 0;
+	}
+	/* Greedy coloring, each pass takes the remaining links that do not share a node with the batch	*/
+	btAlignedObjectArray<int> nodeBatch;
+	nodeBatch.resize(m_nodes.size(), -1);
+	btAlignedObjectArray<Link> remaining;
+	btAlignedObjectArray<Link> sorted;
+	btAlignedObjectArray<Link> deferred;
+	remaining.copyFromArray(m_links);
+	sorted.reserve(numLinks);
+	int batch = 0;
+	while (remaining.size() > 0)
+	{
+		deferred.resize(0);
+		for (int i = 0; i < remaining.size(); ++i)
+		{
+			const Link& l = remaining[i];
+			const int ia = int(l.m_n[0] - &m_nodes[0]);
+			const int ib = int(l.m_n[1] - &m_nodes[0]);
+			if ((nodeBatch[ia] != batch) && (nodeBatch[ib] != batch))
+			{
+				nodeBatch[ia] = batch;
+				nodeBatch[ib] = batch;
+				sorted.push_back(l);
+			}
+			else
+			{
+				deferred.push_back(l);
+			}
+		}
+		m_linkBatches.push_back(sorted.size());
+		remaining.copyFromArray(deferred);
+		++batch;
+	}
+	m_links.copyFromArray(sorted);
+	return batch;
+}
+
+#if BT_THREADSAFE
+///links per task when a link batch is solved with btParallelFor
+static const int s_linkBatchGrainSize = 128;
+
+static bool useParallelLinkBatches(const btSoftBody* psb)
+{
+	const btITaskScheduler* scheduler = btGetTaskScheduler();
+	return psb->hasLinkBatches() && scheduler && (scheduler->getNumThreads() > 1);
+}
+#endif  //BT_THREADSAFE
+
 //
 void btSoftBody::releaseCluster(int index)
 {
@@ -1701,6 +1761,8 @@ void btSoftBody::refine(ImplicitFn* ifn, btScalar accurary, bool cut)
 	int newnodes = 0;
 	int i, j, k, ni;
 
+	m_linkBatches.resize(0);
+
 	/* Filter out		*/
 	for (i = 0; i < m_links.size(); ++i)
 	{
@@ -3973,26 +4035,83 @@ void btSoftBody::PSolve_SContacts(btSoftBody* psb, btScalar, btScalar ti)
 	}
 }
 
+//
+static inline void PSolve_Link(btSoftBody::Link& l, btScalar kst)
+{
+	if (l.m_c0 > 0)
+	{
+		btSoftBody::Node& a = *l.m_n[0];
+		btSoftBody::Node& b = *l.m_n[1];
+		const btVector3 del = b.m_x - a.m_x;
+		const btScalar len = del.length2();
+		if (l.m_c1 + len > SIMD_EPSILON)
+		{
+			const btScalar k = ((l.m_c1 - len) / (l.m_c0 * (l.m_c1 + len))) * kst;
+			a.m_x -= del * (k * a.m_im);
+			b.m_x += del * (k * b.m_im);
+		}
+	}
+}
+
+//
+static inline void VSolve_Link(btSoftBody::Link& l, btScalar kst)
+{
+	btSoftBody::Node** n = l.m_n;
+	const btScalar j = -btDot(l.m_c3, n[0]->m_v - n[1]->m_v) * l.m_c2 * kst;
+	n[0]->m_v += l.m_c3 * (j * n[0]->m_im);
+	n[1]->m_v -= l.m_c3 * (j * n[1]->m_im);
+}
+
+#if BT_THREADSAFE
+struct PSolveLinkBatchLoop : public btIParallelForBody
+{
+	btSoftBody* m_psb;
+	btScalar m_kst;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			PSolve_Link(m_psb->m_links[i], m_kst);
+		}
+	}
+};
+
+struct VSolveLinkBatchLoop : public btIParallelForBody
+{
+	btSoftBody* m_psb;
+	btScalar m_kst;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			VSolve_Link(m_psb->m_links[i], m_kst);
+		}
+	}
+};
+#endif  //BT_THREADSAFE
+
 //
 void btSoftBody::PSolve_Links(btSoftBody* psb, btScalar kst, btScalar ti)
 {
 	BT_PROFILE("PSolve_Links");
-	for (int i = 0, ni = psb->m_links.size(); i < ni; ++i)
+#if BT_THREADSAFE
+	if (useParallelLinkBatches(psb))
 	{
-		Link& l = psb->m_links[i];
-		if (l.m_c0 > 0)
+		PSolveLinkBatchLoop loop;
+		loop.m_psb = psb;
+		loop.m_kst = kst;
+		for (int b = 0, nb = psb->m_linkBatches.size() - 1; b < nb; ++b)
 		{
-			Node& a = *l.m_n[0];
-			Node& b = *l.m_n[1];
-			const btVector3 del = b.m_x - a.m_x;
-			const btScalar len = del.length2();
-			if (l.m_c1 + len > SIMD_EPSILON)
-			{
-				const btScalar k = ((l.m_c1 - len) / (l.m_c0 * (l.m_c1 + len))) * kst;
-				a.m_x -= del * (k * a.m_im);
-				b.m_x += del * (k * b.m_im);
-			}
+			btParallelFor(psb->m_linkBatches[b], psb->m_linkBatches[b + 1], s_linkBatchGrainSize, loop);
 		}
+		return;
+	}
+#endif  //BT_THREADSAFE
+	for (int i = 0, ni = psb->m_links.size(); i < ni; ++i)
+	{
+		PSolve_Link(psb->m_links[i], kst);
 	}
 }
 
@@ -4000,13 +4119,22 @@ void btSoftBody::PSolve_Links(btSoftBody* psb, btScalar kst, btScalar ti)
 void btSoftBody::VSolve_Links(btSoftBody* psb, btScalar kst)
 {
 	BT_PROFILE("VSolve_Links");
+#if BT_THREADSAFE
+	if (useParallelLinkBatches(psb))
+	{
+		VSolveLinkBatchLoop loop;
+		loop.m_psb = psb;
+		loop.m_kst = kst;
+		for (int b = 0, nb = psb->m_linkBatches.size() - 1; b < nb; ++b)
+		{
+			btParallelFor(psb->m_linkBatches[b], psb->m_linkBatches[b + 1], s_linkBatchGrainSize, loop);
+		}
+		return;
+	}
+#endif  //BT_THREADSAFE
 	for (int i = 0, ni = psb->m_links.size(); i < ni; ++i)
 	{
-		Link& l = psb->m_links[i];
-		Node** n = l.m_n;
-		const btScalar j = -btDot(l.m_c3, n[0]->m_v - n[1]->m_v) * l.m_c2 * kst;
-		n[0]->m_v += l.m_c3 * (j * n[0]->m_im);
-		n[1]->m_v -= l.m_c3 * (j * n[1]->m_im);
+		VSolve_Link(psb->m_links[i], kst);
 	}
 }
 
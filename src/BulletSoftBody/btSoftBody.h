@@ -812,6 +812,7 @@ public:
 	tNodeArray m_nodes;                // Nodes
 	tRenderNodeArray m_renderNodes;    // Render Nodes
 	tLinkArray m_links;                // Links
+	btAlignedObjectArray<int> m_linkBatches;  // Offsets of the graph-colored link batches in m_links, see generateLinkBatches
 	tFaceArray m_faces;                // Faces
 	tRenderFaceArray m_renderFaces;          // Faces
 	tTetraArray m_tetras;              // Tetras
@@ -1051,6 +1052,15 @@ public:
 								   Material* mat = 0);
 	/* Randomize constraints to reduce solver bias							*/
 	void randomizeConstraints();
+	/* Sort links into batches without shared nodes (graph coloring)		*/
+	///generateLinkBatches colors the links so that no two links of a batch share a node, and sorts m_links by batch.
+	///PSolve_Links and VSolve_Links then relax one batch after the other, and the links of a batch in parallel
+	///(btParallelFor, in a BT_THREADSAFE build). Appending, removing or reordering links drops the batches. Returns the number of batches.
+	int generateLinkBatches();
+	bool hasLinkBatches() const
+	{
+		return (m_linkBatches.size() > 1) && (m_linkBatches[m_linkBatches.size() - 1] == m_links.size());
+	}
 	/* Release clusters														*/
 	void releaseCluster(int index);
 	void releaseClusters();
@@ -652,6 +652,9 @@ void btSoftBodyHelpers::ReoptimizeLinkOrder(btSoftBody* psb /* This can be repla
 		}
 	}
 
+	// The link order changed, so the graph-colored batches no longer match m_links
+	psb->m_linkBatches.resize(0);
+
 	// Delete the temporary buffers
 	delete[] nodeWrittenAt;
 	delete[] linkDepA;
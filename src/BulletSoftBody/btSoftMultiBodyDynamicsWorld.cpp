@@ -268,6 +268,14 @@ void btSoftMultiBodyDynamicsWorld::rayTest(const btVector3& rayFromWorld, const
 #endif  //USE_BRUTEFORCE_RAYBROADPHASE
 }
 
+void btSoftMultiBodyDynamicsWorld::rayTestPacket(const btVector3* rayFromWorld, const btVector3* rayToWorld, RayResultCallback** resultCallbacks, int numRays) const
+{
+	for (int i = 0; i < numRays; i++)
+	{
+		rayTest(rayFromWorld[i], rayToWorld[i], *resultCallbacks[i]);
+	}
+}
+
 void btSoftMultiBodyDynamicsWorld::rayTestSingle(const btTransform& rayFromTrans, const btTransform& rayToTrans,
 												 btCollisionObject* collisionObject,
 												 const btCollisionShape* collisionShape,
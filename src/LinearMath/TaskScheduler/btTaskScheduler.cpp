@@ -782,6 +782,514 @@ btITaskScheduler* btCreateDefaultTaskScheduler()
 	return ts;
 }
 
+//
+// work-stealing task scheduler
+//
+
+struct WorkStealingLoop
+{
+	const btIParallelForBody* m_forBody;
+	const btIParallelSumBody* m_sumBody;
+	int m_grainSize;
+	btSpinMutex m_mutex;
+	volatile int m_numRemaining;  // iterations not executed yet, protected by m_mutex
+	btScalar m_sum;               // protected by m_mutex
+
+	WorkStealingLoop(const btIParallelForBody* forBody, const btIParallelSumBody* sumBody, int grainSize, int iterationCount)
+	{
+		m_forBody = forBody;
+		m_sumBody = sumBody;
+		m_grainSize = grainSize;
+		m_numRemaining = iterationCount;
+		m_sum = btScalar(0);
+	}
+	void execute(int iBegin, int iEnd)
+	{
+		BT_PROFILE("executeJob");
+		btScalar sum = btScalar(0);
+		if (m_forBody)
+		{
+			m_forBody->forLoop(iBegin, iEnd);
+		}
+		else
+		{
+			sum = m_sumBody->sumLoop(iBegin, iEnd);
+		}
+		m_mutex.lock();
+		m_sum += sum;
+		m_numRemaining -= iEnd - iBegin;
+		m_mutex.unlock();
+	}
+	bool isFinished() const { return m_numRemaining == 0; }
+};
+
+struct WorkStealingRange
+{
+	WorkStealingLoop* m_loop;
+	int m_begin;
+	int m_end;
+};
+
+ATTRIBUTE_ALIGNED64(class)
+WorkStealingDeque
+{
+	btSpinMutex m_mutex;
+	btAlignedObjectArray<WorkStealingRange> m_ranges;  // ranges [m_top, size) are pending, the newest one is at the back
+	int m_top;
+	volatile int m_numRanges;  // for the lock-free emptiness check
+	char m_cachePadding[kCacheLineSize];  // prevent false sharing
+
+	void updateNumRanges()
+	{
+		if (m_top == m_ranges.size())
+		{
+			m_ranges.resizeNoInitialize(0);
+			m_top = 0;
+		}
+		m_numRanges = m_ranges.size() - m_top;
+	}
+
+public:
+	WorkStealingDeque()
+	{
+		m_top = 0;
+		m_numRanges = 0;
+	}
+	bool isEmpty() const { return m_numRanges == 0; }
+
+	void push(const WorkStealingRange& range)
+	{
+		m_mutex.lock();
+		m_ranges.push_back(range);
+		updateNumRanges();
+		m_mutex.unlock();
+	}
+	// owner: the next grain-sized chunk from the front of the newest range
+	bool popChunk(WorkStealingRange * chunk)
+	{
+		if (isEmpty())
+		{
+			// lock free path. even if this is taken erroneously it isn't harmful
+			return false;
+		}
+		bool found = false;
+		m_mutex.lock();
+		if (m_ranges.size() > m_top)
+		{
+			WorkStealingRange& range = m_ranges[m_ranges.size() - 1];
+			*chunk = range;
+			chunk->m_end = btMin(range.m_begin + range.m_loop->m_grainSize, range.m_end);
+			range.m_begin = chunk->m_end;
+			if (range.m_begin == range.m_end)
+			{
+				m_ranges.pop_back();
+			}
+			updateNumRanges();
+			found = true;
+		}
+		m_mutex.unlock();
+		return found;
+	}
+	// thief: the upper half of the oldest range, or all of it if it is not bigger than a chunk
+	bool steal(WorkStealingRange * stolen)
+	{
+		if (isEmpty())
+		{
+			return false;
+		}
+		bool found = false;
+		m_mutex.lock();
+		if (m_ranges.size() > m_top)
+		{
+			WorkStealingRange& range = m_ranges[m_top];
+			*stolen = range;
+			int count = range.m_end - range.m_begin;
+			if (count > range.m_loop->m_grainSize)
+			{
+				int mid = range.m_begin + count / 2;
+				stolen->m_begin = mid;
+				range.m_end = mid;
+			}
+			else
+			{
+				m_top++;
+				updateNumRanges();
+			}
+			found = true;
+		}
+		m_mutex.unlock();
+		return found;
+	}
+};
+
+class btTaskSchedulerWorkStealing;
+
+ATTRIBUTE_ALIGNED64(struct)
+WorkStealingThreadStorage
+{
+	btTaskSchedulerWorkStealing* m_scheduler;
+	int m_threadId;
+	unsigned int m_randomSeed;  // only used by the thread itself, to pick steal victims
+	btSpinMutex m_mutex;
+	WorkerThreadStatus::Type m_status;  // protected by m_mutex
+	unsigned int m_cooldownTime;
+};
+
+static void WorkStealingWorkerThreadFunc(void* userPtr);
+
+///
+/// btTaskSchedulerWorkStealing -- task scheduler with a deque of index ranges per thread
+///
+///  parallelFor/parallelSum push their whole range onto the deque of the calling thread.
+///  Each thread takes grain-sized chunks off the front of the newest range in its own deque, and a thread
+///  without work steals the upper half of the oldest range from another thread's deque, so a range is only
+///  split when another thread is actually idle. Uneven iterations (like islands of very different sizes)
+///  are balanced by the idle threads rather than by a static split of the range.
+///  A thread waiting for its loop to finish keeps executing chunks, so parallelFor/parallelSum can be
+///  called from inside a loop body (nested parallelism), from the main thread or a worker thread.
+///
+class btTaskSchedulerWorkStealing : public btITaskScheduler
+{
+	btThreadSupportInterface* m_threadSupport;
+	WorkerThreadDirectives* m_workerDirective;
+	btAlignedObjectArray<WorkStealingDeque> m_deques;                  // per thread, the main thread is 0
+	btAlignedObjectArray<WorkStealingThreadStorage> m_threadStorage;  // per thread, the main thread is 0
+	int m_threadIdFromThreadIndex[BT_MAX_THREAD_COUNT];               // btGetCurrentThreadIndex -> thread id, or -1
+	btClock m_clock;
+	int m_numThreads;
+	int m_numWorkerThreads;
+	int m_maxNumThreads;
+	int m_mainThreadLoopDepth;
+	static const int kFirstWorkerThreadId = 1;
+
+	int getCurrentThreadId() const
+	{
+		unsigned int threadIndex = btGetCurrentThreadIndex();
+		return threadIndex < BT_MAX_THREAD_COUNT ? m_threadIdFromThreadIndex[threadIndex] : -1;
+	}
+
+	bool steal(int threadId, WorkStealingRange* stolen)
+	{
+		const int numVictims = m_numThreads - 1;
+		if (numVictims <= 0)
+		{
+			return false;
+		}
+		// start with a random victim, so the thieves spread out
+		WorkStealingThreadStorage& storage = m_threadStorage[threadId];
+		storage.m_randomSeed = storage.m_randomSeed * 1664525u + 1013904223u;
+		int offset = int((storage.m_randomSeed >> 16) % unsigned(numVictims));
+		for (int i = 0; i < numVictims; ++i)
+		{
+			int victim = (threadId + 1 + (offset + i) % numVictims) % m_numThreads;
+			if (m_deques[victim].steal(stolen))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool executeChunk(int threadId)
+	{
+		WorkStealingDeque& deque = m_deques[threadId];
+		WorkStealingRange chunk;
+		if (!deque.popChunk(&chunk))
+		{
+			if (!steal(threadId, &chunk))
+			{
+				return false;
+			}
+			if (chunk.m_end - chunk.m_begin > chunk.m_loop->m_grainSize)
+			{
+				// keep the stolen range in our deque, so other threads can split it again
+				deque.push(chunk);
+				if (!deque.popChunk(&chunk))
+				{
+					return true;  // stolen back in the meantime
+				}
+			}
+		}
+		chunk.m_loop->execute(chunk.m_begin, chunk.m_end);
+		return true;
+	}
+
+	void runLoop(int threadId, WorkStealingLoop& loop, int iBegin, int iEnd)
+	{
+		WorkStealingRange range;
+		range.m_loop = &loop;
+		range.m_begin = iBegin;
+		range.m_end = iEnd;
+		m_deques[threadId].push(range);
+
+		// only the outermost loop of the main thread manages the worker threads
+		bool isOutermostLoop = false;
+		if (threadId == 0)
+		{
+			isOutermostLoop = (m_mainThreadLoopDepth == 0);
+			m_mainThreadLoopDepth++;
+		}
+		if (isOutermostLoop)
+		{
+			setWorkerDirectives(WorkerThreadDirectives::kScanForJobs);
+			// wake all of them, even for a few chunks, because the chunks may start nested loops
+			wakeWorkers(m_numWorkerThreads);
+		}
+
+		// work (on this loop or any other) until all of our iterations are done
+		while (!loop.isFinished())
+		{
+			if (!executeChunk(threadId))
+			{
+				btSpinPause();
+			}
+		}
+		// make the results of the other threads visible
+		loop.m_mutex.lock();
+		loop.m_mutex.unlock();
+
+		if (threadId == 0)
+		{
+			m_mainThreadLoopDepth--;
+		}
+		if (isOutermostLoop)
+		{
+			// done with jobs for now, tell workers to rest (but not sleep)
+			setWorkerDirectives(WorkerThreadDirectives::kStayAwakeButIdle);
+		}
+	}
+
+	void setWorkerDirectives(WorkerThreadDirectives::Type dir)
+	{
+		if (m_numThreads > kFirstWorkerThreadId)
+		{
+			m_workerDirective->setDirectiveByRange(kFirstWorkerThreadId, m_numThreads, dir);
+		}
+	}
+
+	void wakeWorkers(int numWorkersToWake)
+	{
+		BT_PROFILE("wakeWorkers");
+		int numDesiredWorkers = btMin(numWorkersToWake, m_numWorkerThreads);
+		int numActiveWorkers = 0;
+		for (int iWorker = 0; iWorker < m_numWorkerThreads; ++iWorker)
+		{
+			WorkStealingThreadStorage& storage = m_threadStorage[kFirstWorkerThreadId + iWorker];
+			if (storage.m_status != WorkerThreadStatus::kSleeping)
+			{
+				numActiveWorkers++;
+			}
+		}
+		for (int iWorker = 0; iWorker < m_numWorkerThreads && numActiveWorkers < numDesiredWorkers; ++iWorker)
+		{
+			WorkStealingThreadStorage& storage = m_threadStorage[kFirstWorkerThreadId + iWorker];
+			storage.m_mutex.lock();
+			bool isSleeping = (storage.m_status == WorkerThreadStatus::kSleeping);
+			if (isSleeping)
+			{
+				// mark it before it runs, so it is not started twice
+				storage.m_status = WorkerThreadStatus::kWaitingForWork;
+			}
+			storage.m_mutex.unlock();
+			if (isSleeping)
+			{
+				m_threadSupport->runTask(iWorker, &storage);
+				numActiveWorkers++;
+			}
+		}
+	}
+
+	void waitForWorkersToSleep()
+	{
+		BT_PROFILE("waitForWorkersToSleep");
+		m_workerDirective->setDirectiveByRange(kFirstWorkerThreadId, BT_MAX_THREAD_COUNT, WorkerThreadDirectives::kGoToSleep);
+		m_threadSupport->waitForAllTasks();
+		for (int i = kFirstWorkerThreadId; i < m_maxNumThreads; i++)
+		{
+			btAssert(m_threadStorage[i].m_status == WorkerThreadStatus::kSleeping);
+		}
+	}
+
+public:
+	btTaskSchedulerWorkStealing() : btITaskScheduler("WorkStealing")
+	{
+		m_threadSupport = NULL;
+		m_workerDirective = NULL;
+		m_mainThreadLoopDepth = 0;
+	}
+
+	virtual ~btTaskSchedulerWorkStealing()
+	{
+		waitForWorkersToSleep();
+
+		if (m_threadSupport)
+		{
+			delete m_threadSupport;
+			m_threadSupport = NULL;
+		}
+		if (m_workerDirective)
+		{
+			btAlignedFree(m_workerDirective);
+			m_workerDirective = NULL;
+		}
+	}
+
+	void init()
+	{
+		btThreadSupportInterface::ConstructionInfo constructionInfo("TaskSchedulerWorkStealing", WorkStealingWorkerThreadFunc);
+		m_threadSupport = btThreadSupportInterface::create(constructionInfo);
+		m_workerDirective = static_cast<WorkerThreadDirectives*>(btAlignedAlloc(sizeof(*m_workerDirective), 64));
+		m_workerDirective->setDirectiveByRange(0, BT_MAX_THREAD_COUNT, WorkerThreadDirectives::kGoToSleep);
+
+		m_numWorkerThreads = m_threadSupport->getNumWorkerThreads();
+		m_maxNumThreads = m_threadSupport->getNumWorkerThreads() + 1;
+		m_numThreads = m_maxNumThreads;
+		m_deques.resize(m_maxNumThreads);
+		m_threadStorage.resize(m_maxNumThreads);
+		for (int i = 0; i < m_maxNumThreads; i++)
+		{
+			WorkStealingThreadStorage& storage = m_threadStorage[i];
+			storage.m_scheduler = this;
+			storage.m_threadId = i;
+			storage.m_randomSeed = 0x9e3779b9u * unsigned(i + 1);
+			storage.m_status = WorkerThreadStatus::kSleeping;
+			storage.m_cooldownTime = 100;  // 100 microseconds, threads go to sleep after this long if they have nothing to do
+		}
+		// the thread creating the scheduler is the main thread, worker threads register when they start
+		for (int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+		{
+			m_threadIdFromThreadIndex[i] = -1;
+		}
+		m_threadIdFromThreadIndex[btGetCurrentThreadIndex()] = 0;
+		setNumThreads(m_threadSupport->getCacheFriendlyNumThreads());
+	}
+
+	virtual int getMaxNumThreads() const BT_OVERRIDE
+	{
+		return m_maxNumThreads;
+	}
+
+	virtual int getNumThreads() const BT_OVERRIDE
+	{
+		return m_numThreads;
+	}
+
+	virtual void setNumThreads(int numThreads) BT_OVERRIDE
+	{
+		m_numThreads = btMax(btMin(numThreads, int(m_maxNumThreads)), 1);
+		m_numWorkerThreads = m_numThreads - 1;
+		m_workerDirective->setDirectiveByRange(m_numThreads, BT_MAX_THREAD_COUNT, WorkerThreadDirectives::kGoToSleep);
+	}
+
+	virtual void sleepWorkerThreadsHint() BT_OVERRIDE
+	{
+		BT_PROFILE("sleepWorkerThreadsHint");
+		// hint the task scheduler that we may not be using these threads for a little while
+		setWorkerDirectives(WorkerThreadDirectives::kGoToSleep);
+	}
+
+	void workerThreadLoop(WorkStealingThreadStorage* storage)
+	{
+		BT_PROFILE("WorkStealingWorkerThreadFunc");
+		const int threadId = storage->m_threadId;
+		m_threadIdFromThreadIndex[btGetCurrentThreadIndex()] = threadId;
+		storage->m_mutex.lock();
+		storage->m_status = WorkerThreadStatus::kWorking;
+		storage->m_mutex.unlock();
+
+		btU64 idleStart = m_clock.getTimeMicroseconds();
+		bool wasIdle = false;
+		while (true)
+		{
+			if (executeChunk(threadId))
+			{
+				wasIdle = false;
+				continue;
+			}
+			// our deque is empty here, so it is safe to stop
+			WorkerThreadDirectives::Type dir = m_workerDirective->getDirective(threadId);
+			if (dir == WorkerThreadDirectives::kGoToSleep)
+			{
+				break;
+			}
+			btU64 now = m_clock.getTimeMicroseconds();
+			if (!wasIdle || dir == WorkerThreadDirectives::kScanForJobs)
+			{
+				// if jobs are incoming, reset clock
+				idleStart = now;
+				wasIdle = true;
+			}
+			else if (now - idleStart > storage->m_cooldownTime)
+			{
+				// if no jobs incoming and there was nothing to steal for the cooldown time, sleep
+				break;
+			}
+			btSpinPause();
+		}
+		{
+			BT_PROFILE("sleep");
+			// go sleep
+			storage->m_mutex.lock();
+			storage->m_status = WorkerThreadStatus::kSleeping;
+			storage->m_mutex.unlock();
+		}
+	}
+
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) BT_OVERRIDE
+	{
+		BT_PROFILE("parallelFor_WorkStealing");
+		btAssert(iEnd >= iBegin);
+		btAssert(grainSize >= 1);
+		int iterationCount = iEnd - iBegin;
+		int threadId = getCurrentThreadId();
+		if (iterationCount > grainSize && m_numWorkerThreads > 0 && threadId >= 0)
+		{
+			WorkStealingLoop loop(&body, NULL, grainSize, iterationCount);
+			runLoop(threadId, loop, iBegin, iEnd);
+		}
+		else
+		{
+			BT_PROFILE("parallelFor_mainThread");
+			// just run on this thread
+			body.forLoop(iBegin, iEnd);
+		}
+	}
+
+	virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) BT_OVERRIDE
+	{
+		BT_PROFILE("parallelSum_WorkStealing");
+		btAssert(iEnd >= iBegin);
+		btAssert(grainSize >= 1);
+		int iterationCount = iEnd - iBegin;
+		int threadId = getCurrentThreadId();
+		if (iterationCount > grainSize && m_numWorkerThreads > 0 && threadId >= 0)
+		{
+			WorkStealingLoop loop(NULL, &body, grainSize, iterationCount);
+			runLoop(threadId, loop, iBegin, iEnd);
+			return loop.m_sum;
+		}
+		else
+		{
+			BT_PROFILE("parallelSum_mainThread");
+			// just run on this thread
+			return body.sumLoop(iBegin, iEnd);
+		}
+	}
+};
+
+static void WorkStealingWorkerThreadFunc(void* userPtr)
+{
+	WorkStealingThreadStorage* storage = (WorkStealingThreadStorage*)userPtr;
+	storage->m_scheduler->workerThreadLoop(storage);
+}
+
+btITaskScheduler* btCreateWorkStealingTaskScheduler()
+{
+	btTaskSchedulerWorkStealing* ts = new btTaskSchedulerWorkStealing();
+	ts->init();
+	return ts;
+}
+
 #else  // #if BT_THREADSAFE
 
 btITaskScheduler* btCreateDefaultTaskScheduler()
@@ -789,4 +1297,9 @@ btITaskScheduler* btCreateDefaultTaskScheduler()
 	return NULL;
 }
 
+btITaskScheduler* btCreateWorkStealingTaskScheduler()
+{
+	return NULL;
+}
+
 #endif  // #else // #if BT_THREADSAFE
@@ -12,6 +12,14 @@
 #endif  //BT_ALLOW_SSE4
 #endif  //USE_SIMD
 
+#ifdef BT_ALLOW_AVX2
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif  //BT_ALLOW_AVX2
+
 #if defined BT_USE_NEON
 #define ARM_NEON_GCC_COMPATIBILITY 1
 #include <arm_neon.h>
@@ -19,16 +27,52 @@
 #include <sys/sysctl.h>  //for sysctlbyname
 #endif                   //BT_USE_NEON
 
-///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, NEON_HPFP)
+///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, AVX2, NEON_HPFP)
 ///We assume SSE2 in case BT_USE_SSE2 is defined in LinearMath/btScalar.h
 class btCpuFeatureUtility
 {
+#if defined(BT_ALLOW_SSE4) || defined(BT_ALLOW_AVX2)
+	static void cpuid(int cpuInfo[4], int function, int subFunction)
+	{
+		memset(cpuInfo, 0, sizeof(int) * 4);
+#ifdef _MSC_VER
+		__cpuidex(cpuInfo, function, subFunction);
+#else
+		unsigned int maxFunction = __get_cpuid_max(0, 0);
+		if ((unsigned int)function <= maxFunction)
+		{
+			unsigned int a, b, c, d;
+			__cpuid_count(function, subFunction, a, b, c, d);
+			cpuInfo[0] = int(a);
+			cpuInfo[1] = int(b);
+			cpuInfo[2] = int(c);
+			cpuInfo[3] = int(d);
+		}
+#endif
+	}
+
+	static unsigned long long xgetbv()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ __volatile__("xgetbv"
+							 : "=a"(eax), "=d"(edx)
+							 : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+#endif  //BT_ALLOW_SSE4 || BT_ALLOW_AVX2
+
 public:
 	enum btCpuFeature
 	{
 		CPU_FEATURE_FMA3 = 1,
 		CPU_FEATURE_SSE4_1 = 2,
-		CPU_FEATURE_NEON_HPFP = 4
+		CPU_FEATURE_NEON_HPFP = 4,
+		CPU_FEATURE_AVX = 8,
+		CPU_FEATURE_AVX2 = 16
 	};
 
 	static int getCpuFeatures()
@@ -50,27 +94,40 @@ public:
 		}
 #endif  //BT_USE_NEON
 
-#ifdef BT_ALLOW_SSE4
+#if defined(BT_ALLOW_SSE4) || defined(BT_ALLOW_AVX2)
 		{
 			int cpuInfo[4];
-			memset(cpuInfo, 0, sizeof(cpuInfo));
 			unsigned long long sseExt = 0;
-			__cpuid(cpuInfo, 1);
+			cpuid(cpuInfo, 1, 0);
 
 			bool osUsesXSAVE_XRSTORE = cpuInfo[2] & (1 << 27) || false;
 			bool cpuAVXSuport = cpuInfo[2] & (1 << 28) || false;
 
 			if (osUsesXSAVE_XRSTORE && cpuAVXSuport)
 			{
-				sseExt = _xgetbv(0);
+				sseExt = xgetbv();
 			}
 			const int OSXSAVEFlag = (1UL << 27);
 			const int AVXFlag = ((1UL << 28) | OSXSAVEFlag);
 			const int FMAFlag = ((1UL << 12) | AVXFlag | OSXSAVEFlag);
-			if ((cpuInfo[2] & FMAFlag) == FMAFlag && (sseExt & 6) == 6)
+			//the OS saves the xmm and ymm registers
+			const bool osSavesYmm = (sseExt & 6) == 6;
+			if ((cpuInfo[2] & FMAFlag) == FMAFlag && osSavesYmm)
 			{
 				capabilities |= btCpuFeatureUtility::CPU_FEATURE_FMA3;
 			}
+			if ((cpuInfo[2] & AVXFlag) == AVXFlag && osSavesYmm)
+			{
+				capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX;
+
+				int extendedInfo[4];
+				cpuid(extendedInfo, 7, 0);
+				const int AVX2Flag = (1 << 5);
+				if (extendedInfo[1] & AVX2Flag)
+				{
+					capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX2;
+				}
+			}
 
 			const int SSE41Flag = (1 << 19);
 			if (cpuInfo[2] & SSE41Flag)
@@ -78,7 +135,7 @@ public:
 				capabilities |= btCpuFeatureUtility::CPU_FEATURE_SSE4_1;
 			}
 		}
-#endif  //BT_ALLOW_SSE4
+#endif  //BT_ALLOW_SSE4 || BT_ALLOW_AVX2
 
 		testedCapabilities = true;
 		return capabilities;
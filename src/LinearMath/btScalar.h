@@ -422,6 +422,15 @@ inline int btIsDoublePrecision()
 		(float32x4_t) { r0, r1, r2, r3 }
 #endif//BT_USE_NEON
 
+//BT_ALLOW_AVX2 means the compiler can build AVX2/FMA3 versions of some array kernels (see btVector3::maxDot),
+//independent of the compiler flags. They are only used when btCpuFeatureUtility reports AVX2 and FMA3 at runtime,
+//so the same binary still runs on any x86-64 cpu. Define BT_NO_AVX2 to leave them out.
+#if !defined(BT_NO_AVX2) && !defined(BT_ALLOW_AVX2) && (defined(__x86_64__) || defined(_M_X64))
+	#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+		#define BT_ALLOW_AVX2
+	#endif
+#endif
+
 #define BT_DECLARE_ALIGNED_ALLOCATOR()                                                                     \
 	SIMD_FORCE_INLINE void *operator new(size_t sizeInBytes) { return btAlignedAlloc(sizeInBytes, 16); }   \
 	SIMD_FORCE_INLINE void operator delete(void *ptr) { btAlignedFree(ptr); }                              \
@@ -0,0 +1,97 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SOA_REAL_H
+#define BT_SOA_REAL_H
+
+#include "btScalar.h"
+#include "btMinMax.h"
+
+///BT_SOA_WIDTH is the number of lanes of the structure-of-arrays kernels (btRigidBodyStateSoA, btBatchedContactRowsSoA):
+///8 when compiled with AVX, 4 with SSE and 1 (plain scalar code) otherwise or with double precision.
+#if defined(BT_USE_DOUBLE_PRECISION)
+#define BT_SOA_WIDTH 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define BT_SOA_WIDTH 8
+#elif defined(BT_USE_SSE) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define BT_SOA_WIDTH 4
+#else
+#define BT_SOA_WIDTH 1
+#endif
+
+///btSoAReal holds one component of BT_SOA_WIDTH lanes
+struct btSoAReal
+{
+	SIMD_FORCE_INLINE btSoAReal() {}
+#if BT_SOA_WIDTH == 8
+	__m256 m_v;
+	SIMD_FORCE_INLINE btSoAReal(__m256 v) : m_v(v) {}
+	SIMD_FORCE_INLINE explicit btSoAReal(btScalar s) : m_v(_mm256_set1_ps(s)) {}
+	static SIMD_FORCE_INLINE btSoAReal load(const btScalar* p) { return _mm256_loadu_ps(p); }
+	SIMD_FORCE_INLINE void store(btScalar* p) const { _mm256_storeu_ps(p, m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator+(const btSoAReal& b) const { return _mm256_add_ps(m_v, b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator-(const btSoAReal& b) const { return _mm256_sub_ps(m_v, b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator*(const btSoAReal& b) const { return _mm256_mul_ps(m_v, b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator/(const btSoAReal& b) const { return _mm256_div_ps(m_v, b.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoASqrt(const btSoAReal& a) { return _mm256_sqrt_ps(a.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoAMin(const btSoAReal& a, const btSoAReal& b) { return _mm256_min_ps(a.m_v, b.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoAMax(const btSoAReal& a, const btSoAReal& b) { return _mm256_max_ps(a.m_v, b.m_v); }
+	///per lane (a > b) ? x : y
+	friend SIMD_FORCE_INLINE btSoAReal btSoASelectGreater(const btSoAReal& a, const btSoAReal& b, const btSoAReal& x, const btSoAReal& y)
+	{
+		return _mm256_blendv_ps(y.m_v, x.m_v, _mm256_cmp_ps(a.m_v, b.m_v, _CMP_GT_OQ));
+	}
+#elif BT_SOA_WIDTH == 4
+	__m128 m_v;
+	SIMD_FORCE_INLINE btSoAReal(__m128 v) : m_v(v) {}
+	SIMD_FORCE_INLINE explicit btSoAReal(btScalar s) : m_v(_mm_set1_ps(s)) {}
+	static SIMD_FORCE_INLINE btSoAReal load(const btScalar* p) { return _mm_loadu_ps(p); }
+	SIMD_FORCE_INLINE void store(btScalar* p) const { _mm_storeu_ps(p, m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator+(const btSoAReal& b) const { return _mm_add_ps(m_v, b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator-(const btSoAReal& b) const { return _mm_sub_ps(m_v, b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator*(const btSoAReal& b) const { return _mm_mul_ps(m_v, b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator/(const btSoAReal& b) const { return _mm_div_ps(m_v, b.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoASqrt(const btSoAReal& a) { return _mm_sqrt_ps(a.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoAMin(const btSoAReal& a, const btSoAReal& b) { return _mm_min_ps(a.m_v, b.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoAMax(const btSoAReal& a, const btSoAReal& b) { return _mm_max_ps(a.m_v, b.m_v); }
+	///per lane (a > b) ? x : y
+	friend SIMD_FORCE_INLINE btSoAReal btSoASelectGreater(const btSoAReal& a, const btSoAReal& b, const btSoAReal& x, const btSoAReal& y)
+	{
+		__m128 mask = _mm_cmpgt_ps(a.m_v, b.m_v);
+		return _mm_or_ps(_mm_and_ps(mask, x.m_v), _mm_andnot_ps(mask, y.m_v));
+	}
+#else
+	btScalar m_v;
+	SIMD_FORCE_INLINE explicit btSoAReal(btScalar s) : m_v(s) {}
+	static SIMD_FORCE_INLINE btSoAReal load(const btScalar* p) { return btSoAReal(*p); }
+	SIMD_FORCE_INLINE void store(btScalar* p) const { *p = m_v; }
+	SIMD_FORCE_INLINE btSoAReal operator+(const btSoAReal& b) const { return btSoAReal(m_v + b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator-(const btSoAReal& b) const { return btSoAReal(m_v - b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator*(const btSoAReal& b) const { return btSoAReal(m_v * b.m_v); }
+	SIMD_FORCE_INLINE btSoAReal operator/(const btSoAReal& b) const { return btSoAReal(m_v / b.m_v); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoASqrt(const btSoAReal& a) { return btSoAReal(btSqrt(a.m_v)); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoAMin(const btSoAReal& a, const btSoAReal& b) { return btSoAReal(btMin(a.m_v, b.m_v)); }
+	friend SIMD_FORCE_INLINE btSoAReal btSoAMax(const btSoAReal& a, const btSoAReal& b) { return btSoAReal(btMax(a.m_v, b.m_v)); }
+	///per lane (a > b) ? x : y
+	friend SIMD_FORCE_INLINE btSoAReal btSoASelectGreater(const btSoAReal& a, const btSoAReal& b, const btSoAReal& x, const btSoAReal& y)
+	{
+		return (a.m_v > b.m_v) ? x : y;
+	}
+#endif
+};
+
+#endif  //BT_SOA_REAL_H
@@ -0,0 +1,249 @@
+/*
+Copyright (c) 2003-2006 Gino van den Bergen / Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btThreadLocalPoolAllocator.h"
+#include "btPoolAllocator.h"
+#include "btAlignedAllocator.h"
+#include "btMinMax.h"
+#include <new>
+
+btThreadLocalPoolAllocator::btThreadLocalPoolAllocator(btPoolAllocator* pool)
+	: m_pool(pool),
+	  m_elemSize(pool->getElementSize()),
+	  m_numArenaBlocks(0),
+	  m_arenaFirstFree(0),
+	  m_arenaFreeCount(0)
+{
+	// the free lists store their links in the elements
+	btAssert(m_elemSize >= int(sizeof(void*)));
+	m_threadCaches = static_cast<ThreadCache*>(btAlignedAlloc(sizeof(ThreadCache) * BT_MAX_THREAD_COUNT, 64));
+	for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; ++i)
+	{
+		ThreadCache* cache = new (&m_threadCaches[i]) ThreadCache();
+		cache->m_firstFree = 0;
+		cache->m_freeCount = 0;
+	}
+}
+
+btThreadLocalPoolAllocator::~btThreadLocalPoolAllocator()
+{
+	// hand the cached pool elements back, so the shared pool can be used by another allocator
+	for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; ++i)
+	{
+		flushCache(m_threadCaches[i], 0);
+	}
+	btAlignedFree(m_threadCaches);
+	for (int i = 0; i < m_numArenaBlocks; ++i)
+	{
+		btAlignedFree(m_arenaBlocks[i].m_memory);
+	}
+}
+
+void* btThreadLocalPoolAllocator::allocate(int size, bool allowGrowth)
+{
+	if (size > m_elemSize)
+	{
+		return 0;
+	}
+	ThreadCache& cache = m_threadCaches[btGetCurrentThreadIndex()];
+	btMutexLock(&cache.m_mutex);
+	void* result = cache.m_firstFree;
+	if (result == 0)
+	{
+		// refillCache takes the arena mutex first, so the mutex of the cache is released meanwhile
+		btMutexUnlock(&cache.m_mutex);
+		return refillCache(cache, allowGrowth);
+	}
+	cache.m_firstFree = *(void**)result;
+	--cache.m_freeCount;
+	btMutexUnlock(&cache.m_mutex);
+	return result;
+}
+
+void btThreadLocalPoolAllocator::freeMemory(void* ptr)
+{
+	if (ptr)
+	{
+		btAssert(validPtr(ptr));
+		ThreadCache& cache = m_threadCaches[btGetCurrentThreadIndex()];
+		btMutexLock(&cache.m_mutex);
+		*(void**)ptr = cache.m_firstFree;
+		cache.m_firstFree = ptr;
+		++cache.m_freeCount;
+		btMutexUnlock(&cache.m_mutex);
+	}
+}
+
+bool btThreadLocalPoolAllocator::validPtr(void* ptr) const
+{
+	if (m_pool->validPtr(ptr))
+	{
+		return true;
+	}
+	const unsigned char* p = static_cast<const unsigned char*>(ptr);
+	const int numBlocks = m_numArenaBlocks;
+	for (int i = 0; i < numBlocks; ++i)
+	{
+		const ArenaBlock& block = m_arenaBlocks[i];
+		if (p >= block.m_memory && p < block.m_memory + block.m_numElements * m_elemSize)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void* btThreadLocalPoolAllocator::refillCache(ThreadCache& cache, bool allowGrowth)
+{
+	void* firstFree = 0;
+	int freeCount = 0;
+	btMutexLock(&m_mutex);
+	takeElements(firstFree, freeCount);
+	if (freeCount == 0)
+	{
+		if (allowGrowth)
+		{
+			addArenaBlock();
+		}
+		else
+		{
+			// the elements of a fixed size pool may all sit in the caches of other threads
+			for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; ++i)
+			{
+				ThreadCache& otherCache = m_threadCaches[i];
+				if (&otherCache != &cache)
+				{
+					btMutexLock(&otherCache.m_mutex);
+					flushCache(otherCache, 0);
+					btMutexUnlock(&otherCache.m_mutex);
+				}
+			}
+		}
+		takeElements(firstFree, freeCount);
+	}
+	btMutexUnlock(&m_mutex);
+
+	if (firstFree == 0)
+	{
+		return 0;
+	}
+	// keep the first element for the caller and move the others to the cache
+	void* result = firstFree;
+	firstFree = *(void**)result;
+	--freeCount;
+	btMutexLock(&cache.m_mutex);
+	while (firstFree)
+	{
+		void* ptr = firstFree;
+		firstFree = *(void**)ptr;
+		*(void**)ptr = cache.m_firstFree;
+		cache.m_firstFree = ptr;
+	}
+	cache.m_freeCount += freeCount;
+	btMutexUnlock(&cache.m_mutex);
+	return result;
+}
+
+void btThreadLocalPoolAllocator::takeElements(void*& firstFree, int& freeCount)
+{
+	// reuse the arena first, it only holds elements that were returned by flushCaches or that were never used
+	if (m_arenaFreeCount == 0)
+	{
+		while (freeCount < CACHE_REFILL_COUNT)
+		{
+			void* ptr = m_pool->allocate(m_elemSize);
+			if (ptr == 0)
+			{
+				break;
+			}
+			*(void**)ptr = firstFree;
+			firstFree = ptr;
+			++freeCount;
+		}
+	}
+	while (m_arenaFreeCount > 0 && freeCount < CACHE_REFILL_COUNT)
+	{
+		void* ptr = m_arenaFirstFree;
+		m_arenaFirstFree = *(void**)ptr;
+		--m_arenaFreeCount;
+		*(void**)ptr = firstFree;
+		firstFree = ptr;
+		++freeCount;
+	}
+}
+
+bool btThreadLocalPoolAllocator::addArenaBlock()
+{
+	if (m_numArenaBlocks >= MAX_ARENA_BLOCKS)
+	{
+		return false;
+	}
+	int numElements = btMax(int(MIN_ARENA_BLOCK_SIZE), m_pool->getMaxCount() / 2);
+	if (m_numArenaBlocks > 0)
+	{
+		numElements = m_arenaBlocks[m_numArenaBlocks - 1].m_numElements * 2;
+	}
+	unsigned char* memory = static_cast<unsigned char*>(btAlignedAlloc(static_cast<size_t>(numElements) * m_elemSize, 16));
+	if (memory == 0)
+	{
+		return false;
+	}
+	ArenaBlock& block = m_arenaBlocks[m_numArenaBlocks];
+	block.m_memory = memory;
+	block.m_numElements = numElements;
+	// publish the block after it is filled in, validPtr reads the blocks without the lock
+	m_numArenaBlocks = m_numArenaBlocks + 1;
+
+	for (int i = numElements - 1; i >= 0; --i)
+	{
+		void* ptr = memory + i * m_elemSize;
+		*(void**)ptr = m_arenaFirstFree;
+		m_arenaFirstFree = ptr;
+	}
+	m_arenaFreeCount += numElements;
+	return true;
+}
+
+void btThreadLocalPoolAllocator::flushCache(ThreadCache& cache, int keepCount)
+{
+	while (cache.m_freeCount > keepCount)
+	{
+		void* ptr = cache.m_firstFree;
+		cache.m_firstFree = *(void**)ptr;
+		--cache.m_freeCount;
+		if (m_pool->validPtr(ptr))
+		{
+			m_pool->freeMemory(ptr);
+		}
+		else
+		{
+			*(void**)ptr = m_arenaFirstFree;
+			m_arenaFirstFree = ptr;
+			++m_arenaFreeCount;
+		}
+	}
+}
+
+void btThreadLocalPoolAllocator::flushCaches()
+{
+	btMutexLock(&m_mutex);
+	for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; ++i)
+	{
+		ThreadCache& cache = m_threadCaches[i];
+		btMutexLock(&cache.m_mutex);
+		flushCache(cache, CACHE_MAX_COUNT);
+		btMutexUnlock(&cache.m_mutex);
+	}
+	btMutexUnlock(&m_mutex);
+}
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2003-2006 Gino van den Bergen / Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_THREAD_LOCAL_POOL_ALLOCATOR_H
+#define BT_THREAD_LOCAL_POOL_ALLOCATOR_H
+
+#include "btScalar.h"
+#include "btThreads.h"
+
+class btPoolAllocator;
+
+///
+/// btThreadLocalPoolAllocator -- a per-thread front end for a shared btPoolAllocator.
+///
+///  Each thread allocates from and frees to its own cache of elements, so an element freed by one thread is
+///  simply reused by that thread. The spin mutex of a cache is only contended when another thread flushes it.
+///  Empty caches are refilled in batches of elements, taken from the shared pool, or from arena blocks owned by
+///  this allocator once the shared pool is exhausted. The arena grows by blocks of doubling size instead of
+///  allocating every overflowing element on the heap. Without growth, the caches of the other threads are
+///  flushed before an allocation fails, so all the elements of the shared pool can be used by any thread.
+///
+///  Elements pile up in the cache of the thread that frees them (for instance the main thread, which releases
+///  the pairs removed by the broadphase), so flushCaches should be called once per frame, while no other thread
+///  uses the allocator, to return the surplus to the shared pool and to the arena.
+///
+class btThreadLocalPoolAllocator
+{
+	enum
+	{
+		CACHE_REFILL_COUNT = 32,     // elements moved to an empty thread cache at once
+		CACHE_MAX_COUNT = 64,        // elements a thread cache keeps after flushCaches
+		MAX_ARENA_BLOCKS = 24,
+		MIN_ARENA_BLOCK_SIZE = 256  // elements
+	};
+
+	struct ThreadCache
+	{
+		void* m_firstFree;
+		int m_freeCount;
+		btSpinMutex m_mutex;
+		char m_padding[64 - sizeof(void*) - sizeof(int) - sizeof(btSpinMutex)];  // one cache line per thread
+	};
+
+	struct ArenaBlock
+	{
+		unsigned char* m_memory;
+		int m_numElements;
+	};
+
+	btPoolAllocator* m_pool;
+	int m_elemSize;
+	ThreadCache* m_threadCaches;  // BT_MAX_THREAD_COUNT, 64 byte aligned
+
+	btSpinMutex m_mutex;  // guards the arena, taken before the mutex of a thread cache
+	ArenaBlock m_arenaBlocks[MAX_ARENA_BLOCKS];
+	volatile int m_numArenaBlocks;
+	void* m_arenaFirstFree;
+	int m_arenaFreeCount;
+
+	void* refillCache(ThreadCache& cache, bool allowGrowth);
+	void takeElements(void*& firstFree, int& freeCount);
+	bool addArenaBlock();
+	void flushCache(ThreadCache& cache, int keepCount);
+
+public:
+	btThreadLocalPoolAllocator(btPoolAllocator* pool);
+	~btThreadLocalPoolAllocator();
+
+	///returns NULL if the size exceeds the element size, or if all elements are in use and allowGrowth is false
+	void* allocate(int size, bool allowGrowth = true);
+
+	///the element goes to the cache of the calling thread
+	void freeMemory(void* ptr);
+
+	///true for elements of the shared pool and of the arena blocks
+	bool validPtr(void* ptr) const;
+
+	///returns the surplus of the thread caches; not thread safe, call it between the parallel sections of a frame
+	void flushCaches();
+
+	int getElementSize() const
+	{
+		return m_elemSize;
+	}
+	btPoolAllocator* getPool()
+	{
+		return m_pool;
+	}
+	int getNumArenaBlocks() const
+	{
+		return m_numArenaBlocks;
+	}
+};
+
+#endif  //BT_THREAD_LOCAL_POOL_ALLOCATOR_H
@@ -157,6 +157,9 @@ btITaskScheduler* btGetSequentialTaskScheduler();
 // create a default task scheduler (Win32 or pthreads based)
 btITaskScheduler* btCreateDefaultTaskScheduler();
 
+// create a work-stealing task scheduler (Win32 or pthreads based), supports nested parallelFor calls
+btITaskScheduler* btCreateWorkStealingTaskScheduler();
+
 // get OpenMP task scheduler (if available, otherwise returns null)
 btITaskScheduler* btGetOpenMPTaskScheduler();
 
@@ -1662,3 +1662,211 @@ long _mindot_large_v1(const float *vv, const float *vec, unsigned long count, fl
 #endif
 
 #endif /* __APPLE__ */
+
+#ifdef BT_ALLOW_AVX2
+
+// AVX2/FMA3 versions of maxDot/minDot for targets without the SSE or NEON versions above (for example
+// x86-64 Linux or double precision builds). Like the NEON versions, the implementation is selected on the first call,
+// so they only need AVX2/FMA3 at runtime, not at compile time.
+
+#include "btCpuFeatureUtility.h"
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BT_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define BT_AVX2_TARGET
+#endif
+
+static long _maxdot_large_scalar(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult);
+static long _mindot_large_scalar(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult);
+static long _maxdot_large_avx2(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult);
+static long _mindot_large_avx2(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult);
+static long _maxdot_large_dispatch_sel(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult);
+static long _mindot_large_dispatch_sel(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult);
+
+long (*_maxdot_large_dispatch)(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult) = _maxdot_large_dispatch_sel;
+long (*_mindot_large_dispatch)(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult) = _mindot_large_dispatch_sel;
+
+static bool btHasAvx2Fma3()
+{
+	const int required = btCpuFeatureUtility::CPU_FEATURE_AVX2 | btCpuFeatureUtility::CPU_FEATURE_FMA3;
+	return (btCpuFeatureUtility::getCpuFeatures() & required) == required;
+}
+
+static long _maxdot_large_dispatch_sel(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult)
+{
+	if (btHasAvx2Fma3())
+		_maxdot_large_dispatch = _maxdot_large_avx2;
+	else
+		_maxdot_large_dispatch = _maxdot_large_scalar;
+
+	return _maxdot_large_dispatch(vv, vec, count, dotResult);
+}
+
+static long _mindot_large_dispatch_sel(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult)
+{
+	if (btHasAvx2Fma3())
+		_mindot_large_dispatch = _mindot_large_avx2;
+	else
+		_mindot_large_dispatch = _mindot_large_scalar;
+
+	return _mindot_large_dispatch(vv, vec, count, dotResult);
+}
+
+///continues the search of the extreme dot product at vertex start, the vertices are 4 btScalars apart
+static SIMD_FORCE_INLINE long btDotExtremeTail(const btScalar *vv, const btScalar *vec, unsigned long start, unsigned long count, bool findMax, btScalar &extremeDot, long extremeIndex)
+{
+	for (unsigned long i = start; i < count; i++)
+	{
+		const btScalar *v = vv + 4 * i;
+		btScalar dot = v[0] * vec[0] + v[1] * vec[1] + v[2] * vec[2];
+		if (findMax ? (dot > extremeDot) : (dot < extremeDot))
+		{
+			extremeDot = dot;
+			extremeIndex = long(i);
+		}
+	}
+	return extremeIndex;
+}
+
+static long _maxdot_large_scalar(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult)
+{
+	*dotResult = -SIMD_INFINITY;
+	return btDotExtremeTail(vv, vec, 0, count, true, *dotResult, -1L);
+}
+
+static long _mindot_large_scalar(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult)
+{
+	*dotResult = SIMD_INFINITY;
+	return btDotExtremeTail(vv, vec, 0, count, false, *dotResult, -1L);
+}
+
+#ifdef BT_USE_DOUBLE_PRECISION
+
+//4 vertices per iteration, one btVector3 fills a ymm register
+BT_AVX2_TARGET static SIMD_FORCE_INLINE long btDotExtremeAvx2(const double *vv, const double *vec, unsigned long count, double *dotResult, bool findMax)
+{
+	const __m256d vx = _mm256_set1_pd(vec[0]);
+	const __m256d vy = _mm256_set1_pd(vec[1]);
+	const __m256d vz = _mm256_set1_pd(vec[2]);
+	__m256d extreme = _mm256_set1_pd(findMax ? -SIMD_INFINITY : SIMD_INFINITY);
+	__m256d extremeIndex = _mm256_set1_pd(-1.0);
+	__m256d index = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+	const __m256d four = _mm256_set1_pd(4.0);
+
+	unsigned long i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const double *p = vv + 4 * i;
+		__m256d a = _mm256_loadu_pd(p);
+		__m256d b = _mm256_loadu_pd(p + 4);
+		__m256d c = _mm256_loadu_pd(p + 8);
+		__m256d d = _mm256_loadu_pd(p + 12);
+		__m256d xzab = _mm256_unpacklo_pd(a, b);  // x0 x1 z0 z1
+		__m256d ywab = _mm256_unpackhi_pd(a, b);  // y0 y1 w0 w1
+		__m256d xzcd = _mm256_unpacklo_pd(c, d);  // x2 x3 z2 z3
+		__m256d ywcd = _mm256_unpackhi_pd(c, d);  // y2 y3 w2 w3
+		__m256d x = _mm256_permute2f128_pd(xzab, xzcd, 0x20);
+		__m256d y = _mm256_permute2f128_pd(ywab, ywcd, 0x20);
+		__m256d z = _mm256_permute2f128_pd(xzab, xzcd, 0x31);
+		__m256d dot = _mm256_fmadd_pd(z, vz, _mm256_fmadd_pd(y, vy, _mm256_mul_pd(x, vx)));
+		__m256d mask = findMax ? _mm256_cmp_pd(dot, extreme, _CMP_GT_OQ) : _mm256_cmp_pd(dot, extreme, _CMP_LT_OQ);
+		extreme = _mm256_blendv_pd(extreme, dot, mask);
+		extremeIndex = _mm256_blendv_pd(extremeIndex, index, mask);
+		index = _mm256_add_pd(index, four);
+	}
+
+	double laneDot[4];
+	double laneIndex[4];
+	_mm256_storeu_pd(laneDot, extreme);
+	_mm256_storeu_pd(laneIndex, extremeIndex);
+	*dotResult = findMax ? -SIMD_INFINITY : SIMD_INFINITY;
+	long result = -1L;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		long laneVertex = long(laneIndex[lane]);
+		if (laneVertex < 0)
+			continue;
+		//the scalar loop returns the first vertex on ties
+		if ((findMax ? (laneDot[lane] > *dotResult) : (laneDot[lane] < *dotResult)) || (laneDot[lane] == *dotResult && laneVertex < result))
+		{
+			*dotResult = laneDot[lane];
+			result = laneVertex;
+		}
+	}
+	return btDotExtremeTail(vv, vec, i, count, findMax, *dotResult, result);
+}
+
+#else  //BT_USE_DOUBLE_PRECISION
+
+//8 vertices per iteration, each ymm register holds two btVector3
+BT_AVX2_TARGET static SIMD_FORCE_INLINE long btDotExtremeAvx2(const float *vv, const float *vec, unsigned long count, float *dotResult, bool findMax)
+{
+	const __m256 vx = _mm256_set1_ps(vec[0]);
+	const __m256 vy = _mm256_set1_ps(vec[1]);
+	const __m256 vz = _mm256_set1_ps(vec[2]);
+	__m256 extreme = _mm256_set1_ps(findMax ? -SIMD_INFINITY : SIMD_INFINITY);
+	__m256i extremeIndex = _mm256_set1_epi32(-1);
+	//the transpose below leaves the vertices in this order in the lanes
+	__m256i index = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	const __m256i eight = _mm256_set1_epi32(8);
+
+	unsigned long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const float *p = vv + 4 * i;
+		__m256 a = _mm256_loadu_ps(p);       // v0 | v1
+		__m256 b = _mm256_loadu_ps(p + 8);   // v2 | v3
+		__m256 c = _mm256_loadu_ps(p + 16);  // v4 | v5
+		__m256 d = _mm256_loadu_ps(p + 24);  // v6 | v7
+		__m256 xyab = _mm256_unpacklo_ps(a, b);  // x0 x2 y0 y2 | x1 x3 y1 y3
+		__m256 zwab = _mm256_unpackhi_ps(a, b);  // z0 z2 w0 w2 | z1 z3 w1 w3
+		__m256 xycd = _mm256_unpacklo_ps(c, d);
+		__m256 zwcd = _mm256_unpackhi_ps(c, d);
+		__m256 x = _mm256_shuffle_ps(xyab, xycd, _MM_SHUFFLE(1, 0, 1, 0));  // x0 x2 x4 x6 | x1 x3 x5 x7
+		__m256 y = _mm256_shuffle_ps(xyab, xycd, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 z = _mm256_shuffle_ps(zwab, zwcd, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 dot = _mm256_fmadd_ps(z, vz, _mm256_fmadd_ps(y, vy, _mm256_mul_ps(x, vx)));
+		__m256 mask = findMax ? _mm256_cmp_ps(dot, extreme, _CMP_GT_OQ) : _mm256_cmp_ps(dot, extreme, _CMP_LT_OQ);
+		extreme = _mm256_blendv_ps(extreme, dot, mask);
+		extremeIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(extremeIndex), _mm256_castsi256_ps(index), mask));
+		index = _mm256_add_epi32(index, eight);
+	}
+
+	float laneDot[8];
+	int laneIndex[8];
+	_mm256_storeu_ps(laneDot, extreme);
+	_mm256_storeu_si256((__m256i *)laneIndex, extremeIndex);
+	*dotResult = findMax ? -SIMD_INFINITY : SIMD_INFINITY;
+	long result = -1L;
+	for (int lane = 0; lane < 8; lane++)
+	{
+		long laneVertex = laneIndex[lane];
+		if (laneVertex < 0)
+			continue;
+		//the scalar loop returns the first vertex on ties
+		if ((findMax ? (laneDot[lane] > *dotResult) : (laneDot[lane] < *dotResult)) || (laneDot[lane] == *dotResult && laneVertex < result))
+		{
+			*dotResult = laneDot[lane];
+			result = laneVertex;
+		}
+	}
+	return btDotExtremeTail(vv, vec, i, count, findMax, *dotResult, result);
+}
+
+#endif  //BT_USE_DOUBLE_PRECISION
+
+BT_AVX2_TARGET static long _maxdot_large_avx2(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult)
+{
+	return btDotExtremeAvx2(vv, vec, count, dotResult, true);
+}
+
+BT_AVX2_TARGET static long _mindot_large_avx2(const btScalar *vv, const btScalar *vec, unsigned long count, btScalar *dotResult)
+{
+	return btDotExtremeAvx2(vv, vec, count, dotResult, false);
+}
+
+#undef BT_AVX2_TARGET
+
+#endif  //BT_ALLOW_AVX2
@@ -1006,6 +1006,14 @@ SIMD_FORCE_INLINE long btVector3::maxDot(const btVector3* array, long array_coun
 	extern long (*_maxdot_large)(const float* array, const float* vec, unsigned long array_count, float* dotOut);
 #endif
 	if (array_count < scalar_cutoff)
+#elif defined(BT_ALLOW_AVX2)
+	//selects the AVX2/FMA3 version at runtime, see btVector3.cpp
+	const long scalar_cutoff = 8;
+	extern long (*_maxdot_large_dispatch)(const btScalar* array, const btScalar* vec, unsigned long array_count, btScalar* dotOut);
+	if (array_count >= scalar_cutoff)
+	{
+		return _maxdot_large_dispatch((const btScalar*)array, &m_floats[0], array_count, &dotOut);
+	}
 #endif
 	{
 		btScalar maxDot1 = -SIMD_INFINITY;
@@ -1044,6 +1052,13 @@ SIMD_FORCE_INLINE long btVector3::minDot(const btVector3* array, long array_coun
 #endif
 
 	if (array_count < scalar_cutoff)
+#elif defined(BT_ALLOW_AVX2)
+	const long scalar_cutoff = 8;
+	extern long (*_mindot_large_dispatch)(const btScalar* array, const btScalar* vec, unsigned long array_count, btScalar* dotOut);
+	if (array_count >= scalar_cutoff)
+	{
+		return _mindot_large_dispatch((const btScalar*)array, &m_floats[0], array_count, &dotOut);
+	}
 #endif
 	{
 		btScalar minDot = SIMD_INFINITY;
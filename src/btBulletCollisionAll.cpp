@@ -3,6 +3,7 @@
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.cpp"
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.cpp"
 #include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.cpp"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphaseMt.cpp"
 #include "BulletCollision/BroadphaseCollision/btQuantizedBvh.cpp"
 #include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.cpp"
 #include "BulletCollision/BroadphaseCollision/btDispatcher.cpp"
@@ -21,6 +22,9 @@
 #include "BulletCollision/CollisionDispatch/btSimulationIslandManager.cpp"
 #include "BulletCollision/CollisionDispatch/btBoxBoxDetector.cpp"
 #include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.cpp"
+#include "BulletCollision/CollisionDispatch/btConvexConvexMprAlgorithm.cpp"
+#include "BulletCollision/CollisionDispatch/btConvexHeightfieldCollisionAlgorithm.cpp"
+#include "BulletCollision/CollisionDispatch/btPrimitivePairCollisionAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btSphereBoxCollisionAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.cpp"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.cpp"
@@ -29,6 +33,7 @@
 #include "BulletCollision/CollisionDispatch/btCollisionObject.cpp"
 #include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.cpp"
 #include "BulletCollision/CollisionDispatch/btSphereTriangleCollisionAlgorithm.cpp"
+#include "BulletCollision/CollisionDispatch/btSdfCollisionAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btCollisionWorld.cpp"
 #include "BulletCollision/CollisionDispatch/btEmptyCollisionAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btUnionFind.cpp"
@@ -48,6 +53,7 @@
 #include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.cpp"
 #include "BulletCollision/CollisionShapes/btBox2dShape.cpp"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.cpp"
+#include "BulletCollision/CollisionShapes/btConvexSupportAccelerator.cpp"
 #include "BulletCollision/CollisionShapes/btShapeHull.cpp"
 #include "BulletCollision/CollisionShapes/btBoxShape.cpp"
 #include "BulletCollision/CollisionShapes/btConvexShape.cpp"
@@ -63,6 +69,7 @@
 #include "BulletCollision/CollisionShapes/btTetrahedronShape.cpp"
 #include "BulletCollision/CollisionShapes/btCompoundShape.cpp"
 #include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.cpp"
+#include "BulletCollision/CollisionShapes/btTiledHeightfieldTerrainShape.cpp"
 #include "BulletCollision/CollisionShapes/btTriangleBuffer.cpp"
 #include "BulletCollision/CollisionShapes/btConcaveShape.cpp"
 #include "BulletCollision/CollisionShapes/btMinkowskiSumShape.cpp"
@@ -83,7 +90,9 @@
 #include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.cpp"
 #include "BulletCollision/CollisionShapes/btSdfCollisionShape.cpp"
 #include "BulletCollision/CollisionShapes/btMiniSDF.cpp"
+#include "BulletCollision/CollisionShapes/btMiniSDFBuilder.cpp"
 #include "BulletCollision/CollisionShapes/btUniformScalingShape.cpp"
+#include "BulletCollision/CollisionShapes/btWideBvh.cpp"
 #include "BulletCollision/Gimpact/btContactProcessing.cpp"
 #include "BulletCollision/Gimpact/btGImpactQuantizedBvh.cpp"
 #include "BulletCollision/Gimpact/btTriangleShapeEx.cpp"
@@ -1,9 +1,11 @@
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.cpp"
 #include "BulletDynamics/Dynamics/btRigidBody.cpp"
+#include "BulletDynamics/Dynamics/btRigidBodyStateSoA.cpp"
 #include "BulletDynamics/Dynamics/btSimulationIslandManagerMt.cpp"
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.cpp"
 #include "BulletDynamics/Dynamics/btSimpleDynamicsWorld.cpp"
 #include "BulletDynamics/ConstraintSolver/btBatchedConstraints.cpp"
+#include "BulletDynamics/ConstraintSolver/btBatchedContactRowsSoA.cpp"
 #include "BulletDynamics/ConstraintSolver/btConeTwistConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btGeneric6DofSpringConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btSliderConstraint.cpp"
@@ -26,6 +28,7 @@
 #include "BulletDynamics/MLCPSolvers/btMLCPSolver.cpp"
 #include "BulletDynamics/Featherstone/btMultiBody.cpp"
 #include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.cpp"
+#include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorldMt.cpp"
 #include "BulletDynamics/Featherstone/btMultiBodyJointMotor.cpp"
 #include "BulletDynamics/Featherstone/btMultiBodyGearConstraint.cpp"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraint.cpp"
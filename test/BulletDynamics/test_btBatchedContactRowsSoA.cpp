@@ -0,0 +1,254 @@
+
+#include <btBulletDynamicsCommon.h>
+#include <LinearMath/btThreads.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/ConstraintSolver/btBatchedContactRowsSoA.h>
+#include <gtest/gtest.h>
+
+//records the residual of the last iteration of the last island
+template <typename btSolver>
+struct btResidualSolver : public btSolver
+{
+	btScalar m_residual;
+
+	btResidualSolver()
+		: m_residual(0)
+	{
+	}
+
+	virtual btScalar solveSingleIteration(int iteration, btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+	{
+		btScalar residual = btSolver::solveSingleIteration(iteration, bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+		//the world also calls the solver without bodies after the islands
+		if (numBodies > 0)
+		{
+			m_residual = residual;
+		}
+		return residual;
+	}
+};
+
+//a pyramid of boxes on the ground, one island with enough contact rows for btBatchedContactRowsSoA,
+//or a grid of separate boxes
+struct btPyramidWorld
+{
+	btDefaultCollisionConfiguration* m_configuration;
+	btCollisionDispatcher* m_dispatcher;
+	btDbvtBroadphase* m_broadphase;
+	btSequentialImpulseConstraintSolver* m_solver;
+	btDiscreteDynamicsWorld* m_world;
+	btBoxShape* m_groundShape;
+	btBoxShape* m_boxShape;
+	btAlignedObjectArray<btRigidBody*> m_boxes;
+	btScalar (*m_getResidual)(const btSequentialImpulseConstraintSolver* solver);
+
+	//numLayers layers of boxes on the ground, each one box narrower than the one below. A spacing below the box size pushes the boxes
+	//into each other and into the ground, for the split impulse
+	btPyramidWorld(bool useMt, int solverMode, int width, int numLayers, int depth, btScalar spacing, const btVector3& gravity)
+	{
+		createSolver(useMt);
+		m_configuration = new btDefaultCollisionConfiguration();
+		m_dispatcher = new btCollisionDispatcher(m_configuration);
+		m_broadphase = new btDbvtBroadphase();
+		m_world = new btDiscreteDynamicsWorld(m_dispatcher, m_broadphase, m_solver, m_configuration);
+		m_world->getSolverInfo().m_solverMode = solverMode;
+		m_world->setGravity(gravity);
+
+		m_groundShape = new btBoxShape(btVector3(50, 1, 50));
+		btRigidBody::btRigidBodyConstructionInfo groundInfo(0, 0, m_groundShape);
+		groundInfo.m_startWorldTransform.setOrigin(btVector3(0, -1, 0));
+		groundInfo.m_friction = 1;
+		m_world->addRigidBody(new btRigidBody(groundInfo));
+
+		const btScalar halfExtent = btScalar(0.5);
+		m_boxShape = new btBoxShape(btVector3(halfExtent, halfExtent, halfExtent));
+		btVector3 localInertia;
+		m_boxShape->calculateLocalInertia(1, localInertia);
+		const btScalar height = btMin(spacing, 2 * halfExtent);
+		for (int layer = 0; layer < numLayers; layer++)
+		{
+			for (int i = 0; i < width - layer; i++)
+			{
+				for (int k = 0; k < depth; k++)
+				{
+					btRigidBody::btRigidBodyConstructionInfo info(1, 0, m_boxShape, localInertia);
+					info.m_startWorldTransform.setOrigin(btVector3((i - btScalar(0.5) * (width - layer - 1)) * spacing, height - halfExtent + layer * height, k * spacing));
+					info.m_friction = 1;
+					btRigidBody* box = new btRigidBody(info);
+					box->setActivationState(DISABLE_DEACTIVATION);
+					m_world->addRigidBody(box);
+					m_boxes.push_back(box);
+				}
+			}
+		}
+	}
+
+	template <typename btSolver>
+	static btScalar getSolverResidual(const btSequentialImpulseConstraintSolver* solver)
+	{
+		return static_cast<const btResidualSolver<btSolver>*>(solver)->m_residual;
+	}
+
+	//btSequentialImpulseConstraintSolverMt needs a BT_THREADSAFE build
+	void createSolver(bool useMt)
+	{
+#if BT_THREADSAFE
+		if (useMt)
+		{
+			m_solver = new btResidualSolver<btSequentialImpulseConstraintSolverMt>();
+			m_getResidual = getSolverResidual<btSequentialImpulseConstraintSolverMt>;
+			return;
+		}
+#endif
+		m_solver = new btResidualSolver<btSequentialImpulseConstraintSolver>();
+		m_getResidual = getSolverResidual<btSequentialImpulseConstraintSolver>;
+	}
+
+	~btPyramidWorld()
+	{
+		for (int i = m_world->getNumCollisionObjects() - 1; i >= 0; i--)
+		{
+			btCollisionObject* obj = m_world->getCollisionObjectArray()[i];
+			m_world->removeCollisionObject(obj);
+			delete obj;
+		}
+		delete m_boxShape;
+		delete m_groundShape;
+		delete m_world;
+		delete m_solver;
+		delete m_broadphase;
+		delete m_dispatcher;
+		delete m_configuration;
+	}
+
+	void stepSimulation(int numSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+		}
+	}
+
+	btScalar getResidual() const
+	{
+		return m_getResidual(m_solver);
+	}
+
+	btScalar getMaxSpeed() const
+	{
+		btScalar maxSpeed = 0;
+		for (int i = 0; i < m_boxes.size(); i++)
+		{
+			maxSpeed = btMax(maxSpeed, m_boxes[i]->getLinearVelocity().length());
+		}
+		return maxSpeed;
+	}
+
+	btScalar getMaxDistance(const btPyramidWorld& other) const
+	{
+		btScalar maxDistance = 0;
+		for (int i = 0; i < m_boxes.size(); i++)
+		{
+			maxDistance = btMax(maxDistance, m_boxes[i]->getWorldTransform().getOrigin().distance(other.m_boxes[i]->getWorldTransform().getOrigin()));
+		}
+		return maxDistance;
+	}
+
+	btScalar getMeanHeight() const
+	{
+		btScalar height = 0;
+		for (int i = 0; i < m_boxes.size(); i++)
+		{
+			height += m_boxes[i]->getWorldTransform().getOrigin().y();
+		}
+		return height / btScalar(m_boxes.size());
+	}
+};
+
+//the blocks visit the rows in a different order than the contact pool, so the results are not identical,
+//but the pyramid must stand the same way and the solver must converge as well
+static void testSoAMatchesPerRow(bool useMt, int solverMode)
+{
+	const btVector3 gravity(0, -10, 0);
+	btPyramidWorld perRow(useMt, solverMode, 6, 6, 2, 1, gravity);
+	btPyramidWorld soa(useMt, solverMode | SOLVER_SIMD_BATCHED_CONTACTS, 6, 6, 2, 1, gravity);
+	btScalar perRowResidual = 0;
+	btScalar soaResidual = 0;
+	for (int i = 0; i < 120; i++)
+	{
+		perRow.stepSimulation(1);
+		soa.stepSimulation(1);
+		perRowResidual += perRow.getResidual();
+		soaResidual += soa.getResidual();
+	}
+	//without SIMD lanes the flag is ignored
+	if (btBatchedContactRowsSoA::getNumLanes() > 1)
+	{
+		EXPECT_GT(soa.getMaxDistance(perRow), btScalar(0.));
+	}
+	EXPECT_LT(soa.getMaxDistance(perRow), btScalar(0.05));
+	EXPECT_LT(soa.getMaxSpeed(), btScalar(2.) * perRow.getMaxSpeed() + btScalar(0.01));
+	EXPECT_GT(perRowResidual, btScalar(0.));
+	EXPECT_LT(soaResidual, btScalar(2.) * perRowResidual);
+}
+
+GTEST_TEST(BulletDynamics, BatchedContactRowsSoAMatchesPerRowStacking)
+{
+	const int oldMinimumContactManifoldsForBatching = btSequentialImpulseConstraintSolverMt::s_minimumContactManifoldsForBatching;
+	btSequentialImpulseConstraintSolverMt::s_minimumContactManifoldsForBatching = 1;
+	const int solverModes[3] = {
+		SOLVER_USE_WARMSTARTING | SOLVER_SIMD,
+		SOLVER_USE_WARMSTARTING | SOLVER_SIMD | SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS,
+		SOLVER_USE_WARMSTARTING | SOLVER_SIMD | SOLVER_USE_2_FRICTION_DIRECTIONS | SOLVER_DISABLE_VELOCITY_DEPENDENT_FRICTION_DIRECTION};
+	for (int m = 0; m < 3; m++)
+	{
+		testSoAMatchesPerRow(false, solverModes[m]);
+#if BT_THREADSAFE
+		testSoAMatchesPerRow(true, solverModes[m]);
+#endif
+	}
+	btSequentialImpulseConstraintSolverMt::s_minimumContactManifoldsForBatching = oldMinimumContactManifoldsForBatching;
+}
+
+#if BT_THREADSAFE
+//the batched friction rows of btSequentialImpulseConstraintSolverMt skipped every other friction row, and its batched split impulse
+//stopped after the first iteration. Both must give the results of btSequentialImpulseConstraintSolver.
+GTEST_TEST(BulletDynamics, BatchedSolverMtFrictionAndSplitImpulse)
+{
+	const int oldMinimumContactManifoldsForBatching = btSequentialImpulseConstraintSolverMt::s_minimumContactManifoldsForBatching;
+	btSequentialImpulseConstraintSolverMt::s_minimumContactManifoldsForBatching = 1;
+	//the friction directions are x and z on the ground, so the boxes would slide along z on the second direction
+	const int solverMode = SOLVER_USE_WARMSTARTING | SOLVER_SIMD | SOLVER_USE_2_FRICTION_DIRECTIONS | SOLVER_DISABLE_VELOCITY_DEPENDENT_FRICTION_DIRECTION;
+	{
+		const btScalar slope = btScalar(0.4);
+		const btVector3 gravity(0, -10 * btCos(slope), 10 * btSin(slope));
+		btPyramidWorld st(false, solverMode, 8, 1, 8, btScalar(1.5), gravity);
+		btPyramidWorld mt(true, solverMode, 8, 1, 8, btScalar(1.5), gravity);
+		st.stepSimulation(60);
+		mt.stepSimulation(60);
+		EXPECT_LT(st.getMaxSpeed(), btScalar(0.01));
+		EXPECT_LT(mt.getMaxSpeed(), btScalar(0.01));
+		EXPECT_LT(mt.getMaxDistance(st), btScalar(0.01));
+	}
+	//the boxes start 0.1 deep in each other and in the ground
+	{
+		const btVector3 gravity(0, -10, 0);
+		btPyramidWorld st(false, solverMode, 10, 10, 2, btScalar(0.9), gravity);
+		btPyramidWorld mt(true, solverMode, 10, 10, 2, btScalar(0.9), gravity);
+		st.stepSimulation(5);
+		mt.stepSimulation(5);
+		EXPECT_NEAR(st.getMeanHeight(), mt.getMeanHeight(), 0.02);
+	}
+	btSequentialImpulseConstraintSolverMt::s_minimumContactManifoldsForBatching = oldMinimumContactManifoldsForBatching;
+}
+#endif  //BT_THREADSAFE
+
+int main(int argc, char** argv)
+{
+#if BT_THREADSAFE
+	//the batches of btSequentialImpulseConstraintSolverMt are set up with btParallelFor
+	btSetTaskScheduler(btGetSequentialTaskScheduler());
+#endif
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,201 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btMiniSDF.h>
+#include <BulletCollision/CollisionShapes/btMiniSDFBuilder.h>
+#include <BulletCollision/CollisionShapes/btSdfCollisionShape.h>
+#include <gtest/gtest.h>
+
+//a box with half extents 1.5 in a field over -4..4 with cells of 0.25, so the bricks of 4 cells are one unit wide:
+//the bricks within 0..1 of the center are deeper than the band and the bricks of the domain corners are far outside
+static const btScalar s_halfExtent = btScalar(1.5);
+static const btScalar s_bandWidth = btScalar(0.25);
+
+static void addBoxTriangles(btTriangleMesh* mesh, btScalar h)
+{
+	const btVector3 v[8] = {
+		btVector3(-h, -h, -h), btVector3(h, -h, -h), btVector3(h, h, -h), btVector3(-h, h, -h),
+		btVector3(-h, -h, h), btVector3(h, -h, h), btVector3(h, h, h), btVector3(-h, h, h)};
+	//counter clockwise seen from the outside
+	const int indices[36] = {
+		0, 2, 1, 0, 3, 2,
+		4, 5, 6, 4, 6, 7,
+		0, 1, 5, 0, 5, 4,
+		3, 6, 2, 3, 7, 6,
+		0, 4, 7, 0, 7, 3,
+		1, 2, 6, 1, 6, 5};
+	for (int i = 0; i < 36; i += 3)
+	{
+		mesh->addTriangle(v[indices[i]], v[indices[i + 1]], v[indices[i + 2]]);
+	}
+}
+
+static btSdfCollisionShape* createBoxSdfShape(bool narrowBand)
+{
+	btTriangleMesh mesh;
+	addBoxTriangles(&mesh, s_halfExtent);
+	btMiniSDFBuilder builder;
+	builder.setResolution(32, 32, 32);
+	builder.setDomain(btVector3(-4, -4, -4), btVector3(4, 4, 4));
+	btAlignedObjectArray<char> sdfData;
+	EXPECT_TRUE(builder.build(&mesh, sdfData));
+	btSdfCollisionShape* shape = new btSdfCollisionShape();
+	EXPECT_TRUE(shape->initializeSDF(&sdfData[0], sdfData.size()));
+	if (narrowBand)
+	{
+		shape->buildNarrowBand(s_bandWidth);
+	}
+	return shape;
+}
+
+GTEST_TEST(BulletCollision, MiniSDFNarrowBandFarField)
+{
+	btSdfCollisionShape* dense = createBoxSdfShape(false);
+	btSdfCollisionShape* banded = createBoxSdfShape(true);
+	ASSERT_TRUE(banded->getSDF().hasNarrowBand());
+	EXPECT_LT(banded->getSDF().calculateMemorySize(), dense->getSDF().calculateMemorySize());
+
+	//deep inside, far outside, and within the band inside and outside of the surface
+	const btVector3 points[4] = {
+		btVector3(0.4, 0.3, 0.2),
+		btVector3(3.5, 3.6, 3.7),
+		btVector3(1.4, 0.3, 0.2),
+		btVector3(0.3, 1.6, 0.2)};
+	btScalar distances[4];
+	btVector3 gradients[4];
+	EXPECT_EQ(4, banded->queryPoints(points, 4, distances, gradients));
+
+	EXPECT_FLOAT_EQ(-s_bandWidth, distances[0]);
+	EXPECT_GT(gradients[0].length(), btScalar(0.5));
+	EXPECT_FLOAT_EQ(s_bandWidth, distances[1]);
+	EXPECT_GT(gradients[1].length(), btScalar(0.5));
+	//the far outside brick is in the positive octant, so its gradient points away from the box
+	EXPECT_GT(gradients[1].dot(points[1]), btScalar(0.));
+
+	EXPECT_NEAR(-0.1, distances[2], 0.01);
+	EXPECT_NEAR(0.1, distances[3], 0.01);
+	EXPECT_NEAR(1.0, gradients[2].x(), 0.05);
+	EXPECT_NEAR(1.0, gradients[3].y(), 0.05);
+
+	//the batched query matches the single point queries
+	for (int i = 0; i < 4; i++)
+	{
+		btScalar dist;
+		btVector3 gradient;
+		EXPECT_TRUE(banded->queryPoint(points[i], dist, gradient));
+		EXPECT_NEAR(distances[i], dist, 1e-4);
+		EXPECT_NEAR(0, (gradients[i] - gradient).length(), 1e-3);
+	}
+
+	//within the band, the narrow band storage matches the dense field
+	btScalar denseDistances[4];
+	btVector3 denseGradients[4];
+	EXPECT_EQ(4, dense->queryPoints(points, 4, denseDistances, denseGradients));
+	EXPECT_NEAR(denseDistances[2], distances[2], 1e-4);
+	EXPECT_NEAR(denseDistances[3], distances[3], 1e-4);
+	EXPECT_LT(denseDistances[0], -s_bandWidth);
+	EXPECT_GT(denseDistances[1], s_bandWidth);
+
+	//outside of the domain there is no distance
+	const btVector3 outside(5, 0, 0);
+	btScalar dist;
+	btVector3 gradient;
+	EXPECT_FALSE(banded->queryPoint(outside, dist, gradient));
+
+	delete banded;
+	delete dense;
+}
+
+struct btSdfContactCallback : public btCollisionWorld::ContactResultCallback
+{
+	int m_numContacts;
+	btScalar m_minDistance;
+	btVector3 m_normalOnSdf;
+
+	btSdfContactCallback()
+		: m_numContacts(0),
+		  m_minDistance(BT_LARGE_FLOAT),
+		  m_normalOnSdf(0, 0, 0)
+	{
+	}
+
+	virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0, const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1)
+	{
+		m_numContacts++;
+		if (cp.getDistance() < m_minDistance)
+		{
+			m_minDistance = cp.getDistance();
+			//the normal on B points from B to A, make it point out of the sdf shape
+			const bool sdfIsB = colObj1Wrap->getCollisionShape()->getShapeType() == SDF_SHAPE_PROXYTYPE;
+			m_normalOnSdf = sdfIsB ? cp.m_normalWorldOnB : -cp.m_normalWorldOnB;
+		}
+		return 0;
+	}
+};
+
+GTEST_TEST(BulletCollision, SdfContactsInsideAndBeyondBand)
+{
+	btDefaultCollisionConstructionInfo constructionInfo;
+	constructionInfo.m_useSdfCollisionAlgorithm = true;
+	btDefaultCollisionConfiguration* configuration = new btDefaultCollisionConfiguration(constructionInfo);
+	btCollisionDispatcher* dispatcher = new btCollisionDispatcher(configuration);
+	btDbvtBroadphase* broadphase = new btDbvtBroadphase();
+	btCollisionWorld* world = new btCollisionWorld(dispatcher, broadphase, configuration);
+
+	btSdfCollisionShape* sdfShape = createBoxSdfShape(true);
+	btCollisionObject* sdfObject = new btCollisionObject();
+	sdfObject->setCollisionShape(sdfShape);
+	world->addCollisionObject(sdfObject);
+
+	btSphereShape* sphereShape = new btSphereShape(btScalar(0.2));
+	btCollisionObject* sphereObject = new btCollisionObject();
+	sphereObject->setCollisionShape(sphereShape);
+	world->addCollisionObject(sphereObject);
+
+	//resting on the top face, within the band
+	{
+		btTransform trans(btQuaternion::getIdentity(), btVector3(0.3, s_halfExtent + btScalar(0.15), 0.2));
+		sphereObject->setWorldTransform(trans);
+		btSdfContactCallback callback;
+		world->contactPairTest(sphereObject, sdfObject, callback);
+		EXPECT_GT(callback.m_numContacts, 0);
+		EXPECT_NEAR(-0.05, callback.m_minDistance, 0.02);
+		EXPECT_NEAR(1.0, callback.m_normalOnSdf.y(), 0.05);
+	}
+
+	//sunk past the band: the clamped far field still reports a penetrating contact
+	{
+		btTransform trans(btQuaternion::getIdentity(), btVector3(0.4, 0.6, 0.3));
+		sphereObject->setWorldTransform(trans);
+		btSdfContactCallback callback;
+		world->contactPairTest(sphereObject, sdfObject, callback);
+		EXPECT_GT(callback.m_numContacts, 0);
+		EXPECT_LE(callback.m_minDistance, -s_bandWidth);
+		EXPECT_GT(callback.m_normalOnSdf.length(), btScalar(0.99));
+	}
+
+	//far outside, in the clamped outside field: no contact
+	{
+		btTransform trans(btQuaternion::getIdentity(), btVector3(3.5, 3.5, 3.5));
+		sphereObject->setWorldTransform(trans);
+		btSdfContactCallback callback;
+		world->contactPairTest(sphereObject, sdfObject, callback);
+		EXPECT_EQ(0, callback.m_numContacts);
+	}
+
+	world->removeCollisionObject(sphereObject);
+	world->removeCollisionObject(sdfObject);
+	delete sphereObject;
+	delete sphereShape;
+	delete sdfObject;
+	delete sdfShape;
+	delete world;
+	delete broadphase;
+	delete dispatcher;
+	delete configuration;
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+
+#include <btBulletDynamicsCommon.h>
+#include <gtest/gtest.h>
+
+struct btSpeculativeContactsWorld
+{
+	btDefaultCollisionConfiguration* m_configuration;
+	btCollisionDispatcher* m_dispatcher;
+	btDbvtBroadphase* m_broadphase;
+	btSequentialImpulseConstraintSolver* m_solver;
+	btDiscreteDynamicsWorld* m_world;
+	btAlignedObjectArray<btCollisionShape*> m_shapes;
+
+	btSpeculativeContactsWorld()
+	{
+		m_configuration = new btDefaultCollisionConfiguration();
+		m_dispatcher = new btCollisionDispatcher(m_configuration);
+		m_broadphase = new btDbvtBroadphase();
+		m_solver = new btSequentialImpulseConstraintSolver();
+		m_world = new btDiscreteDynamicsWorld(m_dispatcher, m_broadphase, m_solver, m_configuration);
+		m_world->setUseSpeculativeContacts(true);
+	}
+
+	~btSpeculativeContactsWorld()
+	{
+		for (int i = m_world->getNumCollisionObjects() - 1; i >= 0; i--)
+		{
+			btCollisionObject* obj = m_world->getCollisionObjectArray()[i];
+			m_world->removeCollisionObject(obj);
+			delete obj;
+		}
+		for (int i = 0; i < m_shapes.size(); i++)
+		{
+			delete m_shapes[i];
+		}
+		delete m_world;
+		delete m_solver;
+		delete m_broadphase;
+		delete m_dispatcher;
+		delete m_configuration;
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& origin)
+	{
+		m_shapes.push_back(shape);
+		btVector3 localInertia(0, 0, 0);
+		if (mass > btScalar(0.))
+		{
+			shape->calculateLocalInertia(mass, localInertia);
+		}
+		btRigidBody::btRigidBodyConstructionInfo info(mass, 0, shape, localInertia);
+		info.m_startWorldTransform.setOrigin(origin);
+		btRigidBody* body = new btRigidBody(info);
+		body->setActivationState(DISABLE_DEACTIVATION);
+		m_world->addRigidBody(body);
+		return body;
+	}
+};
+
+GTEST_TEST(BulletDynamics, SpeculativeContactsStopFastBodiesAtThinBox)
+{
+	//5 cm thick, while the bodies move 5 m per step
+	const btScalar speed = btScalar(300.);
+	const btScalar timeStep = btScalar(1.) / btScalar(60.);
+	for (int s = 0; s < 2; s++)
+	{
+		btSpeculativeContactsWorld world;
+		world.m_world->setGravity(btVector3(0, 0, 0));
+		world.addBody(new btBoxShape(btVector3(btScalar(0.025), 10, 10)), 0, btVector3(0, 0, 0));
+		btCollisionShape* shape = s == 0 ? (btCollisionShape*)new btBoxShape(btVector3(0.5, 0.5, 0.5)) : (btCollisionShape*)new btSphereShape(0.5);
+		btRigidBody* body = world.addBody(shape, 1, btVector3(-12, 0.3, -0.2));
+		body->setLinearVelocity(btVector3(speed, 0, 0));
+		body->setAngularVelocity(btVector3(3, 5, 7));
+
+		for (int i = 0; i < 30; i++)
+		{
+			world.m_world->stepSimulation(timeStep, 0);
+			EXPECT_LT(body->getWorldTransform().getOrigin().x(), btScalar(0.));
+		}
+		//it stopped at the box, the spinning box may roll off with a small part of its speed
+		EXPECT_LT(btFabs(body->getLinearVelocity().x()), btScalar(0.05) * speed);
+	}
+}
+
+GTEST_TEST(BulletDynamics, SpeculativeContactsNoSupportBeyondLedge)
+{
+	//a coarse mesh of two triangles for a plateau at y = 0 over x < 0, and two for the floor at y = -5 over x > 0
+	btTriangleMesh* mesh = new btTriangleMesh();
+	mesh->addTriangle(btVector3(-20, 0, -20), btVector3(-20, 0, 20), btVector3(0, 0, 20));
+	mesh->addTriangle(btVector3(-20, 0, -20), btVector3(0, 0, 20), btVector3(0, 0, -20));
+	mesh->addTriangle(btVector3(0, -5, -20), btVector3(0, -5, 20), btVector3(20, -5, 20));
+	mesh->addTriangle(btVector3(0, -5, -20), btVector3(20, -5, 20), btVector3(20, -5, -20));
+
+	btSpeculativeContactsWorld world;
+	world.addBody(new btBvhTriangleMeshShape(mesh, true), 0, btVector3(0, 0, 0));
+
+	//a box resting on the plateau with its center of mass beyond the ledge tips over, the vertices
+	//beyond the ledge must not get contacts on the extended plane of the plateau triangles
+	btRigidBody* box = world.addBody(new btBoxShape(btVector3(1, 0.25, 1)), 1, btVector3(btScalar(0.3), btScalar(0.25), 0));
+	for (int i = 0; i < 120; i++)
+	{
+		world.m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+	}
+	EXPECT_LT(box->getWorldTransform().getOrigin().y(), btScalar(-2.));
+
+	//the same box with its center of mass on the plateau keeps resting there
+	btSpeculativeContactsWorld world2;
+	world2.addBody(new btBvhTriangleMeshShape(mesh, true), 0, btVector3(0, 0, 0));
+	btRigidBody* box2 = world2.addBody(new btBoxShape(btVector3(1, 0.25, 1)), 1, btVector3(btScalar(-0.3), btScalar(0.25), 0));
+	for (int i = 0; i < 120; i++)
+	{
+		world2.m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+	}
+	EXPECT_NEAR(0.25, box2->getWorldTransform().getOrigin().y(), 0.05);
+	EXPECT_NEAR(-0.3, box2->getWorldTransform().getOrigin().x(), 0.05);
+
+	delete mesh;
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,76 @@
+#ifndef BVH_TEST_UTIL_H
+#define BVH_TEST_UTIL_H
+
+#include <btBulletCollisionCommon.h>
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+///helpers of the triangle mesh bvh tests: a terrain mesh, random query points and a callback that collects the reported triangles
+
+struct btLessIntPredicate
+{
+	bool operator()(const int& a, const int& b) const
+	{
+		return a < b;
+	}
+};
+
+struct btCollectTrianglesCallback : public btNodeOverlapCallback
+{
+	btAlignedObjectArray<int> m_triangles;
+
+	virtual void processNode(int subPart, int triangleIndex)
+	{
+		EXPECT_EQ(0, subPart);
+		m_triangles.push_back(triangleIndex);
+	}
+
+	void sortUnique()
+	{
+		m_triangles.quickSort(btLessIntPredicate());
+		int numUnique = 0;
+		for (int i = 0; i < m_triangles.size(); i++)
+		{
+			if (i == 0 || m_triangles[i] != m_triangles[numUnique - 1])
+			{
+				m_triangles[numUnique++] = m_triangles[i];
+			}
+		}
+		m_triangles.resize(numUnique);
+	}
+};
+
+//a bumpy terrain of 2 * size * size triangles
+inline btTriangleMesh* createTerrainMesh(int size)
+{
+	btTriangleMesh* mesh = new btTriangleMesh();
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			btVector3 v[4];
+			for (int k = 0; k < 4; k++)
+			{
+				const btScalar vx = btScalar(x + (k & 1));
+				const btScalar vz = btScalar(z + (k >> 1));
+				v[k].setValue(vx, btScalar(3.) * btSin(vx * btScalar(0.2)) * btCos(vz * btScalar(0.15)), vz);
+			}
+			mesh->addTriangle(v[0], v[1], v[2]);
+			mesh->addTriangle(v[1], v[3], v[2]);
+		}
+	}
+	return mesh;
+}
+
+inline btVector3 randomPoint(const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	btVector3 p;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		p[axis] = aabbMin[axis] + (aabbMax[axis] - aabbMin[axis]) * btScalar(rand()) / btScalar(RAND_MAX);
+	}
+	return p;
+}
+
+#endif  //BVH_TEST_UTIL_H
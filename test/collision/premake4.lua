@@ -37,6 +37,7 @@
 		"../../src/BulletCollision/CollisionShapes/btConvexInternalShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btCollisionShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btConvexPolyhedron.cpp",
+		"../../src/BulletCollision/CollisionShapes/btConvexSupportAccelerator.cpp",
 
 	}
 
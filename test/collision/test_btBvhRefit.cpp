@@ -0,0 +1,271 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <BulletCollision/Gimpact/btGImpactShape.h>
+#include "BvhTestUtil.h"
+
+//the vertices of a btTriangleMesh with 32 bit indices and btVector3 vertices, locked while it exists
+struct btLockedTriangleMesh
+{
+	btTriangleMesh* m_mesh;
+	unsigned char* m_vertexBase;
+	int m_numVertices;
+	PHY_ScalarType m_vertexType;
+	int m_vertexStride;
+	unsigned char* m_indexBase;
+	int m_indexStride;
+	int m_numTriangles;
+	PHY_ScalarType m_indexType;
+
+	btLockedTriangleMesh(btTriangleMesh* mesh)
+		: m_mesh(mesh)
+	{
+		m_mesh->getLockedVertexIndexBase(&m_vertexBase, m_numVertices, m_vertexType, m_vertexStride, &m_indexBase, m_indexStride, m_numTriangles, m_indexType, 0);
+	}
+
+	~btLockedTriangleMesh()
+	{
+		m_mesh->unLockVertexBase(0);
+	}
+
+	btVector3& getVertex(int triangleIndex, int k)
+	{
+		const unsigned int* indices = (const unsigned int*)(m_indexBase + triangleIndex * m_indexStride);
+		return *(btVector3*)(m_vertexBase + indices[k] * m_vertexStride);
+	}
+};
+
+//the exact boxes of the triangles
+static void calculateTriangleAabbs(btTriangleMesh* mesh, btAlignedObjectArray<btVector3>& aabbs)
+{
+	btLockedTriangleMesh locked(mesh);
+	aabbs.resize(2 * locked.m_numTriangles);
+	for (int i = 0; i < locked.m_numTriangles; i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			const btVector3& v = locked.getVertex(i, k);
+			if (k == 0)
+			{
+				aabbs[2 * i] = v;
+				aabbs[2 * i + 1] = v;
+			}
+			aabbs[2 * i].setMin(v);
+			aabbs[2 * i + 1].setMax(v);
+		}
+	}
+}
+
+//the trees report conservative boxes, so both results are reduced to the triangles whose exact box is hit
+static void filterAabbQuery(btCollectTrianglesCallback& callback, const btAlignedObjectArray<btVector3>& aabbs, const btVector3& queryMin, const btVector3& queryMax)
+{
+	callback.sortUnique();
+	int numHits = 0;
+	for (int i = 0; i < callback.m_triangles.size(); i++)
+	{
+		const int t = callback.m_triangles[i];
+		if (TestAabbAgainstAabb2(aabbs[2 * t], aabbs[2 * t + 1], queryMin, queryMax))
+		{
+			callback.m_triangles[numHits++] = t;
+		}
+	}
+	callback.m_triangles.resize(numHits);
+}
+
+static void filterRayQuery(btCollectTrianglesCallback& callback, const btAlignedObjectArray<btVector3>& aabbs, const btVector3& rayFrom, const btVector3& rayTo)
+{
+	callback.sortUnique();
+	int numHits = 0;
+	for (int i = 0; i < callback.m_triangles.size(); i++)
+	{
+		const int t = callback.m_triangles[i];
+		btScalar param = 1;
+		btVector3 normal;
+		if (btRayAabb(rayFrom, rayTo, aabbs[2 * t], aabbs[2 * t + 1], param, normal))
+		{
+			callback.m_triangles[numHits++] = t;
+		}
+	}
+	callback.m_triangles.resize(numHits);
+}
+
+static void expectSameTriangles(const btCollectTrianglesCallback& expected, const btCollectTrianglesCallback& actual)
+{
+	ASSERT_EQ(expected.m_triangles.size(), actual.m_triangles.size());
+	for (int i = 0; i < expected.m_triangles.size(); i++)
+	{
+		EXPECT_EQ(expected.m_triangles[i], actual.m_triangles[i]);
+	}
+}
+
+//digs a pit around center into the terrain, or raises the triangles there above the original bounds of the mesh
+static void deformTerrain(btTriangleMesh* mesh, const btVector3& center, btScalar radius, btScalar offset)
+{
+	btLockedTriangleMesh locked(mesh);
+	for (int i = 0; i < locked.m_numTriangles; i++)
+	{
+		const btVector3 centroid = (locked.getVertex(i, 0) + locked.getVertex(i, 1) + locked.getVertex(i, 2)) / btScalar(3.);
+		const btScalar dx = centroid.x() - center.x();
+		const btScalar dz = centroid.z() - center.z();
+		if (dx * dx + dz * dz < radius * radius)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				locked.getVertex(i, k) += btVector3(0, offset, 0);
+			}
+			mesh->markTriangleDirty(0, i);
+		}
+	}
+}
+
+//refitDirtyTriangles refits the dirty leaves, rebuilds degraded subtrees in place and grows the quantization range,
+//the queries must still report the triangles of a tree built from scratch on the deformed mesh
+GTEST_TEST(BulletCollision, BvhRefitDirtyTrianglesMatchesRebuild)
+{
+	btTriangleMesh* mesh = createTerrainMesh(64);
+	btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(mesh, true);
+
+	int numRebuiltSubtrees = 0;
+	int numReported = 0;
+	srand(5);
+	for (int frame = 0; frame < 12; frame++)
+	{
+		const btScalar t = btScalar(frame) * btScalar(0.5);
+		const btVector3 center(btScalar(32.) + btScalar(20.) * btCos(t), 0, btScalar(32.) + btScalar(20.) * btSin(t));
+		//the last frames raise the ground above the quantization range of the tree
+		const btScalar offset = frame < 9 ? btScalar(-1.5) : btScalar(8.);
+		deformTerrain(mesh, center, btScalar(6.), offset);
+		shape->refitDirtyTriangles();
+		EXPECT_EQ(0, mesh->getDirtyTriangles().size());
+		ASSERT_TRUE(shape->getRefitData() != 0);
+		//rebuild the subtrees eagerly to run the in place rebuild
+		shape->getRefitData()->m_maxCostGrowth = btScalar(1.05);
+		numRebuiltSubtrees += shape->getRefitData()->m_numRebuiltSubtrees;
+
+		btVector3 aabbMin, aabbMax;
+		mesh->calculateAabbBruteForce(aabbMin, aabbMax);
+		btOptimizedBvh* freshBvh = new btOptimizedBvh();
+		freshBvh->build(mesh, true, aabbMin, aabbMax);
+		btOptimizedBvh* refitBvh = shape->getOptimizedBvh();
+
+		btAlignedObjectArray<btVector3> triangleAabbs;
+		calculateTriangleAabbs(mesh, triangleAabbs);
+		for (int q = 0; q < 50; q++)
+		{
+			//half of the queries around the deformed region
+			const btVector3 queryCenter = (q & 1) ? randomPoint(center - btVector3(8, 8, 8), center + btVector3(8, 8, 8)) : randomPoint(aabbMin, aabbMax);
+			const btVector3 halfExtents = randomPoint(btVector3(0.1, 0.1, 0.1), btVector3(3, 3, 3));
+			const btVector3 target = randomPoint(aabbMin, aabbMax);
+
+			btCollectTrianglesCallback expected[3];
+			btCollectTrianglesCallback actual[3];
+			freshBvh->reportAabbOverlappingNodex(&expected[0], queryCenter - halfExtents, queryCenter + halfExtents);
+			refitBvh->reportAabbOverlappingNodex(&actual[0], queryCenter - halfExtents, queryCenter + halfExtents);
+			filterAabbQuery(expected[0], triangleAabbs, queryCenter - halfExtents, queryCenter + halfExtents);
+			filterAabbQuery(actual[0], triangleAabbs, queryCenter - halfExtents, queryCenter + halfExtents);
+			//the cache friendly traversal walks the subtree headers, which the in place rebuild has to keep up to date
+			expected[2].m_triangles = expected[0].m_triangles;
+			refitBvh->setTraversalMode(btQuantizedBvh::TRAVERSAL_STACKLESS_CACHE_FRIENDLY);
+			refitBvh->reportAabbOverlappingNodex(&actual[2], queryCenter - halfExtents, queryCenter + halfExtents);
+			refitBvh->setTraversalMode(btQuantizedBvh::TRAVERSAL_STACKLESS);
+			filterAabbQuery(actual[2], triangleAabbs, queryCenter - halfExtents, queryCenter + halfExtents);
+			freshBvh->reportRayOverlappingNodex(&expected[1], queryCenter, target);
+			refitBvh->reportRayOverlappingNodex(&actual[1], queryCenter, target);
+			filterRayQuery(expected[1], triangleAabbs, queryCenter, target);
+			filterRayQuery(actual[1], triangleAabbs, queryCenter, target);
+			for (int k = 0; k < 3; k++)
+			{
+				numReported += expected[k].m_triangles.size();
+				expectSameTriangles(expected[k], actual[k]);
+			}
+		}
+		delete freshBvh;
+	}
+	EXPECT_GT(numReported, 0);
+	EXPECT_GT(numRebuiltSubtrees, 0);
+
+	delete shape;
+	delete mesh;
+}
+
+//the gimpact box set refits the dirty leaves in place, but its quantization range can not grow:
+//the boxes of the triangles raised above it must not be clamped, the boxes of the nodes and the queries must cover all the triangles
+GTEST_TEST(BulletCollision, GImpactRefitDirtyTrianglesMatchesBruteForce)
+{
+	btTriangleMesh* mesh = createTerrainMesh(32);
+	btGImpactMeshShape* shape = new btGImpactMeshShape(mesh);
+	shape->updateBound();
+	ASSERT_EQ(1, shape->getMeshPartCount());
+	const btGImpactBoxSet* boxSet = shape->getMeshPart(0)->getBoxSet();
+
+	int numReported = 0;
+	srand(7);
+	for (int frame = 0; frame < 8; frame++)
+	{
+		const btScalar t = btScalar(frame) * btScalar(0.8);
+		const btVector3 center(btScalar(16.) + btScalar(10.) * btCos(t), 0, btScalar(16.) + btScalar(10.) * btSin(t));
+		const btScalar offset = frame < 5 ? btScalar(-1.) : btScalar(8.);
+		deformTerrain(mesh, center, btScalar(4.), offset);
+		shape->refitDirtyTriangles();
+		EXPECT_EQ(0, mesh->getDirtyTriangles().size());
+
+		btVector3 aabbMin, aabbMax;
+		mesh->calculateAabbBruteForce(aabbMin, aabbMax);
+		btAlignedObjectArray<btVector3> triangleAabbs;
+		calculateTriangleAabbs(mesh, triangleAabbs);
+
+		//the broadphase and the gimpact vs gimpact tests use the unquantized boxes of the nodes
+		btVector3 shapeMin, shapeMax;
+		shape->getAabb(btTransform::getIdentity(), shapeMin, shapeMax);
+		EXPECT_TRUE(TestAabbAgainstAabb2(aabbMin, aabbMin, shapeMin, shapeMax));
+		EXPECT_TRUE(TestAabbAgainstAabb2(aabbMax, aabbMax, shapeMin, shapeMax));
+		for (int n = 0; n < boxSet->getNodeCount(); n++)
+		{
+			if (boxSet->isLeafNode(n))
+			{
+				btAABB leafBox;
+				boxSet->getNodeBound(n, leafBox);
+				const int i = boxSet->getNodeData(n);
+				EXPECT_TRUE(TestAabbAgainstAabb2(triangleAabbs[2 * i], triangleAabbs[2 * i], leafBox.m_min, leafBox.m_max));
+				EXPECT_TRUE(TestAabbAgainstAabb2(triangleAabbs[2 * i + 1], triangleAabbs[2 * i + 1], leafBox.m_min, leafBox.m_max));
+			}
+		}
+
+		for (int q = 0; q < 50; q++)
+		{
+			const btVector3 queryCenter = (q & 1) ? randomPoint(center - btVector3(6, 10, 6), center + btVector3(6, 10, 6)) : randomPoint(aabbMin, aabbMax);
+			const btVector3 halfExtents = randomPoint(btVector3(0.1, 0.1, 0.1), btVector3(2, 2, 2));
+			const btVector3 queryMin = queryCenter - halfExtents;
+			const btVector3 queryMax = queryCenter + halfExtents;
+
+			btCollectTrianglesCallback expected;
+			for (int i = 0; i < triangleAabbs.size() / 2; i++)
+			{
+				if (TestAabbAgainstAabb2(triangleAabbs[2 * i], triangleAabbs[2 * i + 1], queryMin, queryMax))
+				{
+					expected.m_triangles.push_back(i);
+				}
+			}
+
+			btAABB queryBox;
+			queryBox.m_min = queryMin;
+			queryBox.m_max = queryMax;
+			btCollectTrianglesCallback actual;
+			boxSet->boxQuery(queryBox, actual.m_triangles);
+			filterAabbQuery(actual, triangleAabbs, queryMin, queryMax);
+
+			numReported += expected.m_triangles.size();
+			expectSameTriangles(expected, actual);
+		}
+	}
+	EXPECT_GT(numReported, 0);
+
+	delete shape;
+	delete mesh;
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+#if BT_THREADSAFE
+//a pile of boxes and spheres, so most objects touch several others
+struct btPileWorld
+{
+	btDefaultCollisionConfiguration m_config;
+	btCollisionDispatcherMt m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btCollisionWorld m_world;
+	btBoxShape m_box;
+	btSphereShape m_sphere;
+	btAlignedObjectArray<btCollisionObject*> m_objects;
+
+	btPileWorld()
+		: m_dispatcher(&m_config, 8),
+		  m_world(&m_dispatcher, &m_broadphase, &m_config),
+		  m_box(btVector3(0.5f, 0.5f, 0.5f)),
+		  m_sphere(0.6f)
+	{
+		srand(1);
+		for (int i = 0; i < 400; i++)
+		{
+			btCollisionObject* object = new btCollisionObject();
+			object->setCollisionShape((i % 3) ? (btCollisionShape*)&m_box : (btCollisionShape*)&m_sphere);
+			object->setUserIndex(i);
+			const btVector3 origin(btScalar(i % 8), btScalar((i / 8) % 8), btScalar(i / 64));
+			const btVector3 jitter(btScalar(rand()) / RAND_MAX, btScalar(rand()) / RAND_MAX, btScalar(rand()) / RAND_MAX);
+			const btQuaternion rotation(btVector3(0.3f, 1.f, 0.2f).normalized(), btScalar(rand()) / RAND_MAX);
+			object->setWorldTransform(btTransform(rotation, origin * btScalar(0.95) + jitter * btScalar(0.1)));
+			m_world.addCollisionObject(object);
+			m_objects.push_back(object);
+		}
+	}
+
+	~btPileWorld()
+	{
+		for (int i = 0; i < m_objects.size(); i++)
+		{
+			m_world.removeCollisionObject(m_objects[i]);
+			delete m_objects[i];
+		}
+	}
+
+	//moves the objects a little, so that some pairs start or stop touching
+	void step(int frame)
+	{
+		for (int i = 0; i < m_objects.size(); i++)
+		{
+			btTransform trans = m_objects[i]->getWorldTransform();
+			const btScalar phase = btScalar(i) * btScalar(0.37) + btScalar(frame) * btScalar(0.5);
+			trans.getOrigin() += btVector3(btSin(phase), btCos(phase), btSin(phase * btScalar(0.7))) * btScalar(0.02);
+			m_objects[i]->setWorldTransform(trans);
+		}
+		m_world.performDiscreteCollisionDetection();
+	}
+};
+
+static void expectSameManifolds(btDispatcher* expected, btDispatcher* actual)
+{
+	ASSERT_EQ(expected->getNumManifolds(), actual->getNumManifolds());
+	for (int i = 0; i < expected->getNumManifolds(); i++)
+	{
+		const btPersistentManifold* a = expected->getManifoldByIndexInternal(i);
+		const btPersistentManifold* b = actual->getManifoldByIndexInternal(i);
+		ASSERT_EQ(a->getBody0()->getUserIndex(), b->getBody0()->getUserIndex()) << "manifold " << i;
+		ASSERT_EQ(a->getBody1()->getUserIndex(), b->getBody1()->getUserIndex()) << "manifold " << i;
+		ASSERT_EQ(a->getNumContacts(), b->getNumContacts()) << "manifold " << i;
+		for (int j = 0; j < a->getNumContacts(); j++)
+		{
+			const btManifoldPoint& pa = a->getContactPoint(j);
+			const btManifoldPoint& pb = b->getContactPoint(j);
+			EXPECT_EQ(pa.getDistance(), pb.getDistance());
+			EXPECT_EQ(pa.getLifeTime(), pb.getLifeTime());
+			for (int k = 0; k < 3; k++)
+			{
+				EXPECT_EQ(pa.m_positionWorldOnB[k], pb.m_positionWorldOnB[k]);
+				EXPECT_EQ(pa.m_normalWorldOnB[k], pb.m_normalWorldOnB[k]);
+			}
+		}
+	}
+}
+
+GTEST_TEST(BulletCollision, CollisionDispatcherMtManifoldsDoNotDependOnThreadCount)
+{
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	ASSERT_TRUE(scheduler != 0);
+	btSetTaskScheduler(scheduler);
+
+	scheduler->setNumThreads(1);
+	btPileWorld* serialWorld = new btPileWorld();
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btPileWorld* parallelWorld = new btPileWorld();
+	for (int frame = 0; frame < 10; frame++)
+	{
+		scheduler->setNumThreads(1);
+		serialWorld->step(frame);
+		scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+		parallelWorld->step(frame);
+		ASSERT_GT(serialWorld->m_dispatcher.getNumManifolds(), 0);
+		expectSameManifolds(&serialWorld->m_dispatcher, &parallelWorld->m_dispatcher);
+	}
+	delete parallelWorld;
+	delete serialWorld;
+
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+#endif  //BT_THREADSAFE
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
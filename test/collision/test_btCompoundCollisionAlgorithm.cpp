@@ -0,0 +1,175 @@
+
+#include <btBulletCollisionCommon.h>
+#include <gtest/gtest.h>
+
+struct btCompoundTestWorld
+{
+	btDefaultCollisionConfiguration m_config;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btCollisionWorld m_world;
+
+	btCompoundTestWorld()
+		: m_dispatcher(&m_config),
+		  m_world(&m_dispatcher, &m_broadphase, &m_config)
+	{
+	}
+
+	void stepFrames(int numFrames)
+	{
+		for (int i = 0; i < numFrames; i++)
+		{
+			m_world.performDiscreteCollisionDetection();
+		}
+	}
+
+	//the lifetime of a contact point grows each frame its manifold is kept, a new manifold refreshes its points once
+	int getMaxLifeTime()
+	{
+		int maxLifeTime = -1;
+		for (int i = 0; i < m_dispatcher.getNumManifolds(); i++)
+		{
+			const btPersistentManifold* manifold = m_dispatcher.getManifoldByIndexInternal(i);
+			for (int j = 0; j < manifold->getNumContacts(); j++)
+			{
+				maxLifeTime = btMax(maxLifeTime, manifold->getContactPoint(j).getLifeTime());
+			}
+		}
+		return maxLifeTime;
+	}
+};
+
+//a row of boxes that rests slightly inside the ground
+static void addBoxes(btCompoundShape* compound, btCollisionShape* box, int numBoxes)
+{
+	for (int i = 0; i < numBoxes; i++)
+	{
+		btTransform childTrans;
+		childTrans.setIdentity();
+		childTrans.setOrigin(btVector3(btScalar(i) * 1.5f - 3.f, 0.f, 0.f));
+		compound->addChildShape(childTrans, box);
+	}
+}
+
+//a box far above the ground, so it adds no contacts
+static void addFloatingBox(btCompoundShape* compound, btCollisionShape* box)
+{
+	btTransform childTrans;
+	childTrans.setIdentity();
+	childTrans.setOrigin(btVector3(0.f, 10.f, 0.f));
+	compound->addChildShape(childTrans, box);
+}
+
+static void checkChildAlgorithms(bool groundIsCompound, bool useDynamicAabbTree)
+{
+	btBoxShape box(btVector3(0.5f, 0.5f, 0.5f));
+	btBoxShape groundBox(btVector3(20.f, 1.f, 20.f));
+	btCompoundShape groundCompound;
+	groundCompound.addChildShape(btTransform::getIdentity(), &groundBox);
+
+	btCompoundShape compound(useDynamicAabbTree);
+	btCompoundShape sameCompound(useDynamicAabbTree);
+	addBoxes(&compound, &box, 5);
+	addBoxes(&sameCompound, &box, 5);
+
+	btCompoundTestWorld world;
+	btCollisionObject ground;
+	ground.setCollisionShape(groundIsCompound ? (btCollisionShape*)&groundCompound : (btCollisionShape*)&groundBox);
+	ground.setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(0.f, -1.f, 0.f)));
+	btCollisionObject object;
+	object.setCollisionShape(&compound);
+	object.setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(0.f, 0.49f, 0.f)));
+	world.m_world.addCollisionObject(&ground);
+	world.m_world.addCollisionObject(&object);
+
+	const int numFrames = 5;
+	world.stepFrames(numFrames);
+	ASSERT_GT(world.m_dispatcher.getNumManifolds(), 0);
+	EXPECT_GE(world.getMaxLifeTime(), numFrames - 1);
+
+	//added children keep the existing child algorithms and their manifolds
+	addFloatingBox(&compound, &box);
+	world.stepFrames(1);
+	EXPECT_GE(world.getMaxLifeTime(), numFrames);
+
+	//a removal changes the child indices, even when a child is added afterwards
+	compound.removeChildShapeByIndex(compound.getNumChildShapes() - 1);
+	addFloatingBox(&compound, &box);
+	world.stepFrames(1);
+	EXPECT_LE(world.getMaxLifeTime(), 1);
+
+	world.stepFrames(numFrames);
+	EXPECT_GE(world.getMaxLifeTime(), numFrames - 1);
+
+	//another compound shape with the same revision and number of children is not a continuation of the previous one
+	addFloatingBox(&sameCompound, &box);
+	while (sameCompound.getUpdateRevision() < compound.getUpdateRevision())
+	{
+		addFloatingBox(&sameCompound, &box);
+		sameCompound.removeChildShapeByIndex(sameCompound.getNumChildShapes() - 1);
+	}
+	ASSERT_EQ(sameCompound.getNumChildShapes(), compound.getNumChildShapes());
+	ASSERT_EQ(sameCompound.getUpdateRevision(), compound.getUpdateRevision());
+	object.setCollisionShape(&sameCompound);
+	world.stepFrames(1);
+	EXPECT_LE(world.getMaxLifeTime(), 1);
+
+	world.m_world.removeCollisionObject(&object);
+	world.m_world.removeCollisionObject(&ground);
+}
+
+GTEST_TEST(BulletCollision, CompoundChildAlgorithmsAcrossShapeChanges)
+{
+	for (int tree = 0; tree < 2; tree++)
+	{
+		checkChildAlgorithms(false, tree != 0);
+	}
+	checkChildAlgorithms(true, true);
+}
+
+static btTransform randomTransform(btScalar extent)
+{
+	btVector3 origin(btScalar(rand()) / RAND_MAX, btScalar(rand()) / RAND_MAX, btScalar(rand()) / RAND_MAX);
+	btVector3 axis(btScalar(rand()) / RAND_MAX - 0.5f, btScalar(rand()) / RAND_MAX - 0.5f, btScalar(rand()) / RAND_MAX + 0.1f);
+	const btScalar angle = btScalar(rand()) / RAND_MAX * SIMD_2_PI;
+	return btTransform(btQuaternion(axis.normalized(), angle), (origin * btScalar(2.) - btVector3(1, 1, 1)) * extent);
+}
+
+GTEST_TEST(BulletCollision, CompoundUpdateChildTransformMatchesRecalculateLocalAabb)
+{
+	srand(1);
+	btBoxShape box(btVector3(0.5f, 0.3f, 0.2f));
+	btSphereShape sphere(0.4f);
+	for (int tree = 0; tree < 2; tree++)
+	{
+		btCompoundShape compound(tree != 0);
+		for (int i = 0; i < 12; i++)
+		{
+			compound.addChildShape(randomTransform(3.f), (i & 1) ? (btCollisionShape*)&box : (btCollisionShape*)&sphere);
+		}
+		for (int i = 0; i < 2000; i++)
+		{
+			//mostly small moves inside the aabb, and sometimes a child that leaves it or comes back
+			const int childIndex = rand() % compound.getNumChildShapes();
+			const btScalar extent = (i % 7) ? btScalar(2.) : btScalar(5.);
+			compound.updateChildTransform(childIndex, randomTransform(extent), true);
+
+			btVector3 aabbMin, aabbMax;
+			compound.getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
+			compound.recalculateLocalAabb();
+			btVector3 expectedMin, expectedMax;
+			compound.getAabb(btTransform::getIdentity(), expectedMin, expectedMax);
+			for (int k = 0; k < 3; k++)
+			{
+				ASSERT_EQ(expectedMin[k], aabbMin[k]) << "step " << i << " tree " << tree;
+				ASSERT_EQ(expectedMax[k], aabbMax[k]) << "step " << i << " tree " << tree;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btConvexSupportAccelerator.h>
+#include <gtest/gtest.h>
+
+static btScalar randomScalar(btScalar minValue, btScalar maxValue)
+{
+	return minValue + (maxValue - minValue) * btScalar(rand()) / RAND_MAX;
+}
+
+static btVector3 randomDirection()
+{
+	btVector3 dir;
+	do
+	{
+		dir.setValue(randomScalar(-1, 1), randomScalar(-1, 1), randomScalar(-1, 1));
+	} while (dir.length2() < btScalar(0.01) || dir.length2() > btScalar(1.));
+	return dir.normalized();
+}
+
+//points on and inside an ellipsoid, the inner points are never a support vertex
+static void createRandomPoints(int numPoints, btAlignedObjectArray<btVector3>& points)
+{
+	points.resize(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		const btScalar radius = (i % 4) ? btScalar(1.) : randomScalar(0, btScalar(0.9));
+		points[i] = randomDirection() * btVector3(btScalar(1.2), btScalar(0.8), btScalar(0.5)) * radius;
+	}
+}
+
+static btScalar getMaxDot(const btAlignedObjectArray<btVector3>& points, const btVector3& dir)
+{
+	btScalar maxDot = -BT_LARGE_FLOAT;
+	for (int i = 0; i < points.size(); i++)
+	{
+		maxDot = btMax(maxDot, points[i].dot(dir));
+	}
+	return maxDot;
+}
+
+//the accelerator finds a vertex as extreme as the linear scan, with and without hill climbing, single and batched
+GTEST_TEST(BulletCollision, ConvexSupportAcceleratorMatchesLinearScan)
+{
+	srand(1);
+	const int numPointsPerSet[] = {20, 256, 1024};
+	for (int s = 0; s < 3; s++)
+	{
+		btAlignedObjectArray<btVector3> points;
+		createRandomPoints(numPointsPerSet[s], points);
+		btConvexSupportAccelerator accelerator(&points[0], points.size());
+		EXPECT_EQ(accelerator.usesHillClimbing(), points.size() >= 128);
+
+		const int numDirs = 1000;
+		btAlignedObjectArray<btVector3> dirs;
+		dirs.resize(numDirs);
+		for (int i = 0; i < numDirs; i++)
+		{
+			dirs[i] = randomDirection() * randomScalar(btScalar(0.1), btScalar(10.));
+		}
+		btAlignedObjectArray<int> batchedIndices;
+		btAlignedObjectArray<btScalar> batchedDots;
+		batchedIndices.resize(numDirs);
+		batchedDots.resize(numDirs);
+		accelerator.batchedGetSupportingVertexIndices(&dirs[0], numDirs, &batchedIndices[0], &batchedDots[0]);
+
+		for (int i = 0; i < numDirs; i++)
+		{
+			const btScalar expected = getMaxDot(points, dirs[i]);
+			const btScalar tolerance = btScalar(1e-5) * dirs[i].length();
+			btScalar maxDot;
+			const int index = accelerator.getSupportingVertexIndex(dirs[i], maxDot);
+			ASSERT_GE(index, 0);
+			ASSERT_LT(index, points.size());
+			EXPECT_NEAR(maxDot, expected, tolerance) << points.size() << " points, direction " << i;
+			EXPECT_NEAR(points[index].dot(dirs[i]), expected, tolerance) << points.size() << " points, direction " << i;
+			EXPECT_NEAR(batchedDots[i], expected, tolerance) << points.size() << " points, direction " << i;
+			EXPECT_NEAR(points[batchedIndices[i]].dot(dirs[i]), expected, tolerance) << points.size() << " points, direction " << i;
+		}
+	}
+}
+
+struct btContactResult : public btCollisionWorld::ContactResultCallback
+{
+	int m_numContacts;
+	btScalar m_distance;
+	btVector3 m_normal;
+
+	btContactResult() : m_numContacts(0), m_distance(0), m_normal(0, 0, 0) {}
+
+	virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0, const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1)
+	{
+		if (m_numContacts == 0 || cp.getDistance() < m_distance)
+		{
+			m_distance = cp.getDistance();
+			m_normal = cp.m_normalWorldOnB;
+		}
+		m_numContacts++;
+		return 0;
+	}
+};
+
+//GJK and EPA find the same contacts for a hull with the accelerator as for the same hull without it
+GTEST_TEST(BulletCollision, ConvexSupportAcceleratorMatchesNarrowphase)
+{
+	srand(2);
+	btAlignedObjectArray<btVector3> points;
+	createRandomPoints(512, points);
+	btConvexHullShape plainHull(&points[0].getX(), points.size());
+	btConvexHullShape acceleratedHull(&points[0].getX(), points.size());
+	plainHull.setLocalScaling(btVector3(btScalar(1.), btScalar(1.5), btScalar(0.8)));
+	acceleratedHull.setLocalScaling(btVector3(btScalar(1.), btScalar(1.5), btScalar(0.8)));
+	acceleratedHull.initializeSupportAccelerator();
+	ASSERT_TRUE(acceleratedHull.getSupportAccelerator() != 0);
+	ASSERT_TRUE(acceleratedHull.getSupportAccelerator()->usesHillClimbing());
+	btBoxShape box(btVector3(btScalar(0.6), btScalar(0.4), btScalar(0.5)));
+
+	btDefaultCollisionConfiguration config;
+	btCollisionDispatcher dispatcher(&config);
+	btDbvtBroadphase broadphase;
+	btCollisionWorld world(&dispatcher, &broadphase, &config);
+
+	int numPenetrations = 0;
+	for (int q = 0; q < 300; q++)
+	{
+		const btTransform transHull(btQuaternion(randomDirection(), randomScalar(0, SIMD_2_PI)), btVector3(0, 0, 0));
+		const btTransform transBox(btQuaternion(randomDirection(), randomScalar(0, SIMD_2_PI)), randomDirection() * randomScalar(btScalar(0.5), btScalar(2.)));
+		btCollisionObject plainObject;
+		plainObject.setCollisionShape(&plainHull);
+		plainObject.setWorldTransform(transHull);
+		btCollisionObject acceleratedObject;
+		acceleratedObject.setCollisionShape(&acceleratedHull);
+		acceleratedObject.setWorldTransform(transHull);
+		btCollisionObject boxObject;
+		boxObject.setCollisionShape(&box);
+		boxObject.setWorldTransform(transBox);
+
+		btContactResult expected;
+		btContactResult actual;
+		world.contactPairTest(&plainObject, &boxObject, expected);
+		world.contactPairTest(&acceleratedObject, &boxObject, actual);
+		ASSERT_EQ(expected.m_numContacts, actual.m_numContacts) << "pose " << q;
+		if (expected.m_numContacts)
+		{
+			EXPECT_NEAR(actual.m_distance, expected.m_distance, btScalar(1e-4)) << "pose " << q;
+			EXPECT_GT(actual.m_normal.dot(expected.m_normal), btScalar(0.999)) << "pose " << q;
+			numPenetrations += expected.m_distance < 0;
+		}
+	}
+	EXPECT_GT(numPenetrations, 50);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
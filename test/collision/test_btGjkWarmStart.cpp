@@ -0,0 +1,151 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/Gimpact/btGImpactShape.h>
+#include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
+#include <gtest/gtest.h>
+
+struct btContact
+{
+	int m_triangleIndex;
+	btScalar m_distance;
+	btVector3 m_normal;
+};
+
+struct btLessContactPredicate
+{
+	bool operator()(const btContact& a, const btContact& b) const
+	{
+		if (a.m_triangleIndex != b.m_triangleIndex)
+			return a.m_triangleIndex < b.m_triangleIndex;
+		return a.m_distance < b.m_distance;
+	}
+};
+
+//collects all the points reported by the algorithms, the manifold would reduce them to four
+struct btCollectContactsResult : public btManifoldResult
+{
+	btAlignedObjectArray<btContact> m_contacts;
+
+	btCollectContactsResult(const btCollisionObjectWrapper* obj0Wrap, const btCollisionObjectWrapper* obj1Wrap)
+		: btManifoldResult(obj0Wrap, obj1Wrap)
+	{
+	}
+
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+	{
+		btContact contact;
+		contact.m_triangleIndex = m_index0;
+		contact.m_distance = depth;
+		contact.m_normal = normalOnBInWorld;
+		m_contacts.push_back(contact);
+	}
+};
+
+static void collectContacts(btCollisionWorld* world, btCollisionObject* objA, btCollisionObject* objB, bool useWarmStart, btAlignedObjectArray<btContact>& contacts)
+{
+	btCollisionObjectWrapper obA(0, objA->getCollisionShape(), objA, objA->getWorldTransform(), -1, -1);
+	btCollisionObjectWrapper obB(0, objB->getCollisionShape(), objB, objB->getWorldTransform(), -1, -1);
+	btCollisionAlgorithm* algorithm = world->getDispatcher()->findAlgorithm(&obA, &obB, 0, BT_CONTACT_POINT_ALGORITHMS);
+	ASSERT_TRUE(algorithm != 0);
+	btCollectContactsResult result(&obA, &obB);
+	world->getDispatchInfo().m_useGjkWarmStart = useWarmStart;
+	algorithm->processCollision(&obA, &obB, world->getDispatchInfo(), &result);
+	algorithm->~btCollisionAlgorithm();
+	world->getDispatcher()->freeCollisionAlgorithm(algorithm);
+	contacts = result.m_contacts;
+	contacts.quickSort(btLessContactPredicate());
+}
+
+//a bumpy terrain of 2 * size * size triangles around the origin
+static btTriangleMesh* createTerrainMesh(int size)
+{
+	btTriangleMesh* mesh = new btTriangleMesh();
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			btVector3 v[4];
+			for (int k = 0; k < 4; k++)
+			{
+				const btScalar vx = btScalar(x + (k & 1) - size / 2);
+				const btScalar vz = btScalar(z + (k >> 1) - size / 2);
+				v[k].setValue(vx, btScalar(0.4) * btSin(vx * btScalar(0.7)) * btCos(vz * btScalar(0.5)), vz);
+			}
+			mesh->addTriangle(v[0], v[1], v[2]);
+			mesh->addTriangle(v[1], v[3], v[2]);
+		}
+	}
+	return mesh;
+}
+
+//the gimpact algorithm runs one convex algorithm on all the triangles of the mesh against a convex child of the compound,
+//passing each triangle in the same btTriangleShape: the GJK warm start must not carry over from one triangle to the next
+GTEST_TEST(BulletCollision, GjkWarmStartGImpactMeshVsConvex)
+{
+	btDefaultCollisionConfiguration* configuration = new btDefaultCollisionConfiguration();
+	btCollisionDispatcher* dispatcher = new btCollisionDispatcher(configuration);
+	btGImpactCollisionAlgorithm::registerAlgorithm(dispatcher);
+	btDbvtBroadphase* broadphase = new btDbvtBroadphase();
+	btCollisionWorld* world = new btCollisionWorld(dispatcher, broadphase, configuration);
+
+	btTriangleMesh* mesh = createTerrainMesh(16);
+	btGImpactMeshShape* terrainShape = new btGImpactMeshShape(mesh);
+	terrainShape->updateBound();
+	btCollisionObject* terrain = new btCollisionObject();
+	terrain->setCollisionShape(terrainShape);
+	world->addCollisionObject(terrain);
+
+	btBoxShape* boxShape = new btBoxShape(btVector3(btScalar(1.5), btScalar(0.5), btScalar(1.)));
+	btGImpactCompoundShape* compoundShape = new btGImpactCompoundShape();
+	compoundShape->addChildShape(btTransform::getIdentity(), boxShape);
+	compoundShape->updateBound();
+	btCollisionObject* box = new btCollisionObject();
+	box->setCollisionShape(compoundShape);
+	world->addCollisionObject(box);
+
+	int numContacts = 0;
+	for (int i = 0; i < 20; i++)
+	{
+		const btScalar t = btScalar(i) * btScalar(0.37);
+		btTransform trans(btQuaternion(btVector3(1, 0, 1).normalized(), btScalar(0.3) * btSin(t)),
+						  btVector3(btScalar(3.) * btCos(t), btScalar(0.3), btScalar(3.) * btSin(t)));
+		box->setWorldTransform(trans);
+		compoundShape->updateBound();
+
+		btAlignedObjectArray<btContact> withWarmStart;
+		btAlignedObjectArray<btContact> withoutWarmStart;
+		collectContacts(world, terrain, box, true, withWarmStart);
+		collectContacts(world, terrain, box, false, withoutWarmStart);
+
+		ASSERT_EQ(withoutWarmStart.size(), withWarmStart.size());
+		for (int c = 0; c < withWarmStart.size(); c++)
+		{
+			const btContact& a = withWarmStart[c];
+			const btContact& b = withoutWarmStart[c];
+			EXPECT_EQ(b.m_triangleIndex, a.m_triangleIndex);
+			EXPECT_NEAR(b.m_distance, a.m_distance, 1e-3);
+			EXPECT_GT(a.m_normal.dot(b.m_normal), btScalar(0.99));
+		}
+		numContacts += withWarmStart.size();
+	}
+	EXPECT_GT(numContacts, 0);
+
+	world->removeCollisionObject(box);
+	world->removeCollisionObject(terrain);
+	delete box;
+	delete compoundShape;
+	delete boxShape;
+	delete terrain;
+	delete terrainShape;
+	delete mesh;
+	delete world;
+	delete broadphase;
+	delete dispatcher;
+	delete configuration;
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
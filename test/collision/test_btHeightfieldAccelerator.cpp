@@ -0,0 +1,577 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
+#include "BvhTestUtil.h"
+
+//not a multiple of the chunk size, so the last chunks and pyramid nodes are partial
+static const int gGridSize = 101;
+static const int gChunkSize = 8;
+
+static void createHeights(btAlignedObjectArray<float>& heights, int size, btScalar noiseAmplitude = btScalar(0.3))
+{
+	heights.resize(size * size);
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			const btScalar noise = noiseAmplitude * btScalar(rand()) / btScalar(RAND_MAX);
+			heights[x + z * size] = float(btScalar(4.) * btSin(btScalar(x) * btScalar(0.15)) * btCos(btScalar(z) * btScalar(0.11)) + noise);
+		}
+	}
+}
+
+static btHeightfieldTerrainShape* createHeightfield(const btAlignedObjectArray<float>& heights, int size, int upAxis, bool useAccelerator)
+{
+	btHeightfieldTerrainShape* shape = new btHeightfieldTerrainShape(size, size, &heights[0], 1, -5, 5, upAxis, PHY_FLOAT, false);
+	//both diagonals of the cells are used
+	shape->setUseDiamondSubdivision(true);
+	shape->setLocalScaling(btVector3(btScalar(1.25), btScalar(1.1), btScalar(0.8)));
+	if (useAccelerator)
+	{
+		shape->buildAccelerator(gChunkSize);
+	}
+	return shape;
+}
+
+static int getTriangleKey(int partId, int triangleIndex)
+{
+	return partId * 4096 + triangleIndex;
+}
+
+//the exact local box of the grid cell (x, z)
+static void getCellAabb(const btHeightfieldTerrainShape* shape, int x, int z, btVector3& aabbMin, btVector3& aabbMax)
+{
+	for (int k = 0; k < 4; k++)
+	{
+		btVector3 v;
+		shape->getVertex(x + (k & 1), z + (k >> 1), v);
+		if (k == 0)
+		{
+			aabbMin = v;
+			aabbMax = v;
+		}
+		aabbMin.setMin(v);
+		aabbMax.setMax(v);
+	}
+}
+
+static void sortUnique(btAlignedObjectArray<int>& keys)
+{
+	keys.quickSort(btLessIntPredicate());
+	int numUnique = 0;
+	for (int i = 0; i < keys.size(); i++)
+	{
+		if (i == 0 || keys[i] != keys[numUnique - 1])
+		{
+			keys[numUnique++] = keys[i];
+		}
+	}
+	keys.resize(numUnique);
+}
+
+static void expectContainsKeys(const btAlignedObjectArray<int>& expected, const btAlignedObjectArray<int>& actual)
+{
+	for (int i = 0; i < expected.size(); i++)
+	{
+		EXPECT_LT(actual.findBinarySearch(expected[i]), actual.size());
+	}
+}
+
+struct btCollectCellsAction
+{
+	btAlignedObjectArray<int> m_cells;
+
+	void operator()(int x, int z)
+	{
+		m_cells.push_back(x + z * gGridSize);
+	}
+};
+
+struct btCollectTriangleIdsCallback : public btTriangleCallback
+{
+	btAlignedObjectArray<int> m_keys;
+
+	virtual void processTriangle(btVector3* triangle, int partId, int triangleIndex)
+	{
+		(void)triangle;
+		m_keys.push_back(getTriangleKey(partId, triangleIndex));
+	}
+};
+
+//keeps the closest hit
+struct btClosestRayCallback : public btTriangleRaycastCallback
+{
+	int m_partId;
+	int m_triangleIndex;
+
+	btClosestRayCallback(const btVector3& from, const btVector3& to)
+		: btTriangleRaycastCallback(from, to),
+		  m_partId(-1),
+		  m_triangleIndex(-1)
+	{
+	}
+
+	virtual btScalar reportHit(const btVector3& hitNormalLocal, btScalar hitFraction, int partId, int triangleIndex)
+	{
+		(void)hitNormalLocal;
+		m_partId = partId;
+		m_triangleIndex = triangleIndex;
+		return hitFraction;
+	}
+};
+
+//collects all the triangles hit by the ray
+struct btAllHitsRayCallback : public btTriangleRaycastCallback
+{
+	btAlignedObjectArray<int> m_keys;
+
+	btAllHitsRayCallback(const btVector3& from, const btVector3& to)
+		: btTriangleRaycastCallback(from, to)
+	{
+	}
+
+	virtual btScalar reportHit(const btVector3& hitNormalLocal, btScalar hitFraction, int partId, int triangleIndex)
+	{
+		(void)hitNormalLocal;
+		(void)hitFraction;
+		m_keys.push_back(getTriangleKey(partId, triangleIndex));
+		return m_hitFraction;
+	}
+};
+
+//keeps the closest hit, or collects all the triangles hit by the cast
+struct btConvexcastCallback : public btTriangleConvexcastCallback
+{
+	bool m_allHits;
+	int m_numHits;
+	btAlignedObjectArray<int> m_keys;
+
+	btConvexcastCallback(const btConvexShape* convexShape, const btTransform& from, const btTransform& to, btScalar margin, bool allHits)
+		: btTriangleConvexcastCallback(convexShape, from, to, btTransform::getIdentity(), margin),
+		  m_allHits(allHits),
+		  m_numHits(0)
+	{
+	}
+
+	virtual btScalar reportHit(const btVector3& hitNormalLocal, const btVector3& hitPointLocal, btScalar hitFraction, int partId, int triangleIndex)
+	{
+		(void)hitNormalLocal;
+		(void)hitPointLocal;
+		m_numHits++;
+		m_keys.push_back(getTriangleKey(partId, triangleIndex));
+		if (!m_allHits)
+		{
+			m_hitFraction = hitFraction;
+		}
+		return hitFraction;
+	}
+};
+
+//a random segment in the local aabb of the shape, from above to below the terrain or across it
+static void randomSegment(const btHeightfieldTerrainShape* shape, int q, btVector3& from, btVector3& to)
+{
+	btVector3 aabbMin, aabbMax;
+	shape->getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
+	from = randomPoint(aabbMin, aabbMax);
+	to = randomPoint(aabbMin, aabbMax);
+	if (q & 1)
+	{
+		const int upAxis = shape->getUpAxis();
+		from[upAxis] = aabbMax[upAxis] + btScalar(2.);
+		to[upAxis] = aabbMin[upAxis] - btScalar(2.);
+	}
+}
+
+//every node of the pyramid holds the exact height range of the vertices of its cells
+GTEST_TEST(BulletCollision, HeightfieldVBoundsPyramid)
+{
+	btAlignedObjectArray<float> heights;
+	srand(1);
+	createHeights(heights, gGridSize);
+	btHeightfieldTerrainShape* shape = createHeightfield(heights, gGridSize, 1, true);
+
+	ASSERT_GT(shape->getNumVBoundsLevels(), 2);
+	const int numCells = gGridSize - 1;
+	for (int level = 0; level < shape->getNumVBoundsLevels(); level++)
+	{
+		const btHeightfieldTerrainShape::VBoundsLevel& vboundsLevel = shape->getVBoundsLevel(level);
+		const int nodeSize = shape->getVBoundsChunkSize() << level;
+		for (int cz = 0; cz < vboundsLevel.m_length; cz++)
+		{
+			for (int cx = 0; cx < vboundsLevel.m_width; cx++)
+			{
+				const int x0 = cx * nodeSize;
+				const int z0 = cz * nodeSize;
+				if (x0 >= numCells || z0 >= numCells)
+				{
+					continue;
+				}
+				btScalar minHeight = BT_LARGE_FLOAT;
+				btScalar maxHeight = -BT_LARGE_FLOAT;
+				for (int z = z0; z <= btMin(z0 + nodeSize, numCells); z++)
+				{
+					for (int x = x0; x <= btMin(x0 + nodeSize, numCells); x++)
+					{
+						minHeight = btMin(minHeight, btScalar(heights[x + z * gGridSize]));
+						maxHeight = btMax(maxHeight, btScalar(heights[x + z * gGridSize]));
+					}
+				}
+				const btHeightfieldTerrainShape::Range& bounds = shape->getVBounds(level, cx, cz);
+				EXPECT_EQ(minHeight, bounds.min);
+				EXPECT_EQ(maxHeight, bounds.max);
+			}
+		}
+	}
+	const btHeightfieldTerrainShape::VBoundsLevel& top = shape->getVBoundsLevel(shape->getNumVBoundsLevels() - 1);
+	EXPECT_EQ(1, top.m_width);
+	EXPECT_EQ(1, top.m_length);
+
+	delete shape;
+}
+
+//processAllCells skips the chunks and cells above or below the aabb, but must visit all the cells the aabb overlaps,
+//and processAllTriangles reports the two triangles of each cell with partId 2 * x and 2 * x + 1
+GTEST_TEST(BulletCollision, HeightfieldProcessAllCellsMatchesBruteForce)
+{
+	btAlignedObjectArray<float> heights;
+	srand(2);
+	createHeights(heights, gGridSize);
+	btHeightfieldTerrainShape* shape = createHeightfield(heights, gGridSize, 1, true);
+	btVector3 shapeMin, shapeMax;
+	shape->getAabb(btTransform::getIdentity(), shapeMin, shapeMax);
+
+	int numCells = 0;
+	for (int q = 0; q < 200; q++)
+	{
+		const btVector3 queryCenter = randomPoint(shapeMin, shapeMax);
+		const btVector3 halfExtents = randomPoint(btVector3(0.1, 0.1, 0.1), btVector3(8, 3, 8));
+		const btVector3 queryMin = queryCenter - halfExtents;
+		const btVector3 queryMax = queryCenter + halfExtents;
+
+		btAlignedObjectArray<int> expected;
+		for (int z = 0; z < gGridSize - 1; z++)
+		{
+			for (int x = 0; x < gGridSize - 1; x++)
+			{
+				btVector3 cellMin, cellMax;
+				getCellAabb(shape, x, z, cellMin, cellMax);
+				if (TestAabbAgainstAabb2(cellMin, cellMax, queryMin, queryMax))
+				{
+					expected.push_back(x + z * gGridSize);
+				}
+			}
+		}
+
+		btCollectCellsAction cells;
+		shape->processAllCells(cells, queryMin, queryMax);
+		//no cell is visited twice, the cells outside of the aabb are allowed
+		const int numVisited = cells.m_cells.size();
+		sortUnique(cells.m_cells);
+		EXPECT_EQ(numVisited, cells.m_cells.size());
+		expectContainsKeys(expected, cells.m_cells);
+
+		btCollectTriangleIdsCallback triangles;
+		shape->processAllTriangles(&triangles, queryMin, queryMax);
+		ASSERT_EQ(2 * cells.m_cells.size(), triangles.m_keys.size());
+		sortUnique(triangles.m_keys);
+		ASSERT_EQ(2 * cells.m_cells.size(), triangles.m_keys.size());
+		for (int i = 0; i < cells.m_cells.size(); i++)
+		{
+			const int x = cells.m_cells[i] % gGridSize;
+			const int z = cells.m_cells[i] / gGridSize;
+			EXPECT_LT(triangles.m_keys.findBinarySearch(getTriangleKey(2 * x, z)), triangles.m_keys.size());
+			EXPECT_LT(triangles.m_keys.findBinarySearch(getTriangleKey(2 * x + 1, z)), triangles.m_keys.size());
+		}
+		numCells += expected.size();
+	}
+	EXPECT_GT(numCells, 0);
+
+	delete shape;
+}
+
+static void checkRaycast(int upAxis, bool useTriangleIds)
+{
+	btAlignedObjectArray<float> heights;
+	srand(3);
+	createHeights(heights, gGridSize);
+	btHeightfieldTerrainShape* shapes[2] = {createHeightfield(heights, gGridSize, upAxis, true), createHeightfield(heights, gGridSize, upAxis, false)};
+	btVector3 shapeMin, shapeMax;
+	shapes[0]->getAabb(btTransform::getIdentity(), shapeMin, shapeMax);
+	for (int s = 0; s < 2; s++)
+	{
+		shapes[s]->setUseTriangleIdsInRaycast(useTriangleIds);
+	}
+
+	int numHits = 0;
+	for (int q = 0; q < 150; q++)
+	{
+		btVector3 from, to;
+		randomSegment(shapes[0], q, from, to);
+
+		//the brute force ray test against all the triangles
+		btClosestRayCallback expectedClosest(from, to);
+		shapes[1]->processAllTriangles(&expectedClosest, shapeMin, shapeMax);
+		btAllHitsRayCallback expectedAllHits(from, to);
+		shapes[1]->processAllTriangles(&expectedAllHits, shapeMin, shapeMax);
+		//by default, rays report the ids of the cells
+		for (int i = 0; i < expectedAllHits.m_keys.size() && !useTriangleIds; i++)
+		{
+			const int partId = expectedAllHits.m_keys[i] / 4096;
+			expectedAllHits.m_keys[i] = getTriangleKey(partId / 2, expectedAllHits.m_keys[i] % 4096);
+		}
+		sortUnique(expectedAllHits.m_keys);
+		const int expectedPartId = useTriangleIds ? expectedClosest.m_partId : expectedClosest.m_partId / 2;
+
+		for (int s = 0; s < 2; s++)
+		{
+			btClosestRayCallback closest(from, to);
+			shapes[s]->performRaycast(&closest, from, to);
+			EXPECT_NEAR(expectedClosest.m_hitFraction, closest.m_hitFraction, 1e-4);
+			if (expectedClosest.m_hitFraction < btScalar(1.) && btFabs(expectedClosest.m_hitFraction - closest.m_hitFraction) < btScalar(1e-6))
+			{
+				EXPECT_EQ(expectedPartId, closest.m_partId);
+				EXPECT_EQ(expectedClosest.m_triangleIndex, closest.m_triangleIndex);
+			}
+
+			btCollectTriangleIdsCallback triangles;
+			shapes[s]->performRaycast((btTriangleCallback*)&triangles, from, to);
+			sortUnique(triangles.m_keys);
+			expectContainsKeys(expectedAllHits.m_keys, triangles.m_keys);
+		}
+		numHits += expectedAllHits.m_keys.size();
+	}
+	EXPECT_GT(numHits, 0);
+
+	delete shapes[0];
+	delete shapes[1];
+}
+
+//the raycast overloads, with and without the accelerator and for all up axes, report the hits of a brute force ray test
+GTEST_TEST(BulletCollision, HeightfieldRaycastMatchesBruteForce)
+{
+	for (int upAxis = 0; upAxis < 3; upAxis++)
+	{
+		checkRaycast(upAxis, false);
+		checkRaycast(upAxis, true);
+	}
+}
+
+//the convex casts skip the chunks beyond the closest hit, and must find the closest hit of a cast against all the triangles
+GTEST_TEST(BulletCollision, HeightfieldConvexcastMatchesBruteForce)
+{
+	btAlignedObjectArray<float> heights;
+	srand(4);
+	createHeights(heights, gGridSize);
+	btHeightfieldTerrainShape* shape = createHeightfield(heights, gGridSize, 1, true);
+	btVector3 shapeMin, shapeMax;
+	shape->getAabb(btTransform::getIdentity(), shapeMin, shapeMax);
+
+	btSphereShape sphere(btScalar(0.7));
+	btBoxShape box(btVector3(btScalar(1.), btScalar(0.4), btScalar(0.6)));
+	const btConvexShape* convexShapes[2] = {&sphere, &box};
+
+	int numHits = 0;
+	for (int q = 0; q < 50; q++)
+	{
+		btVector3 from, to;
+		randomSegment(shape, q, from, to);
+		const btQuaternion rotation(btVector3(1, 1, 0).normalized(), btScalar(0.1) * btScalar(q));
+		const btTransform fromTrans(rotation, from);
+		const btTransform toTrans(rotation, to);
+
+		for (int c = 0; c < 2; c++)
+		{
+			btVector3 boxMin, boxMax;
+			convexShapes[c]->getAabb(btTransform(rotation), boxMin, boxMax);
+
+			btConvexcastCallback expected(convexShapes[c], fromTrans, toTrans, shape->getMargin(), false);
+			shape->processAllTriangles(&expected, shapeMin, shapeMax);
+			btConvexcastCallback expectedAllHits(convexShapes[c], fromTrans, toTrans, shape->getMargin(), true);
+			shape->processAllTriangles(&expectedAllHits, shapeMin, shapeMax);
+			sortUnique(expectedAllHits.m_keys);
+
+			btConvexcastCallback closest(convexShapes[c], fromTrans, toTrans, shape->getMargin(), false);
+			shape->performConvexcast(&closest, from, to, boxMin, boxMax);
+			EXPECT_NEAR(expected.m_hitFraction, closest.m_hitFraction, 1e-4);
+
+			btCollectTriangleIdsCallback triangles;
+			shape->performConvexcast((btTriangleCallback*)&triangles, from, to, boxMin, boxMax);
+			sortUnique(triangles.m_keys);
+			expectContainsKeys(expectedAllHits.m_keys, triangles.m_keys);
+
+			numHits += expectedAllHits.m_keys.size();
+		}
+	}
+	EXPECT_GT(numHits, 0);
+
+	delete shape;
+}
+
+struct btContact
+{
+	btScalar m_distance;
+	btVector3 m_normal;
+};
+
+//collects all the points reported by the algorithms, the manifold would reduce them to four
+struct btCollectContactsResult : public btManifoldResult
+{
+	btAlignedObjectArray<btContact> m_contacts;
+
+	btCollectContactsResult(const btCollisionObjectWrapper* obj0Wrap, const btCollisionObjectWrapper* obj1Wrap)
+		: btManifoldResult(obj0Wrap, obj1Wrap)
+	{
+	}
+
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+	{
+		(void)pointInWorld;
+		btContact contact;
+		contact.m_distance = depth;
+		contact.m_normal = normalOnBInWorld;
+		m_contacts.push_back(contact);
+	}
+
+	const btContact& getDeepestContact() const
+	{
+		int deepest = 0;
+		for (int i = 1; i < m_contacts.size(); i++)
+		{
+			if (m_contacts[i].m_distance < m_contacts[deepest].m_distance)
+			{
+				deepest = i;
+			}
+		}
+		return m_contacts[deepest];
+	}
+};
+
+static void collectContacts(btCollisionDispatcher* dispatcher, btCollisionObject* convex, btCollisionObject* terrain, btCollectContactsResult*& result)
+{
+	btCollisionObjectWrapper obA(0, convex->getCollisionShape(), convex, convex->getWorldTransform(), -1, -1);
+	btCollisionObjectWrapper obB(0, terrain->getCollisionShape(), terrain, terrain->getWorldTransform(), -1, -1);
+	btCollisionAlgorithm* algorithm = dispatcher->findAlgorithm(&obA, &obB, 0, BT_CONTACT_POINT_ALGORITHMS);
+	ASSERT_TRUE(algorithm != 0);
+	result = new btCollectContactsResult(&obA, &obB);
+	btDispatcherInfo dispatchInfo;
+	algorithm->processCollision(&obA, &obB, dispatchInfo, result);
+	algorithm->~btCollisionAlgorithm();
+	dispatcher->freeCollisionAlgorithm(algorithm);
+}
+
+static btScalar getDeepestDistance(btCollisionDispatcher* dispatcher, btCollisionObject* convex, btCollisionObject* terrain)
+{
+	btCollectContactsResult* result = 0;
+	collectContacts(dispatcher, convex, terrain, result);
+	const btScalar distance = result && result->m_contacts.size() ? result->getDeepestContact().m_distance : BT_LARGE_FLOAT;
+	delete result;
+	return distance;
+}
+
+//btConvexHeightfieldCollisionAlgorithm finds the same deepest penetration as the convex versus concave algorithm
+GTEST_TEST(BulletCollision, ConvexHeightfieldAlgorithmMatchesConvexConcave)
+{
+	btAlignedObjectArray<float> heights;
+	srand(10);
+	//four planar slopes meeting at convex ridges: the algorithms choose different normals at the concave and
+	//almost flat edges between curved triangles by design, but must agree on planes and sharp convex edges
+	heights.resize(gGridSize * gGridSize);
+	for (int z = 0; z < gGridSize; z++)
+	{
+		for (int x = 0; x < gGridSize; x++)
+		{
+			heights[x + z * gGridSize] = float(btScalar(3.) - btScalar(0.08) * btFabs(btScalar(x - 50)) - btScalar(0.06) * btFabs(btScalar(z - 40)));
+		}
+	}
+	btHeightfieldTerrainShape* shape = createHeightfield(heights, gGridSize, 1, true);
+	btVector3 shapeMin, shapeMax;
+	shape->getAabb(btTransform::getIdentity(), shapeMin, shapeMax);
+	btCollisionObject terrain;
+	terrain.setCollisionShape(shape);
+
+	btDefaultCollisionConstructionInfo constructionInfo;
+	btDefaultCollisionConfiguration* configurations[2];
+	btCollisionDispatcher* dispatchers[2];
+	for (int a = 0; a < 2; a++)
+	{
+		constructionInfo.m_useConvexHeightfieldAlgorithm = a == 0;
+		configurations[a] = new btDefaultCollisionConfiguration(constructionInfo);
+		dispatchers[a] = new btCollisionDispatcher(configurations[a]);
+	}
+
+	btSphereShape sphere(btScalar(0.8));
+	btBoxShape box(btVector3(btScalar(0.9), btScalar(0.5), btScalar(0.7)));
+	btCapsuleShape capsule(btScalar(0.4), btScalar(1.2));
+	btConvexShape* convexShapes[3] = {&sphere, &box, &capsule};
+
+	int numContacts = 0;
+	for (int q = 0; q < 100; q++)
+	{
+		//put the shape on the ground, away from the borders
+		const btVector3 position = randomPoint(shapeMin + btVector3(4, 0, 4), shapeMax - btVector3(4, 0, 4));
+		const btVector3 rayFrom(position.x(), shapeMax.y() + btScalar(1.), position.z());
+		const btVector3 rayTo(position.x(), shapeMin.y() - btScalar(1.), position.z());
+		btClosestRayCallback ground(rayFrom, rayTo);
+		shape->performRaycast(&ground, rayFrom, rayTo);
+		ASSERT_LT(ground.m_hitFraction, btScalar(1.));
+		const btVector3 groundPoint = rayFrom.lerp(rayTo, ground.m_hitFraction);
+
+		btConvexShape* convexShape = convexShapes[q % 3];
+		btTransform trans(btQuaternion(btVector3(1, 0, 1).normalized(), btScalar(0.3) * btScalar(q)), btVector3(0, 0, 0));
+		const btVector3 lowest = trans(convexShape->localGetSupportingVertex(btVector3(0, -1, 0) * trans.getBasis()));
+		trans.setOrigin(groundPoint - lowest);
+		btCollisionObject convex;
+		convex.setCollisionShape(convexShape);
+
+		//on a slope, the lowest point is not the first to touch: find the touching height with the reference algorithm
+		btScalar below = trans.getOrigin().y() - btScalar(2.);
+		btScalar above = trans.getOrigin().y() + btScalar(1.);
+		for (int i = 0; i < 24; i++)
+		{
+			trans.getOrigin().setY(btScalar(0.5) * (below + above));
+			convex.setWorldTransform(trans);
+			if (getDeepestDistance(dispatchers[1], &convex, &terrain) < btScalar(0.))
+			{
+				below = trans.getOrigin().y();
+			}
+			else
+			{
+				above = trans.getOrigin().y();
+			}
+		}
+		//sink it by less than the margin of the box, so that both algorithms compute the penetration with GJK, not the approximate MPR
+		trans.getOrigin().setY(above - btScalar(0.03));
+		convex.setWorldTransform(trans);
+
+		btCollectContactsResult* results[2];
+		for (int a = 0; a < 2; a++)
+		{
+			collectContacts(dispatchers[a], &convex, &terrain, results[a]);
+		}
+		ASSERT_GT(results[1]->m_contacts.size(), 0);
+		ASSERT_GT(results[0]->m_contacts.size(), 0);
+		const btContact& expected = results[1]->getDeepestContact();
+		const btContact& actual = results[0]->getDeepestContact();
+		EXPECT_LT(expected.m_distance, btScalar(0.));
+		EXPECT_NEAR(expected.m_distance, actual.m_distance, 0.005);
+		EXPECT_GT(expected.m_normal.dot(actual.m_normal), btScalar(0.99));
+		numContacts += results[0]->m_contacts.size();
+		delete results[0];
+		delete results[1];
+	}
+	EXPECT_GT(numContacts, 0);
+
+	for (int a = 0; a < 2; a++)
+	{
+		delete dispatchers[a];
+		delete configurations[a];
+	}
+	delete shape;
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,282 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btConvexPolyhedron.h>
+#include <BulletCollision/NarrowPhaseCollision/btPolyhedralContactClipping.h>
+#include <gtest/gtest.h>
+
+static btScalar randomScalar(btScalar minValue, btScalar maxValue)
+{
+	return minValue + (maxValue - minValue) * btScalar(rand()) / RAND_MAX;
+}
+
+static btVector3 randomDirection()
+{
+	btVector3 dir;
+	do
+	{
+		dir.setValue(randomScalar(-1, 1), randomScalar(-1, 1), randomScalar(-1, 1));
+	} while (dir.length2() < btScalar(0.01) || dir.length2() > btScalar(1.));
+	return dir.normalized();
+}
+
+static btQuaternion randomRotation()
+{
+	return btQuaternion(randomDirection(), randomScalar(0, SIMD_2_PI));
+}
+
+//a hull of random points on an ellipsoid, with numPoints * 2 - 4 triangle faces
+static btConvexHullShape* createRandomHull(int numPoints, const btVector3& radii)
+{
+	btConvexHullShape* hull = new btConvexHullShape();
+	for (int i = 0; i < numPoints; i++)
+	{
+		hull->addPoint(randomDirection() * radii, false);
+	}
+	hull->recalcLocalAabb();
+	hull->initializePolyhedralFeatures();
+	return hull;
+}
+
+struct btIgnoreResult : public btDiscreteCollisionDetectorInterface::Result
+{
+	virtual void setShapeIdentifiersA(int partId0, int index0) {}
+	virtual void setShapeIdentifiersB(int partId1, int index1) {}
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth) {}
+};
+
+//the overlap of the projections of the hulls on the axis, the penetration depth when the axis is the separating axis
+static btScalar getOverlap(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, const btVector3& axis)
+{
+	btScalar minA, maxA, minB, maxB;
+	btVector3 witnessMin, witnessMax;
+	hullA.project(transA, axis, minA, maxA, witnessMin, witnessMax);
+	hullB.project(transB, axis, minB, maxB, witnessMin, witnessMax);
+	return btMin(maxA - minB, maxB - minA);
+}
+
+//the cached feature and the Gauss map pruning find the same separation and penetration depth as the search over all
+//unique edge pairs, along random trajectories of the hulls, so the cache is warm from one pose to the next
+GTEST_TEST(BulletCollision, SeparatingAxisCacheMatchesUniqueEdgeSearch)
+{
+	srand(1);
+	btConvexHullShape* shapeA = createRandomHull(27, btVector3(btScalar(1.), btScalar(0.8), btScalar(0.6)));
+	btConvexHullShape* shapeB = createRandomHull(15, btVector3(btScalar(0.7), btScalar(0.9), btScalar(0.5)));
+	const btConvexPolyhedron& hullA = *shapeA->getConvexPolyhedron();
+	const btConvexPolyhedron& hullB = *shapeB->getConvexPolyhedron();
+	ASSERT_EQ(hullA.m_faces.size(), 50);
+	ASSERT_EQ(hullB.m_faces.size(), 26);
+	ASSERT_GT(hullA.m_edges.size(), 0);
+	ASSERT_GT(hullB.m_edges.size(), 0);
+
+	//without the edge adjacency, findSeparatingAxis tests all pairs of unique edges
+	btConvexPolyhedron referenceA = hullA;
+	btConvexPolyhedron referenceB = hullB;
+	referenceA.m_edges.clear();
+	referenceB.m_edges.clear();
+
+	btSeparatingAxisCache cache;
+	btIgnoreResult result;
+	int numOverlapping = 0;
+	int numSeparated = 0;
+	for (int trajectory = 0; trajectory < 100; trajectory++)
+	{
+		const btVector3 start = randomDirection() * randomScalar(btScalar(0.5), btScalar(2.));
+		const btVector3 velocity = randomDirection() * btScalar(0.05);
+		const btQuaternion rotationA = randomRotation();
+		const btQuaternion rotationB = randomRotation();
+		const btQuaternion spin(randomDirection(), btScalar(0.05));
+		for (int step = 0; step < 20; step++)
+		{
+			btQuaternion rotationStep = btQuaternion::getIdentity();
+			for (int k = 0; k < step; k++)
+			{
+				rotationStep *= spin;
+			}
+			const btTransform transA(rotationA, btVector3(0, 0, 0));
+			const btTransform transB(rotationStep * rotationB, start + velocity * btScalar(step));
+
+			btVector3 expectedSep, actualSep;
+			const bool expected = btPolyhedralContactClipping::findSeparatingAxis(referenceA, referenceB, transA, transB, expectedSep, result);
+			const bool actual = btPolyhedralContactClipping::findSeparatingAxis(hullA, hullB, transA, transB, actualSep, result, &cache);
+			ASSERT_EQ(expected, actual) << "trajectory " << trajectory << " step " << step;
+			if (expected)
+			{
+				const btScalar expectedDepth = getOverlap(hullA, hullB, transA, transB, expectedSep);
+				const btScalar actualDepth = getOverlap(hullA, hullB, transA, transB, actualSep);
+				EXPECT_NEAR(actualDepth, expectedDepth, btScalar(1e-4)) << "trajectory " << trajectory << " step " << step;
+				numOverlapping++;
+			}
+			else
+			{
+				numSeparated++;
+			}
+		}
+	}
+	EXPECT_GT(numOverlapping, 200);
+	EXPECT_GT(numSeparated, 200);
+
+	delete shapeB;
+	delete shapeA;
+}
+
+//clips the faces of two hulls, reporting all clipped points (maxNumContacts 0) or at most maxNumContacts of them
+static void clipHulls(const btCollisionObject& objA, const btCollisionObject& objB, int maxNumContacts, btDiscreteCollisionDetectorInterface::Result& resultOut)
+{
+	const btConvexPolyhedron& hullA = *static_cast<const btPolyhedralConvexShape*>(objA.getCollisionShape())->getConvexPolyhedron();
+	const btConvexPolyhedron& hullB = *static_cast<const btPolyhedralConvexShape*>(objB.getCollisionShape())->getConvexPolyhedron();
+	btIgnoreResult ignore;
+	btVector3 sep;
+	if (!btPolyhedralContactClipping::findSeparatingAxis(hullA, hullB, objA.getWorldTransform(), objB.getWorldTransform(), sep, ignore))
+	{
+		return;
+	}
+	const btScalar threshold = btScalar(0.02);
+	btVertexArray worldVertsB1;
+	btVertexArray worldVertsB2;
+	btPolyhedralContactClipping::clipHullAgainstHull(sep, hullA, hullB, objA.getWorldTransform(), objB.getWorldTransform(),
+													 btScalar(-1.) - threshold, threshold, worldVertsB1, worldVertsB2, resultOut, maxNumContacts);
+}
+
+//the contacts that reach a manifold through btManifoldResult, which reduces them to MANIFOLD_CACHE_SIZE points one at a time
+static void clipHullsToManifold(btCollisionObject& objA, btCollisionObject& objB, int maxNumContacts, btPersistentManifold& manifold)
+{
+	btCollisionObjectWrapper obA(0, objA.getCollisionShape(), &objA, objA.getWorldTransform(), -1, -1);
+	btCollisionObjectWrapper obB(0, objB.getCollisionShape(), &objB, objB.getWorldTransform(), -1, -1);
+	btManifoldResult result(&obA, &obB);
+	result.setPersistentManifold(&manifold);
+	clipHulls(objA, objB, maxNumContacts, result);
+}
+
+struct btCollectResult : public btIgnoreResult
+{
+	btAlignedObjectArray<btScalar> m_depths;
+
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+	{
+		m_depths.push_back(depth);
+	}
+};
+
+static bool hasContact(const btPersistentManifold& manifold, const btManifoldPoint& pt)
+{
+	for (int i = 0; i < manifold.getNumContacts(); i++)
+	{
+		if ((manifold.getContactPoint(i).m_positionWorldOnB - pt.m_positionWorldOnB).length2() < btScalar(1e-10) &&
+			btFabs(manifold.getContactPoint(i).getDistance() - pt.getDistance()) < btScalar(1e-6))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static btScalar getMinDistance(const btPersistentManifold& manifold)
+{
+	btScalar minDistance = BT_LARGE_FLOAT;
+	for (int i = 0; i < manifold.getNumContacts(); i++)
+	{
+		minDistance = btMin(minDistance, manifold.getContactPoint(i).getDistance());
+	}
+	return minDistance;
+}
+
+//the area of the convex polygon of the contacts, in any order
+static btScalar getContactArea(const btPersistentManifold& manifold)
+{
+	const int numContacts = manifold.getNumContacts();
+	if (numContacts < 3)
+	{
+		return 0;
+	}
+	btVector3 points[MANIFOLD_CACHE_SIZE];
+	btScalar angles[MANIFOLD_CACHE_SIZE];
+	btVector3 center(0, 0, 0);
+	for (int i = 0; i < numContacts; i++)
+	{
+		points[i] = manifold.getContactPoint(i).m_positionWorldOnB;
+		center += points[i];
+	}
+	center /= btScalar(numContacts);
+	const btVector3& normal = manifold.getContactPoint(0).m_normalWorldOnB;
+	btVector3 u, v;
+	btPlaneSpace1(normal, u, v);
+	for (int i = 0; i < numContacts; i++)
+	{
+		angles[i] = btAtan2((points[i] - center).dot(v), (points[i] - center).dot(u));
+		for (int j = i; j > 0 && angles[j - 1] > angles[j]; j--)
+		{
+			btSwap(angles[j - 1], angles[j]);
+			btSwap(points[j - 1], points[j]);
+		}
+	}
+	btScalar area = 0;
+	for (int i = 0; i < numContacts; i++)
+	{
+		area += (points[i] - center).cross(points[(i + 1) % numContacts] - center).dot(normal);
+	}
+	return btFabs(area) * btScalar(0.5);
+}
+
+//a box resting on a box, turned around the contact normal and slightly tilted, so up to 8 points are clipped.
+//The clipping reduces them before they reach the manifold: with at most MANIFOLD_CACHE_SIZE points the manifold gets the
+//same contacts as before, with more points it keeps the deepest one and covers at least the area of the manifold reduction
+GTEST_TEST(BulletCollision, ClippedContactReductionMatchesManifoldReduction)
+{
+	srand(3);
+	btBoxShape boxA(btVector3(btScalar(1.), btScalar(0.2), btScalar(1.)));
+	btBoxShape boxB(btVector3(btScalar(0.7), btScalar(0.2), btScalar(0.7)));
+	boxA.initializePolyhedralFeatures();
+	boxB.initializePolyhedralFeatures();
+	btCollisionObject objA;
+	objA.setCollisionShape(&boxA);
+	btCollisionObject objB;
+	objB.setCollisionShape(&boxB);
+
+	int numSame = 0;
+	int numReduced = 0;
+	for (int q = 0; q < 500; q++)
+	{
+		const btQuaternion turn(btVector3(0, 1, 0), randomScalar(0, SIMD_2_PI));
+		const btQuaternion tilt(randomDirection(), randomScalar(0, btScalar(0.02)));
+		const btVector3 offset(randomScalar(-1, 1), btScalar(0.4) - randomScalar(0, btScalar(0.02)), randomScalar(-1, 1));
+		objB.setWorldTransform(btTransform(tilt * turn, offset));
+
+		btCollectResult clipped;
+		clipHulls(objA, objB, 0, clipped);
+		btPersistentManifold manifoldReduction(&objA, &objB, 0, btScalar(0.02), btScalar(0.02));
+		clipHullsToManifold(objA, objB, 0, manifoldReduction);
+		btPersistentManifold clippingReduction(&objA, &objB, 0, btScalar(0.02), btScalar(0.02));
+		clipHullsToManifold(objA, objB, MANIFOLD_CACHE_SIZE, clippingReduction);
+
+		if (clipped.m_depths.size() <= MANIFOLD_CACHE_SIZE)
+		{
+			ASSERT_EQ(clippingReduction.getNumContacts(), manifoldReduction.getNumContacts()) << "pose " << q;
+			for (int i = 0; i < manifoldReduction.getNumContacts(); i++)
+			{
+				EXPECT_TRUE(hasContact(clippingReduction, manifoldReduction.getContactPoint(i))) << "pose " << q << " contact " << i;
+			}
+			numSame += clipped.m_depths.size() > 0;
+		}
+		else
+		{
+			ASSERT_EQ(clippingReduction.getNumContacts(), MANIFOLD_CACHE_SIZE) << "pose " << q;
+			btScalar deepest = BT_LARGE_FLOAT;
+			for (int i = 0; i < clipped.m_depths.size(); i++)
+			{
+				deepest = btMin(deepest, clipped.m_depths[i]);
+			}
+			EXPECT_NEAR(getMinDistance(clippingReduction), deepest, btScalar(1e-6)) << "pose " << q;
+			//both reductions are local optima, either can be slightly larger
+			EXPECT_GE(getContactArea(clippingReduction), getContactArea(manifoldReduction) * btScalar(0.98)) << "pose " << q;
+			numReduced++;
+		}
+	}
+	EXPECT_GT(numSame, 50);
+	EXPECT_GT(numReduced, 50);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,178 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionDispatch/btPrimitivePairCollisionAlgorithm.h>
+#include <gtest/gtest.h>
+
+struct btContact
+{
+	btScalar m_distance;
+	btVector3 m_normal;
+};
+
+//collects the points that btManifoldResult would add to the manifold, and the contact breaking threshold of the manifold
+struct btCollectContactsResult : public btManifoldResult
+{
+	btAlignedObjectArray<btContact> m_contacts;
+	btScalar m_contactBreakingThreshold;
+
+	btCollectContactsResult(const btCollisionObjectWrapper* obj0Wrap, const btCollisionObjectWrapper* obj1Wrap)
+		: btManifoldResult(obj0Wrap, obj1Wrap),
+		  m_contactBreakingThreshold(0)
+	{
+	}
+
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+	{
+		(void)pointInWorld;
+		m_contactBreakingThreshold = getPersistentManifold()->getContactBreakingThreshold();
+		if (depth > m_contactBreakingThreshold)
+			return;
+		btContact contact;
+		contact.m_distance = depth;
+		contact.m_normal = normalOnBInWorld;
+		m_contacts.push_back(contact);
+	}
+};
+
+static void collectContacts(btDispatcher* dispatcher, btCollisionObject* objA, btCollisionObject* objB, btCollectContactsResult*& result)
+{
+	btCollisionObjectWrapper obA(0, objA->getCollisionShape(), objA, objA->getWorldTransform(), -1, -1);
+	btCollisionObjectWrapper obB(0, objB->getCollisionShape(), objB, objB->getWorldTransform(), -1, -1);
+	btCollisionAlgorithm* algorithm = dispatcher->findAlgorithm(&obA, &obB, 0, BT_CONTACT_POINT_ALGORITHMS);
+	ASSERT_TRUE(algorithm != 0);
+	result = new btCollectContactsResult(&obA, &obB);
+	btDispatcherInfo dispatchInfo;
+	algorithm->processCollision(&obA, &obB, dispatchInfo, result);
+	algorithm->~btCollisionAlgorithm();
+	dispatcher->freeCollisionAlgorithm(algorithm);
+}
+
+static btScalar randomScalar(btScalar minValue, btScalar maxValue)
+{
+	return minValue + (maxValue - minValue) * btScalar(rand()) / RAND_MAX;
+}
+
+static btVector3 randomDirection()
+{
+	btVector3 dir;
+	do
+	{
+		dir.setValue(randomScalar(-1, 1), randomScalar(-1, 1), randomScalar(-1, 1));
+	} while (dir.length2() < btScalar(0.01) || dir.length2() > btScalar(1.));
+	return dir.normalized();
+}
+
+static btQuaternion randomRotation()
+{
+	return btQuaternion(randomDirection(), randomScalar(0, SIMD_2_PI));
+}
+
+//the penetration of the shapes along the normal, that points from B to A
+static btScalar getOverlap(const btCollisionObject& objA, const btCollisionObject& objB, const btVector3& normalOnB)
+{
+	const btConvexShape* a = static_cast<const btConvexShape*>(objA.getCollisionShape());
+	const btConvexShape* b = static_cast<const btConvexShape*>(objB.getCollisionShape());
+	const btVector3 dirA = -normalOnB * objA.getWorldTransform().getBasis();
+	const btVector3 dirB = normalOnB * objB.getWorldTransform().getBasis();
+	const btVector3 supportA = objA.getWorldTransform() * (a->localGetSupportingVertexWithoutMargin(dirA) + dirA * a->getMargin());
+	const btVector3 supportB = objB.getWorldTransform() * (b->localGetSupportingVertexWithoutMargin(dirB) + dirB * b->getMargin());
+	return (supportB - supportA).dot(normalOnB);
+}
+
+//the primitive pair kernel finds the contacts of btConvexConvexAlgorithm, over random poses from deep penetration to separation
+static void checkPair(btCollisionShape* shapeA, btCollisionShape* shapeB)
+{
+	ASSERT_TRUE(btPrimitivePairCollisionAlgorithm::hasKernel(shapeA->getShapeType(), shapeB->getShapeType()));
+
+	btDefaultCollisionConstructionInfo constructionInfo;
+	constructionInfo.m_usePrimitivePairAlgorithm = true;
+	btDefaultCollisionConfiguration primitivePairConfig(constructionInfo);
+	btCollisionDispatcher primitivePairDispatcher(&primitivePairConfig);
+	btDefaultCollisionConfiguration convexConvexConfig;
+	btCollisionDispatcher convexConvexDispatcher(&convexConvexConfig);
+
+	btCollisionObject objA;
+	objA.setCollisionShape(shapeA);
+	btCollisionObject objB;
+	objB.setCollisionShape(shapeB);
+	btVector3 center;
+	btScalar radiusA, radiusB;
+	shapeA->getBoundingSphere(center, radiusA);
+	shapeB->getBoundingSphere(center, radiusB);
+
+	int numContacts = 0;
+	int numPenetrations = 0;
+	for (int q = 0; q < 300; q++)
+	{
+		objA.setWorldTransform(btTransform(randomRotation(), btVector3(0, 0, 0)));
+		//every other pose deep inside, where the cores overlap
+		const btScalar maxOffset = (q & 1) ? radiusA + radiusB : (radiusA + radiusB) * btScalar(0.3);
+		objB.setWorldTransform(btTransform(randomRotation(), randomDirection() * randomScalar(0, maxOffset)));
+
+		btCollectContactsResult* expected = 0;
+		btCollectContactsResult* actual = 0;
+		collectContacts(&convexConvexDispatcher, &objA, &objB, expected);
+		collectContacts(&primitivePairDispatcher, &objA, &objB, actual);
+		ASSERT_TRUE(expected && actual);
+
+		if (expected->m_contacts.size() != actual->m_contacts.size())
+		{
+			//only at the contact breaking threshold, where the algorithms round differently
+			const btContact& contact = expected->m_contacts.size() ? expected->m_contacts[0] : actual->m_contacts[0];
+			const btScalar threshold = expected->m_contacts.size() ? expected->m_contactBreakingThreshold : actual->m_contactBreakingThreshold;
+			EXPECT_NEAR(contact.m_distance, threshold, 1e-3) << shapeA->getName() << "-" << shapeB->getName() << " pose " << q;
+		}
+		else
+		{
+			ASSERT_LE(actual->m_contacts.size(), 1) << shapeA->getName() << "-" << shapeB->getName() << " pose " << q;
+			if (actual->m_contacts.size())
+			{
+				const btContact& a = expected->m_contacts[0];
+				const btContact& b = actual->m_contacts[0];
+				EXPECT_NEAR(b.m_distance, a.m_distance, 2e-3) << shapeA->getName() << "-" << shapeB->getName() << " pose " << q;
+				//or another normal with the same penetration, when several faces are as deep
+				EXPECT_TRUE(a.m_normal.dot(b.m_normal) > btScalar(0.99) || btFabs(getOverlap(objA, objB, b.m_normal) + b.m_distance) < btScalar(2e-3))
+					<< shapeA->getName() << "-" << shapeB->getName() << " pose " << q;
+				numContacts++;
+				numPenetrations += a.m_distance < 0;
+			}
+		}
+		delete expected;
+		delete actual;
+	}
+	EXPECT_GT(numContacts, 100) << shapeA->getName() << "-" << shapeB->getName();
+	EXPECT_GT(numPenetrations, 50) << shapeA->getName() << "-" << shapeB->getName();
+}
+
+GTEST_TEST(BulletCollision, PrimitivePairMatchesConvexConvex)
+{
+	srand(1);
+	btSphereShape sphere(btScalar(0.5));
+	btCapsuleShape capsule(btScalar(0.3), btScalar(1.));
+	btCapsuleShapeX capsuleX(btScalar(0.25), btScalar(0.8));
+	btBoxShape box(btVector3(btScalar(0.6), btScalar(0.4), btScalar(0.5)));
+	btCylinderShape cylinder(btVector3(btScalar(0.4), btScalar(0.6), btScalar(0.4)));
+	btConvexHullShape hull;
+	for (int i = 0; i < 16; i++)
+	{
+		hull.addPoint(randomDirection() * btVector3(btScalar(0.7), btScalar(0.5), btScalar(0.4)), false);
+	}
+	hull.recalcLocalAabb();
+
+	checkPair(&sphere, &capsule);
+	checkPair(&capsule, &sphere);
+	checkPair(&capsule, &capsule);
+	checkPair(&capsule, &capsuleX);
+	checkPair(&capsule, &box);
+	checkPair(&box, &capsule);
+	checkPair(&sphere, &hull);
+	checkPair(&hull, &sphere);
+	checkPair(&cylinder, &box);
+	checkPair(&box, &cylinder);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
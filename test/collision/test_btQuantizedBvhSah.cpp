@@ -0,0 +1,158 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <LinearMath/btThreads.h>
+#include "BvhTestUtil.h"
+
+//both trees report each triangle once, but in the order of their own leaves
+static void expectSameTriangles(btCollectTrianglesCallback& median, btCollectTrianglesCallback& sah)
+{
+	median.m_triangles.quickSort(btLessIntPredicate());
+	sah.m_triangles.quickSort(btLessIntPredicate());
+	ASSERT_EQ(median.m_triangles.size(), sah.m_triangles.size());
+	for (int i = 0; i < median.m_triangles.size(); i++)
+	{
+		EXPECT_EQ(median.m_triangles[i], sah.m_triangles[i]);
+	}
+}
+
+static void testSahMatchesMedianSplit(int meshSize, bool useQuantizedAabbCompression)
+{
+	btTriangleMesh* mesh = createTerrainMesh(meshSize);
+	btVector3 aabbMin, aabbMax;
+	mesh->calculateAabbBruteForce(aabbMin, aabbMax);
+
+	btOptimizedBvh* medianBvh = new btOptimizedBvh();
+	medianBvh->build(mesh, useQuantizedAabbCompression, aabbMin, aabbMax, btQuantizedBvh::BUILD_MEDIAN_SPLIT);
+	btOptimizedBvh* sahBvh = new btOptimizedBvh();
+	sahBvh->build(mesh, useQuantizedAabbCompression, aabbMin, aabbMax, btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC);
+
+	int numReported = 0;
+	srand(11);
+	for (int q = 0; q < 200; q++)
+	{
+		const btVector3 center = randomPoint(aabbMin, aabbMax);
+		const btVector3 halfExtents = randomPoint(btVector3(0.1, 0.1, 0.1), btVector3(3, 3, 3));
+		const btVector3 target = randomPoint(aabbMin, aabbMax);
+
+		btCollectTrianglesCallback median[3];
+		btCollectTrianglesCallback sah[3];
+		medianBvh->reportAabbOverlappingNodex(&median[0], center - halfExtents, center + halfExtents);
+		sahBvh->reportAabbOverlappingNodex(&sah[0], center - halfExtents, center + halfExtents);
+		medianBvh->reportRayOverlappingNodex(&median[1], center, target);
+		sahBvh->reportRayOverlappingNodex(&sah[1], center, target);
+		medianBvh->reportBoxCastOverlappingNodex(&median[2], center, target, -halfExtents, halfExtents);
+		sahBvh->reportBoxCastOverlappingNodex(&sah[2], center, target, -halfExtents, halfExtents);
+		for (int k = 0; k < 3; k++)
+		{
+			numReported += median[k].m_triangles.size();
+			expectSameTriangles(median[k], sah[k]);
+		}
+	}
+	EXPECT_GT(numReported, 0);
+
+	delete sahBvh;
+	delete medianBvh;
+	delete mesh;
+}
+
+GTEST_TEST(BulletCollision, QuantizedBvhSahMatchesMedianSplit)
+{
+	testSahMatchesMedianSplit(16, true);
+	testSahMatchesMedianSplit(80, true);
+}
+
+GTEST_TEST(BulletCollision, BvhSahMatchesMedianSplit)
+{
+	testSahMatchesMedianSplit(16, false);
+	testSahMatchesMedianSplit(80, false);
+}
+
+#if BT_THREADSAFE
+//gives access to the nodes, to compare whole trees
+struct btNodeAccessBvh : public btOptimizedBvh
+{
+	int getNodeCount() const
+	{
+		return m_curNodeIndex;
+	}
+
+	const NodeArray& getContiguousNodes() const
+	{
+		return m_contiguousNodes;
+	}
+};
+
+static void expectSameTree(btNodeAccessBvh* a, btNodeAccessBvh* b)
+{
+	ASSERT_EQ(a->isQuantized(), b->isQuantized());
+	ASSERT_EQ(a->getNodeCount(), b->getNodeCount());
+	for (int i = 0; i < a->getNodeCount(); i++)
+	{
+		if (a->isQuantized())
+		{
+			const btQuantizedBvhNode& nodeA = a->getQuantizedNodeArray()[i];
+			const btQuantizedBvhNode& nodeB = b->getQuantizedNodeArray()[i];
+			EXPECT_EQ(nodeA.m_escapeIndexOrTriangleIndex, nodeB.m_escapeIndexOrTriangleIndex);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				EXPECT_EQ(nodeA.m_quantizedAabbMin[axis], nodeB.m_quantizedAabbMin[axis]);
+				EXPECT_EQ(nodeA.m_quantizedAabbMax[axis], nodeB.m_quantizedAabbMax[axis]);
+			}
+		}
+		else
+		{
+			const btOptimizedBvhNode& nodeA = a->getContiguousNodes()[i];
+			const btOptimizedBvhNode& nodeB = b->getContiguousNodes()[i];
+			EXPECT_EQ(nodeA.m_escapeIndex, nodeB.m_escapeIndex);
+			EXPECT_EQ(nodeA.m_subPart, nodeB.m_subPart);
+			EXPECT_EQ(nodeA.m_triangleIndex, nodeB.m_triangleIndex);
+			EXPECT_EQ(nodeA.m_aabbMinOrg, nodeB.m_aabbMinOrg);
+			EXPECT_EQ(nodeA.m_aabbMaxOrg, nodeB.m_aabbMaxOrg);
+		}
+	}
+	if (a->isQuantized())
+	{
+		ASSERT_EQ(a->getSubtreeInfoArray().size(), b->getSubtreeInfoArray().size());
+		for (int i = 0; i < a->getSubtreeInfoArray().size(); i++)
+		{
+			EXPECT_EQ(a->getSubtreeInfoArray()[i].m_rootNodeIndex, b->getSubtreeInfoArray()[i].m_rootNodeIndex);
+			EXPECT_EQ(a->getSubtreeInfoArray()[i].m_subtreeSize, b->getSubtreeInfoArray()[i].m_subtreeSize);
+		}
+	}
+}
+
+//with a task scheduler, meshes above 8192 triangles are binned and partitioned in parallel tasks,
+//the tree must be the one of the serial build
+GTEST_TEST(BulletCollision, BvhSahParallelMatchesSerial)
+{
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	ASSERT_TRUE(scheduler != 0);
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btTriangleMesh* mesh = createTerrainMesh(80);
+	btVector3 aabbMin, aabbMax;
+	mesh->calculateAabbBruteForce(aabbMin, aabbMax);
+	for (int q = 0; q < 2; q++)
+	{
+		const bool useQuantizedAabbCompression = (q == 0);
+		btSetTaskScheduler(0);
+		btNodeAccessBvh* serialBvh = new btNodeAccessBvh();
+		serialBvh->build(mesh, useQuantizedAabbCompression, aabbMin, aabbMax, btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC);
+		btSetTaskScheduler(scheduler);
+		btNodeAccessBvh* parallelBvh = new btNodeAccessBvh();
+		parallelBvh->build(mesh, useQuantizedAabbCompression, aabbMin, aabbMax, btQuantizedBvh::BUILD_SURFACE_AREA_HEURISTIC);
+		btSetTaskScheduler(0);
+		expectSameTree(serialBvh, parallelBvh);
+		delete parallelBvh;
+		delete serialBvh;
+	}
+	delete mesh;
+	delete scheduler;
+}
+#endif  //BT_THREADSAFE
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+
+#include <LinearMath/btThreads.h>
+#include <LinearMath/btAlignedObjectArray.h>
+#include <LinearMath/btMinMax.h>
+#include <gtest/gtest.h>
+
+#if BT_THREADSAFE
+static const int kNumOuter = 48;
+static const int kNumInner = 100;
+static const int kNumMarks = 32;
+
+//sums offset + k, small integers, so the sum is exact in any order
+struct btInnerSumBody : public btIParallelSumBody
+{
+	int m_offset;
+
+	btInnerSumBody(int offset) : m_offset(offset) {}
+
+	btScalar sumLoop(int iBegin, int iEnd) const
+	{
+		btScalar sum = 0;
+		for (int k = iBegin; k < iEnd; k++)
+		{
+			sum += btScalar(m_offset + k);
+		}
+		return sum;
+	}
+};
+
+static btScalar getInnerSum(int offset)
+{
+	return btScalar(kNumInner * offset + kNumInner * (kNumInner - 1) / 2);
+}
+
+//counts the executions of each iteration, and spins a little, so that the other threads steal
+struct btMarkBody : public btIParallelForBody
+{
+	int* m_marks;
+
+	btMarkBody(int* marks) : m_marks(marks) {}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			volatile btScalar sum = 0;
+			for (int k = 0; k < 200; k++)
+			{
+				sum = sum + btScalar(k);
+			}
+			m_marks[i]++;
+		}
+	}
+};
+
+//a parallelFor and a parallelSum nested in each iteration of a parallelFor
+struct btOuterForBody : public btIParallelForBody
+{
+	int* m_counts;
+	btScalar* m_sums;
+	int* m_marks;
+
+	btOuterForBody(int* counts, btScalar* sums, int* marks) : m_counts(counts), m_sums(sums), m_marks(marks) {}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_counts[i]++;
+			m_sums[i] = btParallelSum(0, kNumInner, 4, btInnerSumBody(i));
+			btParallelFor(0, kNumMarks, 2, btMarkBody(&m_marks[i * kNumMarks]));
+		}
+	}
+};
+
+//the same nested in each iteration of a parallelSum
+struct btOuterSumBody : public btIParallelSumBody
+{
+	int* m_marks;
+
+	btOuterSumBody(int* marks) : m_marks(marks) {}
+
+	btScalar sumLoop(int iBegin, int iEnd) const
+	{
+		btScalar sum = 0;
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btParallelFor(0, kNumMarks, 2, btMarkBody(&m_marks[i * kNumMarks]));
+			sum += btParallelSum(0, kNumInner, 4, btInnerSumBody(i));
+		}
+		return sum;
+	}
+};
+
+GTEST_TEST(BulletCollision, TaskSchedulerWorkStealingNestedLoops)
+{
+	btITaskScheduler* scheduler = btCreateWorkStealingTaskScheduler();
+	ASSERT_TRUE(scheduler != 0);
+	btSetTaskScheduler(scheduler);
+	const int maxNumThreads = btMin(4, scheduler->getMaxNumThreads());
+
+	btAlignedObjectArray<int> counts;
+	btAlignedObjectArray<btScalar> sums;
+	btAlignedObjectArray<int> marks;
+	btScalar expectedTotal = 0;
+	for (int i = 0; i < kNumOuter; i++)
+	{
+		expectedTotal += getInnerSum(i);
+	}
+
+	for (int iteration = 0; iteration < 200; iteration++)
+	{
+		scheduler->setNumThreads(1 + iteration % maxNumThreads);
+		counts.resize(0);
+		counts.resize(kNumOuter, 0);
+		sums.resize(0);
+		sums.resize(kNumOuter, btScalar(-1));
+		marks.resize(0);
+		marks.resize(kNumOuter * kNumMarks, 0);
+
+		btParallelFor(0, kNumOuter, 1, btOuterForBody(&counts[0], &sums[0], &marks[0]));
+		for (int i = 0; i < kNumOuter; i++)
+		{
+			ASSERT_EQ(counts[i], 1) << "iteration " << iteration << " outer " << i;
+			ASSERT_EQ(sums[i], getInnerSum(i)) << "iteration " << iteration << " outer " << i;
+		}
+
+		const btScalar total = btParallelSum(0, kNumOuter, 1, btOuterSumBody(&marks[0]));
+		ASSERT_EQ(total, expectedTotal) << "iteration " << iteration;
+		//once by the parallelFor and once by the parallelSum
+		for (int i = 0; i < marks.size(); i++)
+		{
+			ASSERT_EQ(marks[i], 2) << "iteration " << iteration << " mark " << i;
+		}
+	}
+
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+#endif  //BT_THREADSAFE
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+
+#include <LinearMath/btThreadLocalPoolAllocator.h>
+#include <LinearMath/btPoolAllocator.h>
+#include <LinearMath/btAlignedObjectArray.h>
+#include <LinearMath/btMinMax.h>
+#include <gtest/gtest.h>
+
+#if BT_THREADSAFE
+struct btAllocateBody : public btIParallelForBody
+{
+	btThreadLocalPoolAllocator* m_allocator;
+	void** m_elements;
+
+	btAllocateBody(btThreadLocalPoolAllocator* allocator, void** elements) : m_allocator(allocator), m_elements(elements) {}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_elements[i] = m_allocator->allocate(m_allocator->getElementSize(), false);
+			//some work per element, so that the other threads take part in the loop
+			volatile btScalar sum = 0;
+			for (int k = 0; k < 2000; k++)
+			{
+				sum = sum + btSqrt(btScalar(k));
+			}
+		}
+	}
+};
+
+struct btFreeBody : public btIParallelForBody
+{
+	btThreadLocalPoolAllocator* m_allocator;
+	void** m_elements;
+
+	btFreeBody(btThreadLocalPoolAllocator* allocator, void** elements) : m_allocator(allocator), m_elements(elements) {}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_allocator->freeMemory(m_elements[i]);
+			m_elements[i] = 0;
+		}
+	}
+};
+
+struct btLessPointer
+{
+	bool operator()(const void* a, const void* b) const { return a < b; }
+};
+
+//all the elements are allocated, each exactly once, and the next allocation fails
+static void expectFullPool(btThreadLocalPoolAllocator* allocator, btAlignedObjectArray<void*>& elements)
+{
+	for (int i = 0; i < elements.size(); i++)
+	{
+		ASSERT_TRUE(elements[i] != 0) << "element " << i;
+		EXPECT_TRUE(allocator->getPool()->validPtr(elements[i]));
+	}
+	btAlignedObjectArray<void*> sorted = elements;
+	sorted.quickSort(btLessPointer());
+	for (int i = 1; i < sorted.size(); i++)
+	{
+		EXPECT_NE(sorted[i - 1], sorted[i]);
+	}
+	EXPECT_TRUE(allocator->allocate(allocator->getElementSize(), false) == 0);
+}
+
+GTEST_TEST(BulletCollision, ThreadLocalPoolAllocatorFillsFixedPoolAcrossThreads)
+{
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	ASSERT_TRUE(scheduler != 0);
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btSetTaskScheduler(scheduler);
+
+	const int numElements = 1000;
+	btPoolAllocator pool(64, numElements);
+	btThreadLocalPoolAllocator* allocator = new btThreadLocalPoolAllocator(&pool);
+	btAlignedObjectArray<void*> elements;
+	elements.resize(numElements, 0);
+
+	for (int iteration = 0; iteration < 20; iteration++)
+	{
+		btParallelFor(0, numElements, 1, btAllocateBody(allocator, &elements[0]));
+		expectFullPool(allocator, elements);
+
+		//the main thread frees every element to its own cache, the other threads then have to flush it
+		if (iteration & 1)
+		{
+			btParallelFor(0, numElements, 7, btFreeBody(allocator, &elements[0]));
+		}
+		else
+		{
+			btFreeBody(allocator, &elements[0]).forLoop(0, numElements);
+		}
+		if (iteration % 5 == 4)
+		{
+			allocator->flushCaches();
+		}
+	}
+	EXPECT_EQ(allocator->getNumArenaBlocks(), 0);
+
+	delete allocator;
+	EXPECT_EQ(pool.getFreeCount(), numElements);
+
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+#endif  //BT_THREADSAFE
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,428 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/CollisionShapes/btTiledHeightfieldTerrainShape.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* gTileFileName = "test_btTiledHeightfieldTerrainShape.tiles";
+static const int gNumTilesX = 3;
+static const int gNumTilesZ = 2;
+static const int gTileSize = 16;
+static const int gWidth = gNumTilesX * gTileSize + 1;
+static const int gLength = gNumTilesZ * gTileSize + 1;
+//the tile without data, the rays that are compared with the single heightfield stay away from it
+static const int gHoleTileX = 2;
+static const int gHoleTileZ = 1;
+
+//the heights are between heightOffset - 4.5 and heightOffset + 4.5
+template <typename T>
+static void createHeights(btAlignedObjectArray<T>& heights, btScalar heightScale, btScalar heightOffset)
+{
+	heights.resize(gWidth * gLength);
+	for (int z = 0; z < gLength; z++)
+	{
+		for (int x = 0; x < gWidth; x++)
+		{
+			const btScalar height = btScalar(4.) * btSin(btScalar(0.21) * x) * btCos(btScalar(0.17) * z) + btScalar(0.5) * btSin(btScalar(1.3) * x * z);
+			heights[z * gWidth + x] = T((height + heightOffset) / heightScale);
+		}
+	}
+}
+
+//copies the heights of each tile, the tiles share their border heights
+template <typename T>
+static void createTiles(const btAlignedObjectArray<T>& heights, btAlignedObjectArray<T>& tileHeights, btAlignedObjectArray<const void*>& tileData)
+{
+	const int tileSticks = gTileSize + 1;
+	tileHeights.resize(gNumTilesX * gNumTilesZ * tileSticks * tileSticks);
+	tileData.resize(gNumTilesX * gNumTilesZ);
+	for (int tileZ = 0; tileZ < gNumTilesZ; tileZ++)
+	{
+		for (int tileX = 0; tileX < gNumTilesX; tileX++)
+		{
+			const int tileIndex = tileZ * gNumTilesX + tileX;
+			T* tile = &tileHeights[tileIndex * tileSticks * tileSticks];
+			for (int z = 0; z < tileSticks; z++)
+			{
+				for (int x = 0; x < tileSticks; x++)
+				{
+					tile[z * tileSticks + x] = heights[(tileZ * gTileSize + z) * gWidth + tileX * gTileSize + x];
+				}
+			}
+			tileData[tileIndex] = (tileX == gHoleTileX && tileZ == gHoleTileZ) ? 0 : tile;
+		}
+	}
+}
+
+static btHeightfieldTileInfo getTileInfo(PHY_ScalarType heightDataType, btScalar heightScale, btScalar heightOffset)
+{
+	btHeightfieldTileInfo tileInfo;
+	tileInfo.m_numTilesX = gNumTilesX;
+	tileInfo.m_numTilesZ = gNumTilesZ;
+	tileInfo.m_tileSize = gTileSize;
+	tileInfo.m_heightDataType = heightDataType;
+	tileInfo.m_heightScale = heightScale;
+	tileInfo.m_minHeight = heightOffset - 5;
+	tileInfo.m_maxHeight = heightOffset + 5;
+	return tileInfo;
+}
+
+static void writeHeader(const btHeightfieldTileFileHeader& header)
+{
+	FILE* file = fopen(gTileFileName, "r+b");
+	ASSERT_TRUE(file != 0);
+	EXPECT_EQ(fwrite(&header, sizeof(header), 1, file), size_t(1));
+	fclose(file);
+}
+
+static bool readHeader(btHeightfieldTileFileHeader& header)
+{
+	FILE* file = fopen(gTileFileName, "rb");
+	if (!file)
+	{
+		return false;
+	}
+	const bool ok = fread(&header, sizeof(header), 1, file) == 1;
+	fclose(file);
+	return ok;
+}
+
+static btScalar castRay(btCollisionObject& object, const btVector3& from, const btVector3& to)
+{
+	btTransform fromTrans(btQuaternion::getIdentity(), from);
+	btTransform toTrans(btQuaternion::getIdentity(), to);
+	btCollisionWorld::ClosestRayResultCallback callback(from, to);
+	btCollisionWorld::rayTestSingle(fromTrans, toTrans, &object, object.getCollisionShape(), object.getWorldTransform(), callback);
+	return callback.hasHit() ? callback.m_closestHitFraction : btScalar(-1.);
+}
+
+static btScalar randomScalar(btScalar minValue, btScalar maxValue)
+{
+	return minValue + (maxValue - minValue) * btScalar(rand()) / RAND_MAX;
+}
+
+//the heights and the ray casts of the paged in tiles match a single heightfield with all the heights
+template <typename T>
+static void checkTiledTerrain(PHY_ScalarType heightDataType, btScalar heightScale, btScalar heightOffset)
+{
+	btAlignedObjectArray<T> heights;
+	btAlignedObjectArray<T> tileHeights;
+	btAlignedObjectArray<const void*> tileData;
+	createHeights(heights, heightScale, heightOffset);
+	createTiles(heights, tileHeights, tileData);
+	const btHeightfieldTileInfo tileInfo = getTileInfo(heightDataType, heightScale, heightOffset);
+	ASSERT_TRUE(btMappedHeightfieldTileFile::writeFile(gTileFileName, tileInfo, &tileData[0]));
+
+	btMappedHeightfieldTileFile tileFile;
+	ASSERT_TRUE(tileFile.open(gTileFileName));
+	EXPECT_EQ(tileFile.getTileInfo().m_numTilesX, gNumTilesX);
+	EXPECT_EQ(tileFile.getTileInfo().m_numTilesZ, gNumTilesZ);
+	EXPECT_EQ(tileFile.getTileInfo().m_tileSize, gTileSize);
+	EXPECT_EQ(tileFile.getTileInfo().m_heightDataType, heightDataType);
+
+	//the mapped tiles hold the written heights
+	const int tileDataSize = (gTileSize + 1) * (gTileSize + 1) * sizeof(T);
+	for (int i = 0; i < tileData.size(); i++)
+	{
+		const int tileX = i % gNumTilesX;
+		const int tileZ = i / gNumTilesX;
+		EXPECT_EQ(tileFile.hasTile(tileX, tileZ), tileData[i] != 0);
+		const void* mapped = tileFile.mapTile(tileX, tileZ);
+		EXPECT_EQ(mapped != 0, tileData[i] != 0);
+		if (mapped)
+		{
+			EXPECT_EQ(memcmp(mapped, tileData[i], tileDataSize), 0) << "tile " << i;
+			tileFile.unmapTile(tileX, tileZ, mapped);
+		}
+	}
+
+	const btVector3 scaling(btScalar(1.5), btScalar(1.), btScalar(0.75));
+	btHeightfieldTerrainShape heightfield(gWidth, gLength, &heights[0], heightScale, tileInfo.m_minHeight, tileInfo.m_maxHeight, 1, heightDataType, false);
+	heightfield.setUseDiamondSubdivision(true);
+	heightfield.setLocalScaling(scaling);
+	btTiledHeightfieldTerrainShape tiledTerrain(&tileFile, 1, false);
+	tiledTerrain.setUseDiamondSubdivision(true);
+	tiledTerrain.setLocalScaling(scaling);
+
+	btVector3 aabbMin, aabbMax, expectedMin, expectedMax;
+	tiledTerrain.getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
+	heightfield.getAabb(btTransform::getIdentity(), expectedMin, expectedMax);
+	for (int k = 0; k < 3; k++)
+	{
+		EXPECT_NEAR(aabbMin[k], expectedMin[k], 1e-4);
+		EXPECT_NEAR(aabbMax[k], expectedMax[k], 1e-4);
+	}
+
+	tiledTerrain.requestTiles(aabbMin, aabbMax);
+	tiledTerrain.updatePaging();
+	ASSERT_EQ(tiledTerrain.getNumResidentTiles(), gNumTilesX * gNumTilesZ - 1);
+	EXPECT_TRUE(tiledTerrain.getTileShape(gHoleTileX, gHoleTileZ) == 0);
+
+	//the vertices of each tile, in the space of the terrain, are the ones of the single heightfield
+	for (int i = 0; i < tiledTerrain.getNumChildShapes(); i++)
+	{
+		const btHeightfieldTerrainShape* tile = static_cast<const btHeightfieldTerrainShape*>(tiledTerrain.getChildShape(i));
+		const int tileX = tile->getUserIndex() % gNumTilesX;
+		const int tileZ = tile->getUserIndex() / gNumTilesX;
+		const btTransform& tileTrans = tiledTerrain.getChildTransform(i);
+		for (int z = 0; z <= gTileSize; z++)
+		{
+			for (int x = 0; x <= gTileSize; x++)
+			{
+				btVector3 vertex, expected;
+				tile->getVertex(x, z, vertex);
+				heightfield.getVertex(tileX * gTileSize + x, tileZ * gTileSize + z, expected);
+				vertex = tileTrans(vertex);
+				for (int k = 0; k < 3; k++)
+				{
+					ASSERT_NEAR(vertex[k], expected[k], 1e-4) << "tile " << tileX << " " << tileZ << " vertex " << x << " " << z;
+				}
+			}
+		}
+	}
+
+	btCollisionObject tiledObject;
+	tiledObject.setCollisionShape(&tiledTerrain);
+	btCollisionObject heightfieldObject;
+	heightfieldObject.setCollisionShape(&heightfield);
+
+	//vertical and slanted rays across the tile borders, away from the hole tile
+	const btScalar maxX = aabbMin.x() + (aabbMax.x() - aabbMin.x()) * gHoleTileX / gNumTilesX - btScalar(0.1);
+	int numHits = 0;
+	for (int q = 0; q < 300; q++)
+	{
+		const btVector3 from(randomScalar(aabbMin.x(), maxX), btScalar(8.), randomScalar(aabbMin.z(), aabbMax.z()));
+		btVector3 to(randomScalar(aabbMin.x(), maxX), btScalar(-8.), randomScalar(aabbMin.z(), aabbMax.z()));
+		if (q % 3 == 0)
+		{
+			to.setX(from.x());
+			to.setZ(from.z());
+		}
+		const btScalar expected = castRay(heightfieldObject, from, to);
+		const btScalar actual = castRay(tiledObject, from, to);
+		EXPECT_NEAR(actual, expected, 1e-4) << "ray " << q << " type " << heightDataType;
+		numHits += expected >= 0;
+	}
+	EXPECT_GT(numHits, 250);
+
+	//the rays into the hole tile miss
+	for (int q = 0; q < 20; q++)
+	{
+		const btScalar x = randomScalar(maxX + btScalar(0.5), aabbMax.x());
+		const btScalar z = randomScalar(btScalar(0.5) * (aabbMin.z() + aabbMax.z()) + btScalar(0.5), aabbMax.z());
+		EXPECT_LT(castRay(tiledObject, btVector3(x, 8, z), btVector3(x, -8, z)), 0);
+	}
+
+	tiledTerrain.pageOutAllTiles();
+	EXPECT_EQ(tiledTerrain.getNumChildShapes(), 0);
+	tileFile.close();
+	remove(gTileFileName);
+}
+
+GTEST_TEST(BulletCollision, TiledHeightfieldMatchesHeightfield)
+{
+	srand(1);
+	checkTiledTerrain<btScalar>(PHY_FLOAT, btScalar(1.), btScalar(0.));
+	checkTiledTerrain<short>(PHY_SHORT, btScalar(0.01), btScalar(0.));
+	//unsigned heights
+	checkTiledTerrain<unsigned char>(PHY_UCHAR, btScalar(0.05), btScalar(5.));
+}
+
+GTEST_TEST(BulletCollision, TiledHeightfieldFileHeader)
+{
+	btAlignedObjectArray<btScalar> heights;
+	btAlignedObjectArray<btScalar> tileHeights;
+	btAlignedObjectArray<const void*> tileData;
+	createHeights(heights, btScalar(1.), btScalar(0.));
+	createTiles(heights, tileHeights, tileData);
+	ASSERT_TRUE(btMappedHeightfieldTileFile::writeFile(gTileFileName, getTileInfo(PHY_FLOAT, btScalar(1.), btScalar(0.)), &tileData[0]));
+
+	btHeightfieldTileFileHeader header;
+	ASSERT_TRUE(readHeader(header));
+	EXPECT_EQ(header.m_version, 2);
+	EXPECT_EQ(header.m_heightElementSize, int(sizeof(btScalar)));
+
+	btMappedHeightfieldTileFile tileFile;
+	EXPECT_TRUE(tileFile.open(gTileFileName));
+	tileFile.close();
+
+	//PHY_FLOAT heights of the other btScalar precision
+	btHeightfieldTileFileHeader otherPrecision = header;
+	otherPrecision.m_heightElementSize = sizeof(btScalar) == sizeof(float) ? sizeof(double) : sizeof(float);
+	writeHeader(otherPrecision);
+	EXPECT_FALSE(tileFile.open(gTileFileName));
+
+	//version 1 files do not tell the size of their PHY_FLOAT heights
+	btHeightfieldTileFileHeader version1 = header;
+	version1.m_version = 1;
+	version1.m_heightElementSize = 0;
+	writeHeader(version1);
+	EXPECT_FALSE(tileFile.open(gTileFileName));
+
+	//but their PHY_SHORT heights can be read
+	version1.m_heightDataType = PHY_SHORT;
+	writeHeader(version1);
+	EXPECT_TRUE(tileFile.open(gTileFileName));
+	EXPECT_EQ(tileFile.getTileInfo().m_heightDataType, PHY_SHORT);
+	tileFile.close();
+
+	btHeightfieldTileFileHeader badMagic = header;
+	badMagic.m_magic[0] = 'X';
+	writeHeader(badMagic);
+	EXPECT_FALSE(tileFile.open(gTileFileName));
+	EXPECT_FALSE(tileFile.isOpen());
+
+	remove(gTileFileName);
+	EXPECT_FALSE(tileFile.open(gTileFileName));
+}
+
+GTEST_TEST(BulletCollision, TiledHeightfieldPaging)
+{
+	btAlignedObjectArray<btScalar> heights;
+	btAlignedObjectArray<btScalar> tileHeights;
+	btAlignedObjectArray<const void*> tileData;
+	createHeights(heights, btScalar(1.), btScalar(0.));
+	createTiles(heights, tileHeights, tileData);
+	ASSERT_TRUE(btMappedHeightfieldTileFile::writeFile(gTileFileName, getTileInfo(PHY_FLOAT, btScalar(1.), btScalar(0.)), &tileData[0]));
+	btMappedHeightfieldTileFile tileFile;
+	ASSERT_TRUE(tileFile.open(gTileFileName));
+
+	btTiledHeightfieldTerrainShape tiledTerrain(&tileFile, 1, false);
+	tiledTerrain.setTileKeepAliveFrames(1);
+
+	//the terrain is centered, tile (tileX, tileZ) covers x from tileX * gTileSize - gWidth / 2
+	const btScalar halfWidth = btScalar(0.5) * gNumTilesX * gTileSize;
+	const btScalar halfLength = btScalar(0.5) * gNumTilesZ * gTileSize;
+	const btVector3 insideTile00(-halfWidth + 4, 0, -halfLength + 4);
+	const btVector3 insideTile10(-halfWidth + gTileSize + 4, 0, -halfLength + 4);
+	const btVector3 extent(1, 1, 1);
+
+	tiledTerrain.requestTiles(insideTile00 - extent, insideTile00 + extent);
+	tiledTerrain.updatePaging();
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), 1);
+	EXPECT_TRUE(tiledTerrain.getTileShape(0, 0) != 0);
+
+	//an aabb across the border of two tiles pages in both
+	const btVector3 border(-halfWidth + gTileSize, 0, -halfLength + 4);
+	tiledTerrain.requestTiles(border - extent, border + extent);
+	tiledTerrain.updatePaging();
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), 2);
+	EXPECT_TRUE(tiledTerrain.getTileShape(1, 0) != 0);
+
+	//the tiles stay resident for the keep alive frames after their last request
+	for (int frame = 0; frame < 2; frame++)
+	{
+		tiledTerrain.requestTiles(insideTile10 - extent, insideTile10 + extent);
+		tiledTerrain.updatePaging();
+	}
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), 1);
+	EXPECT_TRUE(tiledTerrain.getTileShape(0, 0) == 0);
+	EXPECT_TRUE(tiledTerrain.getTileShape(1, 0) != 0);
+	EXPECT_EQ(tiledTerrain.getNumChildShapes(), 1);
+
+	//the least recently requested tiles are paged out first
+	tiledTerrain.setTileKeepAliveFrames(100);
+	tiledTerrain.setMaxResidentTiles(2);
+	const btVector3 insideTile01(-halfWidth + 4, 0, -halfLength + gTileSize + 4);
+	tiledTerrain.requestTiles(insideTile00 - extent, insideTile00 + extent);
+	tiledTerrain.updatePaging();
+	tiledTerrain.requestTiles(insideTile01 - extent, insideTile01 + extent);
+	tiledTerrain.updatePaging();
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), 2);
+	EXPECT_TRUE(tiledTerrain.getTileShape(1, 0) == 0);
+	EXPECT_TRUE(tiledTerrain.getTileShape(0, 0) != 0);
+	EXPECT_TRUE(tiledTerrain.getTileShape(0, 1) != 0);
+
+	//the hole tile is never paged in
+	tiledTerrain.setMaxResidentTiles(0);
+	tiledTerrain.requestTiles(btVector3(-100, -100, -100), btVector3(100, 100, 100));
+	tiledTerrain.updatePaging();
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), gNumTilesX * gNumTilesZ - 1);
+
+	tiledTerrain.pageOutAllTiles();
+	tileFile.close();
+	remove(gTileFileName);
+}
+
+//the lifetime of a contact point grows each frame its manifold is kept
+static int getMaxLifeTime(btDispatcher* dispatcher)
+{
+	int maxLifeTime = -1;
+	for (int i = 0; i < dispatcher->getNumManifolds(); i++)
+	{
+		const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+		for (int j = 0; j < manifold->getNumContacts(); j++)
+		{
+			maxLifeTime = btMax(maxLifeTime, manifold->getContactPoint(j).getLifeTime());
+		}
+	}
+	return maxLifeTime;
+}
+
+GTEST_TEST(BulletCollision, TiledHeightfieldPagingKeepsManifoldsUntilPageOut)
+{
+	btAlignedObjectArray<btScalar> heights;
+	btAlignedObjectArray<btScalar> tileHeights;
+	btAlignedObjectArray<const void*> tileData;
+	heights.resize(gWidth * gLength, btScalar(0.));
+	createTiles(heights, tileHeights, tileData);
+	ASSERT_TRUE(btMappedHeightfieldTileFile::writeFile(gTileFileName, getTileInfo(PHY_FLOAT, btScalar(1.), btScalar(0.)), &tileData[0]));
+	btMappedHeightfieldTileFile tileFile;
+	ASSERT_TRUE(tileFile.open(gTileFileName));
+	btTiledHeightfieldTerrainShape tiledTerrain(&tileFile, 1, false);
+	tiledTerrain.setTileKeepAliveFrames(0);
+
+	btDefaultCollisionConfiguration config;
+	btCollisionDispatcher dispatcher(&config);
+	btDbvtBroadphase broadphase;
+	btCollisionWorld world(&dispatcher, &broadphase, &config);
+	btCollisionObject terrainObject;
+	terrainObject.setCollisionShape(&tiledTerrain);
+	btBoxShape box(btVector3(0.5, 0.5, 0.5));
+	btCollisionObject boxObject;
+	boxObject.setCollisionShape(&box);
+	const btVector3 boxPosition(-btScalar(0.5) * gNumTilesX * gTileSize + 4, btScalar(0.45), -btScalar(0.5) * gNumTilesZ * gTileSize + 4);
+	boxObject.setWorldTransform(btTransform(btQuaternion::getIdentity(), boxPosition));
+	world.addCollisionObject(&terrainObject);
+	world.addCollisionObject(&boxObject);
+
+	const btVector3 extent(1, 1, 1);
+	const int numFrames = 5;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		tiledTerrain.requestTiles(boxPosition - extent, boxPosition + extent);
+		tiledTerrain.updatePaging();
+		world.performDiscreteCollisionDetection();
+	}
+	ASSERT_GE(getMaxLifeTime(&dispatcher), numFrames - 1);
+
+	//paging in adds children, the manifolds of the pairs with the terrain are kept
+	const btVector3 otherTile = boxPosition + btVector3(btScalar(gTileSize), 0, 0);
+	tiledTerrain.requestTiles(boxPosition - extent, boxPosition + extent);
+	tiledTerrain.requestTiles(otherTile - extent, otherTile + extent);
+	tiledTerrain.updatePaging();
+	world.performDiscreteCollisionDetection();
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), 2);
+	EXPECT_GE(getMaxLifeTime(&dispatcher), numFrames);
+
+	//paging out removes a child, the child algorithms and manifolds of all pairs with the terrain start again
+	tiledTerrain.requestTiles(boxPosition - extent, boxPosition + extent);
+	tiledTerrain.updatePaging();
+	world.performDiscreteCollisionDetection();
+	EXPECT_EQ(tiledTerrain.getNumResidentTiles(), 1);
+	EXPECT_LE(getMaxLifeTime(&dispatcher), 1);
+
+	world.removeCollisionObject(&boxObject);
+	world.removeCollisionObject(&terrainObject);
+	tiledTerrain.pageOutAllTiles();
+	tileFile.close();
+	remove(gTileFileName);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
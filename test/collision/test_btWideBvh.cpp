@@ -0,0 +1,79 @@
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <BulletCollision/CollisionShapes/btWideBvh.h>
+#include "BvhTestUtil.h"
+
+//every triangle of a is in b
+static bool isSubset(const btAlignedObjectArray<int>& a, const btAlignedObjectArray<int>& b)
+{
+	int j = 0;
+	for (int i = 0; i < a.size(); i++)
+	{
+		while (j < b.size() && b[j] < a[i])
+			j++;
+		if (j == b.size() || b[j] != a[i])
+			return false;
+	}
+	return true;
+}
+
+GTEST_TEST(BulletCollision, WideBvhMatchesQuantizedBvh)
+{
+	btTriangleMesh* mesh = createTerrainMesh(64);
+	btVector3 aabbMin, aabbMax;
+	mesh->calculateAabbBruteForce(aabbMin, aabbMax);
+
+	btOptimizedBvh* bvh = new btOptimizedBvh();
+	bvh->build(mesh, true, aabbMin, aabbMax);
+
+	//with one triangle per leaf the wide tree reports exactly the triangles of the quantized tree,
+	//larger leaves report them and possibly other triangles of the same leaves
+	const int leafSizes[2] = {1, BT_WIDE_BVH_DEFAULT_LEAF_SIZE};
+	for (int l = 0; l < 2; l++)
+	{
+		btWideBvh* wideBvh = new btWideBvh();
+		wideBvh->build(mesh, aabbMin, aabbMax, leafSizes[l]);
+		EXPECT_EQ(mesh->getNumTriangles(), wideBvh->getNumTriangles());
+
+		int numReported = 0;
+		srand(7);
+		for (int q = 0; q < 200; q++)
+		{
+			const btVector3 center = randomPoint(aabbMin, aabbMax);
+			const btVector3 halfExtents = randomPoint(btVector3(0.1, 0.1, 0.1), btVector3(3, 3, 3));
+			const btVector3 target = randomPoint(aabbMin, aabbMax);
+
+			btCollectTrianglesCallback expected[3];
+			btCollectTrianglesCallback actual[3];
+			bvh->reportAabbOverlappingNodex(&expected[0], center - halfExtents, center + halfExtents);
+			wideBvh->reportAabbOverlappingNodex(&actual[0], center - halfExtents, center + halfExtents);
+			bvh->reportRayOverlappingNodex(&expected[1], center, target);
+			wideBvh->reportRayOverlappingNodex(&actual[1], center, target);
+			bvh->reportBoxCastOverlappingNodex(&expected[2], center, target, -halfExtents, halfExtents);
+			wideBvh->reportBoxCastOverlappingNodex(&actual[2], center, target, -halfExtents, halfExtents);
+			for (int k = 0; k < 3; k++)
+			{
+				expected[k].sortUnique();
+				actual[k].sortUnique();
+				numReported += expected[k].m_triangles.size();
+				EXPECT_TRUE(isSubset(expected[k].m_triangles, actual[k].m_triangles));
+				if (leafSizes[l] == 1)
+				{
+					EXPECT_EQ(expected[k].m_triangles.size(), actual[k].m_triangles.size());
+				}
+			}
+		}
+		EXPECT_GT(numReported, 0);
+		delete wideBvh;
+	}
+
+	delete bvh;
+	delete mesh;
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}